@@ -0,0 +1,42 @@
+#
+# benchmarks.pri
+#
+# Copyright © Quazaaa Development Team, 2009-2013.
+# This file is part of QUAZAA (quazaa.sourceforge.net)
+#
+# Quazaa is free software; this file may be used under the terms of the GNU
+# General Public License version 3.0 or later or later as published by the Free Software
+# Foundation and appearing in the file LICENSE.GPL included in the
+# packaging of this file.
+#
+# Quazaa is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# Please review the following information to ensure the GNU General Public
+# License version 3.0 requirements will be met:
+# http://www.gnu.org/copyleft/gpl.html.
+#
+# You should have received a copy of the GNU General Public License version
+# 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+# Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+
+# Micro-benchmarks for the core library. Each one is a QtTest executable with QBENCHMARK
+# cases and no GUI, so they run headless: "make check" from this directory runs them all,
+# or start a single one, e.g. "g2packet/tst_g2packet -median 5".
+
+QT += testlib
+CONFIG += testcase
+CONFIG -= app_bundle
+
+CONFIG(debug, debug|release) {
+		OBJECTS_DIR = temp/obj/debug
+}
+else {
+		OBJECTS_DIR = temp/obj/release
+}
+
+MOC_DIR = temp/moc
+
+include(../Quazaa/core.pri)
@@ -0,0 +1,316 @@
+/*
+** tst_bootstrap.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "discovery.h"
+#include "hostcache.h"
+#include "g2packet.h"
+#include "buffer.h"
+#include "datagrams.h"
+#include "timedsignalqueue.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+using namespace Discovery;
+
+// Hosts handed out by the stand-in services. They need to be public addresses, as the host
+// cache drops private ones.
+static QList<CEndPoint> standInHosts(quint8 nNet, int nHosts)
+{
+	QList<CEndPoint> lHosts;
+	for(int i = 1; i <= nHosts; ++i)
+	{
+		lHosts.append(CEndPoint(0x01020000u | (nNet << 8) | i, 6346));
+	}
+	return lHosts;
+}
+
+// A web cache on the loopback interface, answering each request after m_nDelay ms.
+class CStandInGWC : public QTcpServer
+{
+	Q_OBJECT
+
+public:
+	int              m_nDelay;
+	QList<CEndPoint> m_lHosts;
+
+	CStandInGWC(int nDelay, const QList<CEndPoint>& lHosts) :
+		m_nDelay(nDelay),
+		m_lHosts(lHosts)
+	{
+		connect(this, &QTcpServer::newConnection, this, &CStandInGWC::onConnection);
+		listen(QHostAddress::LocalHost);
+	}
+
+	QString url() const
+	{
+		return QString("http://127.0.0.1:%1/").arg(serverPort());
+	}
+
+private slots:
+	void onConnection()
+	{
+		while(QTcpSocket* pSocket = nextPendingConnection())
+		{
+			QByteArray baReply = "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\n"
+								 "I|pong|Stand-in 1.0|gnutella2\n";
+			foreach(const CEndPoint& oHost, m_lHosts)
+			{
+				baReply += "H|" + oHost.toStringWithPort().toLatin1() + "\n";
+			}
+
+			QTimer* pTimer = new QTimer(pSocket);
+			pTimer->setSingleShot(true);
+			connect(pTimer, &QTimer::timeout, [pSocket, baReply]()
+			{
+				pSocket->write(baReply);
+				pSocket->disconnectFromHost();
+			});
+			connect(pSocket, &QTcpSocket::disconnected, pSocket, &QObject::deleteLater);
+			pTimer->start(m_nDelay);
+		}
+	}
+};
+
+// A UDP KHL cache on the loopback interface. Answers /KHLR at once with a /KHLA listing
+// m_lHosts as cached hubs, or never if the list is empty.
+class CStandInUKHL : public QUdpSocket
+{
+	Q_OBJECT
+
+public:
+	QList<CEndPoint> m_lHosts;
+
+	CStandInUKHL(const QList<CEndPoint>& lHosts = QList<CEndPoint>()) :
+		m_lHosts(lHosts)
+	{
+		connect(this, &QUdpSocket::readyRead, this, &CStandInUKHL::onDatagram);
+		bind(QHostAddress::LocalHost, 0);
+	}
+
+	QString url() const
+	{
+		return QString("ukhl:127.0.0.1:%1").arg(localPort());
+	}
+
+private slots:
+	void onDatagram()
+	{
+		while(hasPendingDatagrams())
+		{
+			QByteArray baRequest;
+			baRequest.resize(pendingDatagramSize());
+
+			QHostAddress oSender;
+			quint16 nPort = 0;
+			readDatagram(baRequest.data(), baRequest.size(), &oSender, &nPort);
+
+			if(m_lHosts.isEmpty() || (quint32)baRequest.size() < sizeof(GND_HEADER))
+			{
+				continue;
+			}
+
+			const quint32 tNow = common::getTNowUTC();
+
+			G2Packet* pKHLA = G2Packet::newPacket("KHLA", true);
+			pKHLA->writePacket("TS", 4)->writeIntLE<quint32>(tNow);
+			foreach(CEndPoint oHost, m_lHosts)
+			{
+				pKHLA->writePacket("CH", 10)->writeHostAddress(&oHost);
+				pKHLA->writeIntLE<quint32>(tNow);
+			}
+
+			CBuffer oBuffer;
+			pKHLA->toBuffer(&oBuffer);
+			pKHLA->release();
+
+			GND_HEADER oHeader = *(const GND_HEADER*)baRequest.constData();
+			oHeader.nFlags = 0;
+			oHeader.nPart  = 1;
+			oHeader.nCount = 1;
+			oBuffer.insert(0, &oHeader, sizeof(GND_HEADER));
+
+			writeDatagram(oBuffer.data(), oBuffer.size(), oSender, nPort);
+		}
+	}
+};
+
+class tst_Bootstrap : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir m_oHome;
+
+	quint32 hostCount();
+	void clearHosts();
+	qint64 timeToFirstHub();
+
+private slots:
+	void initTestCase();
+	void cleanup();
+
+	void testTimeToFirstHub_data();
+	void testTimeToFirstHub();
+	void testRanking();
+};
+
+quint32 tst_Bootstrap::hostCount()
+{
+	QMutexLocker l(&hostCache.m_pSection);
+	return hostCache.count();
+}
+
+void tst_Bootstrap::clearHosts()
+{
+	QMutexLocker l(&hostCache.m_pSection);
+	for(quint8 nNet = 3; nNet <= 4; ++nNet)
+	{
+		foreach(const CEndPoint& oHost, standInHosts(nNet, 5))
+		{
+			hostCache.remove(oHost);
+		}
+	}
+}
+
+// Bootstraps against the services added to the manager, returning the milliseconds until the
+// first hub made it into the host cache, or -1. Waits for all services to complete, so they
+// may be removed afterwards.
+qint64 tst_Bootstrap::timeToFirstHub()
+{
+	clearHosts();
+
+	QSignalSpy oFinished(&discoveryManager, SIGNAL(bootstrapFinished(quint32)));
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+	discoveryManager.bootstrap(CNetworkType(dpG2));
+
+	qint64 nFirstHub = -1;
+	while(oTimer.elapsed() < 20000 && oFinished.isEmpty())
+	{
+		if(nFirstHub < 0 && hostCount())
+		{
+			nFirstHub = oTimer.elapsed();
+		}
+		QTest::qWait(5);
+	}
+
+	if(nFirstHub < 0 && hostCount())
+	{
+		nFirstHub = oTimer.elapsed();
+	}
+
+	// services not needed any more keep running until they answer or time out
+	while(oTimer.elapsed() < 20000 &&
+		  (discoveryManager.isActive(stUKHL) || discoveryManager.isActive(stGWC)))
+	{
+		QTest::qWait(50);
+	}
+
+	return nFirstHub;
+}
+
+void tst_Bootstrap::initTestCase()
+{
+	// The host cache saves below the home directory; keep that out of the user's profile.
+	QVERIFY(m_oHome.isValid());
+	qputenv("HOME", QFile::encodeName(m_oHome.path()));
+
+	// The manager is not started, so it stays in this thread and no stored services interfere.
+	signalQueue.setup();
+
+	quazaaSettings.Discovery.AccessThrottle       = 0;
+	quazaaSettings.Discovery.BootstrapHosts       = 5;
+	quazaaSettings.Discovery.FailureLimit         = 2;
+	quazaaSettings.Discovery.MaximumServiceRating = 10;
+	quazaaSettings.Discovery.ServiceTimeout       = 10;
+}
+
+void tst_Bootstrap::cleanup()
+{
+	discoveryManager.clear();
+	clearHosts();
+}
+
+// Two caches that never answer are known before a slow web cache and a working UDP cache,
+// which is what a stale service list looks like.
+void tst_Bootstrap::testTimeToFirstHub_data()
+{
+	QTest::addColumn<int>("fanOut");
+
+	QTest::newRow("1 service at a time") << 1;
+	QTest::newRow("4 services at a time") << 4;
+}
+
+void tst_Bootstrap::testTimeToFirstHub()
+{
+	QFETCH(int, fanOut);
+	quazaaSettings.Discovery.BootstrapFanOut = fanOut;
+
+	CStandInUKHL oSilent1, oSilent2;
+	CStandInGWC  oGWC(1000, standInHosts(3, 5));
+	CStandInUKHL oUKHL(standInHosts(4, 5));
+
+	QVERIFY(discoveryManager.add(oSilent1.url(), stUKHL, CNetworkType(dpG2)));
+	QVERIFY(discoveryManager.add(oSilent2.url(), stUKHL, CNetworkType(dpG2)));
+	QVERIFY(discoveryManager.add(oGWC.url(),     stGWC,  CNetworkType(dpG2)));
+	QVERIFY(discoveryManager.add(oUKHL.url(),    stUKHL, CNetworkType(dpG2)));
+
+	const qint64 nFirstHub = timeToFirstHub();
+	QVERIFY(nFirstHub >= 0);
+	QVERIFY(!discoveryManager.isBootstrapping());
+
+	QTest::setBenchmarkResult(nFirstHub, QTest::WalltimeMilliseconds);
+}
+
+// A service that failed is queried after the ones that did not.
+void tst_Bootstrap::testRanking()
+{
+	quazaaSettings.Discovery.BootstrapFanOut = 1;
+
+	CStandInUKHL oSilent;
+	CStandInUKHL oUKHL(standInHosts(4, 5));
+
+	QVERIFY(discoveryManager.add(oSilent.url(), stUKHL, CNetworkType(dpG2)));
+	QVERIFY(discoveryManager.add(oUKHL.url(),   stUKHL, CNetworkType(dpG2)));
+
+	// equal ranks: the silent cache comes first and has to time out
+	const qint64 nFirst = timeToFirstHub();
+	QVERIFY(nFirst >= 1000);
+
+	// let the access throttle pass
+	QTest::qWait(1100);
+
+	const qint64 nSecond = timeToFirstHub();
+	QVERIFY(nSecond >= 0);
+	QVERIFY(nSecond < 1000);
+}
+
+QTEST_GUILESS_MAIN(tst_Bootstrap)
+
+#include "tst_bootstrap.moc"
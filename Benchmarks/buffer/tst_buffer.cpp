@@ -0,0 +1,99 @@
+/*
+** tst_buffer.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "buffer.h"
+
+#include <QtTest/QtTest>
+
+class tst_Buffer : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testAppendRemove_data();
+	void testAppendRemove();
+	void testPrepend_data();
+	void testPrepend();
+};
+
+void tst_Buffer::testAppendRemove_data()
+{
+	QTest::addColumn<int>("chunk");
+	QTest::addColumn<int>("record");
+
+	// socket reads of "chunk" bytes consumed in records of "record" bytes
+	QTest::newRow("1460 / 32") << 1460 << 32;
+	QTest::newRow("1460 / 512") << 1460 << 512;
+	QTest::newRow("16384 / 32") << 16384 << 32;
+	QTest::newRow("16384 / 4096") << 16384 << 4096;
+}
+
+void tst_Buffer::testAppendRemove()
+{
+	QFETCH(int, chunk);
+	QFETCH(int, record);
+
+	const QByteArray baChunk(chunk, 'x');
+	CBuffer oBuffer;
+
+	QBENCHMARK
+	{
+		for(int i = 0; i < 64; ++i)
+		{
+			oBuffer.append(baChunk.constData(), chunk);
+			while(oBuffer.size() >= (quint32)record)
+			{
+				oBuffer.remove(record);
+			}
+		}
+	}
+}
+
+void tst_Buffer::testPrepend_data()
+{
+	QTest::addColumn<int>("size");
+
+	QTest::newRow("1k") << 1024;
+	QTest::newRow("64k") << 64 * 1024;
+}
+
+void tst_Buffer::testPrepend()
+{
+	QFETCH(int, size);
+
+	const QByteArray baPayload(size, 'x');
+	const char aHeader[4] = {0x48, 0x04, 'Q', '2'};
+	CBuffer oBuffer(size + sizeof(aHeader));
+
+	QBENCHMARK
+	{
+		oBuffer.clear();
+		oBuffer.append(baPayload.constData(), size);
+		oBuffer.prepend(aHeader, sizeof(aHeader));
+	}
+}
+
+QTEST_GUILESS_MAIN(tst_Buffer)
+
+#include "tst_buffer.moc"
@@ -0,0 +1,498 @@
+/*
+** tst_deflate.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "compressedconnection.h"
+#include "deflatebackend.h"
+#include "g2packet.h"
+#include "buffer.h"
+
+#include <QtTest/QtTest>
+#include <limits>
+
+static const int TickMs          = 10;
+static const int Ticks           = 200;	// two seconds of traffic per row
+static const int TicksPerSecond  = 1000 / TickMs;
+static const quint32 PoolSize    = 4 * 1024 * 1024;	// per mix, well past the 32 KB deflate window
+
+enum Mix
+{
+	LeafHits,	// query hits coming back to a searching leaf
+	HubQueries,	// queries, pings and host lists between hubs
+	TableSync,	// query hash table patches, already deflated
+	HubMix,		// all of the above, as a busy hub sees it
+	MixCount
+};
+
+// One link's worth of traffic, see testDeflate_data().
+struct Profile
+{
+	const char* pszName;
+	int nMix;
+	int nLinks;
+	int nOffered;	// bytes per second queued on each link
+	int nCapacity;	// bytes per second each link drains, 0 if the network keeps up
+};
+
+static const Profile Profiles[] =
+{
+	{ "leaf hits, fast link", LeafHits,   1,   512 * 1024, 0 },
+	{ "leaf hits, slow link", LeafHits,   1,   512 * 1024, 64 * 1024 },
+	{ "hub queries",          HubQueries, 300, 8 * 1024,   0 },
+	{ "table sync",           TableSync,  1,   256 * 1024, 0 },
+	{ "hub mix",              HubMix,     300, 16 * 1024,  0 }
+};
+
+static const char* const Words[] =
+{
+	"live", "remix", "album", "track", "original", "mix", "feat", "the", "love", "night",
+	"dance", "radio", "edit", "video", "episode", "season", "complete", "collection", "best", "of",
+	"greatest", "hits", "acoustic", "version", "official", "extended", "club", "summer", "winter", "dream",
+	"linux", "ubuntu", "manual", "guide", "book", "chapter", "part", "disc", "concert", "session"
+};
+static const int WordCount = sizeof(Words) / sizeof(Words[0]);
+
+static QString randomWords(int nCount)
+{
+	QStringList lWords;
+	for(int i = 0; i < nCount; ++i)
+	{
+		lWords << Words[qrand() % WordCount];
+	}
+	return lWords.join(" ");
+}
+
+static QByteArray randomBytes(int nLength)
+{
+	QByteArray baData(nLength, 0);
+	for(int i = 0; i < nLength; ++i)
+	{
+		baData[i] = char(qrand());
+	}
+	return baData;
+}
+
+static CEndPoint randomAddress()
+{
+	return CEndPoint(quint32(qrand()) << 16 | quint32(qrand() & 0xffff), 1024 + qrand() % 60000);
+}
+
+// QH2 with 1 to 20 hits, each with its own SHA1, size and name.
+static G2Packet* makeHits()
+{
+	G2Packet* pPacket = G2Packet::newPacket("QH2", true);
+
+	QUuid oGUID = QUuid::createUuid();
+	CEndPoint oAddress = randomAddress();
+	pPacket->writePacket("GU", 16)->writeGUID(oGUID);
+	pPacket->writePacket("NA", 6)->writeHostAddress(&oAddress);
+	pPacket->writePacket("V", 4)->write((void*)"RAZA", 4);
+
+	const int nHits = 1 + qrand() % 20;
+	for(int i = 0; i < nHits; ++i)
+	{
+		const QString sName = randomWords(2 + qrand() % 5) + (qrand() % 2 ? ".mp3" : ".avi");
+		const quint32 nName = sName.toUtf8().size();
+		QByteArray baHash = randomBytes(20);
+
+		// URN (5 + 25), SZ (4 + 4) and DN (4 + nName) children, no payload
+		pPacket->writePacket("H", 42 + nName, true);
+		pPacket->writePacket("URN", 25);
+		pPacket->writeString("sha1", true);
+		pPacket->write(baHash.data(), 20);
+		pPacket->writePacket("SZ", 4)->writeIntLE<quint32>(quint32(qrand()) * 64);
+		pPacket->writePacket("DN", nName)->writeString(sName, false);
+	}
+
+	QUuid oSearch = QUuid::createUuid();
+	pPacket->writeByte(0);
+	pPacket->writeByte(qrand() % 3);
+	pPacket->writeGUID(oSearch);
+
+	return pPacket;
+}
+
+// Q2 forwarded between hubs, keywords and now and then a hash.
+static G2Packet* makeQuery()
+{
+	G2Packet* pPacket = G2Packet::newPacket("Q2", true);
+
+	CEndPoint oAddress = randomAddress();
+	pPacket->writePacket("UDP", 10)->writeHostAddress(&oAddress);
+	pPacket->writeIntLE<quint32>(quint32(qrand()));
+
+	const QString sDN = randomWords(1 + qrand() % 4);
+	pPacket->writePacket("DN", sDN.toUtf8().size())->writeString(sDN, false);
+
+	if(qrand() % 4 == 0)
+	{
+		QByteArray baHash = randomBytes(20);
+		pPacket->writePacket("URN", 25);
+		pPacket->writeString("sha1", true);
+		pPacket->write(baHash.data(), 20);
+	}
+
+	QUuid oGUID = QUuid::createUuid();
+	pPacket->writeByte(0);
+	pPacket->writeGUID(oGUID);
+
+	return pPacket;
+}
+
+// LNI, KHL or PI, the small housekeeping packets.
+static G2Packet* makeChatter()
+{
+	const int nKind = qrand() % 4;
+
+	if(nKind == 0)
+	{
+		G2Packet* pPacket = G2Packet::newPacket("LNI", true);
+		QUuid oGUID = QUuid::createUuid();
+		CEndPoint oAddress = randomAddress();
+		pPacket->writePacket("NA", 6)->writeHostAddress(&oAddress);
+		pPacket->writePacket("GU", 16)->writeGUID(oGUID);
+		pPacket->writePacket("V", 4)->write((void*)"RAZA", 4);
+		pPacket->writePacket("LS", 8)->writeIntLE<quint32>(quint32(qrand()));
+		pPacket->writeIntLE<quint32>(quint32(qrand()));
+		pPacket->writePacket("HS", 4)->writeIntLE<quint16>(quint16(qrand() % 300));
+		pPacket->writeIntLE<quint16>(300);
+		return pPacket;
+	}
+	else if(nKind == 1)
+	{
+		G2Packet* pPacket = G2Packet::newPacket("KHL", true);
+		pPacket->writePacket("TS", 4)->writeIntLE<quint32>(quint32(time(0)));
+		for(int i = 0; i < 10; ++i)
+		{
+			CEndPoint oAddress = randomAddress();
+			pPacket->writePacket("NH", 6)->writeHostAddress(&oAddress);
+		}
+		return pPacket;
+	}
+
+	return G2Packet::newPacket("PI");
+}
+
+// QHT patch fragment: header, then table bits that were deflated by the sender.
+static G2Packet* makeTablePatch()
+{
+	G2Packet* pPacket = G2Packet::newPacket("QHT");
+
+	pPacket->writeByte(1);		// patch
+	pPacket->writeByte(1);		// fragment number
+	pPacket->writeByte(1);		// fragment count
+	pPacket->writeByte(1);		// deflated
+	pPacket->writeByte(1);		// bits
+
+	QByteArray baPatch = randomBytes(1024 + qrand() % 3072);
+	pPacket->write(baPatch.data(), baPatch.size());
+
+	return pPacket;
+}
+
+static QByteArray inflateAll(const QByteArray& baIn)
+{
+	z_stream oStream;
+	memset(&oStream, 0, sizeof(z_stream));
+	if(inflateInit(&oStream) != Z_OK)
+	{
+		return QByteArray();
+	}
+
+	QByteArray baOut;
+	char pChunk[65536];
+	int nRet = Z_OK;
+
+	oStream.next_in = (Bytef*)baIn.constData();
+	oStream.avail_in = baIn.size();
+
+	do
+	{
+		oStream.next_out = (Bytef*)pChunk;
+		oStream.avail_out = sizeof(pChunk);
+		nRet = inflate(&oStream, Z_SYNC_FLUSH);
+		baOut.append(pChunk, sizeof(pChunk) - oStream.avail_out);
+	}
+	while(nRet == Z_OK && (oStream.avail_in != 0 || oStream.avail_out == 0));
+
+	inflateEnd(&oStream);
+	return baOut;
+}
+
+// Keeps the link at one level whatever adaptDeflate() asks for, to compare against.
+static int FixedLevel = 0;
+
+class CFixedDeflateBackend : public CZlibDeflateBackend
+{
+public:
+	virtual bool init(int nLevel)
+	{
+		Q_UNUSED(nLevel);
+		return CZlibDeflateBackend::init(FixedLevel);
+	}
+	virtual void setLevel(int nLevel)
+	{
+		Q_UNUSED(nLevel);
+	}
+
+	static CDeflateBackend* createInstance()
+	{
+		return new CFixedDeflateBackend();
+	}
+};
+
+// A compressed link without a socket: what would go on the wire is collected in m_baSent.
+class CDeflateLink : public CCompressedConnection
+{
+	Q_OBJECT
+
+public:
+	QByteArray m_baRaw;		// everything queued on the link
+	QByteArray m_baSent;	// everything the link put on the wire
+
+public:
+	CDeflateLink()
+	{
+		m_pInput = new CBuffer(8192);
+		m_pOutput = new CBuffer(8192);
+	}
+
+	void queue(const char* pData, quint32 nLength)
+	{
+		getOutputBuffer()->append(pData, nLength);
+		m_baRaw.append(pData, nLength);
+	}
+
+	// CCompressedConnection::writeToNetwork(), with m_baSent for the socket.
+	virtual qint64 writeToNetwork(qint64 nBytes)
+	{
+		if(m_bCompressedOutput && m_pOutput->size() == 0)
+		{
+			deflateOutput();
+		}
+
+		const quint32 nSent = quint32(qMin<qint64>(m_pOutput->size(), nBytes));
+		m_baSent.append(m_pOutput->data(), nSent);
+		m_pOutput->remove(0, nSent);
+
+		return nSent;
+	}
+
+	// Sends the rest of the stream up to a sync flush, so it can be inflated in full.
+	void finish()
+	{
+		do
+		{
+			m_nNextDeflateFlush = 0;
+			writeToNetwork(m_pZOutput->size() + m_pOutput->size() + 65536);
+		}
+		while(m_pZOutput->size() || m_pOutput->size() || m_bOutputPending);
+	}
+
+	qint64 queued() const
+	{
+		return m_pZOutput->size() + m_pOutput->size();
+	}
+
+public slots:
+	void onConnectNode() {}
+	void onDisconnectNode() {}
+	void onRead() {}
+	void onError(QAbstractSocket::SocketError e)
+	{
+		Q_UNUSED(e);
+	}
+};
+
+class tst_Deflate : public QObject
+{
+	Q_OBJECT
+
+private:
+	// Serialized packets of one mix, back to back.
+	struct Pool
+	{
+		CBuffer          oData;
+		QVector<quint32> vOffsets;	// start of each packet, and the end of the last one
+	};
+	Pool m_aPools[MixCount];
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void testDeflate_data();
+	void testDeflate();
+};
+
+void tst_Deflate::initTestCase()
+{
+	qsrand(31);
+
+	for(int nMix = 0; nMix < MixCount; ++nMix)
+	{
+		Pool& oPool = m_aPools[nMix];
+
+		while(oPool.oData.size() < PoolSize)
+		{
+			G2Packet* pPacket = 0;
+			const int nRoll = qrand() % 100;
+
+			switch(nMix)
+			{
+			case LeafHits:
+				pPacket = (nRoll < 95 ? makeHits() : makeChatter());
+				break;
+			case HubQueries:
+				pPacket = (nRoll < 70 ? makeQuery() : makeChatter());
+				break;
+			case TableSync:
+				pPacket = makeTablePatch();
+				break;
+			default:
+				pPacket = (nRoll < 50 ? makeQuery() : nRoll < 80 ? makeHits() : nRoll < 90 ? makeChatter() : makeTablePatch());
+				break;
+			}
+
+			oPool.vOffsets.append(oPool.oData.size());
+			pPacket->toBuffer(&oPool.oData);
+			pPacket->release();
+		}
+		oPool.vOffsets.append(oPool.oData.size());
+	}
+}
+
+void tst_Deflate::cleanupTestCase()
+{
+	CDeflateBackend::setFactory(0);
+}
+
+void tst_Deflate::testDeflate_data()
+{
+	QTest::addColumn<int>("profile");
+	QTest::addColumn<int>("level");
+
+	const int nProfiles = sizeof(Profiles) / sizeof(Profiles[0]);
+	for(int i = 0; i < nProfiles; ++i)
+	{
+		QTest::newRow(qPrintable(QString("%1, adaptive").arg(Profiles[i].pszName))) << i << 0;
+
+		const int aLevels[] = { 1, 6, 9 };
+		for(int j = 0; j < 3; ++j)
+		{
+			QTest::newRow(qPrintable(QString("%1, level %2").arg(Profiles[i].pszName).arg(aLevels[j]))) << i << aLevels[j];
+		}
+	}
+}
+
+// Paced G2 traffic through CCompressedConnection, adaptive against fixed levels. Reports
+// milliseconds of deflate per MB of traffic; ratio, average level and deepest backlog go
+// to the log. Pacing matters: DeflateCpuBudget is per second of wall time.
+void tst_Deflate::testDeflate()
+{
+	QFETCH(int, profile);
+	QFETCH(int, level);
+
+	const Profile& oProfile = Profiles[profile];
+	Pool& oPool = m_aPools[oProfile.nMix];
+	const int nPackets = oPool.vOffsets.size() - 1;
+
+	FixedLevel = level;
+	CDeflateBackend::setFactory(level ? &CFixedDeflateBackend::createInstance : 0);
+
+	QList<CDeflateLink*> lLinks;
+	QVector<int> vNext(oProfile.nLinks);
+	for(int i = 0; i < oProfile.nLinks; ++i)
+	{
+		lLinks.append(new CDeflateLink());
+		QVERIFY(lLinks.last()->enableOutputCompression());
+		vNext[i] = (i * 7919) % nPackets;
+	}
+
+	const qint64 nPerTick = oProfile.nOffered / TicksPerSecond;
+	const qint64 nDrain = oProfile.nCapacity ? oProfile.nCapacity / TicksPerSecond : std::numeric_limits<qint32>::max();
+
+	qint64 nCpu = 0, nPeakQueue = 0;
+	quint64 nLevels = 0, nSamples = 0;
+
+	QElapsedTimer oClock, oCpu;
+	oClock.start();
+
+	for(int nTick = 0; nTick < Ticks; ++nTick)
+	{
+		for(int i = 0; i < lLinks.size(); ++i)
+		{
+			CDeflateLink* pLink = lLinks[i];
+
+			for(qint64 nQueued = 0; nQueued < nPerTick; )
+			{
+				const quint32 nFrom = oPool.vOffsets[vNext[i]];
+				const quint32 nLength = oPool.vOffsets[vNext[i] + 1] - nFrom;
+				pLink->queue(oPool.oData.data() + nFrom, nLength);
+
+				nQueued += nLength;
+				vNext[i] = (vNext[i] + 1) % nPackets;
+			}
+
+			oCpu.start();
+			pLink->writeToNetwork(nDrain);
+			nCpu += oCpu.nsecsElapsed();
+
+			nLevels += pLink->getDeflateLevel();
+			++nSamples;
+			nPeakQueue = qMax(nPeakQueue, pLink->queued());
+		}
+
+		const qint64 nWait = (nTick + 1) * TickMs - oClock.elapsed();
+		if(nWait > 0)
+		{
+			QThread::msleep(nWait);
+		}
+	}
+
+	quint64 nRaw = 0, nCompressed = 0;
+	foreach(CDeflateLink* pLink, lLinks)
+	{
+		nRaw += pLink->m_nTotalOutputCom;
+		nCompressed += pLink->m_nTotalOutput;
+	}
+	QVERIFY(nRaw > 0);
+
+	foreach(CDeflateLink* pLink, lLinks)
+	{
+		pLink->finish();
+		QVERIFY(inflateAll(pLink->m_baSent) == pLink->m_baRaw);
+	}
+	qDeleteAll(lLinks);
+
+	const double nMsPerMB = nCpu / 1000000.0 / (nRaw / (1024.0 * 1024.0));
+
+	qDebug("%s: %.1f MB deflated, ratio %.3f, average level %.1f, deepest backlog %lld bytes",
+		   oProfile.pszName, nRaw / (1024.0 * 1024.0), double(nCompressed) / double(nRaw),
+		   double(nLevels) / double(nSamples), nPeakQueue);
+	QTest::setBenchmarkResult(nMsPerMB, QTest::WalltimeMilliseconds);
+}
+
+QTEST_GUILESS_MAIN(tst_Deflate)
+
+#include "tst_deflate.moc"
@@ -0,0 +1,281 @@
+/*
+** tst_download.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "downloads.h"
+#include "download.h"
+#include "transfers.h"
+#include "queryhit.h"
+#include "Hashes/hash.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+#include <QCryptographicHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <limits>
+
+static const qint64 FileSize = 32 * 1024 * 1024;
+
+// Stand-in for a remote HTTP source: answers every range request from memory, in order, on
+// keep-alive connections. A latency delays each response as a round trip on a real link would.
+class CStandInSource : public QTcpServer
+{
+public:
+	const QByteArray* m_pContent;
+	int               m_nLatency;
+	quint64           m_nRequests;
+
+	CStandInSource(const QByteArray* pContent) : m_pContent(pContent), m_nLatency(0), m_nRequests(0) {}
+
+protected:
+	void incomingConnection(qintptr nHandle)
+	{
+		QTcpSocket* pSocket = new QTcpSocket(this);
+		pSocket->setSocketDescriptor(nHandle);
+		connect(pSocket, &QTcpSocket::readyRead, pSocket, [this, pSocket]() { onRead(pSocket); });
+		connect(pSocket, &QTcpSocket::disconnected, pSocket, &QObject::deleteLater);
+	}
+
+	void onRead(QTcpSocket* pSocket)
+	{
+		QByteArray baInput = pSocket->property("input").toByteArray() + pSocket->readAll();
+
+		int nEnd;
+		while((nEnd = baInput.indexOf("\r\n\r\n")) >= 0)
+		{
+			const QString sRequest = QString::fromLatin1(baInput.left(nEnd));
+			baInput.remove(0, nEnd + 4);
+			++m_nRequests;
+
+			qint64 nFrom = 0, nTo = m_pContent->size() - 1;
+			QRegExp rxRange("Range:\\s*bytes=(\\d+)-(\\d*)", Qt::CaseInsensitive);
+			const bool bRange = rxRange.indexIn(sRequest) >= 0;
+			if(bRange)
+			{
+				nFrom = rxRange.cap(1).toLongLong();
+				if(!rxRange.cap(2).isEmpty())
+				{
+					nTo = qMin(nTo, rxRange.cap(2).toLongLong());
+				}
+			}
+
+			QByteArray baResponse = bRange ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+			if(bRange)
+			{
+				baResponse += "Content-Range: bytes " + QByteArray::number(nFrom) + "-" + QByteArray::number(nTo)
+							  + "/" + QByteArray::number(m_pContent->size()) + "\r\n";
+			}
+			baResponse += "Content-Length: " + QByteArray::number(nTo - nFrom + 1) + "\r\n";
+			baResponse += "Connection: Keep-Alive\r\n\r\n";
+			baResponse += m_pContent->mid(nFrom, nTo - nFrom + 1);
+
+			if(m_nLatency > 0)
+			{
+				// same delay for every response, so they still go out in request order
+				QTimer::singleShot(m_nLatency, pSocket, [pSocket, baResponse]() { pSocket->write(baResponse); });
+			}
+			else
+			{
+				pSocket->write(baResponse);
+			}
+		}
+
+		pSocket->setProperty("input", baInput);
+	}
+};
+
+class tst_Download : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir            m_oHome;
+	QByteArray               m_baContent;
+	QByteArray               m_baSHA1;
+	QList<CStandInSource*>   m_lSources;
+	int                      m_nDownloads;
+
+	CDownload* addDownload(int nSources);
+	quint64 requests() const;
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void testThroughput_data();
+	void testThroughput();
+};
+
+// Queues a download of the test file with the first nSources stand-ins as its sources.
+CDownload* tst_Download::addDownload(int nSources)
+{
+	CQueryHit* pFirst = 0;
+	CQueryHit* pLast = 0;
+
+	for(int i = 0; i < nSources; ++i)
+	{
+		CQueryHit* pHit = new CQueryHit();
+		pHit->m_pHitInfo = QSharedPointer<QueryHitInfo>(new QueryHitInfo());
+		pHit->m_pHitInfo->m_oNodeAddress = CEndPoint(QHostAddress(QHostAddress::LocalHost), m_lSources[i]->serverPort());
+		pHit->m_lHashes.append(CHash(m_baSHA1, CHash::SHA1));
+		pHit->m_sDescriptiveName = QString("stand-in %1.bin").arg(m_nDownloads);
+		pHit->m_nObjectSize = FileSize;
+
+		if(pLast)
+		{
+			pLast->m_pNext = pHit;
+		}
+		else
+		{
+			pFirst = pHit;
+		}
+		pLast = pHit;
+	}
+
+	QMutexLocker l(&Downloads.m_pSection);
+	Downloads.add(pFirst);
+	++m_nDownloads;
+	CDownload* pDownload = Downloads.m_lDownloads.last();
+	l.unlock();
+
+	delete pFirst;
+	return pDownload;
+}
+
+quint64 tst_Download::requests() const
+{
+	quint64 nRequests = 0;
+	foreach(CStandInSource* pSource, m_lSources)
+	{
+		nRequests += pSource->m_nRequests;
+	}
+	return nRequests;
+}
+
+void tst_Download::initTestCase()
+{
+	QVERIFY(m_oHome.isValid());
+	qputenv("HOME", QFile::encodeName(m_oHome.path()));
+
+	quazaaSettings.Connection.InSpeed            = std::numeric_limits<qint32>::max();
+	quazaaSettings.Connection.OutSpeed           = std::numeric_limits<qint32>::max();
+	quazaaSettings.Connection.TimeoutConnect     = 10;
+	quazaaSettings.Connection.TimeoutTraffic     = 60;
+	quazaaSettings.Downloads.ChunkSize           = 4 * 1024 * 1024;
+	quazaaSettings.Downloads.ChunkStrap          = 128 * 1024;
+	quazaaSettings.Downloads.IncompletePath      = m_oHome.path() + "/Incomplete";
+	quazaaSettings.Downloads.MaxAllowedFailures  = 10;
+	quazaaSettings.Downloads.MaxFiles            = 8;
+	quazaaSettings.Downloads.MaxTransfers        = 32;
+	quazaaSettings.Downloads.MaxTransfersPerFile = 8;
+	quazaaSettings.Downloads.RequestHTTP11       = true;
+	quazaaSettings.Downloads.RetryDelay          = 1000;
+	quazaaSettings.Downloads.VerifyTiger         = false;
+
+	m_baContent.resize(FileSize);
+	quint32 nState = 0x12345678;
+	for(int i = 0; i < m_baContent.size(); ++i)
+	{
+		nState = nState * 1664525 + 1013904223;
+		m_baContent[i] = char(nState >> 24);
+	}
+	m_baSHA1 = QCryptographicHash::hash(m_baContent, QCryptographicHash::Sha1);
+	m_nDownloads = 0;
+
+	for(int i = 0; i < 4; ++i)
+	{
+		m_lSources.append(new CStandInSource(&m_baContent));
+		QVERIFY(m_lSources.last()->listen(QHostAddress::LocalHost));
+	}
+
+	Transfers.start();
+}
+
+void tst_Download::cleanupTestCase()
+{
+	Transfers.stop();
+	qDeleteAll(m_lSources);
+}
+
+void tst_Download::testThroughput_data()
+{
+	QTest::addColumn<int>("sources");
+	QTest::addColumn<int>("latency");
+
+	QTest::newRow("1 source") << 1 << 0;
+	QTest::newRow("1 source, 50 ms") << 1 << 50;
+	QTest::newRow("4 sources, 50 ms") << 4 << 50;
+}
+
+// Downloads the file from the stand-ins. The rate covers the first request up to the last
+// byte reaching the download; the file is then compared once it is complete on disk.
+void tst_Download::testThroughput()
+{
+	QFETCH(int, sources);
+	QFETCH(int, latency);
+
+	foreach(CStandInSource* pSource, m_lSources)
+	{
+		pSource->m_nLatency = latency;
+	}
+	const quint64 nRequestsBefore = requests();
+
+	CDownload* pDownload = addDownload(sources);
+
+	// the download is started by the downloads timer
+	QElapsedTimer oTimer;
+	oTimer.start();
+	while(requests() == nRequestsBefore && oTimer.elapsed() < 10000)
+	{
+		QTest::qWait(1);
+	}
+
+	oTimer.start();
+	bool bReceived = false, bCompleted = false;
+	while(!bCompleted && oTimer.elapsed() < 120000)
+	{
+		QTest::qWait(5);
+
+		QMutexLocker l(&Downloads.m_pSection);
+		if(!bReceived && pDownload->m_lReceived.missing() == 0)
+		{
+			bReceived = true;
+			QTest::setBenchmarkResult(FileSize * 1000.0 / qMax<qint64>(1, oTimer.elapsed()), QTest::BytesPerSecond);
+		}
+		bCompleted = pDownload->isCompleted();
+	}
+
+	QVERIFY(bCompleted);
+
+	qDebug("%llu range requests, %lld ms to completion", requests() - nRequestsBefore, oTimer.elapsed());
+
+	QFile oFile(quazaaSettings.Downloads.IncompletePath + "/" + pDownload->m_sTempName);
+	QVERIFY(oFile.open(QIODevice::ReadOnly));
+	QVERIFY(oFile.readAll() == m_baContent);
+}
+
+QTEST_GUILESS_MAIN(tst_Download)
+
+#include "tst_download.moc"
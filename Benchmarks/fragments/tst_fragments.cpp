@@ -0,0 +1,230 @@
+/*
+** tst_fragments.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "FileFragments.hpp"
+
+#include <QtTest/QtTest>
+
+using Fragments::Fragment;
+
+static const quint64 BlockSize = 16 * 1024;
+
+// Block order of a swarmed download: every block once, scattered over the file.
+static QVector<quint64> scatteredBlocks(int nBlocks)
+{
+	QVector<quint64> vBlocks;
+	vBlocks.reserve(nBlocks);
+	for(int i = 0; i < nBlocks; ++i)
+	{
+		vBlocks << (quint64(i) * 7919) % nBlocks;
+	}
+	return vBlocks;
+}
+
+// Every other block present, the worst case for the number of ranges.
+template<class ListT>
+static ListT everyOtherBlock(int nBlocks)
+{
+	ListT oList(nBlocks * BlockSize);
+	for(int i = 0; i < nBlocks; i += 2)
+	{
+		oList.insert(oList.end(), Fragment(i * BlockSize, (i + 1) * BlockSize));
+	}
+	return oList;
+}
+
+template<class ListT>
+static void benchInsert(int nBlocks)
+{
+	const QVector<quint64> vBlocks = scatteredBlocks(nBlocks);
+
+	QBENCHMARK
+	{
+		ListT oList(nBlocks * BlockSize);
+		foreach(quint64 nBlock, vBlocks)
+		{
+			oList.insert(Fragment(nBlock * BlockSize, (nBlock + 1) * BlockSize));
+		}
+		QCOMPARE(oList.size(), typename ListT::size_type(1));
+	}
+}
+
+template<class ListT>
+static void benchErase(int nBlocks)
+{
+	const QVector<quint64> vBlocks = scatteredBlocks(nBlocks);
+
+	QBENCHMARK
+	{
+		ListT oList(nBlocks * BlockSize);
+		oList.insert(Fragment(0, nBlocks * BlockSize));
+		foreach(quint64 nBlock, vBlocks)
+		{
+			oList.erase(Fragment(nBlock * BlockSize, (nBlock + 1) * BlockSize));
+		}
+		QVERIFY(oList.empty());
+	}
+}
+
+template<class ListT>
+static void benchOverlaps(int nBlocks)
+{
+	const ListT oList = everyOtherBlock<ListT>(nBlocks);
+	const QVector<quint64> vBlocks = scatteredBlocks(nBlocks);
+	quint64 nSum = 0;
+
+	QBENCHMARK
+	{
+		nSum = 0;
+		foreach(quint64 nBlock, vBlocks)
+		{
+			const Fragment oBlock(nBlock * BlockSize, (nBlock + 1) * BlockSize);
+			if(oList.overlaps(oBlock))
+			{
+				nSum += oList.overlapping_sum(oBlock);
+			}
+		}
+	}
+
+	QCOMPARE(nSum, oList.length_sum());
+}
+
+template<class ListT>
+static void benchLargestRange(int nBlocks)
+{
+	ListT oList = everyOtherBlock<ListT>(nBlocks);
+
+	// The scheduler asks for the largest gap after every block it hands out.
+	QBENCHMARK
+	{
+		for(int i = 0; i < 100; ++i)
+		{
+			QVERIFY(oList.largest_range() != oList.end());
+		}
+	}
+}
+
+template<class ListT>
+static void benchInverse(int nBlocks)
+{
+	const ListT oList = everyOtherBlock<ListT>(nBlocks);
+
+	QBENCHMARK
+	{
+		const ListT oMissing = inverse(oList);
+		QCOMPARE(oMissing.length_sum(), oList.missing());
+	}
+}
+
+class tst_Fragments : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testInsert_data();
+	void testInsert();
+	void testErase_data();
+	void testErase();
+	void testOverlaps_data();
+	void testOverlaps();
+	void testLargestRange_data();
+	void testLargestRange();
+	void testInverse_data();
+	void testInverse();
+};
+
+// Every case runs on both backings of Fragments::List: the node based SetList and the
+// sorted vector FlatList that is the default.
+static void addData()
+{
+	QTest::addColumn<bool>("flat");
+	QTest::addColumn<int>("blocks");
+
+	QTest::newRow("set, 1000") << false << 1000;
+	QTest::newRow("flat, 1000") << true << 1000;
+	QTest::newRow("set, 50000") << false << 50000;
+	QTest::newRow("flat, 50000") << true << 50000;
+}
+
+#define BENCH_BOTH(FUNCTION) \
+	QFETCH(bool, flat); \
+	QFETCH(int, blocks); \
+	if(flat) \
+		FUNCTION<Fragments::FlatList>(blocks); \
+	else \
+		FUNCTION<Fragments::SetList>(blocks);
+
+void tst_Fragments::testInsert_data()
+{
+	addData();
+}
+
+void tst_Fragments::testInsert()
+{
+	BENCH_BOTH(benchInsert)
+}
+
+void tst_Fragments::testErase_data()
+{
+	addData();
+}
+
+void tst_Fragments::testErase()
+{
+	BENCH_BOTH(benchErase)
+}
+
+void tst_Fragments::testOverlaps_data()
+{
+	addData();
+}
+
+void tst_Fragments::testOverlaps()
+{
+	BENCH_BOTH(benchOverlaps)
+}
+
+void tst_Fragments::testLargestRange_data()
+{
+	addData();
+}
+
+void tst_Fragments::testLargestRange()
+{
+	BENCH_BOTH(benchLargestRange)
+}
+
+void tst_Fragments::testInverse_data()
+{
+	addData();
+}
+
+void tst_Fragments::testInverse()
+{
+	BENCH_BOTH(benchInverse)
+}
+
+QTEST_GUILESS_MAIN(tst_Fragments)
+
+#include "tst_fragments.moc"
@@ -0,0 +1,166 @@
+/*
+** tst_g2packet.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "g2packet.h"
+#include "buffer.h"
+
+#include <QtTest/QtTest>
+
+// Builds a query hit shaped packet: GUID and node address, then nChildren hit
+// descriptors with an URN, a size and a name each.
+static G2Packet* makeHit(int nChildren)
+{
+	G2Packet* pPacket = G2Packet::newPacket("QH2", true);
+
+	QUuid oGUID = QUuid::createUuid();
+	QByteArray baHash(20, 'h');
+	pPacket->writePacket("GU", 16)->writeGUID(oGUID);
+
+	CEndPoint oAddress(0x0A000001u, 6346);
+	pPacket->writePacket("NA", 6)->writeHostAddress(&oAddress);
+
+	for(int i = 0; i < nChildren; ++i)
+	{
+		const QString sName = QString("file number %1.mp3").arg(i);
+		const quint32 nName = sName.toUtf8().size();
+
+		// URN (5 + 25), SZ (4 + 4) and DN (4 + nName) children, no payload
+		pPacket->writePacket("H", 42 + nName, true);
+		pPacket->writePacket("URN", 25);
+		pPacket->writeString("sha1", true);
+		pPacket->write(baHash.data(), 20);
+		pPacket->writePacket("SZ", 4)->writeIntLE<quint32>(1024 * 1024 + i);
+		pPacket->writePacket("DN", nName)->writeString(sName, false);
+	}
+
+	pPacket->writeByte(0);
+	pPacket->write(baHash.data(), 16);
+
+	return pPacket;
+}
+
+// Walks the children of a compound packet up to nEnd the way the packet handlers do.
+static quint32 walk(G2Packet* pPacket, quint32 nEnd)
+{
+	char szType[9];
+	quint32 nLength = 0;
+	bool bCompound = false;
+	quint32 nChildren = 0;
+
+	while(pPacket->m_nPosition < nEnd && pPacket->readPacket(&szType[0], nLength, &bCompound))
+	{
+		const quint32 nNext = pPacket->m_nPosition + nLength;
+		if(bCompound)
+		{
+			nChildren += walk(pPacket, nNext);
+		}
+		pPacket->m_nPosition = nNext;
+		++nChildren;
+	}
+
+	return nChildren;
+}
+
+class tst_G2Packet : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testSerialize_data();
+	void testSerialize();
+	void testParse_data();
+	void testParse();
+};
+
+void tst_G2Packet::testSerialize_data()
+{
+	QTest::addColumn<int>("children");
+
+	QTest::newRow("1") << 1;
+	QTest::newRow("10") << 10;
+	QTest::newRow("100") << 100;
+}
+
+void tst_G2Packet::testSerialize()
+{
+	QFETCH(int, children);
+
+	CBuffer oBuffer(64 * 1024);
+
+	QBENCHMARK
+	{
+		G2Packet* pPacket = makeHit(children);
+		pPacket->toBuffer(&oBuffer);
+		pPacket->release();
+		oBuffer.clear();
+	}
+}
+
+void tst_G2Packet::testParse_data()
+{
+	QTest::addColumn<int>("children");
+	QTest::addColumn<int>("packets");
+
+	QTest::newRow("1 x 100") << 1 << 100;
+	QTest::newRow("10 x 100") << 10 << 100;
+	QTest::newRow("100 x 10") << 100 << 10;
+}
+
+void tst_G2Packet::testParse()
+{
+	QFETCH(int, children);
+	QFETCH(int, packets);
+
+	// A receive buffer holding a burst of packets, as read from a neighbour.
+	CBuffer oStream;
+	for(int i = 0; i < packets; ++i)
+	{
+		G2Packet* pPacket = makeHit(children);
+		pPacket->toBuffer(&oStream);
+		pPacket->release();
+	}
+
+	CBuffer oInput(oStream.size());
+	quint32 nChildren = 0;
+
+	QBENCHMARK
+	{
+		oInput.clear();
+		oInput.append(oStream);
+
+		nChildren = 0;
+		while(G2Packet* pPacket = G2Packet::readBuffer(&oInput))
+		{
+			nChildren += walk(pPacket, pPacket->m_nLength);
+			pPacket->release();
+		}
+	}
+
+	QCOMPARE(oInput.size(), 0u);
+	QCOMPARE(nChildren, quint32(packets * (2 + children * 4)));
+}
+
+QTEST_GUILESS_MAIN(tst_G2Packet)
+
+#include "tst_g2packet.moc"
@@ -0,0 +1,340 @@
+/*
+** tst_geoip.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "geoiplist.h"
+
+#include <QtTest/QtTest>
+
+static const int V4Ranges = 150000;
+static const int V6Ranges = 30000;
+static const int Lookups  = 100000;
+
+static const char* const Countries[] =
+{
+	"US", "DE", "GB", "FR", "NL", "SE", "PL", "RU", "UA", "IT", "ES", "PT", "BR", "AR", "CA", "MX",
+	"JP", "CN", "KR", "TW", "IN", "AU", "NZ", "ZA", "EG", "TR", "GR", "RO", "HU", "CZ", "AT", "CH"
+};
+static const int CountryCount = sizeof(Countries) / sizeof(Countries[0]);
+
+// The GeoIP list of older versions: (begin, (end, country)) pairs, serialised with
+// QDataStream and sorted again on every start.
+typedef QPair<quint32, QPair<quint32, QString> > GeoIPEntry;
+typedef QList<GeoIPEntry> GeoIPLegacyList;
+
+static QString findLegacy(const GeoIPLegacyList& lDatabase, const quint32 nIp)
+{
+	int nMiddle;
+	int nBegin = 0;
+	int nEnd = lDatabase.size();
+
+	int n = nEnd - nBegin;
+
+	int nHalf;
+
+	while (n > 0)
+	{
+		nHalf = n >> 1;
+
+		nMiddle = nBegin + nHalf;
+
+		if (nIp < lDatabase.at(nMiddle).first )
+		{
+			n = nHalf;
+		}
+		else
+		{
+			if( nIp <= lDatabase.at(nMiddle).second.first )
+			{
+				return lDatabase.at(nMiddle).second.second;
+			}
+			nBegin = nMiddle + 1;
+			n -= nHalf + 1;
+		}
+	}
+
+	return "ZZ";
+}
+
+// Reaches the steps loadGeoIP() takes on the first start (compile) and on later ones (map).
+class CGeoIPBench : public CGeoIPList
+{
+public:
+	bool compileFrom(const QString& sSource, QByteArray& baOutput) const
+	{
+		return compile(sSource, baOutput);
+	}
+
+	bool mapFile(const QString& sPath)
+	{
+		detach();
+		m_oFile.close();
+		m_oFile.setFileName(sPath);
+
+		uchar* pData = 0;
+		if(m_oFile.open(QIODevice::ReadOnly) && (pData = m_oFile.map(0, m_oFile.size())) && attach(pData, m_oFile.size()))
+		{
+			m_bListLoaded = (m_nV4 || m_nV6);
+		}
+
+		return m_bListLoaded;
+	}
+};
+
+class tst_GeoIP : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir       m_oHome;
+	GeoIPLegacyList     m_lLegacy;
+	CGeoIPBench         m_oMapped;
+
+	QVector<quint32>    m_vV4;
+	QList<QHostAddress> m_lV4;
+	QVector<Q_IPV6ADDR> m_vV6;
+
+	QString sourceFile() const
+	{
+		return m_oHome.path() + "/geoip.dat";
+	}
+	QString compiledFile() const
+	{
+		return m_oHome.path() + "/geoip.bin";
+	}
+	QString serialisedFile() const
+	{
+		return m_oHome.path() + "/geoIP.ser";
+	}
+
+private slots:
+	void initTestCase();
+
+	void testStartup_data();
+	void testStartup();
+
+	void testLookup_data();
+	void testLookup();
+};
+
+// Writes a geoip.dat of 150k IPv4 and 30k IPv6 ranges, then stores it in both formats.
+void tst_GeoIP::initTestCase()
+{
+	QVERIFY(m_oHome.isValid());
+
+	qsrand(35);
+
+	QFile oSource(sourceFile());
+	QVERIFY(oSource.open(QIODevice::WriteOnly | QIODevice::Text));
+	QTextStream oStream(&oSource);
+
+	quint32 nNext = 0x01000000u;
+	for(int i = 0; i < V4Ranges; ++i)
+	{
+		const quint32 nBegin = nNext;
+		const quint32 nEnd = nBegin + (256u << (qrand() % 6)) - 1;
+		const QString sCountry = Countries[qrand() % CountryCount];
+
+		oStream << QHostAddress(nBegin).toString() << ' ' << QHostAddress(nEnd).toString() << ' ' << sCountry << '\n';
+		m_lLegacy.append(GeoIPEntry(nBegin, QPair<quint32, QString>(nEnd, sCountry)));
+
+		// now and then a gap no country claims
+		nNext = nEnd + 1 + (qrand() % 4 ? 0 : 256u * (qrand() % 16));
+	}
+
+	for(int i = 0; i < V6Ranges; ++i)
+	{
+		Q_IPV6ADDR oBegin, oEnd;
+		memset(&oBegin, 0, 16);
+		oBegin[0] = 0x20;
+		oBegin[1] = 0x01;
+		oBegin[2] = uchar(i >> 7);
+		oBegin[3] = uchar(i << 1);
+		oEnd = oBegin;
+		memset(&oEnd[4], 0xff, 12);
+
+		oStream << QHostAddress(oBegin).toString() << ' ' << QHostAddress(oEnd).toString() << ' '
+				<< Countries[qrand() % CountryCount] << '\n';
+	}
+
+	oStream.flush();
+	oSource.close();
+
+	// the old list, as geoIP.ser held it
+	QFile oSerialised(serialisedFile());
+	QVERIFY(oSerialised.open(QIODevice::WriteOnly));
+	QDataStream oOut(&oSerialised);
+	oOut << m_lLegacy;
+	oSerialised.close();
+
+	// the compiled database, as geoip.bin holds it
+	QByteArray baDatabase;
+	QVERIFY(m_oMapped.compileFrom(sourceFile(), baDatabase));
+	QFile oCompiled(compiledFile());
+	QVERIFY(oCompiled.open(QIODevice::WriteOnly));
+	QCOMPARE(oCompiled.write(baDatabase), qint64(baDatabase.size()));
+	oCompiled.close();
+
+	QVERIFY(m_oMapped.mapFile(compiledFile()));
+
+	for(int i = 0; i < Lookups; ++i)
+	{
+		const quint32 nIp = 0x01000000u + quint32(qrand()) % (nNext - 0x01000000u);
+		m_vV4.append(nIp);
+		m_lV4.append(QHostAddress(nIp));
+
+		Q_IPV6ADDR oIp;
+		for(int j = 0; j < 16; ++j)
+		{
+			oIp[j] = uchar(qrand());
+		}
+		oIp[0] = 0x20;
+		oIp[1] = 0x01;
+		oIp[2] = uchar(qrand() % (V6Ranges >> 7));
+		m_vV6.append(oIp);
+	}
+
+	// both formats have to agree before their speed means anything
+	const QStringList lBatch = m_oMapped.findCountryCodes(m_lV4);
+	for(int i = 0; i < Lookups; ++i)
+	{
+		const QString sLegacy = findLegacy(m_lLegacy, m_vV4[i]);
+		QCOMPARE(m_oMapped.findCountryCode(m_vV4[i]), sLegacy);
+		QCOMPARE(lBatch.at(i), sLegacy);
+	}
+}
+
+void tst_GeoIP::testStartup_data()
+{
+	QTest::addColumn<int>("format");
+
+	QTest::newRow("serialised list") << 0;
+	QTest::newRow("mapped database") << 1;
+	QTest::newRow("first start, compile") << 2;
+}
+
+// What loading the list costs on every start, and once after geoip.dat changes.
+void tst_GeoIP::testStartup()
+{
+	QFETCH(int, format);
+
+	if(format == 0)
+	{
+		QBENCHMARK
+		{
+			GeoIPLegacyList lDatabase;
+
+			QFile oFile(serialisedFile());
+			QVERIFY(oFile.open(QIODevice::ReadOnly));
+			QDataStream oStream(&oFile);
+			oStream >> lDatabase;
+			qSort(lDatabase);
+
+			QCOMPARE(lDatabase.size(), V4Ranges);
+		}
+	}
+	else if(format == 1)
+	{
+		CGeoIPBench oList;
+
+		QBENCHMARK
+		{
+			QVERIFY(oList.mapFile(compiledFile()));
+		}
+	}
+	else
+	{
+		CGeoIPBench oList;
+
+		QBENCHMARK
+		{
+			QByteArray baDatabase;
+			QVERIFY(oList.compileFrom(sourceFile(), baDatabase));
+		}
+	}
+}
+
+void tst_GeoIP::testLookup_data()
+{
+	QTest::addColumn<int>("mode");
+
+	QTest::newRow("serialised list") << 0;
+	QTest::newRow("mapped database") << 1;
+	QTest::newRow("mapped database, batch") << 2;
+	QTest::newRow("mapped database, IPv6") << 3;
+}
+
+// Lookups per second over 100k random addresses, most of them inside a known range.
+void tst_GeoIP::testLookup()
+{
+	QFETCH(int, mode);
+
+	quint64 nLookups = 0, nKnown = 0;
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	do
+	{
+		if(mode == 0)
+		{
+			for(int i = 0; i < Lookups; ++i)
+			{
+				nKnown += (findLegacy(m_lLegacy, m_vV4[i]) != "ZZ");
+			}
+		}
+		else if(mode == 1)
+		{
+			for(int i = 0; i < Lookups; ++i)
+			{
+				nKnown += (m_oMapped.findCountryCode(m_vV4[i]) != "ZZ");
+			}
+		}
+		else if(mode == 2)
+		{
+			foreach(const QString& sCode, m_oMapped.findCountryCodes(m_lV4))
+			{
+				nKnown += (sCode != "ZZ");
+			}
+		}
+		else
+		{
+			for(int i = 0; i < Lookups; ++i)
+			{
+				nKnown += (m_oMapped.findCountryCode(m_vV6[i]) != "ZZ");
+			}
+		}
+
+		nLookups += Lookups;
+	}
+	while(oTimer.elapsed() < 500);
+
+	const qint64 nElapsed = qMax<qint64>(1, oTimer.elapsed());
+
+	qDebug("%llu lookups, %llu in a known range, in %lld ms", nLookups, nKnown, nElapsed);
+	QTest::setBenchmarkResult(nLookups * 1000.0 / nElapsed, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(tst_GeoIP)
+
+#include "tst_geoip.moc"
@@ -0,0 +1,475 @@
+/*
+** tst_hash.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "Hashes/hash.h"
+#include "3rdparty/CyoEncode/CyoDecode.h"
+
+#include <QtTest/QtTest>
+#include <cstdlib>
+
+#if defined(__GLIBC__) && !defined(_USE_DEBUG_NEW)
+// Heap calls made by the process, counted by wrapping glibc's allocator. operator new, QByteArray
+// and QString all end up here.
+#define ALLOCATION_COUNTING
+static QBasicAtomicInt Allocations = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+extern "C"
+{
+void* __libc_malloc(size_t nSize);
+void* __libc_calloc(size_t nCount, size_t nSize);
+void* __libc_realloc(void* pData, size_t nSize);
+
+void* malloc(size_t nSize) __THROW
+{
+	Allocations.ref();
+	return __libc_malloc(nSize);
+}
+
+void* calloc(size_t nCount, size_t nSize) __THROW
+{
+	Allocations.ref();
+	return __libc_calloc(nCount, nSize);
+}
+
+void* realloc(void* pData, size_t nSize) __THROW
+{
+	Allocations.ref();
+	return __libc_realloc(pData, nSize);
+}
+}
+#endif
+
+// CHash as it was before CHashContext: the digest in a QByteArray, the context on the heap,
+// URNs parsed into a new object. Kept to the parts the benchmarks below use.
+class CLegacyHash
+{
+public:
+	QCryptographicHash*	m_pContext;
+	CHash::Algorithm	m_nHashAlgorithm;
+	QByteArray			m_baRawValue;
+
+public:
+	CLegacyHash() :
+		m_pContext(0),
+		m_nHashAlgorithm(CHash::SHA1)
+	{
+	}
+	CLegacyHash(const CLegacyHash& rhs) :
+		m_pContext(0),
+		m_nHashAlgorithm(rhs.m_nHashAlgorithm),
+		m_baRawValue(rhs.m_baRawValue)
+	{
+	}
+	CLegacyHash(CHash::Algorithm algo) :
+		m_pContext(0),
+		m_nHashAlgorithm(algo)
+	{
+		switch(algo)
+		{
+		case CHash::MD4:
+			m_pContext = new QCryptographicHash(QCryptographicHash::Md4);
+			break;
+		case CHash::MD5:
+			m_pContext = new QCryptographicHash(QCryptographicHash::Md5);
+			break;
+		default:
+			m_pContext = new QCryptographicHash(QCryptographicHash::Sha1);
+			break;
+		}
+	}
+	CLegacyHash(QByteArray baRaw, CHash::Algorithm algo) :
+		m_pContext(0),
+		m_nHashAlgorithm(algo),
+		m_baRawValue(baRaw)
+	{
+		if(baRaw.size() != CHash::byteCount(algo))
+		{
+			throw invalid_hash_exception();
+		}
+	}
+	~CLegacyHash()
+	{
+		delete m_pContext;
+	}
+
+	CLegacyHash& operator=(const CLegacyHash& rhs)
+	{
+		m_nHashAlgorithm = rhs.m_nHashAlgorithm;
+		m_baRawValue = rhs.m_baRawValue;
+		return *this;
+	}
+
+	void addData(const char* pData, quint32 nLength)
+	{
+		m_pContext->addData(pData, nLength);
+	}
+
+	void finalize()
+	{
+		m_baRawValue = m_pContext->result();
+		delete m_pContext;
+		m_pContext = 0;
+	}
+
+	bool operator==(const CLegacyHash& oHash) const
+	{
+		return oHash.m_nHashAlgorithm == m_nHashAlgorithm && oHash.m_baRawValue == m_baRawValue;
+	}
+
+	static CLegacyHash* fromURN(QString sURN)
+	{
+		int nStart = (strncmp("urn:", sURN.toLocal8Bit().data(), 4) == 0 ? 4 : 0);
+		int nStartHash = sURN.indexOf(":", nStart) + 1;
+		QByteArray baFamily = sURN.mid(nStart, nStartHash - nStart - 1).toLower().toLocal8Bit();
+		QByteArray baValue = sURN.mid(nStartHash).toLocal8Bit();
+		char pVal[128];
+
+		if(baFamily == "sha1" && baValue.length() == 32 && cyoBase32Validate(baValue.data(), baValue.length()) == 0)
+		{
+			cyoBase32Decode((char*)&pVal, baValue.data(), baValue.length());
+			return new CLegacyHash(QByteArray((char*)&pVal, 20), CHash::SHA1);
+		}
+
+		return 0;
+	}
+};
+
+uint qHash(const CLegacyHash& oHash)
+{
+	return qHash(oHash.m_baRawValue);
+}
+
+static QVector<CHash> hashes(int nCount, int nSeed)
+{
+	QVector<CHash> vHashes;
+	vHashes.reserve(nCount);
+	for(int i = 0; i < nCount; ++i)
+	{
+		CHashContext oContext(CHash::SHA1);
+		oContext.addData(QByteArray::number(nSeed + i));
+		vHashes << oContext.result();
+	}
+	return vHashes;
+}
+
+static QVector<CLegacyHash> legacyHashes(const QVector<CHash>& vHashes)
+{
+	QVector<CLegacyHash> vLegacy;
+	vLegacy.reserve(vHashes.size());
+	foreach(const CHash& oHash, vHashes)
+	{
+		vLegacy << CLegacyHash(oHash.rawValue(), oHash.getAlgorithm());
+	}
+	return vLegacy;
+}
+
+class tst_Hash : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testContext_data();
+	void testContext();
+	void testLookup_data();
+	void testLookup();
+	void testURN_data();
+	void testURN();
+	void testAllocations_data();
+	void testAllocations();
+};
+
+void tst_Hash::testContext_data()
+{
+	QTest::addColumn<bool>("legacy");
+	QTest::addColumn<int>("algorithm");
+	QTest::addColumn<int>("size");
+
+	QTest::newRow("SHA1, 64") << false << int(CHash::SHA1) << 64;
+	QTest::newRow("SHA1, 64, old CHash") << true << int(CHash::SHA1) << 64;
+	QTest::newRow("SHA1, 256k") << false << int(CHash::SHA1) << 256 * 1024;
+	QTest::newRow("SHA1, 256k, old CHash") << true << int(CHash::SHA1) << 256 * 1024;
+	QTest::newRow("MD5, 256k") << false << int(CHash::MD5) << 256 * 1024;
+	QTest::newRow("MD4, 256k") << false << int(CHash::MD4) << 256 * 1024;
+}
+
+void tst_Hash::testContext()
+{
+	QFETCH(bool, legacy);
+	QFETCH(int, algorithm);
+	QFETCH(int, size);
+
+	const QByteArray baData(size, 'x');
+
+	// Library hashing feeds files in pieces of this size.
+	const int nPiece = qMin(size, 64 * 1024);
+
+	if(legacy)
+	{
+		QBENCHMARK
+		{
+			CLegacyHash oHash((CHash::Algorithm(algorithm)));
+			for(int i = 0; i < size; i += nPiece)
+			{
+				oHash.addData(baData.constData() + i, nPiece);
+			}
+			oHash.finalize();
+			QVERIFY(!oHash.m_baRawValue.isEmpty());
+		}
+	}
+	else
+	{
+		QBENCHMARK
+		{
+			CHashContext oContext(CHash::Algorithm(algorithm));
+			for(int i = 0; i < size; i += nPiece)
+			{
+				oContext.addData(baData.constData() + i, nPiece);
+			}
+			QVERIFY(!oContext.result().isNull());
+		}
+	}
+}
+
+void tst_Hash::testLookup_data()
+{
+	QTest::addColumn<bool>("legacy");
+	QTest::addColumn<int>("count");
+
+	QTest::newRow("1000") << false << 1000;
+	QTest::newRow("1000, old CHash") << true << 1000;
+	QTest::newRow("100000") << false << 100000;
+	QTest::newRow("100000, old CHash") << true << 100000;
+}
+
+void tst_Hash::testLookup()
+{
+	QFETCH(bool, legacy);
+	QFETCH(int, count);
+
+	// Shared file index keyed by hash, as searched for every incoming URN query.
+	const QVector<CHash> vHashes = hashes(count, 0);
+	const QVector<CHash> vMisses = hashes(1000, count);
+	int nFound = 0;
+
+	if(legacy)
+	{
+		const QVector<CLegacyHash> vLegacy = legacyHashes(vHashes);
+		const QVector<CLegacyHash> vLegacyMisses = legacyHashes(vMisses);
+		QHash<CLegacyHash, int> hIndex;
+		for(int i = 0; i < vLegacy.size(); ++i)
+		{
+			hIndex.insert(vLegacy[i], i);
+		}
+
+		QBENCHMARK
+		{
+			nFound = 0;
+			for(int i = 0; i < 1000; ++i)
+			{
+				nFound += hIndex.contains(vLegacy[i % count]);
+				nFound += hIndex.contains(vLegacyMisses[i]);
+			}
+		}
+	}
+	else
+	{
+		QHash<CHash, int> hIndex;
+		for(int i = 0; i < vHashes.size(); ++i)
+		{
+			hIndex.insert(vHashes[i], i);
+		}
+
+		QBENCHMARK
+		{
+			nFound = 0;
+			for(int i = 0; i < 1000; ++i)
+			{
+				nFound += hIndex.contains(vHashes[i % count]);
+				nFound += hIndex.contains(vMisses[i]);
+			}
+		}
+	}
+
+	QCOMPARE(nFound, 1000);
+}
+
+void tst_Hash::testURN_data()
+{
+	QTest::addColumn<bool>("legacy");
+
+	QTest::newRow("CHash") << false;
+	QTest::newRow("old CHash") << true;
+}
+
+void tst_Hash::testURN()
+{
+	QFETCH(bool, legacy);
+
+	const QVector<CHash> vHashes = hashes(1000, 0);
+	QStringList lURNs;
+	foreach(const CHash& oHash, vHashes)
+	{
+		lURNs << oHash.toURN();
+	}
+
+	int nValid = 0;
+
+	if(legacy)
+	{
+		QBENCHMARK
+		{
+			nValid = 0;
+			foreach(const QString& sURN, lURNs)
+			{
+				CLegacyHash* pHash = CLegacyHash::fromURN(sURN);
+				nValid += (pHash != 0);
+				delete pHash;
+			}
+		}
+	}
+	else
+	{
+		QBENCHMARK
+		{
+			nValid = 0;
+			foreach(const QString& sURN, lURNs)
+			{
+				nValid += !CHash::fromURN(sURN).isNull();
+			}
+		}
+	}
+
+	QCOMPARE(nValid, lURNs.size());
+}
+
+void tst_Hash::testAllocations_data()
+{
+	QTest::addColumn<bool>("legacy");
+	QTest::addColumn<int>("operation");
+
+	const char* const aOperations[] = { "hash 64 bytes", "copy into a hit", "parse URN", "index lookup" };
+
+	for(int i = 0; i < 4; ++i)
+	{
+		QTest::newRow(aOperations[i]) << false << i;
+		QTest::newRow(qPrintable(QString("%1, old CHash").arg(aOperations[i]))) << true << i;
+	}
+}
+
+// Heap calls per operation, averaged over 1000 of them. Reported as events.
+void tst_Hash::testAllocations()
+{
+#ifndef ALLOCATION_COUNTING
+	QSKIP("Allocations are only counted with glibc");
+#else
+	QFETCH(bool, legacy);
+	QFETCH(int, operation);
+
+	const int nOperations = 1000;
+	const QByteArray baData(64, 'x');
+	const QVector<CHash> vHashes = hashes(nOperations, 0);
+	const QVector<CLegacyHash> vLegacy = legacyHashes(vHashes);
+
+	QStringList lURNs;
+	foreach(const CHash& oHash, vHashes)
+	{
+		lURNs << oHash.toURN();
+	}
+
+	QHash<CHash, int> hIndex;
+	QHash<CLegacyHash, int> hLegacyIndex;
+	for(int i = 0; i < nOperations; ++i)
+	{
+		hIndex.insert(vHashes[i], i);
+		hLegacyIndex.insert(vLegacy[i], i);
+	}
+
+	// A hit's hash list, as the query hit parser builds it
+	QVector<CHash> vHit;
+	QVector<CLegacyHash> vLegacyHit;
+	vHit.reserve(nOperations);
+	vLegacyHit.reserve(nOperations);
+
+	int nCheck = 0;
+	const int nBefore = Allocations.load();
+
+	for(int i = 0; i < nOperations; ++i)
+	{
+		switch(operation)
+		{
+		case 0:
+			if(legacy)
+			{
+				CLegacyHash oHash(CHash::SHA1);
+				oHash.addData(baData.constData(), baData.size());
+				oHash.finalize();
+				nCheck += oHash.m_baRawValue.size();
+			}
+			else
+			{
+				CHashContext oContext(CHash::SHA1);
+				oContext.addData(baData.constData(), baData.size());
+				nCheck += oContext.result().length();
+			}
+			break;
+		case 1:
+			if(legacy)
+			{
+				vLegacyHit.append(CLegacyHash(QByteArray(vHashes[i].rawData(), vHashes[i].length()), CHash::SHA1));
+			}
+			else
+			{
+				vHit.append(CHash(vHashes[i].rawData(), vHashes[i].length(), CHash::SHA1));
+			}
+			nCheck += 20;
+			break;
+		case 2:
+			if(legacy)
+			{
+				CLegacyHash* pHash = CLegacyHash::fromURN(lURNs.at(i));
+				nCheck += pHash ? pHash->m_baRawValue.size() : 0;
+				delete pHash;
+			}
+			else
+			{
+				nCheck += CHash::fromURN(lURNs.at(i)).length();
+			}
+			break;
+		default:
+			nCheck += 20 * (legacy ? hLegacyIndex.contains(vLegacy[i]) : hIndex.contains(vHashes[i]));
+			break;
+		}
+	}
+
+	const int nAllocations = Allocations.load() - nBefore;
+
+	QCOMPARE(nCheck, nOperations * 20);
+
+	qDebug("%d heap calls for %d operations", nAllocations, nOperations);
+	QTest::setBenchmarkResult(double(nAllocations) / nOperations, QTest::Events);
+#endif
+}
+
+QTEST_GUILESS_MAIN(tst_Hash)
+
+#include "tst_hash.moc"
@@ -0,0 +1,314 @@
+/*
+** tst_headerparser.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "headerparser.h"
+#include "buffer.h"
+
+#include <QtTest/QtTest>
+
+static const char* Handshake =
+	"GNUTELLA CONNECT/0.6\r\n"
+	"Listen-IP: 10.0.0.1:6346\r\n"
+	"Remote-IP: 10.0.0.2\r\n"
+	"User-Agent: Quazaa 0.1\r\n"
+	"Accept: application/x-gnutella2\r\n"
+	"Accept-Encoding: deflate\r\n"
+	"X-Hub: False\r\n"
+	"X-Hub-Needed: True\r\n"
+	"X-Ultrapeer: False\r\n"
+	"X-Ultrapeer-Needed: True\r\n"
+	"\r\n";
+
+class tst_HeaderParser : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testParse_data();
+	void testParse();
+	void testValue();
+	void testStorm_data();
+	void testStorm();
+};
+
+// Parser::getHeaderValue as handshakes used it before CHeaderParser: a case-insensitive
+// scan of the whole handshake text per header.
+static QString legacyHeaderValue(QString& headers, QString headerName)
+{
+	qint32 nStart, nEnd, nColon;
+	headerName += ":";
+
+	nStart = headers.indexOf(headerName, 0, Qt::CaseInsensitive);
+	if(nStart < 0)
+	{
+		return QString();
+	}
+
+	nEnd = headers.indexOf("\r\n", nStart);
+	if(nEnd < 0)
+	{
+		return QString();
+	}
+
+	nColon = headers.indexOf(":", nStart);
+	if(nColon < 0 || nColon > nEnd)
+	{
+		return QString();
+	}
+
+	return headers.mid(nColon + 1, nEnd - nColon).trimmed();
+}
+
+// One incoming connection of the storm: what the peer will send and what we have read so far.
+struct CStormPeer
+{
+	QByteArray    baSend;
+	int           nSent;
+	CBuffer       oInput;
+	CHeaderParser oParser;
+	bool          bClosed;
+
+	CStormPeer(const QByteArray& baData) : baSend(baData), nSent(0), bClosed(false)
+	{
+	}
+};
+
+void tst_HeaderParser::testParse_data()
+{
+	QTest::addColumn<int>("chunk");
+
+	// 0: the whole handshake in one read; otherwise it trickles in "chunk" bytes at a time
+	// and parse() is called on the growing input after each read, as on a connect storm of
+	// slow peers.
+	QTest::newRow("whole") << 0;
+	QTest::newRow("64") << 64;
+	QTest::newRow("16") << 16;
+	QTest::newRow("1") << 1;
+}
+
+void tst_HeaderParser::testParse()
+{
+	QFETCH(int, chunk);
+
+	const quint32 nLength = strlen(Handshake);
+	CHeaderParser oParser;
+
+	QBENCHMARK
+	{
+		for(int i = 0; i < 100; ++i)
+		{
+			oParser.reset();
+			if(chunk)
+			{
+				for(quint32 nRead = chunk; nRead < nLength; nRead += chunk)
+				{
+					oParser.parse(Handshake, nRead);
+				}
+			}
+			oParser.parse(Handshake, nLength);
+		}
+	}
+
+	QCOMPARE(oParser.state(), CHeaderParser::hsComplete);
+	QCOMPARE(oParser.length(), nLength);
+}
+
+void tst_HeaderParser::testValue()
+{
+	CHeaderParser oParser;
+	QCOMPARE(oParser.parse(Handshake, strlen(Handshake)), CHeaderParser::hsComplete);
+
+	QBENCHMARK
+	{
+		QVERIFY(oParser.value("User-Agent").startsWith("Quazaa"));
+		QVERIFY(oParser.contains("x-ultrapeer-needed"));
+		QVERIFY(!oParser.contains("X-Auth-Challenge"));
+	}
+}
+
+void tst_HeaderParser::testStorm_data()
+{
+	QTest::addColumn<bool>("legacy");
+	QTest::addColumn<int>("peers");
+	QTest::addColumn<int>("chunk");
+
+	// A connect storm: every peer trickles its handshake in reads of up to "chunk" bytes,
+	// round-robin, and one peer in ten is junk that keeps sending header lines without ever
+	// ending the handshake. legacy: peek() the whole input and search for the blank line
+	// after every read, then copy it into a QString and scan it once per header;
+	// otherwise: CHeaderParser on the input, dropping peers that outgrow its limit.
+	QTest::newRow("1000 peers, 64 byte reads, old") << true << 1000 << 64;
+	QTest::newRow("1000 peers, 64 byte reads, new") << false << 1000 << 64;
+	QTest::newRow("1000 peers, 8 byte reads, old") << true << 1000 << 8;
+	QTest::newRow("1000 peers, 8 byte reads, new") << false << 1000 << 8;
+	QTest::newRow("5000 peers, 64 byte reads, old") << true << 5000 << 64;
+	QTest::newRow("5000 peers, 64 byte reads, new") << false << 5000 << 64;
+}
+
+void tst_HeaderParser::testStorm()
+{
+	QFETCH(bool, legacy);
+	QFETCH(int, peers);
+	QFETCH(int, chunk);
+
+	QList<CStormPeer*> lPeers;
+	int nGood = 0;
+
+	for(int i = 0; i < peers; ++i)
+	{
+		QByteArray baData;
+
+		if(i % 10 == 9)
+		{
+			baData = "GNUTELLA CONNECT/0.6\r\n";
+			while(baData.size() < 32768)
+			{
+				baData += "X-Junk-" + QByteArray::number(baData.size()) + ": " + QByteArray(48, 'x') + "\r\n";
+			}
+		}
+		else
+		{
+			baData = QByteArray(Handshake).replace("Quazaa 0.1", "Quazaa 0.1." + QByteArray::number(i));
+			++nGood;
+		}
+
+		lPeers.append(new CStormPeer(baData));
+	}
+
+	int nAccepted = 0, nRejected = 0;
+	quint64 nBuffered = 0, nPeakBuffered = 0;
+	bool bPending = true;
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	for(int nRound = 0; bPending; ++nRound)
+	{
+		bPending = false;
+
+		for(int i = 0; i < lPeers.size(); ++i)
+		{
+			CStormPeer* pPeer = lPeers[i];
+
+			if(pPeer->bClosed || pPeer->nSent == pPeer->baSend.size())
+			{
+				continue;
+			}
+
+			const int nRead = qMin(1 + (i * 7 + nRound) % chunk, pPeer->baSend.size() - pPeer->nSent);
+			pPeer->oInput.append(pPeer->baSend.constData() + pPeer->nSent, nRead);
+			pPeer->nSent += nRead;
+			nBuffered += nRead;
+			bPending = true;
+
+			QString sUserAgent, sAccept, sEncoding, sUltrapeer, sRemoteIP;
+
+			if(legacy)
+			{
+				QByteArray baPeek = QByteArray::fromRawData(pPeer->oInput.data(), pPeer->oInput.size());
+				const int nIndex = baPeek.indexOf("\r\n\r\n");
+
+				if(nIndex == -1)
+				{
+					continue;
+				}
+
+				QString sHs = QByteArray(pPeer->oInput.data(), nIndex + 4);
+				pPeer->oInput.remove(nIndex + 4);
+
+				sUserAgent = legacyHeaderValue(sHs, "User-Agent");
+				sAccept    = legacyHeaderValue(sHs, "Accept");
+				sEncoding  = legacyHeaderValue(sHs, "Accept-Encoding");
+				sUltrapeer = legacyHeaderValue(sHs, "X-Ultrapeer");
+				if(sUltrapeer.isEmpty())
+				{
+					sUltrapeer = legacyHeaderValue(sHs, "X-Hub");
+				}
+				sRemoteIP  = legacyHeaderValue(sHs, "Remote-IP");
+			}
+			else
+			{
+				const CHeaderParser::State eState = pPeer->oParser.parse(&pPeer->oInput);
+
+				if(eState == CHeaderParser::hsIncomplete)
+				{
+					continue;
+				}
+
+				if(eState != CHeaderParser::hsComplete)
+				{
+					nBuffered -= pPeer->oInput.size();
+					pPeer->oInput.clear();
+					pPeer->bClosed = true;
+					++nRejected;
+					continue;
+				}
+
+				sUserAgent = pPeer->oParser.value("User-Agent");
+				sAccept    = pPeer->oParser.value("Accept");
+				sEncoding  = pPeer->oParser.value("Accept-Encoding");
+				sUltrapeer = pPeer->oParser.value("X-Ultrapeer");
+				if(sUltrapeer.isEmpty())
+				{
+					sUltrapeer = pPeer->oParser.value("X-Hub");
+				}
+				sRemoteIP  = pPeer->oParser.value("Remote-IP");
+
+				pPeer->oInput.remove(pPeer->oParser.length());
+			}
+
+			nPeakBuffered = qMax(nPeakBuffered, nBuffered);
+			nBuffered -= pPeer->nSent;
+			pPeer->bClosed = true;
+
+			if(!sUserAgent.isEmpty() && sAccept.contains("application/x-gnutella2") && !sRemoteIP.isEmpty())
+			{
+				++nAccepted;
+			}
+		}
+
+		nPeakBuffered = qMax(nPeakBuffered, nBuffered);
+	}
+
+	const qint64 nElapsed = qMax<qint64>(oTimer.elapsed(), 1);
+
+	// The old path never gives up on junk peers: they sit in the input buffer until they stop sending.
+	if(legacy)
+	{
+		nRejected = peers - nAccepted;
+	}
+
+	qDeleteAll(lPeers);
+
+	QCOMPARE(nAccepted, nGood);
+	QCOMPARE(nRejected, peers - nGood);
+
+	QTest::setBenchmarkResult(nAccepted * 1000.0 / nElapsed, QTest::Events);
+	qDebug() << nAccepted << "handshakes accepted," << nRejected << "junk peers," << nElapsed << "ms,"
+			 << nPeakBuffered / 1024 << "KB peak buffered";
+}
+
+QTEST_GUILESS_MAIN(tst_HeaderParser)
+
+#include "tst_headerparser.moc"
@@ -0,0 +1,221 @@
+/*
+** tst_queryhashtable.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "queryhashtable.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+
+// File names shaped like a shared library: a few words, digits and an extension.
+static QStringList fileNames(int nCount, int nSeed)
+{
+	static const char* aWords[] = {"live", "remix", "the", "best", "of", "summer", "night",
+								   "session", "part", "radio", "edit", "original", "mix",
+								   "holiday", "video", "concert", "album", "track", "demo"};
+	static const char* aExtensions[] = {"mp3", "avi", "ogg", "jpg", "pdf"};
+	const int nWords = sizeof(aWords) / sizeof(aWords[0]);
+
+	QStringList lNames;
+	for(int i = 0; i < nCount; ++i)
+	{
+		const int n = i + nSeed;
+		lNames << QString("%1 %2 %3 %4 %5.%6").arg(aWords[n % nWords])
+												.arg(aWords[(n / 3) % nWords])
+												.arg(aWords[(n / 7) % nWords])
+												.arg(n)
+												.arg(aWords[(n / 11) % nWords])
+												.arg(aExtensions[n % 5]);
+	}
+	return lNames;
+}
+
+class tst_QueryHashTable : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+
+	void testHashWord_data();
+	void testHashWord();
+	void testAddString_data();
+	void testAddString();
+	void testMerge_data();
+	void testMerge();
+	void testCheckString_data();
+	void testCheckString();
+};
+
+void tst_QueryHashTable::initTestCase()
+{
+	quazaaSettings.Library.QueryRouteSize = 20;
+}
+
+void tst_QueryHashTable::testHashWord_data()
+{
+	QTest::addColumn<int>("length");
+
+	QTest::newRow("4") << 4;
+	QTest::newRow("8") << 8;
+	QTest::newRow("32") << 32;
+}
+
+void tst_QueryHashTable::testHashWord()
+{
+	QFETCH(int, length);
+
+	QList<QByteArray> lWords;
+	for(int i = 0; i < 1000; ++i)
+	{
+		lWords << QByteArray::number(i * 7919).leftJustified(length, 'k', true);
+	}
+
+	quint32 nSum = 0;
+	QBENCHMARK
+	{
+		foreach(const QByteArray& baWord, lWords)
+		{
+			nSum += CQueryHashTable::hashWord(baWord.constData(), baWord.size(), 20);
+		}
+	}
+	Q_UNUSED(nSum);
+}
+
+void tst_QueryHashTable::testAddString_data()
+{
+	QTest::addColumn<int>("files");
+
+	QTest::newRow("100") << 100;
+	QTest::newRow("1000") << 1000;
+}
+
+void tst_QueryHashTable::testAddString()
+{
+	QFETCH(int, files);
+
+	const QStringList lNames = fileNames(files, 0);
+	CQueryHashTable oTable;
+	oTable.create();
+
+	QBENCHMARK
+	{
+		oTable.clear();
+		foreach(const QString& sName, lNames)
+		{
+			oTable.addString(sName);
+		}
+	}
+
+	QVERIFY(oTable.m_nCount > 0);
+}
+
+void tst_QueryHashTable::testMerge_data()
+{
+	QTest::addColumn<int>("leaves");
+	QTest::addColumn<int>("leafBits");
+
+	QTest::newRow("10 leaves, same size") << 10 << 20;
+	QTest::newRow("10 leaves, 2^16") << 10 << 16;
+	QTest::newRow("100 leaves, same size") << 100 << 20;
+}
+
+void tst_QueryHashTable::testMerge()
+{
+	QFETCH(int, leaves);
+	QFETCH(int, leafBits);
+
+	// Leaf tables as received from neighbours, merged into the hub table we send upwards.
+	QList<CQueryHashTable*> lLeaves;
+	quazaaSettings.Library.QueryRouteSize = leafBits;
+	for(int i = 0; i < leaves; ++i)
+	{
+		CQueryHashTable* pLeaf = new CQueryHashTable();
+		pLeaf->create();
+		foreach(const QString& sName, fileNames(50, i * 50))
+		{
+			pLeaf->addExactString(sName);
+		}
+		lLeaves << pLeaf;
+	}
+	quazaaSettings.Library.QueryRouteSize = 20;
+
+	CQueryHashTable oHub;
+	oHub.create();
+
+	QBENCHMARK
+	{
+		oHub.clear();
+		foreach(const CQueryHashTable* pLeaf, lLeaves)
+		{
+			oHub.merge(pLeaf);
+		}
+	}
+
+	QVERIFY(oHub.m_nCount > 0);
+	qDeleteAll(lLeaves);
+}
+
+void tst_QueryHashTable::testCheckString_data()
+{
+	QTest::addColumn<bool>("hit");
+
+	QTest::newRow("hit") << true;
+	QTest::newRow("miss") << false;
+}
+
+void tst_QueryHashTable::testCheckString()
+{
+	QFETCH(bool, hit);
+
+	CQueryHashTable oTable;
+	oTable.create();
+	foreach(const QString& sName, fileNames(1000, 0))
+	{
+		oTable.addExactString(sName);
+	}
+
+	const QStringList lLookups = fileNames(1000, hit ? 0 : 1000000);
+	int nHits = 0;
+
+	QBENCHMARK
+	{
+		nHits = 0;
+		foreach(const QString& sName, lLookups)
+		{
+			if(oTable.checkString(sName))
+			{
+				++nHits;
+			}
+		}
+	}
+
+	if(hit)
+	{
+		QCOMPARE(nHits, lLookups.size());
+	}
+}
+
+QTEST_GUILESS_MAIN(tst_QueryHashTable)
+
+#include "tst_queryhashtable.moc"
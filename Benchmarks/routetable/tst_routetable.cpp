@@ -0,0 +1,153 @@
+/*
+** tst_routetable.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "routetable.h"
+
+#include <QtTest/QtTest>
+
+static QList<QUuid> guids(int nCount)
+{
+	QList<QUuid> lGUIDs;
+	for(int i = 0; i < nCount; ++i)
+	{
+		lGUIDs << QUuid::createUuid();
+	}
+	return lGUIDs;
+}
+
+class tst_RouteTable : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testAdd_data();
+	void testAdd();
+	void testFind_data();
+	void testFind();
+	void testExpire_data();
+	void testExpire();
+};
+
+void tst_RouteTable::testAdd_data()
+{
+	QTest::addColumn<int>("routes");
+
+	QTest::newRow("1000") << 1000;
+	QTest::newRow("10000") << 10000;
+	QTest::newRow("max") << int(MaxRoutes);
+}
+
+void tst_RouteTable::testAdd()
+{
+	QFETCH(int, routes);
+
+	QList<QUuid> lGUIDs = guids(routes);
+	CEndPoint oAddress(0x0A000001u, 6346);
+
+	QBENCHMARK
+	{
+		CRouteTable oTable;
+		for(int i = 0; i < routes; ++i)
+		{
+			oTable.add(lGUIDs[i], oAddress);
+		}
+	}
+}
+
+void tst_RouteTable::testFind_data()
+{
+	QTest::addColumn<int>("routes");
+	QTest::addColumn<bool>("hit");
+
+	QTest::newRow("1000, hit") << 1000 << true;
+	QTest::newRow("1000, miss") << 1000 << false;
+	QTest::newRow("max, hit") << int(MaxRoutes) << true;
+	QTest::newRow("max, miss") << int(MaxRoutes) << false;
+}
+
+void tst_RouteTable::testFind()
+{
+	QFETCH(int, routes);
+	QFETCH(bool, hit);
+
+	QList<QUuid> lGUIDs = guids(routes);
+	CEndPoint oAddress(0x0A000001u, 6346);
+
+	CRouteTable oTable;
+	for(int i = 0; i < routes; ++i)
+	{
+		oTable.add(lGUIDs[i], oAddress);
+	}
+
+	QList<QUuid> lLookups = hit ? lGUIDs.mid(0, 1000) : guids(1000);
+	int nFound = 0;
+
+	QBENCHMARK
+	{
+		nFound = 0;
+		for(int i = 0; i < lLookups.size(); ++i)
+		{
+			CG2Node* pNode = 0;
+			CEndPoint oEndpoint;
+			if(oTable.find(lLookups[i], &pNode, &oEndpoint))
+			{
+				++nFound;
+			}
+		}
+	}
+
+	QCOMPARE(nFound, hit ? lLookups.size() : 0);
+}
+
+void tst_RouteTable::testExpire_data()
+{
+	QTest::addColumn<int>("routes");
+
+	QTest::newRow("1000") << 1000;
+	QTest::newRow("max") << int(MaxRoutes);
+}
+
+void tst_RouteTable::testExpire()
+{
+	QFETCH(int, routes);
+
+	QList<QUuid> lGUIDs = guids(routes);
+	CEndPoint oAddress(0x0A000001u, 6346);
+	CRouteTable oTable;
+
+	// Forced expiry runs when the table is full and trims it to three quarters, so top it up
+	// again each round. Below that it only scans for expired routes.
+	QBENCHMARK
+	{
+		for(int i = 0; i < routes; ++i)
+		{
+			oTable.add(lGUIDs[i], oAddress);
+		}
+		oTable.expireOldRoutes(true);
+	}
+}
+
+QTEST_GUILESS_MAIN(tst_RouteTable)
+
+#include "tst_routetable.moc"
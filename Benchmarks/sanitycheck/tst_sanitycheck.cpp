@@ -0,0 +1,160 @@
+/*
+** tst_sanitycheck.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "securitysanitycheck.h"
+#include "iprangerule.h"
+
+#include <QtTest/QtTest>
+
+class tst_SanityCheck : public QObject
+{
+	Q_OBJECT
+
+private:
+	QList<CEndPoint>         m_lAddresses;
+	QList<QueryHitSharedPtr> m_lHits;
+
+	static QList<CSecureRule*> ranges(int nRanges);
+
+private slots:
+	void initTestCase();
+
+	void testNeighbours_data();
+	void testNeighbours();
+	void testHits_data();
+	void testHits();
+	void testPerRule();
+};
+
+// nRanges disjoint /24 deny ranges from 1.0.0.0 on, a gap of the same size after each; about
+// the shape of a block list subscription being added in one go.
+QList<CSecureRule*> tst_SanityCheck::ranges(int nRanges)
+{
+	QList<CSecureRule*> lRules;
+	lRules.reserve(nRanges);
+
+	for(int i = 0; i < nRanges; ++i)
+	{
+		const quint32 nFirst = 0x01000000u + quint32(i) * 512;
+
+		CIPRangeRule* pRule = new CIPRangeRule();
+		pRule->parseContent(QHostAddress(nFirst).toString() + '-' + QHostAddress(nFirst + 255).toString());
+		pRule->m_nAction = RuleAction::Deny;
+		lRules.append(pRule);
+	}
+
+	return lRules;
+}
+
+// 5000 neighbour addresses and as many search results, one in ten of them inside a range.
+void tst_SanityCheck::initTestCase()
+{
+	for(int i = 0; i < 5000; ++i)
+	{
+		const quint32 nRange = 0x01000000u + quint32(i % 10000) * 512;
+		m_lAddresses << CEndPoint(nRange + (i % 10 ? 256 : 0) + i % 256, 6346);
+
+		QueryHitSharedPtr pHit(new CQueryHit());
+		pHit->m_pHitInfo = QSharedPointer<QueryHitInfo>(new QueryHitInfo());
+		pHit->m_pHitInfo->m_oNodeAddress = m_lAddresses.last();
+		pHit->m_sDescriptiveName = QString("file %1.mp3").arg(i);
+		m_lHits << pHit;
+	}
+}
+
+void tst_SanityCheck::testNeighbours_data()
+{
+	QTest::addColumn<int>("ranges");
+
+	QTest::newRow("10000") << 10000;
+	QTest::newRow("100000") << 100000;
+}
+
+// Includes indexing the new rules, which every sanity check pays once.
+void tst_SanityCheck::testNeighbours()
+{
+	QFETCH(int, ranges);
+
+	QList<int> lDenied;
+
+	QBENCHMARK
+	{
+		CSecuritySanityCheck oRules(tst_SanityCheck::ranges(ranges), QList<CSecureRule*>());
+		lDenied = oRules.denied(m_lAddresses);
+	}
+
+	QCOMPARE(lDenied.size(), m_lAddresses.size() / 10);
+}
+
+void tst_SanityCheck::testHits_data()
+{
+	testNeighbours_data();
+}
+
+void tst_SanityCheck::testHits()
+{
+	QFETCH(int, ranges);
+
+	CSecuritySanityCheck oRules(tst_SanityCheck::ranges(ranges), QList<CSecureRule*>());
+	QList<int> lDenied;
+
+	QBENCHMARK
+	{
+		lDenied = oRules.denied(m_lHits, QList<QString>());
+	}
+
+	QCOMPARE(lDenied.size(), m_lHits.size() / 10);
+}
+
+// Every rule against every address, as the subsystems would check their snapshots without an
+// index. Only run at 10000 ranges; 100000 takes minutes.
+void tst_SanityCheck::testPerRule()
+{
+	const QList<CSecureRule*> lRules = ranges(10000);
+	int nDenied = 0;
+
+	QBENCHMARK
+	{
+		nDenied = 0;
+		foreach(const CEndPoint& oAddress, m_lAddresses)
+		{
+			foreach(const CSecureRule* pRule, lRules)
+			{
+				if(((const CIPRangeRule*)pRule)->contains(oAddress))
+				{
+					++nDenied;
+					break;
+				}
+			}
+		}
+	}
+
+	qDeleteAll(lRules);
+
+	QCOMPARE(nDenied, m_lAddresses.size() / 10);
+}
+
+QTEST_GUILESS_MAIN(tst_SanityCheck)
+
+#include "tst_sanitycheck.moc"
@@ -0,0 +1,175 @@
+/*
+** tst_searchresults.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "searchresults.h"
+#include "managedsearch.h"
+#include "query.h"
+#include "securitymanager.h"
+#include "Hashes/hash.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+
+static const int Hits         = 50000;
+static const int HitsPerChain = 50;	// a QH2 packet carries a handful of hits, hubs forward several
+
+class tst_SearchResults : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir m_oHome;
+
+	QList<QueryHitSharedPtr> makeHits(int nFiles, int nDuplicates);
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void testAddHits_data();
+	void testAddHits();
+};
+
+// Hits for nFiles distinct files from distinct sources, in chains the way a search emits them.
+// Every nDuplicates-th hit repeats the previous file and source and must be dropped.
+QList<QueryHitSharedPtr> tst_SearchResults::makeHits(int nFiles, int nDuplicates)
+{
+	QList<QueryHitSharedPtr> lChains;
+	CQueryHit* pLast = 0;
+
+	for(int i = 0; i < Hits; ++i)
+	{
+		const bool bDuplicate = (nDuplicates && i % nDuplicates == nDuplicates - 1);
+		const int nFile = bDuplicate ? (i - 1) % nFiles : i % nFiles;
+		const int nSource = bDuplicate ? i - 1 : i;
+
+		QByteArray baRaw(20, 0);
+		memcpy(baRaw.data(), &nFile, sizeof(nFile));
+
+		CQueryHit* pHit = new CQueryHit();
+		pHit->m_pHitInfo = QSharedPointer<QueryHitInfo>(new QueryHitInfo());
+		pHit->m_pHitInfo->m_oNodeAddress = CEndPoint(0x0a000000u + quint32(nSource), 6346);
+		pHit->m_pHitInfo->m_sVendor = "QAZA";
+		pHit->m_lHashes.append(CHash(baRaw, CHash::SHA1));
+		pHit->m_sDescriptiveName = QString("benchmark file %1.mp3").arg(nFile);
+		pHit->m_nObjectSize = 4000000 + nFile;
+
+		if(i % HitsPerChain == 0)
+		{
+			lChains.append(QueryHitSharedPtr(pHit));
+		}
+		else
+		{
+			pLast->m_pNext = pHit;
+		}
+		pLast = pHit;
+	}
+
+	return lChains;
+}
+
+void tst_SearchResults::initTestCase()
+{
+	QVERIFY(m_oHome.isValid());
+	qputenv("HOME", QFile::encodeName(m_oHome.path()));
+
+	quazaaSettings.Gnutella.MaxResults = Hits;
+	quazaaSettings.Security.IgnorePrivateIP = false;
+	securityManager.settingsChanged();
+}
+
+void tst_SearchResults::cleanupTestCase()
+{
+	CSearchResults::stopThread();
+}
+
+void tst_SearchResults::testAddHits_data()
+{
+	QTest::addColumn<int>("files");
+	QTest::addColumn<int>("duplicates");
+
+	QTest::newRow("500 files") << 500 << 0;
+	QTest::newRow("500 files, 10% duplicates") << 500 << 10;
+	QTest::newRow("50000 files") << Hits << 0;
+}
+
+// 50k synthetic hits pushed through the result stage as fast as a search can emit them,
+// until the last batch has reached the GUI thread. Reports hits per second; the time also
+// covers the last frame interval, so the rate is a lower bound.
+void tst_SearchResults::testAddHits()
+{
+	QFETCH(int, files);
+	QFETCH(int, duplicates);
+
+	const QList<QueryHitSharedPtr> lChains = makeHits(files, duplicates);
+	const int nExpected = duplicates ? Hits - Hits / duplicates : Hits;
+
+	CQuery* pQuery = new CQuery();
+	pQuery->setDescriptiveName("benchmark file");
+	CManagedSearch oSearch(pQuery);
+
+	CSearchResults* pResults = new CSearchResults(&oSearch);
+
+	int nReceived = 0, nBatches = 0, nNewFiles = 0;
+	connect(pResults, &CSearchResults::resultsReady, this,
+			[&](SearchResultBatch lResults)
+	{
+		nReceived += lResults.size();
+		++nBatches;
+		foreach(const SearchResultEntry& oEntry, lResults)
+		{
+			if(oEntry.bNewFile)
+			{
+				++nNewFiles;
+			}
+		}
+	});
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	foreach(const QueryHitSharedPtr& pChain, lChains)
+	{
+		emit oSearch.onHit(pChain);
+	}
+
+	while(nReceived < nExpected && oTimer.elapsed() < 60000)
+	{
+		QTest::qWait(10);
+	}
+
+	const qint64 nElapsed = qMax<qint64>(1, oTimer.elapsed());
+
+	QCOMPARE(nReceived, nExpected);
+	QCOMPARE(nNewFiles, files);
+
+	qDebug("%d hits, %d accepted in %d batches, %lld ms", Hits, nReceived, nBatches, nElapsed);
+	QTest::setBenchmarkResult(Hits * 1000.0 / nElapsed, QTest::Events);
+
+	pResults->deleteLater();
+}
+
+QTEST_GUILESS_MAIN(tst_SearchResults)
+
+#include "tst_searchresults.moc"
@@ -0,0 +1,269 @@
+/*
+** tst_security.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "securitymanager.h"
+#include "securityrulestore.h"
+#include "quazaaglobals.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+
+class tst_Security : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir m_oHome;
+
+	bool loadRanges(int nRanges);
+	QList<CSecureRule*> rules();
+	bool saveLegacy(const QString& sPath);
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void testIsDenied_data();
+	void testIsDenied();
+
+	void testSave_data();
+	void testSave();
+	void testLoad_data();
+	void testLoad();
+};
+
+// Loads nRanges disjoint /24 deny ranges in 1.0.0.0/8 through the P2P importer, the
+// same path a block list subscription takes. The importer defers sorting and the sanity
+// check until the whole file is in.
+bool tst_Security::loadRanges(int nRanges)
+{
+	QTemporaryFile oFile;
+	if(!oFile.open())
+	{
+		return false;
+	}
+
+	QTextStream oStream(&oFile);
+	for(int i = 0; i < nRanges; ++i)
+	{
+		const quint32 nFirst = 0x01000000u + quint32(i) * 512;
+		oStream << "range " << i << ':'
+				<< QHostAddress(nFirst).toString() << '-'
+				<< QHostAddress(nFirst + 255).toString() << '\n';
+	}
+	oStream.flush();
+	oFile.close();
+
+	securityManager.clear();
+	return securityManager.fromP2P(oFile.fileName());
+}
+
+QList<CSecureRule*> tst_Security::rules()
+{
+	QList<CSecureRule*> lRules;
+
+	QMetaObject::Connection oConnection =
+			connect(&securityManager, &CSecurity::ruleInfo,
+					[&lRules](CSecureRule* pRule) { lRules.append(pRule); });
+	securityManager.requestRuleList();
+	disconnect(oConnection);
+
+	return lRules;
+}
+
+// Writes the rule list format used before the rule store; still read for migration.
+bool tst_Security::saveLegacy(const QString& sPath)
+{
+	QFile oFile(sPath);
+	if(!oFile.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+
+	const QList<CSecureRule*> lRules = rules();
+
+	QDataStream oStream(&oFile);
+	oStream << (quint16)SECURITY_CODE_VERSION;
+	oStream << securityManager.denyPolicy();
+	oStream << (quint32)lRules.size();
+
+	foreach(const CSecureRule* pRule, lRules)
+	{
+		CSecureRule::save(pRule, oStream);
+	}
+
+	return oStream.status() == QDataStream::Ok;
+}
+
+void tst_Security::initTestCase()
+{
+	// The security manager saves its rules below the home directory; keep that out of the
+	// user's profile.
+	QVERIFY(m_oHome.isValid());
+	qputenv("HOME", QFile::encodeName(m_oHome.path()));
+
+	quazaaSettings.Security.IgnorePrivateIP = false;
+	securityManager.settingsChanged();
+}
+
+void tst_Security::cleanupTestCase()
+{
+	securityManager.clear();
+}
+
+void tst_Security::testIsDenied_data()
+{
+	QTest::addColumn<int>("ranges");
+	QTest::addColumn<bool>("denied");
+
+	QTest::newRow("100, denied") << 100 << true;
+	QTest::newRow("100, allowed") << 100 << false;
+	QTest::newRow("10000, denied") << 10000 << true;
+	QTest::newRow("10000, allowed") << 10000 << false;
+}
+
+void tst_Security::testIsDenied()
+{
+	QFETCH(int, ranges);
+	QFETCH(bool, denied);
+
+	QVERIFY(loadRanges(ranges));
+
+	// Addresses inside the ranges, or in the gaps between them.
+	QList<CEndPoint> lAddresses;
+	for(int i = 0; i < 1000; ++i)
+	{
+		const quint32 nRange = 0x01000000u + quint32(i % ranges) * 512;
+		lAddresses << CEndPoint(nRange + (denied ? 0 : 256) + i % 256, 6346);
+	}
+
+	int nDenied = 0;
+
+	QBENCHMARK
+	{
+		nDenied = 0;
+		foreach(const CEndPoint& oAddress, lAddresses)
+		{
+			if(securityManager.isDenied(oAddress))
+			{
+				++nDenied;
+			}
+		}
+	}
+
+	QCOMPARE(nDenied, denied ? lAddresses.size() : 0);
+}
+
+void tst_Security::testSave_data()
+{
+	QTest::addColumn<int>("ranges");
+	QTest::addColumn<bool>("store");
+
+	QTest::newRow("10000, security.dat") << 10000 << false;
+	QTest::newRow("10000, security.bin") << 10000 << true;
+	QTest::newRow("100000, security.dat") << 100000 << false;
+	QTest::newRow("100000, security.bin") << 100000 << true;
+}
+
+// Full writes of either format. The rule store is not normally rewritten on save; changes
+// are patched into it or appended.
+void tst_Security::testSave()
+{
+	QFETCH(int, ranges);
+	QFETCH(bool, store);
+
+	QVERIFY(loadRanges(ranges));
+
+	const QString sPath = m_oHome.path() + "/save.bin";
+	const QList<CSecureRule*> lRules = rules();
+	QCOMPARE(lRules.size(), ranges);
+
+	CSecurityRuleStore oStore;
+
+	QBENCHMARK
+	{
+		if(store)
+		{
+			QVERIFY(oStore.compile(sPath, lRules, false));
+		}
+		else
+		{
+			QVERIFY(saveLegacy(sPath));
+		}
+	}
+
+	oStore.close();
+	QFile::remove(sPath);
+}
+
+void tst_Security::testLoad_data()
+{
+	testSave_data();
+}
+
+void tst_Security::testLoad()
+{
+	QFETCH(int, ranges);
+	QFETCH(bool, store);
+
+	const QString sLegacyPath = CQuazaaGlobals::DATA_PATH() + "security.dat";
+	const QString sStorePath = CQuazaaGlobals::DATA_PATH() + "security.bin";
+
+	QFile::remove(sLegacyPath);
+	QFile::remove(sStorePath);
+	QDir().mkpath(CQuazaaGlobals::DATA_PATH());
+
+	QVERIFY(loadRanges(ranges));
+
+	// load() prefers the rule store and falls back to the old file. The import may have
+	// saved a rule store already.
+	if(store)
+	{
+		QVERIFY(securityManager.save(true));
+	}
+	else
+	{
+		QFile::remove(sStorePath);
+		QVERIFY(saveLegacy(sLegacyPath));
+	}
+	securityManager.clear();
+
+	QBENCHMARK
+	{
+		QVERIFY(securityManager.load());
+	}
+
+	QCOMPARE(securityManager.getCount(), quint32(ranges));
+
+	// A rule in the middle of the list still denies its range.
+	QVERIFY(securityManager.isDenied(CEndPoint(0x01000000u + quint32(ranges / 2) * 512 + 7, 6346)));
+
+	securityManager.clear();
+	QFile::remove(sLegacyPath);
+	QFile::remove(sStorePath);
+}
+
+QTEST_GUILESS_MAIN(tst_Security)
+
+#include "tst_security.moc"
@@ -0,0 +1,196 @@
+/*
+** tst_storage.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "downloadstorage.h"
+#include "thread.h"
+
+#include <QtTest/QtTest>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+static const int     DownloadCount   = 50;
+static const quint64 DownloadSize    = 4 * 1024 * 1024;
+static const int     SourcesPerFile  = 4;	// each streams its own part of the file
+
+class tst_Storage : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir m_oHome;
+	QByteArray    m_baPacket;
+
+	// One received packet: download, offset and length.
+	struct Packet
+	{
+		int     nDownload;
+		quint64 nOffset;
+		quint32 nLength;
+	};
+	QVector<Packet> m_vPackets;
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void testWrite_data();
+	void testWrite();
+};
+
+void tst_Storage::initTestCase()
+{
+	QVERIFY(m_oHome.isValid());
+
+	m_baPacket.resize(16384);
+	for(int i = 0; i < m_baPacket.size(); ++i)
+	{
+		m_baPacket[i] = char(i * 7);
+	}
+
+	// Packets as they come off the sockets of 50 downloads with 4 sources each: every source
+	// sends its part in order, in packets of one to eleven segments, and all of them take turns.
+	const quint64 nPart = DownloadSize / SourcesPerFile;
+	QVector<quint64> vNext(DownloadCount * SourcesPerFile);
+	for(int i = 0; i < vNext.size(); ++i)
+	{
+		vNext[i] = (i % SourcesPerFile) * nPart;
+	}
+
+	qsrand(7);
+	for(bool bMore = true; bMore; )
+	{
+		bMore = false;
+		for(int i = 0; i < vNext.size(); ++i)
+		{
+			const quint64 nEnd = (i % SourcesPerFile + 1) * nPart;
+			if(vNext[i] >= nEnd)
+			{
+				continue;
+			}
+
+			Packet oPacket;
+			oPacket.nDownload = i / SourcesPerFile;
+			oPacket.nOffset = vNext[i];
+			oPacket.nLength = quint32(qMin<quint64>(1460 * (1 + qrand() % 11), nEnd - vNext[i]));
+			m_vPackets.append(oPacket);
+
+			vNext[i] += oPacket.nLength;
+			bMore = true;
+		}
+	}
+
+	CDownloadStorage::startThread();
+}
+
+void tst_Storage::cleanupTestCase()
+{
+	CDownloadStorage::stopThread();
+}
+
+void tst_Storage::testWrite_data()
+{
+	QTest::addColumn<bool>("cached");
+
+	QTest::newRow("write per packet") << false;
+	QTest::newRow("write-back cache") << true;
+}
+
+// Sustained writes for 50 concurrent downloads, until everything is synced to disk. Reports
+// bytes per second. Writing each packet where it belongs is what the storage replaced.
+void tst_Storage::testWrite()
+{
+	QFETCH(bool, cached);
+
+	const QString sDir = m_oHome.path() + (cached ? "/cached" : "/direct");
+	QVERIFY(QDir().mkpath(sDir));
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	if(cached)
+	{
+		QList<CDownloadStorage*> lStorage;
+		for(int i = 0; i < DownloadCount; ++i)
+		{
+			lStorage.append(new CDownloadStorage(sDir + QString("/%1.partial").arg(i), DownloadSize));
+			lStorage.last()->moveToThread(&DownloadIOThread);
+		}
+
+		foreach(const Packet& oPacket, m_vPackets)
+		{
+			lStorage[oPacket.nDownload]->write(oPacket.nOffset, m_baPacket.constData(), oPacket.nLength);
+		}
+
+		quint64 nDurable = 0;
+		foreach(CDownloadStorage* pStorage, lStorage)
+		{
+			QMetaObject::invokeMethod(pStorage, "flush", Qt::BlockingQueuedConnection, Q_ARG(bool, true));
+
+			QVERIFY(!pStorage->hasError());
+			foreach(const Fragments::Fragment& oFragment, pStorage->takeDurable())
+			{
+				nDurable += oFragment.size();
+			}
+			pStorage->deleteLater();
+		}
+
+		QCOMPARE(nDurable, DownloadCount * DownloadSize);
+	}
+	else
+	{
+		QList<QFile*> lFiles;
+		for(int i = 0; i < DownloadCount; ++i)
+		{
+			lFiles.append(new QFile(sDir + QString("/%1.partial").arg(i)));
+			QVERIFY(lFiles.last()->open(QIODevice::ReadWrite | QIODevice::Unbuffered));
+		}
+
+		foreach(const Packet& oPacket, m_vPackets)
+		{
+			QFile* pFile = lFiles[oPacket.nDownload];
+			QVERIFY(pFile->seek(oPacket.nOffset));
+			QCOMPARE(pFile->write(m_baPacket.constData(), oPacket.nLength), qint64(oPacket.nLength));
+		}
+
+		foreach(QFile* pFile, lFiles)
+		{
+#ifdef Q_OS_UNIX
+			QCOMPARE(::fsync(pFile->handle()), 0);
+#endif
+			pFile->close();
+		}
+		qDeleteAll(lFiles);
+	}
+
+	const qint64 nElapsed = qMax<qint64>(1, oTimer.elapsed());
+
+	qDebug("%d packets to %d files in %lld ms", m_vPackets.size(), DownloadCount, nElapsed);
+	QTest::setBenchmarkResult(DownloadCount * DownloadSize * 1000.0 / nElapsed, QTest::BytesPerSecond);
+}
+
+QTEST_GUILESS_MAIN(tst_Storage)
+
+#include "tst_storage.moc"
@@ -0,0 +1,210 @@
+/*
+** tst_swarm.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "download.h"
+#include "downloads.h"
+#include "downloadsource.h"
+#include "downloadtransferhttp.h"
+#include "transfers.h"
+#include "queryhit.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+
+static const quint64 FileSize    = 256 * 1024 * 1024;
+static const quint64 RequestSize = 256 * 1024;
+static const quint32 Pipeline    = 2;	// requests in flight per transfer
+
+// Gives the benchmark a look at the availability map.
+class CSwarmDownload : public CDownload
+{
+public:
+	CSwarmDownload(CQueryHit* pHit) : CDownload(pHit) {}
+
+	int availabilitySteps() const
+	{
+		return m_lAvailability.size();
+	}
+};
+
+class tst_Swarm : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+
+	void testSwarm_data();
+	void testSwarm();
+};
+
+void tst_Swarm::initTestCase()
+{
+	quazaaSettings.Downloads.IncompletePath = QDir::tempPath();
+	quazaaSettings.Downloads.VerifyTiger    = false;
+}
+
+void tst_Swarm::testSwarm_data()
+{
+	QTest::addColumn<int>("sources");
+	QTest::addColumn<int>("transfers");
+
+	QTest::newRow("10 sources") << 10 << 10;
+	QTest::newRow("100 sources, 20 transfers") << 100 << 20;
+	QTest::newRow("1000 sources, 50 transfers") << 1000 << 50;
+}
+
+// A whole download scheduled against a simulated swarm, without sockets or disk. A fifth of the
+// sources have the file, the others random blocks, and partial sources keep announcing more as
+// the download goes on. Every transfer keeps its pipeline full and completes one request per
+// round. Reports the time for the whole download; selections, end-game overlap and the size of
+// the availability map go to the log.
+void tst_Swarm::testSwarm()
+{
+	QFETCH(int, sources);
+	QFETCH(int, transfers);
+
+	QMutexLocker l(&Downloads.m_pSection);
+	QMutexLocker t(&Transfers.m_pSection);
+
+	CQueryHit oHit;
+	oHit.m_pHitInfo = QSharedPointer<QueryHitInfo>(new QueryHitInfo());
+	oHit.m_sDescriptiveName = "swarm.bin";
+	oHit.m_nObjectSize = FileSize;
+
+	// starts out with the source from the hit, which has no address; the swarm replaces it
+	CSwarmDownload* pDownload = new CSwarmDownload(&oHit);
+	while(!pDownload->m_lSources.isEmpty())
+	{
+		delete pDownload->m_lSources.first();
+	}
+
+	const quint64 nBlockSize = CDownload::defaultBlockSize(FileSize);
+	const int nBlocks = int(FileSize / nBlockSize);
+
+	qsrand(42);
+
+	QList<CDownloadSource*> lSources;
+	for(int i = 0; i < sources; ++i)
+	{
+		CDownloadSource* pSource = new CDownloadSource(pDownload);
+		pSource->m_oAddress = CEndPoint(0x0a000000u + quint32(i), 6346);
+
+		if(i % 5)
+		{
+			Fragments::List oAvailable(FileSize);
+			for(int nBlock = 0; nBlock < nBlocks; ++nBlock)
+			{
+				if(qrand() % 100 < 30)
+				{
+					oAvailable.insert(Fragments::Fragment(nBlock * nBlockSize, (nBlock + 1) * nBlockSize));
+				}
+			}
+			pSource->m_lAvailableFrags.swap(oAvailable);
+		}
+
+		pDownload->addSource(pSource);
+		lSources.append(pSource);
+	}
+
+	QList<CDownloadTransferHTTP*> lTransfers;
+	for(int i = 0; i < transfers; ++i)
+	{
+		lTransfers.append(new CDownloadTransferHTTP(pDownload, lSources[i * sources / transfers]));
+	}
+
+	quint64 nSelections = 0, nDuplicate = 0, nRounds = 0;
+	int nMaxSteps = 0;
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	while(pDownload->m_lReceived.missing() > 0 && nRounds < 1000000)
+	{
+		++nRounds;
+
+		foreach(CDownloadTransferHTTP* pTransfer, lTransfers)
+		{
+			while(pTransfer->m_lRequested.size() < Pipeline)
+			{
+				Fragments::Fragment oFragment(0, 0);
+				if(!pDownload->selectFragment(pTransfer, RequestSize, oFragment))
+				{
+					break;
+				}
+				pTransfer->CDownloadTransfer::requestBlock(oFragment);
+				++nSelections;
+			}
+
+			if(!pTransfer->m_lRequested.empty())
+			{
+				const Fragments::Fragment oDone = *pTransfer->m_lRequested.begin();
+
+				Fragments::List::const_iterator_pair itHave = pDownload->m_lReceived.equal_range(oDone);
+				for(; itHave.first != itHave.second; ++itHave.first)
+				{
+					nDuplicate += qMin(itHave.first->end(), oDone.end()) - qMax(itHave.first->begin(), oDone.begin());
+				}
+
+				pDownload->m_lReceived.insert(oDone);
+				pTransfer->releaseFirstRequest();
+			}
+		}
+
+		// a partial source announces a few more blocks now and then
+		if(nRounds % 10 == 0)
+		{
+			CDownloadSource* pSource = lSources[qrand() % sources];
+			if(!pSource->m_lAvailableFrags.empty())
+			{
+				Fragments::List oAvailable(pSource->m_lAvailableFrags);
+				const quint64 nBlock = qrand() % nBlocks;
+				oAvailable.insert(Fragments::Fragment(nBlock * nBlockSize, (nBlock + 1) * nBlockSize));
+				pDownload->setAvailableFragments(pSource, oAvailable);
+			}
+		}
+
+		nMaxSteps = qMax(nMaxSteps, pDownload->availabilitySteps());
+	}
+
+	const qint64 nElapsed = oTimer.elapsed();
+
+	QCOMPARE(pDownload->m_lReceived.missing(), quint64(0));
+
+	qDebug("%llu selections in %llu rounds, %llu bytes fetched twice, at most %d availability steps",
+	       nSelections, nRounds, nDuplicate, nMaxSteps);
+	QTest::setBenchmarkResult(nElapsed, QTest::WalltimeMilliseconds);
+
+	// the transfers were never added to Transfers, they only give back their requests
+	qDeleteAll(lTransfers);
+	while(!pDownload->m_lSources.isEmpty())
+	{
+		delete pDownload->m_lSources.first();
+	}
+	delete pDownload;
+}
+
+QTEST_GUILESS_MAIN(tst_Swarm)
+
+#include "tst_swarm.moc"
@@ -0,0 +1,176 @@
+/*
+** tst_timedsignalqueue.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "timedsignalqueue.h"
+
+#include <QtTest/QtTest>
+
+static const int Batch    = 1000;	// timers scheduled, changed or cancelled per iteration
+static const int Contexts = 100;	// objects owning the pending timers
+
+class tst_TimedSignalQueue : public QObject
+{
+	Q_OBJECT
+
+private:
+	CTimedSignalQueue* m_pQueue;
+	QList<QObject*>    m_lContexts;
+	QVector<TTimerID>  m_vPending;
+
+	void fill(int nPending);
+
+private slots:
+	void init();
+	void cleanup();
+
+	void testPushPop_data();
+	void testPushPop();
+	void testSetInterval_data();
+	void testSetInterval();
+	void testPopContext_data();
+	void testPopContext();
+};
+
+// Schedules nPending single shot timers between one second and a day out, spread over the
+// context objects, so every level of the wheel holds some. The queue's own timer is never
+// started; nothing fires while the benchmarks run.
+void tst_TimedSignalQueue::fill(int nPending)
+{
+	qsrand(37);
+
+	m_vPending.clear();
+	m_vPending.reserve(nPending);
+
+	for(int i = 0; i < nPending; ++i)
+	{
+		const quint64 tInterval = 1000 + quint64(qrand()) % (24 * 3600 * 1000);
+		m_vPending.append(m_pQueue->pushCall(m_lContexts[i % Contexts], [](){}, tInterval, false));
+	}
+
+	QCOMPARE(m_pQueue->count(), nPending);
+}
+
+void tst_TimedSignalQueue::init()
+{
+	m_pQueue = new CTimedSignalQueue();
+	for(int i = 0; i < Contexts; ++i)
+	{
+		m_lContexts.append(new QObject());
+	}
+}
+
+void tst_TimedSignalQueue::cleanup()
+{
+	delete m_pQueue;
+	qDeleteAll(m_lContexts);
+	m_lContexts.clear();
+	m_vPending.clear();
+}
+
+void tst_TimedSignalQueue::testPushPop_data()
+{
+	QTest::addColumn<int>("pending");
+
+	QTest::newRow("1000 pending") << 1000;
+	QTest::newRow("10000 pending") << 10000;
+	QTest::newRow("100000 pending") << 100000;
+}
+
+// A connection attempt's timeout: scheduled, then cancelled by ID once the peer answers.
+void tst_TimedSignalQueue::testPushPop()
+{
+	QFETCH(int, pending);
+	fill(pending);
+
+	QVector<TTimerID> vBatch(Batch);
+	QObject* pContext = m_lContexts.first();
+
+	QBENCHMARK
+	{
+		for(int i = 0; i < Batch; ++i)
+		{
+			vBatch[i] = m_pQueue->pushCall(pContext, [](){}, 30000 + i, false);
+		}
+		for(int i = 0; i < Batch; ++i)
+		{
+			m_pQueue->pop(vBatch[i]);
+		}
+	}
+
+	QCOMPARE(m_pQueue->count(), pending);
+}
+
+void tst_TimedSignalQueue::testSetInterval_data()
+{
+	testPushPop_data();
+}
+
+// Rescheduling timers that are already pending, as retries and keep-alives do.
+void tst_TimedSignalQueue::testSetInterval()
+{
+	QFETCH(int, pending);
+	fill(pending);
+
+	int nNext = 0;
+
+	QBENCHMARK
+	{
+		for(int i = 0; i < Batch; ++i)
+		{
+			m_pQueue->setInterval(m_vPending[nNext], 1000 + (nNext & 0xFFFF) * 100);
+			nNext = (nNext + 7919) % pending;
+		}
+	}
+
+	QCOMPARE(m_pQueue->count(), pending);
+}
+
+void tst_TimedSignalQueue::testPopContext_data()
+{
+	testPushPop_data();
+}
+
+// Dropping everything one object scheduled, as an object does on shutdown.
+void tst_TimedSignalQueue::testPopContext()
+{
+	QFETCH(int, pending);
+	fill(pending);
+
+	QObject oContext;
+
+	QBENCHMARK
+	{
+		for(int i = 0; i < 10; ++i)
+		{
+			m_pQueue->pushCall(&oContext, [](){}, 60000 + i * 1000, true);
+		}
+		QVERIFY(m_pQueue->pop(&oContext));
+	}
+
+	QCOMPARE(m_pQueue->count(), pending);
+}
+
+QTEST_GUILESS_MAIN(tst_TimedSignalQueue)
+
+#include "tst_timedsignalqueue.moc"
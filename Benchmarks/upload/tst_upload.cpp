@@ -0,0 +1,300 @@
+/*
+** tst_upload.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "uploads.h"
+#include "transfers.h"
+#include "networkconnection.h"
+#include "sharemanager.h"
+#include "Hashes/tigertree.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+#include <QCryptographicHash>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <ctime>
+#include <limits>
+
+static const qint64 SharedFileSize = 64 * 1024 * 1024;
+static const int    Passes         = 4;
+
+// Stands in for the handshake that recognised an upload request.
+class CAcceptedConnection : public CNetworkConnection
+{
+public:
+	void onConnectNode() {}
+	void onDisconnectNode() {}
+	void onRead() {}
+	void onError(QAbstractSocket::SocketError) {}
+};
+
+// Hands every incoming connection to the upload manager, as Handshakes does.
+class CUploadListener : public QTcpServer
+{
+protected:
+	void incomingConnection(qintptr nHandle)
+	{
+		CAcceptedConnection oConn;
+		oConn.acceptFrom(nHandle);
+		Uploads.onAccept(&oConn);
+	}
+};
+
+class tst_Upload : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir   m_oHome;
+	CUploadListener m_oListener;
+	QByteArray      m_baContent;
+	QByteArray      m_sSHA1URN;
+	CTigerTree      m_oTigerTree;
+
+	bool connectTo(QTcpSocket& oSocket);
+	int fetch(QTcpSocket& oSocket, const QByteArray& sPath, QByteArray& sHeaders, QByteArray* pBody = 0,
+	          const QByteArray& sExtra = QByteArray());
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void testThroughput_data();
+	void testThroughput();
+	void testRange();
+	void testTigerTree();
+};
+
+bool tst_Upload::connectTo(QTcpSocket& oSocket)
+{
+	oSocket.connectToHost(QHostAddress::LocalHost, m_oListener.serverPort());
+	return oSocket.waitForConnected(5000);
+}
+
+// Sends a GET for sPath on a keep-alive connection and reads the response. Returns the status
+// code, or -1 if the server did not answer in time. The body is only kept if pBody is given.
+int tst_Upload::fetch(QTcpSocket& oSocket, const QByteArray& sPath, QByteArray& sHeaders, QByteArray* pBody,
+                      const QByteArray& sExtra)
+{
+	oSocket.write("GET " + sPath + " HTTP/1.1\r\nHost: 127.0.0.1\r\n" + sExtra + "\r\n");
+
+	sHeaders.clear();
+	forever
+	{
+		while(!oSocket.canReadLine())
+		{
+			if(!oSocket.waitForReadyRead(10000))
+			{
+				return -1;
+			}
+		}
+
+		const QByteArray sLine = oSocket.readLine();
+		if(sLine == "\r\n")
+		{
+			break;
+		}
+		sHeaders += sLine;
+	}
+
+	QRegExp rxLength("Content-Length:\\s*(\\d+)", Qt::CaseInsensitive);
+	qint64 nLeft = (rxLength.indexIn(QString::fromLatin1(sHeaders)) >= 0) ? rxLength.cap(1).toLongLong() : 0;
+
+	char pBuffer[65536];
+	while(nLeft > 0)
+	{
+		if(!oSocket.bytesAvailable() && !oSocket.waitForReadyRead(10000))
+		{
+			return -1;
+		}
+
+		const qint64 nRead = oSocket.read(pBuffer, qMin<qint64>(sizeof(pBuffer), nLeft));
+		if(nRead < 0)
+		{
+			return -1;
+		}
+		if(pBody)
+		{
+			pBody->append(pBuffer, nRead);
+		}
+		nLeft -= nRead;
+	}
+
+	return sHeaders.mid(9, 3).toInt();
+}
+
+void tst_Upload::initTestCase()
+{
+	// The library database is created below the home directory; keep that out of the user's profile.
+	QVERIFY(m_oHome.isValid());
+	qputenv("HOME", QFile::encodeName(m_oHome.path()));
+
+	quazaaSettings.Connection.InSpeed        = std::numeric_limits<qint32>::max();
+	quazaaSettings.Connection.OutSpeed       = std::numeric_limits<qint32>::max();
+	quazaaSettings.Connection.TimeoutTraffic = 60;
+	quazaaSettings.Downloads.IncompletePath  = m_oHome.path() + "/Incomplete";
+	quazaaSettings.Uploads.MaxPerHost        = 4;
+	quazaaSettings.Uploads.MaxQueued         = 4;
+	quazaaSettings.Uploads.MaxTransfers      = 4;
+	quazaaSettings.Uploads.QueuePollMax      = 120000;
+	quazaaSettings.Uploads.QueuePollMin      = 45000;
+	quazaaSettings.Uploads.ShareTiger        = true;
+
+	// not compressible, not all zeroes on disk
+	m_baContent.resize(SharedFileSize);
+	quint32 nState = 0x12345678;
+	for(int i = 0; i < m_baContent.size(); ++i)
+	{
+		nState = nState * 1664525 + 1013904223;
+		m_baContent[i] = char(nState >> 24);
+	}
+
+	const QString sDir = m_oHome.path() + "/Shared";
+	QVERIFY(QDir().mkpath(sDir));
+	QFile oFile(sDir + "/shared.bin");
+	QVERIFY(oFile.open(QIODevice::WriteOnly));
+	QCOMPARE(oFile.write(m_baContent), SharedFileSize);
+	oFile.close();
+
+	m_oTigerTree.reset(SharedFileSize);
+	m_oTigerTree.addData(m_baContent.constData(), m_baContent.size());
+	QVERIFY(m_oTigerTree.finish());
+
+	const QByteArray baSHA1 = QCryptographicHash::hash(m_baContent, QCryptographicHash::Sha1);
+	const QByteArray baMD5  = QCryptographicHash::hash(m_baContent, QCryptographicHash::Md5);
+	m_sSHA1URN = CHash(baSHA1, CHash::SHA1).toURN().toLatin1();
+
+	// The library answers once its thread has opened the database.
+	ShareManager.start();
+	QElapsedTimer oTimer;
+	oTimer.start();
+	while(ShareManager.query("SELECT 1").isEmpty() && oTimer.elapsed() < 10000)
+	{
+		QTest::qWait(50);
+	}
+
+	const qint64 tModified = QFileInfo(oFile).lastModified().toTime_t();
+	ShareManager.query(QString("INSERT INTO dirs (id, path, parent) VALUES (1, '%1', 0)").arg(sDir));
+	ShareManager.query(QString("INSERT INTO files (file_id, dir_id, name, size, last_modified, shared) "
+	                           "VALUES (1, 1, 'shared.bin', %1, %2, 1)").arg(SharedFileSize).arg(tModified));
+	ShareManager.query(QString("INSERT INTO hashes (file_id, sha1, md5, tiger) VALUES (1, X'%1', X'%2', X'%3')")
+	                   .arg(QString(baSHA1.toHex()), QString(baMD5.toHex()),
+	                        QString(m_oTigerTree.root().rawValue().toHex())));
+	ShareManager.query(QString("INSERT INTO tigertrees (file_id, depth, tree) VALUES (1, %1, X'%2')")
+	                   .arg(m_oTigerTree.depth()).arg(QString(m_oTigerTree.toBreadthFirst().toHex())));
+	QCOMPARE(ShareManager.query("SELECT file_id FROM tigertrees").size(), 1);
+
+	Transfers.start();
+	QVERIFY(m_oListener.listen(QHostAddress::LocalHost));
+}
+
+void tst_Upload::cleanupTestCase()
+{
+	m_oListener.close();
+	Transfers.stop();
+	ShareManager.stop();
+}
+
+void tst_Upload::testThroughput_data()
+{
+	QTest::addColumn<bool>("zeroCopy");
+
+	QTest::newRow("read and write") << false;
+#ifdef Q_OS_LINUX
+	QTest::newRow("sendfile") << true;
+#endif
+}
+
+// Whole-file downloads back to back on one connection. Reports the rate; the CPU time the
+// process spent per GB sent (server and client side) goes to the log.
+void tst_Upload::testThroughput()
+{
+	QFETCH(bool, zeroCopy);
+	quazaaSettings.Uploads.ZeroCopy = zeroCopy;
+
+	QTcpSocket oSocket;
+	QVERIFY(connectTo(oSocket));
+
+	QByteArray sHeaders;
+	QElapsedTimer oTimer;
+	oTimer.start();
+	const std::clock_t tCPU = std::clock();
+
+	for(int i = 0; i < Passes; ++i)
+	{
+		QCOMPARE(fetch(oSocket, "/uri-res/N2R?" + m_sSHA1URN, sHeaders), 200);
+	}
+
+	const double nCPUSecs  = double(std::clock() - tCPU) / CLOCKS_PER_SEC;
+	const qint64 nElapsed  = qMax<qint64>(1, oTimer.elapsed());
+	const double nGB       = double(SharedFileSize) * Passes / (1024.0 * 1024 * 1024);
+
+	qDebug("%s: %.0f MB/s, %.0f ms CPU per GB", zeroCopy ? "sendfile" : "read and write",
+	       SharedFileSize * Passes / 1048.576 / nElapsed, nCPUSecs * 1000 / nGB);
+
+	QTest::setBenchmarkResult(SharedFileSize * Passes * 1000.0 / nElapsed, QTest::BytesPerSecond);
+}
+
+void tst_Upload::testRange()
+{
+	QTcpSocket oSocket;
+	QVERIFY(connectTo(oSocket));
+
+	QByteArray sHeaders, baBody;
+	QCOMPARE(fetch(oSocket, "/uri-res/N2R?" + m_sSHA1URN, sHeaders, &baBody, "Range: bytes=1000000-1999999\r\n"), 206);
+	QVERIFY(sHeaders.contains("Content-Range: bytes 1000000-1999999/"));
+	QVERIFY(baBody == m_baContent.mid(1000000, 1000000));
+
+	baBody.clear();
+	QCOMPARE(fetch(oSocket, "/uri-res/N2R?" + m_sSHA1URN, sHeaders, &baBody, "Range: bytes=-4096\r\n"), 206);
+	QVERIFY(baBody == m_baContent.right(4096));
+
+	QCOMPARE(fetch(oSocket, "/uri-res/N2R?" + m_sSHA1URN, sHeaders, 0, "Range: bytes=999999999-\r\n"), 416);
+	QCOMPARE(fetch(oSocket, "/uri-res/N2R?urn:sha1:AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA", sHeaders), 404);
+}
+
+// The tree a download would get from the X-Thex-URI header checks out against the root.
+void tst_Upload::testTigerTree()
+{
+	QTcpSocket oSocket;
+	QVERIFY(connectTo(oSocket));
+
+	QByteArray sHeaders, baBody;
+	QCOMPARE(fetch(oSocket, "/uri-res/N2R?" + m_sSHA1URN, sHeaders, 0, "Range: bytes=0-0\r\n"), 206);
+
+	QRegExp rxThex("X-Thex-URI:\\s*(\\S+)");
+	QVERIFY(rxThex.indexIn(QString::fromLatin1(sHeaders)) >= 0);
+
+	QCOMPARE(fetch(oSocket, rxThex.cap(1).toLatin1(), sHeaders, &baBody), 200);
+
+	CTigerTree oTree;
+	QVERIFY(oTree.fromDIME(SharedFileSize, m_oTigerTree.root(), baBody));
+	QCOMPARE(oTree.depth(), m_oTigerTree.depth());
+	QVERIFY(oTree.toBreadthFirst() == m_oTigerTree.toBreadthFirst());
+}
+
+QTEST_GUILESS_MAIN(tst_Upload)
+
+#include "tst_upload.moc"
@@ -0,0 +1,211 @@
+/*
+** tst_verify.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "downloadverifier.h"
+#include "Hashes/tigertree.h"
+#include "quazaasettings.h"
+
+#include <QtTest/QtTest>
+
+static const qint64  FileSize  = 32 * 1024 * 1024;
+static const quint32 ChunkSize = 16 * 1024;	// what one read from a socket hands over
+static const int     Sources   = 4;
+
+class tst_Verify : public QObject
+{
+	Q_OBJECT
+
+private:
+	QTemporaryDir m_oHome;
+	QString       m_sFileName;
+	QByteArray    m_baContent;
+	CTigerTree    m_oTigerTree;
+
+private slots:
+	void initTestCase();
+
+	void testThroughput_data();
+	void testThroughput();
+	void testCorruptSource();
+};
+
+void tst_Verify::initTestCase()
+{
+	QVERIFY(m_oHome.isValid());
+	qputenv("HOME", QFile::encodeName(m_oHome.path()));
+
+	quazaaSettings.Downloads.IncompletePath = m_oHome.path();
+	quazaaSettings.Downloads.VerifyTiger    = true;
+
+	m_baContent.resize(FileSize);
+	quint32 nState = 0x12345678;
+	for(int i = 0; i < m_baContent.size(); ++i)
+	{
+		nState = nState * 1664525 + 1013904223;
+		m_baContent[i] = char(nState >> 24);
+	}
+
+	// the read-back case finds the data where the download storage would have put it
+	m_sFileName = m_oHome.path() + "/verify.partial";
+	QFile oFile(m_sFileName);
+	QVERIFY(oFile.open(QIODevice::WriteOnly));
+	QCOMPARE(oFile.write(m_baContent), FileSize);
+	oFile.close();
+
+	m_oTigerTree.reset(FileSize);
+	m_oTigerTree.addData(m_baContent.constData(), m_baContent.size());
+	QVERIFY(m_oTigerTree.finish());
+}
+
+void tst_Verify::testThroughput_data()
+{
+	QTest::addColumn<bool>("streamed");
+
+	QTest::newRow("streamed") << true;
+	QTest::newRow("read back") << false;
+}
+
+// Checks the whole file once, either hashed on the fly from the data as it is synced, or
+// read back from the file after the fact, as for data that came in out of order.
+void tst_Verify::testThroughput()
+{
+	QFETCH(bool, streamed);
+
+	CDownloadVerifier oVerifier(m_sFileName, m_oTigerTree);
+	QSignalSpy oSpy(&oVerifier, SIGNAL(blockVerified(quint32,bool)));
+
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	if(streamed)
+	{
+		for(qint64 nOffset = 0; nOffset < FileSize; nOffset += ChunkSize)
+		{
+			oVerifier.addData(nOffset, m_baContent.mid(nOffset, ChunkSize));
+		}
+	}
+	else
+	{
+		oVerifier.addCompleted(0, FileSize);
+	}
+
+	const qint64 nElapsed = qMax<qint64>(1, oTimer.elapsed());
+
+	QCOMPARE(oSpy.count(), int(m_oTigerTree.blockCount()));
+	for(int i = 0; i < oSpy.count(); ++i)
+	{
+		QVERIFY(oSpy.at(i).at(1).toBool());
+	}
+	QCOMPARE(oVerifier.hashedBytes(), quint64(FileSize));
+	QCOMPARE(oVerifier.readBackBytes(), streamed ? quint64(0) : quint64(FileSize));
+
+	QTest::setBenchmarkResult(FileSize * 1000.0 / nElapsed, QTest::BytesPerSecond);
+}
+
+// Several sources share the file block by block, one of them corrupts every fifth block it
+// sends. Failed blocks go back to the next source until everything checks out. Reports the
+// bytes fetched again, against the whole file a full-file hash mismatch would cost.
+void tst_Verify::testCorruptSource()
+{
+	CDownloadVerifier oVerifier(m_sFileName, m_oTigerTree);
+	QSignalSpy oSpy(&oVerifier, SIGNAL(blockVerified(quint32,bool)));
+
+	const quint32 nBlocks    = m_oTigerTree.blockCount();
+	const quint64 nBlockSize = m_oTigerTree.blockSize();
+
+	QList<quint32> lPending;	// blocks still to fetch
+	QVector<int>   lSource(nBlocks);	// who is to send each block
+	for(quint32 i = 0; i < nBlocks; ++i)
+	{
+		lPending.append(i);
+		lSource[i] = i % Sources;
+	}
+
+	quint64 nTransferred = 0;
+	int nRounds = 0;
+
+	while(!lPending.isEmpty() && nRounds < 10)
+	{
+		++nRounds;
+
+		// every source sends its blocks a socket read at a time, the sources take turns
+		for(quint64 nPos = 0; nPos < nBlockSize; nPos += ChunkSize)
+		{
+			foreach(quint32 nBlock, lPending)
+			{
+				const qint64 nBegin = nBlock * nBlockSize;
+				const qint64 nEnd   = qMin<qint64>(nBegin + nBlockSize, FileSize);
+
+				if(nBegin + qint64(nPos) >= nEnd)
+				{
+					continue;
+				}
+
+				QByteArray baChunk = m_baContent.mid(nBegin + nPos, qMin<qint64>(ChunkSize, nEnd - nBegin - nPos));
+
+				if(lSource[nBlock] == Sources - 1 && nBlock % 5 == 0 && nPos == 0)
+				{
+					baChunk[0] = char(baChunk[0] ^ 0x55);
+				}
+
+				oVerifier.addData(nBegin + nPos, baChunk);
+				nTransferred += baChunk.size();
+			}
+		}
+
+		QCOMPARE(oSpy.count(), lPending.size());
+
+		lPending.clear();
+		for(int i = 0; i < oSpy.count(); ++i)
+		{
+			const quint32 nBlock = oSpy.at(i).at(0).toUInt();
+
+			if(!oSpy.at(i).at(1).toBool())
+			{
+				// the download drops the source that sent the whole block, the next one gets it
+				QCOMPARE(lSource[nBlock], Sources - 1);
+				lSource[nBlock] = (lSource[nBlock] + 1) % Sources;
+				lPending.append(nBlock);
+			}
+		}
+		oSpy.clear();
+	}
+
+	QVERIFY(lPending.isEmpty());
+	QCOMPARE(oVerifier.readBackBytes(), quint64(0));
+
+	const quint64 nAgain = nTransferred - FileSize;
+
+	qDebug("%u of %u blocks failed, %llu bytes fetched again instead of %lld (%.1f%% saved)",
+	       quint32(nAgain / nBlockSize), nBlocks, nAgain, FileSize, 100.0 - nAgain * 100.0 / FileSize);
+
+	QVERIFY(nAgain > 0 && nAgain < quint64(FileSize));
+
+	// one event per byte that did not have to be fetched again
+	QTest::setBenchmarkResult(FileSize - nAgain, QTest::Events);
+}
+
+QTEST_GUILESS_MAIN(tst_Verify)
+
+#include "tst_verify.moc"
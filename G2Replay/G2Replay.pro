@@ -0,0 +1,50 @@
+#
+# G2Replay.pro
+#
+# Copyright © Quazaaa Development Team, 2009-2013.
+# This file is part of QUAZAA (quazaa.sourceforge.net)
+#
+# Quazaa is free software; this file may be used under the terms of the GNU
+# General Public License version 3.0 or later or later as published by the Free Software
+# Foundation and appearing in the file LICENSE.GPL included in the
+# packaging of this file.
+#
+# Quazaa is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# Please review the following information to ensure the GNU General Public
+# License version 3.0 requirements will be met:
+# http://www.gnu.org/copyleft/gpl.html.
+#
+# You should have received a copy of the GNU General Public License version
+# 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+# Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+
+# Offline G2 replay benchmark: feeds a capture made with "Quazaa --capture-g2 <file>" through
+# the core's receive path. Links against QuazaaCore, not the GUI.
+
+TARGET = G2Replay
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+CONFIG(debug, debug|release) {
+		DESTDIR = ./debug
+		OBJECTS_DIR = temp/obj/debug
+}
+else {
+		DESTDIR = ./release
+		OBJECTS_DIR = temp/obj/release
+}
+
+MOC_DIR = temp/moc
+
+include(../Quazaa/core.pri)
+
+HEADERS += g2replay.h
+
+SOURCES += main.cpp \
+		g2replay.cpp
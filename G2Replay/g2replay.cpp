@@ -0,0 +1,156 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "g2replay.h"
+#include "g2capture.h"
+#include "g2metrics.h"
+#include "g2node.h"
+#include "g2packet.h"
+#include "datagrams.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <stdio.h>
+#include <string.h>
+
+#include "debug_new.h"
+
+int CG2Replay::run(const QString& sPath)
+{
+	QFile oFile(sPath);
+	if(!oFile.open(QIODevice::ReadOnly))
+	{
+		fprintf(stderr, "Could not open %s\n", qPrintable(sPath));
+		return 1;
+	}
+
+	QDataStream oStream(&oFile);
+	oStream.setByteOrder(QDataStream::BigEndian);
+
+	char szMagic[6];
+	quint16 nVersion = 0;
+	if(oStream.readRawData(szMagic, 6) != 6 || memcmp(szMagic, CG2Capture::Magic, 6) != 0)
+	{
+		fprintf(stderr, "%s is not a G2 capture\n", qPrintable(sPath));
+		return 1;
+	}
+	oStream >> nVersion;
+	if(nVersion != CG2Capture::CaptureVersion)
+	{
+		fprintf(stderr, "Unsupported G2 capture version %u\n", nVersion);
+		return 1;
+	}
+
+	Datagrams.startReplay();
+
+	QHash<quint32, CG2Node*> lStreams;
+	quint64 nRecords = 0, nDatagrams = 0, nBytes = 0;
+	quint32 nCaptureSpan = 0;
+	quint64 nAllocated = G2Packets.allocated();
+
+	QElapsedTimer tReplay;
+	tReplay.start();
+
+	while(!oStream.atEnd())
+	{
+		quint8 nType = 0;
+		quint32 nTime = 0, nStream = 0;
+		oStream >> nType >> nTime >> nStream;
+
+		CEndPoint oAddress;
+		QByteArray baData;
+
+		switch(nType)
+		{
+		case CG2Capture::crStreamOpen:
+		{
+			quint8 nNodeType = 0, nDeflated = 0;
+			oStream >> oAddress >> nNodeType >> nDeflated >> baData;
+
+			CG2Node* pNode = new CG2Node();
+			pNode->m_oAddress = oAddress;
+			pNode->startReplay(G2NodeType(nNodeType), nDeflated);
+			pNode->replayInput(baData.constData(), baData.size());
+
+			delete lStreams.value(nStream);
+			lStreams.insert(nStream, pNode);
+			break;
+		}
+		case CG2Capture::crStreamData:
+			oStream >> baData;
+			if(CG2Node* pNode = lStreams.value(nStream))
+			{
+				pNode->replayInput(baData.constData(), baData.size());
+			}
+			break;
+		case CG2Capture::crStreamClose:
+			delete lStreams.take(nStream);
+			break;
+		case CG2Capture::crDatagram:
+			oStream >> oAddress >> baData;
+			Datagrams.replayDatagram(oAddress, baData);
+			++nDatagrams;
+			break;
+		default:
+			fprintf(stderr, "Corrupt G2 capture, unknown record type %u\n", nType);
+			oStream.setStatus(QDataStream::ReadCorruptData);
+			break;
+		}
+
+		if(oStream.status() != QDataStream::Ok)
+		{
+			break;
+		}
+
+		++nRecords;
+		nBytes += baData.size();
+		nCaptureSpan = nTime;
+	}
+
+	qint64 nElapsed = qMax(qint64(1), tReplay.elapsed());
+
+	qDeleteAll(lStreams);
+	lStreams.clear();
+	Datagrams.disconnectNode();
+
+	quint64 nPackets = G2Metrics.totalPacketsIn();
+
+	printf("records:          %llu (%llu datagrams)\n", nRecords, nDatagrams);
+	printf("bytes:            %llu\n", nBytes);
+	printf("packets:          %llu\n", nPackets);
+	printf("packets/s:        %.0f\n", nPackets * 1000.0 / nElapsed);
+	printf("MB/s:             %.2f\n", nBytes / 1048.576 / nElapsed);
+	printf("packet allocs:    %llu\n", G2Packets.allocated() - nAllocated);
+	printf("capture span:     %u ms\n", nCaptureSpan);
+	printf("replay time:      %lld ms\n", nElapsed);
+	if(oStream.status() != QDataStream::Ok)
+	{
+		printf("capture truncated after %llu records\n", nRecords);
+	}
+	printf("\n%s", G2Metrics.report().constData());
+
+	return 0;
+}
@@ -1,5 +1,5 @@
 /*
-** parser.h
+** g2replay.h
 **
 ** Copyright © Quazaa Development Team, 2009-2013.
 ** This file is part of QUAZAA (quazaa.sourceforge.net)
@@ -22,17 +22,21 @@
 ** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-//#ifndef PARSER_H
-//#define PARSER_H
 
-#include "types.h"
+#ifndef G2REPLAY_H
+#define G2REPLAY_H
 
-class QString;
+#include <QString>
 
-namespace Parser
+// Offline benchmark: feeds a G2Capture file through the regular receive path - TCP streams
+// through CG2Node (inflate, G2Packet::readBuffer, routing, onPacket), datagrams through
+// CDatagrams (GND reassembly, onPacket) - as fast as possible, with stand-in sockets and
+// nothing sent. Prints throughput, G2 packet allocations and the G2Metrics report.
+// Run as "G2Replay <capture file>"; record one with Quazaa --capture-g2 <file>.
+class CG2Replay
 {
-	QString getHeaderValue(QString& headers, QString headerName);
-
+public:
+	static int run(const QString& sPath);
 };
 
-//#endif // PARSER_H
+#endif // G2REPLAY_H
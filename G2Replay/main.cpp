@@ -0,0 +1,60 @@
+/*
+** main.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "g2replay.h"
+#include "quazaaglobals.h"
+#include "quazaasettings.h"
+#include "systemlog.h"
+#include "timedsignalqueue.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <stdio.h>
+
+#include "debug_new.h"
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication theApp( argc, argv );
+
+	QStringList args = theApp.arguments();
+	if ( args.size() != 2 )
+	{
+		fprintf( stderr, "Usage: G2Replay <capture file>\n"
+				 "Replays a G2 capture recorded with Quazaa --capture-g2 <file> through the packet handlers.\n" );
+		return 1;
+	}
+
+	// Same names as Quazaa, so that the user's settings are used for the replay
+	theApp.setApplicationName(    CQuazaaGlobals::APPLICATION_NAME() );
+	theApp.setApplicationVersion( CQuazaaGlobals::APPLICATION_VERSION_STRING() );
+	theApp.setOrganizationDomain( CQuazaaGlobals::APPLICATION_ORGANIZATION_DOMAIN() );
+	theApp.setOrganizationName(   CQuazaaGlobals::APPLICATION_ORGANIZATION_NAME() );
+
+	systemLog.start();
+	signalQueue.setup();
+	quazaaSettings.loadSettings();
+
+	return CG2Replay::run( args.at( 1 ) );
+}
@@ -25,6 +25,9 @@
 TEMPLATE = subdirs
 
 SUBDIRS = VersionTool \
-		  Quazaa
+		  QuazaaCore \
+		  Quazaa \
+		  G2Replay \
+		  Benchmarks
 
 CONFIG += ordered
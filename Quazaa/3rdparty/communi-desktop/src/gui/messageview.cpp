@@ -218,6 +218,8 @@ void MessageView::setBuffer(IrcBuffer* buffer)
     if (d.buffer != buffer) {
         if (IrcChannel* channel = qobject_cast<IrcChannel*>(buffer)) {
             d.listView->setChannel(channel);
+            if (IrcUserListModel* model = d.listView->userModel())
+                d.nicks.setNames(model->names());
             IrcUserListModel* activityModel = new IrcUserListModel(channel);
             activityModel->setSortMethod(Irc::SortByActivity);
             d.chatInput->textEdit()->completer()->setUserModel(activityModel);
@@ -648,6 +650,8 @@ void MessageView::receiveMessage(IrcMessage* message)
             break;
         }
         case IrcMessage::Join:
+            if (!d.playback)
+                d.nicks.addName(message->nick());
             if (!d.playback && message->flags() & IrcMessage::Own) {
                 ++d.joined;
                 d.firstNames = true;
@@ -659,21 +663,35 @@ void MessageView::receiveMessage(IrcMessage* message)
                 return;
             break;
         case IrcMessage::Quit:
+            if (!d.playback)
+                d.nicks.removeName(message->nick());
             if (!d.playback && message->flags() & IrcMessage::Own)
                 ++d.parted;
             if (!d.showQuits)
                 return;
             break;
         case IrcMessage::Part:
+            if (!d.playback)
+                d.nicks.removeName(message->nick());
             if (!d.playback && message->flags() & IrcMessage::Own)
                 ++d.parted;
             if (!d.showParts)
                 return;
             break;
         case IrcMessage::Kick:
+            if (!d.playback)
+                d.nicks.removeName(static_cast<IrcKickMessage*>(message)->user());
             if (!d.playback && !static_cast<IrcKickMessage*>(message)->user().compare(d.connection->nickName(), Qt::CaseInsensitive))
                 ++d.parted;
             break;
+        case IrcMessage::Nick:
+            if (!d.playback)
+                d.nicks.renameName(message->nick(), static_cast<IrcNickMessage*>(message)->newNick());
+            break;
+        case IrcMessage::Names:
+            if (IrcUserListModel* model = d.listView->userModel())
+                d.nicks.setNames(model->names());
+            break;
         case IrcMessage::Pong: {
             QString arg = static_cast<IrcPongMessage*>(message)->argument();
             if (arg.startsWith("_communi_msg_")) {
@@ -713,6 +731,7 @@ void MessageView::receiveMessage(IrcMessage* message)
                 {
                     if( viewType() == ViewInfo::Channel ) {
                         d.listView->userModel()->sort();
+                        d.nicks.setNames(d.listView->userModel()->names());
                         d.whoTimer->start(300000);
                     }
 
@@ -727,8 +746,7 @@ void MessageView::receiveMessage(IrcMessage* message)
     }
 
     options.nickName = d.connection->nickName();
-    if (IrcUserListModel* model = d.listView->userModel())
-        options.users = model->names();
+    options.nicks = &d.nicks;
     options.stripNicks = d.stripNicks;
     options.timeStampFormat = d.timeStampFormat;
     options.textFormat = irc_text_format();
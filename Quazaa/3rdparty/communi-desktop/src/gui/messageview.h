@@ -17,6 +17,7 @@
 
 #include "ui_messageview.h"
 #include "viewinfo.h"
+#include "nickmatcher.h"
 #include <QPointer>
 #if QT_VERSION >= 0x040700
 #include <QElapsedTimer>
@@ -129,6 +130,7 @@ private:
 		QString timeStampFormat;
 		bool firstNames;
 		CWidgetChatInput* chatInput;
+		NickMatcher nicks;
 	} d;
 };
 
@@ -26,6 +26,7 @@
 */
 
 #include "messageformatter.h"
+#include "nickmatcher.h"
 #include <irctextformat.h>
 #include <ircconnection.h>
 #include <irc.h>
@@ -381,36 +382,67 @@ QString MessageFormatter::formatHtml(const QString& message, const Options& opti
     else
         msg = IrcTextFormat().toHtml(message);
 
-    for (int i = options.users.count() - 1; i >= 0; --i) {
-        const QString& user = options.users.at(i);
-        int pos = 0;
-        while ((pos = msg.indexOf(user, pos)) != -1) {
-            QTextBoundaryFinder finder(QTextBoundaryFinder::Word, msg);
+    if (options.nicks)
+        return formatNicks(msg, *options.nicks);
+    if (!options.users.isEmpty()) {
+        NickMatcher nicks;
+        nicks.setNames(options.users);
+        return formatNicks(msg, nicks);
+    }
+    return msg;
+}
 
-            finder.setPosition(pos);
-            if (!finder.isAtBoundary()) {
-                pos += user.length();
-                continue;
-            }
+QString MessageFormatter::formatNicks(const QString& html, const NickMatcher& nicks)
+{
+    if (nicks.isEmpty() || html.isEmpty())
+        return html;
+
+    QBitArray boundaries(html.length() + 1);
+    QTextBoundaryFinder finder(QTextBoundaryFinder::Word, html);
+    for (int pos = finder.position(); pos != -1; pos = finder.toNextBoundary())
+        boundaries.setBit(pos);
 
-            finder.setPosition(pos + user.length());
-            if (!finder.isAtBoundary()) {
-                pos += user.length();
+    // single pass over the text between tags, skipping entities and link texts
+    QString formatted;
+    bool anchor = false;
+    int copied = 0;
+    int pos = 0;
+    while (pos < html.length()) {
+        const QChar c = html.at(pos);
+        if (c == QLatin1Char('<')) {
+            const int end = html.indexOf(QLatin1Char('>'), pos);
+            if (end == -1)
+                break;
+            const QStringRef tag = html.midRef(pos + 1, end - pos - 1);
+            if (tag.startsWith(QLatin1String("a "), Qt::CaseInsensitive) || !tag.compare(QLatin1String("a"), Qt::CaseInsensitive))
+                anchor = true;
+            else if (!tag.compare(QLatin1String("/a"), Qt::CaseInsensitive))
+                anchor = false;
+            pos = end + 1;
+            continue;
+        }
+        if (c == QLatin1Char('&')) {
+            const int end = html.indexOf(QLatin1Char(';'), pos);
+            if (end != -1 && end - pos <= 8) {
+                pos = end + 1;
                 continue;
             }
-
-            const int anchor = msg.indexOf("</a>", pos + user.length() + 1);
-            if (anchor != -1 && anchor <= msg.indexOf('<', pos + user.length() + 1)) {
-                pos += user.length();
+        }
+        if (!anchor && boundaries.testBit(pos)) {
+            if (int length = nicks.longestMatch(html, pos, boundaries)) {
+                formatted += html.midRef(copied, pos - copied);
+                formatted += formatNick(html.mid(pos, length));
+                pos += length;
+                copied = pos;
                 continue;
             }
-
-            QString formatted = formatNick(msg.mid(pos, user.length()));
-            msg.replace(pos, user.length(), formatted);
-            pos += formatted.length();
         }
+        ++pos;
     }
-    return msg;
+    if (!copied)
+        return html;
+    formatted += html.midRef(copied);
+    return formatted;
 }
 
 QString MessageFormatter::formatNames(const QStringList &names, int columns)
@@ -31,6 +31,8 @@
 #include <IrcMessage>
 #include <IrcTextFormat>
 
+class NickMatcher;
+
 class MessageFormatter : public QObject
 {
     Q_OBJECT
@@ -38,12 +40,13 @@ class MessageFormatter : public QObject
 public:
     struct Options
     {
-        Options() : repeat(false), highlight(false), stripNicks(false), textFormat(0) { }
+        Options() : repeat(false), highlight(false), stripNicks(false), nicks(0), textFormat(0) { }
         bool repeat;
         bool highlight;
         bool stripNicks;
         QString nickName;
         QStringList users;
+        const NickMatcher* nicks; // takes precedence over users
         QDateTime timeStamp;
         QString timeStampFormat;
         IrcTextFormat* textFormat;
@@ -69,6 +72,8 @@ protected:
     static QString formatTopicMessage(IrcTopicMessage* message, const Options& options);
     static QString formatUnknownMessage(IrcMessage* message, const Options& options);
 
+    static QString formatNicks(const QString& html, const NickMatcher& nicks);
+
     static QString formatPingReply(const QString& nick, const QString& arg);
 
     static QString formatNick(const QString& nick, bool own = false);
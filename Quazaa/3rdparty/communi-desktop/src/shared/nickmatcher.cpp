@@ -0,0 +1,150 @@
+/*
+* Copyright (C) 2008-2013 The Communi Project
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the <organization> nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "nickmatcher.h"
+#include <QVarLengthArray>
+
+NickMatcher::NickMatcher()
+{
+    d.nodes.resize(1);
+    d.count = 0;
+}
+
+bool NickMatcher::isEmpty() const
+{
+    return !d.count;
+}
+
+int NickMatcher::count() const
+{
+    return d.count;
+}
+
+bool NickMatcher::contains(const QString& name) const
+{
+    int node = 0;
+    for (int i = 0; i < name.length(); ++i) {
+        node = d.edges.value(edgeKey(node, name.at(i)));
+        if (!node)
+            return false;
+    }
+    return node && d.nodes.at(node).names;
+}
+
+void NickMatcher::setNames(const QStringList& names)
+{
+    clear();
+    foreach (const QString& name, names)
+        addName(name);
+}
+
+void NickMatcher::addName(const QString& name)
+{
+    if (name.isEmpty())
+        return;
+
+    int node = 0;
+    for (int i = 0; i < name.length(); ++i) {
+        const quint64 key = edgeKey(node, name.at(i));
+        int next = d.edges.value(key);
+        if (!next) {
+            if (!d.unused.isEmpty()) {
+                next = d.unused.last();
+                d.unused.removeLast();
+            } else {
+                next = d.nodes.count();
+                d.nodes.append(Node());
+            }
+            d.edges.insert(key, next);
+            ++d.nodes[node].children;
+        }
+        node = next;
+    }
+    ++d.nodes[node].names;
+    ++d.count;
+}
+
+void NickMatcher::removeName(const QString& name)
+{
+    QVarLengthArray<int, 32> path;
+    path.append(0);
+    for (int i = 0; i < name.length(); ++i) {
+        const int next = d.edges.value(edgeKey(path.last(), name.at(i)));
+        if (!next)
+            return;
+        path.append(next);
+    }
+    if (path.count() == 1 || !d.nodes.at(path.last()).names)
+        return;
+
+    --d.nodes[path.last()].names;
+    --d.count;
+
+    // drop the nodes that no longer lead to any name
+    for (int i = path.count() - 1; i > 0; --i) {
+        const Node& node = d.nodes.at(path.at(i));
+        if (node.names || node.children)
+            break;
+        d.edges.remove(edgeKey(path.at(i - 1), name.at(i - 1)));
+        --d.nodes[path.at(i - 1)].children;
+        d.unused.append(path.at(i));
+    }
+}
+
+void NickMatcher::renameName(const QString& from, const QString& to)
+{
+    removeName(from);
+    addName(to);
+}
+
+void NickMatcher::clear()
+{
+    d.nodes.resize(1);
+    d.nodes[0] = Node();
+    d.unused.clear();
+    d.edges.clear();
+    d.count = 0;
+}
+
+int NickMatcher::longestMatch(const QString& text, int pos, const QBitArray& boundaries) const
+{
+    int node = 0;
+    int length = 0;
+    for (int i = pos; i < text.length(); ++i) {
+        node = d.edges.value(edgeKey(node, text.at(i)));
+        if (!node)
+            break;
+        if (d.nodes.at(node).names && boundaries.testBit(i + 1))
+            length = i + 1 - pos;
+    }
+    return length;
+}
+
+quint64 NickMatcher::edgeKey(int node, const QChar& ch)
+{
+    return (quint64(node) << 16) | ch.toCaseFolded().unicode();
+}
@@ -0,0 +1,75 @@
+/*
+* Copyright (C) 2008-2013 The Communi Project
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in the
+*       documentation and/or other materials provided with the distribution.
+*     * Neither the name of the <organization> nor the
+*       names of its contributors may be used to endorse or promote products
+*       derived from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+* DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef NICKMATCHER_H
+#define NICKMATCHER_H
+
+#include <QHash>
+#include <QVector>
+#include <QBitArray>
+#include <QStringList>
+
+// Case-insensitive trie of channel nicks. Join, part and nick changes update
+// it in place, so highlighting a line costs one walk per word instead of one
+// scan of the line per user.
+class NickMatcher
+{
+public:
+    NickMatcher();
+
+    bool isEmpty() const;
+    int count() const;
+    bool contains(const QString& name) const;
+
+    void setNames(const QStringList& names);
+    void addName(const QString& name);
+    void removeName(const QString& name);
+    void renameName(const QString& from, const QString& to);
+    void clear();
+
+    // Length of the longest name found at text[pos] that ends on one of
+    // the given boundaries, or 0 if there is none.
+    int longestMatch(const QString& text, int pos, const QBitArray& boundaries) const;
+
+private:
+    struct Node {
+        Node() : names(0), children(0) { }
+        int names;
+        int children;
+    };
+
+    static quint64 edgeKey(int node, const QChar& ch);
+
+    struct Private {
+        QVector<Node> nodes;
+        QVector<int> unused;
+        QHash<quint64, int> edges;
+        int count;
+    } d;
+};
+
+#endif // NICKMATCHER_H
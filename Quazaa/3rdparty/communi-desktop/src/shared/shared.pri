@@ -8,9 +8,11 @@ INCLUDEPATH += $$PWD
 HEADERS += $$PWD/commandparser.h
 HEADERS += $$PWD/ignoremanager.h
 HEADERS += $$PWD/messageformatter.h
+HEADERS += $$PWD/nickmatcher.h
 HEADERS += $$PWD/zncmanager.h
 
 SOURCES += $$PWD/commandparser.cpp
 SOURCES += $$PWD/ignoremanager.cpp
 SOURCES += $$PWD/messageformatter.cpp
+SOURCES += $$PWD/nickmatcher.cpp
 SOURCES += $$PWD/zncmanager.cpp
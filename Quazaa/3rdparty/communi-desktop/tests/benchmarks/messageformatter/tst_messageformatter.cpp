@@ -9,7 +9,8 @@
  */
 
 #include "messageformatter.h"
-#include "connection.h"
+#include "nickmatcher.h"
+#include <IrcConnection>
 #include <QtTest/QtTest>
 #include <QtCore/QStringList>
 
@@ -41,10 +42,14 @@ static const QStringList USERS_100 = QStringList()
                                      << "MeSsAgE" << "FoRmAtTeR" << "c00l" << "_[KiDDO]_" << "yes"
                                      << "no" << "never" << "tincidunt" << "ultricies" << "posuere";
 
-class TestMessageFormatter : public MessageFormatter
+// busy channels: the names above plus numbered variants of them
+static QStringList channelUsers(int count)
 {
-    friend class tst_MessageFormatter;
-};
+    QStringList users = USERS_100;
+    for (int i = 0; users.count() < count; ++i)
+        users += USERS_100.at(i % USERS_100.count()) + QString::number(i / USERS_100.count());
+    return users;
+}
 
 class tst_MessageFormatter : public QObject
 {
@@ -54,11 +59,11 @@ private slots:
     void testFormatHtml_data();
     void testFormatHtml();
 
+    void testNickMatcher_data();
+    void testNickMatcher();
+
     void testZncPlayback_data();
     void testZncPlayback();
-
-private:
-    TestMessageFormatter formatter;
 };
 
 Q_DECLARE_METATYPE(QStringList)
@@ -109,6 +114,11 @@ void tst_MessageFormatter::testFormatHtml_data()
     QTest::newRow("512 chars / 75 words / 75 users") << MSG_512_75 << QStringList(USERS_100.mid(0, 75));
     QTest::newRow("512 chars / 75 words / 100 users") << MSG_512_75 << USERS_100;
     QTest::newRow("512 chars / 75 words / 200 users") << MSG_512_75 << USERS_100 + USERS_UC;
+
+    QTest::newRow("64 chars / 9 words / 1k users") << MSG_64_9 << channelUsers(1000);
+    QTest::newRow("64 chars / 9 words / 10k users") << MSG_64_9 << channelUsers(10000);
+    QTest::newRow("512 chars / 75 words / 1k users") << MSG_512_75 << channelUsers(1000);
+    QTest::newRow("512 chars / 75 words / 10k users") << MSG_512_75 << channelUsers(10000);
 }
 
 void tst_MessageFormatter::testFormatHtml()
@@ -116,13 +126,33 @@ void tst_MessageFormatter::testFormatHtml()
     QFETCH(QString, message);
     QFETCH(QStringList, users);
 
-    Connection connection;
-    IrcMessage* dummy = new IrcMessage(&connection);
-    formatter.setUsers(users);
-    formatter.formatMessage(dummy);
+    MessageFormatter::Options options;
+    options.users = users;
+
+    QBENCHMARK {
+        MessageFormatter::formatHtml(message, options);
+    }
+}
+
+void tst_MessageFormatter::testNickMatcher_data()
+{
+    testFormatHtml_data();
+}
+
+void tst_MessageFormatter::testNickMatcher()
+{
+    QFETCH(QString, message);
+    QFETCH(QStringList, users);
+
+    // the view keeps its matcher up to date, only the lookup counts
+    NickMatcher nicks;
+    nicks.setNames(users);
+
+    MessageFormatter::Options options;
+    options.nicks = &nicks;
 
     QBENCHMARK {
-        formatter.formatHtml(message);
+        MessageFormatter::formatHtml(message, options);
     }
 }
 
@@ -146,14 +176,13 @@ void tst_MessageFormatter::testZncPlayback()
 {
     QFETCH(QByteArray, data);
 
-    Connection connection;
+    IrcConnection connection;
     IrcMessage* msg = IrcMessage::fromData(data, &connection);
-    formatter.setTimeStampFormat("[hh:mm:ss]");
-    formatter.setZncPlaybackMode(true);
+    MessageFormatter::Options options;
+    options.timeStampFormat = "[hh:mm:ss]";
     QBENCHMARK {
-        formatter.formatMessage(msg);
+        MessageFormatter::formatMessage(msg, options);
     }
-    formatter.setZncPlaybackMode(false);
     delete msg;
 }
 
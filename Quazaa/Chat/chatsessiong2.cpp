@@ -26,7 +26,6 @@
 
 #include "quazaaglobals.h"
 #include "quazaasettings.h"
-#include "parser.h"
 #include "g2packet.h"
 #include "network.h"
 #include <QXmlStreamReader>
@@ -103,8 +102,12 @@ void CChatSessionG2::onRead()
 {
 	if( m_nState == csHandshaking )
 	{
-		if(peek(bytesAvailable()).indexOf("\r\n\r\n") != -1)
+		CHeaderParser::State nState = m_oHeaders.parse(getInputBuffer());
+
+		if( nState == CHeaderParser::hsComplete )
 		{
+			getInputBuffer()->remove(m_oHeaders.length());
+
 			if(m_bInitiated)
 			{
 				parseOutgoingHandshake();
@@ -113,6 +116,13 @@ void CChatSessionG2::onRead()
 			{
 				//ParseIncomingHandshake();
 			}
+
+			m_oHeaders.reset();
+		}
+		else if( nState != CHeaderParser::hsIncomplete )
+		{
+			emit systemMessage("Received an invalid handshake, connection lost.");
+			CNetworkConnection::close();
 		}
 	}
 	else if( m_nState == csConnected || m_nState == csActive )
@@ -143,13 +153,11 @@ void CChatSessionG2::onRead()
 
 void CChatSessionG2::parseOutgoingHandshake()
 {
-	QString sHs = read(peek(bytesAvailable()).indexOf("\r\n\r\n") + 4);
-
-	qDebug() << "Chat received:\n" << sHs;
+	qDebug() << "Chat received:\n" << m_oHeaders.toString();
 
-	if( sHs.left(12) == "CHAT/0.2 200" )
+	if( m_oHeaders.startLine().startsWith("CHAT/0.2 200") )
 	{
-		QString sAccept = Parser::getHeaderValue(sHs, "Accept");
+		QString sAccept = m_oHeaders.value("Accept");
 		if( !sAccept.contains("application/x-gnutella2") )
 		{
 			send_ChatError("503 Required protocol not accepted");
@@ -158,7 +166,7 @@ void CChatSessionG2::parseOutgoingHandshake()
 			return;
 		}
 
-		QString sContentType = Parser::getHeaderValue(sHs, "Content-Type");
+		QString sContentType = m_oHeaders.value("Content-Type");
 		if( !sContentType.contains("application/x-gnutella2") )
 		{
 			send_ChatError("503 Required protocol not provided");
@@ -167,7 +175,7 @@ void CChatSessionG2::parseOutgoingHandshake()
 			return;
 		}
 
-		QString sUA = Parser::getHeaderValue(sHs, "User-Agent");
+		QString sUA = m_oHeaders.value("User-Agent");
 		if( sUA.indexOf("shareaza", 0, Qt::CaseInsensitive) != -1 )
 			m_bShareaza = true;
 
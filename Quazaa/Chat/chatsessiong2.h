@@ -26,6 +26,7 @@
 #define CHATSESSIONG2_H
 
 #include "chatsession.h"
+#include "headerparser.h"
 
 class G2Packet;
 
@@ -34,6 +35,7 @@ class CChatSessionG2 : public CChatSession
 	Q_OBJECT
 protected:
 	CEndPoint m_oRemoteHost;
+	CHeaderParser m_oHeaders;
 public:
 	CChatSessionG2(CEndPoint oRemoteHost, QObject *parent = 0);
 
@@ -48,6 +48,8 @@ CDiscovery::CDiscovery(QObject *parent) :
 	QObject( parent ),
 	m_bSaved( true ),
 	m_nLastID( 0 ),
+	m_bBootstrapping( false ),
+	m_nBootstrapHosts( 0 ),
 	m_pActive( new quint16[Discovery::stNumberOfServiceTypes] )
 {
 	// reg. meta types
@@ -400,6 +402,33 @@ void CDiscovery::queryService(TServiceID nID)
 							   Qt::QueuedConnection, Q_ARG( TServiceID, nID ) );
 }
 
+/**
+ * @brief bootstrap queries services for hosts to connect to until enough hosts have been
+ * obtained. Services are ranked by their expected cost - measured latency over rating - and
+ * up to Discovery.BootstrapFanOut of them are queried at the same time; each answer starts the
+ * next one. UDP KHL caches answer in a single round trip and so usually go first. Querying
+ * stops once Discovery.BootstrapHosts hosts have been obtained or no service is left;
+ * bootstrapFinished() is emitted either way. Does nothing if a bootstrap is already running.
+ * Locking: YES (asynchronous)
+ * @param type
+ */
+void CDiscovery::bootstrap(const CNetworkType& type)
+{
+	QMetaObject::invokeMethod( this, "asyncBootstrapHelper",
+							   Qt::QueuedConnection, Q_ARG( const CNetworkType, type ) );
+}
+
+/**
+ * @brief isBootstrapping
+ * Locking: YES (synchronous)
+ * @return true between a call to bootstrap() and bootstrapFinished()
+ */
+bool CDiscovery::isBootstrapping()
+{
+	QMutexLocker l( &m_pSection );
+	return m_bBootstrapping;
+}
+
 /**
  * @brief getWorkingService
  * Locking: YES (synchronous)
@@ -652,7 +681,7 @@ void CDiscovery::asyncUpdateServiceHelper(const CNetworkType type)
 	if ( pNAM->networkAccessible() == QNetworkAccessManager::Accessible )
 	{
 		m_pSection.lock();
-		TServicePtr pService = getRandomService( type );
+		TServicePtr pService = getRandomService( type, stGWC ); // only GWCs take updates
 		m_pSection.unlock();
 
 		if ( pService )
@@ -810,6 +839,69 @@ void CDiscovery::asyncQueryServiceHelper(TServiceID nID)
 #endif
 }
 
+void CDiscovery::asyncBootstrapHelper(const CNetworkType type)
+{
+	if ( isBootstrapping() )
+		return;
+
+	// Only refuse if the network is known to be down: an unknown state is common on systems
+	// without a network configuration backend, and failing services are ranked down anyway.
+	QSharedPointer<QNetworkAccessManager> pNAM = requestNAM();
+
+	if ( pNAM->networkAccessible() == QNetworkAccessManager::NotAccessible )
+	{
+		postLog( LogSeverity::Error,
+				 tr( "Could not bootstrap: the network connection is currently unavailable." ) );
+
+		emit bootstrapFinished( 0 );
+		return;
+	}
+
+	// Bootstraps are only started from within the Discovery thread, so none can have started
+	// since the check above.
+	m_pSection.lock();
+
+	m_lBootstrapQueue = getBootstrapServices( type );
+	m_lBootstrapRunning.clear();
+	m_nBootstrapHosts = 0;
+	m_bBootstrapping  = true;
+	m_oBootstrapTimer.start();
+
+	const quint32 nServices = (quint32)m_lBootstrapQueue.size();
+
+	m_pSection.unlock();
+
+	postLog( LogSeverity::Notice, tr( "Bootstrapping %1 from up to %2 services."
+									  ).arg( type.toString(), QString::number( nServices ) ) );
+
+	bootstrapNext();
+}
+
+void CDiscovery::bootstrapQueried(TServiceID nID, quint16 nHosts)
+{
+	m_pSection.lock();
+
+	if ( !m_bBootstrapping || !m_lBootstrapRunning.erase( nID ) )
+	{
+		// not part of the bootstrap, or answering after it has finished
+		m_pSection.unlock();
+		return;
+	}
+
+	m_nBootstrapHosts += nHosts;
+
+	if ( m_nBootstrapHosts >= quazaaSettings.Discovery.BootstrapHosts )
+	{
+		// Enough hosts; services still running are left to complete, but not waited for.
+		m_lBootstrapQueue.clear();
+		m_lBootstrapRunning.clear();
+	}
+
+	m_pSection.unlock();
+
+	bootstrapNext();
+}
+
 /**
  * @brief doCount: Internal helper without locking. See count for documentation.
  */
@@ -999,7 +1091,7 @@ bool CDiscovery::load( QString sPath )
 			 QString( "Number of services stored in file: " ) + QString::number( nCount ), true );
 #endif
 
-		if ( nVersion == DISCOVERY_CODE_VERSION ) // else do load defaults
+		if ( nVersion >= 1 && nVersion <= DISCOVERY_CODE_VERSION ) // else do load defaults
 		{
 			QMutexLocker l( &m_pSection );
 			while ( nCount > 0 )
@@ -1098,6 +1190,10 @@ bool CDiscovery::add(TServicePtr& pService)
 	// push to map
 	m_mServices[pService->m_nID] = pService;
 
+	// queued: services report while holding their own lock
+	connect( pService.data(), &CDiscoveryService::queried,
+			 this, &CDiscovery::bootstrapQueried, Qt::QueuedConnection );
+
 #if ENABLE_DISCOVERY_DEBUGGING
 	postLog( LogSeverity::Debug,
 			 QString( "[Discovery] Service added to manager: [%1] " ).arg( pService->type() ) +
@@ -1169,8 +1265,18 @@ void CDiscovery::addDefaults()
 
 //			case 'D':	// eDonkey service
 //				break;
-//			case 'U':	// Bootstrap and UDP Discovery Service
-//				break;
+
+			case 'U':	// Bootstrap and UDP Discovery Service
+				// Only UDP KHL caches serve G2; uhc: and host entries are for other networks.
+				if ( sService.startsWith( "ukhl:" ) )
+				{
+#if ENABLE_DISCOVERY_DEBUGGING
+					postLog( LogSeverity::Debug, "Parsing Default Service: UDP KHL Cache", true );
+					bAdded =
+#endif
+					add( sService, stUKHL, CNetworkType( dpG2 ), DISCOVERY_MAX_PROBABILITY );
+				}
+				break;
 
 			case 'X':	// Blocked service
 #if ENABLE_DISCOVERY_DEBUGGING
@@ -1497,9 +1603,16 @@ bool CDiscovery::normalizeURL(QString& sURL)
 //	else if ( sURL.startsWith( "uhc:" ) )
 //	{
 //	}
-//	else if ( sURL.startsWith( "ukhl:" ) )
-//	{
-//	}
+	else if ( sURL.startsWith( "ukhl:" ) )
+	{
+		// ukhl:host:port
+		if ( !QRegularExpression( "^ukhl:[a-z0-9.-]+:[0-9]{1,5}$" ).match( sURL ).hasMatch() )
+		{
+			postLog( LogSeverity::Error,
+					 tr( "Could not add invalid URL as a discovery service: " ) + sURL );
+			sURL.clear();
+		}
+	}
 	else // not supported
 	{
 		sURL.clear();
@@ -1513,10 +1626,12 @@ bool CDiscovery::normalizeURL(QString& sURL)
  * network.
  * Requires locking: YES
  * @param oNType
+ * @param eSType: if not stNull, only services of this type are considered
  * @return A discovery service for the specified network; Null if no working service could be
  * found for the specified network.
  */
-CDiscovery::TServicePtr CDiscovery::getRandomService(const CNetworkType& oNType)
+CDiscovery::TServicePtr CDiscovery::getRandomService(const CNetworkType& oNType,
+													 const TServiceType eSType)
 {
 #if ENABLE_DISCOVERY_DEBUGGING
 	postLog( LogSeverity::Debug,
@@ -1572,6 +1687,7 @@ CDiscovery::TServicePtr CDiscovery::getRandomService(const CNetworkType& oNType)
 
 		// Consider all services that...
 		if ( pService->m_oNetworkType.isNetwork( oNType ) &&     // have the correct type
+			 ( eSType == stNull || pService->m_nServiceType == eSType ) && // are of the requested kind
 			 bRatingEnabled &&              // have a rating > 0 or are considered for revival
 			 pService->m_tLastAccessed + quazaaSettings.Discovery.AccessThrottle
 			 < tNow &&                      // are not recently used
@@ -1633,6 +1749,131 @@ CDiscovery::TServicePtr CDiscovery::getRandomService(const CNetworkType& oNType)
 	}
 }
 
+/**
+ * @brief getBootstrapServices: Helper method. Allows to get all services that may currently
+ * be queried for a specified network, ordered by their expected cost.
+ * Requires locking: YES
+ * @param oNType
+ * @return the services, cheapest first
+ */
+CDiscovery::TDiscoveryServicesList CDiscovery::getBootstrapServices(const CNetworkType& oNType)
+{
+	typedef std::pair< quint32, TServicePtr > TRankedService;
+
+	std::list< TRankedService > lRanked;
+	const quint32 tNow = common::getTNowUTC();
+
+	foreach ( TMapPair pair, m_mServices )
+	{
+		TServicePtr pService = pair.second;
+		QReadLocker oServiceLock( &pService->m_oRWLock );
+
+		// Same conditions as for random access, except that zero rated services are not revived
+		// here: a bootstrap is about getting hosts quickly, not about testing services.
+		if ( !pService->m_bBanned && pService->m_nRating &&
+			 pService->m_oNetworkType.isNetwork( oNType ) &&
+			 pService->m_tLastAccessed + quazaaSettings.Discovery.AccessThrottle < tNow &&
+			 !pService->m_bRunning )
+		{
+			lRanked.push_back( TRankedService( pService->cost(), pService ) );
+		}
+	}
+
+	// stable, so equally ranked services keep their ID order
+	lRanked.sort( []( const TRankedService& a, const TRankedService& b )
+	{
+		return a.first < b.first;
+	} );
+
+	TDiscoveryServicesList lServices;
+	for ( std::list< TRankedService >::const_iterator it = lRanked.begin(); it != lRanked.end(); ++it )
+	{
+		lServices.push_back( it->second );
+	}
+
+	return lServices;
+}
+
+/**
+ * @brief bootstrapNext: Helper method. Queries further services of the running bootstrap up
+ * to the fan-out limit, or finishes the bootstrap if there is nothing left to wait for.
+ * Locking: YES (synchronous)
+ */
+void CDiscovery::bootstrapNext()
+{
+	TDiscoveryServicesList lStart;
+	const quint32 nFanOut = qMax<quint32>( quazaaSettings.Discovery.BootstrapFanOut, 1 );
+
+	m_pSection.lock();
+
+	if ( !m_bBootstrapping )
+	{
+		m_pSection.unlock();
+		return;
+	}
+
+	while ( !m_lBootstrapQueue.empty() && m_lBootstrapRunning.size() < nFanOut )
+	{
+		TServicePtr pService = m_lBootstrapQueue.front();
+		m_lBootstrapQueue.pop_front();
+
+		m_lBootstrapRunning.insert( pService->m_nID );
+		lStart.push_back( pService );
+	}
+
+	const bool bFinished = m_lBootstrapRunning.empty();
+	const quint32 nHosts = m_nBootstrapHosts;
+
+	if ( bFinished )
+	{
+		m_bBootstrapping = false;
+	}
+
+	m_pSection.unlock();
+
+	// Querying takes the service lock and may need the manager lock (see requestNAM()), so it
+	// must happen outside the section.
+	bool bSkipped = false;
+	for ( TListIterator it = lStart.begin(); it != lStart.end(); ++it )
+	{
+		TServicePtr pService = *it;
+
+		// the service might have been started by a manual query or an update in the meantime
+		pService->m_oRWLock.lockForRead();
+		const bool bRunning = pService->m_bRunning;
+		pService->m_oRWLock.unlock();
+
+		if ( bRunning )
+		{
+			m_pSection.lock();
+			m_lBootstrapRunning.erase( pService->m_nID );
+			m_pSection.unlock();
+
+			bSkipped = true;
+			continue;
+		}
+
+		postLog( LogSeverity::Notice, tr( "Querying service: " ) + pService->url() );
+
+		++m_pActive[pService->serviceType()];
+		pService->query();
+	}
+
+	if ( bSkipped )
+	{
+		// fill the freed slots, or finish if there is nothing left to do
+		bootstrapNext();
+	}
+	else if ( bFinished )
+	{
+		postLog( LogSeverity::Notice, tr( "Bootstrap finished with %1 hosts after %2 ms."
+										  ).arg( QString::number( nHosts ),
+												 QString::number( m_oBootstrapTimer.elapsed() ) ) );
+
+		emit bootstrapFinished( nHosts );
+	}
+}
+
 /**
  * @brief postLog writes a message to the system log or to the debug output.
  * Requires locking: /
@@ -25,6 +25,7 @@
 #ifndef DISCOVERY_H
 #define DISCOVERY_H
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QNetworkAccessManager>
 #include <QSharedPointer>
@@ -33,15 +34,17 @@
 
 #include <map>
 #include <list>
+#include <set>
 
 #include "systemlog.h"
 #include "networktype.h"
 
 // Increment this if there have been made changes to the way of storing discovery services.
-#define DISCOVERY_CODE_VERSION	1
+#define DISCOVERY_CODE_VERSION	2
 // History:
 // 0 - Initial implementation
 // 1 - Full implementation of GWC spec 2.0.
+// 2 - Added UDP KHL caches and the measured service latency.
 
 #define DISCOVERY_MAX_PROBABILITY 5
 
@@ -70,7 +73,7 @@ class CDiscoveryService;
  * @brief TServiceType: Must be updated when implementing new subclasses of CDiscoveryService.
  * Each subclass must implement (exactly) one TServiceType.
  */
-typedef enum { stNull = 0, stBanned = 1, stGWC = 2, stNumberOfServiceTypes = 3 } TServiceType;
+typedef enum { stNull = 0, stBanned = 1, stGWC = 2, stUKHL = 3, stNumberOfServiceTypes = 4 } TServiceType;
 
 /**
  * @brief TDiscoveryID: ID type used to identify and manage discovery services. All IDs are
@@ -143,6 +146,13 @@ private:
 	// thread used by the manager
 	QThread               m_oDiscoveryThread;
 
+	// bootstrap state; see bootstrap()
+	bool                  m_bBootstrapping;
+	TDiscoveryServicesList m_lBootstrapQueue;   // services not yet queried, best first
+	std::set<TServiceID>  m_lBootstrapRunning;  // services queried and not yet answered
+	quint32               m_nBootstrapHosts;    // hosts obtained so far
+	QElapsedTimer         m_oBootstrapTimer;
+
 public:
 	quint16*              m_pActive;
 
@@ -278,6 +288,25 @@ public:
 	void queryService(const CNetworkType& type); // Random service access
 	void queryService(TServiceID nID);           // Manual service access
 
+	/**
+	 * @brief bootstrap queries services for hosts to connect to until enough hosts have been
+	 * obtained. Services are ranked by their expected cost - measured latency over rating - and
+	 * up to Discovery.BootstrapFanOut of them are queried at the same time; each answer starts the
+	 * next one. UDP KHL caches answer in a single round trip and so usually go first. Querying
+	 * stops once Discovery.BootstrapHosts hosts have been obtained or no service is left;
+	 * bootstrapFinished() is emitted either way. Does nothing if a bootstrap is already running.
+	 * Locking: YES (asynchronous)
+	 * @param type
+	 */
+	void bootstrap(const CNetworkType& type);
+
+	/**
+	 * @brief isBootstrapping
+	 * Locking: YES (synchronous)
+	 * @return true between a call to bootstrap() and bootstrapFinished()
+	 */
+	bool isBootstrapping();
+
 	/**
 	 * @brief getWorkingService
 	 * Locking: YES (synchronous)
@@ -317,6 +346,12 @@ signals:
 	 */
 	void serviceInfo(TConstServicePtr pService);
 
+	/**
+	 * @brief bootstrapFinished is emitted once a bootstrap has stopped querying services.
+	 * @param nHosts: the number of hosts obtained
+	 */
+	void bootstrapFinished(quint32 nHosts);
+
 private slots:
 	// All methods in this section are helpers to do certain tasks asynchronously. See their
 	// respective callers for documentation.
@@ -327,6 +362,16 @@ private slots:
 	void asyncUpdateServiceHelper(TServiceID nID);
 	void asyncQueryServiceHelper(const CNetworkType type);
 	void asyncQueryServiceHelper(TServiceID nID);
+	void asyncBootstrapHelper(const CNetworkType type);
+
+	/**
+	 * @brief bootstrapQueried: Informs the bootstrap about a service having answered a query
+	 * (or having failed to).
+	 * Locking: YES (synchronous)
+	 * @param nID
+	 * @param nHosts
+	 */
+	void bootstrapQueried(TServiceID nID, quint16 nHosts);
 
 private:
 	/**
@@ -410,10 +455,27 @@ private:
 	 * network.
 	 * Requires locking: YES
 	 * @param oNType
+	 * @param eSType: if not stNull, only services of this type are considered
 	 * @return A discovery service for the specified network; Null if no working service could be
 	 * found for the specified network.
 	 */
-	TServicePtr getRandomService(const CNetworkType& oNType);
+	TServicePtr getRandomService(const CNetworkType& oNType, const TServiceType eSType = stNull);
+
+	/**
+	 * @brief getBootstrapServices: Helper method. Allows to get all services that may currently
+	 * be queried for a specified network, ordered by their expected cost.
+	 * Requires locking: YES
+	 * @param oNType
+	 * @return the services, cheapest first
+	 */
+	TDiscoveryServicesList getBootstrapServices(const CNetworkType& oNType);
+
+	/**
+	 * @brief bootstrapNext: Helper method. Queries further services of the running bootstrap up
+	 * to the fan-out limit, or finishes the bootstrap if there is nothing left to wait for.
+	 * Locking: YES (synchronous)
+	 */
+	void bootstrapNext();
 };
 
 } // namespace Discovery
@@ -24,6 +24,7 @@
 
 #include "discoveryservice.h"
 #include "gwc.h"
+#include "ukhl.h"
 #include "banneddiscoveryservice.h"
 
 #include "quazaasettings.h"
@@ -53,7 +54,9 @@ CDiscoveryService::CDiscoveryService(const QUrl& oURL, const CNetworkType& oNTyp
 	m_tLastSuccess( 0 ),
 	m_nFailures( 0 ),
 	m_nZeroRevivals( 0 ),
-	m_bRunning( false )
+	m_nLatency( 0 ),
+	m_bRunning( false ),
+	m_nSQCancelRequestID( 0 )
 {
 }
 
@@ -63,7 +66,8 @@ CDiscoveryService::CDiscoveryService(const QUrl& oURL, const CNetworkType& oNTyp
  */
 CDiscoveryService::CDiscoveryService(const CDiscoveryService& pService) :
 	QObject(),
-	m_bRunning( false )
+	m_bRunning( false ),
+	m_nSQCancelRequestID( 0 )
 {
 	// The usage of a custom copy constructor makes sure the list of registered
 	// pointers is NOT forwarded to a copy of this service.
@@ -85,6 +89,7 @@ CDiscoveryService::CDiscoveryService(const CDiscoveryService& pService) :
 
 	m_nZeroRevivals = pService.m_nZeroRevivals;
 	m_nProbaMult    = pService.m_nProbaMult;
+	m_nLatency      = pService.m_nLatency;
 }
 
 /**
@@ -129,7 +134,7 @@ bool CDiscoveryService::operator!=(const CDiscoveryService& pService) const
  * @param fsStream
  * @param nVersion
  */
-void CDiscoveryService::load(CDiscoveryService*& pService, QDataStream &fsFile, int)
+void CDiscoveryService::load(CDiscoveryService*& pService, QDataStream &fsFile, const int nVersion)
 {
 	quint8     nServiceType;        // GWC, UKHL, ...
 	quint16    nNetworkType;        // could be several in case of GWC for instance
@@ -146,6 +151,7 @@ void CDiscoveryService::load(CDiscoveryService*& pService, QDataStream &fsFile,
 	quint32    tLastSuccess;        // last time we queried the service successfully
 	quint8     nFailures;
 	quint8     nZeroRatingFailures;
+	quint32    nLatency = 0;        // average duration of successful accesses
 
 	fsFile >> nServiceType;
 	fsFile >> nNetworkType;
@@ -163,6 +169,11 @@ void CDiscoveryService::load(CDiscoveryService*& pService, QDataStream &fsFile,
 	fsFile >> nFailures;
 	fsFile >> nZeroRatingFailures;
 
+	if ( nVersion >= 2 )
+	{
+		fsFile >> nLatency;
+	}
+
 	pService = createService( sURL, (TServiceType)nServiceType,
 							  CNetworkType( nNetworkType ), nRating );
 
@@ -179,6 +190,7 @@ void CDiscoveryService::load(CDiscoveryService*& pService, QDataStream &fsFile,
 		pService->m_tLastSuccess  = tLastSuccess;
 		pService->m_nFailures     = nFailures;
 		pService->m_nZeroRevivals = nZeroRatingFailures;
+		pService->m_nLatency      = nLatency;
 
 #if ENABLE_DISCOVERY_DEBUGGING
 		QString s = QString( "Rating: " )         + QString::number( pService->m_nRating ) +
@@ -211,6 +223,7 @@ void CDiscoveryService::save(const CDiscoveryService* const pService, QDataStrea
 	fsFile << pService->m_tLastSuccess;
 	fsFile << pService->m_nFailures;
 	fsFile << pService->m_nZeroRevivals;
+	fsFile << pService->m_nLatency;
 }
 
 /**
@@ -253,6 +266,15 @@ CDiscoveryService* CDiscoveryService::createService(const QString& sURL, TServic
 		break;
 	}
 
+	case stUKHL:
+	{
+#if ENABLE_DISCOVERY_DEBUGGING
+		qDebug() << "[Discovery] Service Type: UKHL";
+#endif
+		pService = new CUKHL( sURL, oNType, nRating );
+		break;
+	}
+
 	default:
 #if ENABLE_DISCOVERY_DEBUGGING
 		qDebug() << "[Discovery] Service Type: Unknown";
@@ -281,13 +303,14 @@ void CDiscoveryService::update()
 
 	m_bRunning = true;
 	m_bQuery   = false;
+	m_oAccessTimer.start();
 
 	doUpdate();
 
 	m_oRWLock.unlock();
 
-	m_oSQCancelRequestID = signalQueue.push( this, SLOT( cancelRequest() ), common::getTNowUTC() +
-											 quazaaSettings.Discovery.ServiceTimeout );
+	m_nSQCancelRequestID = signalQueue.push( this, &CDiscoveryService::cancelRequest,
+											 common::getTNowUTC() + requestTimeout() );
 
 	emit updated( m_nID ); // notify GUI
 }
@@ -313,6 +336,7 @@ void CDiscoveryService::query()
 
 	m_bRunning = true;
 	m_bQuery   = true;
+	m_oAccessTimer.start();
 
 	doQuery();
 
@@ -322,8 +346,8 @@ void CDiscoveryService::query()
 	postLog( LogSeverity::Debug, "Released service lock.", true );
 #endif
 
-	m_oSQCancelRequestID = signalQueue.push( this, SLOT( cancelRequest() ), common::getTNowUTC() +
-											 quazaaSettings.Discovery.ServiceTimeout );
+	m_nSQCancelRequestID = signalQueue.push( this, &CDiscoveryService::cancelRequest,
+											 common::getTNowUTC() + requestTimeout() );
 
 	emit updated( m_nID ); // notify GUI
 
@@ -389,9 +413,9 @@ void CDiscoveryService::updateStatistics(quint16 nHosts, quint16 nURLs, bool bUp
 
 	// remove cancel request from signal queue
 	postLog( LogSeverity::Debug, tr( "Updating statistics." ), true );
-	Q_ASSERT( signalQueue.pop( m_oSQCancelRequestID ) );
+	signalQueue.pop( m_nSQCancelRequestID );
 
-	m_oSQCancelRequestID = QUuid();
+	m_nSQCancelRequestID = 0;
 
 	if ( m_bQuery || nHosts )//in case of an update, we still count hosts we got but did not request
 		m_nLastHosts = nHosts;
@@ -409,6 +433,10 @@ void CDiscoveryService::updateStatistics(quint16 nHosts, quint16 nURLs, bool bUp
 		m_tLastSuccess = m_tLastAccessed;
 		m_nFailures = 0;
 
+		// keep a running average, weighting the latest access by a quarter
+		const quint32 nLatency = qMax<qint64>( m_oAccessTimer.elapsed(), 1 );
+		m_nLatency = m_nLatency ? ( 3 * m_nLatency + nLatency ) / 4 : nLatency;
+
 		// eventual revival try successful
 		m_bZero = false;
 		m_nZeroRevivals = 0;
@@ -467,6 +495,43 @@ void CDiscoveryService::updateStatistics(quint16 nHosts, quint16 nURLs, bool bUp
 		Q_ASSERT( false );
 
 	emit updated( m_nID );
+
+	if ( m_bQuery )
+		emit queried( m_nID, nHosts );
+}
+
+/**
+ * @brief cost estimates what querying this service takes per useful answer: its latency
+ * divided by the share of its rating in the maximum rating, stretched further by recent
+ * failures. Used to rank services for bootstrapping; lower is better.
+ * Requires locking: R
+ * @return
+ */
+quint32 CDiscoveryService::cost() const
+{
+	const quint32 nLatency = m_nLatency ? m_nLatency : typicalLatency();
+	const quint32 nMaxRating = qMax<quint32>( quazaaSettings.Discovery.MaximumServiceRating, 1 );
+
+	return nLatency * ( nMaxRating + 1 ) / ( m_nRating + 1 ) * ( m_nFailures + 1 );
+}
+
+/**
+ * @brief typicalLatency: The latency in ms assumed for a service that has not yet been
+ * accessed successfully: an HTTP request including name lookup and connection setup.
+ * Requires locking: /
+ */
+quint32 CDiscoveryService::typicalLatency() const
+{
+	return 2000;
+}
+
+/**
+ * @brief requestTimeout: Number of seconds after which an access is cancelled.
+ * Requires locking: /
+ */
+quint32 CDiscoveryService::requestTimeout() const
+{
+	return quazaaSettings.Discovery.ServiceTimeout;
 }
 
 /**
@@ -26,6 +26,7 @@
 #define DISCOVERYSERVICE_H
 
 #include <QDataStream>
+#include <QElapsedTimer>
 #include <QReadWriteLock>
 #include <QUrl>
 
@@ -83,10 +84,12 @@ private:
 	quint8          m_nFailures;    // query failures in a row
 	quint8          m_nZeroRevivals;// counts number of times this service has been revived from a
 									// 0 rating.
+	quint32         m_nLatency;     // average duration of successful accesses in ms; 0: unknown
+	QElapsedTimer   m_oAccessTimer; // started on each access
 
 	bool            m_bRunning;     // service is currently doing network communication
 
-	QUuid           m_oSQCancelRequestID; // ID of cancel request (signal queue)
+	TTimerID        m_nSQCancelRequestID; // ID of cancel request (signal queue)
 
 	/* ========================================================================================== */
 	/* ====================================== Construction ====================================== */
@@ -168,6 +171,15 @@ private:
 	static CDiscoveryService* createService(const QString &sURL, TServiceType eSType,
 											const CNetworkType& oNType, quint8 nRating);
 
+	/**
+	 * @brief cost estimates what querying this service takes per useful answer: its latency
+	 * divided by the share of its rating in the maximum rating, stretched further by recent
+	 * failures. Used to rank services for bootstrapping; lower is better.
+	 * Requires locking: R
+	 * @return
+	 */
+	quint32 cost() const;
+
 	/* ========================================================================================== */
 	/* ======================================= Operations ======================================= */
 	/* ========================================================================================== */
@@ -200,6 +212,13 @@ signals:
 	 */
 	void updated(TServiceID nID);
 
+	/**
+	 * @brief queried is emitted once a query has been answered, failed or been cancelled.
+	 * @param nID
+	 * @param nHosts: the number of hosts obtained
+	 */
+	void queried(TServiceID nID, quint16 nHosts);
+
 	/* ========================================================================================== */
 	/* ==================================== Attribute Access ==================================== */
 	/* ========================================================================================== */
@@ -311,6 +330,13 @@ public:
 	 */
 	inline quint32 lastAccessed() const;
 
+	/**
+	 * @brief latency
+	 * Requires locking: R
+	 * @return the average duration of successful accesses in ms; 0 if unknown
+	 */
+	inline quint32 latency() const;
+
 protected:
 	/**
 	 * @brief setLastQueried sets the lastQueried attribute to tNow
@@ -405,6 +431,19 @@ private:
 	 */
 	virtual void doCancelRequest() throw() = 0;	/** Must be implemented by subclasses. */
 
+	/**
+	 * @brief typicalLatency: The latency in ms assumed for a service that has not yet been
+	 * accessed successfully.
+	 * Requires locking: /
+	 */
+	virtual quint32 typicalLatency() const;
+
+	/**
+	 * @brief requestTimeout: Number of seconds after which an access is cancelled.
+	 * Requires locking: /
+	 */
+	virtual quint32 requestTimeout() const;
+
 	/* ========================================================================================== */
 	/* ===================================== Friend Classes ===================================== */
 	/* ========================================================================================== */
@@ -473,6 +512,11 @@ quint32 CDiscoveryService::lastAccessed() const
 	return m_tLastAccessed;
 }
 
+quint32 CDiscoveryService::latency() const
+{
+	return m_nLatency;
+}
+
 void CDiscoveryService::setLastAccessed(quint32 tNow)
 {
 	m_tLastAccessed = tNow;
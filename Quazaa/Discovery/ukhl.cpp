@@ -0,0 +1,354 @@
+﻿/*
+** ukhl.cpp
+**
+** Copyright © Quazaa Development Team, 2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QUdpSocket>
+
+#include "buffer.h"
+#include "datagrams.h"
+#include "g2packet.h"
+#include "zlibutils.h"
+
+#include "quazaasettings.h"
+
+#include "ukhl.h"
+
+using namespace Discovery;
+
+CUKHL::CUKHL(const QUrl& oURL, const CNetworkType& oNType, quint8 nRating) :
+	CDiscoveryService( oURL, oNType, nRating ),
+	m_pSocket( NULL ),
+	m_nLookupID( -1 )
+{
+	m_nServiceType = stUKHL;
+}
+
+CUKHL::~CUKHL()
+{
+	cleanup();
+}
+
+QString CUKHL::type() const
+{
+	return isBanned() ? QString( "Banned UKHL" ) : QString( "UKHL" );
+}
+
+// caller needs to make sure the cache is not currently running
+void CUKHL::doQuery() throw()
+{
+	setLastAccessed( common::getTNowUTC() );
+
+	// URLs have the form ukhl:host:port; QUrl puts host:port into the path
+	const QString sAddress = m_oServiceURL.path();
+	const int     nColon   = sAddress.lastIndexOf( ':' );
+	const QString sHost    = sAddress.left( nColon );
+	const quint16 nPort    = sAddress.mid( nColon + 1 ).toUShort();
+
+	postLog( LogSeverity::Debug, QString( "Querying UKHL: %1" ).arg( sAddress ) );
+
+	QHostAddress oHost;
+	if ( oHost.setAddress( sHost ) )
+	{
+		m_oAddress = CEndPoint( oHost, nPort );
+		sendRequest();
+	}
+	else
+	{
+		// the port is restored once the lookup has completed
+		m_oAddress  = CEndPoint( QHostAddress(), nPort );
+		m_nLookupID = QHostInfo::lookupHost( sHost, this, SLOT( lookupCompleted( QHostInfo ) ) );
+	}
+}
+
+// a /KHLR announces us to the cache anyway, so an update is just a query
+void CUKHL::doUpdate() throw()
+{
+	m_bQuery = true;
+	doQuery();
+}
+
+void CUKHL::doCancelRequest() throw()
+{
+	cleanup();
+	resetRunning();
+}
+
+/**
+ * @brief typicalLatency: A single datagram round trip, without connection setup.
+ * Requires locking: /
+ */
+quint32 CUKHL::typicalLatency() const
+{
+	return 300;
+}
+
+/**
+ * @brief requestTimeout: UDP replies either arrive quickly or not at all.
+ * Requires locking: /
+ */
+quint32 CUKHL::requestTimeout() const
+{
+	return qMin<quint32>( quazaaSettings.Discovery.ServiceTimeout, 3 );
+}
+
+void CUKHL::sendRequest()
+{
+	const bool bIPv6 = m_oAddress.protocol() == QAbstractSocket::IPv6Protocol;
+
+	m_pSocket = new QUdpSocket();
+	connect( m_pSocket, &QUdpSocket::readyRead, this, &CUKHL::datagramReceived );
+
+	if ( !m_pSocket->bind( bIPv6 ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4, 0 ) )
+	{
+		// the cancel request will take care of the failure
+		postLog( LogSeverity::Error,
+				 tr( "Could not open UDP socket for UKHL: " ) + m_pSocket->errorString() );
+		return;
+	}
+
+	G2Packet* pKHLR = G2Packet::newPacket( "KHLR" );
+	CBuffer oBuffer;
+	pKHLR->toBuffer( &oBuffer );
+	pKHLR->release();
+
+	GND_HEADER oHeader;
+	memcpy( &oHeader.szTag[0], "GND", 3 );
+	oHeader.nFlags    = 0;
+	oHeader.nSequence = qrand() & 0xFFFF;
+	oHeader.nPart     = 1;
+	oHeader.nCount    = 1;
+	oBuffer.insert( 0, &oHeader, sizeof( GND_HEADER ) );
+
+	if ( m_pSocket->writeDatagram( oBuffer.data(), oBuffer.size(), m_oAddress,
+								   m_oAddress.port() ) < 0 )
+	{
+		postLog( LogSeverity::Error,
+				 tr( "Could not send request to UKHL: " ) + m_pSocket->errorString() );
+	}
+}
+
+bool CUKHL::parseReply(const QByteArray& baDatagram, QList< QPair<CEndPoint, quint32> >& lHosts)
+{
+	if ( (quint32)baDatagram.size() <= sizeof( GND_HEADER ) )
+		return false;
+
+	const GND_HEADER* pHeader = (const GND_HEADER*)baDatagram.constData();
+
+	// a list of hubs easily fits a single datagram; we do not reassemble fragments
+	if ( strncmp( &pHeader->szTag[0], "GND", 3 ) || pHeader->nPart != 1 || pHeader->nCount != 1 )
+		return false;
+
+	CBuffer oBuffer;
+	oBuffer.append( baDatagram.constData() + sizeof( GND_HEADER ),
+					baDatagram.size() - sizeof( GND_HEADER ) );
+
+	if ( ( pHeader->nFlags & 0x01 ) && !ZLibUtils::uncompressBuffer( oBuffer ) )
+		return false;
+
+	G2Packet* pPacket = NULL;
+	try
+	{
+		pPacket = G2Packet::readBuffer( &oBuffer );
+	}
+	catch ( ... )
+	{
+		pPacket = NULL;
+	}
+
+	if ( !pPacket )
+		return false;
+
+	if ( !pPacket->isType( "KHLA" ) || !pPacket->m_bCompound )
+	{
+		pPacket->release();
+		return false;
+	}
+
+	const quint32 tNow = common::getTNowUTC();
+	qint32 nDiff = 0;
+
+	char szType[9], szInner[9];
+	quint32 nLength = 0, nInnerLength = 0;
+	bool bCompound = false;
+	quint32 nNext = 0;
+
+	try
+	{
+		while ( pPacket->readPacket( &szType[0], nLength, &bCompound ) )
+		{
+			nNext = pPacket->m_nPosition + nLength;
+
+			const bool bNH = strcmp( "NH", szType ) == 0;
+			const bool bCH = strcmp( "CH", szType ) == 0;
+
+			if ( bNH || bCH )
+			{
+				// children (GU, V, ...) are of no interest here
+				if ( bCompound )
+				{
+					while ( pPacket->m_nPosition < nNext &&
+							pPacket->readPacket( &szInner[0], nInnerLength ) )
+					{
+						pPacket->m_nPosition += nInnerLength;
+					}
+
+					nLength = nNext - pPacket->m_nPosition;
+				}
+
+				// hubs listed under NH are neighbours of the cache and thus alive right now
+				if ( nLength >= ( bCH ? 10u : 6u ) )
+				{
+					CEndPoint oAddress;
+					pPacket->readHostAddress( &oAddress, nLength < ( bCH ? 22u : 18u ) );
+
+					const quint32 tSeen = bCH ? pPacket->readIntLE<quint32>() : 0;
+					lHosts.append( qMakePair( oAddress, tSeen ) );
+				}
+			}
+			else if ( strcmp( "TS", szType ) == 0 )
+			{
+				if ( bCompound )
+				{
+					pPacket->skipCompound( nLength );
+				}
+
+				if ( nLength >= 4 )
+				{
+					nDiff = tNow - pPacket->readIntLE<quint32>();
+				}
+			}
+
+			pPacket->m_nPosition = nNext;
+		}
+	}
+	catch ( ... )
+	{
+		// keep what we got so far
+	}
+
+	pPacket->release();
+
+	// translate the remote time stamps to local time; the TS child may come last
+	for ( int i = 0; i < lHosts.size(); ++i )
+	{
+		lHosts[i].second = lHosts[i].second ? lHosts[i].second + nDiff : tNow;
+	}
+
+	return true;
+}
+
+void CUKHL::cleanup()
+{
+	if ( m_nLookupID != -1 )
+	{
+		QHostInfo::abortHostLookup( m_nLookupID );
+		m_nLookupID = -1;
+	}
+
+	if ( m_pSocket )
+	{
+		m_pSocket->disconnect( this );
+		m_pSocket->deleteLater();
+		m_pSocket = NULL;
+	}
+}
+
+void CUKHL::lookupCompleted(const QHostInfo& oHostInfo)
+{
+	QWriteLocker oUKHLLock( &m_oRWLock );
+
+	if ( !isRunning() || oHostInfo.lookupId() != m_nLookupID )
+		return; // we got cancelled while waiting for the lock
+
+	m_nLookupID = -1;
+
+	if ( oHostInfo.error() != QHostInfo::NoError || oHostInfo.addresses().isEmpty() )
+	{
+		postLog( LogSeverity::Error,
+				 tr( "Could not resolve UKHL host name: " ) + oHostInfo.errorString() );
+
+		updateStatistics();
+		resetRunning();
+		return;
+	}
+
+	m_oAddress = CEndPoint( oHostInfo.addresses().first(), m_oAddress.port() );
+	sendRequest();
+}
+
+void CUKHL::datagramReceived()
+{
+	QWriteLocker oUKHLLock( &m_oRWLock );
+
+	if ( !isRunning() || !m_pSocket )
+		return; // we got cancelled while waiting for the lock
+
+	QList< QPair<CEndPoint, quint32> > lHosts;
+	bool bAnswered = false;
+
+	while ( !bAnswered && m_pSocket->hasPendingDatagrams() )
+	{
+		QByteArray baDatagram;
+		baDatagram.resize( m_pSocket->pendingDatagramSize() );
+
+		QHostAddress oSender;
+		quint16 nSenderPort = 0;
+		m_pSocket->readDatagram( baDatagram.data(), baDatagram.size(), &oSender, &nSenderPort );
+
+		// ignore anything that is not a reply from the cache itself
+		if ( oSender != m_oAddress || nSenderPort != m_oAddress.port() )
+			continue;
+
+		bAnswered = parseReply( baDatagram, lHosts );
+	}
+
+	if ( !bAnswered )
+		return;
+
+	postLog( LogSeverity::Debug, tr( "Recieved answer from UKHL." ) );
+
+	const quint16 nHosts = qMin( lHosts.size(), 0xFFFF );
+
+	// make sure all statistics and failure counters are updated
+	updateStatistics( nHosts );
+
+	cleanup();
+
+	// make sure the service is not reported as running anymore
+	resetRunning();
+
+	// finished accessing UKHL variables
+	oUKHLLock.unlock();
+
+	// prepare for adding new hosts
+	QMutexLocker l( &hostCache.m_pSection );
+
+	for ( int i = 0; i < lHosts.size(); ++i )
+	{
+		hostCache.add( lHosts[i].first, lHosts[i].second );
+	}
+
+	postLog( LogSeverity::Debug,
+			 QString( "Host Cache count after querying UKHL: " ) +
+			 QString::number( hostCache.count() ), true );
+}
@@ -0,0 +1,102 @@
+﻿/*
+** ukhl.h
+**
+** Copyright © Quazaa Development Team, 2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef UKHL_H
+#define UKHL_H
+
+#include <QHostInfo>
+
+#include "discoveryservice.h"
+
+class QUdpSocket;
+
+namespace Discovery
+{
+
+/**
+ * @brief The CUKHL class implements a G2 UDP KHL cache: a node answering a /KHLR datagram with a
+ * /KHLA listing known hubs. URLs have the form ukhl:host:port.
+ */
+class CUKHL : public CDiscoveryService
+{
+	Q_OBJECT
+
+	/* ========================================================================================== */
+	/* ======================================= Attributes ======================================= */
+	/* ========================================================================================== */
+private:
+	QUdpSocket* m_pSocket;
+	CEndPoint   m_oAddress;   // resolved service address
+	int         m_nLookupID;  // pending host name lookup; -1: none
+
+	/* ========================================================================================== */
+	/* ====================================== Construction ====================================== */
+	/* ========================================================================================== */
+public:
+	CUKHL(const QUrl& oURL, const CNetworkType& oNType, quint8 nRating);
+
+	~CUKHL();
+
+	/* ========================================================================================== */
+	/* ======================================= Operations ======================================= */
+	/* ========================================================================================== */
+	QString     type()       const;
+
+private:
+	void doQuery()  throw();
+	void doUpdate() throw();
+	void doCancelRequest() throw();
+
+	quint32 typicalLatency() const;
+	quint32 requestTimeout() const;
+
+	/**
+	 * @brief sendRequest sends the /KHLR to m_oAddress.
+	 * Requires locking: RW
+	 */
+	void sendRequest();
+
+	/**
+	 * @brief parseReply extracts the hubs from a /KHLA datagram.
+	 * Requires locking: /
+	 * @param baDatagram
+	 * @param lHosts: receives the hubs along with the time they were last seen (local time)
+	 * @return true if the datagram was a /KHLA
+	 */
+	static bool parseReply(const QByteArray& baDatagram, QList< QPair<CEndPoint, quint32> >& lHosts);
+
+	/**
+	 * @brief cleanup releases the socket and any pending lookup.
+	 * Requires locking: RW
+	 */
+	void cleanup();
+
+private slots:
+	void lookupCompleted(const QHostInfo& oHostInfo);
+	void datagramReceived();
+};
+
+}
+
+#endif // UKHL_H
@@ -50,7 +50,7 @@ inline Ranges::Range<quint64> SerializeIn(QDataStream& s)
 	throw std::exception();
 }
 
-inline void SerializeOut(QDataStream& s, const Ranges::List< Ranges::Range<quint64>, ListTraits >& rhs)
+inline void SerializeOut(QDataStream& s, const List& rhs)
 {
 	quint64 nTotal = rhs.limit();
 	quint64 nRemaining = rhs.length_sum();
@@ -58,12 +58,12 @@ inline void SerializeOut(QDataStream& s, const Ranges::List< Ranges::Range<quint
 
 	s << nTotal << nRemaining << nFragments;
 
-	for( Ranges::List< Ranges::Range<quint64>, ListTraits >::const_iterator i = rhs.begin(); i != rhs.end(); ++i )
+	for( List::const_iterator i = rhs.begin(); i != rhs.end(); ++i )
 	{
 		SerializeOut(s, *i);
 	}
 }
-inline void SerializeIn(QDataStream& s, Ranges::List< Ranges::Range<quint64>, ListTraits >& rhs)
+inline void SerializeIn(QDataStream& s, List& rhs)
 {
 	quint64 nTotal, nRemaining;
     quint64 nFragments;
@@ -71,7 +71,7 @@ inline void SerializeIn(QDataStream& s, Ranges::List< Ranges::Range<quint64>, Li
 	s >> nTotal >> nRemaining >> nFragments;
 
 	{
-		Ranges::List< Ranges::Range<quint64>, ListTraits > oNewRange(nTotal);
+		List oNewRange(nTotal);
 		rhs.swap(oNewRange);
 	}
 
@@ -108,7 +108,14 @@ using Ranges::Exception;
 typedef Ranges::Range< quint64 > Fragment;
 typedef Ranges::RangeError< Fragment > FragmentError;
 typedef Ranges::ListError< Fragment > ListError;
-typedef Ranges::List< Fragment, ListTraits > List;
+// The flat list is the default; define QUAZAA_FRAGMENTS_SET_LIST to go back to std::set.
+typedef Ranges::List< Fragment, ListTraits > SetList;
+typedef Ranges::FlatList< Fragment > FlatList;
+#ifdef QUAZAA_FRAGMENTS_SET_LIST
+typedef SetList List;
+#else
+typedef FlatList List;
+#endif
 typedef Ranges::Queue< Fragment > Queue;
 
 } // namespace Fragments
@@ -0,0 +1,377 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef FILEFRAGMENTS_FLATLIST_HPP_INCLUDED
+#define FILEFRAGMENTS_FLATLIST_HPP_INCLUDED
+
+#include <algorithm>
+#include <vector>
+
+#include "commonfunctions.h"
+#include <QDebug>
+
+namespace Ranges
+{
+
+// Same interface as List, but the ranges are kept in a sorted std::vector: they sit next to
+// each other in memory, lookups are binary searches and no node is allocated per range.
+// Inserting or erasing moves the ranges behind the position, which for the few thousand
+// fragments of even a large download is far cheaper than std::set's allocations.
+// Unlike List, every insert or erase invalidates iterators.
+// The largest range is cached, so repeated largest_range() calls don't walk the list.
+template< class RangeT >
+class FlatList
+{
+// Interface
+public:
+	// Typedefs
+	typedef RangeT range_type;
+	typedef std::vector< RangeT > container_type;
+	typedef typename range_type::size_type range_size_type;
+	typedef typename range_type::payload_type payload_type;
+	typedef RangeCompare< range_size_type, payload_type > compare_type;
+	typedef ListError< range_type > ListException;
+	typedef typename container_type::value_type value_Type;
+	typedef typename container_type::pointer pointer;
+	typedef typename container_type::const_pointer const_pointer;
+	typedef typename container_type::reference reference;
+	typedef typename container_type::const_reference const_reference;
+	typedef typename container_type::iterator iterator;
+	typedef typename container_type::const_iterator const_iterator;
+	typedef typename container_type::reverse_iterator reverse_iterator;
+	typedef typename container_type::const_reverse_iterator const_reverse_iterator;
+	typedef typename container_type::size_type size_type;
+	typedef typename container_type::difference_type difference_type;
+	typedef std::pair< iterator, iterator > iterator_pair;
+	typedef std::pair< const_iterator, const_iterator > const_iterator_pair;
+	typedef range_size_type ctor_arg_type;
+	// Constructor
+	explicit FlatList(ctor_arg_type limit = 0) : m_set(), m_limit( limit ), m_length_sum( 0 ),
+		m_largest( 0, 0 ), m_largest_valid( true ) { }
+
+	// Iterators
+	iterator               begin()        { return m_set.begin(); }
+	const_iterator         begin()  const { return m_set.begin(); }
+	iterator               end()          { return m_set.end(); }
+	const_iterator         end()    const { return m_set.end(); }
+	reverse_iterator       rbegin()       { return m_set.rbegin(); }
+	const_reverse_iterator rbegin() const { return m_set.rbegin(); }
+	reverse_iterator       rend()         { return m_set.rend(); }
+	const_reverse_iterator rend()   const { return m_set.rend(); }
+
+	// Accessors
+	bool empty() const { return m_set.empty(); }
+	size_type size()  const { return m_set.size(); }
+	range_size_type limit() const { return m_limit; }
+	range_size_type length_sum() const { return m_length_sum; }
+	range_size_type missing() const { return limit() - length_sum(); }
+	void ensure(range_size_type limit)
+	{
+		m_limit = qMax( m_limit, limit );
+	}
+	// Operations
+	void clear()
+	{
+		m_set.clear();
+		m_length_sum = 0;
+		m_largest = range_type( 0, 0 );
+		m_largest_valid = true;
+	}
+	void reserve(size_type count) { m_set.reserve( count ); }
+	// @insert  See List::insert().
+	// @complexity   ~O( log( n ) ) to find the position, plus moving the ranges behind it
+	range_size_type insert(const range_type& value);
+	template< typename input_iterator >
+	range_size_type insert(input_iterator first, input_iterator last)
+	{
+		range_size_type sum = 0;
+		for ( ; first != last; ) sum += insert( *first++ );
+		return sum;
+	}
+	// @insert  Inserts a fragment using an iterator as hint. Appending at end() in
+	//          ascending order is done in constant time.
+	range_size_type insert(const iterator where, const range_type& value);
+	// @erase   See List::erase().
+	range_size_type erase(const range_type& value);
+	template< typename input_iterator >
+	range_size_type erase(input_iterator first, input_iterator last)
+	{
+		range_size_type sum = 0;
+		for ( ; first != last; ) sum += erase( *first++ );
+		return sum;
+	}
+	range_size_type erase(const iterator where)
+	{
+		range_size_type result = where->size();
+		if ( m_largest_valid && *where == m_largest ) m_largest_valid = false;
+		m_length_sum -= result;
+		m_set.erase( where );
+		return result;
+	}
+	// @swap    Swaps two lists.
+	// @complexity   ~O( 1 )
+	void swap(FlatList& rhs)                // throw ()
+	{
+		m_set.swap( rhs.m_set );
+		std::swap( m_limit, rhs.m_limit );
+		std::swap( m_length_sum, rhs.m_length_sum );
+		std::swap( m_largest, rhs.m_largest );
+		std::swap( m_largest_valid, rhs.m_largest_valid );
+	}
+
+	iterator            lower_bound(const range_type& key)       { return std::lower_bound( begin(), end(), key, compare_type() ); }
+	const_iterator      lower_bound(const range_type& key) const { return std::lower_bound( begin(), end(), key, compare_type() ); }
+	iterator            upper_bound(const range_type& key)       { return std::upper_bound( begin(), end(), key, compare_type() ); }
+	const_iterator      upper_bound(const range_type& key) const { return std::upper_bound( begin(), end(), key, compare_type() ); }
+	iterator_pair       equal_range(const range_type& key)       { return std::equal_range( begin(), end(), key, compare_type() ); }
+	const_iterator_pair equal_range(const range_type& key) const { return std::equal_range( begin(), end(), key, compare_type() ); }
+	iterator_pair       merge_range(const range_type& key)
+	{
+		iterator_pair sequence( equal_range( key ) );
+		if ( sequence.first != m_set.begin() && ( sequence.first - 1 )->end() == key.begin() )
+			--sequence.first;
+		if ( sequence.second != m_set.end() && sequence.second->begin() == key.end() )
+			++sequence.second;
+		return sequence;
+	}
+	const_iterator_pair merge_range(const range_type& key) const
+	{
+		const_iterator_pair sequence( equal_range( key ) );
+		if ( sequence.first != m_set.begin() && ( sequence.first - 1 )->end() == key.begin() )
+			--sequence.first;
+		if ( sequence.second != m_set.end() && sequence.second->begin() == key.end() )
+			++sequence.second;
+		return sequence;
+	}
+
+	iterator largest_range()
+	{
+		update_largest();
+		return empty() ? end() : lower_bound( m_largest );
+	}
+	const_iterator largest_range() const
+	{
+		update_largest();
+		return empty() ? end() : lower_bound( m_largest );
+	}
+
+	iterator random_range()
+	{
+		iterator result = begin();
+		if ( !empty() ) result += common::getRandomNum<quint64>( 0u, size() - 1 );
+		return result;
+	}
+	const_iterator random_range() const
+	{
+		const_iterator result = begin();
+		if ( !empty() ) result += common::getRandomNum<quint64>( 0u, size() - 1 );
+		return result;
+	}
+
+	bool overlaps(const range_type& key) const { return std::binary_search( begin(), end(), key, compare_type() ); }
+	bool overlaps(const FlatList& rhs) const
+	{
+		return size() < rhs.size()
+			? std::find_if( begin(), end(), overlaps_helper( rhs ) ) != end()
+			: std::find_if( rhs.begin(), rhs.end(), overlaps_helper( *this ) ) != rhs.end();
+	}
+	range_size_type overlapping_sum(const range_type& key) const
+	{
+		const_iterator_pair sequence( equal_range( key ) );
+		range_size_type sum = 0;
+		for ( ; sequence.first != sequence.second; ++sequence.first )
+		{
+			sum += qMin( sequence.first->end(), key.end() )
+				- qMax( sequence.first->begin(), key.begin() );
+		}
+		return sum;
+	}
+	bool has_position(range_size_type where) const { return overlaps( range_type( where, where + 1 ) ); }
+
+// Implementation
+private:
+	container_type m_set;
+	range_size_type m_limit;
+	range_size_type m_length_sum;
+	mutable range_type m_largest;       // largest range, if m_largest_valid
+	mutable bool m_largest_valid;
+
+	void update_largest() const
+	{
+		if ( m_largest_valid ) return;
+		m_largest = empty() ? range_type( 0, 0 ) : *std::max_element( begin(), end(), cmp_size() );
+		m_largest_valid = true;
+	}
+	void grown(const range_type& value)
+	{
+		// value replaced every range it touched, including the largest one if it did
+		if ( m_largest_valid && value.size() >= m_largest.size() ) m_largest = value;
+	}
+	void shrunk(const range_type& value)
+	{
+		if ( m_largest_valid && value.begin() < m_largest.end() && m_largest.begin() < value.end() )
+			m_largest_valid = false;
+	}
+
+	struct cmp_size : public std::binary_function< RangeT, RangeT, bool >
+	{
+		typename cmp_size::result_type operator()(typename cmp_size::first_argument_type lhs, typename cmp_size::second_argument_type rhs) const
+		{
+			return lhs.size() < rhs.size();
+		}
+	};
+	struct overlaps_helper : public std::unary_function< RangeT, bool >
+	{
+		overlaps_helper(const FlatList& list) : m_list( list ) { }
+		typename overlaps_helper::result_type operator()(typename overlaps_helper::argument_type arg) const
+		{
+			return m_list.overlaps( arg );
+		}
+		const FlatList& m_list;
+	};
+};
+
+// @inverse Linear version of inverse() for the flat list.
+// @complexity   ~O( n )
+template< class RangeT >
+FlatList< RangeT > inverse(const FlatList< RangeT >& src);
+
+} // namespace Ranges
+
+////////////////////////////////////////////////////////////////////////////////
+// Implementation
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Ranges
+{
+
+template< class RangeT >
+typename RangeT::size_type FlatList< RangeT >::insert(const RangeT& value)
+{
+	if ( value.end() > limit() )
+	{
+		qDebug( qPrintable(QString("ListError - insert - size: %1 - limit: %2 - sum: %3 - Range - begin: %4 - end: %5")
+								   .arg(size()).arg(limit()).arg(length_sum()).arg(value.begin()).arg(value.end())) );
+		return 0;
+	}
+	if ( value.size() == 0 ) return 0;
+	iterator_pair sequence( merge_range( value ) );
+	if ( sequence.first == sequence.second )
+	{
+		m_set.insert( sequence.first, value );
+		m_length_sum += value.size();
+		grown( value );
+		return value.size();
+	}
+	if ( sequence.first->begin() <= value.begin()
+		&& sequence.first->end() >= value.end() ) return 0;
+	const range_type merged( qMin( sequence.first->begin(), value.begin() ),
+		qMax( ( sequence.second - 1 )->end(), value.end() ) );
+	range_size_type old_sum = m_length_sum;
+	for ( iterator i = sequence.first; i != sequence.second; ++i ) m_length_sum -= i->size();
+	*sequence.first = merged;
+	m_set.erase( sequence.first + 1, sequence.second );
+	m_length_sum += merged.size();
+	grown( merged );
+	return m_length_sum - old_sum;
+}
+
+template< class RangeT >
+typename RangeT::size_type FlatList< RangeT >::insert(
+	typename FlatList< RangeT >::iterator where, const RangeT& value)
+{
+	if ( value.end() > limit() )
+	{
+		qDebug( qPrintable(QString("ListError - insert(h) - size: %1 - limit: %2 - sum: %3 - \nRange - begin: %4 - end: %5")
+			.arg(size()).arg(limit()).arg(length_sum()).arg(value.begin()).arg(value.end())) );
+		return 0;
+	}
+	if ( value.size() == 0 ) return 0;
+	if ( ( where == begin() || ( where - 1 )->end() < value.begin() )
+		&& ( where == end() || value.end() < where->begin() ) )
+	{
+		m_set.insert( where, value );
+		m_length_sum += value.size();
+		grown( value );
+		return value.size();
+	}
+	return insert( value );
+}
+
+template< class RangeT >
+typename RangeT::size_type FlatList< RangeT >::erase(const RangeT& value)
+{
+	if ( value.end() > limit() )
+	{
+		qDebug(qPrintable(QString("ListError - erase - size: %1 - limit: %2 - sum: %3 - Range - begin: %4 - end: %5")
+								  .arg(size()).arg(limit()).arg(length_sum()).arg(value.begin()).arg(value.end())) );
+		return 0;
+	}
+	if ( value.size() == 0 ) return 0;
+	iterator_pair sequence( equal_range( value ) );
+	if ( sequence.first == sequence.second ) return 0;
+	const range_type front( qMin( sequence.first->begin(), value.begin() ),
+		value.begin(), value.value() );
+	const range_type back( value.end(),
+		qMax( ( sequence.second - 1 )->end(), value.end() ), value.value() );
+	range_size_type sum = 0;
+	for ( iterator i = sequence.first; i != sequence.second; ++i ) sum += i->size();
+	sum -= front.size() + back.size();
+	m_length_sum -= sum;
+	shrunk( value );
+
+	// reuse the slots of the removed ranges for the remaining pieces
+	const size_type first = sequence.first - begin();
+	const size_type count = sequence.second - sequence.first;
+	size_type used = 0;
+	if ( front.size() ) m_set[ first + used++ ] = front;
+	if ( back.size() )
+	{
+		if ( used == count ) m_set.insert( begin() + first + used, back );
+		else m_set[ first + used++ ] = back;
+	}
+	if ( used < count ) m_set.erase( begin() + first + used, begin() + first + count );
+	return sum;
+}
+
+template< class RangeT >
+FlatList< RangeT > inverse(const FlatList< RangeT >& src)
+{
+	typedef typename FlatList< RangeT >::range_size_type range_size_type;
+	typedef typename FlatList< RangeT >::const_iterator const_iterator;
+	FlatList< RangeT > result( src.limit() );
+	result.reserve( src.size() + 1 );
+	range_size_type last = 0;
+	for ( const_iterator i = src.begin(); i != src.end(); ++i )
+	{
+		result.insert( result.end(), RangeT( last, i->begin() ) );
+		last = i->end();
+	}
+	result.insert( result.end(), RangeT( last, src.limit() ) );
+	return result;
+}
+
+} // namespace Ranges
+
+#endif // #ifndef FILEFRAGMENTS_FLATLIST_HPP_INCLUDED
@@ -242,6 +242,12 @@ private:
 template< class list_type >
 list_type inverse(const list_type& src);
 
+// @intersection returns a list containing each range that is part of both lists,
+//          limited like lhs
+// @complexity   ~O( n + m ) when the list supports appending at end() in constant time
+template< class list_type >
+list_type intersection(const list_type& lhs, const list_type& rhs);
+
 } // namespace Ranges
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -326,6 +332,25 @@ list_type inverse(const list_type& src)
 	return result;
 }
 
+template< class list_type >
+list_type intersection(const list_type& lhs, const list_type& rhs)
+{
+	typedef typename list_type::range_type range_type;
+	typedef typename list_type::range_size_type range_size_type;
+	typedef typename list_type::const_iterator const_iterator;
+	list_type result( lhs.limit() );
+	const_iterator i = lhs.begin(), j = rhs.begin();
+	while ( i != lhs.end() && j != rhs.end() )
+	{
+		const range_size_type low = qMax( i->begin(), j->begin() );
+		const range_size_type high = qMin( i->end(), j->end() );
+		if ( low < high ) result.insert( result.end(), range_type( low, high ) );
+		if ( i->end() < j->end() ) ++i;
+		else ++j;
+	}
+	return result;
+}
+
 } // namespace Ranges
 
 #endif // #ifndef FILEFRAGMENTS_LIST_HPP_INCLUDED
@@ -31,6 +31,7 @@
 #include "Exception.hpp"
 #include "Range.hpp"
 #include "List.hpp"
+#include "FlatList.hpp"
 #include "Queue.hpp"
 
 #endif // #ifndef FILEFRAGMENTS_RANGES_HPP_INCLUDED
@@ -41,7 +41,8 @@ CHostCache hostCache;
 
 CHostCache::CHostCache():
 	m_tLastSave( common::getTNowUTC() ),
-	m_nMaxCacheHosts( 3000 )
+	m_nMaxCacheHosts( 3000 ),
+	m_nGeneration( 1 )
 {
 }
 
@@ -85,6 +86,7 @@ CHostCacheHost* CHostCache::add(CEndPoint host, quint32 tTimeStamp)
 		{
 			delete m_lHosts.takeLast();
 		}
+		changed();
 
 		save( tNow );
 	}
@@ -108,6 +110,7 @@ CHostCacheHost* CHostCache::add(CEndPoint host, quint32 tTimeStamp)
 	CHostCacheIterator it = qLowerBound( m_lHosts.begin(), m_lHosts.end(),
 										 pNew, qLess<CHostCacheHost*>() );
 	m_lHosts.insert( it, pNew );
+	changed();
 
 	return pNew;
 }
@@ -155,6 +158,7 @@ CHostCacheHost* CHostCache::update(CHostCacheIterator itHost, const quint32 tTim
 	m_lHosts.erase( itHost );
 	pHost->m_tTimestamp = tTimeStamp;
 	m_lHosts.prepend( pHost );
+	changed();
 	return pHost;
 }
 
@@ -165,6 +169,7 @@ void CHostCache::remove(CHostCacheHost* pRemove)
 	if ( it != m_lHosts.end() )
 	{
 		m_lHosts.erase( it );
+		changed();
 	}
 
 	delete pRemove;
@@ -178,6 +183,37 @@ void CHostCache::remove(CEndPoint oHost)
 	{
 		delete *it;
 		m_lHosts.erase( it );
+		changed();
+	}
+}
+
+// Removes the hosts banned by the rules of a sanity check. The addresses are checked on a snapshot,
+// so the cache stays available while that happens; the section must not be held by the caller.
+void CHostCache::sanityCheck(const CSecuritySanityCheck& oRules)
+{
+	if ( !oRules.hasAddressRules() )
+		return;
+
+	QList<CEndPoint> lAddresses;
+
+	m_pSection.lock();
+	lAddresses.reserve( m_lHosts.size() );
+	foreach ( CHostCacheHost* pHost, m_lHosts )
+	{
+		lAddresses.append( pHost->m_oAddress );
+	}
+	m_pSection.unlock();
+
+	QList<int> lDenied = oRules.denied( lAddresses );
+
+	if ( !lDenied.isEmpty() )
+	{
+		QMutexLocker l( &m_pSection );
+
+		foreach ( int nIndex, lDenied )
+		{
+			remove( lAddresses.at( nIndex ) );
+		}
 	}
 }
 
@@ -264,6 +300,8 @@ void CHostCache::onFailure(CEndPoint addr)
 
 	if ( itHost != m_lHosts.end() )
 	{
+		changed();
+
 		if ( (int)(++(*itHost)->m_nFailures) > quazaaSettings.Connection.FailureLimit )
 		{
 			remove( addr );
@@ -282,6 +320,7 @@ CHostCacheHost* CHostCache::get()
 
 	pHost = m_lHosts.first();
 	m_lHosts.removeFirst();
+	changed();
 
 	return pHost;
 }
@@ -299,16 +338,31 @@ CHostCacheHost* CHostCache::getConnectable(const quint32 tNow, QList<CHostCacheH
 		return NULL;
 	}
 
+	// Look up the countries of all hosts in one pass instead of once per host and attempt
+	QStringList lCountries;
+	if ( bCountry )
+	{
+		QList<QHostAddress> lAddresses;
+		lAddresses.reserve( m_lHosts.size() );
+		foreach ( CHostCacheHost * pHost, m_lHosts )
+		{
+			lAddresses.append( pHost->m_oAddress );
+		}
+		lCountries = geoIP.findCountryCodes( lAddresses );
+	}
+
 	// First try untested or working hosts, then fall back to failed hosts to increase chances for
 	// successful connection
 	for ( int nFailures = 0; nFailures < quazaaSettings.Connection.FailureLimit; ++nFailures )
 	{
-		foreach ( CHostCacheHost * pHost, m_lHosts )
+		for ( int i = 0; i < m_lHosts.size(); ++i )
 		{
+			CHostCacheHost* pHost = m_lHosts.at( i );
+
 			if ( nFailures != pHost->m_nFailures )
 				continue;
 
-			if ( bCountry && geoIP.findCountryCode(pHost->m_oAddress.toIPv4Address()) != sCountry )
+			if ( bCountry && lCountries.at( i ) != sCountry )
 			{
 				continue;
 			}
@@ -425,6 +479,7 @@ void CHostCache::pruneOldHosts(const quint32 tNow)
 		{
 			delete it.value();
 			it.remove();
+			changed();
 		}
 		else
 		{
@@ -441,6 +496,7 @@ void CHostCache::pruneByQueryAck(const quint32 tNow)
 		{
 			delete *it;
 			it = m_lHosts.erase( it );
+			changed();
 		}
 		else
 		{
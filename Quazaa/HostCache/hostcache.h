@@ -26,6 +26,7 @@
 #define HOSTCACHE_H
 
 #include <QMutex>
+#include <QAtomicInt>
 
 #include "hostcachehost.h"
 
@@ -36,6 +37,7 @@
 // 6 - Fixed Hosts having an early date and changed time storage from QDateTime to quint32.
 
 class QFile;
+class CSecuritySanityCheck;
 
 typedef QList<CHostCacheHost*>::iterator CHostCacheIterator;
 
@@ -50,6 +52,8 @@ public:
 	quint32                 m_nMaxCacheHosts;
 	QString                 m_sMessage;
 
+	QAtomicInt              m_nGeneration;  // bumped on every change to m_lHosts, readable without the lock
+
 public:
 	CHostCache();
 	~CHostCache();
@@ -83,11 +87,14 @@ public:
 
 	void pruneOldHosts(const quint32 tNow);
 	void pruneByQueryAck(const quint32 tNow);
+	void sanityCheck(const CSecuritySanityCheck& oRules);
 
 	static quint32 writeToFile(const void * const pManager, QFile& oFile);
 
 	inline quint32 count();
 	inline bool isEmpty();
+	inline int generation() const;
+	inline void changed();
 };
 
 CHostCacheHost* CHostCache::take(CEndPoint oHost)
@@ -111,6 +118,16 @@ bool CHostCache::isEmpty()
 	return !count();
 }
 
+int CHostCache::generation() const
+{
+	return m_nGeneration.loadAcquire();
+}
+
+void CHostCache::changed()
+{
+	m_nGeneration.fetchAndAddRelease( 1 );
+}
+
 extern CHostCache hostCache;
 
 #endif // HOSTCACHE_H
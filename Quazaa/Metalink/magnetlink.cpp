@@ -15,10 +15,6 @@ CMagnet::MagnetFile::MagnetFile() :
 
 CMagnet::MagnetFile::~MagnetFile()
 {
-	foreach( CHash* pHash, m_lHashes )
-	{
-		delete pHash;
-	}
 }
 
 bool CMagnet::MagnetFile::isValid() const
@@ -129,11 +125,11 @@ bool CMagnet::parseMagnet(QString sMagnet)
 			}
 			else if ( sParam.startsWith( "xt" ) )	// EXect Topic
 			{
-				CHash* pHash = CHash::fromURN( sSubsection );
+				CHash oHash = CHash::fromURN( sSubsection );
 
-				if ( pHash )
+				if ( !oHash.isNull() )
 				{
-					mFiles[nFileNo].m_lHashes.append( pHash );
+					mFiles[nFileNo].m_lHashes.append( oHash );
 				}
 				else
 				{
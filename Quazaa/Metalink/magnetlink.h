@@ -7,7 +7,6 @@
 
 #include "download.h"
 
-class CHash;
 
 namespace URI
 {
@@ -29,7 +28,7 @@ public:
 		bool			m_bNull;
 		quint64			m_nFileSize;
 		QString			m_sFileName;
-		QList<CHash*>	m_lHashes;		// Includes all hashes provided via <hash> tag.
+		QVector<CHash>	m_lHashes;		// Includes all hashes provided via <hash> tag.
 		QList<MediaURL>	m_lURLs;		// Includes http, https, ftp, ftps, etc.
 		QList<QUrl>		m_lTrackers;	// BitTorrent Trackers for this file
 
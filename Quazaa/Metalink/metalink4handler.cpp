@@ -117,11 +117,11 @@ bool CMetalink4Handler::parseFile(QList<MetaFile> &lFiles, quint16 ID)
 			{
 				QString urn = "urn:" + vAttributes.value( "type" ).toString().trimmed() + ":" +
 								  m_oMetaLink.readElementText();
-				CHash* pHash = CHash::fromURN( urn );
+				CHash oHash = CHash::fromURN( urn );
 
-				if ( pHash )
+				if ( !oHash.isNull() )
 				{
-					oCurrentFile.m_lHashes.append( pHash );
+					oCurrentFile.m_lHashes.append( oHash );
 				}
 				else
 				{
@@ -41,7 +41,7 @@ struct MetaFile
 	QString m_sVersion;
 	QString m_sLanguage;
 	QString m_sDescription;
-	QList<CHash*> m_lHashes; // Includes all hashes provided via <hash> tag.
+	QVector<CHash> m_lHashes; // Includes all hashes provided via <hash> tag.
 	QList<MediaURI> m_lURIs; // Includes web links, links to .torrent files, as well as Magnets.
 
 	MetaFile();
@@ -0,0 +1,201 @@
+/*
+** startupsequence.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "startupsequence.h"
+#include "systemlog.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "debug_new.h"
+
+// Runs a worker stage on the thread pool and reports back to the sequence on the main thread.
+class CStartupStageRunnable : public QRunnable
+{
+	CStartupSequence::Function  m_fnRun;
+	QObject*                    m_pSequence;
+	int                         m_nStage;
+
+public:
+	CStartupStageRunnable(const CStartupSequence::Function& fnRun, QObject* pSequence, int nStage) :
+		m_fnRun( fnRun ),
+		m_pSequence( pSequence ),
+		m_nStage( nStage )
+	{
+	}
+
+	void run()
+	{
+		QElapsedTimer oTimer;
+		oTimer.start();
+
+		m_fnRun();
+
+		QMetaObject::invokeMethod( m_pSequence, "onStageFinished", Qt::QueuedConnection,
+								   Q_ARG( int, m_nStage ), Q_ARG( qint64, oTimer.elapsed() ) );
+	}
+};
+
+CStartupSequence::CStartupSequence(QObject* parent) :
+	QObject( parent ),
+	m_nFinished( 0 )
+{
+}
+
+int CStartupSequence::add(const QString& sName, StageType nType, Function fnRun, const QList<int>& lDepends)
+{
+	Q_ASSERT( !m_oClock.isValid() );
+
+	Stage oStage;
+	oStage.sName     = sName;
+	oStage.nType     = nType;
+	oStage.fnRun     = fnRun;
+	oStage.nPending  = lDepends.size();
+	oStage.bStarted  = false;
+	oStage.tStart    = 0;
+	oStage.tDuration = -1;
+
+	const int nStage = m_lStages.size();
+	foreach ( int nDepend, lDepends )
+	{
+		Q_ASSERT( nDepend >= 0 && nDepend < nStage );
+		m_lStages[nDepend].lDependents.append( nStage );
+	}
+
+	m_lStages.append( oStage );
+	return nStage;
+}
+
+/**
+ * @brief run starts all stages without dependencies and returns. The remaining stages are started
+ * from the event loop as their dependencies finish; finished() is emitted after the last one.
+ */
+void CStartupSequence::run()
+{
+	m_oClock.start();
+	startReady();
+}
+
+/**
+ * @brief report lists the stages in the order they were started with their start time relative
+ * to run() and their duration.
+ * @return the report, one line per stage
+ */
+QString CStartupSequence::report() const
+{
+	QString sReport = tr( "Startup took %1 ms." ).arg( m_oClock.isValid() ? m_oClock.elapsed() : 0 );
+	foreach ( int i, m_lStarted )
+	{
+		const Stage& oStage = m_lStages[i];
+		sReport += QString( "\n%1: +%2 ms, %3 ms%4" ).arg( oStage.sName )
+												   .arg( oStage.tStart )
+												   .arg( oStage.tDuration )
+												   .arg( oStage.nType == Worker ? tr( " (worker thread)" ) : QString() );
+	}
+	return sReport;
+}
+
+void CStartupSequence::runStage(int nStage)
+{
+	QElapsedTimer oTimer;
+	oTimer.start();
+
+	m_lStages[nStage].fnRun();
+
+	onStageFinished( nStage, oTimer.elapsed() );
+}
+
+void CStartupSequence::onStageFinished(int nStage, qint64 tDuration)
+{
+	Stage& oStage = m_lStages[nStage];
+	oStage.tDuration = tDuration;
+	++m_nFinished;
+
+	foreach ( int nDependent, oStage.lDependents )
+	{
+		--m_lStages[nDependent].nPending;
+	}
+
+	emit stageFinished( oStage.sName );
+
+	if ( isFinished() )
+	{
+		systemLog.postLog( LogSeverity::Notice, report() );
+		emit finished();
+	}
+	else
+	{
+		startReady();
+	}
+}
+
+void CStartupSequence::startReady()
+{
+	bool bRunning = false;
+
+	for ( int i = 0; i < m_lStages.size(); ++i )
+	{
+		const Stage& oStage = m_lStages[i];
+		if ( oStage.bStarted )
+		{
+			bRunning |= oStage.tDuration < 0;
+		}
+		else if ( !oStage.nPending && oStage.nType != Deferred )
+		{
+			startStage( i );
+			bRunning = true;
+		}
+	}
+
+	// Nothing critical left: the deferred stages may go.
+	if ( !bRunning )
+	{
+		for ( int i = 0; i < m_lStages.size(); ++i )
+		{
+			if ( !m_lStages[i].bStarted && !m_lStages[i].nPending )
+			{
+				startStage( i );
+			}
+		}
+	}
+}
+
+void CStartupSequence::startStage(int nStage)
+{
+	Stage& oStage = m_lStages[nStage];
+	oStage.bStarted = true;
+	oStage.tStart = m_oClock.elapsed();
+	m_lStarted.append( nStage );
+
+	emit stageStarted( oStage.sName );
+
+	if ( oStage.nType == Worker )
+	{
+		QThreadPool::globalInstance()->start( new CStartupStageRunnable( oStage.fnRun, this, nStage ) );
+	}
+	else
+	{
+		QMetaObject::invokeMethod( this, "runStage", Qt::QueuedConnection, Q_ARG( int, nStage ) );
+	}
+}
@@ -0,0 +1,115 @@
+/*
+** startupsequence.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef STARTUPSEQUENCE_H
+#define STARTUPSEQUENCE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QList>
+#include <QVector>
+
+#include <functional>
+
+// Runs the startup stages as a dependency graph instead of one after another. A stage starts as
+// soon as all stages it depends on have finished: worker stages on the global thread pool, the
+// others on the main thread, each from its own event loop iteration so the GUI stays responsive.
+// Deferred stages wait until every other stage is done; use them for data nothing else needs
+// right away. Start time and duration of every stage are recorded and logged once all are done.
+class CStartupSequence : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum StageType
+	{
+		MainThread,
+		Worker,
+		Deferred        // main thread, after all other stages
+	};
+
+	typedef std::function<void()> Function;
+
+protected:
+	struct Stage
+	{
+		QString     sName;
+		StageType   nType;
+		Function    fnRun;
+		QList<int>  lDependents;    // stages waiting for this one
+		int         nPending;       // dependencies not finished yet
+		bool        bStarted;
+		qint64      tStart;         // ms since run()
+		qint64      tDuration;      // ms, -1 while running
+	};
+
+	QVector<Stage>  m_lStages;
+	QList<int>      m_lStarted;     // stage indexes in start order
+	QElapsedTimer   m_oClock;
+	int             m_nFinished;
+
+public:
+	explicit CStartupSequence(QObject* parent = 0);
+
+	// Dependencies are the return values of earlier add() calls.
+	int add(const QString& sName, StageType nType, Function fnRun, const QList<int>& lDepends = QList<int>());
+
+	void run();
+
+	inline int count() const;
+	inline int finishedCount() const;
+	inline bool isFinished() const;
+
+	QString report() const;
+
+signals:
+	void stageStarted(const QString& sName);
+	void stageFinished(const QString& sName);
+	void finished();
+
+protected slots:
+	void runStage(int nStage);
+	void onStageFinished(int nStage, qint64 tDuration);
+
+protected:
+	void startReady();
+	void startStage(int nStage);
+};
+
+int CStartupSequence::count() const
+{
+	return m_lStages.size();
+}
+
+int CStartupSequence::finishedCount() const
+{
+	return m_nFinished;
+}
+
+bool CStartupSequence::isFinished() const
+{
+	return m_nFinished == m_lStages.size();
+}
+
+#endif // STARTUPSEQUENCE_H
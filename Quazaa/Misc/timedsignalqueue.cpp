@@ -23,167 +23,31 @@
 */
 
 #include <QDebug>
+#include <QTimer>
 
 #include "timedsignalqueue.h"
 #include "types.h"
 #include "debug_new.h"
 
-CTimedSignalQueue signalQueue;
-
-/* ---------------------------------------------------------------------------------------------- */
-/* ---------------------------------------- CTimerObject ---------------------------------------- */
-/* ---------------------------------------------------------------------------------------------- */
-
-CTimerObject::CTimerObject(QObject* obj, const char* member, quint64 tInterval, bool bMultiShot,
-                           QGenericArgument val0, QGenericArgument val1,
-                           QGenericArgument val2, QGenericArgument val3,
-                           QGenericArgument val4, QGenericArgument val5,
-                           QGenericArgument val6, QGenericArgument val7,
-                           QGenericArgument val8, QGenericArgument val9) :
-    m_tInterval( tInterval ),
-    m_bMultiShot( bMultiShot )
-{
-	resetTime();
-
-	m_sSignal.obj = obj;
-
-	// Copy the c-string we have been given.
-	const size_t nLength = strlen( member );
-	char* sTmp = new char[nLength + 1];	// We need 1 extra char for the terminal \0.
-
-	// This is supposed to be safe as eventual changes to pTimerObject->
-	// m_sSignal.sName should originate from the same thread.
-#ifdef _MSC_VER
-	strcpy_s( sTmp, nLength + 1, member );
-#else
-	strcpy( sTmp, member );
-#endif
-
-	m_sSignal.sName = sTmp;
-
-	m_sSignal.val0 = val0;
-	m_sSignal.val1 = val1;
-	m_sSignal.val2 = val2;
-	m_sSignal.val3 = val3;
-	m_sSignal.val4 = val4;
-	m_sSignal.val5 = val5;
-	m_sSignal.val6 = val6;
-	m_sSignal.val7 = val7;
-	m_sSignal.val8 = val8;
-	m_sSignal.val9 = val9;
-
-	m_oUUID = QUuid::createUuid();
-}
-
-CTimerObject::CTimerObject(QObject* obj, const char* member, quint32 tSchedule,
-                           QGenericArgument val0, QGenericArgument val1,
-                           QGenericArgument val2, QGenericArgument val3,
-                           QGenericArgument val4, QGenericArgument val5,
-                           QGenericArgument val6, QGenericArgument val7,
-                           QGenericArgument val8, QGenericArgument val9) :
-    m_tInterval( 0 ),
-    m_bMultiShot( false )
-{
-	// Transform 32bit UTC time in seconds to 64bit relative time in ms.
-	m_tTime = (quint64)( tSchedule ) * 1000 - signalQueue.m_tTimerStartUTCInMSec;
-
-	m_sSignal.obj = obj;
-
-	// Copy the c-string we have been given.
-	const size_t nLength = strlen( member );
-	char* sTmp = new char[nLength + 1];	// We need 1 extra char for the terminal \0.
-
-	// This is supposed to be safe as eventual changes to pTimerObject->
-	// m_sSignal.sName should originate from the same thread.
-#ifdef _MSC_VER
-	strcpy_s( sTmp, nLength + 1, member );
-#else
-	strcpy( sTmp, member );
-#endif
-
-	m_sSignal.sName = sTmp;
-
-	m_sSignal.val0 = val0;
-	m_sSignal.val1 = val1;
-	m_sSignal.val2 = val2;
-	m_sSignal.val3 = val3;
-	m_sSignal.val4 = val4;
-	m_sSignal.val5 = val5;
-	m_sSignal.val6 = val6;
-	m_sSignal.val7 = val7;
-	m_sSignal.val8 = val8;
-	m_sSignal.val9 = val9;
-
-	m_oUUID = QUuid::createUuid();
-}
-
-CTimerObject::CTimerObject(const CTimerObject* const pTimerObject)
-{
-	m_tTime			= pTimerObject->m_tTime;
-	m_tInterval		= pTimerObject->m_tInterval;
-	m_bMultiShot	= pTimerObject->m_bMultiShot;
-
-	m_oUUID			= pTimerObject->m_oUUID;
-
-	m_sSignal.obj	= pTimerObject->m_sSignal.obj;
-
-	// Copy the c-string from pTimerObject
-	const size_t nLength = strlen( pTimerObject->m_sSignal.sName );
-	char* sTmp = new char[nLength + 1];				// We need 1 extra char for the terminal 0.
-
-	// This is supposed to be safe as eventual changes to pTimerObject->
-	// m_sSignal.sName should originate from the same thread.
-#ifdef _MSC_VER
-	strcpy_s( sTmp, nLength + 1, pTimerObject->m_sSignal.sName );
-#else
-	strcpy( sTmp, pTimerObject->m_sSignal.sName );
-#endif
-
-	m_sSignal.sName = sTmp;
-
-	m_sSignal.val0	= pTimerObject->m_sSignal.val0;
-	m_sSignal.val1	= pTimerObject->m_sSignal.val1;
-	m_sSignal.val2	= pTimerObject->m_sSignal.val2;
-	m_sSignal.val3	= pTimerObject->m_sSignal.val3;
-	m_sSignal.val4	= pTimerObject->m_sSignal.val4;
-	m_sSignal.val5	= pTimerObject->m_sSignal.val5;
-	m_sSignal.val6	= pTimerObject->m_sSignal.val6;
-	m_sSignal.val7	= pTimerObject->m_sSignal.val7;
-	m_sSignal.val8	= pTimerObject->m_sSignal.val8;
-	m_sSignal.val9	= pTimerObject->m_sSignal.val9;
-}
-
-CTimerObject::~CTimerObject()
-{
-	delete[] m_sSignal.sName;
-}
-
-void CTimerObject::resetTime()
-{
-	m_tTime = CTimedSignalQueue::getRelativeTimeInMs() + m_tInterval;
-}
+const quint64 TimerWheelTick = 100;        // ms per slot of the lowest wheel level
+const quint32 InvalidEntry   = 0xFFFFFFFF;
 
-bool CTimerObject::emitSignal() const
-{
-	return QMetaObject::invokeMethod( m_sSignal.obj, m_sSignal.sName, Qt::QueuedConnection,
-	                                  m_sSignal.val0, m_sSignal.val1, m_sSignal.val2,
-	                                  m_sSignal.val3, m_sSignal.val4, m_sSignal.val5,
-	                                  m_sSignal.val6, m_sSignal.val7, m_sSignal.val8,
-	                                  m_sSignal.val9 );
-}
-
-
-/* ---------------------------------------------------------------------------------------------- */
-/* ------------------------------------- CTimedSignalQueue -------------------------------------- */
-/* ---------------------------------------------------------------------------------------------- */
+CTimedSignalQueue signalQueue;
 
 QElapsedTimer CTimedSignalQueue::m_oTime;
 quint64       CTimedSignalQueue::m_tTimerStartUTCInMSec = 0;
 
 CTimedSignalQueue::CTimedSignalQueue(QObject *parent) :
     QObject( parent ),
-    m_nPrecision( 1000 )
+    m_nPrecision( 1000 ),
+    m_nFreeEntry( InvalidEntry ),
+    m_tCurrentTick( 0 ),
+    m_nPending( 0 )
 {
+	for ( int i = 0; i < WheelLevels * WheelSlots; ++i )
+	{
+		m_lWheel[i] = InvalidEntry;
+	}
 }
 
 CTimedSignalQueue::~CTimedSignalQueue()
@@ -223,10 +87,18 @@ void CTimedSignalQueue::clear()
 {
 	QMutexLocker l( &m_pSection );
 
-	for ( TSignalQueueIterator i = m_QueuedSignals.begin(); i != m_QueuedSignals.end(); )
+	for ( int i = 0; i < WheelLevels * WheelSlots; ++i )
 	{
-		delete i.value();
-		i = m_QueuedSignals.erase(i);
+		m_lWheel[i] = InvalidEntry;
+	}
+
+	for ( quint32 nEntry = 0; nEntry < (quint32)m_lEntries.size(); ++nEntry )
+	{
+		if ( m_lEntries[nEntry].nSlot != -1 )
+		{
+			m_lEntries[nEntry].nSlot = -1;
+			release( nEntry );
+		}
 	}
 }
 
@@ -241,6 +113,13 @@ void CTimedSignalQueue::setPrecision( quint64 tInterval )
 	}
 }
 
+int CTimedSignalQueue::count()
+{
+	QMutexLocker l( &m_pSection );
+
+	return m_nPending;
+}
+
 void CTimedSignalQueue::timerEvent(QTimerEvent* event)
 {
 	if ( event->timerId() == m_oTimer.timerId() )
@@ -258,28 +137,39 @@ void CTimedSignalQueue::checkSchedule()
 	// don't block too long waiting for a lock...
 	if ( m_pSection.tryLock( m_nPrecision / 2 ) )
 	{
-		const quint64 tRelativeTimeMs = getRelativeTimeInMs();
+		const quint64 tNowTick = getRelativeTimeInMs() / TimerWheelTick;
 
-		for ( TSignalQueueIterator i = m_QueuedSignals.begin(); i != m_QueuedSignals.end(); )
+		if ( !m_nPending )
 		{
-			if ( i.key() > tRelativeTimeMs )
-				break;
-
-			CTimerObject* pObj = i.value();
-			i = m_QueuedSignals.erase(i);
+			m_tCurrentTick = tNowTick + 1;
+		}
 
-			bool bSuccess = pObj->emitSignal();
+		while ( m_tCurrentTick <= tNowTick )
+		{
+			const int nSlot = int( m_tCurrentTick & WheelMask );
 
-			if ( bSuccess && pObj->m_bMultiShot )
+			// Entering a new round of a level: move the timers of the matching slot of the next
+			// level down to where they belong now.
+			for ( int nLevel = 1; nLevel < WheelLevels; ++nLevel )
 			{
-				pObj->resetTime();
-				m_QueuedSignals.insert( pObj->m_tTime, pObj );
+				if ( m_tCurrentTick & ( ( Q_UINT64_C( 1 ) << ( WheelBits * nLevel ) ) - 1 ) )
+					break;
+
+				cascade( nLevel, int( ( m_tCurrentTick >> ( WheelBits * nLevel ) ) & WheelMask ) );
 			}
-			else
+
+			quint32 nEntry = m_lWheel[nSlot];
+			m_lWheel[nSlot] = InvalidEntry;
+
+			// Timers rescheduled from here on go to the next tick at the earliest.
+			++m_tCurrentTick;
+
+			while ( nEntry != InvalidEntry )
 			{
-				qDebug() << "Error in CTimedSignalQueue::checkSchedule(): Unable invoke method! "
-				         << pObj->m_sSignal.sName;
-				delete pObj;
+				const quint32 nNext = m_lEntries[nEntry].nNext;
+				m_lEntries[nEntry].nSlot = -1;
+				expire( nEntry );
+				nEntry = nNext;
 			}
 		}
 
@@ -291,36 +181,28 @@ void CTimedSignalQueue::checkSchedule()
 	}
 }
 
-QUuid CTimedSignalQueue::push(QObject* parent, const char* signal,
-                              quint64 tInterval, bool bMultiShot,
-                              QGenericArgument val0, QGenericArgument val1,
-                              QGenericArgument val2, QGenericArgument val3,
-                              QGenericArgument val4, QGenericArgument val5,
-                              QGenericArgument val6, QGenericArgument val7,
-                              QGenericArgument val8, QGenericArgument val9)
+TTimerID CTimedSignalQueue::push(QObject* parent, const char* signal, quint64 tInterval, bool bMultiShot)
 {
-	return push( new CTimerObject( parent, signal, tInterval, bMultiShot,
-	                               val0, val1, val2, val3, val4, val5, val6, val7, val8, val9 ) );
+	return add( parent, std::function<void()>(), signal,
+				getRelativeTimeInMs() + tInterval, tInterval, bMultiShot );
 }
 
-QUuid CTimedSignalQueue::push(QObject* parent, const char* signal, quint32 tSchedule,
-                              QGenericArgument val0, QGenericArgument val1,
-                              QGenericArgument val2, QGenericArgument val3,
-                              QGenericArgument val4, QGenericArgument val5,
-                              QGenericArgument val6, QGenericArgument val7,
-                              QGenericArgument val8, QGenericArgument val9)
+TTimerID CTimedSignalQueue::push(QObject* parent, const char* signal, quint32 tSchedule)
 {
-	return push( new CTimerObject( parent, signal, tSchedule,
-	                               val0, val1, val2, val3, val4, val5, val6, val7, val8, val9 ) );
+	return add( parent, std::function<void()>(), signal,
+				utcToRelativeTimeInMs( tSchedule ), 0, false );
 }
 
-QUuid CTimedSignalQueue::push(CTimerObject* pTimedSignal)
+TTimerID CTimedSignalQueue::pushCall(QObject* pContext, const std::function<void()>& fnCall,
+									 quint64 tInterval, bool bMultiShot)
 {
-	QMutexLocker l( &m_pSection );
-
-	m_QueuedSignals.insert( pTimedSignal->m_tTime, pTimedSignal );
+	return add( pContext, fnCall, NULL, getRelativeTimeInMs() + tInterval, tInterval, bMultiShot );
+}
 
-	return pTimedSignal->m_oUUID;
+TTimerID CTimedSignalQueue::pushCallAt(QObject* pContext, const std::function<void()>& fnCall,
+									   quint32 tSchedule)
+{
+	return add( pContext, fnCall, NULL, utcToRelativeTimeInMs( tSchedule ), 0, false );
 }
 
 bool CTimedSignalQueue::pop(const QObject* parent, const char* signal)
@@ -328,85 +210,258 @@ bool CTimedSignalQueue::pop(const QObject* parent, const char* signal)
 	if ( !parent )
 		return false;
 
+	const QByteArray sMember = normalizedMember( signal );
 	bool bFound = false;
-	QString sSignalName = "";
-
-	if ( signal )
-		sSignalName = signal;
 
 	QMutexLocker l( &m_pSection );
 
-	for ( TSignalQueueIterator iQueue = m_QueuedSignals.begin(); iQueue != m_QueuedSignals.end(); )
+	const QList<quint32> lEntries = m_lByContext.values( parent );
+	foreach ( quint32 nEntry, lEntries )
 	{
-		if ( iQueue.value()->m_sSignal.obj == parent &&
-		     ( !signal || sSignalName == iQueue.value()->m_sSignal.sName ) )
+		if ( !signal || m_lEntries[nEntry].sMember == sMember )
 		{
-			delete iQueue.value();
-			iQueue = m_QueuedSignals.erase( iQueue );
+			unlink( nEntry );
+			release( nEntry );
 			bFound = true;
 		}
-		else
-		{
-			++iQueue;
-		}
 	}
 
 	return bFound;
 }
 
-bool CTimedSignalQueue::pop(QUuid oTimer_ID)
+bool CTimedSignalQueue::pop(TTimerID nTimerID)
 {
 	QMutexLocker l( &m_pSection );
 
-	CTimerObject* pTimer = popInternal( oTimer_ID );
+	const quint32 nEntry = entryIndex( nTimerID );
 
-	if ( pTimer )
+	if ( nEntry != InvalidEntry )
 	{
-		delete pTimer;
+		unlink( nEntry );
+		release( nEntry );
 		return true;
 	}
 
 	return false;
 }
 
-bool CTimedSignalQueue::setInterval(QUuid oTimer_ID, quint64 tInterval)
+bool CTimedSignalQueue::setInterval(TTimerID nTimerID, quint64 tInterval)
 {
 	QMutexLocker l( &m_pSection );
 
-	CTimerObject* pTimer = popInternal( oTimer_ID );
+	const quint32 nEntry = entryIndex( nTimerID );
 
-	if ( pTimer )
+	if ( nEntry != InvalidEntry )
 	{
-		pTimer->m_tInterval = tInterval;
-		pTimer->resetTime();
+		unlink( nEntry );
 
-		l.unlock();
+		CTimerEntry& oEntry = m_lEntries[nEntry];
+		oEntry.tInterval = tInterval;
+		oEntry.tExpire   = getRelativeTimeInMs() + tInterval;
 
-		push( pTimer );
+		link( nEntry );
 		return true;
 	}
 
 	return false;
 }
 
-CTimerObject* CTimedSignalQueue::popInternal(QUuid oTimer_ID)
+quint64 CTimedSignalQueue::utcToRelativeTimeInMs(quint32 tSchedule)
+{
+	// make sure m_tTimerStartUTCInMSec has been initialized
+	getRelativeTimeInMs();
+
+	// Transform 32bit UTC time in seconds to 64bit relative time in ms. Times in the past are due now.
+	const quint64 tScheduleMs = (quint64)( tSchedule ) * 1000;
+	return tScheduleMs > m_tTimerStartUTCInMSec ? tScheduleMs - m_tTimerStartUTCInMSec : 0;
+}
+
+/**
+ * @brief normalizedMember strips the code and the argument list SLOT() and SIGNAL() add to a method
+ * name, as QMetaObject::invokeMethod() expects the bare name.
+ */
+QByteArray CTimedSignalQueue::normalizedMember(const char* sMember)
+{
+	QByteArray sName( sMember );
+
+	if ( !sName.isEmpty() && sName.at( 0 ) >= '0' && sName.at( 0 ) <= '2' )
+		sName.remove( 0, 1 );
+
+	const int nArguments = sName.indexOf( '(' );
+	if ( nArguments != -1 )
+		sName.truncate( nArguments );
+
+	return sName;
+}
+
+TTimerID CTimedSignalQueue::add(QObject* pContext, const std::function<void()>& fnCall,
+								const char* sMember, quint64 tExpire, quint64 tInterval,
+								bool bMultiShot)
+{
+	Q_ASSERT( pContext );
+	Q_ASSERT( sMember || fnCall );
+
+	QMutexLocker l( &m_pSection );
+
+	quint32 nEntry = m_nFreeEntry;
+	if ( nEntry != InvalidEntry )
+	{
+		m_nFreeEntry = m_lEntries[nEntry].nNext;
+	}
+	else
+	{
+		nEntry = m_lEntries.size();
+		m_lEntries.resize( nEntry + 1 );
+		m_lEntries[nEntry].nGeneration = 1;
+	}
+
+	CTimerEntry& oEntry = m_lEntries[nEntry];
+	oEntry.fnCall     = fnCall;
+	oEntry.sMember    = sMember ? normalizedMember( sMember ) : QByteArray();
+	oEntry.pContext   = pContext;
+	oEntry.pOwner     = pContext;
+	oEntry.tExpire    = tExpire;
+	oEntry.tInterval  = tInterval;
+	oEntry.bMultiShot = bMultiShot;
+
+	link( nEntry );
+	m_lByContext.insert( pContext, nEntry );
+	++m_nPending;
+
+	return ( (TTimerID)oEntry.nGeneration << 32 ) | nEntry;
+}
+
+quint32 CTimedSignalQueue::entryIndex(TTimerID nTimerID) const
 {
-	CTimerObject* pTimer;
+	const quint32 nEntry = quint32( nTimerID );
+
+	if ( nEntry >= (quint32)m_lEntries.size() )
+		return InvalidEntry;
+
+	const CTimerEntry& oEntry = m_lEntries[nEntry];
+	if ( oEntry.nSlot == -1 || oEntry.nGeneration != quint32( nTimerID >> 32 ) )
+		return InvalidEntry;
+
+	return nEntry;
+}
+
+void CTimedSignalQueue::link(quint32 nEntry)
+{
+	CTimerEntry& oEntry = m_lEntries[nEntry];
+
+	quint64 tTick = oEntry.tExpire / TimerWheelTick;
+	if ( tTick < m_tCurrentTick )
+		tTick = m_tCurrentTick;
+
+	// pick the lowest level whose range covers the delay; beyond the top level's range the timer
+	// is parked in its last slot and placed again when that slot is cascaded
+	const quint64 nMaxDelta = ( Q_UINT64_C( 1 ) << ( WheelBits * WheelLevels ) ) - 1;
+	if ( tTick - m_tCurrentTick > nMaxDelta )
+		tTick = m_tCurrentTick + nMaxDelta;
+
+	const quint64 nDelta = tTick - m_tCurrentTick;
+	int nLevel = 0;
+	while ( nLevel < WheelLevels - 1 && nDelta >> ( WheelBits * ( nLevel + 1 ) ) )
+		++nLevel;
+
+	const int nSlot = nLevel * WheelSlots + int( ( tTick >> ( WheelBits * nLevel ) ) & WheelMask );
+
+	oEntry.nSlot = nSlot;
+	oEntry.nPrev = InvalidEntry;
+	oEntry.nNext = m_lWheel[nSlot];
+
+	if ( oEntry.nNext != InvalidEntry )
+		m_lEntries[oEntry.nNext].nPrev = nEntry;
+
+	m_lWheel[nSlot] = nEntry;
+}
+
+void CTimedSignalQueue::unlink(quint32 nEntry)
+{
+	CTimerEntry& oEntry = m_lEntries[nEntry];
+
+	Q_ASSERT( oEntry.nSlot != -1 );
+
+	if ( oEntry.nPrev != InvalidEntry )
+		m_lEntries[oEntry.nPrev].nNext = oEntry.nNext;
+	else
+		m_lWheel[oEntry.nSlot] = oEntry.nNext;
 
-	for ( TSignalQueueIterator iQueue = m_QueuedSignals.begin(); iQueue != m_QueuedSignals.end(); )
+	if ( oEntry.nNext != InvalidEntry )
+		m_lEntries[oEntry.nNext].nPrev = oEntry.nPrev;
+
+	oEntry.nSlot = -1;
+}
+
+void CTimedSignalQueue::release(quint32 nEntry)
+{
+	CTimerEntry& oEntry = m_lEntries[nEntry];
+
+	m_lByContext.remove( oEntry.pOwner, nEntry );
+
+	oEntry.fnCall = std::function<void()>();
+	oEntry.sMember.clear();
+	oEntry.pContext.clear();
+	oEntry.pOwner = NULL;
+
+	// invalidate outstanding IDs
+	if ( !++oEntry.nGeneration )
+		oEntry.nGeneration = 1;
+
+	oEntry.nNext = m_nFreeEntry;
+	m_nFreeEntry = nEntry;
+
+	--m_nPending;
+}
+
+void CTimedSignalQueue::cascade(int nLevel, int nSlot)
+{
+	nSlot += nLevel * WheelSlots;
+
+	quint32 nEntry = m_lWheel[nSlot];
+	m_lWheel[nSlot] = InvalidEntry;
+
+	while ( nEntry != InvalidEntry )
+	{
+		const quint32 nNext = m_lEntries[nEntry].nNext;
+		link( nEntry );
+		nEntry = nNext;
+	}
+}
+
+void CTimedSignalQueue::expire(quint32 nEntry)
+{
+	CTimerEntry& oEntry = m_lEntries[nEntry];
+
+	bool bSuccess = false;
+
+	if ( oEntry.pContext )
 	{
-		pTimer = iQueue.value();
-		if ( pTimer->m_oUUID == oTimer_ID )
+		if ( oEntry.sMember.isEmpty() )
 		{
-			m_QueuedSignals.erase( iQueue );
-			return pTimer;
+			// runs the callable in the context object's thread
+			QTimer::singleShot( 0, oEntry.pContext.data(), oEntry.fnCall );
+			bSuccess = true;
 		}
 		else
 		{
-			++iQueue;
+			bSuccess = QMetaObject::invokeMethod( oEntry.pContext.data(), oEntry.sMember.constData(),
+												  Qt::QueuedConnection );
+			if ( !bSuccess )
+			{
+				qDebug() << "Error in CTimedSignalQueue::checkSchedule(): Unable invoke method! "
+						 << oEntry.sMember;
+			}
 		}
 	}
 
-	return NULL;
+	if ( bSuccess && oEntry.bMultiShot )
+	{
+		oEntry.tExpire = getRelativeTimeInMs() + oEntry.tInterval;
+		link( nEntry );
+	}
+	else
+	{
+		release( nEntry );
+	}
 }
-
@@ -5,79 +5,54 @@
 #include <QBasicTimer>
 #include <QTimerEvent>
 #include <QDateTime>
-#include <QMultiMap>
+#include <QMultiHash>
+#include <QPointer>
+#include <QVector>
 #include <QMutex>
-#include <QUuid>
 
-class CTimedSignalQueue;
-
-/* ---------------------------------------------------------------------------------------------- */
-/* ---------------------------------------- CTimerObject ---------------------------------------- */
-/* ---------------------------------------------------------------------------------------------- */
-/**
- * @brief The CTimerObject class is a helper class that allows to store signals and related relevant
- * information, as well as to emit the signals at a given time.
- */
-class CTimerObject
-{
-private:
-	struct
-	{
-		QObject* obj;
-		const char* sName;
-		QGenericArgument val0;
-		QGenericArgument val1;
-		QGenericArgument val2;
-		QGenericArgument val3;
-		QGenericArgument val4;
-		QGenericArgument val5;
-		QGenericArgument val6;
-		QGenericArgument val7;
-		QGenericArgument val8;
-		QGenericArgument val9;
-	} m_sSignal; // String based Qt4 signal
-
-	QUuid   m_oUUID;
-	quint64 m_tTime;      // relative time in ms as provided by getRelativeTimeInMs()
-	quint64 m_tInterval;  // repetition interval in ms
-	bool    m_bMultiShot; // repeat after m_tInterval yes/no
+#include <functional>
 
-private:
-	CTimerObject(QObject* obj, const char* member, quint64 tInterval, bool bMultiShot,
-				 QGenericArgument val0 = QGenericArgument(), QGenericArgument val1 = QGenericArgument(),
-				 QGenericArgument val2 = QGenericArgument(), QGenericArgument val3 = QGenericArgument(),
-				 QGenericArgument val4 = QGenericArgument(), QGenericArgument val5 = QGenericArgument(),
-				 QGenericArgument val6 = QGenericArgument(), QGenericArgument val7 = QGenericArgument(),
-				 QGenericArgument val8 = QGenericArgument(), QGenericArgument val9 = QGenericArgument());
-
-	CTimerObject(QObject* obj, const char* member, quint32 tSchedule,
-				 QGenericArgument val0 = QGenericArgument(), QGenericArgument val1 = QGenericArgument(),
-				 QGenericArgument val2 = QGenericArgument(), QGenericArgument val3 = QGenericArgument(),
-				 QGenericArgument val4 = QGenericArgument(), QGenericArgument val5 = QGenericArgument(),
-				 QGenericArgument val6 = QGenericArgument(), QGenericArgument val7 = QGenericArgument(),
-				 QGenericArgument val8 = QGenericArgument(), QGenericArgument val9 = QGenericArgument());
-
-	CTimerObject(const CTimerObject* const pTimerObject);
-
-	~CTimerObject();
-
-	void resetTime();
-	bool emitSignal() const;
+class CTimedSignalQueue;
 
-	friend class CTimedSignalQueue;
-};
+// Handle of a scheduled call: low 32 bits index the timer, high 32 bits tell apart successive users
+// of that index. 0 is never a valid handle.
+typedef quint64 TTimerID;
 
 /* ---------------------------------------------------------------------------------------------- */
 /* -------------------------------------- CTimedSignalQueue ------------------------------------- */
 /* ---------------------------------------------------------------------------------------------- */
+/**
+ * @brief The CTimedSignalQueue class invokes slots or callables at a given time or in a given
+ * interval. Scheduled calls are kept in a hierarchical timer wheel, which makes scheduling and
+ * cancelling by ID O(1) regardless of the number of pending calls.
+ */
 class CTimedSignalQueue : public QObject
 {
 	Q_OBJECT
 
 private:
-	// Key: The relative time as provided by getRelativeTimeInMs()
-	typedef QMultiMap<quint64, CTimerObject*>           TSignalQueue;
-	typedef QMultiMap<quint64, CTimerObject*>::iterator TSignalQueueIterator;
+	enum
+	{
+		WheelLevels = 4,
+		WheelBits   = 8,
+		WheelSlots  = 1 << WheelBits,
+		WheelMask   = WheelSlots - 1
+	};
+
+	struct CTimerEntry
+	{
+		std::function<void()> fnCall;      // type safe payload, or...
+		QByteArray            sMember;     // ...name of a slot/invokable method of pContext
+		QPointer<QObject>     pContext;    // the call is dropped once this is gone
+		const QObject*        pOwner;      // key in m_lByContext, survives pContext
+		quint64               tExpire;     // relative time in ms as provided by getRelativeTimeInMs()
+		quint64               tInterval;   // repetition interval in ms
+		quint32               nGeneration;
+		quint32               nPrev;       // neighbours in the wheel slot (or free list)
+		quint32               nNext;
+		int                   nSlot;       // index into m_lWheel, -1 if not scheduled
+		bool                  bMultiShot;  // repeat after tInterval yes/no
+	};
 
 	static QElapsedTimer m_oTime;                // the relative time since the timer was started
 	static quint64       m_tTimerStartUTCInMSec; // ms since 1970-01-01T00:00:00 UTC (timer start)
@@ -85,7 +60,14 @@ private:
 	QBasicTimer			m_oTimer;                // for timer events
 	QMutex				m_pSection;
 	quint64				m_nPrecision;            // the interval in ms between two timer events
-	TSignalQueue		m_QueuedSignals;         // the queued signals
+
+	QVector<CTimerEntry> m_lEntries;             // timer storage, indexed by the low half of a TTimerID
+	quint32				m_nFreeEntry;            // head of the free list
+	quint32				m_lWheel[WheelLevels * WheelSlots]; // slot list heads
+	quint64				m_tCurrentTick;          // next tick to be processed
+	int					m_nPending;
+
+	QMultiHash<const QObject*, quint32> m_lByContext; // for pop(parent, signal)
 
 	// Before deleting the timed signal queue object, this lock is aquired. If you have other global
 	// objects depending on this component, you can aquire this lock to prevent deletion until
@@ -111,6 +93,30 @@ public:
 	// Sets the interval used by the queue to check for new signals to be scheduled. This defaults to 1000ms.
 	void setPrecision(quint64 tInterval = 1000);
 
+	// Number of scheduled items.
+	int count();
+
+	// Schedules pObject->pMember() to be invoked in pObject's thread after tInterval milliseconds.
+	// If bMultiShot is set to true, it is invoked in the given interval until it is popped or pObject
+	// is destroyed.
+	template<class T>
+	TTimerID push(T* pObject, void (T::*pMember)(), quint64 tInterval, bool bMultiShot)
+	{
+		return pushCall( pObject, std::bind( pMember, pObject ), tInterval, bMultiShot );
+	}
+
+	// Schedules pObject->pMember() to be invoked once at a given schedule time tSchedule (UTC).
+	template<class T>
+	TTimerID push(T* pObject, void (T::*pMember)(), quint32 tSchedule)
+	{
+		return pushCallAt( pObject, std::bind( pMember, pObject ), tSchedule );
+	}
+
+	// As above for any callable without arguments, e.g. a lambda or the result of std::bind().
+	// The callable is invoked in pContext's thread and dropped once pContext is destroyed.
+	TTimerID pushCall(QObject* pContext, const std::function<void()>& fnCall, quint64 tInterval, bool bMultiShot);
+	TTimerID pushCallAt(QObject* pContext, const std::function<void()>& fnCall, quint32 tSchedule);
+
 protected:
 	void timerEvent(QTimerEvent* event);
 
@@ -125,46 +131,41 @@ private:
 
 		return m_oTime.elapsed();
 	}
-	QUuid push(CTimerObject* pTimedSignal);
+	static quint64 utcToRelativeTimeInMs(quint32 tSchedule);
+	static QByteArray normalizedMember(const char* sMember);
+
+	TTimerID add(QObject* pContext, const std::function<void()>& fnCall, const char* sMember,
+				 quint64 tExpire, quint64 tInterval, bool bMultiShot);
+	quint32 entryIndex(TTimerID nID) const;
+	void link(quint32 nEntry);
+	void unlink(quint32 nEntry);
+	void release(quint32 nEntry);
+	void cascade(int nLevel, int nSlot);
+	void expire(quint32 nEntry);
 
 public slots:
 	// Allows to manually check for new scheduled items in the queue.
 	void checkSchedule();
 
-	// This schedules a signal or slot to be invoqued after an interval of tInterval milliseconds.
+	// This schedules a slot to be invoqued after an interval of tInterval milliseconds.
 	// If multiShot is set to true, the slot will be invoqued in the given interval until the signal queue
 	// recieves a pop() request for the signal or the given parent turns invalid.
-	QUuid push(QObject* parent, const char* signal, quint64 tInterval, bool multiShot,
-			   QGenericArgument val0 = QGenericArgument(), QGenericArgument val1 = QGenericArgument(),
-			   QGenericArgument val2 = QGenericArgument(), QGenericArgument val3 = QGenericArgument(),
-			   QGenericArgument val4 = QGenericArgument(), QGenericArgument val5 = QGenericArgument(),
-			   QGenericArgument val6 = QGenericArgument(), QGenericArgument val7 = QGenericArgument(),
-			   QGenericArgument val8 = QGenericArgument(), QGenericArgument val9 = QGenericArgument());
-
-	// This schedules a signal to be invoqued once at a given schedule time tSchedule (UTC).
-	QUuid push(QObject* parent, const char* signal, quint32 tSchedule,
-			   QGenericArgument val0 = QGenericArgument(), QGenericArgument val1 = QGenericArgument(),
-			   QGenericArgument val2 = QGenericArgument(), QGenericArgument val3 = QGenericArgument(),
-			   QGenericArgument val4 = QGenericArgument(), QGenericArgument val5 = QGenericArgument(),
-			   QGenericArgument val6 = QGenericArgument(), QGenericArgument val7 = QGenericArgument(),
-			   QGenericArgument val8 = QGenericArgument(), QGenericArgument val9 = QGenericArgument());
+	TTimerID push(QObject* parent, const char* signal, quint64 tInterval, bool multiShot);
+
+	// This schedules a slot to be invoqued once at a given schedule time tSchedule (UTC).
+	TTimerID push(QObject* parent, const char* signal, quint32 tSchedule);
 
 	// Removes all scheduled combinations of a given parent and signal/slot from the queue.
 	// If no signal/slot is specified, all entries for the given parent are removed.
 	bool pop(const QObject* parent, const char* signal = NULL);
 
-	// Removes a scheduled parent + signal/slot combination by its UUID.
-	bool pop(QUuid oTimer_ID);
-
-	// Sets the interval time of a given parent + signal/slot combination to tInterval. After this call,
-	// the next schedule time of that combination is in tInterval milliseconds, no matter the timing state
-	// of the previously scheduled combination.
-	bool setInterval(QUuid oTimer_ID, quint64 tInterval);
-
-private:
-	CTimerObject* popInternal(QUuid oTimer_ID);
+	// Removes a scheduled item by its ID.
+	bool pop(TTimerID nTimerID);
 
-	friend class CTimerObject;
+	// Sets the interval time of a given scheduled item to tInterval. After this call, the next
+	// schedule time of that item is in tInterval milliseconds, no matter the timing state
+	// of the previously scheduled item.
+	bool setInterval(TTimerID nTimerID, quint64 tInterval);
 };
 
 extern CTimedSignalQueue signalQueue;
@@ -287,6 +287,10 @@ void CDiscoveryTableModel::Service::refreshServiceIcon(CDiscoveryTableModel* mod
 	}
 		break;
 
+	case Discovery::stUKHL:
+		m_piType = model->m_pIcons[BOOTSTRAP];
+		break;
+
 	default:
 		Q_ASSERT( false );
 	}
@@ -23,13 +23,12 @@
 */
 
 #include "searchtreemodel.h"
-#include <QFileInfo>
 #include "systemlog.h"
-#include "geoiplist.h"
 #include "commonfunctions.h"
 #include "Hashes/hash.h"
 #include "fileiconprovider.h"
 #include "networkiconprovider.h"
+#include "securitymanager.h"
 
 #include "debug_new.h"
 
@@ -51,6 +50,9 @@ SearchTreeModel::SearchTreeModel() :
 				 << "Country";
 	rootItem = new SearchTreeItem( rootItemData );
 	nFileCount = 0;
+
+	// queued: the Security Manager emits while holding its own lock
+	connect( &securityManager, SIGNAL( performSanityCheck() ), this, SLOT( sanityCheck() ), Qt::QueuedConnection );
 }
 
 SearchTreeModel::~SearchTreeModel()
@@ -89,12 +91,98 @@ void SearchTreeModel::removeQueryHit(int position, const QModelIndex &parent)
 	}
 
 	if(parentItem) {
+		SearchTreeItem *item = parentItem->child(position);
+		if(!item)
+			return;
+
+		if(parentItem == rootItem) {
+			m_lFiles.remove(item->HitData.nFileId);
+		}
+
 		beginRemoveRows(parent, position, position);
 		parentItem->removeChild(position);
 		endRemoveRows();
+
+		if(parentItem == rootItem) {
+			nFileCount = rootItem->childCount();
+		} else {
+			parentItem->updateHitCount(parentItem->childCount());
+		}
 	}
 }
 
+void SearchTreeModel::setQueryWords(const QStringList& lQueryWords)
+{
+	m_lQueryWords = lQueryWords;
+}
+
+// Removes the hits banned by the rules added since the last sanity check, and the files left
+// without any hit. The hits are checked on worker threads while the view waits.
+void SearchTreeModel::sanityCheck()
+{
+	QSharedPointer<const CSecuritySanityCheck> pRules = securityManager.newRules();
+
+	if ( pRules && rootItem->childCount() )
+	{
+		QList<QueryHitSharedPtr> lHits;
+		QList<SearchTreeItem*>   lItems;
+
+		for ( int nFile = 0; nFile < rootItem->childCount(); ++nFile )
+		{
+			SearchTreeItem* pFileItem = rootItem->child( nFile );
+
+			for ( int nHit = 0; nHit < pFileItem->childCount(); ++nHit )
+			{
+				SearchTreeItem* pHitItem = pFileItem->child( nHit );
+
+				if ( pHitItem->HitData.pQueryHit )
+				{
+					lHits.append( pHitItem->HitData.pQueryHit );
+					lItems.append( pHitItem );
+				}
+			}
+		}
+
+		QList<int> lDenied = pRules->denied( lHits, m_lQueryWords );
+
+		// items were collected in row order, so walking backwards keeps the remaining rows valid
+		QList<SearchTreeItem*> lEmptied;
+		for ( int i = lDenied.size() - 1; i >= 0; --i )
+		{
+			SearchTreeItem* pHitItem  = lItems.at( lDenied.at( i ) );
+			SearchTreeItem* pFileItem = pHitItem->parent();
+
+			removeQueryHit( pHitItem->row(), createIndex( pFileItem->row(), 0, pFileItem ) );
+
+			if ( !pFileItem->childCount() )
+			{
+				if ( lEmptied.isEmpty() || lEmptied.last() != pFileItem )
+				{
+					lEmptied.append( pFileItem );
+				}
+			}
+			else
+			{
+				QModelIndex idxCount = createIndex( pFileItem->row(), 5, pFileItem );
+				emit dataChanged( idxCount, idxCount );
+			}
+		}
+
+		// lEmptied is in descending row order as well
+		foreach ( SearchTreeItem* pFileItem, lEmptied )
+		{
+			removeQueryHit( pFileItem->row(), QModelIndex() );
+		}
+
+		if ( !lDenied.isEmpty() )
+		{
+			emit updateStats();
+		}
+	}
+
+	securityManager.sanityCheckPerformed();
+}
+
 int SearchTreeModel::columnCount(const QModelIndex& parent) const
 {
 	if ( parent.isValid() )
@@ -290,6 +378,8 @@ void SearchTreeModel::setupModelData(const QStringList& lines, SearchTreeItem* p
 
 void SearchTreeModel::clear()
 {
+	m_lFiles.clear();
+
 	beginRemoveRows( QModelIndex(), 0, rootItem->childCount() );
 	//qDebug() << "clearSearch passing to rootItem";
 	rootItem->clearChildren();
@@ -300,126 +390,158 @@ void SearchTreeModel::clear()
 	emit dataChanged( idx1, idx2 );
 }
 
-void SearchTreeModel::addQueryHit(QueryHitSharedPtr pHitPtr)
+void SearchTreeModel::addResults(SearchResultBatch lResults)
 {
-	CQueryHit* pHit = pHitPtr.data();
+	if ( lResults.isEmpty() )
+	{
+		return;
+	}
 
-	while ( pHit )
+	QList<SearchTreeItem*> lNewFiles;
+	QList<SearchTreeItem*> lUpdatedFiles;
+	QHash<SearchTreeItem*, QList<SearchTreeItem*> > lNewSources;
+
+	// Results have already been filtered and deduplicated by CSearchResults, only grouping is left.
+	foreach ( const SearchResultEntry& oResult, lResults )
 	{
-		int existingFileEntry = -1;
+		SearchTreeItem* pFileItem = m_lFiles.value( oResult.nFileId, NULL );
 
-		// Check for duplicate file.
-		foreach ( CHash pHash, pHit->m_lHashes )
+		if ( !pFileItem )
 		{
-			existingFileEntry = rootItem->find( pHash );
-			if ( existingFileEntry != -1 )
-				break;
+			// new file, or a file the user removed earlier
+			pFileItem = createFileItem( oResult );
+			m_lFiles.insert( oResult.nFileId, pFileItem );
+			lNewFiles.append( pFileItem );
+		}
+		else
+		{
+			foreach ( const CHash& oHash, oResult.pHit->m_lHashes )
+			{
+				if ( !pFileItem->HitData.lHashes.contains( oHash ) )
+				{
+					pFileItem->HitData.lHashes.append( oHash );
+				}
+			}
 		}
 
-		// This hit is a new non duplicate file.
-		if ( existingFileEntry == -1 )
+		SearchTreeItem* pHitItem = createHitItem( oResult, pFileItem );
+
+		if ( pFileItem->row() == -1 )
 		{
-			QFileInfo fileInfo( pHit->m_sDescriptiveName );
-
-			QString sCountry = geoIP.findCountryCode(pHit->m_pHitInfo.data()->m_oNodeAddress.toIPv4Address());
-
-			// Create SearchTreeItem representing the new file
-			QList<QVariant> lParentData;
-			lParentData << fileInfo.completeBaseName()        // File name
-						<< fileInfo.suffix()                  // Extension
-						<< formatBytes( pHit->m_nObjectSize ) // Size
-						<< ""                                 // Rating
-						<< ""                                 // Status
-						<< 1                                  // Host/Count
-						<< ""                                 // Speed
-						<< ""                                 // Client
-						<< "";                                // Country
-			SearchTreeItem* m_oFileItem = new SearchTreeItem( lParentData, rootItem );
-
-			m_oFileItem->HitData.lHashes << pHit->m_lHashes;
-
-			// Create SearchTreeItem representing hit
-			QList<QVariant> lChildData;
-			lChildData << fileInfo.completeBaseName()
-					   << fileInfo.suffix()
-					   << formatBytes( pHit->m_nObjectSize )
-					   << ""
-					   << ""
-					   << pHit->m_pHitInfo.data()->m_oNodeAddress.toString()
-					   << ""
-					   << common::vendorCodeToName( pHit->m_pHitInfo.data()->m_sVendor )
-					   << geoIP.countryNameFromCode( sCountry );
-			SearchTreeItem* m_oHitItem = new SearchTreeItem(lChildData, m_oFileItem);
-
-			m_oHitItem->HitData.lHashes << pHit->m_lHashes;
-			m_oHitItem->HitData.iNetwork = CNetworkIconProvider::icon( dpG2 );
-			m_oHitItem->HitData.iCountry = QIcon( ":/Resource/Flags/" + sCountry.toLower() + ".png" );
-
-			QueryHitSharedPtr pHitX( new CQueryHit( pHit ) );
-			m_oHitItem->HitData.pQueryHit = pHitX;
-
-			// add both items to the model
-			beginInsertRows( QModelIndex(), rootItem->childCount(), rootItem->childCount() );
-			rootItem->appendChild( m_oFileItem );
-			m_oFileItem->appendChild( m_oHitItem );
-			endInsertRows();
+			// not yet visible to the view, no need to announce the child separately
+			pFileItem->appendChild( pHitItem );
+		}
+		else
+		{
+			if ( !lNewSources.contains( pFileItem ) )
+			{
+				lUpdatedFiles.append( pFileItem );
+			}
+			lNewSources[pFileItem].append( pHitItem );
+		}
+	}
 
-			nFileCount = rootItem->childCount();
+	// add new hits to files already in the model, one insertion per file
+	foreach ( SearchTreeItem* pFileItem, lUpdatedFiles )
+	{
+		const QList<SearchTreeItem*>& lHits = lNewSources[pFileItem];
+		const int nFirst = pFileItem->childCount();
+
+		beginInsertRows( createIndex( pFileItem->row(), 0, pFileItem ), nFirst, nFirst + lHits.size() - 1 );
+		foreach ( SearchTreeItem* pHitItem, lHits )
+		{
+			pFileItem->appendChild( pHitItem );
 		}
-		// We do already have a file for that hit. Check for duplicate IP address. If not duplicate, add item.
-		else if ( !rootItem->child( existingFileEntry
-									)->duplicateCheck( rootItem->child( existingFileEntry ),
-													   pHit->m_pHitInfo.data()->
-													   m_oNodeAddress.toString() ) )
+		pFileItem->updateHitCount( pFileItem->childCount() );
+		endInsertRows();
+
+		QModelIndex idxCount = createIndex( pFileItem->row(), 5, pFileItem );
+		emit dataChanged( idxCount, idxCount );
+	}
+
+	// add all new files at once
+	if ( !lNewFiles.isEmpty() )
+	{
+		const int nFirst = rootItem->childCount();
+
+		beginInsertRows( QModelIndex(), nFirst, nFirst + lNewFiles.size() - 1 );
+		foreach ( SearchTreeItem* pFileItem, lNewFiles )
 		{
-			QModelIndex idxParent = index( existingFileEntry, 0, QModelIndex() );
-			QFileInfo fileInfo( pHit->m_sDescriptiveName );
-
-			QString sCountry = geoIP.findCountryCode(pHit->m_pHitInfo.data()->m_oNodeAddress.toIPv4Address());
-
-			QList<QVariant> lChildData;
-			lChildData << fileInfo.completeBaseName()
-					   << fileInfo.suffix()
-					   << formatBytes( pHit->m_nObjectSize )
-					   << ""
-					   << ""
-					   << pHit->m_pHitInfo.data()->m_oNodeAddress.toString()
-					   << ""
-					   << common::vendorCodeToName( pHit->m_pHitInfo.data()->m_sVendor )
-					   << geoIP.countryNameFromCode( sCountry );
-			SearchTreeItem* oHitItem = new SearchTreeItem( lChildData,
-															 rootItem->child( existingFileEntry ) );
-
-			oHitItem->HitData.lHashes << pHit->m_lHashes;
-			oHitItem->HitData.iNetwork = CNetworkIconProvider::icon( dpG2 );
-			oHitItem->HitData.iCountry = QIcon( ":/Resource/Flags/" + sCountry.toLower() + ".png" );
-
-			QueryHitSharedPtr pHitX( new CQueryHit( pHit ) );
-			oHitItem->HitData.pQueryHit = pHitX;
-
-			beginInsertRows( idxParent, rootItem->child( existingFileEntry )->childCount(),
-							 rootItem->child( existingFileEntry )->childCount() );
-			rootItem->child( existingFileEntry )->appendChild( oHitItem );
-			rootItem->child( existingFileEntry )->updateHitCount( rootItem->child( existingFileEntry
-																				  )->childCount() );
-			endInsertRows();
+			pFileItem->updateHitCount( pFileItem->childCount() );
+			rootItem->appendChild( pFileItem );
 		}
+		endInsertRows();
 
-		pHit = pHit->m_pNext;
+		nFileCount = rootItem->childCount();
 	}
 
 	emit updateStats();
-
-	QModelIndex idx1 = index( 0, 0, QModelIndex() );
-	QModelIndex idx2 = index( rootItem->childCount(), 10, QModelIndex() );
-	emit dataChanged( idx1, idx2 );
 	emit sort();
 }
 
+SearchTreeItem* SearchTreeModel::createFileItem(const SearchResultEntry& oResult)
+{
+	// Create SearchTreeItem representing the new file
+	QList<QVariant> lParentData;
+	lParentData << oResult.sName        // File name
+				<< oResult.sExtension   // Extension
+				<< oResult.sSize        // Size
+				<< ""                   // Rating
+				<< ""                   // Status
+				<< 1                    // Host/Count
+				<< ""                   // Speed
+				<< ""                   // Client
+				<< "";                  // Country
+	SearchTreeItem* pFileItem = new SearchTreeItem( lParentData, rootItem );
+
+	pFileItem->HitData.lHashes << oResult.pHit->m_lHashes;
+	pFileItem->HitData.nFileId = oResult.nFileId;
+
+	return pFileItem;
+}
+
+SearchTreeItem* SearchTreeModel::createHitItem(const SearchResultEntry& oResult, SearchTreeItem* pFileItem)
+{
+	// Create SearchTreeItem representing hit
+	QList<QVariant> lChildData;
+	lChildData << oResult.sName
+			   << oResult.sExtension
+			   << oResult.sSize
+			   << ""
+			   << ""
+			   << oResult.sAddress
+			   << ""
+			   << oResult.sClient
+			   << oResult.sCountryName;
+	SearchTreeItem* pHitItem = new SearchTreeItem( lChildData, pFileItem );
+
+	pHitItem->HitData.lHashes << oResult.pHit->m_lHashes;
+	pHitItem->HitData.nFileId = oResult.nFileId;
+	pHitItem->HitData.iNetwork = CNetworkIconProvider::icon( dpG2 );
+	pHitItem->HitData.iCountry = countryIcon( oResult.sCountryCode );
+	pHitItem->HitData.pQueryHit = oResult.pHit;
+
+	return pHitItem;
+}
+
+QIcon SearchTreeModel::countryIcon(const QString& sCountryCode)
+{
+	QHash<QString, QIcon>::const_iterator it = m_lCountryIcons.constFind( sCountryCode );
+	if ( it != m_lCountryIcons.constEnd() )
+	{
+		return it.value();
+	}
+
+	QIcon iFlag( ":/Resource/Flags/" + sCountryCode.toLower() + ".png" );
+	m_lCountryIcons.insert( sCountryCode, iFlag );
+	return iFlag;
+}
+
 SearchTreeItem::SearchTreeItem(const QList<QVariant> &data, SearchTreeItem* parent)
 {
 	parentItem = parent;
 	itemData = data;
+	rowNumber = -1;
 }
 
 SearchTreeItem::~SearchTreeItem()
@@ -430,6 +552,7 @@ SearchTreeItem::~SearchTreeItem()
 void SearchTreeItem::appendChild(SearchTreeItem* item)
 {
 	item->parentItem = this;
+	item->rowNumber = childItems.size();
 	childItems.append(item);
 }
 
@@ -454,17 +577,6 @@ int SearchTreeItem::columnCount() const
 	return itemData.count();
 }
 
-int SearchTreeItem::find(CHash& pHash) const
-{
-	for ( int i = 0; i < childItems.size(); ++i )
-	{
-		if ( child( i )->HitData.lHashes.contains( pHash ) )
-		{
-			return i;
-		}
-	}
-	return -1;
-}
 
 QVariant SearchTreeItem::data(int column) const
 {
@@ -478,17 +590,22 @@ SearchTreeItem* SearchTreeItem::parent()
 
 void SearchTreeItem::removeChild(int position)
 {
-	if (position < 0 || position  > childItems.size())
+	if (position < 0 || position >= childItems.size())
 		return;
 
 	delete childItems.takeAt(position);
+
+	for(int i = position; i < childItems.size(); ++i)
+	{
+		childItems[i]->rowNumber = i;
+	}
 }
 
 int SearchTreeItem::row() const
 {
 	if(parentItem)
 	{
-		return parentItem->childItems.indexOf(const_cast<SearchTreeItem*>(this));
+		return rowNumber;
 	}
 
 	return 0;
@@ -499,18 +616,6 @@ void SearchTreeItem::updateHitCount(int count)
 	itemData[5] = count;
 }
 
-bool SearchTreeItem::duplicateCheck(SearchTreeItem* containerItem, QString ip)
-{
-	for(int index = 0; index < containerItem->childItems.size(); ++index)
-	{
-		if(containerItem->child(index)->data(5).toString() == ip)
-		{
-			return true;
-		}
-	}
-	return false;
-}
-
 SearchTreeItem * SearchTreeModel::topLevelItemFromIndex(QModelIndex index)
 {
 	Q_ASSERT(index.model() == this);
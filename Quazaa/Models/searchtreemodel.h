@@ -27,17 +27,19 @@
 
 #include <QObject>
 #include <QIcon>
+#include <QHash>
 #include <QAbstractItemModel>
 #include "NetworkCore/queryhit.h"
+#include "NetworkCore/searchresults.h"
 
-class CHash;
 class CFileIconProvider;
 
 namespace SearchHitData
 {
 	struct sSearchHitData
 	{
-		QList<CHash> lHashes;
+		QVector<CHash> lHashes;
+		quint32 nFileId;       // file group id assigned by CSearchResults
 		QIcon iNetwork;
 		QIcon iCountry;
 		QueryHitSharedPtr pQueryHit;
@@ -88,9 +90,7 @@ public:
 	SearchTreeItem* child(int row) const;
 	int childCount() const;
 	int columnCount() const;
-	int find(CHash& pHash) const;
 	void updateHitCount(int count);
-	bool duplicateCheck(SearchTreeItem* containerItem, QString ip);
 	QVariant data(int column) const;
 	int row() const;
 	SearchTreeItem* parent();
@@ -100,6 +100,7 @@ private:
 	QList<SearchTreeItem*> childItems;
 	QList<QVariant> itemData;
 	SearchTreeItem* parentItem;
+	int rowNumber; // position in parentItem->childItems, kept up to date by the parent
 };
 
 class SearchTreeModel : public QAbstractItemModel
@@ -112,6 +113,10 @@ private:
 
 	SearchTreeItem*    rootItem;
 
+	QHash<quint32, SearchTreeItem*> m_lFiles;         // file group id -> top level file item
+	QHash<QString, QIcon>           m_lCountryIcons;  // country code -> flag
+	QStringList                     m_lQueryWords;    // for regular expression rules
+
 public:
 	SearchTreeModel();
 	~SearchTreeModel();
@@ -129,20 +134,24 @@ public:
 	int columnCount(const QModelIndex& parent = QModelIndex()) const;
 	int nFileCount;
 
+	void setQueryWords(const QStringList& lQueryWords);
+
 signals:
 	void updateStats();
 	void sort();
 
 private:
 	void setupModelData(const QStringList& lines, SearchTreeItem* parent);
+	SearchTreeItem* createFileItem(const SearchResultEntry& oResult);
+	SearchTreeItem* createHitItem(const SearchResultEntry& oResult, SearchTreeItem* pFileItem);
+	QIcon countryIcon(const QString& sCountryCode);
 
 public slots:
 	void clear();
 	bool isRoot(QModelIndex index);
 	void removeQueryHit(int position, const QModelIndex &parent);
-
-private slots:
-	void addQueryHit(QueryHitSharedPtr pHit);
+	void addResults(SearchResultBatch lResults);
+	void sanityCheck();
 };
 
 #endif // SEARCHTREEMODEL_H
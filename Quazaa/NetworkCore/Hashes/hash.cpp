@@ -22,73 +22,37 @@
 ** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-
 #include "hash.h"
 #include "systemlog.h"
-#include <QCryptographicHash>
 #include "3rdparty/CyoEncode/CyoEncode.h"
 #include "3rdparty/CyoEncode/CyoDecode.h"
 
 #include "debug_new.h"
 
-CHash::CHash(const CHash &rhs) //Right Hash Set
+CHash::CHash(const char* pRaw, quint32 nLength, CHash::Algorithm algo)
 {
-	if ( !rhs.m_bFinalized )
+	if ( nLength == 0 || nLength != (quint32)CHash::byteCount( algo ) )
 	{
-		systemLog.postLog(LogSeverity::Debug, QObject::tr( "WARNING: Copying non-finalized CHash" ) );
+		throw invalid_hash_exception();
 	}
 
-	m_baRawValue = rhs.m_baRawValue;
-	m_nHashAlgorithm = rhs.m_nHashAlgorithm;
-	m_bFinalized = true;
-	m_pContext = 0;
-}
-
-CHash::CHash(Algorithm algo)
-{
-	m_bFinalized = false;
+	memset( m_pRaw, 0, sizeof( m_pRaw ) );
+	memcpy( m_pRaw, pRaw, nLength );
 	m_nHashAlgorithm = algo;
-
-	switch( algo )
-	{
-	case CHash::SHA1:
-		m_pContext = new QCryptographicHash( QCryptographicHash::Sha1 );
-		break;
-	case CHash::MD4:
-		m_pContext = new QCryptographicHash( QCryptographicHash::Md4 );
-		break;
-	case CHash::MD5:
-		m_pContext = new QCryptographicHash( QCryptographicHash::Md5 );
-		break;
-	default:
-		m_pContext = 0; /* error? */
-	}
+	m_nLength = nLength;
 }
 
-CHash::CHash(QByteArray baRaw, CHash::Algorithm algo)
+CHash::CHash(const QByteArray& baRaw, CHash::Algorithm algo)
 {
-	if ( baRaw.size() != CHash::byteCount( algo ) )
+	if ( baRaw.size() == 0 || baRaw.size() != CHash::byteCount( algo ) )
 	{
 		throw invalid_hash_exception();
 	}
-	m_baRawValue = baRaw;
-	m_nHashAlgorithm = algo;
-	m_pContext = 0;
-	m_bFinalized = true;
-}
 
-CHash::~CHash()
-{
-	if ( m_pContext )
-	{
-		switch( m_nHashAlgorithm )
-		{
-		case CHash::SHA1:
-		case CHash::MD5:
-		case CHash::MD4:
-			delete ( (QCryptographicHash*)m_pContext );
-		}
-	}
+	memset( m_pRaw, 0, sizeof( m_pRaw ) );
+	memcpy( m_pRaw, baRaw.constData(), baRaw.size() );
+	m_nHashAlgorithm = algo;
+	m_nLength = baRaw.size();
 }
 
 // Returns raw hash length by hash family
@@ -102,27 +66,28 @@ int CHash::byteCount(int algo)
 		return 16;
 	case CHash::MD5:
 		return 16;
+	case CHash::TIGER:
+		return 24;
 	default:
 		return 0;
 	}
 }
 
-// Parses URN and returns CHash pointer if conversion succeed, 0 otherwise
-CHash* CHash::fromURN(QString sURN)
+// Parses URN, returns a null hash if the URN is not understood
+CHash CHash::fromURN(const QString& sURN)
 {
 	// try to get hash family from URN
-	// urn:tree:tiger:/
 
 	if ( sURN.size() < 16 )
 	{
-		throw invalid_hash_exception();
+		return CHash();
 	}
 
 	QByteArray baFamily;
-	int nStart = ( strncmp( "urn:", sURN.toLocal8Bit().data(), 4 ) == 0 ? 4 : 0 );
+	int nStart = ( sURN.startsWith( "urn:", Qt::CaseInsensitive ) ? 4 : 0 );
 	int nStartHash = sURN.indexOf( ":", nStart ) + 1;
-	baFamily = sURN.mid( nStart, nStartHash - nStart - 1 ).toLower().toLocal8Bit();
-	QByteArray baValue = sURN.mid( nStartHash ).toLocal8Bit();
+	baFamily = sURN.mid( nStart, nStartHash - nStart - 1 ).toLower().toLatin1();
+	QByteArray baValue = sURN.mid( nStartHash ).toLatin1();
 	char pVal[ 128 ];
 
 	if ( baFamily == "sha1" && baValue.length() == 32 )
@@ -132,8 +97,7 @@ CHash* CHash::fromURN(QString sURN)
 		{
 			// valid sha1/base32
 			cyoBase32Decode( (char*)&pVal, baValue.data(), baValue.length() );
-			CHash* pRet = new CHash(QByteArray( (char*)&pVal ), CHash::SHA1);
-			return pRet;
+			return CHash( pVal, 20, CHash::SHA1 );
 		}
 	}
 	else if(baFamily == "md5" && baValue.length() == 32)
@@ -141,26 +105,37 @@ CHash* CHash::fromURN(QString sURN)
 		if(cyoBase16Validate(baValue.data(), baValue.length()) == 0)
 		{
 			cyoBase16Decode((char*)&pVal, baValue.data(), baValue.length());
-			CHash* pRet = new CHash(QByteArray((char*)&pVal), CHash::MD5);
-			return pRet;
+			return CHash( pVal, 16, CHash::MD5 );
+		}
+	}
+	else if ( baFamily == "tree" )
+	{
+		// urn:tree:tiger:ROOT, also seen as urn:tree:tiger/:ROOT
+		if ( baValue.startsWith( "tiger:" ) || baValue.startsWith( "tiger/:" ) )
+		{
+			// the decoder works on whole 40 character groups
+			baValue = baValue.mid( baValue.indexOf( ':' ) + 1 ).toUpper();
+			baValue.append( "=" );
+
+			if ( baValue.length() == 40 && cyoBase32Validate( baValue.data(), baValue.length() ) == 0 )
+			{
+				cyoBase32Decode( (char*)&pVal, baValue.data(), baValue.length() );
+				return CHash( pVal, 24, CHash::TIGER );
+			}
 		}
 	}
 
-	return 0;
+	return CHash();
 }
 
-CHash* CHash::fromRaw(QByteArray &baRaw, CHash::Algorithm algo)
+CHash CHash::fromRaw(const QByteArray& baRaw, CHash::Algorithm algo)
 {
-	try
+	if ( baRaw.size() == 0 || baRaw.size() != CHash::byteCount( algo ) )
 	{
-		CHash* pRet = new CHash( baRaw, algo );
-		return pRet;
+		return CHash();
 	}
-	catch( ... )
-	{
 
-	}
-	return 0;
+	return CHash( baRaw, algo );
 }
 
 int CHash::lengthForUrn(const QString &urn)
@@ -185,12 +160,19 @@ int CHash::lengthForUrn(const QString &urn)
 // Returns URN as string
 QString CHash::toURN() const
 {
+	if ( isNull() )
+	{
+		return QString();
+	}
+
 	switch( m_nHashAlgorithm )
 	{
 		case CHash::SHA1:
 			return QString( "urn:sha1:" ) + toString();
 		case CHash::MD5:
 			return QString("urn:md5:") + toString();
+		case CHash::TIGER:
+			return QString( "urn:tree:tiger:" ) + toString();
 		case CHash::MD4:
 			break;
 	}
@@ -204,13 +186,23 @@ QString CHash::toString() const
 	char pBuff[128];
 	memset( &pBuff, 0, sizeof( pBuff ) );
 
+	if ( isNull() )
+	{
+		return QString();
+	}
+
 	switch( m_nHashAlgorithm )
 	{
 		case CHash::SHA1:
-			cyoBase32Encode( (char*)&pBuff, rawValue().data(), 20 );
+			cyoBase32Encode( (char*)&pBuff, rawData(), 20 );
 			break;
 		case CHash::MD5:
-			cyoBase16Encode((char*)&pBuff, rawValue().data(), 16);
+			cyoBase16Encode((char*)&pBuff, rawData(), 16);
+			break;
+		case CHash::TIGER:
+			// 39 characters, without the padding
+			cyoBase32Encode( (char*)&pBuff, rawData(), 24 );
+			pBuff[39] = 0;
 			break;
 		case CHash::MD4:
 			break;
@@ -219,43 +211,7 @@ QString CHash::toString() const
 	return QString( pBuff );
 }
 
-void CHash::finalize()
-{
-	if(!m_bFinalized)
-	{
-		Q_ASSERT(m_pContext);
-
-		switch(m_nHashAlgorithm)
-		{
-		case CHash::SHA1:
-		case CHash::MD5:
-		case CHash::MD4:
-			m_baRawValue = ((QCryptographicHash*)m_pContext)->result();
-			delete((QCryptographicHash*)m_pContext);
-			m_pContext = 0;
-			m_bFinalized = true;
-		}
-	}
-}
-
-void CHash::addData(const char *pData, quint32 nLength)
-{
-	Q_ASSERT( !m_bFinalized && m_pContext );
-
-	switch( m_nHashAlgorithm )
-	{
-	case CHash::SHA1:
-	case CHash::MD5:
-	case CHash::MD4:
-		( (QCryptographicHash*)m_pContext )->addData( pData, nLength );
-	}
-}
-void CHash::addData(QByteArray baData)
-{
-	addData( baData.data(), baData.length() );
-}
-
-QString CHash::getFamilyName()
+QString CHash::getFamilyName() const
 {
 	switch( m_nHashAlgorithm )
 	{
@@ -265,6 +221,8 @@ QString CHash::getFamilyName()
 		return QString( "md5" );
 	case CHash::MD4:
 		return QString( "md4" );
+	case CHash::TIGER:
+		return QString( "tiger" );
 	}
 
 	return "";
@@ -280,9 +238,46 @@ QDataStream& operator>>(QDataStream& s, CHash& rhs)
 {
 	QString sTmp;
 	s >> sTmp;
-	CHash* pHash = CHash::fromURN(sTmp);
-	rhs = *pHash;
-	delete pHash;
+	rhs = CHash::fromURN(sTmp);
 	return s;
 }
 
+CHashContext::CHashContext(CHash::Algorithm algo) :
+	m_nHashAlgorithm(algo),
+	m_oContext(cryptographicAlgorithm(algo))
+{
+	Q_ASSERT_X(algo != CHash::TIGER, "CHashContext", "Tiger tree roots are computed by CTigerTree");
+}
+
+void CHashContext::addData(const char *pData, quint32 nLength)
+{
+	m_oContext.addData( pData, nLength );
+}
+void CHashContext::addData(const QByteArray& baData)
+{
+	m_oContext.addData( baData.constData(), baData.length() );
+}
+
+CHash CHashContext::result() const
+{
+	return CHash( m_oContext.result(), m_nHashAlgorithm );
+}
+
+void CHashContext::reset()
+{
+	m_oContext.reset();
+}
+
+QCryptographicHash::Algorithm CHashContext::cryptographicAlgorithm(CHash::Algorithm algo)
+{
+	switch( algo )
+	{
+	case CHash::MD4:
+		return QCryptographicHash::Md4;
+	case CHash::MD5:
+		return QCryptographicHash::Md5;
+	case CHash::SHA1:
+	default:
+		return QCryptographicHash::Sha1;
+	}
+}
@@ -27,44 +27,50 @@
 
 #include "types.h"
 
+#include <QCryptographicHash>
+#include <QVector>
+#include <functional>
+#include <string.h>
+
 struct invalid_hash_exception{};
 
+// A finished hash value: algorithm and digest stored inline, no heap allocations, so it can
+// be copied, compared and used as a key in QHash/QMap and std containers cheaply.
+// Digests are produced by CHashContext; TIGER values are Tiger tree roots, made by CTigerTree.
 class CHash
 {
 
 public:
-	enum Algorithm {SHA1, MD5, MD4};
+	enum Algorithm {SHA1, MD5, MD4, TIGER};
+	enum { MaxByteCount = 24 };
 
 protected:
-	void*				m_pContext;
-	bool				m_bFinalized;
-	CHash::Algorithm	m_nHashAlgorithm;
-	QByteArray			m_baRawValue;
+	quint8				m_pRaw[MaxByteCount];
+	quint8				m_nHashAlgorithm;	// CHash::Algorithm
+	quint8				m_nLength;			// 0 for a null hash
 
 public:
-	CHash(const CHash& rhs);
-	CHash(Algorithm algo);
-	CHash(QByteArray baRaw, CHash::Algorithm algo);
-	~CHash();
+	inline CHash();
+	CHash(const char* pRaw, quint32 nLength, CHash::Algorithm algo);
+	CHash(const QByteArray& baRaw, CHash::Algorithm algo);
 
 	static int	byteCount(int algo);
 
-	static CHash* fromURN(QString sURN);
-	static CHash* fromRaw(QByteArray& baRaw, CHash::Algorithm algo);
+	// Both return a null hash if the input is not understood.
+	static CHash fromURN(const QString& sURN);
+	static CHash fromRaw(const QByteArray& baRaw, CHash::Algorithm algo);
 
 	static int lengthForUrn(const QString& urn);
 
 	QString toURN() const;
 	QString toString() const;
 
-	void addData(const char* pData, quint32 nLength);
-	void addData(QByteArray baData);
-
-	QString getFamilyName();
-
-	void finalize();
+	QString getFamilyName() const;
 
+	inline bool isNull() const;
 	inline CHash::Algorithm getAlgorithm() const;
+	inline const char* rawData() const;
+	inline int length() const;
 	inline QByteArray rawValue() const;
 
 	inline bool operator==(const CHash& oHash) const;
@@ -73,10 +79,19 @@ public:
 	inline bool operator<(const CHash& oHash) const;
 };
 
+Q_DECLARE_TYPEINFO(CHash, Q_MOVABLE_TYPE);
+
+CHash::CHash() :
+	m_nHashAlgorithm(SHA1),
+	m_nLength(0)
+{
+	memset(m_pRaw, 0, sizeof(m_pRaw));
+}
+
 bool CHash::operator ==(const CHash& oHash) const
 {
-	Q_ASSERT(oHash.m_bFinalized && m_bFinalized);
-	return (oHash.m_nHashAlgorithm == m_nHashAlgorithm && oHash.m_baRawValue == m_baRawValue);
+	return (oHash.m_nHashAlgorithm == m_nHashAlgorithm && oHash.m_nLength == m_nLength
+			&& memcmp(oHash.m_pRaw, m_pRaw, m_nLength) == 0);
 }
 bool CHash::operator !=(const CHash& oHash) const
 {
@@ -84,22 +99,83 @@ bool CHash::operator !=(const CHash& oHash) const
 }
 bool CHash::operator <(const CHash& oHash) const
 {
-	return (m_baRawValue < oHash.m_baRawValue);
+	if(m_nHashAlgorithm != oHash.m_nHashAlgorithm)
+	{
+		return m_nHashAlgorithm < oHash.m_nHashAlgorithm;
+	}
+	return memcmp(m_pRaw, oHash.m_pRaw, sizeof(m_pRaw)) < 0;
 }
 bool CHash::operator >(const CHash& oHash) const
 {
-	return (m_baRawValue > oHash.m_baRawValue);
+	return (oHash < *this);
 }
 
+bool CHash::isNull() const
+{
+	return m_nLength == 0;
+}
 CHash::Algorithm CHash::getAlgorithm() const
 {
-	return m_nHashAlgorithm;
+	return CHash::Algorithm(m_nHashAlgorithm);
+}
+const char* CHash::rawData() const
+{
+	return (const char*)m_pRaw;
+}
+int CHash::length() const
+{
+	return m_nLength;
 }
 QByteArray CHash::rawValue() const
 {
-	return m_baRawValue;
+	return QByteArray((const char*)m_pRaw, m_nLength);
 }
+
+// Digests are uniformly distributed, the first bytes make a good bucket index.
+inline uint qHash(const CHash& oHash)
+{
+	uint nKey;
+	memcpy(&nKey, oHash.rawData(), sizeof(nKey));
+	return nKey ^ oHash.getAlgorithm();
+}
+
+namespace std
+{
+template<> struct hash<CHash>
+{
+	inline size_t operator()(const CHash& oHash) const
+	{
+		return qHash(oHash);
+	}
+};
+}
+
 QDataStream& operator<<(QDataStream& s, const CHash& rhs);
 QDataStream& operator>>(QDataStream& s, CHash& rhs);
 
+// Computes a CHash from data added in pieces. Not for TIGER, see CTigerTree.
+class CHashContext
+{
+protected:
+	CHash::Algorithm	m_nHashAlgorithm;
+	QCryptographicHash	m_oContext;
+
+public:
+	explicit CHashContext(CHash::Algorithm algo);
+
+	inline CHash::Algorithm getAlgorithm() const
+	{
+		return m_nHashAlgorithm;
+	}
+
+	void addData(const char* pData, quint32 nLength);
+	void addData(const QByteArray& baData);
+
+	CHash result() const;
+	void reset();
+
+protected:
+	static QCryptographicHash::Algorithm cryptographicAlgorithm(CHash::Algorithm algo);
+};
+
 #endif // HASH_H
@@ -0,0 +1,676 @@
+/*
+** tiger.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "tiger.h"
+
+#include <QtEndian>
+#include <string.h>
+
+#include "debug_new.h"
+
+// The four S-boxes from the reference implementation.
+static const quint64 TigerSBoxes[4][256] =
+{
+	{
+		Q_UINT64_C(0x02AAB17CF7E90C5E), Q_UINT64_C(0xAC424B03E243A8EC),
+		Q_UINT64_C(0x72CD5BE30DD5FCD3), Q_UINT64_C(0x6D019B93F6F97F3A),
+		Q_UINT64_C(0xCD9978FFD21F9193), Q_UINT64_C(0x7573A1C9708029E2),
+		Q_UINT64_C(0xB164326B922A83C3), Q_UINT64_C(0x46883EEE04915870),
+		Q_UINT64_C(0xEAACE3057103ECE6), Q_UINT64_C(0xC54169B808A3535C),
+		Q_UINT64_C(0x4CE754918DDEC47C), Q_UINT64_C(0x0AA2F4DFDC0DF40C),
+		Q_UINT64_C(0x10B76F18A74DBEFA), Q_UINT64_C(0xC6CCB6235AD1AB6A),
+		Q_UINT64_C(0x13726121572FE2FF), Q_UINT64_C(0x1A488C6F199D921E),
+		Q_UINT64_C(0x4BC9F9F4DA0007CA), Q_UINT64_C(0x26F5E6F6E85241C7),
+		Q_UINT64_C(0x859079DBEA5947B6), Q_UINT64_C(0x4F1885C5C99E8C92),
+		Q_UINT64_C(0xD78E761EA96F864B), Q_UINT64_C(0x8E36428C52B5C17D),
+		Q_UINT64_C(0x69CF6827373063C1), Q_UINT64_C(0xB607C93D9BB4C56E),
+		Q_UINT64_C(0x7D820E760E76B5EA), Q_UINT64_C(0x645C9CC6F07FDC42),
+		Q_UINT64_C(0xBF38A078243342E0), Q_UINT64_C(0x5F6B343C9D2E7D04),
+		Q_UINT64_C(0xF2C28AEB600B0EC6), Q_UINT64_C(0x6C0ED85F7254BCAC),
+		Q_UINT64_C(0x71592281A4DB4FE5), Q_UINT64_C(0x1967FA69CE0FED9F),
+		Q_UINT64_C(0xFD5293F8B96545DB), Q_UINT64_C(0xC879E9D7F2A7600B),
+		Q_UINT64_C(0x860248920193194E), Q_UINT64_C(0xA4F9533B2D9CC0B3),
+		Q_UINT64_C(0x9053836C15957613), Q_UINT64_C(0xDB6DCF8AFC357BF1),
+		Q_UINT64_C(0x18BEEA7A7A370F57), Q_UINT64_C(0x037117CA50B99066),
+		Q_UINT64_C(0x6AB30A9774424A35), Q_UINT64_C(0xF4E92F02E325249B),
+		Q_UINT64_C(0x7739DB07061CCAE1), Q_UINT64_C(0xD8F3B49CECA42A05),
+		Q_UINT64_C(0xBD56BE3F51382F73), Q_UINT64_C(0x45FAED5843B0BB28),
+		Q_UINT64_C(0x1C813D5C11BF1F83), Q_UINT64_C(0x8AF0E4B6D75FA169),
+		Q_UINT64_C(0x33EE18A487AD9999), Q_UINT64_C(0x3C26E8EAB1C94410),
+		Q_UINT64_C(0xB510102BC0A822F9), Q_UINT64_C(0x141EEF310CE6123B),
+		Q_UINT64_C(0xFC65B90059DDB154), Q_UINT64_C(0xE0158640C5E0E607),
+		Q_UINT64_C(0x884E079826C3A3CF), Q_UINT64_C(0x930D0D9523C535FD),
+		Q_UINT64_C(0x35638D754E9A2B00), Q_UINT64_C(0x4085FCCF40469DD5),
+		Q_UINT64_C(0xC4B17AD28BE23A4C), Q_UINT64_C(0xCAB2F0FC6A3E6A2E),
+		Q_UINT64_C(0x2860971A6B943FCD), Q_UINT64_C(0x3DDE6EE212E30446),
+		Q_UINT64_C(0x6222F32AE01765AE), Q_UINT64_C(0x5D550BB5478308FE),
+		Q_UINT64_C(0xA9EFA98DA0EDA22A), Q_UINT64_C(0xC351A71686C40DA7),
+		Q_UINT64_C(0x1105586D9C867C84), Q_UINT64_C(0xDCFFEE85FDA22853),
+		Q_UINT64_C(0xCCFBD0262C5EEF76), Q_UINT64_C(0xBAF294CB8990D201),
+		Q_UINT64_C(0xE69464F52AFAD975), Q_UINT64_C(0x94B013AFDF133E14),
+		Q_UINT64_C(0x06A7D1A32823C958), Q_UINT64_C(0x6F95FE5130F61119),
+		Q_UINT64_C(0xD92AB34E462C06C0), Q_UINT64_C(0xED7BDE33887C71D2),
+		Q_UINT64_C(0x79746D6E6518393E), Q_UINT64_C(0x5BA419385D713329),
+		Q_UINT64_C(0x7C1BA6B948A97564), Q_UINT64_C(0x31987C197BFDAC67),
+		Q_UINT64_C(0xDE6C23C44B053D02), Q_UINT64_C(0x581C49FED002D64D),
+		Q_UINT64_C(0xDD474D6338261571), Q_UINT64_C(0xAA4546C3E473D062),
+		Q_UINT64_C(0x928FCE349455F860), Q_UINT64_C(0x48161BBACAAB94D9),
+		Q_UINT64_C(0x63912430770E6F68), Q_UINT64_C(0x6EC8A5E602C6641C),
+		Q_UINT64_C(0x87282515337DDD2B), Q_UINT64_C(0x2CDA6B42034B701B),
+		Q_UINT64_C(0xB03D37C181CB096D), Q_UINT64_C(0xE108438266C71C6F),
+		Q_UINT64_C(0x2B3180C7EB51B255), Q_UINT64_C(0xDF92B82F96C08BBC),
+		Q_UINT64_C(0x5C68C8C0A632F3BA), Q_UINT64_C(0x5504CC861C3D0556),
+		Q_UINT64_C(0xABBFA4E55FB26B8F), Q_UINT64_C(0x41848B0AB3BACEB4),
+		Q_UINT64_C(0xB334A273AA445D32), Q_UINT64_C(0xBCA696F0A85AD881),
+		Q_UINT64_C(0x24F6EC65B528D56C), Q_UINT64_C(0x0CE1512E90F4524A),
+		Q_UINT64_C(0x4E9DD79D5506D35A), Q_UINT64_C(0x258905FAC6CE9779),
+		Q_UINT64_C(0x2019295B3E109B33), Q_UINT64_C(0xF8A9478B73A054CC),
+		Q_UINT64_C(0x2924F2F934417EB0), Q_UINT64_C(0x3993357D536D1BC4),
+		Q_UINT64_C(0x38A81AC21DB6FF8B), Q_UINT64_C(0x47C4FBF17D6016BF),
+		Q_UINT64_C(0x1E0FAADD7667E3F5), Q_UINT64_C(0x7ABCFF62938BEB96),
+		Q_UINT64_C(0xA78DAD948FC179C9), Q_UINT64_C(0x8F1F98B72911E50D),
+		Q_UINT64_C(0x61E48EAE27121A91), Q_UINT64_C(0x4D62F7AD31859808),
+		Q_UINT64_C(0xECEBA345EF5CEAEB), Q_UINT64_C(0xF5CEB25EBC9684CE),
+		Q_UINT64_C(0xF633E20CB7F76221), Q_UINT64_C(0xA32CDF06AB8293E4),
+		Q_UINT64_C(0x985A202CA5EE2CA4), Q_UINT64_C(0xCF0B8447CC8A8FB1),
+		Q_UINT64_C(0x9F765244979859A3), Q_UINT64_C(0xA8D516B1A1240017),
+		Q_UINT64_C(0x0BD7BA3EBB5DC726), Q_UINT64_C(0xE54BCA55B86ADB39),
+		Q_UINT64_C(0x1D7A3AFD6C478063), Q_UINT64_C(0x519EC608E7669EDD),
+		Q_UINT64_C(0x0E5715A2D149AA23), Q_UINT64_C(0x177D4571848FF194),
+		Q_UINT64_C(0xEEB55F3241014C22), Q_UINT64_C(0x0F5E5CA13A6E2EC2),
+		Q_UINT64_C(0x8029927B75F5C361), Q_UINT64_C(0xAD139FABC3D6E436),
+		Q_UINT64_C(0x0D5DF1A94CCF402F), Q_UINT64_C(0x3E8BD948BEA5DFC8),
+		Q_UINT64_C(0xA5A0D357BD3FF77E), Q_UINT64_C(0xA2D12E251F74F645),
+		Q_UINT64_C(0x66FD9E525E81A082), Q_UINT64_C(0x2E0C90CE7F687A49),
+		Q_UINT64_C(0xC2E8BCBEBA973BC5), Q_UINT64_C(0x000001BCE509745F),
+		Q_UINT64_C(0x423777BBE6DAB3D6), Q_UINT64_C(0xD1661C7EAEF06EB5),
+		Q_UINT64_C(0xA1781F354DAACFD8), Q_UINT64_C(0x2D11284A2B16AFFC),
+		Q_UINT64_C(0xF1FC4F67FA891D1F), Q_UINT64_C(0x73ECC25DCB920ADA),
+		Q_UINT64_C(0xAE610C22C2A12651), Q_UINT64_C(0x96E0A810D356B78A),
+		Q_UINT64_C(0x5A9A381F2FE7870F), Q_UINT64_C(0xD5AD62EDE94E5530),
+		Q_UINT64_C(0xD225E5E8368D1427), Q_UINT64_C(0x65977B70C7AF4631),
+		Q_UINT64_C(0x99F889B2DE39D74F), Q_UINT64_C(0x233F30BF54E1D143),
+		Q_UINT64_C(0x9A9675D3D9A63C97), Q_UINT64_C(0x5470554FF334F9A8),
+		Q_UINT64_C(0x166ACB744A4F5688), Q_UINT64_C(0x70C74CAAB2E4AEAD),
+		Q_UINT64_C(0xF0D091646F294D12), Q_UINT64_C(0x57B82A89684031D1),
+		Q_UINT64_C(0xEFD95A5A61BE0B6B), Q_UINT64_C(0x2FBD12E969F2F29A),
+		Q_UINT64_C(0x9BD37013FEFF9FE8), Q_UINT64_C(0x3F9B0404D6085A06),
+		Q_UINT64_C(0x4940C1F3166CFE15), Q_UINT64_C(0x09542C4DCDF3DEFB),
+		Q_UINT64_C(0xB4C5218385CD5CE3), Q_UINT64_C(0xC935B7DC4462A641),
+		Q_UINT64_C(0x3417F8A68ED3B63F), Q_UINT64_C(0xB80959295B215B40),
+		Q_UINT64_C(0xF99CDAEF3B8C8572), Q_UINT64_C(0x018C0614F8FCB95D),
+		Q_UINT64_C(0x1B14ACCD1A3ACDF3), Q_UINT64_C(0x84D471F200BB732D),
+		Q_UINT64_C(0xC1A3110E95E8DA16), Q_UINT64_C(0x430A7220BF1A82B8),
+		Q_UINT64_C(0xB77E090D39DF210E), Q_UINT64_C(0x5EF4BD9F3CD05E9D),
+		Q_UINT64_C(0x9D4FF6DA7E57A444), Q_UINT64_C(0xDA1D60E183D4A5F8),
+		Q_UINT64_C(0xB287C38417998E47), Q_UINT64_C(0xFE3EDC121BB31886),
+		Q_UINT64_C(0xC7FE3CCC980CCBEF), Q_UINT64_C(0xE46FB590189BFD03),
+		Q_UINT64_C(0x3732FD469A4C57DC), Q_UINT64_C(0x7EF700A07CF1AD65),
+		Q_UINT64_C(0x59C64468A31D8859), Q_UINT64_C(0x762FB0B4D45B61F6),
+		Q_UINT64_C(0x155BAED099047718), Q_UINT64_C(0x68755E4C3D50BAA6),
+		Q_UINT64_C(0xE9214E7F22D8B4DF), Q_UINT64_C(0x2ADDBF532EAC95F4),
+		Q_UINT64_C(0x32AE3909B4BD0109), Q_UINT64_C(0x834DF537B08E3450),
+		Q_UINT64_C(0xFA209DA84220728D), Q_UINT64_C(0x9E691D9B9EFE23F7),
+		Q_UINT64_C(0x0446D288C4AE8D7F), Q_UINT64_C(0x7B4CC524E169785B),
+		Q_UINT64_C(0x21D87F0135CA1385), Q_UINT64_C(0xCEBB400F137B8AA5),
+		Q_UINT64_C(0x272E2B66580796BE), Q_UINT64_C(0x3612264125C2B0DE),
+		Q_UINT64_C(0x057702BDAD1EFBB2), Q_UINT64_C(0xD4BABB8EACF84BE9),
+		Q_UINT64_C(0x91583139641BC67B), Q_UINT64_C(0x8BDC2DE08036E024),
+		Q_UINT64_C(0x603C8156F49F68ED), Q_UINT64_C(0xF7D236F7DBEF5111),
+		Q_UINT64_C(0x9727C4598AD21E80), Q_UINT64_C(0xA08A0896670A5FD7),
+		Q_UINT64_C(0xCB4A8F4309EBA9CB), Q_UINT64_C(0x81AF564B0F7036A1),
+		Q_UINT64_C(0xC0B99AA778199ABD), Q_UINT64_C(0x959F1EC83FC8E952),
+		Q_UINT64_C(0x8C505077794A81B9), Q_UINT64_C(0x3ACAAF8F056338F0),
+		Q_UINT64_C(0x07B43F50627A6778), Q_UINT64_C(0x4A44AB49F5ECCC77),
+		Q_UINT64_C(0x3BC3D6E4B679EE98), Q_UINT64_C(0x9CC0D4D1CF14108C),
+		Q_UINT64_C(0x4406C00B206BC8A0), Q_UINT64_C(0x82A18854C8D72D89),
+		Q_UINT64_C(0x67E366B35C3C432C), Q_UINT64_C(0xB923DD61102B37F2),
+		Q_UINT64_C(0x56AB2779D884271D), Q_UINT64_C(0xBE83E1B0FF1525AF),
+		Q_UINT64_C(0xFB7C65D4217E49A9), Q_UINT64_C(0x6BDBE0E76D48E7D4),
+		Q_UINT64_C(0x08DF828745D9179E), Q_UINT64_C(0x22EA6A9ADD53BD34),
+		Q_UINT64_C(0xE36E141C5622200A), Q_UINT64_C(0x7F805D1B8CB750EE),
+		Q_UINT64_C(0xAFE5C7A59F58E837), Q_UINT64_C(0xE27F996A4FB1C23C),
+		Q_UINT64_C(0xD3867DFB0775F0D0), Q_UINT64_C(0xD0E673DE6E88891A),
+		Q_UINT64_C(0x123AEB9EAFB86C25), Q_UINT64_C(0x30F1D5D5C145B895),
+		Q_UINT64_C(0xBB434A2DEE7269E7), Q_UINT64_C(0x78CB67ECF931FA38),
+		Q_UINT64_C(0xF33B0372323BBF9C), Q_UINT64_C(0x52D66336FB279C74),
+		Q_UINT64_C(0x505F33AC0AFB4EAA), Q_UINT64_C(0xE8A5CD99A2CCE187),
+		Q_UINT64_C(0x534974801E2D30BB), Q_UINT64_C(0x8D2D5711D5876D90),
+		Q_UINT64_C(0x1F1A412891BC038E), Q_UINT64_C(0xD6E2E71D82E56648),
+		Q_UINT64_C(0x74036C3A497732B7), Q_UINT64_C(0x89B67ED96361F5AB),
+		Q_UINT64_C(0xFFED95D8F1EA02A2), Q_UINT64_C(0xE72B3BD61464D43D),
+		Q_UINT64_C(0xA6300F170BDC4820), Q_UINT64_C(0xEBC18760ED78A77A)
+	},
+	{
+		Q_UINT64_C(0xE6A6BE5A05A12138), Q_UINT64_C(0xB5A122A5B4F87C98),
+		Q_UINT64_C(0x563C6089140B6990), Q_UINT64_C(0x4C46CB2E391F5DD5),
+		Q_UINT64_C(0xD932ADDBC9B79434), Q_UINT64_C(0x08EA70E42015AFF5),
+		Q_UINT64_C(0xD765A6673E478CF1), Q_UINT64_C(0xC4FB757EAB278D99),
+		Q_UINT64_C(0xDF11C6862D6E0692), Q_UINT64_C(0xDDEB84F10D7F3B16),
+		Q_UINT64_C(0x6F2EF604A665EA04), Q_UINT64_C(0x4A8E0F0FF0E0DFB3),
+		Q_UINT64_C(0xA5EDEEF83DBCBA51), Q_UINT64_C(0xFC4F0A2A0EA4371E),
+		Q_UINT64_C(0xE83E1DA85CB38429), Q_UINT64_C(0xDC8FF882BA1B1CE2),
+		Q_UINT64_C(0xCD45505E8353E80D), Q_UINT64_C(0x18D19A00D4DB0717),
+		Q_UINT64_C(0x34A0CFEDA5F38101), Q_UINT64_C(0x0BE77E518887CAF2),
+		Q_UINT64_C(0x1E341438B3C45136), Q_UINT64_C(0xE05797F49089CCF9),
+		Q_UINT64_C(0xFFD23F9DF2591D14), Q_UINT64_C(0x543DDA228595C5CD),
+		Q_UINT64_C(0x661F81FD99052A33), Q_UINT64_C(0x8736E641DB0F7B76),
+		Q_UINT64_C(0x15227725418E5307), Q_UINT64_C(0xE25F7F46162EB2FA),
+		Q_UINT64_C(0x48A8B2126C13D9FE), Q_UINT64_C(0xAFDC541792E76EEA),
+		Q_UINT64_C(0x03D912BFC6D1898F), Q_UINT64_C(0x31B1AAFA1B83F51B),
+		Q_UINT64_C(0xF1AC2796E42AB7D9), Q_UINT64_C(0x40A3A7D7FCD2EBAC),
+		Q_UINT64_C(0x1056136D0AFBBCC5), Q_UINT64_C(0x7889E1DD9A6D0C85),
+		Q_UINT64_C(0xD33525782A7974AA), Q_UINT64_C(0xA7E25D09078AC09B),
+		Q_UINT64_C(0xBD4138B3EAC6EDD0), Q_UINT64_C(0x920ABFBE71EB9E70),
+		Q_UINT64_C(0xA2A5D0F54FC2625C), Q_UINT64_C(0xC054E36B0B1290A3),
+		Q_UINT64_C(0xF6DD59FF62FE932B), Q_UINT64_C(0x3537354511A8AC7D),
+		Q_UINT64_C(0xCA845E9172FADCD4), Q_UINT64_C(0x84F82B60329D20DC),
+		Q_UINT64_C(0x79C62CE1CD672F18), Q_UINT64_C(0x8B09A2ADD124642C),
+		Q_UINT64_C(0xD0C1E96A19D9E726), Q_UINT64_C(0x5A786A9B4BA9500C),
+		Q_UINT64_C(0x0E020336634C43F3), Q_UINT64_C(0xC17B474AEB66D822),
+		Q_UINT64_C(0x6A731AE3EC9BAAC2), Q_UINT64_C(0x8226667AE0840258),
+		Q_UINT64_C(0x67D4567691CAECA5), Q_UINT64_C(0x1D94155C4875ADB5),
+		Q_UINT64_C(0x6D00FD985B813FDF), Q_UINT64_C(0x51286EFCB774CD06),
+		Q_UINT64_C(0x5E8834471FA744AF), Q_UINT64_C(0xF72CA0AEE761AE2E),
+		Q_UINT64_C(0xBE40E4CDAEE8E09A), Q_UINT64_C(0xE9970BBB5118F665),
+		Q_UINT64_C(0x726E4BEB33DF1964), Q_UINT64_C(0x703B000729199762),
+		Q_UINT64_C(0x4631D816F5EF30A7), Q_UINT64_C(0xB880B5B51504A6BE),
+		Q_UINT64_C(0x641793C37ED84B6C), Q_UINT64_C(0x7B21ED77F6E97D96),
+		Q_UINT64_C(0x776306312EF96B73), Q_UINT64_C(0xAE528948E86FF3F4),
+		Q_UINT64_C(0x53DBD7F286A3F8F8), Q_UINT64_C(0x16CADCE74CFC1063),
+		Q_UINT64_C(0x005C19BDFA52C6DD), Q_UINT64_C(0x68868F5D64D46AD3),
+		Q_UINT64_C(0x3A9D512CCF1E186A), Q_UINT64_C(0x367E62C2385660AE),
+		Q_UINT64_C(0xE359E7EA77DCB1D7), Q_UINT64_C(0x526C0773749ABE6E),
+		Q_UINT64_C(0x735AE5F9D09F734B), Q_UINT64_C(0x493FC7CC8A558BA8),
+		Q_UINT64_C(0xB0B9C1533041AB45), Q_UINT64_C(0x321958BA470A59BD),
+		Q_UINT64_C(0x852DB00B5F46C393), Q_UINT64_C(0x91209B2BD336B0E5),
+		Q_UINT64_C(0x6E604F7D659EF19F), Q_UINT64_C(0xB99A8AE2782CCB24),
+		Q_UINT64_C(0xCCF52AB6C814C4C7), Q_UINT64_C(0x4727D9AFBE11727B),
+		Q_UINT64_C(0x7E950D0C0121B34D), Q_UINT64_C(0x756F435670AD471F),
+		Q_UINT64_C(0xF5ADD442615A6849), Q_UINT64_C(0x4E87E09980B9957A),
+		Q_UINT64_C(0x2ACFA1DF50AEE355), Q_UINT64_C(0xD898263AFD2FD556),
+		Q_UINT64_C(0xC8F4924DD80C8FD6), Q_UINT64_C(0xCF99CA3D754A173A),
+		Q_UINT64_C(0xFE477BACAF91BF3C), Q_UINT64_C(0xED5371F6D690C12D),
+		Q_UINT64_C(0x831A5C285E687094), Q_UINT64_C(0xC5D3C90A3708A0A4),
+		Q_UINT64_C(0x0F7F903717D06580), Q_UINT64_C(0x19F9BB13B8FDF27F),
+		Q_UINT64_C(0xB1BD6F1B4D502843), Q_UINT64_C(0x1C761BA38FFF4012),
+		Q_UINT64_C(0x0D1530C4E2E21F3B), Q_UINT64_C(0x8943CE69A7372C8A),
+		Q_UINT64_C(0xE5184E11FEB5CE66), Q_UINT64_C(0x618BDB80BD736621),
+		Q_UINT64_C(0x7D29BAD68B574D0B), Q_UINT64_C(0x81BB613E25E6FE5B),
+		Q_UINT64_C(0x071C9C10BC07913F), Q_UINT64_C(0xC7BEEB7909AC2D97),
+		Q_UINT64_C(0xC3E58D353BC5D757), Q_UINT64_C(0xEB017892F38F61E8),
+		Q_UINT64_C(0xD4EFFB9C9B1CC21A), Q_UINT64_C(0x99727D26F494F7AB),
+		Q_UINT64_C(0xA3E063A2956B3E03), Q_UINT64_C(0x9D4A8B9A4AA09C30),
+		Q_UINT64_C(0x3F6AB7D500090FB4), Q_UINT64_C(0x9CC0F2A057268AC0),
+		Q_UINT64_C(0x3DEE9D2DEDBF42D1), Q_UINT64_C(0x330F49C87960A972),
+		Q_UINT64_C(0xC6B2720287421B41), Q_UINT64_C(0x0AC59EC07C00369C),
+		Q_UINT64_C(0xEF4EAC49CB353425), Q_UINT64_C(0xF450244EEF0129D8),
+		Q_UINT64_C(0x8ACC46E5CAF4DEB6), Q_UINT64_C(0x2FFEAB63989263F7),
+		Q_UINT64_C(0x8F7CB9FE5D7A4578), Q_UINT64_C(0x5BD8F7644E634635),
+		Q_UINT64_C(0x427A7315BF2DC900), Q_UINT64_C(0x17D0C4AA2125261C),
+		Q_UINT64_C(0x3992486C93518E50), Q_UINT64_C(0xB4CBFEE0A2D7D4C3),
+		Q_UINT64_C(0x7C75D6202C5DDD8D), Q_UINT64_C(0xDBC295D8E35B6C61),
+		Q_UINT64_C(0x60B369D302032B19), Q_UINT64_C(0xCE42685FDCE44132),
+		Q_UINT64_C(0x06F3DDB9DDF65610), Q_UINT64_C(0x8EA4D21DB5E148F0),
+		Q_UINT64_C(0x20B0FCE62FCD496F), Q_UINT64_C(0x2C1B912358B0EE31),
+		Q_UINT64_C(0xB28317B818F5A308), Q_UINT64_C(0xA89C1E189CA6D2CF),
+		Q_UINT64_C(0x0C6B18576AAADBC8), Q_UINT64_C(0xB65DEAA91299FAE3),
+		Q_UINT64_C(0xFB2B794B7F1027E7), Q_UINT64_C(0x04E4317F443B5BEB),
+		Q_UINT64_C(0x4B852D325939D0A6), Q_UINT64_C(0xD5AE6BEEFB207FFC),
+		Q_UINT64_C(0x309682B281C7D374), Q_UINT64_C(0xBAE309A194C3B475),
+		Q_UINT64_C(0x8CC3F97B13B49F05), Q_UINT64_C(0x98A9422FF8293967),
+		Q_UINT64_C(0x244B16B01076FF7C), Q_UINT64_C(0xF8BF571C663D67EE),
+		Q_UINT64_C(0x1F0D6758EEE30DA1), Q_UINT64_C(0xC9B611D97ADEB9B7),
+		Q_UINT64_C(0xB7AFD5887B6C57A2), Q_UINT64_C(0x6290AE846B984FE1),
+		Q_UINT64_C(0x94DF4CDEACC1A5FD), Q_UINT64_C(0x058A5BD1C5483AFF),
+		Q_UINT64_C(0x63166CC142BA3C37), Q_UINT64_C(0x8DB8526EB2F76F40),
+		Q_UINT64_C(0xE10880036F0D6D4E), Q_UINT64_C(0x9E0523C9971D311D),
+		Q_UINT64_C(0x45EC2824CC7CD691), Q_UINT64_C(0x575B8359E62382C9),
+		Q_UINT64_C(0xFA9E400DC4889995), Q_UINT64_C(0xD1823ECB45721568),
+		Q_UINT64_C(0xDAFD983B8206082F), Q_UINT64_C(0xAA7D29082386A8CB),
+		Q_UINT64_C(0x269FCD4403B87588), Q_UINT64_C(0x1B91F5F728BDD1E0),
+		Q_UINT64_C(0xE4669F39040201F6), Q_UINT64_C(0x7A1D7C218CF04ADE),
+		Q_UINT64_C(0x65623C29D79CE5CE), Q_UINT64_C(0x2368449096C00BB1),
+		Q_UINT64_C(0xAB9BF1879DA503BA), Q_UINT64_C(0xBC23ECB1A458058E),
+		Q_UINT64_C(0x9A58DF01BB401ECC), Q_UINT64_C(0xA070E868A85F143D),
+		Q_UINT64_C(0x4FF188307DF2239E), Q_UINT64_C(0x14D565B41A641183),
+		Q_UINT64_C(0xEE13337452701602), Q_UINT64_C(0x950E3DCF3F285E09),
+		Q_UINT64_C(0x59930254B9C80953), Q_UINT64_C(0x3BF299408930DA6D),
+		Q_UINT64_C(0xA955943F53691387), Q_UINT64_C(0xA15EDECAA9CB8784),
+		Q_UINT64_C(0x29142127352BE9A0), Q_UINT64_C(0x76F0371FFF4E7AFB),
+		Q_UINT64_C(0x0239F450274F2228), Q_UINT64_C(0xBB073AF01D5E868B),
+		Q_UINT64_C(0xBFC80571C10E96C1), Q_UINT64_C(0xD267088568222E23),
+		Q_UINT64_C(0x9671A3D48E80B5B0), Q_UINT64_C(0x55B5D38AE193BB81),
+		Q_UINT64_C(0x693AE2D0A18B04B8), Q_UINT64_C(0x5C48B4ECADD5335F),
+		Q_UINT64_C(0xFD743B194916A1CA), Q_UINT64_C(0x2577018134BE98C4),
+		Q_UINT64_C(0xE77987E83C54A4AD), Q_UINT64_C(0x28E11014DA33E1B9),
+		Q_UINT64_C(0x270CC59E226AA213), Q_UINT64_C(0x71495F756D1A5F60),
+		Q_UINT64_C(0x9BE853FB60AFEF77), Q_UINT64_C(0xADC786A7F7443DBF),
+		Q_UINT64_C(0x0904456173B29A82), Q_UINT64_C(0x58BC7A66C232BD5E),
+		Q_UINT64_C(0xF306558C673AC8B2), Q_UINT64_C(0x41F639C6B6C9772A),
+		Q_UINT64_C(0x216DEFE99FDA35DA), Q_UINT64_C(0x11640CC71C7BE615),
+		Q_UINT64_C(0x93C43694565C5527), Q_UINT64_C(0xEA038E6246777839),
+		Q_UINT64_C(0xF9ABF3CE5A3E2469), Q_UINT64_C(0x741E768D0FD312D2),
+		Q_UINT64_C(0x0144B883CED652C6), Q_UINT64_C(0xC20B5A5BA33F8552),
+		Q_UINT64_C(0x1AE69633C3435A9D), Q_UINT64_C(0x97A28CA4088CFDEC),
+		Q_UINT64_C(0x8824A43C1E96F420), Q_UINT64_C(0x37612FA66EEEA746),
+		Q_UINT64_C(0x6B4CB165F9CF0E5A), Q_UINT64_C(0x43AA1C06A0ABFB4A),
+		Q_UINT64_C(0x7F4DC26FF162796B), Q_UINT64_C(0x6CBACC8E54ED9B0F),
+		Q_UINT64_C(0xA6B7FFEFD2BB253E), Q_UINT64_C(0x2E25BC95B0A29D4F),
+		Q_UINT64_C(0x86D6A58BDEF1388C), Q_UINT64_C(0xDED74AC576B6F054),
+		Q_UINT64_C(0x8030BDBC2B45805D), Q_UINT64_C(0x3C81AF70E94D9289),
+		Q_UINT64_C(0x3EFF6DDA9E3100DB), Q_UINT64_C(0xB38DC39FDFCC8847),
+		Q_UINT64_C(0x123885528D17B87E), Q_UINT64_C(0xF2DA0ED240B1B642),
+		Q_UINT64_C(0x44CEFADCD54BF9A9), Q_UINT64_C(0x1312200E433C7EE6),
+		Q_UINT64_C(0x9FFCC84F3A78C748), Q_UINT64_C(0xF0CD1F72248576BB),
+		Q_UINT64_C(0xEC6974053638CFE4), Q_UINT64_C(0x2BA7B67C0CEC4E4C),
+		Q_UINT64_C(0xAC2F4DF3E5CE32ED), Q_UINT64_C(0xCB33D14326EA4C11),
+		Q_UINT64_C(0xA4E9044CC77E58BC), Q_UINT64_C(0x5F513293D934FCEF),
+		Q_UINT64_C(0x5DC9645506E55444), Q_UINT64_C(0x50DE418F317DE40A),
+		Q_UINT64_C(0x388CB31A69DDE259), Q_UINT64_C(0x2DB4A83455820A86),
+		Q_UINT64_C(0x9010A91E84711AE9), Q_UINT64_C(0x4DF7F0B7B1498371),
+		Q_UINT64_C(0xD62A2EABC0977179), Q_UINT64_C(0x22FAC097AA8D5C0E)
+	},
+	{
+		Q_UINT64_C(0xF49FCC2FF1DAF39B), Q_UINT64_C(0x487FD5C66FF29281),
+		Q_UINT64_C(0xE8A30667FCDCA83F), Q_UINT64_C(0x2C9B4BE3D2FCCE63),
+		Q_UINT64_C(0xDA3FF74B93FBBBC2), Q_UINT64_C(0x2FA165D2FE70BA66),
+		Q_UINT64_C(0xA103E279970E93D4), Q_UINT64_C(0xBECDEC77B0E45E71),
+		Q_UINT64_C(0xCFB41E723985E497), Q_UINT64_C(0xB70AAA025EF75017),
+		Q_UINT64_C(0xD42309F03840B8E0), Q_UINT64_C(0x8EFC1AD035898579),
+		Q_UINT64_C(0x96C6920BE2B2ABC5), Q_UINT64_C(0x66AF4163375A9172),
+		Q_UINT64_C(0x2174ABDCCA7127FB), Q_UINT64_C(0xB33CCEA64A72FF41),
+		Q_UINT64_C(0xF04A4933083066A5), Q_UINT64_C(0x8D970ACDD7289AF5),
+		Q_UINT64_C(0x8F96E8E031C8C25E), Q_UINT64_C(0xF3FEC02276875D47),
+		Q_UINT64_C(0xEC7BF310056190DD), Q_UINT64_C(0xF5ADB0AEBB0F1491),
+		Q_UINT64_C(0x9B50F8850FD58892), Q_UINT64_C(0x4975488358B74DE8),
+		Q_UINT64_C(0xA3354FF691531C61), Q_UINT64_C(0x0702BBE481D2C6EE),
+		Q_UINT64_C(0x89FB24057DEDED98), Q_UINT64_C(0xAC3075138596E902),
+		Q_UINT64_C(0x1D2D3580172772ED), Q_UINT64_C(0xEB738FC28E6BC30D),
+		Q_UINT64_C(0x5854EF8F63044326), Q_UINT64_C(0x9E5C52325ADD3BBE),
+		Q_UINT64_C(0x90AA53CF325C4623), Q_UINT64_C(0xC1D24D51349DD067),
+		Q_UINT64_C(0x2051CFEEA69EA624), Q_UINT64_C(0x13220F0A862E7E4F),
+		Q_UINT64_C(0xCE39399404E04864), Q_UINT64_C(0xD9C42CA47086FCB7),
+		Q_UINT64_C(0x685AD2238A03E7CC), Q_UINT64_C(0x066484B2AB2FF1DB),
+		Q_UINT64_C(0xFE9D5D70EFBF79EC), Q_UINT64_C(0x5B13B9DD9C481854),
+		Q_UINT64_C(0x15F0D475ED1509AD), Q_UINT64_C(0x0BEBCD060EC79851),
+		Q_UINT64_C(0xD58C6791183AB7F8), Q_UINT64_C(0xD1187C5052F3EEE4),
+		Q_UINT64_C(0xC95D1192E54E82FF), Q_UINT64_C(0x86EEA14CB9AC6CA2),
+		Q_UINT64_C(0x3485BEB153677D5D), Q_UINT64_C(0xDD191D781F8C492A),
+		Q_UINT64_C(0xF60866BAA784EBF9), Q_UINT64_C(0x518F643BA2D08C74),
+		Q_UINT64_C(0x8852E956E1087C22), Q_UINT64_C(0xA768CB8DC410AE8D),
+		Q_UINT64_C(0x38047726BFEC8E1A), Q_UINT64_C(0xA67738B4CD3B45AA),
+		Q_UINT64_C(0xAD16691CEC0DDE19), Q_UINT64_C(0xC6D4319380462E07),
+		Q_UINT64_C(0xC5A5876D0BA61938), Q_UINT64_C(0x16B9FA1FA58FD840),
+		Q_UINT64_C(0x188AB1173CA74F18), Q_UINT64_C(0xABDA2F98C99C021F),
+		Q_UINT64_C(0x3E0580AB134AE816), Q_UINT64_C(0x5F3B05B773645ABB),
+		Q_UINT64_C(0x2501A2BE5575F2F6), Q_UINT64_C(0x1B2F74004E7E8BA9),
+		Q_UINT64_C(0x1CD7580371E8D953), Q_UINT64_C(0x7F6ED89562764E30),
+		Q_UINT64_C(0xB15926FF596F003D), Q_UINT64_C(0x9F65293DA8C5D6B9),
+		Q_UINT64_C(0x6ECEF04DD690F84C), Q_UINT64_C(0x4782275FFF33AF88),
+		Q_UINT64_C(0xE41433083F820801), Q_UINT64_C(0xFD0DFE409A1AF9B5),
+		Q_UINT64_C(0x4325A3342CDB396B), Q_UINT64_C(0x8AE77E62B301B252),
+		Q_UINT64_C(0xC36F9E9F6655615A), Q_UINT64_C(0x85455A2D92D32C09),
+		Q_UINT64_C(0xF2C7DEA949477485), Q_UINT64_C(0x63CFB4C133A39EBA),
+		Q_UINT64_C(0x83B040CC6EBC5462), Q_UINT64_C(0x3B9454C8FDB326B0),
+		Q_UINT64_C(0x56F56A9E87FFD78C), Q_UINT64_C(0x2DC2940D99F42BC6),
+		Q_UINT64_C(0x98F7DF096B096E2D), Q_UINT64_C(0x19A6E01E3AD852BF),
+		Q_UINT64_C(0x42A99CCBDBD4B40B), Q_UINT64_C(0xA59998AF45E9C559),
+		Q_UINT64_C(0x366295E807D93186), Q_UINT64_C(0x6B48181BFAA1F773),
+		Q_UINT64_C(0x1FEC57E2157A0A1D), Q_UINT64_C(0x4667446AF6201AD5),
+		Q_UINT64_C(0xE615EBCACFB0F075), Q_UINT64_C(0xB8F31F4F68290778),
+		Q_UINT64_C(0x22713ED6CE22D11E), Q_UINT64_C(0x3057C1A72EC3C93B),
+		Q_UINT64_C(0xCB46ACC37C3F1F2F), Q_UINT64_C(0xDBB893FD02AAF50E),
+		Q_UINT64_C(0x331FD92E600B9FCF), Q_UINT64_C(0xA498F96148EA3AD6),
+		Q_UINT64_C(0xA8D8426E8B6A83EA), Q_UINT64_C(0xA089B274B7735CDC),
+		Q_UINT64_C(0x87F6B3731E524A11), Q_UINT64_C(0x118808E5CBC96749),
+		Q_UINT64_C(0x9906E4C7B19BD394), Q_UINT64_C(0xAFED7F7E9B24A20C),
+		Q_UINT64_C(0x6509EADEEB3644A7), Q_UINT64_C(0x6C1EF1D3E8EF0EDE),
+		Q_UINT64_C(0xB9C97D43E9798FB4), Q_UINT64_C(0xA2F2D784740C28A3),
+		Q_UINT64_C(0x7B8496476197566F), Q_UINT64_C(0x7A5BE3E6B65F069D),
+		Q_UINT64_C(0xF96330ED78BE6F10), Q_UINT64_C(0xEEE60DE77A076A15),
+		Q_UINT64_C(0x2B4BEE4AA08B9BD0), Q_UINT64_C(0x6A56A63EC7B8894E),
+		Q_UINT64_C(0x02121359BA34FEF4), Q_UINT64_C(0x4CBF99F8283703FC),
+		Q_UINT64_C(0x398071350CAF30C8), Q_UINT64_C(0xD0A77A89F017687A),
+		Q_UINT64_C(0xF1C1A9EB9E423569), Q_UINT64_C(0x8C7976282DEE8199),
+		Q_UINT64_C(0x5D1737A5DD1F7ABD), Q_UINT64_C(0x4F53433C09A9FA80),
+		Q_UINT64_C(0xFA8B0C53DF7CA1D9), Q_UINT64_C(0x3FD9DCBC886CCB77),
+		Q_UINT64_C(0xC040917CA91B4720), Q_UINT64_C(0x7DD00142F9D1DCDF),
+		Q_UINT64_C(0x8476FC1D4F387B58), Q_UINT64_C(0x23F8E7C5F3316503),
+		Q_UINT64_C(0x032A2244E7E37339), Q_UINT64_C(0x5C87A5D750F5A74B),
+		Q_UINT64_C(0x082B4CC43698992E), Q_UINT64_C(0xDF917BECB858F63C),
+		Q_UINT64_C(0x3270B8FC5BF86DDA), Q_UINT64_C(0x10AE72BB29B5DD76),
+		Q_UINT64_C(0x576AC94E7700362B), Q_UINT64_C(0x1AD112DAC61EFB8F),
+		Q_UINT64_C(0x691BC30EC5FAA427), Q_UINT64_C(0xFF246311CC327143),
+		Q_UINT64_C(0x3142368E30E53206), Q_UINT64_C(0x71380E31E02CA396),
+		Q_UINT64_C(0x958D5C960AAD76F1), Q_UINT64_C(0xF8D6F430C16DA536),
+		Q_UINT64_C(0xC8FFD13F1BE7E1D2), Q_UINT64_C(0x7578AE66004DDBE1),
+		Q_UINT64_C(0x05833F01067BE646), Q_UINT64_C(0xBB34B5AD3BFE586D),
+		Q_UINT64_C(0x095F34C9A12B97F0), Q_UINT64_C(0x247AB64525D60CA8),
+		Q_UINT64_C(0xDCDBC6F3017477D1), Q_UINT64_C(0x4A2E14D4DECAD24D),
+		Q_UINT64_C(0xBDB5E6D9BE0A1EEB), Q_UINT64_C(0x2A7E70F7794301AB),
+		Q_UINT64_C(0xDEF42D8A270540FD), Q_UINT64_C(0x01078EC0A34C22C1),
+		Q_UINT64_C(0xE5DE511AF4C16387), Q_UINT64_C(0x7EBB3A52BD9A330A),
+		Q_UINT64_C(0x77697857AA7D6435), Q_UINT64_C(0x004E831603AE4C32),
+		Q_UINT64_C(0xE7A21020AD78E312), Q_UINT64_C(0x9D41A70C6AB420F2),
+		Q_UINT64_C(0x28E06C18EA1141E6), Q_UINT64_C(0xD2B28CBD984F6B28),
+		Q_UINT64_C(0x26B75F6C446E9D83), Q_UINT64_C(0xBA47568C4D418D7F),
+		Q_UINT64_C(0xD80BADBFE6183D8E), Q_UINT64_C(0x0E206D7F5F166044),
+		Q_UINT64_C(0xE258A43911CBCA3E), Q_UINT64_C(0x723A1746B21DC0BC),
+		Q_UINT64_C(0xC7CAA854F5D7CDD3), Q_UINT64_C(0x7CAC32883D261D9C),
+		Q_UINT64_C(0x7690C26423BA942C), Q_UINT64_C(0x17E55524478042B8),
+		Q_UINT64_C(0xE0BE477656A2389F), Q_UINT64_C(0x4D289B5E67AB2DA0),
+		Q_UINT64_C(0x44862B9C8FBBFD31), Q_UINT64_C(0xB47CC8049D141365),
+		Q_UINT64_C(0x822C1B362B91C793), Q_UINT64_C(0x4EB14655FB13DFD8),
+		Q_UINT64_C(0x1ECBBA0714E2A97B), Q_UINT64_C(0x6143459D5CDE5F14),
+		Q_UINT64_C(0x53A8FBF1D5F0AC89), Q_UINT64_C(0x97EA04D81C5E5B00),
+		Q_UINT64_C(0x622181A8D4FDB3F3), Q_UINT64_C(0xE9BCD341572A1208),
+		Q_UINT64_C(0x1411258643CCE58A), Q_UINT64_C(0x9144C5FEA4C6E0A4),
+		Q_UINT64_C(0x0D33D06565CF620F), Q_UINT64_C(0x54A48D489F219CA1),
+		Q_UINT64_C(0xC43E5EAC6D63C821), Q_UINT64_C(0xA9728B3A72770DAF),
+		Q_UINT64_C(0xD7934E7B20DF87EF), Q_UINT64_C(0xE35503B61A3E86E5),
+		Q_UINT64_C(0xCAE321FBC819D504), Q_UINT64_C(0x129A50B3AC60BFA6),
+		Q_UINT64_C(0xCD5E68EA7E9FB6C3), Q_UINT64_C(0xB01C90199483B1C7),
+		Q_UINT64_C(0x3DE93CD5C295376C), Q_UINT64_C(0xAED52EDF2AB9AD13),
+		Q_UINT64_C(0x2E60F512C0A07884), Q_UINT64_C(0xBC3D86A3E36210C9),
+		Q_UINT64_C(0x35269D9B163951CE), Q_UINT64_C(0x0C7D6E2AD0CDB5FA),
+		Q_UINT64_C(0x59E86297D87F5733), Q_UINT64_C(0x298EF221898DB0E7),
+		Q_UINT64_C(0x55000029D1A5AA7E), Q_UINT64_C(0x8BC08AE1B5061B45),
+		Q_UINT64_C(0xC2C31C2B6C92703A), Q_UINT64_C(0x94CC596BAF25EF42),
+		Q_UINT64_C(0x0A1D73DB22540456), Q_UINT64_C(0x04B6A0F9D9C4179A),
+		Q_UINT64_C(0xEFFDAFA2AE3D3C60), Q_UINT64_C(0xF7C8075BB49496C4),
+		Q_UINT64_C(0x9CC5C7141D1CD4E3), Q_UINT64_C(0x78BD1638218E5534),
+		Q_UINT64_C(0xB2F11568F850246A), Q_UINT64_C(0xEDFABCFA9502BC29),
+		Q_UINT64_C(0x796CE5F2DA23051B), Q_UINT64_C(0xAAE128B0DC93537C),
+		Q_UINT64_C(0x3A493DA0EE4B29AE), Q_UINT64_C(0xB5DF6B2C416895D7),
+		Q_UINT64_C(0xFCABBD25122D7F37), Q_UINT64_C(0x70810B58105DC4B1),
+		Q_UINT64_C(0xE10FDD37F7882A90), Q_UINT64_C(0x524DCAB5518A3F5C),
+		Q_UINT64_C(0x3C9E85878451255B), Q_UINT64_C(0x4029828119BD34E2),
+		Q_UINT64_C(0x74A05B6F5D3CECCB), Q_UINT64_C(0xB610021542E13ECA),
+		Q_UINT64_C(0x0FF979D12F59E2AC), Q_UINT64_C(0x6037DA27E4F9CC50),
+		Q_UINT64_C(0x5E92975A0DF1847D), Q_UINT64_C(0xD66DE190D3E623FE),
+		Q_UINT64_C(0x5032D6B87B568048), Q_UINT64_C(0x9A36B7CE8235216E),
+		Q_UINT64_C(0x80272A7A24F64B4A), Q_UINT64_C(0x93EFED8B8C6916F7),
+		Q_UINT64_C(0x37DDBFF44CCE1555), Q_UINT64_C(0x4B95DB5D4B99BD25),
+		Q_UINT64_C(0x92D3FDA169812FC0), Q_UINT64_C(0xFB1A4A9A90660BB6),
+		Q_UINT64_C(0x730C196946A4B9B2), Q_UINT64_C(0x81E289AA7F49DA68),
+		Q_UINT64_C(0x64669A0F83B1A05F), Q_UINT64_C(0x27B3FF7D9644F48B),
+		Q_UINT64_C(0xCC6B615C8DB675B3), Q_UINT64_C(0x674F20B9BCEBBE95),
+		Q_UINT64_C(0x6F31238275655982), Q_UINT64_C(0x5AE488713E45CF05),
+		Q_UINT64_C(0xBF619F9954C21157), Q_UINT64_C(0xEABAC46040A8EAE9),
+		Q_UINT64_C(0x454C6FE9F2C0C1CD), Q_UINT64_C(0x419CF6496412691C),
+		Q_UINT64_C(0xD3DC3BEF265B0F70), Q_UINT64_C(0x6D0E60F5C3578A9E)
+	},
+	{
+		Q_UINT64_C(0x5B0E608526323C55), Q_UINT64_C(0x1A46C1A9FA1B59F5),
+		Q_UINT64_C(0xA9E245A17C4C8FFA), Q_UINT64_C(0x65CA5159DB2955D7),
+		Q_UINT64_C(0x05DB0A76CE35AFC2), Q_UINT64_C(0x81EAC77EA9113D45),
+		Q_UINT64_C(0x528EF88AB6AC0A0D), Q_UINT64_C(0xA09EA253597BE3FF),
+		Q_UINT64_C(0x430DDFB3AC48CD56), Q_UINT64_C(0xC4B3A67AF45CE46F),
+		Q_UINT64_C(0x4ECECFD8FBE2D05E), Q_UINT64_C(0x3EF56F10B39935F0),
+		Q_UINT64_C(0x0B22D6829CD619C6), Q_UINT64_C(0x17FD460A74DF2069),
+		Q_UINT64_C(0x6CF8CC8E8510ED40), Q_UINT64_C(0xD6C824BF3A6ECAA7),
+		Q_UINT64_C(0x61243D581A817049), Q_UINT64_C(0x048BACB6BBC163A2),
+		Q_UINT64_C(0xD9A38AC27D44CC32), Q_UINT64_C(0x7FDDFF5BAAF410AB),
+		Q_UINT64_C(0xAD6D495AA804824B), Q_UINT64_C(0xE1A6A74F2D8C9F94),
+		Q_UINT64_C(0xD4F7851235DEE8E3), Q_UINT64_C(0xFD4B7F886540D893),
+		Q_UINT64_C(0x247C20042AA4BFDA), Q_UINT64_C(0x096EA1C517D1327C),
+		Q_UINT64_C(0xD56966B4361A6685), Q_UINT64_C(0x277DA5C31221057D),
+		Q_UINT64_C(0x94D59893A43ACFF7), Q_UINT64_C(0x64F0C51CCDC02281),
+		Q_UINT64_C(0x3D33BCC4FF6189DB), Q_UINT64_C(0xE005CB184CE66AF1),
+		Q_UINT64_C(0xFF5CCD1D1DB99BEA), Q_UINT64_C(0xB0B854A7FE42980F),
+		Q_UINT64_C(0x7BD46A6A718D4B9F), Q_UINT64_C(0xD10FA8CC22A5FD8C),
+		Q_UINT64_C(0xD31484952BE4BD31), Q_UINT64_C(0xC7FA975FCB243847),
+		Q_UINT64_C(0x4886ED1E5846C407), Q_UINT64_C(0x28CDDB791EB70B04),
+		Q_UINT64_C(0xC2B00BE2F573417F), Q_UINT64_C(0x5C9590452180F877),
+		Q_UINT64_C(0x7A6BDDFFF370EB00), Q_UINT64_C(0xCE509E38D6D9D6A4),
+		Q_UINT64_C(0xEBEB0F00647FA702), Q_UINT64_C(0x1DCC06CF76606F06),
+		Q_UINT64_C(0xE4D9F28BA286FF0A), Q_UINT64_C(0xD85A305DC918C262),
+		Q_UINT64_C(0x475B1D8732225F54), Q_UINT64_C(0x2D4FB51668CCB5FE),
+		Q_UINT64_C(0xA679B9D9D72BBA20), Q_UINT64_C(0x53841C0D912D43A5),
+		Q_UINT64_C(0x3B7EAA48BF12A4E8), Q_UINT64_C(0x781E0E47F22F1DDF),
+		Q_UINT64_C(0xEFF20CE60AB50973), Q_UINT64_C(0x20D261D19DFFB742),
+		Q_UINT64_C(0x16A12B03062A2E39), Q_UINT64_C(0x1960EB2239650495),
+		Q_UINT64_C(0x251C16FED50EB8B8), Q_UINT64_C(0x9AC0C330F826016E),
+		Q_UINT64_C(0xED152665953E7671), Q_UINT64_C(0x02D63194A6369570),
+		Q_UINT64_C(0x5074F08394B1C987), Q_UINT64_C(0x70BA598C90B25CE1),
+		Q_UINT64_C(0x794A15810B9742F6), Q_UINT64_C(0x0D5925E9FCAF8C6C),
+		Q_UINT64_C(0x3067716CD868744E), Q_UINT64_C(0x910AB077E8D7731B),
+		Q_UINT64_C(0x6A61BBDB5AC42F61), Q_UINT64_C(0x93513EFBF0851567),
+		Q_UINT64_C(0xF494724B9E83E9D5), Q_UINT64_C(0xE887E1985C09648D),
+		Q_UINT64_C(0x34B1D3C675370CFD), Q_UINT64_C(0xDC35E433BC0D255D),
+		Q_UINT64_C(0xD0AAB84234131BE0), Q_UINT64_C(0x08042A50B48B7EAF),
+		Q_UINT64_C(0x9997C4EE44A3AB35), Q_UINT64_C(0x829A7B49201799D0),
+		Q_UINT64_C(0x263B8307B7C54441), Q_UINT64_C(0x752F95F4FD6A6CA6),
+		Q_UINT64_C(0x927217402C08C6E5), Q_UINT64_C(0x2A8AB754A795D9EE),
+		Q_UINT64_C(0xA442F7552F72943D), Q_UINT64_C(0x2C31334E19781208),
+		Q_UINT64_C(0x4FA98D7CEAEE6291), Q_UINT64_C(0x55C3862F665DB309),
+		Q_UINT64_C(0xBD0610175D53B1F3), Q_UINT64_C(0x46FE6CB840413F27),
+		Q_UINT64_C(0x3FE03792DF0CFA59), Q_UINT64_C(0xCFE700372EB85E8F),
+		Q_UINT64_C(0xA7BE29E7ADBCE118), Q_UINT64_C(0xE544EE5CDE8431DD),
+		Q_UINT64_C(0x8A781B1B41F1873E), Q_UINT64_C(0xA5C94C78A0D2F0E7),
+		Q_UINT64_C(0x39412E2877B60728), Q_UINT64_C(0xA1265EF3AFC9A62C),
+		Q_UINT64_C(0xBCC2770C6A2506C5), Q_UINT64_C(0x3AB66DD5DCE1CE12),
+		Q_UINT64_C(0xE65499D04A675B37), Q_UINT64_C(0x7D8F523481BFD216),
+		Q_UINT64_C(0x0F6F64FCEC15F389), Q_UINT64_C(0x74EFBE618B5B13C8),
+		Q_UINT64_C(0xACDC82B714273E1D), Q_UINT64_C(0xDD40BFE003199D17),
+		Q_UINT64_C(0x37E99257E7E061F8), Q_UINT64_C(0xFA52626904775AAA),
+		Q_UINT64_C(0x8BBBF63A463D56F9), Q_UINT64_C(0xF0013F1543A26E64),
+		Q_UINT64_C(0xA8307E9F879EC898), Q_UINT64_C(0xCC4C27A4150177CC),
+		Q_UINT64_C(0x1B432F2CCA1D3348), Q_UINT64_C(0xDE1D1F8F9F6FA013),
+		Q_UINT64_C(0x606602A047A7DDD6), Q_UINT64_C(0xD237AB64CC1CB2C7),
+		Q_UINT64_C(0x9B938E7225FCD1D3), Q_UINT64_C(0xEC4E03708E0FF476),
+		Q_UINT64_C(0xFEB2FBDA3D03C12D), Q_UINT64_C(0xAE0BCED2EE43889A),
+		Q_UINT64_C(0x22CB8923EBFB4F43), Q_UINT64_C(0x69360D013CF7396D),
+		Q_UINT64_C(0x855E3602D2D4E022), Q_UINT64_C(0x073805BAD01F784C),
+		Q_UINT64_C(0x33E17A133852F546), Q_UINT64_C(0xDF4874058AC7B638),
+		Q_UINT64_C(0xBA92B29C678AA14A), Q_UINT64_C(0x0CE89FC76CFAADCD),
+		Q_UINT64_C(0x5F9D4E0908339E34), Q_UINT64_C(0xF1AFE9291F5923B9),
+		Q_UINT64_C(0x6E3480F60F4A265F), Q_UINT64_C(0xEEBF3A2AB29B841C),
+		Q_UINT64_C(0xE21938A88F91B4AD), Q_UINT64_C(0x57DFEFF845C6D3C3),
+		Q_UINT64_C(0x2F006B0BF62CAAF2), Q_UINT64_C(0x62F479EF6F75EE78),
+		Q_UINT64_C(0x11A55AD41C8916A9), Q_UINT64_C(0xF229D29084FED453),
+		Q_UINT64_C(0x42F1C27B16B000E6), Q_UINT64_C(0x2B1F76749823C074),
+		Q_UINT64_C(0x4B76ECA3C2745360), Q_UINT64_C(0x8C98F463B91691BD),
+		Q_UINT64_C(0x14BCC93CF1ADE66A), Q_UINT64_C(0x8885213E6D458397),
+		Q_UINT64_C(0x8E177DF0274D4711), Q_UINT64_C(0xB49B73B5503F2951),
+		Q_UINT64_C(0x10168168C3F96B6B), Q_UINT64_C(0x0E3D963B63CAB0AE),
+		Q_UINT64_C(0x8DFC4B5655A1DB14), Q_UINT64_C(0xF789F1356E14DE5C),
+		Q_UINT64_C(0x683E68AF4E51DAC1), Q_UINT64_C(0xC9A84F9D8D4B0FD9),
+		Q_UINT64_C(0x3691E03F52A0F9D1), Q_UINT64_C(0x5ED86E46E1878E80),
+		Q_UINT64_C(0x3C711A0E99D07150), Q_UINT64_C(0x5A0865B20C4E9310),
+		Q_UINT64_C(0x56FBFC1FE4F0682E), Q_UINT64_C(0xEA8D5DE3105EDF9B),
+		Q_UINT64_C(0x71ABFDB12379187A), Q_UINT64_C(0x2EB99DE1BEE77B9C),
+		Q_UINT64_C(0x21ECC0EA33CF4523), Q_UINT64_C(0x59A4D7521805C7A1),
+		Q_UINT64_C(0x3896F5EB56AE7C72), Q_UINT64_C(0xAA638F3DB18F75DC),
+		Q_UINT64_C(0x9F39358DABE9808E), Q_UINT64_C(0xB7DEFA91C00B72AC),
+		Q_UINT64_C(0x6B5541FD62492D92), Q_UINT64_C(0x6DC6DEE8F92E4D5B),
+		Q_UINT64_C(0x353F57ABC4BEEA7E), Q_UINT64_C(0x735769D6DA5690CE),
+		Q_UINT64_C(0x0A234AA642391484), Q_UINT64_C(0xF6F9508028F80D9D),
+		Q_UINT64_C(0xB8E319A27AB3F215), Q_UINT64_C(0x31AD9C1151341A4D),
+		Q_UINT64_C(0x773C22A57BEF5805), Q_UINT64_C(0x45C7561A07968633),
+		Q_UINT64_C(0xF913DA9E249DBE36), Q_UINT64_C(0xDA652D9B78A64C68),
+		Q_UINT64_C(0x4C27A97F3BC334EF), Q_UINT64_C(0x76621220E66B17F4),
+		Q_UINT64_C(0x967743899ACD7D0B), Q_UINT64_C(0xF3EE5BCAE0ED6782),
+		Q_UINT64_C(0x409F753600C879FC), Q_UINT64_C(0x06D09A39B5926DB6),
+		Q_UINT64_C(0x6F83AEB0317AC588), Q_UINT64_C(0x01E6CA4A86381F21),
+		Q_UINT64_C(0x66FF3462D19F3025), Q_UINT64_C(0x72207C24DDFD3BFB),
+		Q_UINT64_C(0x4AF6B6D3E2ECE2EB), Q_UINT64_C(0x9C994DBEC7EA08DE),
+		Q_UINT64_C(0x49ACE597B09A8BC4), Q_UINT64_C(0xB38C4766CF0797BA),
+		Q_UINT64_C(0x131B9373C57C2A75), Q_UINT64_C(0xB1822CCE61931E58),
+		Q_UINT64_C(0x9D7555B909BA1C0C), Q_UINT64_C(0x127FAFDD937D11D2),
+		Q_UINT64_C(0x29DA3BADC66D92E4), Q_UINT64_C(0xA2C1D57154C2ECBC),
+		Q_UINT64_C(0x58C5134D82F6FE24), Q_UINT64_C(0x1C3AE3515B62274F),
+		Q_UINT64_C(0xE907C82E01CB8126), Q_UINT64_C(0xF8ED091913E37FCB),
+		Q_UINT64_C(0x3249D8F9C80046C9), Q_UINT64_C(0x80CF9BEDE388FB63),
+		Q_UINT64_C(0x1881539A116CF19E), Q_UINT64_C(0x5103F3F76BD52457),
+		Q_UINT64_C(0x15B7E6F5AE47F7A8), Q_UINT64_C(0xDBD7C6DED47E9CCF),
+		Q_UINT64_C(0x44E55C410228BB1A), Q_UINT64_C(0xB647D4255EDB4E99),
+		Q_UINT64_C(0x5D11882BB8AAFC30), Q_UINT64_C(0xF5098BBB29D3212A),
+		Q_UINT64_C(0x8FB5EA14E90296B3), Q_UINT64_C(0x677B942157DD025A),
+		Q_UINT64_C(0xFB58E7C0A390ACB5), Q_UINT64_C(0x89D3674C83BD4A01),
+		Q_UINT64_C(0x9E2DA4DF4BF3B93B), Q_UINT64_C(0xFCC41E328CAB4829),
+		Q_UINT64_C(0x03F38C96BA582C52), Q_UINT64_C(0xCAD1BDBD7FD85DB2),
+		Q_UINT64_C(0xBBB442C16082AE83), Q_UINT64_C(0xB95FE86BA5DA9AB0),
+		Q_UINT64_C(0xB22E04673771A93F), Q_UINT64_C(0x845358C9493152D8),
+		Q_UINT64_C(0xBE2A488697B4541E), Q_UINT64_C(0x95A2DC2DD38E6966),
+		Q_UINT64_C(0xC02C11AC923C852B), Q_UINT64_C(0x2388B1990DF2A87B),
+		Q_UINT64_C(0x7C8008FA1B4F37BE), Q_UINT64_C(0x1F70D0C84D54E503),
+		Q_UINT64_C(0x5490ADEC7ECE57D4), Q_UINT64_C(0x002B3C27D9063A3A),
+		Q_UINT64_C(0x7EAEA3848030A2BF), Q_UINT64_C(0xC602326DED2003C0),
+		Q_UINT64_C(0x83A7287D69A94086), Q_UINT64_C(0xC57A5FCB30F57A8A),
+		Q_UINT64_C(0xB56844E479EBE779), Q_UINT64_C(0xA373B40F05DCBCE9),
+		Q_UINT64_C(0xD71A786E88570EE2), Q_UINT64_C(0x879CBACDBDE8F6A0),
+		Q_UINT64_C(0x976AD1BCC164A32F), Q_UINT64_C(0xAB21E25E9666D78B),
+		Q_UINT64_C(0x901063AAE5E5C33C), Q_UINT64_C(0x9818B34448698D90),
+		Q_UINT64_C(0xE36487AE3E1E8ABB), Q_UINT64_C(0xAFBDF931893BDCB4),
+		Q_UINT64_C(0x6345A0DC5FBBD519), Q_UINT64_C(0x8628FE269B9465CA),
+		Q_UINT64_C(0x1E5D01603F9C51EC), Q_UINT64_C(0x4DE44006A15049B7),
+		Q_UINT64_C(0xBF6C70E5F776CBB1), Q_UINT64_C(0x411218F2EF552BED),
+		Q_UINT64_C(0xCB0C0708705A36A3), Q_UINT64_C(0xE74D14754F986044),
+		Q_UINT64_C(0xCD56D9430EA8280E), Q_UINT64_C(0xC12591D7535F5065),
+		Q_UINT64_C(0xC83223F1720AEF96), Q_UINT64_C(0xC3A0396F7363A51F)
+	}
+};
+
+#define TIGER_ROUND(a, b, c, x, mul) \
+	c ^= x; \
+	a -= TigerSBoxes[0][quint8(c)] ^ TigerSBoxes[1][quint8(c >> 16)] ^ TigerSBoxes[2][quint8(c >> 32)] ^ TigerSBoxes[3][quint8(c >> 48)]; \
+	b += TigerSBoxes[3][quint8(c >> 8)] ^ TigerSBoxes[2][quint8(c >> 24)] ^ TigerSBoxes[1][quint8(c >> 40)] ^ TigerSBoxes[0][quint8(c >> 56)]; \
+	b *= mul;
+
+#define TIGER_PASS(a, b, c, mul) \
+	TIGER_ROUND(a, b, c, x[0], mul) \
+	TIGER_ROUND(b, c, a, x[1], mul) \
+	TIGER_ROUND(c, a, b, x[2], mul) \
+	TIGER_ROUND(a, b, c, x[3], mul) \
+	TIGER_ROUND(b, c, a, x[4], mul) \
+	TIGER_ROUND(c, a, b, x[5], mul) \
+	TIGER_ROUND(a, b, c, x[6], mul) \
+	TIGER_ROUND(b, c, a, x[7], mul)
+
+#define TIGER_KEY_SCHEDULE \
+	x[0] -= x[7] ^ Q_UINT64_C(0xA5A5A5A5A5A5A5A5); \
+	x[1] ^= x[0]; \
+	x[2] += x[1]; \
+	x[3] -= x[2] ^ ((~x[1]) << 19); \
+	x[4] ^= x[3]; \
+	x[5] += x[4]; \
+	x[6] -= x[5] ^ ((~x[4]) >> 23); \
+	x[7] ^= x[6]; \
+	x[0] += x[7]; \
+	x[1] -= x[0] ^ ((~x[7]) << 19); \
+	x[2] ^= x[1]; \
+	x[3] += x[2]; \
+	x[4] -= x[3] ^ ((~x[2]) >> 23); \
+	x[5] ^= x[4]; \
+	x[6] += x[5]; \
+	x[7] -= x[6] ^ Q_UINT64_C(0x0123456789ABCDEF);
+
+CTiger::CTiger()
+{
+	reset();
+}
+
+void CTiger::reset()
+{
+	m_pState[0] = Q_UINT64_C(0x0123456789ABCDEF);
+	m_pState[1] = Q_UINT64_C(0xFEDCBA9876543210);
+	m_pState[2] = Q_UINT64_C(0xF096A5B4C3B2E187);
+	m_nLength = 0;
+}
+
+void CTiger::addData(const char* pData, quint32 nLength)
+{
+	const quint8* pInput = (const quint8*)pData;
+	quint32 nBuffered = quint32(m_nLength % BlockSize);
+
+	m_nLength += nLength;
+
+	if( nBuffered )
+	{
+		const quint32 nFill = qMin<quint32>(BlockSize - nBuffered, nLength);
+		memcpy(m_pBuffer + nBuffered, pInput, nFill);
+		pInput += nFill;
+		nLength -= nFill;
+
+		if( nBuffered + nFill < BlockSize )
+			return;
+
+		compress(m_pBuffer);
+	}
+
+	for( ; nLength >= BlockSize; pInput += BlockSize, nLength -= BlockSize )
+	{
+		compress(pInput);
+	}
+
+	if( nLength )
+		memcpy(m_pBuffer, pInput, nLength);
+}
+
+void CTiger::result(char* pDigest)
+{
+	quint32 nBuffered = quint32(m_nLength % BlockSize);
+
+	// original Tiger padding: 0x01, zeroes, then the length in bits
+	m_pBuffer[nBuffered++] = 0x01;
+
+	if( nBuffered > BlockSize - 8 )
+	{
+		memset(m_pBuffer + nBuffered, 0, BlockSize - nBuffered);
+		compress(m_pBuffer);
+		nBuffered = 0;
+	}
+
+	memset(m_pBuffer + nBuffered, 0, BlockSize - 8 - nBuffered);
+	qToLittleEndian<quint64>(m_nLength << 3, m_pBuffer + BlockSize - 8);
+	compress(m_pBuffer);
+
+	for( int i = 0; i < 3; ++i )
+	{
+		qToLittleEndian<quint64>(m_pState[i], (uchar*)pDigest + i * 8);
+	}
+}
+
+void CTiger::compress(const quint8* pBlock)
+{
+	quint64 x[8];
+	for( int i = 0; i < 8; ++i )
+	{
+		x[i] = qFromLittleEndian<quint64>(pBlock + i * 8);
+	}
+
+	quint64 a = m_pState[0], b = m_pState[1], c = m_pState[2];
+
+	TIGER_PASS(a, b, c, 5)
+	TIGER_KEY_SCHEDULE
+	TIGER_PASS(c, a, b, 7)
+	TIGER_KEY_SCHEDULE
+	TIGER_PASS(b, c, a, 9)
+
+	m_pState[0] ^= a;
+	m_pState[1] = b - m_pState[1];
+	m_pState[2] += c;
+}
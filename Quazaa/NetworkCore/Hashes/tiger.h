@@ -1,5 +1,5 @@
 /*
-** $Id$
+** tiger.h
 **
 ** Copyright © Quazaa Development Team, 2009-2013.
 ** This file is part of QUAZAA (quazaa.sourceforge.net)
@@ -13,54 +13,43 @@
 ** but WITHOUT ANY WARRANTY; without even the implied warranty of
 ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 **
-** Please review the following information to ensure the GNU General Public 
-** License version 3.0 requirements will be met: 
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
 ** http://www.gnu.org/copyleft/gpl.html.
 **
-** You should have received a copy of the GNU General Public License version 
-** 3.0 along with Quazaa; if not, write to the Free Software Foundation, 
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
 ** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-#include "parser.h"
+#ifndef TIGER_H
+#define TIGER_H
 
-#include <QString>
-#include <QList>
+#include "types.h"
 
-#include "debug_new.h"
-
-namespace Parser
+// Tiger hash (Anderson and Biham, 1996), the digest Tiger trees are made of.
+// Used through CTigerTree; the plain digest is not exchanged on its own.
+class CTiger
 {
-	QString getHeaderValue(QString& headers, QString headerName)
-	{
-		qint32 nStart;
-		qint32 nEnd;
-		qint32 nColon;
-
-		headerName += ":";
-
-		nStart = headers.indexOf(headerName, 0, Qt::CaseInsensitive);
-
-		if(nStart < 0)
-		{
-			return QString();
-		}
+public:
+	enum { DigestSize = 24, BlockSize = 64 };
 
-		nEnd = headers.indexOf("\r\n", nStart);
+protected:
+	quint64		m_pState[3];
+	quint64		m_nLength;				// bytes added so far
+	quint8		m_pBuffer[BlockSize];	// partial block
 
-		if(nEnd < 0)
-		{
-			return QString();
-		}
+public:
+	CTiger();
 
-		nColon = headers.indexOf(":", nStart);
+	void reset();
+	void addData(const char* pData, quint32 nLength);
 
-		if(nColon < 0 || nColon > nEnd)
-		{
-			return QString();
-		}
+	// Writes DigestSize bytes; reset() before adding data again.
+	void result(char* pDigest);
 
-		return headers.mid(nColon + 1, nEnd - nColon).trimmed();
-	}
+protected:
+	void compress(const quint8* pBlock);
 };
 
+#endif // TIGER_H
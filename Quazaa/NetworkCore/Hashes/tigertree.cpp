@@ -0,0 +1,370 @@
+/*
+** tigertree.cpp
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "tigertree.h"
+
+#include <QList>
+#include <QUuid>
+#include <QtEndian>
+#include <string.h>
+
+#include "debug_new.h"
+
+static const char TigerLeafPrefix = 0x00;
+static const char TigerNodePrefix = 0x01;
+
+static const char THEXBreadthFirst[] = "http://open-content.net/spec/thex/breadthfirst";
+
+CTigerTree::CTigerTree(quint64 nSize)
+{
+	reset(nSize);
+}
+
+void CTigerTree::reset(quint64 nSize)
+{
+	const quint32 nHeight = heightForSize(nSize);
+
+	m_nSize = nSize;
+	m_nDepth = 0;
+	m_nBaseLevel = nHeight - qMin<quint32>(nHeight, MaxDepth);
+	m_baNodes.clear();
+
+	m_nAdded = 0;
+	m_nSegmentFill = 0;
+	m_oSegment.reset();
+	m_oSegment.addData(&TigerLeafPrefix, 1);
+	m_lStack.clear();
+	m_baBlocks.clear();
+}
+
+void CTigerTree::addData(const char* pData, quint32 nLength)
+{
+	m_nAdded += nLength;
+
+	while( nLength )
+	{
+		const quint32 nPart = qMin<quint32>(SegmentSize - m_nSegmentFill, nLength);
+
+		m_oSegment.addData(pData, nPart);
+		m_nSegmentFill += nPart;
+		pData += nPart;
+		nLength -= nPart;
+
+		if( m_nSegmentFill == SegmentSize )
+			addSegment();
+	}
+}
+
+bool CTigerTree::finish()
+{
+	if( m_nAdded != m_nSize )
+	{
+		reset(m_nSize);
+		return false;
+	}
+
+	// a file that is empty still has one segment
+	if( m_nSegmentFill > 0 || m_nAdded == 0 )
+		addSegment();
+
+	// what is left below the block level forms the last, short block
+	if( !m_lStack.isEmpty() )
+	{
+		char pHash[CTiger::DigestSize];
+		memcpy(pHash, m_lStack.last().pHash, CTiger::DigestSize);
+		m_lStack.removeLast();
+
+		while( !m_lStack.isEmpty() )
+		{
+			combine(m_lStack.last().pHash, pHash, pHash);
+			m_lStack.removeLast();
+		}
+
+		m_baBlocks.append(pHash, CTiger::DigestSize);
+	}
+
+	m_nDepth = heightForSize(m_nSize) - m_nBaseLevel;
+	m_baNodes = buildLevels(m_baBlocks, m_nDepth);
+	m_baBlocks.clear();
+
+	return true;
+}
+
+CHash CTigerTree::root() const
+{
+	if( !isValid() )
+		return CHash();
+
+	return CHash(m_baNodes.constData(), CTiger::DigestSize, CHash::TIGER);
+}
+
+quint64 CTigerTree::blockSize() const
+{
+	return quint64(SegmentSize) << m_nBaseLevel;
+}
+
+quint32 CTigerTree::blockCount() const
+{
+	return isValid() ? nodesAtLevel(m_nSize, m_nBaseLevel) : 0;
+}
+
+const char* CTigerTree::blockHash(quint32 nBlock) const
+{
+	Q_ASSERT(nBlock < blockCount());
+
+	// the block hashes are the deepest level kept, at the end
+	return m_baNodes.constData() + m_baNodes.size() - (blockCount() - nBlock) * CTiger::DigestSize;
+}
+
+void CTigerTree::hashBlock(const char* pData, quint32 nLength, char* pHash)
+{
+	CTigerTree oTree(nLength);
+	oTree.addData(pData, nLength);
+	oTree.finish();
+
+	memcpy(pHash, oTree.m_baNodes.constData(), CTiger::DigestSize);
+}
+
+QByteArray CTigerTree::toDIME() const
+{
+	if( !isValid() )
+		return QByteArray();
+
+	const QByteArray sUUID = "uuid:" + QUuid::createUuid().toByteArray().mid(1, 36);
+
+	QByteArray sXML;
+	sXML += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n";
+	sXML += "<!DOCTYPE hashtree SYSTEM \"http://open-content.net/spec/thex/thex.dtd\">\r\n";
+	sXML += "<hashtree>";
+	sXML += "<file size=\"" + QByteArray::number(m_nSize) + "\" segmentsize=\"" + QByteArray::number(SegmentSize) + "\"/>";
+	sXML += "<digest algorithm=\"http://open-content.net/spec/digest/tiger\" outputsize=\"" + QByteArray::number(CTiger::DigestSize) + "\"/>";
+	sXML += "<serializedtree depth=\"" + QByteArray::number(m_nDepth) + "\" type=\"" + THEXBreadthFirst + "\" uri=\"" + sUUID + "\"/>";
+	sXML += "</hashtree>";
+
+	// two DIME records: the XML description (media type) and the tree (absolute URI type)
+	QByteArray baDIME;
+
+	for( int nRecord = 0; nRecord < 2; ++nRecord )
+	{
+		const QByteArray& baID   = (nRecord == 0 ? QByteArray() : sUUID);
+		const QByteArray& baType = (nRecord == 0 ? QByteArray("text/xml") : QByteArray(THEXBreadthFirst));
+		const QByteArray& baData = (nRecord == 0 ? sXML : m_baNodes);
+
+		uchar pHeader[12];
+		pHeader[0] = 0x08 | (nRecord == 0 ? 0x04 : 0x02);	// version 1, message begin/end
+		pHeader[1] = (nRecord == 0 ? 0x10 : 0x20);
+		qToBigEndian<quint16>(0, pHeader + 2);
+		qToBigEndian<quint16>(baID.size(), pHeader + 4);
+		qToBigEndian<quint16>(baType.size(), pHeader + 6);
+		qToBigEndian<quint32>(baData.size(), pHeader + 8);
+
+		baDIME.append((const char*)pHeader, sizeof(pHeader));
+
+		foreach( const QByteArray& baField, QList<QByteArray>() << baID << baType << baData )
+		{
+			baDIME.append(baField);
+			baDIME.append(QByteArray((4 - baField.size() % 4) % 4, '\0'));
+		}
+	}
+
+	return baDIME;
+}
+
+bool CTigerTree::fromBreadthFirst(quint64 nSize, const CHash& oRoot, const QByteArray& baTree)
+{
+	if( oRoot.getAlgorithm() != CHash::TIGER || oRoot.isNull() )
+		return false;
+
+	if( baTree.isEmpty() || baTree.size() % CTiger::DigestSize )
+		return false;
+
+	// the depth the sender chose follows from the node count
+	const quint32 nHeight = heightForSize(nSize);
+	const quint64 nNodes = baTree.size() / CTiger::DigestSize;
+	quint64 nTotal = 0;
+	quint32 nDepth = 0;
+
+	for( quint32 nLevel = 1; nLevel <= nHeight && nTotal < nNodes; ++nLevel )
+	{
+		nTotal += nodesAtLevel(nSize, nHeight - nLevel);
+
+		if( nTotal == nNodes )
+			nDepth = nLevel;
+	}
+
+	if( nDepth == 0 )
+		return false;
+
+	// every level has to follow from the one below, up to the root we expect
+	const int nBase = nodesAtLevel(nSize, nHeight - nDepth) * CTiger::DigestSize;
+	const QByteArray baNodes = buildLevels(baTree.right(nBase), nDepth);
+
+	if( baNodes != baTree || memcmp(baNodes.constData(), oRoot.rawData(), CTiger::DigestSize) != 0 )
+		return false;
+
+	const quint32 nKeep = qMin<quint32>(nDepth, MaxDepth);
+	quint64 nKeepNodes = 0;
+
+	for( quint32 nLevel = 1; nLevel <= nKeep; ++nLevel )
+	{
+		nKeepNodes += nodesAtLevel(nSize, nHeight - nLevel);
+	}
+
+	reset(nSize);
+	m_nBaseLevel = nHeight - nKeep;
+	m_nDepth = nKeep;
+	m_baNodes = baNodes.left(nKeepNodes * CTiger::DigestSize);
+
+	return true;
+}
+
+bool CTigerTree::fromDIME(quint64 nSize, const CHash& oRoot, const QByteArray& baDIME)
+{
+	const uchar* pData = (const uchar*)baDIME.constData();
+	quint32 nPos = 0;
+
+	while( nPos + 12 <= (quint32)baDIME.size() )
+	{
+		const quint32 nOptions = qFromBigEndian<quint16>(pData + nPos + 2);
+		const quint32 nID      = qFromBigEndian<quint16>(pData + nPos + 4);
+		const quint32 nType    = qFromBigEndian<quint16>(pData + nPos + 6);
+		const quint32 nLength  = qFromBigEndian<quint32>(pData + nPos + 8);
+		const bool bLast       = (pData[nPos] & 0x02);
+
+		const quint64 nTypeAt = nPos + 12 + ((nOptions + 3) & ~3u) + ((nID + 3) & ~3u);
+		const quint64 nDataAt = nTypeAt + ((nType + 3) & ~3u);
+
+		if( nDataAt + nLength > (quint64)baDIME.size() )
+			return false;
+
+		if( QByteArray::fromRawData((const char*)pData + nTypeAt, nType) == THEXBreadthFirst )
+			return fromBreadthFirst(nSize, oRoot, baDIME.mid(nDataAt, nLength));
+
+		if( bLast )
+			break;
+
+		nPos = nDataAt + ((quint64(nLength) + 3) & ~Q_UINT64_C(3));
+	}
+
+	return false;
+}
+
+quint32 CTigerTree::heightForSize(quint64 nSize)
+{
+	const quint64 nSegments = qMax<quint64>(1, (nSize + SegmentSize - 1) / SegmentSize);
+
+	quint32 nHeight = 1;
+	while( (Q_UINT64_C(1) << (nHeight - 1)) < nSegments )
+	{
+		++nHeight;
+	}
+
+	return nHeight;
+}
+
+void CTigerTree::addSegment()
+{
+	char pHash[CTiger::DigestSize];
+	m_oSegment.result(pHash);
+
+	m_oSegment.reset();
+	m_oSegment.addData(&TigerLeafPrefix, 1);
+	m_nSegmentFill = 0;
+
+	addNode(0, pHash);
+}
+
+void CTigerTree::addNode(quint32 nLevel, const char* pHash)
+{
+	char pCombined[CTiger::DigestSize];
+
+	while( nLevel < m_nBaseLevel && !m_lStack.isEmpty() && m_lStack.last().nLevel == nLevel )
+	{
+		combine(m_lStack.last().pHash, pHash, pCombined);
+		m_lStack.removeLast();
+		pHash = pCombined;
+		++nLevel;
+	}
+
+	if( nLevel == m_nBaseLevel )
+	{
+		m_baBlocks.append(pHash, CTiger::DigestSize);
+		return;
+	}
+
+	Node oNode;
+	oNode.nLevel = nLevel;
+	memcpy(oNode.pHash, pHash, CTiger::DigestSize);
+	m_lStack.append(oNode);
+}
+
+void CTigerTree::combine(const char* pLeft, const char* pRight, char* pResult)
+{
+	CTiger oTiger;
+	oTiger.addData(&TigerNodePrefix, 1);
+	oTiger.addData(pLeft, CTiger::DigestSize);
+	oTiger.addData(pRight, CTiger::DigestSize);
+	oTiger.result(pResult);
+}
+
+QByteArray CTigerTree::buildLevels(const QByteArray& baBase, quint32 nDepth)
+{
+	QList<QByteArray> lLevels;
+	lLevels.prepend(baBase);
+
+	while( (quint32)lLevels.size() < nDepth )
+	{
+		const QByteArray& baBelow = lLevels.first();
+		const int nBelow = baBelow.size() / CTiger::DigestSize;
+
+		QByteArray baLevel((nBelow + 1) / 2 * CTiger::DigestSize, '\0');
+
+		for( int i = 0; i + 1 < nBelow; i += 2 )
+		{
+			combine(baBelow.constData() + i * CTiger::DigestSize, baBelow.constData() + (i + 1) * CTiger::DigestSize,
+					baLevel.data() + i / 2 * CTiger::DigestSize);
+		}
+
+		// an odd node moves up unchanged
+		if( nBelow % 2 )
+			memcpy(baLevel.data() + baLevel.size() - CTiger::DigestSize, baBelow.constData() + baBelow.size() - CTiger::DigestSize, CTiger::DigestSize);
+
+		lLevels.prepend(baLevel);
+	}
+
+	QByteArray baNodes;
+	foreach( const QByteArray& baLevel, lLevels )
+	{
+		baNodes.append(baLevel);
+	}
+
+	return baNodes;
+}
+
+quint32 CTigerTree::nodesAtLevel(quint64 nSize, quint32 nHeight)
+{
+	const quint64 nSegments = qMax<quint64>(1, (nSize + SegmentSize - 1) / SegmentSize);
+
+	return quint32((nSegments + (Q_UINT64_C(1) << nHeight) - 1) >> nHeight);
+}
@@ -0,0 +1,124 @@
+/*
+** tigertree.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef TIGERTREE_H
+#define TIGERTREE_H
+
+#include "types.h"
+#include "hash.h"
+#include "tiger.h"
+
+#include <QByteArray>
+#include <QVarLengthArray>
+
+// Tiger tree hash as specified by THEX: Tiger over 1024 byte segments prefixed with 0x00,
+// pairs of nodes combined as Tiger(0x01 + left + right) and an odd node at the end of a
+// level promoted unchanged. The root is the urn:tree:tiger: value of a file.
+//
+// Built from file data with addData()/finish(), or loaded from a serialized tree received
+// from a peer or read from the library. Only the top MaxDepth levels are kept; the deepest
+// of them holds one hash per block of blockSize() bytes, which is what downloads verify
+// against. Nodes are stored breadth first, root first, as THEX sends them.
+class CTigerTree
+{
+public:
+	enum { SegmentSize = 1024, MaxDepth = 10 };
+
+protected:
+	struct Node
+	{
+		quint32	nLevel;		// 0 for a segment hash
+		char	pHash[CTiger::DigestSize];
+	};
+
+	quint64		m_nSize;		// bytes of file data the tree covers
+	quint32		m_nDepth;		// levels kept, root included; 0 while the tree is not complete
+	quint32		m_nBaseLevel;	// height of a block hash above the segment hashes
+	QByteArray	m_baNodes;		// all kept levels, breadth first
+
+	// while building
+	quint64		m_nAdded;
+	quint32		m_nSegmentFill;
+	CTiger		m_oSegment;
+	QVarLengthArray<Node, 32> m_lStack;	// completed subtrees below the block level
+	QByteArray	m_baBlocks;		// completed block hashes
+
+public:
+	explicit CTigerTree(quint64 nSize = 0);
+
+	// Starts building the tree of a file of nSize bytes.
+	void reset(quint64 nSize);
+	void addData(const char* pData, quint32 nLength);
+	// Returns false unless exactly size() bytes were added.
+	bool finish();
+
+	inline bool isValid() const;
+	inline quint64 size() const;
+	inline quint32 depth() const;
+	CHash root() const;
+
+	quint64 blockSize() const;
+	quint32 blockCount() const;
+	const char* blockHash(quint32 nBlock) const;
+
+	// Root of a single block of data, for checking it against blockHash().
+	static void hashBlock(const char* pData, quint32 nLength, char* pHash);
+
+	// THEX breadth first serialization, and the DIME message it is served in.
+	inline QByteArray toBreadthFirst() const;
+	QByteArray toDIME() const;
+
+	// Both fail unless the data is a complete tree of any depth for a file of nSize bytes
+	// with the given root; trees deeper than MaxDepth are cut down.
+	bool fromBreadthFirst(quint64 nSize, const CHash& oRoot, const QByteArray& baTree);
+	bool fromDIME(quint64 nSize, const CHash& oRoot, const QByteArray& baDIME);
+
+	static quint32 heightForSize(quint64 nSize);
+
+protected:
+	void addSegment();
+	void addNode(quint32 nLevel, const char* pHash);
+	static void combine(const char* pLeft, const char* pRight, char* pResult);
+	static QByteArray buildLevels(const QByteArray& baBase, quint32 nDepth);
+	static quint32 nodesAtLevel(quint64 nSize, quint32 nHeight);
+};
+
+bool CTigerTree::isValid() const
+{
+	return m_nDepth > 0;
+}
+quint64 CTigerTree::size() const
+{
+	return m_nSize;
+}
+quint32 CTigerTree::depth() const
+{
+	return m_nDepth;
+}
+QByteArray CTigerTree::toBreadthFirst() const
+{
+	return m_baNodes;
+}
+
+#endif // TIGERTREE_H
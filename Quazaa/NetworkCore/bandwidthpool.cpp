@@ -0,0 +1,185 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "bandwidthpool.h"
+
+#include <limits>
+#include <QMutexLocker>
+
+#include "debug_new.h"
+
+const qint64 PoolBurstMsecs = 250;      // tokens the pool may bank, in ms of link speed
+const qint64 PoolMinBurst   = 4096;
+
+CBandwidthPool BandwidthPool;
+
+CBandwidthPool::CBandwidthPool()
+{
+	for(int i = 0; i < rdCount; ++i)
+	{
+		m_nLimit[i] = std::numeric_limits<qint32>::max() / 2;
+		m_nTokens[i] = 0;
+	}
+}
+
+void CBandwidthPool::setLimits(qint64 nDownload, qint64 nUpload)
+{
+	QMutexLocker l(&m_pSection);
+
+	refill();
+
+	m_nLimit[rdDownload] = qMax(qint64(0), nDownload);
+	m_nLimit[rdUpload] = qMax(qint64(0), nUpload);
+
+	for(int i = 0; i < rdCount; ++i)
+	{
+		m_nTokens[i] = qMin(m_nTokens[i], burst(RateDirection(i)));
+	}
+}
+
+qint64 CBandwidthPool::limit(RateDirection nDirection)
+{
+	QMutexLocker l(&m_pSection);
+	return m_nLimit[nDirection];
+}
+
+void CBandwidthPool::registerClass(RateClass nClass, qint64 nDownload, qint64 nUpload)
+{
+	QMutexLocker l(&m_pSection);
+
+	m_lClasses[nClass].nGuaranteed[rdDownload] = nDownload;
+	m_lClasses[nClass].nGuaranteed[rdUpload] = nUpload;
+	m_lClasses[nClass].bActive = true;
+}
+
+void CBandwidthPool::unregisterClass(RateClass nClass)
+{
+	QMutexLocker l(&m_pSection);
+
+	m_lClasses[nClass].bActive = false;
+}
+
+// Charges traffic sent within the guaranteed rate of a class.
+void CBandwidthPool::consume(RateClass nClass, RateDirection nDirection, qint64 nBytes)
+{
+	if(nBytes <= 0)
+	{
+		return;
+	}
+
+	QMutexLocker l(&m_pSection);
+
+	refill();
+
+	m_nTokens[nDirection] = qMax(m_nTokens[nDirection] - nBytes, -burst(nDirection));
+	m_lClasses[nClass].nTotal[nDirection] += nBytes;
+}
+
+// Reserves spare tokens; whatever is not used must be returned with giveBack().
+qint64 CBandwidthPool::borrow(RateDirection nDirection, qint64 nWanted)
+{
+	QMutexLocker l(&m_pSection);
+
+	refill();
+
+	qint64 nGranted = qBound(qint64(0), m_nTokens[nDirection], nWanted);
+	m_nTokens[nDirection] -= nGranted;
+
+	return nGranted;
+}
+
+void CBandwidthPool::giveBack(RateClass nClass, RateDirection nDirection, qint64 nGranted, qint64 nUsed)
+{
+	Q_ASSERT(nUsed <= nGranted);
+
+	QMutexLocker l(&m_pSection);
+
+	m_nTokens[nDirection] += nGranted - nUsed;
+	m_lClasses[nClass].nTotal[nDirection] += nUsed;
+	m_lClasses[nClass].nBorrowed[nDirection] += nUsed;
+}
+
+// Time until nBytes of spare bandwidth will be available, for scheduling wake-ups.
+qint64 CBandwidthPool::msecsUntil(RateDirection nDirection, qint64 nBytes)
+{
+	QMutexLocker l(&m_pSection);
+
+	refill();
+
+	if(m_nTokens[nDirection] >= nBytes)
+	{
+		return 0;
+	}
+	if(m_nLimit[nDirection] == 0)
+	{
+		return std::numeric_limits<qint32>::max();
+	}
+
+	return ((nBytes - m_nTokens[nDirection]) * 1000 + m_nLimit[nDirection] - 1) / m_nLimit[nDirection];
+}
+
+CRateClassStats CBandwidthPool::classStats(RateClass nClass)
+{
+	QMutexLocker l(&m_pSection);
+	return m_lClasses[nClass];
+}
+
+void CBandwidthPool::refill()
+{
+	if(!m_tRefill.isValid())
+	{
+		m_tRefill.start();
+		for(int i = 0; i < rdCount; ++i)
+		{
+			m_nTokens[i] = burst(RateDirection(i));
+		}
+		return;
+	}
+
+	qint64 nNsecs = qMin(m_tRefill.nsecsElapsed(), 1000000000ll);
+
+	// Only advance the clock when it produced whole bytes, so slow links do not lose fractions
+	qint64 nAdded[rdCount];
+	bool bAdvance = false;
+	for(int i = 0; i < rdCount; ++i)
+	{
+		nAdded[i] = m_nLimit[i] * nNsecs / 1000000000ll;
+		bAdvance = bAdvance || nAdded[i] > 0;
+	}
+
+	if(bAdvance)
+	{
+		m_tRefill.start();
+		for(int i = 0; i < rdCount; ++i)
+		{
+			m_nTokens[i] = qMin(m_nTokens[i] + nAdded[i], burst(RateDirection(i)));
+		}
+	}
+}
+
+qint64 CBandwidthPool::burst(RateDirection nDirection) const
+{
+	return qMax(PoolMinBurst, m_nLimit[nDirection] * PoolBurstMsecs / 1000);
+}
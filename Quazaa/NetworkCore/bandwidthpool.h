@@ -0,0 +1,108 @@
+/*
+** bandwidthpool.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#ifndef BANDWIDTHPOOL_H
+#define BANDWIDTHPOOL_H
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+#include <QMutex>
+
+// Traffic classes sharing the link. Each CRateController serves one class.
+enum RateClass
+{
+	rcNeighbours,
+	rcTransfers,
+	rcChat,
+	rcHandshakes,
+	rcCount
+};
+
+enum RateDirection
+{
+	rdDownload,
+	rdUpload,
+	rdCount
+};
+
+// Per-class accounting, for monitoring.
+struct CRateClassStats
+{
+	qint64  nGuaranteed[rdCount];   // configured guaranteed rate, B/s
+	quint64 nTotal[rdCount];        // bytes moved
+	quint64 nBorrowed[rdCount];     // ... of which above the guaranteed rate
+	bool    bActive;
+
+	CRateClassStats() :
+		bActive(false)
+	{
+		for(int i = 0; i < rdCount; ++i)
+		{
+			nGuaranteed[i] = 0;
+			nTotal[i] = nBorrowed[i] = 0;
+		}
+	}
+};
+
+// Parent token bucket of the rate controllers, shared across their threads.
+// It refills at the link speed. Guaranteed traffic is always charged to it (and may
+// drive it negative), borrowed traffic only takes what is left, so bandwidth a class
+// leaves unused is lent to the others while every class keeps its guarantee.
+class CBandwidthPool
+{
+protected:
+	QMutex          m_pSection;
+
+	qint64          m_nLimit[rdCount];
+	qint64          m_nTokens[rdCount];
+	QElapsedTimer   m_tRefill;
+
+	CRateClassStats m_lClasses[rcCount];
+
+public:
+	CBandwidthPool();
+
+	void setLimits(qint64 nDownload, qint64 nUpload);
+	qint64 limit(RateDirection nDirection);
+
+	void registerClass(RateClass nClass, qint64 nDownload, qint64 nUpload);
+	void unregisterClass(RateClass nClass);
+
+	void consume(RateClass nClass, RateDirection nDirection, qint64 nBytes);
+	qint64 borrow(RateDirection nDirection, qint64 nWanted);
+	void giveBack(RateClass nClass, RateDirection nDirection, qint64 nGranted, qint64 nUsed);
+
+	qint64 msecsUntil(RateDirection nDirection, qint64 nBytes);
+
+	CRateClassStats classStats(RateClass nClass);
+
+protected:
+	void refill();
+	qint64 burst(RateDirection nDirection) const;
+};
+
+extern CBandwidthPool BandwidthPool;
+
+#endif // BANDWIDTHPOOL_H
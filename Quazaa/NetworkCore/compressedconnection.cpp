@@ -23,11 +23,32 @@
 */
 
 #include "compressedconnection.h"
+#include "deflatebackend.h"
+#include "g2capture.h"
 #include "buffer.h"
 #include "systemlog.h"
 
 #include "debug_new.h"
 
+// Deflate tuning. Links start at the zlib default level and flush cadence; adaptDeflate()
+// then trades ratio for CPU or latency for throughput based on what each link shows.
+const int     DeflateDefaultLevel   = 6;
+const int     DeflateMinLevel       = 1;
+const int     DeflateMaxLevel       = 9;
+const quint32 DeflateFlushSize      = 4096;         // compressed bytes between sync flushes
+const quint32 DeflateFlushSizeBulk  = 16384;        // ... while the link is backlogged
+const qint64  DeflateFlushTime      = 250;          // ms between sync flushes
+const qint64  DeflateFlushTimeBulk  = 500;          // ... while the link is backlogged
+const quint64 DeflateWindow         = 16384;        // raw bytes sampled per adaptation
+const qint64  DeflateQueueDeep      = 32768;        // queued bytes considered a backlog
+const qint64  DeflateQueueShallow   = 4096;         // queued bytes considered idle
+const float   DeflatePoorRatio      = 0.9f;         // compressed/raw above this is not worth the CPU
+const qint64  DeflateCpuBudget      = 50000000ll;   // ns of deflate per second, all links together
+
+// Deflate time spent by all links in the current one-second budget period.
+static qint64        DeflateCpuUsed = 0;
+static QElapsedTimer DeflateCpuPeriod;
+
 CCompressedConnection::CCompressedConnection(QObject* parent) :
 	CNetworkConnection(parent)
 {
@@ -43,15 +64,27 @@ CCompressedConnection::CCompressedConnection(QObject* parent) :
 	m_nTotalInputDec = 0;
 	m_nTotalOutputCom = 0;
 
-	m_nNextDeflateFlush = 4096;
+	m_nNextDeflateFlush = DeflateFlushSize;
 	m_bOutputPending = false;
 
+	m_pDeflate = 0;
+	m_nDeflateFlushSize = DeflateFlushSize;
+	m_nDeflateFlushTime = DeflateFlushTime;
+	m_nWindowIn = 0;
+	m_nWindowOut = 0;
+
+	m_nCaptureStream = 0;
+
 	memset(&m_sInput, 0, sizeof(z_stream));
-	memset(&m_sOutput, 0, sizeof(z_stream));
 }
 
 CCompressedConnection::~CCompressedConnection()
 {
+	if(m_nCaptureStream)
+	{
+		G2Capture.closeStream(m_nCaptureStream);
+	}
+
 	cleanupInputStream();
 	cleanupOutputStream();
 }
@@ -120,13 +153,20 @@ bool CCompressedConnection::setupOutputStream()
 		return false;
 	}
 
-	if(deflateInit(&m_sOutput, Z_DEFAULT_COMPRESSION) != Z_OK)
+	m_pDeflate = CDeflateBackend::create();
+
+	if(!m_pDeflate->init(DeflateDefaultLevel))
 	{
+		delete m_pDeflate;
+		m_pDeflate = 0;
 		delete m_pZOutput;
 		m_pZOutput = 0;
 		return false;
 	}
-	m_nNextDeflateFlush = m_nTotalOutput + 4096;
+	m_nDeflateFlushSize = DeflateFlushSize;
+	m_nDeflateFlushTime = DeflateFlushTime;
+	m_nWindowIn = m_nWindowOut = 0;
+	m_nNextDeflateFlush = m_nTotalOutput + m_nDeflateFlushSize;
 	m_tDeflateFlush.start();
 
 	return true;
@@ -152,13 +192,20 @@ void CCompressedConnection::cleanupOutputStream()
 		delete m_pZOutput;
 		m_pZOutput = 0;
 	}
-	deflateEnd(&m_sOutput);
+
+	delete m_pDeflate;
+	m_pDeflate = 0;
 }
 
 qint64 CCompressedConnection::readFromNetwork(qint64 nBytes)
 {
 	qint64 nRet = CNetworkConnection::readFromNetwork(nBytes);
 
+	if(m_nCaptureStream && nRet > 0)
+	{
+		G2Capture.streamData(m_nCaptureStream, m_pInput->data() + m_pInput->size() - nRet, nRet);
+	}
+
 	if(m_bCompressedInput)
 	{
 		inflateInput();
@@ -244,55 +291,125 @@ void CCompressedConnection::inflateInput()
 
 void CCompressedConnection::deflateOutput()
 {
-	qint32 nFlushMode = Z_NO_FLUSH;
+	CDeflateBackend::FlushMode nFlushMode = CDeflateBackend::NoFlush;
 
-	if(m_tDeflateFlush.elapsed() > 250ll || m_nTotalOutput > m_nNextDeflateFlush)
+	if(m_tDeflateFlush.elapsed() > m_nDeflateFlushTime || m_nTotalOutput > m_nNextDeflateFlush)
 	{
-		nFlushMode = Z_SYNC_FLUSH;
-		m_nNextDeflateFlush += 4096;
+		nFlushMode = CDeflateBackend::SyncFlush;
+		m_nNextDeflateFlush = m_nTotalOutput + m_nDeflateFlushSize;
 		m_tDeflateFlush.start();
 	}
 
-	if(m_pZOutput->size() == 0 && nFlushMode == Z_NO_FLUSH)
+	if(m_pZOutput->size() == 0 && nFlushMode == CDeflateBackend::NoFlush)
 	{
 		return;
 	}
 
+	QElapsedTimer tCpu;
+	tCpu.start();
+
+	quint32 nConsumed = 0, nProduced = 0;
+
 	do
 	{
-		m_sOutput.next_in = (Bytef*)m_pZOutput->data();
-		m_sOutput.avail_in = m_pZOutput->size();
-		m_sOutput.total_in = 0u;
-
 		if(m_pOutput->capacity() - m_pOutput->size() < 2048)
 		{
 			m_pOutput->ensure(2048u);
 		}
 
-		qint32 nOldSize = m_pOutput->size();
-
-		m_sOutput.next_out = (Bytef*)m_pOutput->data() + nOldSize;
-		m_sOutput.avail_out = m_pOutput->capacity() - nOldSize;
-		m_sOutput.total_out = 0u;
-
-		qint32 nRet = deflate(&m_sOutput, nFlushMode);
+		quint32 nOldSize = m_pOutput->size();
 
-		if(nRet == Z_OK || nRet == Z_BUF_ERROR)
+		if(m_pDeflate->compress(m_pZOutput->data(), m_pZOutput->size(),
+								m_pOutput->data() + nOldSize, m_pOutput->capacity() - nOldSize,
+								nFlushMode, nConsumed, nProduced))
 		{
-			m_pOutput->resize(nOldSize + m_sOutput.total_out);
-			m_pZOutput->remove(0, m_sOutput.total_in);
-			m_nTotalOutput += m_sOutput.total_out;
-			m_nTotalOutputCom += m_sOutput.total_in;
+			m_pOutput->resize(nOldSize + nProduced);
+			m_pZOutput->remove(0, nConsumed);
+			m_nTotalOutput += nProduced;
+			m_nTotalOutputCom += nConsumed;
+			m_nWindowOut += nProduced;
+			m_nWindowIn += nConsumed;
 		}
 		else
 		{
-			systemLog.postLog(LogSeverity::Debug, QString("Error in compressor! %1").arg(nRet));
+			systemLog.postLog(LogSeverity::Debug, QString("Error in compressor (%1)!").arg(m_pDeflate->name()));
 			close();
-			break;
+			return;
+		}
+
+	}
+	while(m_pZOutput->size() != 0 || m_pOutput->capacity() == m_pOutput->size());
+
+	qint64 nNsecs = tCpu.nsecsElapsed();
+
+	if(!DeflateCpuPeriod.isValid() || DeflateCpuPeriod.elapsed() > 1000)
+	{
+		DeflateCpuPeriod.start();
+		DeflateCpuUsed = 0;
+	}
+	DeflateCpuUsed += nNsecs;
+
+	m_bOutputPending = (nFlushMode == CDeflateBackend::NoFlush);
+
+	if(nFlushMode == CDeflateBackend::SyncFlush)
+	{
+		adaptDeflate();
+	}
+}
+
+// Called after each sync flush, where a level change costs nothing extra.
+void CCompressedConnection::adaptDeflate()
+{
+	if(m_nWindowIn < DeflateWindow)
+	{
+		return;
+	}
+
+	int nLevel = m_pDeflate->level();
+	qint64 nQueued = m_pZOutput->size() + m_pOutput->size() + bytesToWrite();
+	float nRatio = float(m_nWindowOut) / float(m_nWindowIn);
+
+	if(nRatio > DeflatePoorRatio)
+	{
+		// Already compressed payload (hashes, previews), spend as little as possible on it
+		nLevel = DeflateMinLevel;
+	}
+	else if(DeflateCpuUsed > DeflateCpuBudget)
+	{
+		nLevel = qMax(DeflateMinLevel, nLevel - 1);
+	}
+	else if(nQueued > DeflateQueueDeep)
+	{
+		// The link is the bottleneck: squeeze harder and batch more per flush
+		nLevel = qMin(DeflateMaxLevel, nLevel + 1);
+		m_nDeflateFlushSize = DeflateFlushSizeBulk;
+		m_nDeflateFlushTime = DeflateFlushTimeBulk;
+	}
+	else if(nQueued < DeflateQueueShallow)
+	{
+		// Idle link: favour latency
+		if(nLevel < DeflateDefaultLevel)
+		{
+			++nLevel;
+		}
+		else if(nLevel > DeflateDefaultLevel)
+		{
+			--nLevel;
 		}
+		m_nDeflateFlushSize = DeflateFlushSize;
+		m_nDeflateFlushTime = DeflateFlushTime;
+	}
 
+	if(nLevel != m_pDeflate->level())
+	{
+		m_pDeflate->setLevel(nLevel);
 	}
-	while(m_sOutput.avail_in != 0);
 
-	m_bOutputPending = (nFlushMode == Z_NO_FLUSH);
+	m_nNextDeflateFlush = m_nTotalOutput + m_nDeflateFlushSize;
+	m_nWindowIn = m_nWindowOut = 0;
+}
+
+int CCompressedConnection::getDeflateLevel() const
+{
+	return m_pDeflate ? m_pDeflate->level() : 0;
 }
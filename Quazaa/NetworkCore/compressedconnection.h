@@ -31,6 +31,7 @@
 
 
 class CBuffer;
+class CDeflateBackend;
 
 class CCompressedConnection : public CNetworkConnection
 {
@@ -38,7 +39,7 @@ class CCompressedConnection : public CNetworkConnection
 
 public:
 	z_stream    m_sInput;               // zlib compressed input stream
-	z_stream    m_sOutput;              // zlib compressed output stream
+	CDeflateBackend* m_pDeflate;        // compressor for the output stream
 	bool        m_bCompressedInput;     // Compress input streams?
 	bool        m_bCompressedOutput;    // Compress output streams?
 	CBuffer* 	m_pZInput;              // Local input buffer
@@ -50,6 +51,11 @@ public:
 	quint64     m_nNextDeflateFlush;    // Amount of bytes until a deflate buffer flush is triggered.
 	bool        m_bOutputPending;       // Do we have data to send on the compressed output stream?
 	QElapsedTimer m_tDeflateFlush;      // Amount of time until a deflate buffer flush is triggered.
+	quint32     m_nDeflateFlushSize;    // Compressed bytes between flushes, adapted to the link.
+	qint64      m_nDeflateFlushTime;    // Milliseconds between flushes, adapted to the link.
+	quint64     m_nWindowIn;            // Raw bytes compressed since the last adaptation.
+	quint64     m_nWindowOut;           // Compressed bytes produced since the last adaptation.
+	quint32     m_nCaptureStream;       // Raw input is recorded to this G2Capture stream, 0 if not.
 public:
 	CCompressedConnection(QObject* parent = 0);
 	virtual ~CCompressedConnection();
@@ -68,6 +74,7 @@ protected:
 
 	void inflateInput();
 	void deflateOutput();
+	void adaptDeflate();
 
 public:
 	inline CBuffer* getInputBuffer()
@@ -117,6 +124,7 @@ public:
 		float ret = 1.0f - (float)m_nTotalOutput / (float)m_nTotalOutputCom;
 		return ret;
 	}
+	int getDeflateLevel() const;
 
 signals:
 
@@ -28,6 +28,8 @@
 #include "datagramfrags.h"
 #include "g2node.h"
 #include "g2packet.h"
+#include "g2metrics.h"
+#include "g2capture.h"
 #include "searchmanager.h"
 #include "Hashes/hash.h"
 #include "queryhit.h"
@@ -113,20 +115,7 @@ void CDatagrams::listen()
 		systemLog.postLog(LogSeverity::Debug, QString("Datagrams listening on %1").arg(m_pSocket->localPort()));
 		m_nDiscarded = 0;
 
-		for(int i = 0; i < quazaaSettings.Gnutella2.UdpBuffers; i++)
-		{
-			m_FreeBuffer.append(new CBuffer(1024));
-		}
-
-		for(int i = 0; i < quazaaSettings.Gnutella2.UdpInFrames; i++)
-		{
-			m_FreeDatagramIn.append(new DatagramIn);
-		}
-
-		for(int i = 0; i < quazaaSettings.Gnutella2.UdpOutFrames; i++)
-		{
-			m_FreeDatagramOut.append(new DatagramOut);
-		}
+		allocateFrames();
 
 		connect(this, SIGNAL(sendQueueUpdated()), this, SLOT(flushSendCache()), Qt::QueuedConnection);
 		connect(m_pSocket, SIGNAL(readyRead()), this, SLOT(onDatagram()), Qt::QueuedConnection);
@@ -142,6 +131,52 @@ void CDatagrams::listen()
 	m_bFirewalled = true;
 }
 
+void CDatagrams::allocateFrames()
+{
+	for(int i = 0; i < quazaaSettings.Gnutella2.UdpBuffers; i++)
+	{
+		m_FreeBuffer.append(new CBuffer(1024));
+	}
+
+	for(int i = 0; i < quazaaSettings.Gnutella2.UdpInFrames; i++)
+	{
+		m_FreeDatagramIn.append(new DatagramIn);
+	}
+
+	for(int i = 0; i < quazaaSettings.Gnutella2.UdpOutFrames; i++)
+	{
+		m_FreeDatagramOut.append(new DatagramOut);
+	}
+}
+
+// Sets up the receive side without a socket, for CG2Replay. m_bActive stays false, so
+// nothing is sent; disconnectNode() cleans up.
+void CDatagrams::startReplay()
+{
+	QMutexLocker l(&m_pSection);
+
+	m_nDiscarded = 0;
+	allocateFrames();
+}
+
+void CDatagrams::replayDatagram(const CEndPoint& oAddress, const QByteArray& baData)
+{
+	m_pRecvBuffer->clear();
+	m_pRecvBuffer->append(baData.constData(), baData.size());
+	*m_pHostAddress = oAddress;
+	m_nPort = oAddress.port();
+
+	processDatagram();
+
+	// there is no socket to send the acknowledgements through
+	QMutexLocker l(&m_pSection);
+	while(!m_AckCache.isEmpty())
+	{
+		QPair<CEndPoint, char*> oAck = m_AckCache.takeFirst();
+		delete [] oAck.second;
+	}
+}
+
 void CDatagrams::disconnectNode()
 {
 	QMutexLocker l(&m_pSection);
@@ -210,21 +245,39 @@ void CDatagrams::onDatagram()
 			return;
 		}
 
-		m_nInFrags++;
+		m_pRecvBuffer->resize(nReadSize);
 
-		GND_HEADER* pHeader = (GND_HEADER*)m_pRecvBuffer->data();
-		if(strncmp((char*)&pHeader->szTag, "GND", 3) == 0 && pHeader->nPart > 0 && (pHeader->nCount == 0 || pHeader->nPart <= pHeader->nCount))
+		if(G2Capture.isActive())
 		{
-			if(pHeader->nCount == 0)
-			{
-				// ACK
-				onAcknowledgeGND();
-			}
-			else
-			{
-				// DG
-				onReceiveGND();
-			}
+			G2Capture.datagram(CEndPoint(*m_pHostAddress, m_nPort), m_pRecvBuffer->data(), nReadSize);
+		}
+
+		processDatagram();
+	}
+}
+
+// Dispatches the datagram in m_pRecvBuffer, received from m_pHostAddress:m_nPort.
+void CDatagrams::processDatagram()
+{
+	if(m_pRecvBuffer->size() < 8)
+	{
+		return;
+	}
+
+	m_nInFrags++;
+
+	GND_HEADER* pHeader = (GND_HEADER*)m_pRecvBuffer->data();
+	if(strncmp((char*)&pHeader->szTag, "GND", 3) == 0 && pHeader->nPart > 0 && (pHeader->nCount == 0 || pHeader->nPart <= pHeader->nCount))
+	{
+		if(pHeader->nCount == 0)
+		{
+			// ACK
+			onAcknowledgeGND();
+		}
+		else
+		{
+			// DG
+			onReceiveGND();
 		}
 	}
 }
@@ -596,7 +649,10 @@ void CDatagrams::sendPacket(CEndPoint& oAddr, G2Packet* pPacket, bool bAck, Data
 		systemLog.postLog(LogSeverity::Debug, QString("UDP out frames exhausted"));
 
 		if( !bAck ) // if caller does not want ACK, drop the packet here
+		{
+			G2Metrics.drop(gtUDP, CG2Metrics::classify(pPacket), drQueueFull);
 			return; // TODO: needs more testing
+		}
 
 		remove(m_SendCache.last());
 
@@ -609,6 +665,7 @@ void CDatagrams::sendPacket(CEndPoint& oAddr, G2Packet* pPacket, bool bAck, Data
 		if(m_FreeBuffer.isEmpty())
 		{
 			systemLog.postLog(LogSeverity::Debug, QString("UDP out discarded, out of buffers"));
+			G2Metrics.drop(gtUDP, CG2Metrics::classify(pPacket), drQueueFull);
 			return;
 		}
 	}
@@ -618,6 +675,7 @@ void CDatagrams::sendPacket(CEndPoint& oAddr, G2Packet* pPacket, bool bAck, Data
 
 	m_SendCache.prepend(pDatagramOut);
 	m_SendCacheMap[pDatagramOut->m_nSequence] = pDatagramOut;
+	G2Metrics.packetOut(gtUDP, CG2Metrics::classify(pPacket), pPacket->m_nLength);
 
 	// TODO: Notify the listener if we have one.
 
@@ -631,48 +689,46 @@ void CDatagrams::sendPacket(CEndPoint& oAddr, G2Packet* pPacket, bool bAck, Data
 
 void CDatagrams::onPacket(CEndPoint addr, G2Packet* pPacket)
 {
+	CG2MetricsScope oMetrics(gtUDP, pPacket);
+
 	try
 	{
-		if(pPacket->isType("PI"))
+		switch(oMetrics.packetClass())
 		{
+		case pcPI:
 			onPing(addr, pPacket);
-		}
-		else if(pPacket->isType("PO"))
-		{
+			break;
+		case pcPO:
 			onPong(addr, pPacket);
-		}
-		else if(pPacket->isType("CRAWLR"))
-		{
+			break;
+		case pcCRAWLR:
 			onCRAWLR(addr, pPacket);
-		}
-		else if(pPacket->isType("QKR"))
-		{
+			break;
+		case pcQKR:
 			onQKR(addr, pPacket);
-		}
-		else if(pPacket->isType("QKA"))
-		{
+			break;
+		case pcQKA:
 			onQKA(addr, pPacket);
-		}
-		else if(pPacket->isType("QA"))
-		{
+			break;
+		case pcQA:
 			onQA(addr, pPacket);
-		}
-		else if(pPacket->isType("QH2"))
-		{
+			break;
+		case pcQH2:
 			onQH2(addr, pPacket);
-		}
-		else if(pPacket->isType("Q2"))
-		{
+			break;
+		case pcQ2:
 			onQuery(addr, pPacket);
-		}
-		else
-		{
+			break;
+		default:
+			oMetrics.drop(drUnknown);
 			//systemLog.postLog(LogSeverity::Debug, QString("G2 UDP recieved unknown packet %1").arg(pPacket->GetType()));
 			//qDebug() << "UDP RECEIVED unknown packet " << pPacket->GetType();
+			break;
 		}
 	}
 	catch(...)
 	{
+		oMetrics.drop(drMalformed);
 		systemLog.postLog(LogSeverity::Debug, QString("malformed packet"));
 		//qDebug() << "malformed packet";
 	}
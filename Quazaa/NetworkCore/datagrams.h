@@ -103,11 +103,15 @@ public:
 	void listen();
 	void disconnectNode();
 
+	void startReplay();
+	void replayDatagram(const CEndPoint& oAddress, const QByteArray& baData);
+
 	void sendPacket(CEndPoint& oAddr, G2Packet* pPacket, bool bAck = false, DatagramWatcher* pWatcher = 0, void* pParam = 0);
 
 	void removeOldIn(bool bForce = false);
 	void remove(DatagramIn* pDatagramIn, bool bReclaim = false);
 	void remove(DatagramOut* pDatagramOut);
+	void processDatagram();
 	void onReceiveGND();
 	void onAcknowledgeGND();
 
@@ -126,6 +130,9 @@ public:
 	inline bool isFirewalled();
 	inline bool isListening();
 
+protected:
+	void allocateFrames();
+
 public slots:
 	void onDatagram();
 	void flushSendCache();
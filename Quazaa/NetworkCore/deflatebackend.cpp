@@ -0,0 +1,121 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "deflatebackend.h"
+
+#include "debug_new.h"
+
+static CDeflateBackend::Factory DeflateBackendFactory = &CZlibDeflateBackend::createInstance;
+
+CDeflateBackend* CDeflateBackend::create()
+{
+	return DeflateBackendFactory();
+}
+
+void CDeflateBackend::setFactory(CDeflateBackend::Factory pFactory)
+{
+	DeflateBackendFactory = pFactory ? pFactory : &CZlibDeflateBackend::createInstance;
+}
+
+CZlibDeflateBackend::CZlibDeflateBackend() :
+	m_bInitialized(false),
+	m_nLevel(Z_DEFAULT_COMPRESSION),
+	m_nPendingLevel(Z_DEFAULT_COMPRESSION)
+{
+	memset(&m_oStream, 0, sizeof(z_stream));
+}
+
+CZlibDeflateBackend::~CZlibDeflateBackend()
+{
+	if(m_bInitialized)
+	{
+		deflateEnd(&m_oStream);
+	}
+}
+
+CDeflateBackend* CZlibDeflateBackend::createInstance()
+{
+	return new CZlibDeflateBackend();
+}
+
+bool CZlibDeflateBackend::init(int nLevel)
+{
+	if(deflateInit(&m_oStream, nLevel) != Z_OK)
+	{
+		return false;
+	}
+
+	m_bInitialized = true;
+	m_nLevel = m_nPendingLevel = nLevel;
+	return true;
+}
+
+void CZlibDeflateBackend::setLevel(int nLevel)
+{
+	m_nPendingLevel = nLevel;
+}
+
+int CZlibDeflateBackend::level() const
+{
+	return m_nPendingLevel;
+}
+
+bool CZlibDeflateBackend::compress(const char* pIn, quint32 nIn, char* pOut, quint32 nOut, FlushMode nFlush,
+								   quint32& nConsumed, quint32& nProduced)
+{
+	Q_ASSERT(m_bInitialized);
+
+	m_oStream.next_in = (Bytef*)pIn;
+	m_oStream.avail_in = nIn;
+	m_oStream.next_out = (Bytef*)pOut;
+	m_oStream.avail_out = nOut;
+
+	qint32 nRet = Z_OK;
+
+	// deflateParams() needs room to flush what was compressed with the old level
+	if(m_nPendingLevel != m_nLevel)
+	{
+		nRet = deflateParams(&m_oStream, m_nPendingLevel, Z_DEFAULT_STRATEGY);
+
+		if(nRet == Z_OK)
+		{
+			m_nLevel = m_nPendingLevel;
+		}
+	}
+
+	if(nRet == Z_OK || nRet == Z_BUF_ERROR)
+	{
+		nRet = deflate(&m_oStream, nFlush == SyncFlush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+	}
+
+	nConsumed = nIn - m_oStream.avail_in;
+	nProduced = nOut - m_oStream.avail_out;
+
+	return (nRet == Z_OK || nRet == Z_BUF_ERROR);
+}
+
+const char* CZlibDeflateBackend::name() const
+{
+	return "zlib";
+}
@@ -0,0 +1,81 @@
+/*
+** deflatebackend.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef DEFLATEBACKEND_H
+#define DEFLATEBACKEND_H
+
+#include "types.h"
+#include "zlib.h"
+
+// Compressor behind a CCompressedConnection output stream, one instance per link.
+// The stream must stay valid across level changes; a faster deflate implementation
+// can be plugged in with setFactory() before any link enables compression.
+class CDeflateBackend
+{
+public:
+	enum FlushMode
+	{
+		NoFlush,
+		SyncFlush
+	};
+
+	typedef CDeflateBackend* (*Factory)();
+
+public:
+	virtual ~CDeflateBackend() {}
+
+	virtual bool init(int nLevel) = 0;
+	virtual void setLevel(int nLevel) = 0;	// takes effect with the next compress() call
+	virtual int  level() const = 0;
+	virtual bool compress(const char* pIn, quint32 nIn, char* pOut, quint32 nOut, FlushMode nFlush,
+						  quint32& nConsumed, quint32& nProduced) = 0;
+	virtual const char* name() const = 0;
+
+	static CDeflateBackend* create();
+	static void setFactory(Factory pFactory);
+};
+
+class CZlibDeflateBackend : public CDeflateBackend
+{
+protected:
+	z_stream	m_oStream;
+	bool		m_bInitialized;
+	int			m_nLevel;
+	int			m_nPendingLevel;
+
+public:
+	CZlibDeflateBackend();
+	virtual ~CZlibDeflateBackend();
+
+	virtual bool init(int nLevel);
+	virtual void setLevel(int nLevel);
+	virtual int  level() const;
+	virtual bool compress(const char* pIn, quint32 nIn, char* pOut, quint32 nOut, FlushMode nFlush,
+						  quint32& nConsumed, quint32& nProduced);
+	virtual const char* name() const;
+
+	static CDeflateBackend* createInstance();
+};
+
+#endif // DEFLATEBACKEND_H
@@ -0,0 +1,148 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "g2capture.h"
+#include "systemlog.h"
+
+#include "debug_new.h"
+
+const char* CG2Capture::Magic = "QG2CAP";
+
+CG2Capture G2Capture;
+
+CG2Capture::CG2Capture() :
+	m_nNextStream(1),
+	m_bActive(0)
+{
+}
+
+CG2Capture::~CG2Capture()
+{
+	stop();
+}
+
+bool CG2Capture::start(const QString& sPath)
+{
+	QMutexLocker l(&m_pSection);
+
+	if(m_oFile.isOpen())
+	{
+		return false;
+	}
+
+	m_oFile.setFileName(sPath);
+	if(!m_oFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		systemLog.postLog(LogSeverity::Error, Components::G2, "Could not open G2 capture file %s",
+						  qPrintable(sPath));
+		return false;
+	}
+
+	m_oStream.setDevice(&m_oFile);
+	m_oStream.setByteOrder(QDataStream::BigEndian);
+	m_oStream.writeRawData(Magic, 6);
+	m_oStream << quint16(CaptureVersion);
+
+	m_tStarted.start();
+	m_nNextStream = 1;
+	m_bActive.storeRelease(1);
+
+	systemLog.postLog(LogSeverity::Notice, Components::G2, "Capturing G2 traffic to %s", qPrintable(sPath));
+	return true;
+}
+
+void CG2Capture::stop()
+{
+	QMutexLocker l(&m_pSection);
+
+	if(!m_oFile.isOpen())
+	{
+		return;
+	}
+
+	m_bActive.storeRelease(0);
+	m_oStream.setDevice(0);
+	m_oFile.close();
+}
+
+quint32 CG2Capture::openStream(const CEndPoint& oAddress, G2NodeType nType, bool bDeflated, const char* pData, quint32 nLength)
+{
+	QMutexLocker l(&m_pSection);
+
+	if(!m_oFile.isOpen())
+	{
+		return 0;
+	}
+
+	quint32 nStream = m_nNextStream++;
+
+	writeHeader(crStreamOpen, nStream);
+	m_oStream << oAddress << quint8(nType) << quint8(bDeflated) << QByteArray::fromRawData(pData, nLength);
+
+	return nStream;
+}
+
+void CG2Capture::streamData(quint32 nStream, const char* pData, quint32 nLength)
+{
+	QMutexLocker l(&m_pSection);
+
+	if(!m_oFile.isOpen())
+	{
+		return;
+	}
+
+	writeHeader(crStreamData, nStream);
+	m_oStream << QByteArray::fromRawData(pData, nLength);
+}
+
+void CG2Capture::closeStream(quint32 nStream)
+{
+	QMutexLocker l(&m_pSection);
+
+	if(!m_oFile.isOpen())
+	{
+		return;
+	}
+
+	writeHeader(crStreamClose, nStream);
+}
+
+void CG2Capture::datagram(const CEndPoint& oAddress, const char* pData, quint32 nLength)
+{
+	QMutexLocker l(&m_pSection);
+
+	if(!m_oFile.isOpen())
+	{
+		return;
+	}
+
+	writeHeader(crDatagram, 0);
+	m_oStream << oAddress << QByteArray::fromRawData(pData, nLength);
+}
+
+void CG2Capture::writeHeader(RecordType nType, quint32 nStream)
+{
+	m_oStream << quint8(nType) << quint32(m_tStarted.elapsed()) << nStream;
+}
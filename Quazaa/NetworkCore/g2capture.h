@@ -0,0 +1,94 @@
+/*
+** g2capture.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#ifndef G2CAPTURE_H
+#define G2CAPTURE_H
+
+#include <QAtomicInt>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+
+#include "endpoint.h"
+#include "types.h"
+
+// Records inbound G2 traffic for offline replay (see G2Replay/g2replay.h): TCP streams of connected
+// neighbours as read from the socket (after the handshake, before inflating) and raw UDP
+// datagrams. Enabled with the command line option --capture-g2 <file>.
+//
+// File format (QDataStream, big endian): "QG2CAP", quint16 version, then records of
+// quint8 type, quint32 ms since capture start, quint32 stream id (0 for datagrams) and
+//   crStreamOpen:  CEndPoint, quint8 G2NodeType, quint8 deflated, QByteArray data
+//   crStreamData:  QByteArray data
+//   crStreamClose: -
+//   crDatagram:    CEndPoint, QByteArray data
+class CG2Capture
+{
+public:
+	enum RecordType
+	{
+		crStreamOpen = 1,
+		crStreamData,
+		crStreamClose,
+		crDatagram
+	};
+
+	enum { CaptureVersion = 1 };
+
+	static const char* Magic;
+
+protected:
+	QMutex          m_pSection;
+	QFile           m_oFile;
+	QDataStream     m_oStream;
+	QElapsedTimer   m_tStarted;
+	quint32         m_nNextStream;
+	QAtomicInt      m_bActive;
+
+public:
+	CG2Capture();
+	~CG2Capture();
+
+	bool start(const QString& sPath);
+	void stop();
+
+	inline bool isActive() const
+	{
+		return m_bActive.loadAcquire();
+	}
+
+	quint32 openStream(const CEndPoint& oAddress, G2NodeType nType, bool bDeflated, const char* pData, quint32 nLength);
+	void streamData(quint32 nStream, const char* pData, quint32 nLength);
+	void closeStream(quint32 nStream);
+	void datagram(const CEndPoint& oAddress, const char* pData, quint32 nLength);
+
+protected:
+	void writeHeader(RecordType nType, quint32 nStream);
+};
+
+extern CG2Capture G2Capture;
+
+#endif // G2CAPTURE_H
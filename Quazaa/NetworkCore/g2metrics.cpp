@@ -0,0 +1,361 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "g2metrics.h"
+#include "g2packet.h"
+#include "systemlog.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThreadStorage>
+#include <QTimerEvent>
+
+#include "debug_new.h"
+
+const int G2MetricsAggregateInterval = 10000;  // ms, well before 32 bit shard counters can wrap
+
+CG2Metrics G2Metrics;
+
+// Counters of one thread. Only the owning thread writes m_lLive, so increments need no
+// atomic read-modify-write; the aggregator reads them relaxed and remembers what it has seen.
+class CG2MetricsShard
+{
+public:
+	QAtomicInt m_lLive[CG2Metrics::ctCount];
+	quint32    m_lFolded[CG2Metrics::ctCount];   // guarded by CG2Metrics::m_pSection
+
+	CG2MetricsShard()
+	{
+		memset(m_lFolded, 0, sizeof(m_lFolded));
+	}
+
+	inline void add(int nCounter, quint32 nBy)
+	{
+		m_lLive[nCounter].store(int(quint32(m_lLive[nCounter].load()) + nBy));
+	}
+};
+
+struct CG2MetricsShardRef
+{
+	CG2MetricsShard* pShard;
+
+	CG2MetricsShardRef() :
+		pShard(0)
+	{
+	}
+};
+
+static QThreadStorage<CG2MetricsShardRef> g_oThreadShard;
+
+CG2Metrics::CG2Metrics() :
+	m_pServer(0),
+	m_nAggregateTimer(0)
+{
+	memset(m_lTotals, 0, sizeof(m_lTotals));
+	m_tStarted.start();
+}
+
+CG2Metrics::~CG2Metrics()
+{
+	qDeleteAll(m_lShards);
+}
+
+void CG2Metrics::start()
+{
+	if(m_pServer)
+	{
+		return;
+	}
+
+	m_pServer = new QLocalServer(this);
+	connect(m_pServer, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+
+	QLocalServer::removeServer("quazaa-g2metrics");
+	if(!m_pServer->listen("quazaa-g2metrics"))
+	{
+		systemLog.postLog(LogSeverity::Warning, Components::G2, "Could not open metrics socket: %s",
+						  qPrintable(m_pServer->errorString()));
+	}
+
+	m_nAggregateTimer = startTimer(G2MetricsAggregateInterval);
+}
+
+void CG2Metrics::stop()
+{
+	if(m_nAggregateTimer)
+	{
+		killTimer(m_nAggregateTimer);
+		m_nAggregateTimer = 0;
+	}
+
+	if(m_pServer)
+	{
+		m_pServer->close();
+		delete m_pServer;
+		m_pServer = 0;
+	}
+}
+
+G2PacketClass CG2Metrics::classify(const G2Packet* pPacket)
+{
+	const char* szType = pPacket->m_sType;
+
+	switch(szType[0])
+	{
+	case 'C':
+		return strcmp(szType, "CRAWLR") == 0 ? pcCRAWLR : pcOther;
+	case 'H':
+		return strcmp(szType, "HAW") == 0 ? pcHAW : pcOther;
+	case 'K':
+		return strcmp(szType, "KHL") == 0 ? pcKHL : pcOther;
+	case 'L':
+		return strcmp(szType, "LNI") == 0 ? pcLNI : pcOther;
+	case 'P':
+		if(strcmp(szType, "PI") == 0)
+		{
+			return pcPI;
+		}
+		return strcmp(szType, "PO") == 0 ? pcPO : pcOther;
+	case 'Q':
+		if(strcmp(szType, "Q2") == 0)
+		{
+			return pcQ2;
+		}
+		if(strcmp(szType, "QH2") == 0)
+		{
+			return pcQH2;
+		}
+		if(strcmp(szType, "QA") == 0)
+		{
+			return pcQA;
+		}
+		if(strcmp(szType, "QHT") == 0)
+		{
+			return pcQHT;
+		}
+		if(strcmp(szType, "QKR") == 0)
+		{
+			return pcQKR;
+		}
+		return strcmp(szType, "QKA") == 0 ? pcQKA : pcOther;
+	default:
+		return pcOther;
+	}
+}
+
+const char* CG2Metrics::className(G2PacketClass nClass)
+{
+	static const char* lNames[pcCount] =
+	{
+		"PI", "PO", "LNI", "KHL", "QHT", "Q2", "QH2", "QA", "QKR", "QKA", "HAW", "CRAWLR", "other"
+	};
+
+	return lNames[nClass];
+}
+
+void CG2Metrics::packetIn(G2Transport nTransport, G2PacketClass nClass, quint32 nBytes, qint64 nNsecs, bool bRouted)
+{
+	CG2MetricsShard* pShard = shard();
+
+	pShard->add(counter(nTransport, nClass, ctPacketsIn), 1);
+	pShard->add(counter(nTransport, nClass, ctBytesIn), nBytes);
+
+	if(bRouted)
+	{
+		pShard->add(counter(nTransport, nClass, ctRouted), 1);
+	}
+
+	qint64 nUsecs = nNsecs / 1000;
+	int nBucket = 0;
+	while(nUsecs && nBucket < LatencyBuckets - 1)
+	{
+		nUsecs >>= 1;
+		++nBucket;
+	}
+	pShard->add(counter(nTransport, nClass, ctLatency + nBucket), 1);
+}
+
+void CG2Metrics::packetOut(G2Transport nTransport, G2PacketClass nClass, quint32 nBytes)
+{
+	CG2MetricsShard* pShard = shard();
+
+	pShard->add(counter(nTransport, nClass, ctPacketsOut), 1);
+	pShard->add(counter(nTransport, nClass, ctBytesOut), nBytes);
+}
+
+void CG2Metrics::drop(G2Transport nTransport, G2PacketClass nClass, G2DropReason nReason)
+{
+	shard()->add(counter(nTransport, nClass, ctDrops + nReason), 1);
+}
+
+CG2MetricsShard* CG2Metrics::shard()
+{
+	CG2MetricsShardRef& oRef = g_oThreadShard.localData();
+
+	if(!oRef.pShard)
+	{
+		// kept after the thread exits, so its counts stay in the totals
+		oRef.pShard = new CG2MetricsShard();
+
+		QMutexLocker l(&m_pSection);
+		m_lShards.append(oRef.pShard);
+	}
+
+	return oRef.pShard;
+}
+
+void CG2Metrics::aggregate()
+{
+	QMutexLocker l(&m_pSection);
+
+	foreach(CG2MetricsShard* pShard, m_lShards)
+	{
+		for(int i = 0; i < ctCount; ++i)
+		{
+			const quint32 nLive = quint32(pShard->m_lLive[i].load());
+			m_lTotals[i] += quint32(nLive - pShard->m_lFolded[i]);
+			pShard->m_lFolded[i] = nLive;
+		}
+	}
+}
+
+// Text in the Prometheus exposition format, series without traffic are left out.
+QByteArray CG2Metrics::report()
+{
+	static const char* lTransports[gtCount] = { "tcp", "udp" };
+	static const char* lReasons[drCount] = { "malformed", "unknown", "queue_full", "expired" };
+	static const char* lSeries[ctDrops] =
+	{
+		"g2_packets_in_total", "g2_bytes_in_total", "g2_packets_out_total", "g2_bytes_out_total", "g2_packets_routed_total"
+	};
+
+	aggregate();
+
+	QMutexLocker l(&m_pSection);
+
+	QByteArray baReport;
+	baReport.append("# Quazaa G2 metrics\n");
+	baReport.append("g2_uptime_seconds ").append(QByteArray::number(m_tStarted.elapsed() / 1000)).append('\n');
+
+	for(int nTransport = 0; nTransport < gtCount; ++nTransport)
+	{
+		for(int nClass = 0; nClass < pcCount; ++nClass)
+		{
+			const quint64* pCounters = &m_lTotals[counter(G2Transport(nTransport), G2PacketClass(nClass), 0)];
+			const QByteArray sLabels = QByteArray("transport=\"") + lTransports[nTransport] +
+									   "\",type=\"" + className(G2PacketClass(nClass)) + "\"";
+
+			for(int i = 0; i < ctDrops; ++i)
+			{
+				if(pCounters[i])
+				{
+					baReport.append(lSeries[i]).append('{').append(sLabels).append("} ")
+							.append(QByteArray::number(pCounters[i])).append('\n');
+				}
+			}
+
+			for(int i = 0; i < drCount; ++i)
+			{
+				if(pCounters[ctDrops + i])
+				{
+					baReport.append("g2_packets_dropped_total{").append(sLabels).append(",reason=\"")
+							.append(lReasons[i]).append("\"} ").append(QByteArray::number(pCounters[ctDrops + i])).append('\n');
+				}
+			}
+
+			if(!pCounters[ctPacketsIn])
+			{
+				continue;
+			}
+
+			quint64 nCumulative = 0;
+			for(int i = 0; i < LatencyBuckets; ++i)
+			{
+				nCumulative += pCounters[ctLatency + i];
+				const QByteArray sBound = (i < LatencyBuckets - 1) ? QByteArray::number(1 << i) : QByteArray("+Inf");
+				baReport.append("g2_handler_microseconds_bucket{").append(sLabels).append(",le=\"").append(sBound)
+						.append("\"} ").append(QByteArray::number(nCumulative)).append('\n');
+			}
+		}
+	}
+
+	return baReport;
+}
+
+quint64 CG2Metrics::totalPacketsIn()
+{
+	aggregate();
+
+	QMutexLocker l(&m_pSection);
+
+	quint64 nTotal = 0;
+	for(int nTransport = 0; nTransport < gtCount; ++nTransport)
+	{
+		for(int nClass = 0; nClass < pcCount; ++nClass)
+		{
+			nTotal += m_lTotals[counter(G2Transport(nTransport), G2PacketClass(nClass), ctPacketsIn)];
+		}
+	}
+
+	return nTotal;
+}
+
+void CG2Metrics::timerEvent(QTimerEvent* event)
+{
+	if(event->timerId() == m_nAggregateTimer)
+	{
+		aggregate();
+	}
+	else
+	{
+		QObject::timerEvent(event);
+	}
+}
+
+void CG2Metrics::onNewConnection()
+{
+	while(m_pServer && m_pServer->hasPendingConnections())
+	{
+		QLocalSocket* pSocket = m_pServer->nextPendingConnection();
+		connect(pSocket, SIGNAL(disconnected()), pSocket, SLOT(deleteLater()));
+
+		pSocket->write(report());
+		pSocket->disconnectFromServer();
+	}
+}
+
+CG2MetricsScope::CG2MetricsScope(G2Transport nTransport, const G2Packet* pPacket) :
+	m_nTransport(nTransport),
+	m_nClass(CG2Metrics::classify(pPacket)),
+	m_nBytes(pPacket->m_nLength),
+	m_bRouted(false)
+{
+	m_tHandler.start();
+}
+
+CG2MetricsScope::~CG2MetricsScope()
+{
+	G2Metrics.packetIn(m_nTransport, m_nClass, m_nBytes, m_tHandler.nsecsElapsed(), m_bRouted);
+}
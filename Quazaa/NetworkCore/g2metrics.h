@@ -0,0 +1,169 @@
+/*
+** g2metrics.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#ifndef G2METRICS_H
+#define G2METRICS_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+
+class G2Packet;
+class QLocalServer;
+class CG2MetricsShard;
+
+// Packet types broken out in the metrics, everything else is counted as pcOther.
+enum G2PacketClass
+{
+	pcPI,
+	pcPO,
+	pcLNI,
+	pcKHL,
+	pcQHT,
+	pcQ2,
+	pcQH2,
+	pcQA,
+	pcQKR,
+	pcQKA,
+	pcHAW,
+	pcCRAWLR,
+	pcOther,
+	pcCount
+};
+
+enum G2Transport
+{
+	gtTCP,
+	gtUDP,
+	gtCount
+};
+
+enum G2DropReason
+{
+	drMalformed,    // parser threw
+	drUnknown,      // no handler for the type
+	drQueueFull,    // send queue or datagram buffers exhausted
+	drExpired,      // sat in the send queue for too long
+	drCount
+};
+
+// Counters per transport and packet type: packets and bytes in/out, packets routed
+// instead of handled, drops by reason and a log2 histogram of handler time in µs.
+// Every thread counts into its own shard without locking; the shards are folded into
+// 64 bit totals periodically and on request. The totals are served as text on the
+// local socket "quazaa-g2metrics" (e.g. socat - UNIX-CONNECT:/tmp/quazaa-g2metrics).
+class CG2Metrics : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum
+	{
+		LatencyBuckets = 16,                                        // <1µs, <2µs, <4µs ... >=16ms
+		ctPacketsIn = 0,
+		ctBytesIn,
+		ctPacketsOut,
+		ctBytesOut,
+		ctRouted,
+		ctDrops,
+		ctLatency   = ctDrops + drCount,
+		ctPerType   = ctLatency + LatencyBuckets,
+		ctCount     = ctPerType * pcCount * gtCount
+	};
+
+protected:
+	QMutex                   m_pSection;    // guards the shard list and the totals
+	QList<CG2MetricsShard*>  m_lShards;
+	quint64                  m_lTotals[ctCount];
+	QElapsedTimer            m_tStarted;
+
+	QLocalServer*            m_pServer;
+	int                      m_nAggregateTimer;
+
+public:
+	CG2Metrics();
+	~CG2Metrics();
+
+	void start();
+	void stop();
+
+	static G2PacketClass classify(const G2Packet* pPacket);
+	static const char* className(G2PacketClass nClass);
+
+	void packetIn(G2Transport nTransport, G2PacketClass nClass, quint32 nBytes, qint64 nNsecs, bool bRouted);
+	void packetOut(G2Transport nTransport, G2PacketClass nClass, quint32 nBytes);
+	void drop(G2Transport nTransport, G2PacketClass nClass, G2DropReason nReason);
+
+	QByteArray report();
+	quint64 totalPacketsIn();
+
+protected:
+	void timerEvent(QTimerEvent* event);
+
+	CG2MetricsShard* shard();
+	void aggregate();
+
+	static inline int counter(G2Transport nTransport, G2PacketClass nClass, int nCounter)
+	{
+		return (nTransport * pcCount + nClass) * ctPerType + nCounter;
+	}
+
+protected slots:
+	void onNewConnection();
+};
+
+extern CG2Metrics G2Metrics;
+
+// Times one received packet from construction to destruction and accounts it.
+class CG2MetricsScope
+{
+protected:
+	G2Transport     m_nTransport;
+	G2PacketClass   m_nClass;
+	quint32         m_nBytes;
+	bool            m_bRouted;
+	QElapsedTimer   m_tHandler;
+
+public:
+	CG2MetricsScope(G2Transport nTransport, const G2Packet* pPacket);
+	~CG2MetricsScope();
+
+	inline G2PacketClass packetClass() const
+	{
+		return m_nClass;
+	}
+	inline void routed()
+	{
+		m_bRouted = true;
+	}
+	inline void drop(G2DropReason nReason)
+	{
+		G2Metrics.drop(m_nTransport, m_nClass, nReason);
+	}
+};
+
+#endif // G2METRICS_H
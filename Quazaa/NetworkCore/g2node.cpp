@@ -26,7 +26,7 @@
 #include "network.h"
 #include "neighbours.h"
 #include "g2packet.h"
-#include "parser.h"
+#include "headerparser.h"
 #include "datagrams.h"
 #include "searchmanager.h"
 #include "Hashes/hash.h"
@@ -35,6 +35,8 @@
 #include "queryhashtable.h"
 #include "queryhashmaster.h"
 #include "hubhorizon.h"
+#include "g2metrics.h"
+#include "g2capture.h"
 #include "securitymanager.h"
 
 #include "HostCache/hostcache.h"
@@ -46,6 +48,9 @@
 
 //#define _DISABLE_COMPRESSION
 
+const quint32 G2SendQueueBudget = 256 * 1024;  // bytes of buffered packets per neighbour
+const quint32 G2QueryMaxAge     = 10;           // seconds a forwarded query may wait
+
 CG2Node::CG2Node(QObject* parent) :
 	CNeighbour(parent),
 	m_pHubGroup(new CHubHorizonGroup)
@@ -66,15 +71,24 @@ CG2Node::CG2Node(QObject* parent) :
 	m_pRemoteTable = 0;
 
 	m_nHAWWait = 0;
+
+	m_nSendQueueBytes = 0;
+	for(int i = 0; i < scCount; ++i)
+	{
+		m_nSendDropped[i] = 0;
+	}
 }
 
 CG2Node::~CG2Node()
 {
 	Network.m_oRoutingTable.remove(this);
 
-	while(m_lSendQueue.size())
+	for(int i = 0; i < scCount; ++i)
 	{
-		m_lSendQueue.dequeue()->release();
+		while(!m_lSendQueue[i].isEmpty())
+		{
+			m_lSendQueue[i].dequeue().pPacket->release();
+		}
 	}
 
 	if(m_pLocalTable)
@@ -95,16 +109,29 @@ void CG2Node::sendPacket(G2Packet* pPacket, bool bBuffered, bool bRelease)
 	ASSUME_LOCK(Neighbours.m_pSection);
 
 	m_nPacketsOut++;
+	G2Metrics.packetOut(gtTCP, CG2Metrics::classify(pPacket), pPacket->m_nLength);
 
 	if(bBuffered)
 	{
-		while(m_lSendQueue.size() > 128)
+		G2SendClass nClass = sendClass(pPacket);
+		G2QueuedPacket oQueued;
+		oQueued.pPacket = pPacket;
+		oQueued.nSize = pPacket->m_nLength + strlen(pPacket->m_sType) + 4;
+		oQueued.tQueued = time(0);
+
+		expireQueries(oQueued.tQueued);
+
+		if(makeRoom(nClass, oQueued.nSize))
 		{
-			m_lSendQueue.dequeue()->release();
+			pPacket->addRef();
+			m_lSendQueue[nClass].enqueue(oQueued);
+			m_nSendQueueBytes += oQueued.nSize;
+		}
+		else
+		{
+			m_nSendDropped[nClass]++;
+			G2Metrics.drop(gtTCP, CG2Metrics::classify(pPacket), drQueueFull);
 		}
-
-		pPacket->addRef();
-		m_lSendQueue.enqueue(pPacket);
 	}
 	else
 	{
@@ -119,6 +146,72 @@ void CG2Node::sendPacket(G2Packet* pPacket, bool bBuffered, bool bRelease)
 	emit readyToTransfer();
 }
 
+// Records the raw stream from here on if G2 traffic is being captured. Anything left in the
+// input buffer after the handshake is the start of the stream.
+void CG2Node::startCapture()
+{
+	if(G2Capture.isActive())
+	{
+		m_nCaptureStream = G2Capture.openStream(m_oAddress, m_nType, m_bCompressedInput,
+												m_pInput->data(), m_pInput->size());
+	}
+}
+
+// Turns this node into a connected neighbour without a peer, for CG2Replay. The socket
+// is never connected and only stands in for a real one.
+void CG2Node::startReplay(G2NodeType nType, bool bDeflated)
+{
+	Q_ASSERT(m_pSocket == 0);
+
+	m_pSocket = new QTcpSocket();
+	m_pInput = new CBuffer(8192);
+	m_pOutput = new CBuffer(8192);
+	m_bConnected = true;
+	m_tConnected = time(0);
+
+	m_nType = nType;
+	if(bDeflated)
+	{
+		enableInputCompression();
+	}
+
+	m_nState = nsConnected;
+	m_tLastPacketIn = m_tLastPacketOut = time(0);
+
+	if(m_nType == G2_HUB)
+	{
+		m_pLocalTable = new CQueryHashTable();
+	}
+}
+
+// Feeds captured raw stream data through the regular receive path and throws away
+// whatever the handlers sent in response.
+void CG2Node::replayInput(const char* pData, quint32 nLength)
+{
+	m_pInput->append(pData, nLength);
+
+	if(m_bCompressedInput)
+	{
+		inflateInput();
+	}
+
+	onRead();
+
+	QMutexLocker l(&Neighbours.m_pSection);
+
+	for(int i = 0; i < scCount; ++i)
+	{
+		while(!m_lSendQueue[i].isEmpty())
+		{
+			m_lSendQueue[i].dequeue().pPacket->release();
+		}
+	}
+	m_nSendQueueBytes = 0;
+
+	getOutputBuffer()->clear();
+	m_pOutput->clear();
+}
+
 void CG2Node::onConnectNode()
 {
 	//QMutexLocker l(&Neighbours.m_pSection);
@@ -168,8 +261,13 @@ void CG2Node::onRead()
 	//qDebug() << "CG2Node::OnRead";
 	if(m_nState == nsHandshaking)
 	{
-		if(peek(bytesAvailable()).indexOf("\r\n\r\n") != -1)
+		switch(m_oHeaders.parse(getInputBuffer()))
 		{
+		case CHeaderParser::hsIncomplete:
+			break;
+		case CHeaderParser::hsComplete:
+			getInputBuffer()->remove(m_oHeaders.length());
+
 			if(m_bInitiated)
 			{
 				parseOutgoingHandshake();
@@ -178,6 +276,14 @@ void CG2Node::onRead()
 			{
 				parseIncomingHandshake();
 			}
+
+			m_oHeaders.reset();
+			break;
+		default:
+			systemLog.postLog(LogSeverity::Debug, Components::G2, "Closing connection to %s - oversized or malformed handshake",
+							  qPrintable(m_oAddress.toStringWithPort()));
+			close();
+			break;
 		}
 	}
 	else if(m_nState == nsConnected)
@@ -200,6 +306,7 @@ void CG2Node::onRead()
 		{
 			if(pPacket)
 			{
+				G2Metrics.drop(gtTCP, CG2Metrics::classify(pPacket), drMalformed);
 				systemLog.postLog(LogSeverity::Debug, QString("%1").arg(pPacket->dump()));
 				pPacket->release();
 			}
@@ -302,16 +409,11 @@ void CG2Node::parseIncomingHandshake()
 {
 	//QMutexLocker l(&Neighbours.m_pSection);
 
-	qint32 nIndex = peek(bytesAvailable()).indexOf("\r\n\r\n");
-	QString sHs = read(nIndex + 4);
-
-	//qDebug() << "Handshake receive:\n" << sHs;
-
-	m_sHandshake += "Handshake in:\n" + sHs;
+	m_sHandshake += "Handshake in:\n" + m_oHeaders.toString();
 
 	if(m_sUserAgent.isEmpty())
 	{
-		m_sUserAgent = Parser::getHeaderValue(sHs, "User-Agent");
+		m_sUserAgent = m_oHeaders.value("User-Agent");
 	}
 
 	if(m_sUserAgent.isEmpty())
@@ -327,9 +429,9 @@ void CG2Node::parseIncomingHandshake()
 		return;
 	}
 
-	if(sHs.startsWith("GNUTELLA CONNECT/0.6"))
+	if(m_oHeaders.startLine().startsWith("GNUTELLA CONNECT/0.6"))
 	{
-		QString sAccept = Parser::getHeaderValue(sHs, "Accept");
+		QString sAccept = m_oHeaders.value("Accept");
 		bool bAcceptG2 = sAccept.contains("application/x-gnutella2");
 
 		if(!bAcceptG2)
@@ -340,18 +442,18 @@ void CG2Node::parseIncomingHandshake()
 
 #ifndef _DISABLE_COMPRESSION
 		m_bAcceptDeflate = false;
-		QString sAcceptEnc = Parser::getHeaderValue(sHs, "Accept-Encoding");
+		QString sAcceptEnc = m_oHeaders.value("Accept-Encoding");
 		if(sAcceptEnc.contains("deflate") && Neighbours.isG2Hub())
 		{
 			m_bAcceptDeflate = true;
 		}
 #endif
 
-		QString sUltra = Parser::getHeaderValue(sHs, "X-Ultrapeer").toLower();
-		//QString sUltraNeeded = Parser::getHeaderValue(sHs, "X-Ultrapeer-Needed").toLower();
+		QString sUltra = m_oHeaders.value("X-Ultrapeer").toLower();
+		//QString sUltraNeeded = m_oHeaders.value("X-Ultrapeer-Needed").toLower();
 		if(sUltra.isEmpty())
 		{
-			sUltra = Parser::getHeaderValue(sHs, "X-Hub").toLower();
+			sUltra = m_oHeaders.value("X-Hub").toLower();
 
 			if( sUltra.isEmpty() )
 			{
@@ -360,7 +462,7 @@ void CG2Node::parseIncomingHandshake()
 			}
 		}
 
-		QString sRemoteIP = Parser::getHeaderValue(sHs, "Remote-IP");
+		QString sRemoteIP = m_oHeaders.value("Remote-IP");
 		if(!sRemoteIP.isEmpty())
 		{
 			Network.acquireLocalAddress(sRemoteIP);
@@ -401,9 +503,9 @@ void CG2Node::parseIncomingHandshake()
 		send_ConnectOK(false, m_bAcceptDeflate);
 
 	}
-	else if(sHs.contains(" 200 OK"))
+	else if(m_oHeaders.startLine().contains(" 200 OK"))
 	{
-		QString sContentType = Parser::getHeaderValue(sHs, "Content-Type");
+		QString sContentType = m_oHeaders.value("Content-Type");
 		bool bG2Provided = sContentType.contains("application/x-gnutella2");
 
 		if(!bG2Provided)
@@ -413,7 +515,7 @@ void CG2Node::parseIncomingHandshake()
 		}
 
 #ifndef _DISABLE_COMPRESSION
-		QString sContentEnc = Parser::getHeaderValue(sHs, "Content-Encoding");
+		QString sContentEnc = m_oHeaders.value("Content-Encoding");
 		if(sContentEnc.contains("deflate"))
 		{
 			if(!enableInputCompression())
@@ -438,20 +540,21 @@ void CG2Node::parseIncomingHandshake()
 #endif
 
 		m_nState = nsConnected;
+		startCapture();
 		emit nodeStateChanged();
 
 		sendStartups();
 		m_tLastPacketIn = m_tLastPacketOut = time(0);
 		if(m_nType == G2_HUB)
 		{
+			Neighbours.invalidateHubCaches();
 			m_pLocalTable = new CQueryHashTable();
 		}
 
 	}
 	else
 	{
-		systemLog.postLog(LogSeverity::Debug, QString("Connection to %1 rejected: %2").arg(this->m_oAddress.toString()).arg(sHs.left(sHs.indexOf("\r\n"))));
-		//qDebug() << "Connection rejected: " << sHs.left(sHs.indexOf("\r\n"));
+		systemLog.postLog(LogSeverity::Debug, QString("Connection to %1 rejected: %2").arg(this->m_oAddress.toString()).arg(QString(m_oHeaders.startLine())));
 		m_nState = nsClosing;
 		emit nodeStateChanged();
 		close();
@@ -461,13 +564,9 @@ void CG2Node::parseIncomingHandshake()
 void CG2Node::parseOutgoingHandshake()
 {
 	//QMutexLocker l(&Neighbours.m_pSection);
-	QString sHs = read(peek(bytesAvailable()).indexOf("\r\n\r\n") + 4);
+	m_sHandshake += "Handshake in:\n" + m_oHeaders.toString();
 
-	//qDebug() << "Handshake receive:\n" << sHs;
-
-	m_sHandshake += "Handshake in:\n" + sHs;
-
-	QString sAccept = Parser::getHeaderValue(sHs, "Accept");
+	QString sAccept = m_oHeaders.value("Accept");
 	bool bAcceptG2 = sAccept.contains("application/x-gnutella2");
 
 	if(!bAcceptG2)
@@ -476,7 +575,7 @@ void CG2Node::parseOutgoingHandshake()
 		return;
 	}
 
-	QString sContentType = Parser::getHeaderValue(sHs, "Content-Type");
+	QString sContentType = m_oHeaders.value("Content-Type");
 	bool bG2Provided = sContentType.contains("application/x-gnutella2");
 
 	if(!bG2Provided)
@@ -485,7 +584,7 @@ void CG2Node::parseOutgoingHandshake()
 		return;
 	}
 
-	m_sUserAgent = Parser::getHeaderValue(sHs, "User-Agent");
+	m_sUserAgent = m_oHeaders.value("User-Agent");
 
 	if(m_sUserAgent.isEmpty())
 	{
@@ -500,7 +599,7 @@ void CG2Node::parseOutgoingHandshake()
 		return;
 	}
 
-	QString sTry = Parser::getHeaderValue(sHs, "X-Try-Hubs");
+	QString sTry = m_oHeaders.value("X-Try-Hubs");
 	if(bAcceptG2 && bG2Provided && sTry.size())
 	{
 		hostCache.m_pSection.lock();
@@ -508,9 +607,9 @@ void CG2Node::parseOutgoingHandshake()
 		hostCache.m_pSection.unlock();
 	}
 
-	if(sHs.left(16) != "GNUTELLA/0.6 200")
+	if(!m_oHeaders.startLine().startsWith("GNUTELLA/0.6 200"))
 	{
-		systemLog.postLog(LogSeverity::Error, QString("Connection to %1 rejected: %2").arg(this->m_oAddress.toString()).arg(sHs.left(sHs.indexOf("\r\n"))));
+		systemLog.postLog(LogSeverity::Error, QString("Connection to %1 rejected: %2").arg(this->m_oAddress.toString()).arg(QString(m_oHeaders.startLine())));
 
 		// Is it okay to count non-200 response as a failure? Needs some testing...
 		hostCache.m_pSection.lock();
@@ -521,7 +620,7 @@ void CG2Node::parseOutgoingHandshake()
 		return;
 	}
 
-	QString sRemoteIP = Parser::getHeaderValue(sHs, "Remote-IP");
+	QString sRemoteIP = m_oHeaders.value("Remote-IP");
 	if(!sRemoteIP.isEmpty())
 	{
 		Network.acquireLocalAddress(sRemoteIP);
@@ -532,20 +631,20 @@ void CG2Node::parseOutgoingHandshake()
 		return;
 	}
 
-	QString sUltra = Parser::getHeaderValue(sHs, "X-Ultrapeer").toLower();
+	QString sUltra = m_oHeaders.value("X-Ultrapeer").toLower();
 
 	if( sUltra.isEmpty() )
 	{
-		sUltra = Parser::getHeaderValue(sHs, "X-Hub").toLower();
+		sUltra = m_oHeaders.value("X-Hub").toLower();
 	}
 
-	//QString sUltraNeeded = Parser::getHeaderValue(sHs, "X-Ultrapeer-Needed").toLower();
+	//QString sUltraNeeded = m_oHeaders.value("X-Ultrapeer-Needed").toLower();
 
 	bool bUltra = (sUltra == "true");
 	//bool bUltraNeeded = (sUltraNeeded == "true");
 
 #ifndef _DISABLE_COMPRESSION
-	QString sContentEnc = Parser::getHeaderValue(sHs, "Content-Encoding");
+	QString sContentEnc = m_oHeaders.value("Content-Encoding");
 	if(sContentEnc.contains("deflate"))
 	{
 		if(!enableInputCompression())
@@ -560,7 +659,7 @@ void CG2Node::parseOutgoingHandshake()
 
 	bool bAcceptDeflate = false;
 #ifndef _DISABLE_COMPRESSION
-	QString sAcceptEnc = Parser::getHeaderValue(sHs, "Accept-Encoding");
+	QString sAcceptEnc = m_oHeaders.value("Accept-Encoding");
 	if(sAcceptEnc.contains("deflate") && Neighbours.isG2Hub())
 	{
 		bAcceptDeflate = true;
@@ -596,8 +695,11 @@ void CG2Node::parseOutgoingHandshake()
 
 	hostCache.m_pSection.lock();
 	CHostCacheHost* pThisHost = hostCache.take(m_oAddress);
-	if( pThisHost )
+	if( pThisHost && pThisHost->m_nFailures )
+	{
 		pThisHost->m_nFailures = 0;
+		hostCache.changed();
+	}
 	hostCache.m_pSection.unlock();
 
 #ifndef _DISABLE_COMPRESSION
@@ -614,6 +716,7 @@ void CG2Node::parseOutgoingHandshake()
 #endif
 
 	m_nState = nsConnected;
+	startCapture();
 	emit nodeStateChanged();
 
 	sendStartups();
@@ -621,6 +724,7 @@ void CG2Node::parseOutgoingHandshake()
 
 	if(m_nType == G2_HUB)
 	{
+		Neighbours.invalidateHubCaches();
 		m_pLocalTable = new CQueryHashTable();
 	}
 
@@ -768,66 +872,55 @@ void CG2Node::onPacket(G2Packet* pPacket)
 {
 	//qDebug() << "Got packet " << pPacket->GetType() << pPacket->ToHex() << pPacket->ToASCII();
 
-	//try
-	//{
-	if(!Network.routePacket(pPacket))
+	CG2MetricsScope oMetrics(gtTCP, pPacket);
+
+	if(Network.routePacket(pPacket))
 	{
+		oMetrics.routed();
+		return;
+	}
 
-		if(pPacket->isType("PI"))
-		{
-			onPing(pPacket);
-		}
-		else if(pPacket->isType("PO"))
-		{
-			onPong(pPacket);
-		}
-		else if(pPacket->isType("LNI"))
-		{
-			onLNI(pPacket);
-		}
-		else if(pPacket->isType("KHL"))
-		{
-			onKHL(pPacket);
-		}
-		else if(pPacket->isType("QHT"))
-		{
-			onQHT(pPacket);
-		}
-		else if(pPacket->isType("Q2"))
-		{
-			onQuery(pPacket);
-		}
-		else if(pPacket->isType("QKR"))
-		{
-			onQKR(pPacket);
-		}
-		else if(pPacket->isType("QKA"))
-		{
-			onQKA(pPacket);
-		}
-		else if(pPacket->isType("QA"))
-		{
-			onQA(pPacket);
-		}
-		else if(pPacket->isType("QH2"))
-		{
-			onQH2(pPacket);
-		}
-		else if(pPacket->isType("HAW"))
-		{
-			onHaw(pPacket);
-		}
-		else
-		{
-			systemLog.postLog(LogSeverity::Debug, QString("G2 TCP recieved unknown packet %1").arg(pPacket->getType()));
-			//qDebug() << "Unknown packet " << pPacket->GetType();
-		}
+	switch(oMetrics.packetClass())
+	{
+	case pcPI:
+		onPing(pPacket);
+		break;
+	case pcPO:
+		onPong(pPacket);
+		break;
+	case pcLNI:
+		onLNI(pPacket);
+		break;
+	case pcKHL:
+		onKHL(pPacket);
+		break;
+	case pcQHT:
+		onQHT(pPacket);
+		break;
+	case pcQ2:
+		onQuery(pPacket);
+		break;
+	case pcQKR:
+		onQKR(pPacket);
+		break;
+	case pcQKA:
+		onQKA(pPacket);
+		break;
+	case pcQA:
+		onQA(pPacket);
+		break;
+	case pcQH2:
+		onQH2(pPacket);
+		break;
+	case pcHAW:
+		onHaw(pPacket);
+		break;
+	default:
+		oMetrics.drop(drUnknown);
+		systemLog.postLog(LogSeverity::Debug, QString("G2 TCP recieved unknown packet %1").arg(pPacket->getType()));
+		//qDebug() << "Unknown packet " << pPacket->GetType();
+		break;
 	}
-	/*}
-	catch(...)
-	{
-		qDebug() << "Packet error in child packets";
-	}*/
 }
 
 void CG2Node::onPing(G2Packet* pPacket)
@@ -989,8 +1082,14 @@ void CG2Node::onLNI(G2Packet* pPacket)
 		{
 			if(m_nType == G2_HUB)
 			{
-				m_nLeafCount = pPacket->readIntLE<quint16>();
+				quint16 nLeafCount = pPacket->readIntLE<quint16>();
 				m_nLeafMax = pPacket->readIntLE<quint16>();
+
+				if(nLeafCount != m_nLeafCount)
+				{
+					m_nLeafCount = nLeafCount;
+					Neighbours.invalidateHubCaches();
+				}
 			}
 		}
 		else if(strcmp("QK", szType) == 0)
@@ -1448,11 +1547,21 @@ qint64 CG2Node::writeToNetwork(qint64 nBytes)
 
 	do
 	{
-		if(getOutputBuffer()->isEmpty() && !m_lSendQueue.isEmpty())
+		if(getOutputBuffer()->isEmpty() && hasQueuedPackets())
 		{
-			G2Packet* pPacket = m_lSendQueue.dequeue();
-			pPacket->toBuffer(getOutputBuffer());
-			pPacket->release();
+			expireQueries(time(0));
+
+			for(int i = 0; i < scCount; ++i)
+			{
+				if(!m_lSendQueue[i].isEmpty())
+				{
+					G2QueuedPacket oQueued = m_lSendQueue[i].dequeue();
+					m_nSendQueueBytes -= oQueued.nSize;
+					oQueued.pPacket->toBuffer(getOutputBuffer());
+					oQueued.pPacket->release();
+					break;
+				}
+			}
 		}
 
 		qint64 nSent = CNeighbour::writeToNetwork(nBytes - nTotalSent);
@@ -1469,6 +1578,79 @@ qint64 CG2Node::writeToNetwork(qint64 nBytes)
 	return nTotalSent;
 }
 
+G2SendClass CG2Node::sendClass(G2Packet* pPacket)
+{
+	if(pPacket->isType("Q2"))
+	{
+		return scQueries;
+	}
+	if(pPacket->isType("QH2") || pPacket->isType("QA") || pPacket->isType("PUSH"))
+	{
+		return scHits;
+	}
+	if(pPacket->isType("PI") || pPacket->isType("PO") || pPacket->isType("LNI") || pPacket->isType("KHL")
+	   || pPacket->isType("HAW") || pPacket->isType("QKR") || pPacket->isType("QKA"))
+	{
+		return scControl;
+	}
+
+	return scBulk;
+}
+
+// Frees queue space for a packet of the given class by dropping the oldest packets
+// of its own or less valuable classes: forwarded queries first, then bulk, then hits.
+// Control packets are never dropped and always fit.
+bool CG2Node::makeRoom(G2SendClass nClass, quint32 nSize)
+{
+	static const G2SendClass lVictims[] = { scQueries, scBulk, scHits };
+	static const int nVictims = sizeof(lVictims) / sizeof(lVictims[0]);
+
+	for(int i = 0; i < nVictims && m_nSendQueueBytes + nSize > G2SendQueueBudget; ++i)
+	{
+		G2SendClass nVictim = lVictims[i];
+
+		if(nClass != scControl && nVictim != nClass)
+		{
+			// only displace classes dropped before this one
+			bool bLessValuable = false;
+			for(int j = 0; j < nVictims && lVictims[j] != nClass; ++j)
+			{
+				bLessValuable = bLessValuable || lVictims[j] == nVictim;
+			}
+			if(!bLessValuable)
+			{
+				break;
+			}
+		}
+
+		while(!m_lSendQueue[nVictim].isEmpty() && m_nSendQueueBytes + nSize > G2SendQueueBudget)
+		{
+			G2QueuedPacket oQueued = m_lSendQueue[nVictim].dequeue();
+			m_nSendQueueBytes -= oQueued.nSize;
+			G2Metrics.drop(gtTCP, CG2Metrics::classify(oQueued.pPacket), drQueueFull);
+			oQueued.pPacket->release();
+			m_nSendDropped[nVictim]++;
+		}
+	}
+
+	return (nClass == scControl || m_nSendQueueBytes + nSize <= G2SendQueueBudget);
+}
+
+// Forwarded queries are worthless once their searcher has moved on.
+void CG2Node::expireQueries(quint32 tNow)
+{
+	QQueue<G2QueuedPacket>& lQueries = m_lSendQueue[scQueries];
+
+	while(!lQueries.isEmpty() && tNow - lQueries.head().tQueued > G2QueryMaxAge)
+	{
+		G2QueuedPacket oQueued = lQueries.dequeue();
+		m_nSendQueueBytes -= oQueued.nSize;
+		oQueued.pPacket->release();
+		m_nSendDropped[scQueries]++;
+		G2Metrics.drop(gtTCP, pcQ2, drExpired);
+	}
+}
+
 void CG2Node::sendHAW()
 {
 	G2Packet* pPacket = G2Packet::newPacket("HAW");
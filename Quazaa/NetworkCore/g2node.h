@@ -26,6 +26,7 @@
 #define G2NODE_H
 
 #include "neighbour.h"
+#include "headerparser.h"
 #include <QElapsedTimer>
 #include <QQueue>
 #include <QHash>
@@ -34,6 +35,23 @@ class G2Packet;
 class CQueryHashTable;
 class CHubHorizonGroup;
 
+// Classes of buffered outgoing packets, sent in this order.
+enum G2SendClass
+{
+	scControl,      // PI, PO, LNI, KHL, HAW, QKR, QKA
+	scHits,         // QH2, QA, PUSH
+	scQueries,      // forwarded Q2
+	scBulk,         // everything else
+	scCount
+};
+
+struct G2QueuedPacket
+{
+	G2Packet*   pPacket;
+	quint32     nSize;
+	quint32     tQueued;
+};
+
 class CG2Node : public CNeighbour
 {
 	Q_OBJECT
@@ -47,6 +65,7 @@ public:
 	quint16         m_nLeafMax;
 
 	bool            m_bAcceptDeflate;
+	CHeaderParser   m_oHeaders;             // handshake being received
 
 	quint32         m_tKeyRequest;
 	quint32         m_tLastHAWIn;			// Time when HAW packet recievied
@@ -57,7 +76,9 @@ public:
 
 	quint32         m_nHAWWait;
 
-	QQueue<G2Packet*>   m_lSendQueue;
+	QQueue<G2QueuedPacket> m_lSendQueue[scCount];
+	quint32             m_nSendQueueBytes;          // bytes held in all send queues
+	quint32             m_nSendDropped[scCount];    // packets dropped per class under backpressure
 
 	CQueryHashTable*    m_pRemoteTable;
 	CQueryHashTable*    m_pLocalTable;
@@ -76,9 +97,28 @@ public:
 
 	void sendPacket(G2Packet* pPacket, bool bBuffered = false, bool bRelease = false);
 
+	void startReplay(G2NodeType nType, bool bDeflated);
+	void replayInput(const char* pData, quint32 nLength);
+
 protected:
+	static G2SendClass sendClass(G2Packet* pPacket);
+	bool makeRoom(G2SendClass nClass, quint32 nSize);
+	void expireQueries(quint32 tNow);
+	bool hasQueuedPackets() const
+	{
+		for(int i = 0; i < scCount; ++i)
+		{
+			if(!m_lSendQueue[i].isEmpty())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	void parseOutgoingHandshake();
 	void parseIncomingHandshake();
+	void startCapture();
 
 	void send_ConnectError(QString sReason);
 	void send_ConnectOK(bool bReply, bool bDeflated = false);
@@ -113,7 +153,7 @@ protected:
 	qint64 writeToNetwork(qint64 nBytes);
 	bool hasData()
 	{
-		if ( !m_lSendQueue.isEmpty() )
+		if ( hasQueuedPackets() )
 		{
 			return true;
 		}
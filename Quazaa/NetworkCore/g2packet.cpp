@@ -177,6 +177,7 @@ G2PacketPool::G2PacketPool()
 {
 	m_pFree = 0;
 	m_nFree = 0;
+	m_nAllocated = 0;
 }
 
 G2PacketPool::~G2PacketPool()
@@ -572,6 +573,15 @@ void G2PacketPool::clear()
 	m_nFree = 0;
 }
 
+//////////////////////////////////////////////////////////////////////
+// G2PacketPool allocation count
+
+quint64 G2PacketPool::allocated()
+{
+	QMutexLocker l(&m_pSection);
+	return m_nAllocated;
+}
+
 //////////////////////////////////////////////////////////////////////
 // G2PacketPool new pool setup
 
@@ -135,6 +135,7 @@ public:
 protected:
 	G2Packet* 	m_pFree;
 	quint32		m_nFree;
+	quint64		m_nAllocated;	// packets handed out so far, for benchmarks
 protected:
 	QMutex				m_pSection;
 	QList<G2Packet*>	m_pPools;
@@ -148,6 +149,7 @@ protected:
 public:
 	inline G2Packet* newPacket();
 	inline void deletePacket(G2Packet* pPacket);
+	quint64 allocated();
 
 };
 
@@ -351,6 +353,7 @@ G2Packet* G2PacketPool::newPacket()
 	G2Packet* pPacket = m_pFree;
 	m_pFree = m_pFree->m_pNext;
 	m_nFree --;
+	m_nAllocated++;
 
 	m_pSection.unlock();
 
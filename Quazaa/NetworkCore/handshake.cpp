@@ -28,6 +28,8 @@
 #include "neighbours.h"
 #include "neighbour.h"
 #include "g2node.h"
+#include "transfers.h"
+#include "uploads.h"
 
 #include <QTcpSocket>
 #include <QFile>
@@ -37,7 +39,8 @@
 #include "debug_new.h"
 
 CHandshake::CHandshake(QObject* parent)
-	: CNetworkConnection(parent)
+	: CNetworkConnection(parent),
+	  m_oRequest(8192, 64)
 {
 }
 CHandshake::~CHandshake()
@@ -73,13 +76,26 @@ void CHandshake::onRead()
 		Handshakes.processNeighbour(this);
 		delete this;
 	}
-	else if(peek(5).startsWith("GET /"))
+	else if(peek(5).startsWith("GET /") || peek(6).startsWith("HEAD /"))
 	{
-		if( peek(bytesAvailable()).indexOf("\r\n\r\n") != -1 )
+		CHeaderParser::State nState = m_oRequest.parse(getInputBuffer());
+
+		if( nState == CHeaderParser::hsComplete && CUploads::isUploadRequest(m_oRequest.startLine()) && Transfers.m_bActive )
+		{
+			systemLog.postLog(LogSeverity::Debug, QString("Incoming connection from %1 is an upload request").arg(m_pSocket->peerAddress().toString().toLocal8Bit().constData()));
+			Handshakes.processUpload(this);
+			delete this;
+		}
+		else if( nState == CHeaderParser::hsComplete )
 		{
 			systemLog.postLog(LogSeverity::Debug, QString("Incoming connection from %1 is a Web request").arg(m_pSocket->peerAddress().toString().toLocal8Bit().constData()));
 			onWebRequest();
 		}
+		else if( nState != CHeaderParser::hsIncomplete )
+		{
+			systemLog.postLog(LogSeverity::Debug, QString("Closing connection with %1 - oversized Web request").arg(m_pSocket->peerAddress().toString().toLocal8Bit().constData()));
+			close();
+		}
 	}
 	else
 	{
@@ -121,14 +137,10 @@ void CHandshake::onStateChange(QAbstractSocket::SocketState s)
 
 void CHandshake::onWebRequest()
 {
-	QString sRequest;
-
-	sRequest = read(bytesAvailable());
-	sRequest = sRequest.left(sRequest.indexOf("\r\n\r\n"));
+	const QString sRequestLine = m_oRequest.startLine();
+	getInputBuffer()->clear();
 
-	QStringList arrLines = sRequest.split("\r\n");
-
-	if( arrLines[0].startsWith("GET / HTTP") )
+	if( sRequestLine.startsWith("GET / HTTP") )
 	{
 		QByteArray baResp;
 
@@ -211,7 +223,7 @@ void CHandshake::onWebRequest()
 	{
 		QByteArray baResp;
 
-		QString sPath = arrLines[0].mid(4, arrLines[0].length() - 12).trimmed();
+		QString sPath = sRequestLine.mid(4, sRequestLine.length() - 12).trimmed();
 
 		bool bFound = false;
 
@@ -241,8 +253,6 @@ void CHandshake::onWebRequest()
 			}
 		}
 
-		// TODO: Handle P2P uploads here
-
 		if( !bFound )
 		{
 			baResp += "HTTP/1.1 404 Not found\r\n";
@@ -27,6 +27,7 @@
 
 #include <QObject>
 #include "networkconnection.h"
+#include "headerparser.h"
 
 class CHandshake: public CNetworkConnection
 {
@@ -48,6 +49,9 @@ public slots:
 private:
 	void onWebRequest();
 
+private:
+	CHeaderParser m_oRequest;
+
 };
 
 #endif // HANDSHAKE_H
@@ -28,6 +28,7 @@
 #include "ratecontroller.h"
 #include "neighbours.h"
 #include "securitymanager.h"
+#include "uploads.h"
 
 #include <QTimer>
 
@@ -106,6 +107,47 @@ void CHandshakes::onTimer()
 	}
 }
 
+// Checks pending handshakes against the rules added since the last sanity check, on a snapshot
+// taken under the section, so incoming connections are not held up while the rules are checked.
+void CHandshakes::sanityCheck()
+{
+	QSharedPointer<const CSecuritySanityCheck> pRules = securityManager.newRules();
+
+	if(pRules && pRules->hasAddressRules())
+	{
+		QList<CHandshake*> lHandshakes;
+		QList<CEndPoint> lAddresses;
+
+		m_pSection.lock();
+		lHandshakes = m_lHandshakes.toList();
+		lAddresses.reserve(lHandshakes.size());
+		foreach(CHandshake* pHs, lHandshakes)
+		{
+			lAddresses.append(pHs->m_oAddress);
+		}
+		m_pSection.unlock();
+
+		QList<int> lDenied = pRules->denied(lAddresses);
+
+		if(!lDenied.isEmpty())
+		{
+			QMutexLocker l(&m_pSection);
+
+			foreach(int nIndex, lDenied)
+			{
+				CHandshake* pHs = lHandshakes.at(nIndex);
+
+				if(m_lHandshakes.contains(pHs) && pHs->m_oAddress == lAddresses.at(nIndex))
+				{
+					pHs->close();
+				}
+			}
+		}
+	}
+
+	securityManager.sanityCheckPerformed();
+}
+
 void CHandshakes::removeHandshake(CHandshake* pHs)
 {
 	ASSUME_LOCK(Handshakes.m_pSection);
@@ -123,14 +165,21 @@ void CHandshakes::processNeighbour(CHandshake* pHs)
 	Neighbours.onAccept(pHs);
 }
 
+void CHandshakes::processUpload(CHandshake* pHs)
+{
+	removeHandshake(pHs);
+	Uploads.onAccept(pHs);
+}
+
 void CHandshakes::setupThread()
 {
-	m_pController = new CRateController(&m_pSection);
+	m_pController = new CRateController(&m_pSection, rcHandshakes);
 
 	m_pController->moveToThread(&HandshakesThread); // should not be necesarry
 
 	m_pController->setDownloadLimit(4096);
 	m_pController->setUploadLimit(4096);
+	m_pController->setBorrowing(false);
 
 	bool bOK = QTcpServer::listen(QHostAddress::Any, Network.getLocalAddress().port());
 
@@ -149,9 +198,14 @@ void CHandshakes::setupThread()
 	m_pTimer = new QTimer(this);
 	connect(m_pTimer, SIGNAL(timeout()), this, SLOT(onTimer()));
 	m_pTimer->start(1000);
+
+	// queued: the Security Manager emits while holding its own lock
+	connect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()), Qt::QueuedConnection);
 }
 void CHandshakes::cleanupThread()
 {
+	disconnect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()));
+
 	if(isListening())
 	{
 		close();
@@ -62,6 +62,7 @@ public slots:
 	void listen();
 	void stop();
 	void onTimer();
+	void sanityCheck();
 
 protected slots:
 	void setupThread();
@@ -75,6 +76,7 @@ protected:
 	void removeHandshake(CHandshake* pHs);
 
 	void processNeighbour(CHandshake* pHs);
+	void processUpload(CHandshake* pHs);
 
 	friend class CHandshake;
 };
@@ -0,0 +1,265 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include "headerparser.h"
+#include "buffer.h"
+
+#include <string.h>
+
+#include "debug_new.h"
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+CHeaderParser::CHeaderParser(quint32 nMaxSize, quint32 nMaxFields) :
+	m_nMaxSize(qMin<quint32>(nMaxSize, 0xFFFF)),   // field offsets are 16 bit
+	m_nMaxFields(nMaxFields)
+{
+	reset();
+}
+
+void CHeaderParser::reset()
+{
+	m_nState = hsIncomplete;
+	m_nScanned = 0;
+	m_nLength = 0;
+	m_nStartLine = 0;
+	m_baBlock.clear();
+	m_lFields.clear();
+}
+
+CHeaderParser::State CHeaderParser::parse(CBuffer* pBuffer)
+{
+	return parse(pBuffer->data(), pBuffer->size());
+}
+
+// pData must start with the same bytes as on the previous call, with more appended.
+CHeaderParser::State CHeaderParser::parse(const char* pData, quint32 nLength)
+{
+	if(m_nState != hsIncomplete)
+	{
+		return m_nState;
+	}
+
+	quint32 nEnd = 0;
+
+	while(m_nScanned < nLength)
+	{
+		const char* pLF = (const char*)memchr(pData + m_nScanned, '\n', nLength - m_nScanned);
+
+		if(!pLF)
+		{
+			m_nScanned = nLength;
+			break;
+		}
+
+		quint32 nPos = pLF - pData;
+		m_nScanned = nPos + 1;
+
+		if(nPos >= 3 && memcmp(pLF - 3, "\r\n\r\n", 4) == 0)
+		{
+			nEnd = nPos + 1;
+			break;
+		}
+	}
+
+	if(!nEnd)
+	{
+		if(m_nScanned > m_nMaxSize)
+		{
+			m_nState = hsTooLarge;
+		}
+		return m_nState;
+	}
+
+	if(nEnd > m_nMaxSize)
+	{
+		m_nState = hsTooLarge;
+		return m_nState;
+	}
+
+	m_nLength = nEnd;
+	m_baBlock = QByteArray(pData, nEnd);
+	m_nState = split();
+
+	return m_nState;
+}
+
+// Indexes the lines of m_baBlock. Continuation lines (starting with white space) extend
+// the value of the previous field.
+CHeaderParser::State CHeaderParser::split()
+{
+	const char* pBlock = m_baBlock.constData();
+	const int nSize = m_baBlock.size() - 2;     // the empty line
+
+	int nPos = m_baBlock.indexOf("\r\n");
+	m_nStartLine = nPos;
+	nPos += 2;
+
+	while(nPos < nSize)
+	{
+		int nEOL = m_baBlock.indexOf("\r\n", nPos);
+
+		if(isBlank(pBlock[nPos]))
+		{
+			if(m_lFields.isEmpty())
+			{
+				return hsMalformed;
+			}
+
+			Field& oField = m_lFields[m_lFields.size() - 1];
+			int nValueEnd = nEOL;
+			while(nValueEnd > nPos && isBlank(pBlock[nValueEnd - 1]))
+			{
+				--nValueEnd;
+			}
+			if(nValueEnd > nPos)
+			{
+				if(!oField.nValueLength)
+				{
+					while(isBlank(pBlock[nPos]))
+					{
+						++nPos;
+					}
+					oField.nValue = nPos;
+				}
+				oField.nValueLength = nValueEnd - oField.nValue;
+			}
+		}
+		else
+		{
+			const char* pColon = (const char*)memchr(pBlock + nPos, ':', nEOL - nPos);
+
+			if(!pColon)
+			{
+				return hsMalformed;
+			}
+
+			if(quint32(m_lFields.size()) >= m_nMaxFields)
+			{
+				return hsTooLarge;
+			}
+
+			int nColon = pColon - pBlock;
+			int nNameEnd = nColon;
+			while(nNameEnd > nPos && isBlank(pBlock[nNameEnd - 1]))
+			{
+				--nNameEnd;
+			}
+
+			int nValue = nColon + 1;
+			int nValueEnd = nEOL;
+			while(nValue < nValueEnd && isBlank(pBlock[nValue]))
+			{
+				++nValue;
+			}
+			while(nValueEnd > nValue && isBlank(pBlock[nValueEnd - 1]))
+			{
+				--nValueEnd;
+			}
+
+			Field oField;
+			oField.nName = nPos;
+			oField.nNameLength = nNameEnd - nPos;
+			oField.nValue = nValue;
+			oField.nValueLength = nValueEnd - nValue;
+			m_lFields.append(oField);
+		}
+
+		nPos = nEOL + 2;
+	}
+
+	return hsComplete;
+}
+
+QByteArray CHeaderParser::startLine() const
+{
+	return m_baBlock.left(m_nStartLine);
+}
+
+int CHeaderParser::count() const
+{
+	return m_lFields.size();
+}
+
+QByteArray CHeaderParser::name(int nIndex) const
+{
+	const Field& oField = m_lFields.at(nIndex);
+	return QByteArray(m_baBlock.constData() + oField.nName, oField.nNameLength);
+}
+
+QByteArray CHeaderParser::rawValue(int nIndex) const
+{
+	const Field& oField = m_lFields.at(nIndex);
+	return QByteArray(m_baBlock.constData() + oField.nValue, oField.nValueLength);
+}
+
+int CHeaderParser::find(const char* szName) const
+{
+	const uint nNameLength = qstrlen(szName);
+
+	for(int i = 0; i < m_lFields.size(); ++i)
+	{
+		const Field& oField = m_lFields.at(i);
+
+		if(oField.nNameLength == nNameLength
+		   && qstrnicmp(m_baBlock.constData() + oField.nName, szName, nNameLength) == 0)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+bool CHeaderParser::contains(const char* szName) const
+{
+	return find(szName) != -1;
+}
+
+QByteArray CHeaderParser::rawValue(const char* szName) const
+{
+	int nIndex = find(szName);
+	return nIndex == -1 ? QByteArray() : rawValue(nIndex);
+}
+
+QString CHeaderParser::value(const char* szName) const
+{
+	QByteArray baValue = rawValue(szName);
+
+	if(baValue.contains('\n'))
+	{
+		baValue = baValue.simplified();     // folded over several lines
+	}
+
+	return QString::fromUtf8(baValue);
+}
+
+QString CHeaderParser::toString() const
+{
+	return QString::fromUtf8(m_baBlock);
+}
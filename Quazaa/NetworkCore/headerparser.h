@@ -0,0 +1,111 @@
+/*
+** headerparser.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#ifndef HEADERPARSER_H
+#define HEADERPARSER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+
+#include "types.h"
+
+class CBuffer;
+
+// Incremental parser for a block of "Name: value" lines ended by an empty line, as sent
+// in G2 handshakes, HTTP requests and responses and chat handshakes.
+//
+// Call parse() with the connection's input each time more data arrives; scanning resumes
+// where the previous call stopped, so a slow sender costs nothing per byte already seen.
+// Once the block is complete it is copied into a single buffer and the fields are indexed
+// in place. The caller removes length() bytes from its input and calls reset() before
+// the next block.
+class CHeaderParser
+{
+public:
+	enum State
+	{
+		hsIncomplete,   // no empty line yet
+		hsComplete,
+		hsTooLarge,     // block or field count over the limit
+		hsMalformed     // a line without a colon
+	};
+
+protected:
+	struct Field
+	{
+		quint16 nName;
+		quint16 nNameLength;
+		quint16 nValue;
+		quint16 nValueLength;
+	};
+
+	quint32                 m_nMaxSize;
+	quint32                 m_nMaxFields;
+
+	State                   m_nState;
+	quint32                 m_nScanned;     // bytes of input already searched for the empty line
+	quint32                 m_nLength;      // length of the block including the empty line
+
+	QByteArray              m_baBlock;      // the block as received
+	quint16                 m_nStartLine;   // length of the first line
+	QVarLengthArray<Field, 24> m_lFields;
+
+public:
+	CHeaderParser(quint32 nMaxSize = 16384, quint32 nMaxFields = 64);
+
+	void reset();
+
+	State parse(const char* pData, quint32 nLength);
+	State parse(CBuffer* pBuffer);
+
+	inline State state() const
+	{
+		return m_nState;
+	}
+	inline quint32 length() const
+	{
+		return m_nLength;
+	}
+
+	// Valid once parse() returned hsComplete.
+	QByteArray startLine() const;
+	int count() const;
+	QByteArray name(int nIndex) const;
+	QByteArray rawValue(int nIndex) const;
+
+	// First field with the given name, case insensitive.
+	bool contains(const char* szName) const;
+	QByteArray rawValue(const char* szName) const;
+	QString value(const char* szName) const;
+
+	QString toString() const;
+
+protected:
+	int find(const char* szName) const;
+	State split();
+};
+
+#endif // HEADERPARSER_H
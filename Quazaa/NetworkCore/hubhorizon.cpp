@@ -39,6 +39,7 @@ CHubHorizonPool::CHubHorizonPool()
 	m_pFree		= 0;
 	m_pActive	= 0;
 	m_nActive	= 0;
+	m_nGeneration = 1;
 }
 
 CHubHorizonPool::~CHubHorizonPool()
@@ -61,6 +62,7 @@ void CHubHorizonPool::setup()
 	m_pActive	= 0;
 	m_nActive	= 0;
 	m_pFree		= m_pBuffer;
+	m_nGeneration++;
 
 	for(quint32 nItem = 0 ; nItem < m_nBuffer ; nItem++)
 	{
@@ -74,6 +76,7 @@ void CHubHorizonPool::clear()
 	m_pActive	= 0;
 	m_nActive	= 0;
 	m_pFree		= m_pBuffer;
+	m_nGeneration++;
 
 	for(quint32 nItem = 0 ; nItem < m_nBuffer ; nItem++)
 	{
@@ -105,6 +108,7 @@ CHubHorizonHub* CHubHorizonPool::add(CEndPoint oAddress)
 	pHub->m_pNext = m_pActive;
 	m_pActive = pHub;
 	m_nActive ++;
+	m_nGeneration++;
 
 	pHub->m_oAddress	= oAddress;
 	pHub->m_nReference	= 1;
@@ -124,6 +128,7 @@ void CHubHorizonPool::remove(CHubHorizonHub* pHub)
 			pHub->m_pNext = m_pFree;
 			m_pFree = pHub;
 			m_nActive --;
+			m_nGeneration++;
 			break;
 		}
 
@@ -70,6 +70,7 @@ protected:
 	CHubHorizonHub*		m_pFree;
 	CHubHorizonHub*		m_pActive;
 	quint32				m_nActive;
+	quint32				m_nGeneration;	// bumped whenever the active list changes
 
 public:
 	void				setup();
@@ -79,6 +80,11 @@ public:
 	CHubHorizonHub*		find(CEndPoint oAddress);
 	int					addHorizonHubs(G2Packet* pPacket);
 
+	inline quint32		generation() const
+	{
+		return m_nGeneration;
+	}
+
 };
 
 extern CHubHorizonPool	HubHorizonPool;
@@ -55,19 +55,27 @@ void CNeighboursConnections::connectNode()
 
 	Q_ASSERT(m_pController == 0);
 
-	m_pController = new CRateController(&m_pSection);
-	m_pController->setDownloadLimit(quazaaSettings.Connection.InSpeed);
-	m_pController->setUploadLimit(quazaaSettings.Connection.OutSpeed);
+	BandwidthPool.setLimits(quazaaSettings.Connection.InSpeed, quazaaSettings.Connection.OutSpeed);
+
+	// G2 control traffic keeps a quarter of the link and borrows whatever transfers leave idle
+	m_pController = new CRateController(&m_pSection, rcNeighbours);
+	m_pController->setDownloadLimit(quazaaSettings.Connection.InSpeed / 4);
+	m_pController->setUploadLimit(quazaaSettings.Connection.OutSpeed / 4);
 	m_pController->moveToThread(&NetworkThread);
 
 	m_nHubsConnectedG2 = m_nLeavesConnectedG2 = 0;
 
+	// queued: the Security Manager emits while holding its own lock
+	connect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()), Qt::QueuedConnection);
+
 	CNeighboursRouting::connectNode();
 }
 void CNeighboursConnections::disconnectNode()
 {
 	QMutexLocker l(&m_pSection);
 
+	disconnect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()));
+
 	while(!m_lNodes.isEmpty())
 	{
 		CNeighbour* pCurr = m_lNodes.takeFirst();
@@ -400,6 +408,50 @@ quint32 CNeighboursConnections::uploadSpeed()
 	return m_pController ? m_pController->uploadSpeed() : 0;
 }
 
+// Checks the connected neighbours against the rules added since the last sanity check. The rules
+// are evaluated on a snapshot, so the section is only held to take it and to close the nodes.
+void CNeighboursConnections::sanityCheck()
+{
+	QSharedPointer<const CSecuritySanityCheck> pRules = securityManager.newRules();
+
+	if(pRules && pRules->hasAddressRules())
+	{
+		QList<CNeighbour*> lNodes;
+		QList<CEndPoint> lAddresses;
+
+		m_pSection.lock();
+		lNodes = m_lNodes;
+		lAddresses.reserve(lNodes.size());
+		foreach(CNeighbour* pNode, lNodes)
+		{
+			lAddresses.append(pNode->m_oAddress);
+		}
+		m_pSection.unlock();
+
+		QList<int> lDenied = pRules->denied(lAddresses);
+
+		if(!lDenied.isEmpty())
+		{
+			QMutexLocker l(&m_pSection);
+
+			foreach(int nIndex, lDenied)
+			{
+				CNeighbour* pNode = lNodes.at(nIndex);
+
+				// the node may have gone, or its memory been reused, while the rules were checked
+				if(neighbourExists(pNode) && pNode->m_oAddress == lAddresses.at(nIndex))
+				{
+					systemLog.postLog(LogSeverity::Security, Components::Network,
+									  tr("Dropping neighbour %1 - banned by a new security rule.").arg(lAddresses.at(nIndex).toString()));
+					pNode->close();
+				}
+			}
+		}
+	}
+
+	securityManager.sanityCheckPerformed();
+}
+
 CNeighbour* CNeighboursConnections::onAccept(CNetworkConnection* pConn)
 {
 	// TODO: Make new CNeighbour deriviate for handshaking with Gnutella clients
@@ -65,6 +65,8 @@ public slots:
 	CNeighbour* onAccept(CNetworkConnection* pConn);
 
 	virtual void maintain();
+
+	void sanityCheck();
 };
 
 #endif // NEIGHBOURSCONNECTIONS_H
@@ -47,7 +47,13 @@ CNeighboursG2::CNeighboursG2(QObject* parent) :
 	m_tLastModeChange(0),
 	m_nHubBalanceWait(0),
 	m_nPeriodsLow(0),
-	m_nPeriodsHigh(0)
+	m_nPeriodsHigh(0),
+	m_nHubsGeneration(1),
+	m_nQAHubsGeneration(0),
+	m_nQAHorizonGeneration(0),
+	m_nKHLHubsGeneration(0),
+	m_nKHLHostsGeneration(0),
+	m_tKHLHostsExpire(0)
 {
 }
 CNeighboursG2::~CNeighboursG2()
@@ -77,7 +83,7 @@ void CNeighboursG2::connectNode()
 	// TODO: Test whether already active checking is required
 	if ( !bStartupRequest )
 	{
-		discoveryManager.queryService( CNetworkType( dpG2 ) );
+		discoveryManager.bootstrap( CNetworkType( dpG2 ) );
 		bStartupRequest = true;
 	}
 
@@ -85,6 +91,26 @@ void CNeighboursG2::connectNode()
 
 }
 
+void CNeighboursG2::addNode(CNeighbour* pNode)
+{
+	CNeighboursConnections::addNode(pNode);
+	invalidateHubCaches();
+}
+
+void CNeighboursG2::removeNode(CNeighbour* pNode)
+{
+	CNeighboursConnections::removeNode(pNode);
+	invalidateHubCaches();
+}
+
+// Call (with m_pSection held) whenever a G2 hub connects or leaves or its leaf count changes.
+void CNeighboursG2::invalidateHubCaches()
+{
+	ASSUME_LOCK(m_pSection);
+
+	++m_nHubsGeneration;
+}
+
 void CNeighboursG2::maintain()
 {
 	ASSUME_LOCK(m_pSection);
@@ -99,11 +125,11 @@ void CNeighboursG2::maintain()
 	}
 
 	// TODO: Test whether already active checking is required
-	if ( !m_nHubsConnectedG2 && !discoveryManager.isActive( Discovery::stGWC )
+	if ( !m_nHubsConnectedG2 && !discoveryManager.isBootstrapping()
 		 && ( hostCache.isEmpty() || !hostCache.getConnectable() ) && m_nUnknownInitiated == 0 )
 	{
-		qDebug() << "GWC query: Active:" << discoveryManager.isActive(Discovery::stGWC) << ", empty cache:" << hostCache.isEmpty() << ", has connectable:" << (hostCache.getConnectable() != 0) << "has unknown initiated:" << (m_nUnknownInitiated != 0);
-		discoveryManager.queryService( CNetworkType( dpG2 ) );
+		qDebug() << "Bootstrap: Active:" << discoveryManager.isBootstrapping() << ", empty cache:" << hostCache.isEmpty() << ", has connectable:" << (hostCache.getConnectable() != 0) << "has unknown initiated:" << (m_nUnknownInitiated != 0);
+		discoveryManager.bootstrap( CNetworkType( dpG2 ) );
 	}
 
 	if(m_nNextKHL == 0)
@@ -194,34 +220,68 @@ void CNeighboursG2::dispatchKHL()
 		return;
 	}
 
-	G2Packet* pKHL = G2Packet::newPacket( "KHL" );
-
 	const quint32 tNow = common::getTNowUTC();
 
+	updateKHLCache( tNow );
+
+	G2Packet* pKHL = G2Packet::newPacket( "KHL" );
+
 	pKHL->writePacket( "TS", 4 )->writeIntLE<quint32>( tNow );
+	pKHL->write( m_baKHLHubs.data(), m_baKHLHubs.size() );
+	pKHL->write( m_baKHLHosts.data(), m_baKHLHosts.size() );
 
 	foreach ( CNeighbour * pNode, m_lNodes )
 	{
-		if ( pNode->m_nProtocol != dpG2 )
+		if ( pNode->m_nState == nsConnected && pNode->m_nProtocol == dpG2 )
 		{
-			continue;
+			((CG2Node*)pNode)->sendPacket( pKHL, false, false );
 		}
+	}
 
-		if ( pNode->m_nState == nsConnected && ((CG2Node*)pNode)->m_nType == G2_HUB )
+	pKHL->release();
+}
+
+void CNeighboursG2::updateKHLCache(quint32 tNow)
+{
+	ASSUME_LOCK( m_pSection );
+
+	if ( m_nKHLHubsGeneration != m_nHubsGeneration )
+	{
+		G2Packet* pHubs = G2Packet::newPacket( "KHL" );
+
+		foreach ( CNeighbour * pNode, m_lNodes )
 		{
-			if ( pNode->m_oAddress.protocol() == QAbstractSocket::IPv4Protocol )
+			if ( pNode->m_nProtocol == dpG2 && pNode->m_nState == nsConnected && ((CG2Node*)pNode)->m_nType == G2_HUB )
 			{
-				pKHL->writePacket( "NH", 6 )->writeHostAddress( &pNode->m_oAddress );
-			}
-			else
-			{
-				pKHL->writePacket( "NH", 18 )->writeHostAddress( &pNode->m_oAddress );
+				if ( pNode->m_oAddress.protocol() == QAbstractSocket::IPv4Protocol )
+				{
+					pHubs->writePacket( "NH", 6 )->writeHostAddress( &pNode->m_oAddress );
+				}
+				else
+				{
+					pHubs->writePacket( "NH", 18 )->writeHostAddress( &pNode->m_oAddress );
+				}
 			}
 		}
+
+		m_baKHLHubs = QByteArray( (const char*)pHubs->m_pBuffer, pHubs->m_nLength );
+		m_nKHLHubsGeneration = m_nHubsGeneration;
+		pHubs->release();
+	}
+
+	// The host cache lock is only taken when the cache changed or an entry went stale
+	if ( m_nKHLHostsGeneration == hostCache.generation() && tNow < m_tKHLHostsExpire )
+	{
+		return;
 	}
 
+	G2Packet* pHosts = G2Packet::newPacket( "KHL" );
+	quint32 tExpire = 0xFFFFFFFF;
+
 	hostCache.m_pSection.lock();
 
+	m_nKHLHostsGeneration = hostCache.generation();
+
 	quint32 nCount = quazaaSettings.Gnutella2.KHLHubCount;
 	CHostCacheIterator itHost = hostCache.m_lHosts.begin();
 
@@ -232,29 +292,24 @@ void CNeighboursG2::dispatchKHL()
 		{
 			if ( (*itHost)->m_oAddress.protocol() == QAbstractSocket::IPv4Protocol )
 			{
-				pKHL->writePacket( "CH", 10 )->writeHostAddress( &(*itHost)->m_oAddress );
-				pKHL->writeIntLE<quint32>( (*itHost)->m_tTimestamp );
+				pHosts->writePacket( "CH", 10 )->writeHostAddress( &(*itHost)->m_oAddress );
+				pHosts->writeIntLE<quint32>( (*itHost)->m_tTimestamp );
 			}
 			else
 			{
-				pKHL->writePacket( "CH", 22 )->writeHostAddress( &(*itHost)->m_oAddress );
-				pKHL->writeIntLE<quint32>( (*itHost)->m_tTimestamp );
+				pHosts->writePacket( "CH", 22 )->writeHostAddress( &(*itHost)->m_oAddress );
+				pHosts->writeIntLE<quint32>( (*itHost)->m_tTimestamp );
 			}
+			tExpire = qMin( tExpire, (*itHost)->m_tTimestamp + quazaaSettings.Gnutella2.HostCurrent );
 			--nCount;
 		}
 	}
 
 	hostCache.m_pSection.unlock();
 
-	foreach ( CNeighbour * pNode, m_lNodes )
-	{
-		if ( pNode->m_nState == nsConnected && pNode->m_nProtocol == dpG2 )
-		{
-			((CG2Node*)pNode)->sendPacket( pKHL, false, false );
-		}
-	}
-
-	pKHL->release();
+	m_baKHLHosts = QByteArray( (const char*)pHosts->m_pBuffer, pHosts->m_nLength );
+	m_tKHLHostsExpire = tExpire;
+	pHosts->release();
 }
 
 bool CNeighboursG2::switchG2ClientMode(G2NodeType nRequestedMode)
@@ -426,18 +481,32 @@ G2Packet* CNeighboursG2::createQueryAck(QUuid oGUID, bool bWithHubs, CNeighbour*
 
 		if(bWithHubs)
 		{
+			ASSUME_LOCK(m_pSection);
+
 			pPacket->writeIntLE<quint16>(m_nLeavesConnectedG2);
 
-			foreach(CNeighbour * pNode, m_lNodes)
+			updateQueryAckCache();
+
+			QHash<CNeighbour*, QPair<int, int> >::const_iterator itExcept = m_lQAHubSpans.constEnd();
+			if(pExcept)
 			{
-				if(pNode->m_nProtocol == dpG2 && pNode->m_nState == nsConnected && ((CG2Node*)pNode)->m_nType == G2_HUB && pNode != pExcept)
-				{
-					pPacket->writePacket("D", (pNode->m_oAddress.protocol() == QAbstractSocket::IPv4Protocol ? 8 : 20))->writeHostAddress(&pNode->m_oAddress);
-					pPacket->writeIntLE<quint16>(((CG2Node*)pNode)->m_nLeafCount);
-				}
+				itExcept = m_lQAHubSpans.constFind(pExcept);
+			}
+
+			if(itExcept == m_lQAHubSpans.constEnd())
+			{
+				pPacket->write(m_baQAHubs.data(), m_baQAHubs.size());
+			}
+			else
+			{
+				int nSkipFrom = itExcept.value().first;
+				int nSkipTo = nSkipFrom + itExcept.value().second;
+
+				pPacket->write(m_baQAHubs.data(), nSkipFrom);
+				pPacket->write(m_baQAHubs.data() + nSkipTo, m_baQAHubs.size() - nSkipTo);
 			}
 
-			/*int nCount = */HubHorizonPool.addHorizonHubs(pPacket);
+			pPacket->write(m_baQAHorizon.data(), m_baQAHorizon.size());
 
 			// TODO Add hubs from HostCache
 			/*if( nCount < 10 )
@@ -464,3 +533,41 @@ G2Packet* CNeighboursG2::createQueryAck(QUuid oGUID, bool bWithHubs, CNeighbour*
 	return pPacket;
 }
 
+void CNeighboursG2::updateQueryAckCache()
+{
+	ASSUME_LOCK(m_pSection);
+
+	if(m_nQAHubsGeneration != m_nHubsGeneration)
+	{
+		G2Packet* pHubs = G2Packet::newPacket("QA", true);
+
+		m_lQAHubSpans.clear();
+
+		foreach(CNeighbour * pNode, m_lNodes)
+		{
+			if(pNode->m_nProtocol == dpG2 && pNode->m_nState == nsConnected && ((CG2Node*)pNode)->m_nType == G2_HUB)
+			{
+				int nOffset = pHubs->m_nLength;
+				pHubs->writePacket("D", (pNode->m_oAddress.protocol() == QAbstractSocket::IPv4Protocol ? 8 : 20))->writeHostAddress(&pNode->m_oAddress);
+				pHubs->writeIntLE<quint16>(((CG2Node*)pNode)->m_nLeafCount);
+				m_lQAHubSpans.insert(pNode, qMakePair(nOffset, int(pHubs->m_nLength) - nOffset));
+			}
+		}
+
+		m_baQAHubs = QByteArray((const char*)pHubs->m_pBuffer, pHubs->m_nLength);
+		m_nQAHubsGeneration = m_nHubsGeneration;
+		pHubs->release();
+	}
+
+	if(m_nQAHorizonGeneration != HubHorizonPool.generation())
+	{
+		G2Packet* pHorizon = G2Packet::newPacket("QA", true);
+
+		HubHorizonPool.addHorizonHubs(pHorizon);
+
+		m_baQAHorizon = QByteArray((const char*)pHorizon->m_pBuffer, pHorizon->m_nLength);
+		m_nQAHorizonGeneration = HubHorizonPool.generation();
+		pHorizon->release();
+	}
+}
+
@@ -27,6 +27,9 @@
 #define NEIGHBOURSG2_H
 
 #include "neighboursconnections.h"
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
 
 class G2Packet;
 
@@ -43,6 +46,10 @@ public:
 
 	virtual void connectNode();
 
+	void addNode(CNeighbour* pNode);
+	void removeNode(CNeighbour* pNode);
+	void invalidateHubCaches();
+
 	G2Packet* createQueryAck(QUuid oGUID, bool bWithHubs = true, CNeighbour* pExcept = 0, bool bDone = true);
 
 	void hubBalancing();
@@ -60,6 +67,23 @@ protected:
 	quint32 m_nPeriodsLow;
 	quint32 m_nPeriodsHigh;
 
+	// Pre-encoded QA and KHL children, rebuilt only when what they describe changes
+	quint32    m_nHubsGeneration;       // bumped when connected hubs or their leaf counts change
+	quint32    m_nQAHubsGeneration;
+	QByteArray m_baQAHubs;              // D children of connected hubs
+	QHash<CNeighbour*, QPair<int, int> > m_lQAHubSpans;  // offset and length of each hub in m_baQAHubs
+	quint32    m_nQAHorizonGeneration;
+	QByteArray m_baQAHorizon;           // S children of the hub horizon
+	quint32    m_nKHLHubsGeneration;
+	QByteArray m_baKHLHubs;             // NH children
+	int        m_nKHLHostsGeneration;
+	quint32    m_tKHLHostsExpire;       // first included host cache entry goes stale
+	QByteArray m_baKHLHosts;            // CH children
+
+protected:
+	void updateQueryAckCache();
+	void updateKHLCache(quint32 tNow);
+
 
 signals:
 
@@ -39,6 +39,8 @@
 #include "sharemanager.h"
 
 #include "geoiplist.h"
+#include "hostcache.h"
+#include "securitymanager.h"
 
 #include "debug_new.h"
 
@@ -116,9 +118,15 @@ void CNetwork::setupThread()
 	Handshakes.listen();
 
 	m_bSharesReady = ShareManager.sharesAreReady();
+
+	// the host cache has no thread of its own, so it is checked from here
+	// queued: the Security Manager emits while holding its own lock
+	connect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()), Qt::QueuedConnection);
 }
 void CNetwork::cleanupThread()
 {
+	disconnect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()));
+
 	m_pSecondTimer->stop();
 	delete m_pSecondTimer;
 	m_pSecondTimer = 0;
@@ -136,6 +144,18 @@ void CNetwork::cleanupThread()
 	qDebug() << "Cleanup complete.";
 }
 
+void CNetwork::sanityCheck()
+{
+	QSharedPointer<const CSecuritySanityCheck> pRules = securityManager.newRules();
+
+	if(pRules)
+	{
+		hostCache.sanityCheck(*pRules);
+	}
+
+	securityManager.sanityCheckPerformed();
+}
+
 void CNetwork::onSecondTimer()
 {
 	if(!m_pSection.tryLock(150))
@@ -221,7 +241,10 @@ bool CNetwork::routePacket(QUuid& pTargetGUID, G2Packet* pPacket, bool bLockNeig
 			if( Neighbours.neighbourExists(pNode) )
 			{
 				pNode->sendPacket(pPacket, bBuffered, false);
-				systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket %1 Packet: %2 routed to neighbour: %3").arg(pTargetGUID.toString()).arg(pPacket->getType()).arg(pNode->m_oAddress.toString().toLocal8Bit().constData()));
+				if( systemLog.isLogged(LogSeverity::Debug, Components::None) )
+				{
+					systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket %1 Packet: %2 routed to neighbour: %3").arg(pTargetGUID.toString()).arg(pPacket->getType()).arg(pNode->m_oAddress.toString().toLocal8Bit().constData()));
+				}
 			}
 
 			if( bLockNeighbours )
@@ -233,13 +256,19 @@ bool CNetwork::routePacket(QUuid& pTargetGUID, G2Packet* pPacket, bool bLockNeig
 		else if(pAddr.isValid())
 		{
 			Datagrams.sendPacket(pAddr, pPacket, true);
-			systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket %1 Packet: %2 routed to remote node: %3").arg(pTargetGUID.toString()).arg(pPacket->getType()).arg(pAddr.toString().toLocal8Bit().constData()));
+			if( systemLog.isLogged(LogSeverity::Debug, Components::None) )
+			{
+				systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket %1 Packet: %2 routed to remote node: %3").arg(pTargetGUID.toString()).arg(pPacket->getType()).arg(pAddr.toString().toLocal8Bit().constData()));
+			}
 			return true;
 		}
 		systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket - No node and no address!"));
 	}
 
-	systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket %1 Packet: %2 DROPPED!").arg(pTargetGUID.toString()).arg(pPacket->getType()));
+	if( systemLog.isLogged(LogSeverity::Debug, Components::None) )
+	{
+		systemLog.postLog(LogSeverity::Debug, QString("CNetwork::RoutePacket %1 Packet: %2 DROPPED!").arg(pTargetGUID.toString()).arg(pPacket->getType()));
+	}
 	return false;
 }
 bool CNetwork::routePacket(G2Packet* pPacket, CG2Node* pNbr)
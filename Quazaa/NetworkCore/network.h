@@ -86,6 +86,7 @@ public slots:
 	void connectToNode(CEndPoint& addr);
 
 	void onSharesReady();
+	void sanityCheck();
 
 signals:
 	void localAddressChanged();
@@ -84,10 +84,14 @@ G2Packet* CQuery::toG2Packet(CEndPoint* pAddr, quint32 nKey)
 		pPacket->writePacket("MD", m_sMetadata.toUtf8().size())->writeString(m_sMetadata, false);
 	}
 
-	foreach(CHash pHash, m_lHashes)
+	foreach(const CHash& oHash, m_lHashes)
 	{
-		pPacket->writePacket("URN", pHash.getFamilyName().size() + CHash::byteCount(pHash.getAlgorithm()) + 1);
-		pPacket->writeString(pHash.getFamilyName() + "\0" + pHash.rawValue(), false);
+		// G2 calls a Tiger tree root "ttr"
+		const QString sFamily = (oHash.getAlgorithm() == CHash::TIGER ? QString("ttr") : oHash.getFamilyName());
+
+		pPacket->writePacket("URN", sFamily.size() + oHash.length() + 1);
+		pPacket->writeString(sFamily, true);
+		pPacket->write((void*)oHash.rawData(), oHash.length());
 	}
 
 	/*if( m_nMinimumSize > 0 && m_nMaximumSize < 0xFFFFFFFFFFFFFFFF )
@@ -299,31 +303,32 @@ bool CQuery::fromG2Packet(G2Packet *pPacket, CEndPoint *pEndpoint)
 		else if( strcmp("URN", szType) == 0 )
 		{
 			QString sURN;
-			QByteArray hashBuff;
 			sURN = pPacket->readString();
 
 			if(nLength >= 44u && sURN.compare("bp") == 0)
 			{
-				hashBuff.resize(CHash::byteCount(CHash::SHA1));
-				pPacket->read(hashBuff.data(), CHash::byteCount(CHash::SHA1));
-				CHash* pHash = CHash::fromRaw(hashBuff, CHash::SHA1);
-				if(pHash)
+				char pRaw[CHash::MaxByteCount];
+				pPacket->read(pRaw, CHash::byteCount(CHash::SHA1));
+				m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::SHA1), CHash::SHA1));
+
+				// bitprint: SHA1 followed by the Tiger tree root
+				if(nLength >= 3u + CHash::byteCount(CHash::SHA1) + CHash::byteCount(CHash::TIGER))
 				{
-					m_lHashes.append(*pHash);
-					delete pHash;
+					pPacket->read(pRaw, CHash::byteCount(CHash::TIGER));
+					m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::TIGER), CHash::TIGER));
 				}
-				// TODO: Tiger
 			}
 			else if(nLength >= CHash::byteCount(CHash::SHA1) + 5u && sURN.compare("sha1") == 0)
 			{
-				hashBuff.resize(CHash::byteCount(CHash::SHA1));
-				pPacket->read(hashBuff.data(), CHash::byteCount(CHash::SHA1));
-				CHash* pHash = CHash::fromRaw(hashBuff, CHash::SHA1);
-				if(pHash)
-				{
-					m_lHashes.append(*pHash);
-					delete pHash;
-				}
+				char pRaw[CHash::MaxByteCount];
+				pPacket->read(pRaw, CHash::byteCount(CHash::SHA1));
+				m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::SHA1), CHash::SHA1));
+			}
+			else if(nLength >= CHash::byteCount(CHash::TIGER) + 4u && sURN.compare("ttr") == 0)
+			{
+				char pRaw[CHash::MaxByteCount];
+				pPacket->read(pRaw, CHash::byteCount(CHash::TIGER));
+				m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::TIGER), CHash::TIGER));
 			}
 		}
 		else if( strcmp("SZR", szType) == 0 && nLength >= 8 )
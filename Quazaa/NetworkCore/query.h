@@ -26,10 +26,10 @@
 #define QUERY_H
 
 #include "types.h"
+#include "Hashes/hash.h"
 
 class G2Packet;
 class CQuery;
-class CHash;
 
 typedef QSharedPointer<CQuery> CQueryPtr;
 
@@ -37,7 +37,7 @@ class CQuery
 {
 public:
 	QUuid           m_oGUID;
-	QList<CHash>	m_lHashes;
+	QVector<CHash>	m_lHashes;
 	QString         m_sMetadata;
 	quint64         m_nMinimumSize;
 	quint64         m_nMaximumSize;
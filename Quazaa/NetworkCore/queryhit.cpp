@@ -208,33 +208,35 @@ CQueryHit* CQueryHit::readPacket(G2Packet* pPacket, QueryHitInfo* pHitInfo)
 					if(strcmp("URN", szTypeX) == 0)
 					{
 						QString sURN;
-						QByteArray hashBuff;
 						sURN = pPacket->readString();
 
 						if(nLengthX >= 44u && sURN.compare("bp") == 0)
 						{
-							hashBuff.resize(CHash::byteCount(CHash::SHA1));
-							pPacket->read(hashBuff.data(), CHash::byteCount(CHash::SHA1));
-							CHash* pHash = CHash::fromRaw(hashBuff, CHash::SHA1);
-							if(pHash)
+							char pRaw[CHash::MaxByteCount];
+							pPacket->read(pRaw, CHash::byteCount(CHash::SHA1));
+							pHit->m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::SHA1), CHash::SHA1));
+							bHaveURN = true;
+
+							// bitprint: SHA1 followed by the Tiger tree root
+							if(nLengthX >= 3u + CHash::byteCount(CHash::SHA1) + CHash::byteCount(CHash::TIGER))
 							{
-								pHit->m_lHashes.append(*pHash);
-								bHaveURN = true;
+								pPacket->read(pRaw, CHash::byteCount(CHash::TIGER));
+								pHit->m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::TIGER), CHash::TIGER));
 							}
-							delete pHash;
-							// TODO: Tiger
 						}
 						else if(nLengthX >= CHash::byteCount(CHash::SHA1) + 5u && sURN.compare("sha1") == 0)
 						{
-							hashBuff.resize(CHash::byteCount(CHash::SHA1));
-							pPacket->read(hashBuff.data(), CHash::byteCount(CHash::SHA1));
-							CHash* pHash = CHash::fromRaw(hashBuff, CHash::SHA1);
-							if(pHash)
-							{
-								pHit->m_lHashes.append(*pHash);
-								bHaveURN = true;
-							}
-							delete pHash;
+							char pRaw[CHash::MaxByteCount];
+							pPacket->read(pRaw, CHash::byteCount(CHash::SHA1));
+							pHit->m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::SHA1), CHash::SHA1));
+							bHaveURN = true;
+						}
+						else if(nLengthX >= CHash::byteCount(CHash::TIGER) + 4u && sURN.compare("ttr") == 0)
+						{
+							char pRaw[CHash::MaxByteCount];
+							pPacket->read(pRaw, CHash::byteCount(CHash::TIGER));
+							pHit->m_lHashes.append(CHash(pRaw, CHash::byteCount(CHash::TIGER), CHash::TIGER));
+							bHaveURN = true;
 						}
 
 					}
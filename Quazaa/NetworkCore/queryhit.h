@@ -26,10 +26,10 @@
 #define QUERYHIT_H
 
 #include "types.h"
+#include "Hashes/hash.h"
 
 class G2Packet;
 class CQuery;
-class CHash;
 
 struct QueryHitInfo
 {
@@ -54,7 +54,7 @@ public:
 
 	QSharedPointer<QueryHitInfo>   m_pHitInfo;
 
-	QList<CHash>	m_lHashes;
+	QVector<CHash>	m_lHashes;
 	QString         m_sDescriptiveName;         // File name
 	QString         m_sURL;                     // http://{IP}:{port}/uri-res/N2R?{URN}
 	QString         m_sMetadata;
@@ -34,23 +34,51 @@
 
 #include "debug_new.h"
 
-CRateController::CRateController(QMutex* pMutex, QObject* parent): QObject(parent)
+const qint64 RateBurstMsecs = 250;      // guaranteed tokens a class may bank, in ms of its rate
+const qint64 RateMinBurst   = 2048;
+const qint64 RateMaxSlice   = 65536;    // most a single pass borrows from the pool
+const qint64 RateMinWake    = 1024;     // tokens worth waking up for
+const int    RateRetryMsecs = 100;      // retry for sockets holding data they could not send yet
+const int    RateMaxWait    = 1000;
+
+static inline qint64 rateBurst(qint64 nLimit)
 {
+	return qMax(RateMinBurst, nLimit * RateBurstMsecs / 1000);
+}
+
+CRateController::CRateController(QMutex* pMutex, RateClass nClass, QObject* parent): QObject(parent)
+{
+	m_nClass = nClass;
 	m_bTransferSheduled = false;
+	m_bBorrowing = true;
 	m_nUploadLimit = std::numeric_limits<qint32>::max() / 2;
 	m_nDownloadLimit = std::numeric_limits<qint32>::max() / 2;
-	m_tStopWatch.invalidate();
+	m_nUploadTokens = m_nDownloadTokens = 0;
+	m_tRefill.invalidate();
 
 	m_pMutex = pMutex;
+
+	m_pRefillTimer = new QTimer(this);
+	m_pRefillTimer->setSingleShot(true);
+	connect(m_pRefillTimer, SIGNAL(timeout()), this, SLOT(transfer()));
+
+	BandwidthPool.registerClass(m_nClass, m_nDownloadLimit, m_nUploadLimit);
+}
+
+CRateController::~CRateController()
+{
+	BandwidthPool.unregisterClass(m_nClass);
 }
 
 void CRateController::addSocket(CNetworkConnection* pSock)
 {
 	ASSUME_LOCK(*m_pMutex);
 
-	connect(pSock, SIGNAL(readyToTransfer()), this, SLOT(sheduleTransfer()));
+	connect(pSock, SIGNAL(readyToTransfer()), this, SLOT(onReadyToTransfer()));
+	connect(pSock, SIGNAL(bytesWritten(qint64)), this, SLOT(onReadyToTransfer()));
 	pSock->setReadBufferSize(8192);
 	m_lSockets.insert(pSock);
+	m_lReady.insert(pSock);
 
 	QMetaObject::invokeMethod(this, "sheduleTransfer", Qt::QueuedConnection);
 }
@@ -60,10 +88,28 @@ void CRateController::removeSocket(CNetworkConnection* pSock)
 
 	if(m_lSockets.remove(pSock))
 	{
-		disconnect(pSock, SIGNAL(readyToTransfer()), this, SLOT(sheduleTransfer()));
+		disconnect(pSock, SIGNAL(readyToTransfer()), this, SLOT(onReadyToTransfer()));
+		disconnect(pSock, SIGNAL(bytesWritten(qint64)), this, SLOT(onReadyToTransfer()));
 		pSock->setReadBufferSize(0);
+		m_lReady.remove(pSock);
+
+		QMutexLocker l(&m_pReadySection);
+		m_lWoken.remove(pSock);
 	}
 }
+void CRateController::onReadyToTransfer()
+{
+	// May fire while the emitter holds the owner's lock, so only the leaf lock is taken here
+	CNetworkConnection* pSock = qobject_cast<CNetworkConnection*>(sender());
+
+	if(pSock)
+	{
+		QMutexLocker l(&m_pReadySection);
+		m_lWoken.insert(pSock);
+	}
+
+	sheduleTransfer();
+}
 void CRateController::sheduleTransfer()
 {
 	if(m_bTransferSheduled)
@@ -72,7 +118,7 @@ void CRateController::sheduleTransfer()
 	}
 
 	m_bTransferSheduled = true;
-	QTimer::singleShot(50, this, SLOT(transfer()));
+	QMetaObject::invokeMethod(this, "transfer", Qt::QueuedConnection);
 }
 void CRateController::transfer()
 {
@@ -80,78 +126,67 @@ void CRateController::transfer()
 
 	QMutexLocker l(m_pMutex);
 
-	qint64 nMsecs = 1000;
-	if(m_tStopWatch.isValid())
 	{
-		nMsecs = qMin(nMsecs, m_tStopWatch.elapsed());
+		QMutexLocker lReady(&m_pReadySection);
+		for(QSet<CNetworkConnection*>::const_iterator itSocket = m_lWoken.constBegin(); itSocket != m_lWoken.constEnd(); ++itSocket)
+		{
+			if(m_lSockets.contains(*itSocket))
+			{
+				m_lReady.insert(*itSocket);
+			}
+		}
+		m_lWoken.clear();
 	}
 
-	qint64 nToRead = (m_nDownloadLimit * nMsecs) / 1000;
-	qint64 nToWrite = (m_nUploadLimit * nMsecs) / 1000;
-
-	if(nToRead == 0 && nToWrite == 0)
+	if(m_lReady.isEmpty())
 	{
-		sheduleTransfer();
+		m_pRefillTimer->stop();
 		return;
 	}
 
-	QSet<CNetworkConnection*> lSockets;
-	for(QSet<CNetworkConnection*>::const_iterator itSocket = m_lSockets.constBegin(); itSocket != m_lSockets.constEnd(); ++itSocket)
-	{
-		CNetworkConnection* pSock = *itSocket;
-		if(pSock->hasData())
-		{
-			lSockets.insert(pSock);
-		}
-	}
+	refill();
 
-	if(lSockets.isEmpty())
+	qint64 nBorrowedRead = 0, nBorrowedWrite = 0;
+	if(m_bBorrowing)
 	{
-		return;
+		nBorrowedRead = BandwidthPool.borrow(rdDownload, RateMaxSlice);
+		nBorrowedWrite = BandwidthPool.borrow(rdUpload, RateMaxSlice);
 	}
 
-	m_tStopWatch.start();
+	qint64 nToRead = qMax(qint64(0), m_nDownloadTokens) + nBorrowedRead;
+	qint64 nToWrite = qMax(qint64(0), m_nUploadTokens) + nBorrowedWrite;
+	qint64 nMaxBacklog = qMax(m_nUploadLimit * 2, RateMaxSlice);
 
+	quint32 nDownloaded = 0, nUploaded = 0;
 	bool bCanTransferMore = false;
-	bool bRestart = false;
 
 	do
 	{
 		bCanTransferMore = false;
-		bRestart = false;
-		qint64 nWriteChunk = qMax(qint64(1), nToWrite / lSockets.size());
-		qint64 nReadChunk = qMax(qint64(1), nToRead / lSockets.size());
-
-		quint32 nDownloaded = 0, nUploaded = 0;
+		qint64 nWriteChunk = qMax(qint64(1), nToWrite / m_lReady.size());
+		qint64 nReadChunk = qMax(qint64(1), nToRead / m_lReady.size());
 
-		for(QSet<CNetworkConnection*>::iterator itSocket = lSockets.begin(); itSocket != lSockets.end() && (nToRead > 0 || nToWrite > 0);)
+		for(QSet<CNetworkConnection*>::iterator itSocket = m_lReady.begin(); itSocket != m_lReady.end() && (nToRead > 0 || nToWrite > 0);)
 		{
 			CNetworkConnection* pConn = *itSocket;
 
 			bool bDataTransferred = false;
 
-			if(m_nUploadLimit * 2 > pConn->bytesToWrite())
+			if(nToWrite > 0 && nMaxBacklog > pConn->bytesToWrite())
 			{
-				qint64 nChunkSize = qMin(qMin(nWriteChunk, nToWrite), m_nUploadLimit * 2 - pConn->bytesToWrite());
+				qint64 nChunkSize = qMin(qMin(nWriteChunk, nToWrite), nMaxBacklog - pConn->bytesToWrite());
 
-				if(nChunkSize > 0)
+				qint64 nBytesWritten = pConn->writeToNetwork(nChunkSize);
+				if(nBytesWritten > 0)
 				{
-					qint64 nBytesWritten = pConn->writeToNetwork(nChunkSize);
-					if(nBytesWritten > 0)
-					{
-						nToWrite -= nBytesWritten;
-						nUploaded += nBytesWritten;
-						bDataTransferred = true;
-					}
-					else if( nBytesWritten == 0 )
-					{
-						bRestart = true;
-					}
+					nToWrite -= nBytesWritten;
+					nUploaded += nBytesWritten;
+					bDataTransferred = true;
 				}
 			}
 
 			qint64 nAvailable = qMin(nReadChunk, pConn->networkBytesAvailable());
-			if(nAvailable > 0)
+			if(nToRead > 0 && nAvailable > 0)
 			{
 				qint64 nReadBytes = pConn->readFromNetwork(qMin(nAvailable, nToRead));
 				if(nReadBytes > 0)
@@ -162,27 +197,111 @@ void CRateController::transfer()
 				}
 			}
 
-			if(bDataTransferred && pConn->hasData())
-			{
-				bCanTransferMore = true;
-			}
-			else
+			if(!pConn->hasData())
 			{
-				itSocket = lSockets.erase(itSocket);
+				// Nothing left; the socket comes back with its next readiness signal
+				itSocket = m_lReady.erase(itSocket);
 				continue;
 			}
 
+			bCanTransferMore = bCanTransferMore || bDataTransferred;
 			++itSocket;
 		}
+	}
+	while(bCanTransferMore && (nToRead > 0 || nToWrite > 0) && !m_lReady.isEmpty());
+
+	m_mDownload.Add(nDownloaded);
+	m_mUpload.Add(nUploaded);
 
-		m_mDownload.Add(nDownloaded);
-		m_mUpload.Add(nUploaded);
+	charge(rdDownload, nDownloaded, nBorrowedRead);
+	charge(rdUpload, nUploaded, nBorrowedWrite);
+
+	if(m_lReady.isEmpty())
+	{
+		m_pRefillTimer->stop();
+		return;
 	}
-	while(bCanTransferMore && (nToRead > 0 || nToWrite > 0) && !lSockets.isEmpty());
 
-	if(bCanTransferMore || bRestart || nToRead == 0 || nToWrite == 0)
+	// Sockets still hold data: wait for the buckets if they ran dry, otherwise the
+	// sockets are waiting on something else (a deflate flush, the kernel) and get a retry
+	bool bReadBlocked = (nToRead <= 0);
+	bool bWriteBlocked = (nToWrite <= 0);
+
+	if(bReadBlocked || bWriteBlocked)
 	{
-		sheduleTransfer();
+		m_pRefillTimer->start(nextRefill(bReadBlocked, bWriteBlocked));
+	}
+	else
+	{
+		m_pRefillTimer->start(RateRetryMsecs);
+	}
+}
+
+void CRateController::refill()
+{
+	if(!m_tRefill.isValid())
+	{
+		m_tRefill.start();
+		m_nDownloadTokens = rateBurst(m_nDownloadLimit);
+		m_nUploadTokens = rateBurst(m_nUploadLimit);
+		return;
+	}
+
+	qint64 nNsecs = qMin(m_tRefill.nsecsElapsed(), 1000000000ll);
+	qint64 nDownload = m_nDownloadLimit * nNsecs / 1000000000ll;
+	qint64 nUpload = m_nUploadLimit * nNsecs / 1000000000ll;
+
+	if(nDownload > 0 || nUpload > 0)
+	{
+		m_tRefill.start();
+		m_nDownloadTokens = qMin(m_nDownloadTokens + nDownload, rateBurst(m_nDownloadLimit));
+		m_nUploadTokens = qMin(m_nUploadTokens + nUpload, rateBurst(m_nUploadLimit));
 	}
 }
 
+// Spends the guaranteed tokens first; the rest came from the pool and what was
+// borrowed but not used goes back to it.
+void CRateController::charge(RateDirection nDirection, qint64 nBytes, qint64 nBorrowed)
+{
+	qint64& nTokens = (nDirection == rdDownload ? m_nDownloadTokens : m_nUploadTokens);
+
+	qint64 nFromPool = qBound(qint64(0), nBytes - qMax(qint64(0), nTokens), nBorrowed);
+	qint64 nOwn = nBytes - nFromPool;
+
+	nTokens -= nOwn;
+	BandwidthPool.consume(m_nClass, nDirection, nOwn);
+
+	if(nBorrowed > 0)
+	{
+		BandwidthPool.giveBack(m_nClass, nDirection, nBorrowed, nFromPool);
+	}
+}
+
+int CRateController::nextRefill(bool bRead, bool bWrite) const
+{
+	qint64 nMsecs = RateMaxWait;
+
+	for(int i = 0; i < rdCount; ++i)
+	{
+		RateDirection nDirection = RateDirection(i);
+
+		if(!(nDirection == rdDownload ? bRead : bWrite))
+		{
+			continue;
+		}
+
+		qint64 nTokens = (nDirection == rdDownload ? m_nDownloadTokens : m_nUploadTokens);
+		qint64 nLimit = (nDirection == rdDownload ? m_nDownloadLimit : m_nUploadLimit);
+
+		if(nLimit > 0)
+		{
+			nMsecs = qMin(nMsecs, (RateMinWake - nTokens) * 1000 / nLimit);
+		}
+		if(m_bBorrowing)
+		{
+			nMsecs = qMin(nMsecs, BandwidthPool.msecsUntil(nDirection, RateMinWake));
+		}
+	}
+
+	return qBound(qint64(1), nMsecs, qint64(RateMaxWait));
+}
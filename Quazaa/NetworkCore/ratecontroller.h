@@ -32,26 +32,43 @@
 #include <QMutex>
 
 #include "networkconnection.h"
+#include "bandwidthpool.h"
 
+class QTimer;
+
+// Token bucket for one traffic class. The guaranteed rate (the "limit") is always
+// available to the class; with borrowing enabled it may also use whatever the other
+// classes leave idle in BandwidthPool. Transfers run when a socket reports readiness
+// or when the buckets have refilled enough for the sockets still waiting.
 class CRateController : public QObject
 {
 	Q_OBJECT
 protected:
+	RateClass m_nClass;
 	qint64  m_nUploadLimit;
 	qint64  m_nDownloadLimit;
+	qint64  m_nUploadTokens;
+	qint64  m_nDownloadTokens;
+	bool    m_bBorrowing;
 	bool    m_bTransferSheduled;
 	QMutex* 	m_pMutex;
+	QMutex  	m_pReadySection;
+	QTimer* 	m_pRefillTimer;
 
-	QElapsedTimer   m_tStopWatch;
+	QElapsedTimer   m_tRefill;
 
 	QSet<CNetworkConnection*>   m_lSockets;
+	QSet<CNetworkConnection*>   m_lReady;   // sockets that may have something to transfer
+	QSet<CNetworkConnection*>   m_lWoken;   // readiness reported since the last pass, guarded by m_pReadySection
 
 public:
 	TCPBandwidthMeter	m_mDownload;
 	TCPBandwidthMeter	m_mUpload;
 
 public:
-	CRateController(QMutex* pMutex, QObject* parent = 0);
+	CRateController(QMutex* pMutex, RateClass nClass, QObject* parent = 0);
+	~CRateController();
+
 	void addSocket(CNetworkConnection* pSock);
 	void removeSocket(CNetworkConnection* pSock);
 
@@ -59,11 +76,17 @@ public:
 	{
 		systemLog.postLog(LogSeverity::Debug, QString("New download limit: %1").arg(nLimit));
 		m_nDownloadLimit = nLimit;
+		BandwidthPool.registerClass(m_nClass, m_nDownloadLimit, m_nUploadLimit);
 	}
 	void setUploadLimit(qint32 nLimit)
 	{
 		systemLog.postLog(LogSeverity::Debug, QString("New upload limit: %1").arg(nLimit));
 		m_nUploadLimit = nLimit;
+		BandwidthPool.registerClass(m_nClass, m_nDownloadLimit, m_nUploadLimit);
+	}
+	void setBorrowing(bool bBorrowing)
+	{
+		m_bBorrowing = bBorrowing;
 	}
 	qint32 uploadLimit() const
 	{
@@ -83,9 +106,17 @@ public:
 		return m_mUpload.AvgUsage();
 	}
 
+protected:
+	void refill();
+	void charge(RateDirection nDirection, qint64 nBytes, qint64 nBorrowed);
+	int nextRefill(bool bRead, bool bWrite) const;
+
 public slots:
 	void sheduleTransfer();
 	void transfer();
+
+protected slots:
+	void onReadyToTransfer();
 };
 
 #endif // RATECONTROLLER_H
@@ -0,0 +1,212 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "searchresults.h"
+#include "managedsearch.h"
+#include "query.h"
+#include "thread.h"
+#include "Hashes/hash.h"
+#include "geoiplist.h"
+#include "securitymanager.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QTimerEvent>
+
+#include "debug_new.h"
+
+CThread SearchResultsThread;
+static QMutex SearchResultsSection;
+
+// Accepted results are handed to the GUI at most this often (ms).
+const int SearchResultsFrameInterval = 200;
+
+CSearchResults::CSearchResults(CManagedSearch* pSearch) :
+	QObject( NULL ),
+	m_nNextFileId( 0 )
+{
+	m_lQueryWords = pSearch->m_pQuery->descriptiveName().split( QRegExp( "\\s+" ), QString::SkipEmptyParts );
+
+	startThread();
+	moveToThread( &SearchResultsThread );
+
+	connect( pSearch, SIGNAL( onHit( QueryHitSharedPtr ) ), this, SLOT( addHits( QueryHitSharedPtr ) ) );
+}
+
+CSearchResults::~CSearchResults()
+{
+}
+
+void CSearchResults::startThread()
+{
+	QMutexLocker l( &SearchResultsSection );
+
+	if ( !SearchResultsThread.isRunning() )
+	{
+		qRegisterMetaType<SearchResultBatch>( "SearchResultBatch" );
+		SearchResultsThread.start( "SearchResults", &SearchResultsSection );
+	}
+}
+
+void CSearchResults::stopThread()
+{
+	QMutexLocker l( &SearchResultsSection );
+
+	if ( SearchResultsThread.isRunning() )
+	{
+		SearchResultsThread.exit( 0 );
+	}
+}
+
+void CSearchResults::addHits(QueryHitSharedPtr pHits)
+{
+	for ( CQueryHit* pHit = pHits.data(); pHit; pHit = pHit->m_pNext )
+	{
+		if ( isAccepted( pHit ) )
+		{
+			addHit( pHit );
+		}
+	}
+
+	if ( !m_lPending.isEmpty() && !m_oFrameTimer.isActive() )
+	{
+		m_oFrameTimer.start( SearchResultsFrameInterval, this );
+	}
+}
+
+void CSearchResults::clear()
+{
+	// File ids are not reused, so results already on their way to the GUI can't be mixed up
+	// with groups created after the clear.
+	m_lFileIds.clear();
+	m_lSources.clear();
+	m_lPending.clear();
+	m_oFrameTimer.stop();
+}
+
+void CSearchResults::timerEvent(QTimerEvent* event)
+{
+	if ( event->timerId() == m_oFrameTimer.timerId() )
+	{
+		m_oFrameTimer.stop();
+
+		if ( !m_lPending.isEmpty() )
+		{
+			resolveCountries();
+			emit resultsReady( m_lPending );
+			m_lPending.clear();
+		}
+	}
+	else
+	{
+		QObject::timerEvent( event );
+	}
+}
+
+bool CSearchResults::isAccepted(CQueryHit* pHit)
+{
+	if ( pHit->m_lHashes.isEmpty() || pHit->m_pHitInfo.isNull() || !pHit->isValid() )
+	{
+		return false;
+	}
+
+	if ( securityManager.isDenied( pHit->m_pHitInfo->m_oNodeAddress ) )
+	{
+		return false;
+	}
+
+	return !securityManager.isDenied( pHit, m_lQueryWords );
+}
+
+void CSearchResults::addHit(CQueryHit* pHit)
+{
+	const CEndPoint& oAddress = pHit->m_pHitInfo->m_oNodeAddress;
+
+	// Find the file group by any of the hit's hashes.
+	quint32 nFileId  = 0;
+	bool    bKnown   = false;
+	foreach ( const CHash& oHash, pHit->m_lHashes )
+	{
+		QHash<CHash, quint32>::const_iterator it = m_lFileIds.constFind( oHash );
+		if ( it != m_lFileIds.constEnd() )
+		{
+			nFileId = it.value();
+			bKnown  = true;
+			break;
+		}
+	}
+
+	if ( !bKnown )
+	{
+		nFileId = m_nNextFileId++;
+	}
+
+	QSet<CEndPoint>& lSources = m_lSources[nFileId];
+	if ( lSources.contains( oAddress ) )
+	{
+		return;
+	}
+	lSources.insert( oAddress );
+
+	// the hit might carry hashes we did not know about yet
+	foreach ( const CHash& oHash, pHit->m_lHashes )
+	{
+		if ( !m_lFileIds.contains( oHash ) )
+		{
+			m_lFileIds.insert( oHash, nFileId );
+		}
+	}
+
+	QFileInfo fileInfo( pHit->m_sDescriptiveName );
+
+	SearchResultEntry oEntry;
+	oEntry.nFileId      = nFileId;
+	oEntry.bNewFile     = !bKnown;
+	oEntry.pHit         = QueryHitSharedPtr( new CQueryHit( pHit ) );
+	oEntry.sName        = fileInfo.completeBaseName();
+	oEntry.sExtension   = fileInfo.suffix();
+	oEntry.sSize        = common::formatBytes( pHit->m_nObjectSize );
+	oEntry.sAddress     = oAddress.toString();
+	oEntry.sClient      = common::vendorCodeToName( pHit->m_pHitInfo->m_sVendor );
+
+	m_lPending.append( oEntry );
+}
+
+// Country codes for a whole frame are looked up in one pass over the GeoIP ranges.
+void CSearchResults::resolveCountries()
+{
+	QList<QHostAddress> lAddresses;
+	lAddresses.reserve( m_lPending.size() );
+	foreach ( const SearchResultEntry& oEntry, m_lPending )
+	{
+		lAddresses.append( oEntry.pHit->m_pHitInfo->m_oNodeAddress );
+	}
+
+	const QStringList lCodes = geoIP.findCountryCodes( lAddresses );
+	for ( int i = 0; i < m_lPending.size(); ++i )
+	{
+		m_lPending[i].sCountryCode = lCodes.at( i );
+		m_lPending[i].sCountryName = geoIP.countryNameFromCode( lCodes.at( i ) );
+	}
+}
@@ -0,0 +1,103 @@
+/*
+** searchresults.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SEARCHRESULTS_H
+#define SEARCHRESULTS_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QBasicTimer>
+#include <QMetaType>
+
+#include "types.h"
+#include "queryhit.h"
+
+class CThread;
+class CManagedSearch;
+
+// One accepted hit, already validated, filtered and prepared for display.
+struct SearchResultEntry
+{
+	quint32           nFileId;      // identifies the file group within the search
+	bool              bNewFile;     // first accepted source for this file
+	QueryHitSharedPtr pHit;         // single hit, m_pNext is always 0
+
+	QString           sName;
+	QString           sExtension;
+	QString           sSize;
+	QString           sAddress;
+	QString           sClient;
+	QString           sCountryCode;
+	QString           sCountryName;
+};
+
+typedef QList<SearchResultEntry> SearchResultBatch;
+
+Q_DECLARE_METATYPE(SearchResultBatch)
+
+/**
+ * @brief CSearchResults takes the hits of one managed search off the GUI thread. Hits are validated,
+ * checked against the security rules, deduplicated by file hash and source address and converted
+ * to display strings on SearchResultsThread; accepted results are delivered in one batch per frame.
+ */
+class CSearchResults : public QObject
+{
+	Q_OBJECT
+
+private:
+	QStringList                       m_lQueryWords;  // for regular expression rules
+	QHash<CHash, quint32>             m_lFileIds;     // hash -> file group id
+	QHash<quint32, QSet<CEndPoint> >  m_lSources;     // file group id -> source addresses
+	quint32                           m_nNextFileId;
+
+	SearchResultBatch                 m_lPending;
+	QBasicTimer                       m_oFrameTimer;
+
+public:
+	CSearchResults(CManagedSearch* pSearch);
+	~CSearchResults();
+
+	static void startThread();
+	static void stopThread();
+
+public slots:
+	void addHits(QueryHitSharedPtr pHits);
+	void clear();
+
+signals:
+	void resultsReady(SearchResultBatch lResults);
+
+protected:
+	void timerEvent(QTimerEvent* event);
+
+private:
+	bool isAccepted(CQueryHit* pHit);
+	void addHit(CQueryHit* pHit);
+	void resolveCountries();
+};
+
+extern CThread SearchResultsThread;
+
+#endif // SEARCHRESULTS_H
@@ -44,6 +44,8 @@ unix:!mac {
 		QT += dbus
 }
 
+CONFIG += c++11
+
 TARGET = Quazaa
 
 # Paths
@@ -62,40 +64,18 @@ MOC_DIR = temp/moc
 UI_DIR = temp/uic
 
 INCLUDEPATH += 3rdparty \
-		3rdparty/nvwa \
 		3rdparty/SingleApplication \
 		Chat \
-		Discovery \
-		FileFragments \
-		HostCache \
 		Misc \
 		Models \
-		NetworkCore \
-		Security \
-		ShareManager \
 		Skin \
-		Transfers \
 		UI \
 		.
 
-include(3rdparty/communi-desktop/src/src.pri)
+# Networking, security, library and transfers are built into the QuazaaCore static library
+include(core.pri)
 
-# Version stuff
-MAJOR = 0
-MINOR = 1
-VERSION_HEADER = version.h
-VERSION_HEADER_PATH = $$clean_path($$relative_path($$PWD/$$VERSION_HEADER, $$OUT_PWD))
-
-versiontarget.target = $$VERSION_HEADER_PATH
-CONFIG(debug, debug|release): versiontarget.commands = cd \"$$PWD\" && \"$$OUT_PWD/../VersionTool/debug/VersionTool\" $$MAJOR $$MINOR $$VERSION_HEADER
-CONFIG(release, debug|release): versiontarget.commands = cd \"$$PWD\" && \"$$OUT_PWD/../VersionTool/release/VersionTool\" $$MAJOR $$MINOR $$VERSION_HEADER
-win32-*{
-	versiontarget.commands = $$replace(versiontarget.commands, '/', '\\') # for nmake
-}
-versiontarget.depends = FORCE
-PRE_TARGETDEPS += $$VERSION_HEADER_PATH
-QMAKE_EXTRA_TARGETS += versiontarget
-QMAKE_CLEAN += $$VERSION_HEADER_PATH
+include(3rdparty/communi-desktop/src/src.pri)
 
 # Language stuff
 isEmpty(QMAKE_LRELEASE) {
@@ -132,7 +112,6 @@ CONFIG(debug, debug|release):TARGET = $$join(TARGET,,,_debug)
 # Additional config
 
 CONFIG(debug, debug|release){
-		DEFINES += _DEBUG
 		QT_FATAL_WARNINGS = 1
 }
 
@@ -140,16 +119,6 @@ CONFIG(debug, debug|release){
 win32 {
 		LIBS += -Lbin -luser32 -lole32 -lshell32 # if you are at windows os
 }
-mac {
-		LIBS += -lz
-}
-linux {
-		LIBS += -lz -L/usr/lib
-}
-unix {
-		LIBS += -lz -L/usr/lib
-}
-
 TEMPLATE = app
 
 # MinGW-specific compiler flags (enable exception handling and disable new/delete overload)
@@ -222,44 +191,14 @@ contains(DEFINES, _USE_DEBUG_NEW){
 		!build_pass:message( "Building with DEBUG_NEW" )
 }
 
-# Use Qt's Zlib
-INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
-
 # Headers
 HEADERS += \
-		$$[QT_INSTALL_HEADERS]/QtZlib/zlib.h \
-		3rdparty/CyoEncode/CyoDecode.h \
-		3rdparty/CyoEncode/CyoEncode.h \
-		3rdparty/nvwa/debug_new.h \
-		3rdparty/nvwa/fast_mutex.h \
-		3rdparty/nvwa/static_assert.h \
 		Chat/chatconverter.h \
 		Chat/chatcore.h \
 		Chat/chatsession.h \
 		Chat/chatsessiong2.h \
-		commonfunctions.h \
-		Discovery/banneddiscoveryservice.h \
-		Discovery/discovery.h \
-		Discovery/discoveryservice.h \
-		Discovery/gwc.h \
-		Discovery/networktype.h \
-		FileFragments/Compatibility.hpp \
-		FileFragments/Exception.hpp \
-		FileFragments/FileFragments.hpp \
-		FileFragments/List.hpp \
-		FileFragments/Queue.hpp \
-		FileFragments/Range.hpp \
-		FileFragments/Ranges.hpp \
-		geoiplist.h \
-		HostCache/hostcache.h \
-		HostCache/hostcachehost.h \
-		Metalink/magnetlink.h \
-		Metalink/metalinkhandler.h \
-		Metalink/metalink4handler.h \
 		Misc/fileiconprovider.h \
 		Misc/networkiconprovider.h \
-		Misc/timedsignalqueue.h \
-		Misc/timeoutwritelocker.h \
 		Models/categorynavigatortreemodel.h \
 		Models/discoverytablemodel.h \
 		Models/downloadstreemodel.h \
@@ -268,57 +207,7 @@ HEADERS += \
 		Models/searchtreemodel.h \
 		Models/securitytablemodel.h \
 		Models/sharesnavigatortreemodel.h \
-		NetworkCore/buffer.h \
-		NetworkCore/compressedconnection.h \
-		NetworkCore/datagramfrags.h \
-		NetworkCore/datagrams.h \
-		NetworkCore/endpoint.h \
-		NetworkCore/g2node.h \
-		NetworkCore/g2packet.h \
-		NetworkCore/handshake.h \
-		NetworkCore/handshakes.h \
-		NetworkCore/Hashes/hash.h \
-		NetworkCore/hubhorizon.h \
-		NetworkCore/managedsearch.h \
-		NetworkCore/neighbour.h \
-		NetworkCore/neighbours.h \
-		NetworkCore/neighboursbase.h \
-		NetworkCore/neighboursconnections.h \
-		NetworkCore/neighboursg2.h \
-		NetworkCore/neighboursrouting.h \
-		NetworkCore/network.h \
-		NetworkCore/networkconnection.h \
-		NetworkCore/parser.h \
-		NetworkCore/query.h \
-		NetworkCore/queryhashgroup.h \
-		NetworkCore/queryhashmaster.h \
-		NetworkCore/queryhashtable.h \
-		NetworkCore/queryhit.h \
-		NetworkCore/querykeys.h \
-		NetworkCore/ratecontroller.h \
-		NetworkCore/routetable.h \
-		NetworkCore/searchmanager.h \
-		NetworkCore/thread.h \
-		NetworkCore/types.h \
-		NetworkCore/types.h \
-		NetworkCore/zlibutils.h \
-		quazaaglobals.h \
-		quazaasettings.h \
-		quazaasysinfo.h \
-		Security/securerule.h \
-		Security/securitymanager.h \
-		ShareManager/file.h \
-		ShareManager/filehasher.h \
-		ShareManager/sharedfile.h \
-		ShareManager/sharemanager.h \
 		Skin/skinsettings.h \
-		systemlog.h \
-		Transfers/download.h \
-		Transfers/downloads.h \
-		Transfers/downloadsource.h \
-		Transfers/downloadtransfer.h \
-		Transfers/transfer.h \
-		Transfers/transfers.h \
 		UI/completerlineedit.h \
 		UI/dialogabout.h \
 		UI/dialogadddownload.h \
@@ -387,12 +276,6 @@ HEADERS += \
 		UI/dialogirccolordialog.h \
 		UI/wizardircconnection.h \
 		Models/ircuserlistmodel.h \
-		Security/iprule.h \
-		Security/iprangerule.h \
-		Security/hashrule.h \
-		Security/regexprule.h \
-		Security/useragentrule.h \
-		Security/contentrule.h \
 		Models/securityfiltermodel.h \
 		UI/dialogimportsecurity.h \
 	UI/dialogmodifyrule.h \
@@ -402,29 +285,13 @@ HEADERS += \
 
 # Sources
 SOURCES += \
-		3rdparty/CyoEncode/CyoDecode.c \
-		3rdparty/CyoEncode/CyoEncode.c \
-		3rdparty/nvwa/debug_new.cpp \
 		Chat/chatconverter.cpp \
 		Chat/chatcore.cpp \
 		Chat/chatsession.cpp \
 		Chat/chatsessiong2.cpp \
-		commonfunctions.cpp \
-		Discovery/banneddiscoveryservice.cpp \
-		Discovery/discovery.cpp \
-		Discovery/discoveryservice.cpp \
-		Discovery/gwc.cpp \
-		Discovery/networktype.cpp \
-		geoiplist.cpp \
-		HostCache/hostcache.cpp \
-		HostCache/hostcachehost.cpp \
 		main.cpp \
 		Misc/fileiconprovider.cpp \
 		Misc/networkiconprovider.cpp \
-		Misc/timedsignalqueue.cpp \
-		Metalink/magnetlink.cpp \
-		Metalink/metalinkhandler.cpp \
-		Metalink/metalink4handler.cpp \
 		Models/categorynavigatortreemodel.cpp \
 		Models/discoverytablemodel.cpp \
 		Models/downloadstreemodel.cpp \
@@ -433,56 +300,7 @@ SOURCES += \
 		Models/searchtreemodel.cpp \
 		Models/securitytablemodel.cpp \
 		Models/sharesnavigatortreemodel.cpp \
-		NetworkCore/buffer.cpp \
-		NetworkCore/compressedconnection.cpp \
-		NetworkCore/datagramfrags.cpp \
-		NetworkCore/datagrams.cpp \
-		NetworkCore/endpoint.cpp \
-		NetworkCore/g2node.cpp \
-		NetworkCore/g2packet.cpp \
-		NetworkCore/handshake.cpp \
-		NetworkCore/handshakes.cpp \
-		NetworkCore/Hashes/hash.cpp \
-		NetworkCore/hubhorizon.cpp \
-		NetworkCore/managedsearch.cpp \
-		NetworkCore/neighbour.cpp \
-		NetworkCore/neighbours.cpp \
-		NetworkCore/neighboursbase.cpp \
-		NetworkCore/neighboursconnections.cpp \
-		NetworkCore/neighboursg2.cpp \
-		NetworkCore/neighboursrouting.cpp \
-		NetworkCore/network.cpp \
-		NetworkCore/networkconnection.cpp \
-		NetworkCore/parser.cpp \
-		NetworkCore/query.cpp \
-		NetworkCore/queryhashgroup.cpp \
-		NetworkCore/queryhashmaster.cpp \
-		NetworkCore/queryhashtable.cpp \
-		NetworkCore/queryhit.cpp \
-		NetworkCore/querykeys.cpp \
-		NetworkCore/ratecontroller.cpp \
-		NetworkCore/routetable.cpp \
-		NetworkCore/searchmanager.cpp \
-		NetworkCore/thread.cpp \
-		NetworkCore/types.cpp \
-		NetworkCore/zlibutils.cpp \
-		quazaaglobals.cpp \
-		quazaasettings.cpp \
-		quazaasysinfo.cpp \
-		Security/securerule.cpp \
-		Security/securitymanager.cpp \
-		ShareManager/file.cpp \
-		ShareManager/filehasher.cpp \
-		ShareManager/sharedfile.cpp \
-		ShareManager/sharemanager.cpp \
 		Skin/skinsettings.cpp \
-		systemlog.cpp \
-		Transfers/download.cpp \
-		Transfers/downloads.cpp \
-		Transfers/downloadsource.cpp \
-		Transfers/downloadtransfer.cpp \
-		Transfers/transfer.cpp \
-		Transfers/transfers.cpp \
 		UI/completerlineedit.cpp \
 		UI/dialogabout.cpp \
 		UI/dialogadddownload.cpp \
@@ -550,12 +368,6 @@ SOURCES += \
 		UI/dialogirccolordialog.cpp \
 		UI/wizardircconnection.cpp \
 		Models/ircuserlistmodel.cpp \
-		Security/iprule.cpp \
-		Security/iprangerule.cpp \
-		Security/hashrule.cpp \
-		Security/regexprule.cpp \
-		Security/useragentrule.cpp \
-		Security/contentrule.cpp \
 		Models/securityfiltermodel.cpp \
 		UI/dialogimportsecurity.cpp \
 	UI/dialogmodifyrule.cpp \
@@ -10,9 +10,9 @@ CSecureRule* CHashRule::getCopy() const
 	return new CHashRule( *this );
 }
 
-QList< CHash > CHashRule::getHashes() const
+QVector< CHash > CHashRule::getHashes() const
 {
-	QList< CHash > result;
+	QVector< CHash > result;
 	foreach ( CHash oHash, m_Hashes )
 	{
 		result.append( oHash );
@@ -21,7 +21,7 @@ QList< CHash > CHashRule::getHashes() const
 	return result;
 }
 
-void CHashRule::setHashes(const QList< CHash >& hashes)
+void CHashRule::setHashes(const QVector< CHash >& hashes)
 {
 	Q_ASSERT( m_nType == RuleType::Hash );
 
@@ -39,7 +39,7 @@ void CHashRule::setHashes(const QList< CHash >& hashes)
 
 bool CHashRule::parseContent(const QString& sContent)
 {
-	QList<CHash> lHashes;
+	QVector<CHash> lHashes;
 
 	QStringList prefixes;
 	prefixes << "urn:sha1:" << "urn:ed2k:" << "urn:ed2khash:" << "urn:tree:tiger:" << "urn:btih:" << "urn:bitprint:" << "urn:md5:";
@@ -77,9 +77,9 @@ bool CHashRule::parseContent(const QString& sContent)
 				continue;
 			}
 
-			CHash* pHash = CHash::fromURN( sHash );
-			if(pHash)
-				lHashes.append( *CHash::fromURN( sHash ) );
+			CHash oHash = CHash::fromURN( sHash );
+			if( !oHash.isNull() )
+				lHashes.append( oHash );
 			else
 				qDebug() << "Hash type not recognised.";
 		}
@@ -123,7 +123,7 @@ bool CHashRule::match(const CQueryHit* const pHit) const
 {
 	return match( pHit->m_lHashes );
 }
-bool CHashRule::match(const QList<CHash>& lHashes) const
+bool CHashRule::match(const QVector<CHash>& lHashes) const
 {
 	QMap< CHash::Algorithm, CHash >::const_iterator i;
 	quint8 nCount = 0;
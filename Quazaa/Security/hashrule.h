@@ -11,8 +11,8 @@ private:
 public:
 	CHashRule();
 
-	QList< CHash >		getHashes() const;
-	void				setHashes(const QList< CHash >& hashes);
+	QVector< CHash >		getHashes() const;
+	void				setHashes(const QVector< CHash >& hashes);
 
 	bool				parseContent(const QString& sContent);
 
@@ -21,7 +21,7 @@ public:
 	bool				hashEquals(CHashRule *oRule) const;
 
 	bool				match(const CQueryHit* const pHit) const;
-	bool				match(const QList<CHash>& lHashes) const;
+	bool				match(const QVector<CHash>& lHashes) const;
 
 	void				toXML(QXmlStreamWriter& oXMLdocument) const;
 };
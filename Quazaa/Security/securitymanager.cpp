@@ -27,6 +27,7 @@
 #include <QDir>
 #include <QDateTime>
 #include <QMetaType>
+#include <QThread>
 
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
@@ -62,8 +63,8 @@ CSecurity::CSecurity() :
 	m_pSection(QMutex::Recursive),
 	m_bIsLoading( false ),
 	m_bLogIPCheckHits( false ),
+	m_idForceEoSC( 0 ),
 	m_bUseMissCache( false ),
-	m_bNewRulesLoaded( false ),
 	m_nPendingOperations( 0 ),
 	m_nMaxUnsavedRules( 100 ),
 	m_nUnsaved( 0 ),
@@ -86,6 +87,7 @@ CSecurity::~CSecurity()
 void CSecurity::setDenyPolicy(bool bDenyPolicy)
 {
 	m_bDenyPolicy = bDenyPolicy;
+	m_oStore.setDenyPolicy( bDenyPolicy );
 }
 
 /**
@@ -242,7 +244,7 @@ bool CSecurity::add(CSecureRule* pRule)
 	{
 		CHashRule* pHashRule = (CHashRule*)pRule;
 
-		QList<CHash> oHashes = pHashRule->getHashes();
+		QVector<CHash> oHashes = pHashRule->getHashes();
 
 		if ( oHashes.isEmpty() )
 		{
@@ -282,7 +284,7 @@ bool CSecurity::add(CSecureRule* pRule)
 		// similar but not 100% identical content, add hashes to map.
 		foreach ( CHash oHash, oHashes )
 		{
-			m_lmmHashes.insert( qHash( oHash.rawValue() ), pHashRule );
+			m_lmmHashes.insert( qHash( oHash ), pHashRule );
 		}
 
 		bNewHit	= true;
@@ -459,6 +461,8 @@ bool CSecurity::add(CSecureRule* pRule)
   */
 void CSecurity::clear()
 {
+	QMutexLocker locker(&m_pSection);
+
 	m_lIPs.clear();
 	m_lIPRanges.clear();
 	m_lmmHashes.clear();
@@ -469,11 +473,7 @@ void CSecurity::clear()
 	qDeleteAll( m_lRules );
 	m_lRules.clear();
 
-	qDeleteAll( m_lLoadedAddressRules );
-	m_lLoadedAddressRules.clear();
-
-	qDeleteAll( m_lLoadedHitRules );
-	m_lLoadedHitRules.clear();
+	m_pNewRules.clear();
 
 	CSecureRule* pRule = NULL;
 	while( m_lqNewAddressRules.size() )
@@ -489,6 +489,9 @@ void CSecurity::clear()
 	}
 	missCacheClear();
 
+	// Rules still in the store are dropped as well; the next save writes a fresh file.
+	m_oStore.close();
+
 	m_nUnsaved.fetchAndStoreRelaxed( 0 );
 }
 
@@ -702,39 +705,12 @@ void CSecurity::ban(const CEndPoint& oAddress, quint32 nRuleTime, bool bMessage,
   */
 bool CSecurity::isNewlyDenied(const CEndPoint& oAddress)
 {
-	if ( oAddress.isNull() )
-		return false;
-
-	CSecureRule* pRule = NULL;
+	QMutexLocker locker(&m_pSection);
 
 	// This should only be called if new rules have been loaded previously.
-	Q_ASSERT( m_bNewRulesLoaded );
-
-	if ( m_lLoadedAddressRules.empty() )
-		return false;
-
-	int i = 0;
-
-	while ( i < m_lLoadedAddressRules.size() )
-	{
-		pRule = m_lLoadedAddressRules.at(i);
-
-		if ( pRule->match( oAddress ) )
-		{
-			// the rules are new, so we don't need to check whether they are expired or not
-
-			hit( pRule );
-
-			if ( pRule->m_nAction == RuleAction::Accept )
-				return false;
-			else if ( pRule->m_nAction == RuleAction::Deny )
-				return true;
-		}
+	Q_ASSERT( !m_pNewRules.isNull() );
 
-		++i;
-	}
-
-	return false;
+	return m_pNewRules && m_pNewRules->isDenied( oAddress );
 }
 
 /**
@@ -746,37 +722,23 @@ bool CSecurity::isNewlyDenied(const CQueryHit* pHit, const QList<QString>& lQuer
 	if ( !pHit )
 		return false;
 
-	CSecureRule* pRule = NULL;
+	QMutexLocker locker(&m_pSection);
 
 	// This should only be called if new rules have been loaded previously.
-	Q_ASSERT( m_bNewRulesLoaded );
+	Q_ASSERT( !m_pNewRules.isNull() );
 
-	if ( m_lLoadedHitRules.empty() )
-		return false;
-
-	int i = 0;
-
-	while ( i < m_lLoadedHitRules.size() )
-	{
-		pRule = m_lLoadedHitRules.at(i);
-
-		if ( pRule->match( pHit ) || pRule->match( pHit->m_sDescriptiveName ) ||
-			 pRule->match( lQuery, pHit->m_sDescriptiveName ) )
-		{
-			// The rules are new, so we don't need to check whether they are expired or not.
-
-			hit( pRule );
-
-			if ( pRule->m_nAction == RuleAction::Accept )
-				return false;
-			else if ( pRule->m_nAction == RuleAction::Deny )
-				return true;
-		}
-
-		++i;
-	}
+	return m_pNewRules && m_pNewRules->isDenied( pHit, lQuery );
+}
 
-	return false;
+/**
+  * Returns the rules of the running sanity check. Components take their own reference, so the
+  * rules stay valid for them even if the check is aborted meanwhile.
+  * Locking: R
+  */
+QSharedPointer<const CSecuritySanityCheck> CSecurity::newRules()
+{
+	QMutexLocker locker(&m_pSection);
+	return m_pNewRules;
 }
 
 /**
@@ -949,6 +911,8 @@ bool CSecurity::isPrivate(const CEndPoint &oAddress)
 
 CIPRule *CSecurity::isInAddressRules(const CEndPoint nIp)
 {
+	loadStoredRule( nIp, CSecurityRuleStore::Addresses );
+
 	if ( m_lIPs.isEmpty() )
 	{
 		return NULL;
@@ -988,6 +952,8 @@ CIPRule *CSecurity::isInAddressRules(const CEndPoint nIp)
 
 CIPRangeRule* CSecurity::isInAddressRangeRules(const CEndPoint nIp)
 {
+	loadStoredRule( nIp, CSecurityRuleStore::Ranges );
+
 	if ( m_lIPRanges.isEmpty() )
 	{
 		return NULL;
@@ -1183,6 +1149,8 @@ bool CSecurity::isVendorBlocked(const QString& sVendor) const
 // CSecurity load and save
 /**
   * Initializes signal/slot connections, pulls settings and sets up cleanup interval counters.
+  * Call from the main thread; the rules are loaded separately by load(), which may run on a
+  * worker thread during startup.
   * Locking: RW
   */
 bool CSecurity::start()
@@ -1202,7 +1170,7 @@ bool CSecurity::start()
 	// Pull settings from global database to local copy.
 	settingsChanged();
 
-	return load(); // Load security rules from HDD.
+	return true;
 }
 
 /**
@@ -1230,6 +1198,12 @@ bool CSecurity::stop()
   */
 bool CSecurity::load()
 {
+	if ( loadStore( CQuazaaGlobals::DATA_PATH() + "security.bin" ) )
+	{
+		return true;
+	}
+
+	// Rule list written before the rule store existed. It is migrated on the next save.
 	QString sPath = CQuazaaGlobals::DATA_PATH() + "security.dat";
 
 	if ( load( sPath ) )
@@ -1295,7 +1269,10 @@ bool CSecurity::load( QString sPath )
 			pRule = NULL;
 
 			nCount--;
-			qApp->processEvents(QEventLoop::ExcludeUserInputEvents, 50);
+
+			// Keep the GUI alive unless loading in the background.
+			if ( QThread::currentThread() == qApp->thread() )
+				qApp->processEvents(QEventLoop::ExcludeUserInputEvents, 50);
 		}
 
 		if(nSuccessCount > 0) {
@@ -1328,32 +1305,134 @@ bool CSecurity::load( QString sPath )
 }
 
 /**
-  * Helper method for save()
-  * Requires Locking: R
+  * Private helper method for load(). Maps the rule store and creates objects for its loose
+  * rules; indexed rules are left in the store until a lookup hits them.
+  * Locking: RW
+  */
+bool CSecurity::loadStore(const QString& sPath)
+{
+	QMutexLocker locker(&m_pSection);
+
+	clear();
+
+	if ( !m_oStore.open( sPath ) )
+		return false;
+
+	const quint32 tNow = common::getTNowUTC();
+
+	m_bDenyPolicy = m_oStore.denyPolicy();
+	m_bIsLoading = true; // Prevent sanity check from being executed at each add() operation.
+	int nSuccessCount = 0;
+
+	foreach ( quint32 nOffset, m_oStore.looseRecords() )
+	{
+		CSecureRule* pRule = m_oStore.readRule( nOffset );
+
+		if ( !pRule || pRule->isExpired( tNow, true ) )
+		{
+			delete pRule;
+			m_oStore.discard( nOffset );
+			continue;
+		}
+
+		// add() deletes rules it does not need, so attach the record only if it kept the rule.
+		if ( add( pRule ) )
+		{
+			m_oStore.attach( pRule, nOffset );
+			++nSuccessCount;
+		}
+		else
+		{
+			m_oStore.discard( nOffset );
+		}
+	}
+
+	systemLog.postLog( LogSeverity::Debug, Components::Security,
+					   tr( "Loaded security rules from file: %1" ).arg( sPath ) );
+	systemLog.postLog( LogSeverity::Debug, Components::Security,
+					   tr( "Loaded %1 rules, %2 more are looked up in the file."
+						   ).arg( nSuccessCount ).arg( m_oStore.pendingCount() ) );
+
+	qSort(m_lIPs.begin(), m_lIPs.end(), IPLessThan);
+	qSort(m_lIPRanges.begin(), m_lIPRanges.end(), IPRangeLessThan);
+	sanityCheck();
+
+	m_bIsLoading = false;
+
+	// Everything just loaded is on disk already.
+	m_nUnsaved.fetchAndStoreRelaxed( 0 );
+
+	return true;
+}
+
+/**
+  * Creates the objects for the stored rules covering oAddress in the given table, if that has not
+  * happened yet, so the in-memory lookups see them.
+  * Requires Locking: RW
   */
-quint32 CSecurity::writeToFile(const void * const pManager, QFile& oFile)
+void CSecurity::loadStoredRule(const CEndPoint& oAddress, CSecurityRuleStore::Table eTable)
 {
-	quint16 nVersion = SECURITY_CODE_VERSION;
+	if ( !m_oStore.pendingCount() || oAddress.protocol() != QAbstractSocket::IPv4Protocol )
+		return;
 
-	QDataStream oStream( &oFile );
-	CSecurity* pSManager = (CSecurity*)pManager;
+	foreach ( CSecureRule* pRule, m_oStore.take( oAddress.toIPv4Address(), eTable ) )
+	{
+		insertStoredRule( pRule );
+	}
+}
 
-	oStream << nVersion;
-	oStream << pSManager->m_bDenyPolicy;
-	oStream << pSManager->getCount();
+/**
+  * Creates objects for all rules left in the store. Used wherever the full rule list is needed.
+  * Locking: RW
+  */
+void CSecurity::loadStoredRules()
+{
+	QMutexLocker locker(&m_pSection);
+
+	if ( !m_oStore.pendingCount() )
+		return;
 
-	for ( int i = 0; i != pSManager->m_lRules.size(); ++i )
+	foreach ( CSecureRule* pRule, m_oStore.takeAll() )
 	{
-		const CSecureRule* pRule = pSManager->m_lRules.at(i);
-		CSecureRule::save( pRule, oStream );
+		insertStoredRule( pRule );
 	}
+}
+
+/**
+  * Adds a rule created from the store. These are known not to conflict and are already saved, so
+  * this skips the checks of add() and keeps the address lists sorted.
+  * Requires Locking: RW
+  */
+void CSecurity::insertStoredRule(CSecureRule* pRule)
+{
+	if ( pRule->type() == RuleType::IPAddress )
+	{
+		CIPRule* pIPRule = (CIPRule*)pRule;
+		m_lIPs.insert( qLowerBound( m_lIPs.begin(), m_lIPs.end(), pIPRule, IPLessThan ), pIPRule );
+	}
+	else
+	{
+		Q_ASSERT( pRule->type() == RuleType::IPAddressRange );
+
+		CIPRangeRule* pRangeRule = (CIPRangeRule*)pRule;
+		m_lIPRanges.insert( qLowerBound( m_lIPRanges.begin(), m_lIPRanges.end(), pRangeRule,
+										 IPRangeLessThan ), pRangeRule );
+	}
+
+	m_lRules.append( pRule );
+
+	if ( !m_bUseMissCache )
+		evaluateCacheUsage();
 
-	return pSManager->getCount();
+	// Inform CSecurityTableModel about new rule and update the GUI.
+	emit ruleAdded( pRule );
 }
 
 /**
   * Saves the security rules to HDD. Skips saving if there haven't
   * been any important changes and bForceSaving is not set to true.
+  * Changes are written into the rule store in place; it is only rewritten as a whole if there is
+  * none yet or a quarter of it has been replaced since it was last written.
   * Locking: R
   */
 bool CSecurity::save(bool bForceSaving) const
@@ -1363,20 +1442,35 @@ bool CSecurity::save(bool bForceSaving) const
 		return true;		// Saving not required ATM.
 	}
 
-	bool bReturn;
+	// Stores smaller than this are simply rewritten.
+	const quint32 nMinGarbage = 1024;
+
+	// Rules still pending in the store are part of it, although they have no object yet.
+	const quint32 nStored = (quint32)m_lRules.size() + m_oStore.pendingCount();
 
-	if ( !common::securedSaveFile( CQuazaaGlobals::DATA_PATH(), "security.dat", "[Security] ",
-									this, &CSecurity::writeToFile ) )
+	if ( m_oStore.isOpen() && m_oStore.sync( m_lRules ) &&
+		 m_oStore.garbage() < qMax( nMinGarbage, nStored / 4 ) )
 	{
-		bReturn = false;
+		m_nUnsaved.fetchAndStoreOrdered( 0 );
+		return true;
 	}
-	else
+
+	const QString sPath = CQuazaaGlobals::DATA_PATH() + "security.bin";
+
+	systemLog.postLog( LogSeverity::Debug, Components::Security,
+					   tr( "Saving to File: %1" ).arg( sPath ) );
+
+	QDir().mkpath( CQuazaaGlobals::DATA_PATH() );
+
+	if ( !m_oStore.compile( sPath, m_lRules, m_bDenyPolicy ) )
 	{
-		m_nUnsaved.fetchAndStoreOrdered( 0 );
-		bReturn = true;
+		systemLog.postLog( LogSeverity::Error, Components::Security,
+						   tr( "Error: Could not save security rules to file: %1" ).arg( sPath ) );
+		return false;
 	}
 
-	return bReturn;
+	m_nUnsaved.fetchAndStoreOrdered( 0 );
+	return true;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -1390,8 +1484,10 @@ const QString CSecurity::xmlns = "http://www.shareaza.com/schemas/Security.xsd";
   * Exports all rules to an XML file.
   * Locking: R
   */
-bool CSecurity::toXML(const QString& sPath) const
+bool CSecurity::toXML(const QString& sPath)
 {
+	loadStoredRules();
+
 	QFile oFile( sPath );
 	if( !oFile.open( QIODevice::ReadWrite ) )
 		return false;
@@ -1591,6 +1687,8 @@ int CSecurity::receivers(const char* signal) const
   */
 void CSecurity::requestRuleList()
 {
+	loadStoredRules();
+
 	for ( int i = 0; i < m_lRules.size(); ++i )
 	{
 		emit ruleInfo( m_lRules.at(i) );
@@ -1600,54 +1698,45 @@ void CSecurity::requestRuleList()
 //////////////////////////////////////////////////////////////////////
 // Sanity checking slots
 /**
-  * Qt slot. Triggers a system wide sanity check.
-  * The sanity check is delayed by 5s, if a write lock couldn't be aquired after 500ms.
+  * Qt slot. Triggers a system wide sanity check over the rules added since the last one.
+  * The sanity check is delayed by 5s if another one is still running; rules added meanwhile are
+  * checked together then.
   * The sanity check is aborted if it takes longer than 2min to finish.
   * Locking: RW
   */
 void CSecurity::sanityCheck()
 {
-	// This indicates that an error happend previously.
-	Q_ASSERT( !m_bNewRulesLoaded || !m_lLoadedAddressRules.empty() || !m_lLoadedHitRules.empty());
+	QMutexLocker locker(&m_pSection);
 
 	// Check whether there are new rules to deal with.
-	bool bNewRules = m_lqNewAddressRules.size() || m_lqNewHitRules.size();
+	if ( m_lqNewAddressRules.isEmpty() && m_lqNewHitRules.isEmpty() )
+		return;
 
-	if ( bNewRules )
+	if ( m_pNewRules ) // other sanity check still in progress
 	{
-		if ( !m_bNewRulesLoaded )
-		{
-			loadNewRules();
+		// try again later
+		signalQueue.push( this, &CSecurity::sanityCheck, 5000, false );
+		return;
+	}
 
-			// Count how many "OK"s we need to get back.
-			m_nPendingOperations = receivers( SIGNAL( performSanityCheck() ) );
+	loadNewRules();
 
-			// if there is anyone listening, start the sanity check
-			if ( m_nPendingOperations )
-			{
-#ifdef _DEBUG
-				// Failsafe mechanism in case there are massive problems somewhere else.
-				m_idForceEoSC = signalQueue.push( this, "forceEndOfSanityCheck", 120 );
-#endif
+	// Count how many "OK"s we need to get back.
+	m_nPendingOperations = receivers( SIGNAL( performSanityCheck() ) );
 
-				// Inform all other modules about the necessity of a sanity check.
-				emit performSanityCheck();
-			}
-			else
-			{
-				clearNewRules();
-			}
-		}
-		else // other sanity check still in progress
-		{
-			// try again later
-			signalQueue.push( this, "sanityCheck", 5 );
-		}
+	// if there is anyone listening, start the sanity check
+	if ( m_nPendingOperations )
+	{
+		// Failsafe mechanism in case a component never reports back.
+		m_idForceEoSC = signalQueue.push( this, &CSecurity::forceEndOfSanityCheck, 120000, false );
+
+		// Inform all other modules about the necessity of a sanity check. They pick up the
+		// rules with newRules().
+		emit performSanityCheck();
 	}
-	else // We didn't get a write lock in a timely manner.
+	else
 	{
-		// try again later
-		signalQueue.push( this, "sanityCheck", 5 );
+		clearNewRules();
 	}
 }
 
@@ -1657,8 +1746,11 @@ void CSecurity::sanityCheck()
   */
 void CSecurity::sanityCheckPerformed()
 {
-	Q_ASSERT( m_bNewRulesLoaded );        // TODO: remove after testing
-	Q_ASSERT( m_nPendingOperations > 0 );
+	QMutexLocker locker(&m_pSection);
+
+	// The check may have been aborted in the meantime.
+	if ( !m_nPendingOperations )
+		return;
 
 	if ( --m_nPendingOperations == 0 )
 	{
@@ -1666,13 +1758,14 @@ void CSecurity::sanityCheckPerformed()
 				 Components::Security, QString( "Sanity Check finished successfully. " ) +
 				 QString( "Starting cleanup now." ) );
 
+		signalQueue.pop( m_idForceEoSC );
 		clearNewRules();
 	}
 	else
 	{
 		systemLog.postLog( LogSeverity::Security,
 				 Components::Security, QString( "A component finished with sanity checking. " ) +
-				 QString( "Still waiting for %s other components to finish."
+				 QString( "Still waiting for %1 other components to finish."
 						  ).arg( m_nPendingOperations ) );
 	}
 }
@@ -1683,7 +1776,8 @@ void CSecurity::sanityCheckPerformed()
   */
 void CSecurity::forceEndOfSanityCheck()
 {
-#ifdef _DEBUG
+	QMutexLocker locker(&m_pSection);
+
 	if ( m_nPendingOperations )
 	{
 		QString sTmp = QString( "Sanity check aborted. Most probable reason: It took some " ) +
@@ -1691,11 +1785,15 @@ void CSecurity::forceEndOfSanityCheck()
 					   QString( "after having recieved the signal performSanityCheck()." );
 		systemLog.postLog( LogSeverity::Security,
 				 Components::Security, sTmp );
+#ifdef _DEBUG
 		Q_ASSERT( false );
-	}
 #endif //_DEBUG
+	}
+
+	m_nPendingOperations = 0;
 
-	clearNewRules();
+	if ( m_pNewRules )
+		clearNewRules();
 }
 
 /**
@@ -1761,78 +1859,43 @@ void CSecurity::settingsChanged()
 
 void CSecurity::loadNewRules()
 {
-	// should both be empty
-	Q_ASSERT( !( m_lLoadedAddressRules.size() || m_lLoadedHitRules.size() ) );
+	Q_ASSERT( m_pNewRules.isNull() );
 
 	// there should be at least 1 new rule
 	Q_ASSERT( m_lqNewAddressRules.size() || m_lqNewHitRules.size() );
 
-	CSecureRule* pRule = NULL;
+	QList<CSecureRule*> lAddressRules;
+	QList<CSecureRule*> lHitRules;
 
 	while ( m_lqNewAddressRules.size() )
 	{
-		pRule = m_lqNewAddressRules.dequeue();
-
 		// Only IP, IP range and coutry rules are allowed.
-		Q_ASSERT( pRule->type() != 0 && pRule->type() < 4 );
-
-		m_lLoadedAddressRules.push_back( pRule );
+		Q_ASSERT( m_lqNewAddressRules.head()->type() != 0 && m_lqNewAddressRules.head()->type() < 4 );
 
-		pRule = NULL;
+		lAddressRules.append( m_lqNewAddressRules.dequeue() );
 	}
 
 	while ( m_lqNewHitRules.size() )
 	{
-		pRule = m_lqNewHitRules.dequeue();
-
 		// Only hit related rules are allowed.
-		Q_ASSERT( pRule->type() > 3 );
-
-		m_lLoadedHitRules.push_back( pRule );
+		Q_ASSERT( m_lqNewHitRules.head()->type() > 3 );
 
-		pRule = NULL;
+		lHitRules.append( m_lqNewHitRules.dequeue() );
 	}
 
-	m_bNewRulesLoaded = true;
+	// The rules are indexed once here, not for every address checked against them.
+	m_pNewRules = QSharedPointer<CSecuritySanityCheck>( new CSecuritySanityCheck( lAddressRules, lHitRules ) );
 }
 
 void CSecurity::clearNewRules()
 {
-	Q_ASSERT( m_bNewRulesLoaded );
-
-	// There should at least be one rule.
-	Q_ASSERT( m_lLoadedAddressRules.size() || m_lLoadedHitRules.size() );
-
-	CSecureRule* pRule = NULL;
-
-	while ( m_lLoadedAddressRules.size() )
-	{
-		pRule = m_lLoadedAddressRules.front();
-		m_lLoadedAddressRules.pop_front();
-
-		// only IP, IP range and coutry rules allowed
-		Q_ASSERT( pRule->type() > 0 && pRule->type() < 4 );
-
-		delete pRule;
-		pRule = NULL;
-	}
-
-	while ( m_lLoadedHitRules.size() )
-	{
-		pRule = m_lLoadedHitRules.front();
-		m_lLoadedHitRules.pop_front();
-
-		// Only hit related rules are allowed
-		Q_ASSERT( pRule->type() > 3 );
-
-		delete pRule;
-		pRule = NULL;
-	}
+	Q_ASSERT( !m_pNewRules.isNull() );
 
-	m_bNewRulesLoaded = false;
+	// Components still holding a reference keep the rules alive until they are done.
+	m_pNewRules.clear();
 }
 
-CHashRule* CSecurity::getHash(const QList<CHash>& hashes) const
+CHashRule* CSecurity::getHash(const QVector<CHash>& hashes) const
 {
 	// We are not searching for any hash. :)
 	if ( hashes.isEmpty() )
@@ -1842,7 +1905,7 @@ CHashRule* CSecurity::getHash(const QList<CHash>& hashes) const
 	QList<CHashRule*> lHashesCheck;
 	foreach ( CHash oHash, hashes )
 	{
-		uint iHash = qHash( oHash.rawValue() );
+		uint iHash = qHash( oHash );
 		lHashesCheck = m_lmmHashes.values( iHash );
 
 		foreach( CHashRule* pHashRuleCheck, lHashesCheck )
@@ -1901,12 +1964,12 @@ void CSecurity::remove(CSecureRule* pRule)
 		{
 			CHashRule* pHashRule = (CHashRule*)pRule;
 
-			QList<CHash> lHashes = pHashRule->getHashes();
+			QVector<CHash> lHashes = pHashRule->getHashes();
 
 			QList<CHashRule*> lHashesCheck;
 			foreach ( CHash oHash, lHashes )
 			{
-				uint iHash = qHash( oHash.rawValue() );
+				uint iHash = qHash( oHash );
 				lHashesCheck = m_lmmHashes.values( iHash );
 
 				foreach( CHashRule* pHashRuleCheck, lHashesCheck )
@@ -1977,6 +2040,9 @@ void CSecurity::remove(CSecureRule* pRule)
 
 		m_nUnsaved.fetchAndAddRelaxed( 1 );
 
+		// Tombstone its record so it is gone from disk as well.
+		m_oStore.remove( pRule );
+
 		// Remove rule entry from list of all rules
 		m_lRules.removeOne(pRule);
 
@@ -2096,7 +2162,7 @@ bool CSecurity::isDenied(const CQueryHit* const pHit)
 	if ( !pHit )
 		return false;
 
-	const QList<CHash>& lHashes = pHit->m_lHashes;
+	const QVector<CHash>& lHashes = pHit->m_lHashes;
 
 	const quint32 tNow = common::getTNowUTC();
 
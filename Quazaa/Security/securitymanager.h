@@ -27,6 +27,7 @@
 
 #include <QList>
 #include <QQueue>
+#include <QSharedPointer>
 #include <QTimer>
 
 // Increment this if there have been made changes to the way of storing security rules.
@@ -35,6 +36,8 @@
 // 0 - Initial implementation
 
 #include "securerule.h"
+#include "securityrulestore.h"
+#include "securitysanitycheck.h"
 #include "contentrule.h"
 #include "hashrule.h"
 #include "iprangerule.h"
@@ -42,6 +45,7 @@
 #include "regexprule.h"
 #include "useragentrule.h"
 #include "commonfunctions.h"
+#include "timedsignalqueue.h"
 
 // DODO: Add quint16 GUI ID to rules and update GUI only when there is a change to the rule.
 // TODO: Enable/disable this according to the visibility within the GUI
@@ -63,10 +67,9 @@ private:
 
 	QList<CSecureRule*>				m_lRules;			// contains all rules
 	// Used to manage newly added rules during sanity check
-	QList<CSecureRule*>				m_lLoadedAddressRules;
 	QQueue<CSecureRule*>			m_lqNewAddressRules;
-	QList<CSecureRule*>				m_lLoadedHitRules;
 	QQueue<CSecureRule*>			m_lqNewHitRules;
+	QSharedPointer<CSecuritySanityCheck> m_pNewRules;		// rules being checked; shared with the components checking them
 	QSet<uint>						m_lsCache;				// IP rule miss cache
 	QList<CIPRule*>					m_lIPs;					// single IP blocking rules
 	QList<CIPRangeRule*>			m_lIPRanges;			// multiple IP blocking rules
@@ -76,14 +79,12 @@ private:
 	QList<CContentRule*>			m_lContents;			// all other content rules
 	QList<CRegularExpressionRule*>	m_lRegularExpressions;	// RegExp rules
 	QMap<QString, CUserAgentRule*>	m_lmUserAgents;			// User agent rules
+	mutable CSecurityRuleStore		m_oStore;				// compiled rule file; serves permanent IPv4 rules until they are hit
 	// Security manager settings
 	bool							m_bLogIPCheckHits;		// Post log message on IsDenied( QHostAdress ) call
 	QTimer*							m_tMaintenance;			// This timer runs the maintenance tasks every second
-#ifdef _DEBUG // use failsafe to abort sanity check only in debug version
-	QUuid							m_idForceEoSC;			// The signalQueue ID (force end of sanity check)
-#endif
+	TTimerID						m_idForceEoSC;			// The signalQueue ID (force end of sanity check)
 	bool							m_bUseMissCache;
-	bool							m_bNewRulesLoaded;		// true if new rules for sanity check have been loaded.
 	unsigned short					m_nPendingOperations;	// Counts the number of program modules that still need to call back after having finished a requested sanity check operation.
 	quint16							m_nMaxUnsavedRules;		// maximal number of unsaved rules to tolerate before forcing save
 	mutable QAtomicInt				m_nUnsaved;				// count of unsaved rules
@@ -108,6 +109,8 @@ public:
 	// Methods used during sanity check
 	bool			isNewlyDenied(const CEndPoint& oAddress);
 	bool			isNewlyDenied(const CQueryHit* pHit, const QList<QString>& lQuery);
+	// Rules of the running sanity check, for checking whole snapshots. Null if there is none.
+	QSharedPointer<const CSecuritySanityCheck> newRules();
 	bool			isDenied(const CEndPoint& oAddress);
 	bool			isDenied(const CQueryHit* const pHit, const QList<QString>& lQuery);	// This does not check for the hit IP to avoid double checking.
 	bool			isPrivate(const CEndPoint &oAddress);
@@ -126,9 +129,8 @@ public:
 	bool			stop();																	// makes the Security Manager ready for destruction
 	bool			load();
 	bool			save(bool bForceSaving = false) const;
-	static quint32	writeToFile(const void* const pManager, QFile& oFile); // used by save()
 	bool			import(const QString& sPath);
-	bool			toXML(const QString& sPath) const;
+	bool			toXML(const QString& sPath);
 	bool			fromXML(const QString& sPath);
 	bool			fromP2P(const QString& sFile);
 	int				receivers(const char* signal) const;	// Allows for external callers to find out about how many listeners there are to the Security Manager Signals.
@@ -155,7 +157,11 @@ private:	// Sanity check helper methods
 	void			loadNewRules();
 	void			clearNewRules();
 	bool			load(QString sPath);
-	CHashRule		*getHash(const QList< CHash >& hashes) const;	// this returns the first rule found. Note that there might be others, too.
+	bool			loadStore(const QString& sPath);
+	void			loadStoredRule(const CEndPoint& oAddress, CSecurityRuleStore::Table eTable);
+	void			loadStoredRules();
+	void			insertStoredRule(CSecureRule* pRule);
+	CHashRule		*getHash(const QVector< CHash >& hashes) const;	// this returns the first rule found. Note that there might be others, too.
 	CSecureRule		*getUUID(const QUuid& oUUID) const;
 	bool			isAgentDenied(const QString& sUserAgent);
 	void			missCacheAdd(const uint& nIP);
@@ -168,7 +174,7 @@ private:	// Sanity check helper methods
 
 quint32 CSecurity::getCount() const
 {
-	return (quint32)m_lRules.size();
+	return (quint32)m_lRules.size() + m_oStore.pendingCount();
 }
 
 bool CSecurity::denyPolicy() const
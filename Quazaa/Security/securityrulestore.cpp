@@ -0,0 +1,718 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of the Quazaa Security Library (quazaa.sourceforge.net)
+**
+** The Quazaa Security Library is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** The Quazaa Security Library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with the Quazaa Security Library; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QDataStream>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <cstring>
+
+#include "securityrulestore.h"
+#include "securitymanager.h"
+
+#include "debug_new.h"
+
+namespace
+{
+// "QSRS", little endian like every other field of the file.
+const quint32 StoreMagic = 0x53525351;
+
+// The header is a row of quint32 fields.
+enum HeaderField
+{
+	HeaderMagic, HeaderVersion, HeaderFlags, HeaderRuleVersion,
+	HeaderRanges, HeaderAddresses,
+	HeaderLoose, HeaderIndexed, HeaderTable, HeaderJournal,
+	HeaderRemovedIndexed,	// tombstoned indexed records
+	HeaderChanges,			// tombstoned loose and appended records
+	HeaderFields
+};
+
+const quint32 HeaderSize = HeaderFields * 4;
+const quint32 FlagDenyPolicy = 0x01;
+
+// Table entry: start address, end address, record offset.
+const quint32 EntrySize = 12;
+
+// Record: state, rule type, reserved (2 bytes), payload length, start address, end address.
+// The addresses are only set for records of indexed rules.
+const quint32 RecordHeaderSize = 16;
+enum RecordState { RecordLive = 0, RecordRemoved = 1 };
+
+struct StoreEntry
+{
+	quint32				nStart;
+	quint32				nEnd;
+	quint32				nOffset;
+	const CSecureRule*	pRule;	// NULL for entries copied over without an object
+
+	bool operator<(const StoreEntry& oOther) const
+	{
+		return nStart < oOther.nStart;
+	}
+};
+
+bool ruleKey(const CSecureRule* pRule, quint32& nStart, quint32& nEnd)
+{
+	// Only rules that never expire are indexed; everything else has to be around for expire().
+	if ( pRule->getExpiryTime() != (quint32)RuleTime::Special || pRule->isExpired( 0, true ) )
+		return false;
+
+	switch ( pRule->type() )
+	{
+	case RuleType::IPAddress:
+	{
+		const CEndPoint oIP = ((const CIPRule*)pRule)->IP();
+		if ( oIP.protocol() != QAbstractSocket::IPv4Protocol )
+			return false;
+
+		nStart = nEnd = oIP.toIPv4Address();
+		return true;
+	}
+
+	case RuleType::IPAddressRange:
+	{
+		const CEndPoint oStart = ((const CIPRangeRule*)pRule)->startIP();
+		const CEndPoint oEnd   = ((const CIPRangeRule*)pRule)->endIP();
+		if ( oStart.protocol() != QAbstractSocket::IPv4Protocol ||
+			 oEnd.protocol()   != QAbstractSocket::IPv4Protocol )
+			return false;
+
+		nStart = oStart.toIPv4Address();
+		nEnd   = oEnd.toIPv4Address();
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+}
+
+CSecurityRuleStore::CSecurityRuleStore() :
+	m_pData( 0 ),
+	m_nSize( 0 ),
+	m_nRanges( 0 ),
+	m_nAddresses( 0 ),
+	m_nPending( 0 )
+{
+}
+
+CSecurityRuleStore::~CSecurityRuleStore()
+{
+	close();
+}
+
+/**
+  * Maps a compiled rule file. This validates the header only; records are checked as they
+  * are read.
+  */
+bool CSecurityRuleStore::open(const QString& sPath)
+{
+	close();
+
+	if ( !QFile::exists( sPath ) )
+		return false;
+
+	m_oFile.setFileName( sPath );
+
+	if ( !m_oFile.open( QIODevice::ReadWrite ) || !map() || m_nSize < HeaderSize ||
+		 header( HeaderMagic ) != StoreMagic || header( HeaderVersion ) != SECURITY_STORE_VERSION )
+	{
+		close();
+		return false;
+	}
+
+	m_nRanges    = header( HeaderRanges );
+	m_nAddresses = header( HeaderAddresses );
+
+	const quint64 nTableEnd = (quint64)header( HeaderTable ) + ( (quint64)m_nRanges + m_nAddresses ) * EntrySize;
+
+	if ( header( HeaderLoose ) != HeaderSize ||
+		 header( HeaderIndexed ) < header( HeaderLoose ) ||
+		 header( HeaderTable ) < header( HeaderIndexed ) ||
+		 nTableEnd != header( HeaderJournal ) || nTableEnd > m_nSize ||
+		 header( HeaderRemovedIndexed ) > m_nRanges + m_nAddresses )
+	{
+		close();
+		return false;
+	}
+
+	m_nPending = m_nRanges + m_nAddresses - header( HeaderRemovedIndexed );
+	m_baTaken.fill( false, m_nRanges + m_nAddresses );
+
+	// Ranges may overlap, so a lookup has to know how far back a covering entry can be.
+	m_vMaxEnd.resize( m_nRanges + m_nAddresses );
+	quint32 nMaxEnd = 0;
+	for ( quint32 i = 0; i < m_nRanges + m_nAddresses; ++i )
+	{
+		if ( i == m_nRanges )
+			nMaxEnd = 0;
+
+		nMaxEnd = qMax( nMaxEnd, qFromLittleEndian<quint32>( entry( i ) + 4 ) );
+		m_vMaxEnd[i] = nMaxEnd;
+	}
+
+	return true;
+}
+
+void CSecurityRuleStore::close()
+{
+	if ( m_pData )
+	{
+		m_oFile.unmap( m_pData );
+		m_pData = 0;
+	}
+
+	m_oFile.close();
+
+	m_nSize      = 0;
+	m_nRanges    = 0;
+	m_nAddresses = 0;
+	m_nPending   = 0;
+	m_baTaken.clear();
+	m_vMaxEnd.clear();
+	m_hRecords.clear();
+}
+
+bool CSecurityRuleStore::denyPolicy() const
+{
+	return m_pData && ( header( HeaderFlags ) & FlagDenyPolicy );
+}
+
+void CSecurityRuleStore::setDenyPolicy(bool bDenyPolicy)
+{
+	if ( m_pData )
+	{
+		const quint32 nFlags = header( HeaderFlags ) & ~FlagDenyPolicy;
+		setHeader( HeaderFlags, bDenyPolicy ? nFlags | FlagDenyPolicy : nFlags );
+	}
+}
+
+/**
+  * Returns the offsets of all live records that are not indexed: loose rules and the journal.
+  */
+QList<quint32> CSecurityRuleStore::looseRecords() const
+{
+	QList<quint32> lOffsets;
+
+	if ( !m_pData )
+		return lOffsets;
+
+	const quint32 pSections[2][2] = { { header( HeaderLoose ),   header( HeaderIndexed ) },
+									  { header( HeaderJournal ), m_nSize } };
+
+	for ( int i = 0; i < 2; ++i )
+	{
+		quint32 nOffset = pSections[i][0];
+
+		while ( (quint64)nOffset + RecordHeaderSize <= pSections[i][1] )
+		{
+			const quint64 nNext = (quint64)nOffset + RecordHeaderSize +
+								  qFromLittleEndian<quint32>( m_pData + nOffset + 4 );
+			if ( nNext > pSections[i][1] )
+				break;
+
+			if ( m_pData[nOffset] == RecordLive )
+				lOffsets.append( nOffset );
+
+			nOffset = (quint32)nNext;
+		}
+	}
+
+	return lOffsets;
+}
+
+/**
+  * Creates the rule object for the record at nOffset. Returns NULL for damaged records.
+  */
+CSecureRule* CSecurityRuleStore::readRule(quint32 nOffset) const
+{
+	if ( !m_pData || (quint64)nOffset + RecordHeaderSize > m_nSize )
+		return NULL;
+
+	const quint32 nLength = qFromLittleEndian<quint32>( m_pData + nOffset + 4 );
+	if ( (quint64)nOffset + RecordHeaderSize + nLength > m_nSize )
+		return NULL;
+
+	const QByteArray baPayload = QByteArray::fromRawData( (const char*)m_pData + nOffset + RecordHeaderSize, nLength );
+	QDataStream oStream( baPayload );
+	oStream.setVersion( QDataStream::Qt_5_0 );
+
+	CSecureRule* pRule = NULL;
+	CSecureRule::load( pRule, oStream, header( HeaderRuleVersion ) );
+
+	if ( pRule && oStream.status() != QDataStream::Ok )
+	{
+		delete pRule;
+		pRule = NULL;
+	}
+
+	return pRule;
+}
+
+void CSecurityRuleStore::attach(const CSecureRule* pRule, quint32 nOffset)
+{
+	m_hRecords.insert( pRule, nOffset );
+}
+
+void CSecurityRuleStore::discard(quint32 nOffset)
+{
+	tombstone( nOffset );
+}
+
+/**
+  * Looks up nIP in one of the tables and turns every pending entry covering it into a rule object.
+  * Entries whose objects have been created before are left out.
+  */
+QList<CSecureRule*> CSecurityRuleStore::take(quint32 nIP, Table eTable)
+{
+	QList<CSecureRule*> lRules;
+
+	if ( !m_nPending )
+		return lRules;
+
+	const quint32 nBegin = ( eTable == Ranges ) ? 0 : m_nRanges;
+	const quint32 nEnd   = ( eTable == Ranges ) ? m_nRanges : m_nRanges + m_nAddresses;
+
+	// Find the first entry starting after nIP.
+	quint32 nFirst = nBegin;
+	quint32 n = nEnd - nBegin;
+
+	while ( n > 0 )
+	{
+		const quint32 nHalf = n >> 1;
+		const quint32 nMiddle = nFirst + nHalf;
+
+		if ( qFromLittleEndian<quint32>( entry( nMiddle ) ) <= nIP )
+		{
+			nFirst = nMiddle + 1;
+			n -= nHalf + 1;
+		}
+		else
+		{
+			n = nHalf;
+		}
+	}
+
+	// Any entry before it may cover nIP, down to the point where none of them reaches that far.
+	while ( nFirst > nBegin && m_vMaxEnd.at( nFirst - 1 ) >= nIP )
+	{
+		const uchar* pEntry = entry( --nFirst );
+		const quint32 nOffset = qFromLittleEndian<quint32>( pEntry + 8 );
+
+		if ( m_baTaken.testBit( nFirst ) || isRemoved( nOffset ) ||
+			 qFromLittleEndian<quint32>( pEntry + 4 ) < nIP )
+			continue;
+
+		m_baTaken.setBit( nFirst );
+		--m_nPending;
+
+		if ( CSecureRule* pRule = readRule( nOffset ) )
+		{
+			attach( pRule, nOffset );
+			lRules.append( pRule );
+		}
+	}
+
+	return lRules;
+}
+
+/**
+  * Turns all pending table entries into rule objects.
+  */
+QList<CSecureRule*> CSecurityRuleStore::takeAll()
+{
+	QList<CSecureRule*> lRules;
+
+	for ( quint32 i = 0; m_nPending && i < m_nRanges + m_nAddresses; ++i )
+	{
+		const quint32 nOffset = qFromLittleEndian<quint32>( entry( i ) + 8 );
+
+		if ( m_baTaken.testBit( i ) || isRemoved( nOffset ) )
+			continue;
+
+		m_baTaken.setBit( i );
+		--m_nPending;
+
+		if ( CSecureRule* pRule = readRule( nOffset ) )
+		{
+			attach( pRule, nOffset );
+			lRules.append( pRule );
+		}
+	}
+
+	return lRules;
+}
+
+void CSecurityRuleStore::remove(const CSecureRule* pRule)
+{
+	QHash<const CSecureRule*, quint32>::iterator it = m_hRecords.find( pRule );
+
+	if ( it != m_hRecords.end() )
+	{
+		tombstone( it.value() );
+		m_hRecords.erase( it );
+	}
+}
+
+/**
+  * Brings the records of lRules up to date. Rules without a record are appended to the journal.
+  * Changed records are patched in place as long as their size and their table key stay the same,
+  * otherwise they are tombstoned and appended anew.
+  */
+bool CSecurityRuleStore::sync(const QList<CSecureRule*>& lRules)
+{
+	if ( !m_pData )
+		return false;
+
+	QList<const CSecureRule*> lAppended;
+	QList<QByteArray> lRecords;
+
+	foreach ( const CSecureRule* pRule, lRules )
+	{
+		const QByteArray baRecord = record( pRule );
+		QHash<const CSecureRule*, quint32>::iterator it = m_hRecords.find( pRule );
+
+		if ( it != m_hRecords.end() )
+		{
+			uchar* pRecord = m_pData + it.value();
+
+			// The table points at indexed records by key, so those must keep theirs.
+			const bool bIndexed = it.value() >= header( HeaderIndexed ) && it.value() < header( HeaderTable );
+
+			if ( (quint32)baRecord.size() == RecordHeaderSize + qFromLittleEndian<quint32>( pRecord + 4 ) &&
+				 ( !bIndexed || !memcmp( pRecord + 8, baRecord.constData() + 8, 8 ) ) )
+			{
+				if ( memcmp( pRecord + RecordHeaderSize, baRecord.constData() + RecordHeaderSize,
+							 baRecord.size() - RecordHeaderSize ) )
+				{
+					memcpy( pRecord + RecordHeaderSize, baRecord.constData() + RecordHeaderSize,
+							baRecord.size() - RecordHeaderSize );
+				}
+
+				continue;
+			}
+
+			tombstone( it.value() );
+			m_hRecords.erase( it );
+		}
+
+		lAppended.append( pRule );
+		lRecords.append( baRecord );
+	}
+
+	if ( lAppended.isEmpty() )
+		return true;
+
+	// Appending goes through the file; the mapping is renewed once everything is written.
+	QList<quint32> lOffsets;
+	quint32 nOffset = m_nSize;
+
+	if ( !m_oFile.seek( nOffset ) )
+		return false;
+
+	foreach ( const QByteArray& baRecord, lRecords )
+	{
+		if ( m_oFile.write( baRecord ) != baRecord.size() )
+		{
+			// Don't leave a partial record behind.
+			m_oFile.resize( m_nSize );
+			return false;
+		}
+
+		lOffsets.append( nOffset );
+		nOffset += baRecord.size();
+	}
+
+	if ( !m_oFile.flush() || !map() )
+	{
+		close();
+		return false;
+	}
+
+	for ( int i = 0; i < lAppended.size(); ++i )
+	{
+		attach( lAppended.at(i), lOffsets.at(i) );
+	}
+
+	setHeader( HeaderChanges, header( HeaderChanges ) + lAppended.size() );
+
+	return true;
+}
+
+quint32 CSecurityRuleStore::garbage() const
+{
+	return m_pData ? header( HeaderRemovedIndexed ) + header( HeaderChanges ) : 0;
+}
+
+/**
+  * Writes a fresh rule file containing lRules and all pending table entries of the currently open
+  * file, then switches over to it. Pending entries are copied as they are, without creating rule
+  * objects.
+  */
+bool CSecurityRuleStore::compile(const QString& sPath, const QList<CSecureRule*>& lRules,
+								 bool bDenyPolicy)
+{
+	const QString sTemporaryPath = sPath + "_tmp";
+
+	if ( QFile::exists( sTemporaryPath ) && !QFile::remove( sTemporaryPath ) )
+		return false;
+
+	QFile oFile( sTemporaryPath );
+	if ( !oFile.open( QIODevice::WriteOnly ) )
+		return false;
+
+	QVector< QPair<const CSecureRule*, quint32> > vLoose;
+	QVector<StoreEntry> vRanges;
+	QVector<StoreEntry> vAddresses;
+
+	quint32 nOffset = HeaderSize;
+	oFile.write( QByteArray( HeaderSize, '\0' ) );
+
+	// Loose rules first, as these are read in full on start-up.
+	foreach ( const CSecureRule* pRule, lRules )
+	{
+		quint32 nStart, nEnd;
+		if ( ruleKey( pRule, nStart, nEnd ) )
+			continue;
+
+		const QByteArray baRecord = record( pRule );
+		oFile.write( baRecord );
+
+		vLoose.append( qMakePair( pRule, nOffset ) );
+		nOffset += baRecord.size();
+	}
+
+	const quint32 nIndexed = nOffset;
+
+	foreach ( const CSecureRule* pRule, lRules )
+	{
+		StoreEntry oEntry;
+		if ( !ruleKey( pRule, oEntry.nStart, oEntry.nEnd ) )
+			continue;
+
+		const QByteArray baRecord = record( pRule );
+		oFile.write( baRecord );
+
+		oEntry.nOffset = nOffset;
+		oEntry.pRule = pRule;
+		( pRule->type() == RuleType::IPAddress ? vAddresses : vRanges ).append( oEntry );
+		nOffset += baRecord.size();
+	}
+
+	for ( quint32 i = 0; m_pData && i < m_nRanges + m_nAddresses; ++i )
+	{
+		const uchar* pEntry = entry( i );
+		const quint32 nRecord = qFromLittleEndian<quint32>( pEntry + 8 );
+
+		if ( m_baTaken.testBit( i ) || isRemoved( nRecord ) )
+			continue;
+
+		const quint32 nLength = RecordHeaderSize + qFromLittleEndian<quint32>( m_pData + nRecord + 4 );
+		if ( (quint64)nRecord + nLength > m_nSize )
+			continue;
+
+		oFile.write( (const char*)m_pData + nRecord, nLength );
+
+		StoreEntry oEntry;
+		oEntry.nStart  = qFromLittleEndian<quint32>( pEntry );
+		oEntry.nEnd    = qFromLittleEndian<quint32>( pEntry + 4 );
+		oEntry.nOffset = nOffset;
+		oEntry.pRule   = NULL;
+		( i < m_nRanges ? vRanges : vAddresses ).append( oEntry );
+		nOffset += nLength;
+	}
+
+	const quint32 nTable = nOffset;
+
+	qSort( vRanges );
+	qSort( vAddresses );
+
+	QByteArray baTable( ( vRanges.size() + vAddresses.size() ) * EntrySize, '\0' );
+	uchar* pEntry = (uchar*)baTable.data();
+
+	for ( int i = 0; i < vRanges.size() + vAddresses.size(); ++i, pEntry += EntrySize )
+	{
+		const StoreEntry& oEntry = i < vRanges.size() ? vRanges.at(i) : vAddresses.at(i - vRanges.size());
+		qToLittleEndian<quint32>( oEntry.nStart,  pEntry );
+		qToLittleEndian<quint32>( oEntry.nEnd,    pEntry + 4 );
+		qToLittleEndian<quint32>( oEntry.nOffset, pEntry + 8 );
+	}
+
+	oFile.write( baTable );
+
+	quint32 pHeader[HeaderFields] = { 0 };
+	pHeader[HeaderMagic]       = StoreMagic;
+	pHeader[HeaderVersion]     = SECURITY_STORE_VERSION;
+	pHeader[HeaderFlags]       = bDenyPolicy ? FlagDenyPolicy : 0;
+	pHeader[HeaderRuleVersion] = SECURITY_CODE_VERSION;
+	pHeader[HeaderRanges]      = vRanges.size();
+	pHeader[HeaderAddresses]   = vAddresses.size();
+	pHeader[HeaderLoose]       = HeaderSize;
+	pHeader[HeaderIndexed]     = nIndexed;
+	pHeader[HeaderTable]       = nTable;
+	pHeader[HeaderJournal]     = nTable + baTable.size();
+
+	QByteArray baHeader( HeaderSize, '\0' );
+	for ( int i = 0; i < HeaderFields; ++i )
+	{
+		qToLittleEndian<quint32>( pHeader[i], (uchar*)baHeader.data() + i * 4 );
+	}
+
+	oFile.seek( 0 );
+	oFile.write( baHeader );
+
+	const bool bWritten = ( oFile.error() == QFile::NoError );
+	oFile.close();
+
+	if ( !bWritten )
+	{
+		QFile::remove( sTemporaryPath );
+		return false;
+	}
+
+	// Switch over. The old file has to be closed first so it can be replaced on all platforms.
+	const QHash<const CSecureRule*, quint32> hRecords = m_hRecords;
+	const QBitArray baTaken = m_baTaken;
+	const quint32 nPending = m_nPending;
+	const QString sOldPath = m_oFile.fileName();
+
+	close();
+
+	if ( QFile::exists( sPath ) && !QFile::remove( sPath ) )
+	{
+		QFile::remove( sTemporaryPath );
+
+		// Carry on with the old file.
+		if ( open( sOldPath ) )
+		{
+			m_hRecords = hRecords;
+			m_baTaken = baTaken;
+			m_nPending = nPending;
+		}
+
+		return false;
+	}
+
+	if ( !open( QFile::rename( sTemporaryPath, sPath ) ? sPath : sTemporaryPath ) )
+		return false;
+
+	for ( int i = 0; i < vLoose.size(); ++i )
+	{
+		attach( vLoose.at(i).first, vLoose.at(i).second );
+	}
+
+	for ( int i = 0; i < vRanges.size() + vAddresses.size(); ++i )
+	{
+		const StoreEntry& oEntry = i < vRanges.size() ? vRanges.at(i) : vAddresses.at(i - vRanges.size());
+
+		if ( oEntry.pRule )
+		{
+			attach( oEntry.pRule, oEntry.nOffset );
+			m_baTaken.setBit( i );
+			--m_nPending;
+		}
+	}
+
+	return true;
+}
+
+/**
+  * Indexed rules are permanent IPv4 address and range rules.
+  */
+bool CSecurityRuleStore::isIndexed(const CSecureRule* pRule)
+{
+	quint32 nStart, nEnd;
+	return ruleKey( pRule, nStart, nEnd );
+}
+
+bool CSecurityRuleStore::map()
+{
+	if ( m_pData )
+	{
+		m_oFile.unmap( m_pData );
+		m_pData = 0;
+	}
+
+	m_nSize = (quint32)m_oFile.size();
+	m_pData = m_nSize ? m_oFile.map( 0, m_nSize ) : 0;
+
+	return m_pData;
+}
+
+quint32 CSecurityRuleStore::header(int nField) const
+{
+	return qFromLittleEndian<quint32>( m_pData + nField * 4 );
+}
+
+void CSecurityRuleStore::setHeader(int nField, quint32 nValue)
+{
+	qToLittleEndian<quint32>( nValue, m_pData + nField * 4 );
+}
+
+const uchar* CSecurityRuleStore::entry(quint32 nEntry) const
+{
+	return m_pData + header( HeaderTable ) + nEntry * EntrySize;
+}
+
+bool CSecurityRuleStore::isRemoved(quint32 nOffset) const
+{
+	return (quint64)nOffset + RecordHeaderSize > m_nSize || m_pData[nOffset] != RecordLive;
+}
+
+void CSecurityRuleStore::tombstone(quint32 nOffset)
+{
+	if ( !m_pData || isRemoved( nOffset ) )
+		return;
+
+	m_pData[nOffset] = RecordRemoved;
+
+	if ( nOffset >= header( HeaderIndexed ) && nOffset < header( HeaderTable ) )
+		setHeader( HeaderRemovedIndexed, header( HeaderRemovedIndexed ) + 1 );
+	else
+		setHeader( HeaderChanges, header( HeaderChanges ) + 1 );
+}
+
+QByteArray CSecurityRuleStore::record(const CSecureRule* pRule)
+{
+	QByteArray baRecord( RecordHeaderSize, '\0' );
+
+	// Pinned so records stay readable whatever Qt version wrote them.
+	QDataStream oStream( &baRecord, QIODevice::WriteOnly | QIODevice::Append );
+	oStream.setVersion( QDataStream::Qt_5_0 );
+	CSecureRule::save( pRule, oStream );
+
+	quint32 nStart = 0, nEnd = 0;
+	ruleKey( pRule, nStart, nEnd );
+
+	uchar* pHeader = (uchar*)baRecord.data();
+	pHeader[0] = RecordLive;
+	pHeader[1] = (uchar)pRule->type();
+	qToLittleEndian<quint32>( baRecord.size() - RecordHeaderSize, pHeader + 4 );
+	qToLittleEndian<quint32>( nStart, pHeader + 8 );
+	qToLittleEndian<quint32>( nEnd,   pHeader + 12 );
+
+	return baRecord;
+}
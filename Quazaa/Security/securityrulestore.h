@@ -0,0 +1,135 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of the Quazaa Security Library (quazaa.sourceforge.net)
+**
+** The Quazaa Security Library is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** The Quazaa Security Library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with the Quazaa Security Library; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SECURITYRULESTORE_H
+#define SECURITYRULESTORE_H
+
+#include <QBitArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "securerule.h"
+
+// Version of the rule store file layout. The rule records inside carry SECURITY_CODE_VERSION.
+#define SECURITY_STORE_VERSION 1
+// History:
+// 1 - Initial implementation
+
+// Compiled security rule file, mapped instead of deserialised at start-up.
+//
+// Layout: header | loose records | indexed records | lookup table | journal
+//
+// Permanent IPv4 address and range rules are "indexed": the lookup table holds their sorted
+// address ranges, so lookups run on the mapped file and a rule object is only created for a
+// table entry once a lookup hits it (or the whole list is requested). All other rules are
+// "loose" and are read when the file is opened. Rules added after the file was compiled are
+// appended to the journal, removed rules are tombstoned in place, and changed rules are
+// patched in place where their record size allows. compile() folds all of this back into a
+// fresh file.
+//
+// Locking: the caller (the Security Manager) serialises all access.
+class CSecurityRuleStore
+{
+public:
+	enum Table { Ranges = 0, Addresses = 1 };
+
+private:
+	QFile			m_oFile;
+	uchar*			m_pData;
+	quint32			m_nSize;
+
+	quint32			m_nRanges;		// range table entries
+	quint32			m_nAddresses;	// single address table entries
+	quint32			m_nPending;		// table entries neither removed nor turned into objects yet
+	QBitArray		m_baTaken;		// table entries already turned into objects
+	QVector<quint32> m_vMaxEnd;		// highest end address of each table entry and those before it
+
+	QHash<const CSecureRule*, quint32> m_hRecords;	// record offsets of rules with an object
+
+public:
+	CSecurityRuleStore();
+	~CSecurityRuleStore();
+
+	bool			open(const QString& sPath);
+	void			close();
+	inline bool		isOpen() const;
+
+	bool			denyPolicy() const;
+	void			setDenyPolicy(bool bDenyPolicy);
+
+	// Loose and journal records, read when the file is opened. Each must be handed back
+	// to either attach() or discard().
+	QList<quint32>	looseRecords() const;
+	CSecureRule*	readRule(quint32 nOffset) const;
+	void			attach(const CSecureRule* pRule, quint32 nOffset);
+	void			discard(quint32 nOffset);
+
+	// Lookup table access. take() returns the rules covering nIP in the given table that have
+	// not been turned into objects yet.
+	inline quint32	pendingCount() const;
+	QList<CSecureRule*> take(quint32 nIP, Table eTable);
+	QList<CSecureRule*> takeAll();
+
+	inline bool		contains(const CSecureRule* pRule) const;
+	void			remove(const CSecureRule* pRule);
+
+	// Writes back changes to lRules: new rules are appended, changed ones patched in place.
+	bool			sync(const QList<CSecureRule*>& lRules);
+	// Removed and appended records since the last compile().
+	quint32			garbage() const;
+	// Writes a fresh file from lRules plus all pending table entries and reopens it.
+	bool			compile(const QString& sPath, const QList<CSecureRule*>& lRules, bool bDenyPolicy);
+
+	static bool		isIndexed(const CSecureRule* pRule);
+
+private:
+	bool			map();
+	quint32			header(int nField) const;
+	void			setHeader(int nField, quint32 nValue);
+	const uchar*	entry(quint32 nEntry) const;
+	bool			isRemoved(quint32 nOffset) const;
+	void			tombstone(quint32 nOffset);
+	bool			append(const QByteArray& baRecord, quint32& nOffset);
+
+	static QByteArray record(const CSecureRule* pRule);
+};
+
+bool CSecurityRuleStore::isOpen() const
+{
+	return m_pData;
+}
+
+quint32 CSecurityRuleStore::pendingCount() const
+{
+	return m_nPending;
+}
+
+bool CSecurityRuleStore::contains(const CSecureRule* pRule) const
+{
+	return m_hRecords.contains( pRule );
+}
+
+#endif // SECURITYRULESTORE_H
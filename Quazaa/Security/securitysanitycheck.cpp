@@ -0,0 +1,284 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of the Quazaa Security Library (quazaa.sourceforge.net)
+**
+** The Quazaa Security Library is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** The Quazaa Security Library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with the Quazaa Security Library; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtAlgorithms>
+
+#include <functional>
+
+#include "securitysanitycheck.h"
+#include "iprangerule.h"
+#include "iprule.h"
+
+#include "debug_new.h"
+
+namespace
+{
+// Snapshots smaller than this are not worth handing to other threads.
+const int MinBatchSize = 256;
+
+typedef std::function<void(int nBegin, int nEnd)> BatchFunction;
+
+class CSanityCheckBatch : public QRunnable
+{
+	const BatchFunction&	m_fnBatch;
+	int						m_nBegin;
+	int						m_nEnd;
+	QSemaphore*				m_pDone;
+
+public:
+	CSanityCheckBatch(const BatchFunction& fnBatch, int nBegin, int nEnd, QSemaphore* pDone) :
+		m_fnBatch( fnBatch ),
+		m_nBegin( nBegin ),
+		m_nEnd( nEnd ),
+		m_pDone( pDone )
+	{
+	}
+
+	void run()
+	{
+		m_fnBatch( m_nBegin, m_nEnd );
+		m_pDone->release();
+	}
+};
+
+// Runs fnBatch over [0, nCount) in batches on the global thread pool. The calling thread takes the
+// first batch and returns once all of them are done.
+void runBatches(int nCount, const BatchFunction& fnBatch)
+{
+	const int nBatches = qMin( QThreadPool::globalInstance()->maxThreadCount(),
+							   ( nCount + MinBatchSize - 1 ) / MinBatchSize );
+
+	if ( nBatches <= 1 )
+	{
+		fnBatch( 0, nCount );
+		return;
+	}
+
+	const int nSize = ( nCount + nBatches - 1 ) / nBatches;
+	QSemaphore oDone;
+
+	for ( int i = 1; i < nBatches; ++i )
+	{
+		QThreadPool::globalInstance()->start( new CSanityCheckBatch( fnBatch, qMin( nCount, i * nSize ),
+																	 qMin( nCount, ( i + 1 ) * nSize ),
+																	 &oDone ) );
+	}
+
+	fnBatch( 0, nSize );
+	oDone.acquire( nBatches - 1 );
+}
+
+bool isIPv4(const CEndPoint& oAddress)
+{
+	return oAddress.protocol() == QAbstractSocket::IPv4Protocol;
+}
+}
+
+CSecuritySanityCheck::CSecuritySanityCheck(const QList<CSecureRule*>& lAddressRules,
+										   const QList<CSecureRule*>& lHitRules) :
+	m_lAddressRules( lAddressRules ),
+	m_lHitRules( lHitRules )
+{
+	for ( int i = 0; i < m_lAddressRules.size(); ++i )
+	{
+		const CSecureRule* pRule = m_lAddressRules.at(i);
+
+		// Rules without an action never decide anything.
+		if ( pRule->m_nAction == RuleAction::None )
+			continue;
+
+		if ( pRule->type() == RuleType::IPAddress && isIPv4( ((const CIPRule*)pRule)->IP() ) )
+		{
+			const quint32 nIP = ((const CIPRule*)pRule)->IP().toIPv4Address();
+
+			if ( !m_lhAddresses.contains( nIP ) )
+				m_lhAddresses.insert( nIP, i );
+		}
+		else if ( pRule->type() == RuleType::IPAddressRange &&
+				  isIPv4( ((const CIPRangeRule*)pRule)->startIP() ) &&
+				  isIPv4( ((const CIPRangeRule*)pRule)->endIP() ) )
+		{
+			Range oRange;
+			oRange.nStart = ((const CIPRangeRule*)pRule)->startIP().toIPv4Address();
+			oRange.nEnd   = ((const CIPRangeRule*)pRule)->endIP().toIPv4Address();
+			oRange.nRule  = i;
+			m_vRanges.append( oRange );
+		}
+		else if ( pRule->type() == RuleType::IPAddress || pRule->type() == RuleType::IPAddressRange )
+		{
+			m_lUnindexed.append( i );
+		}
+	}
+
+	qSort( m_vRanges );
+
+	quint32 nMaxEnd = 0;
+	for ( int i = 0; i < m_vRanges.size(); ++i )
+	{
+		nMaxEnd = qMax( nMaxEnd, m_vRanges[i].nEnd );
+		m_vRanges[i].nMaxEnd = nMaxEnd;
+	}
+}
+
+CSecuritySanityCheck::~CSecuritySanityCheck()
+{
+	qDeleteAll( m_lAddressRules );
+	qDeleteAll( m_lHitRules );
+}
+
+bool CSecuritySanityCheck::isDenied(const CEndPoint& oAddress) const
+{
+	const int nRule = addressRule( oAddress );
+
+	return nRule != -1 && m_lAddressRules.at( nRule )->m_nAction == RuleAction::Deny;
+}
+
+bool CSecuritySanityCheck::isDenied(const CQueryHit* pHit, const QList<QString>& lQuery) const
+{
+	foreach ( const CSecureRule* pRule, m_lHitRules )
+	{
+		if ( pRule->m_nAction != RuleAction::None &&
+			 ( pRule->match( pHit ) || pRule->match( pHit->m_sDescriptiveName ) ||
+			   pRule->match( lQuery, pHit->m_sDescriptiveName ) ) )
+		{
+			return pRule->m_nAction == RuleAction::Deny;
+		}
+	}
+
+	return false;
+}
+
+QList<int> CSecuritySanityCheck::denied(const QList<CEndPoint>& lAddresses) const
+{
+	QVector<char> vDenied( lAddresses.size(), 0 );
+	char* pDenied = vDenied.data();
+
+	if ( hasAddressRules() )
+	{
+		// Every batch writes its own slice of vDenied.
+		runBatches( lAddresses.size(), [&]( int nBegin, int nEnd )
+		{
+			for ( int i = nBegin; i < nEnd; ++i )
+			{
+				pDenied[i] = isDenied( lAddresses.at(i) );
+			}
+		} );
+	}
+
+	QList<int> lDenied;
+	for ( int i = 0; i < vDenied.size(); ++i )
+	{
+		if ( vDenied.at(i) )
+			lDenied.append( i );
+	}
+
+	return lDenied;
+}
+
+QList<int> CSecuritySanityCheck::denied(const QList<QueryHitSharedPtr>& lHits,
+										const QList<QString>& lQuery) const
+{
+	QVector<char> vDenied( lHits.size(), 0 );
+	char* pDenied = vDenied.data();
+
+	runBatches( lHits.size(), [&]( int nBegin, int nEnd )
+	{
+		for ( int i = nBegin; i < nEnd; ++i )
+		{
+			const CQueryHit* pHit = lHits.at(i).data();
+
+			pDenied[i] = ( hasAddressRules() && pHit->m_pHitInfo &&
+						   isDenied( pHit->m_pHitInfo->m_oNodeAddress ) ) ||
+						 ( hasHitRules() && isDenied( pHit, lQuery ) );
+		}
+	} );
+
+	QList<int> lDenied;
+	for ( int i = 0; i < vDenied.size(); ++i )
+	{
+		if ( vDenied.at(i) )
+			lDenied.append( i );
+	}
+
+	return lDenied;
+}
+
+/**
+  * Returns the index of the first rule with an action matching oAddress, or -1.
+  */
+int CSecuritySanityCheck::addressRule(const CEndPoint& oAddress) const
+{
+	if ( oAddress.isNull() )
+		return -1;
+
+	int nBest = -1;
+
+	if ( isIPv4( oAddress ) )
+	{
+		const quint32 nIP = oAddress.toIPv4Address();
+
+		QHash<quint32, int>::const_iterator itAddress = m_lhAddresses.find( nIP );
+		if ( itAddress != m_lhAddresses.end() )
+			nBest = itAddress.value();
+
+		// Walk back from the last range starting at or before nIP, for as long as an earlier
+		// range can still reach that far.
+		Range oKey;
+		oKey.nStart = nIP;
+		QVector<Range>::const_iterator itRange = qUpperBound( m_vRanges.begin(), m_vRanges.end(), oKey );
+
+		while ( itRange != m_vRanges.begin() )
+		{
+			--itRange;
+
+			if ( itRange->nMaxEnd < nIP )
+				break;
+
+			if ( itRange->nEnd >= nIP && ( nBest == -1 || itRange->nRule < nBest ) )
+				nBest = itRange->nRule;
+		}
+	}
+
+	foreach ( int nRule, m_lUnindexed )
+	{
+		if ( nBest != -1 && nBest < nRule )
+			break;
+
+		const CSecureRule* pRule = m_lAddressRules.at( nRule );
+
+		const bool bMatch = ( pRule->type() == RuleType::IPAddressRange )
+							? ((const CIPRangeRule*)pRule)->contains( oAddress )
+							: QHostAddress( oAddress ) == QHostAddress( ((const CIPRule*)pRule)->IP() );
+		if ( bMatch )
+		{
+			nBest = nRule;
+			break;
+		}
+	}
+
+	return nBest;
+}
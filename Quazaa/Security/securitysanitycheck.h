@@ -0,0 +1,92 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of the Quazaa Security Library (quazaa.sourceforge.net)
+**
+** The Quazaa Security Library is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** The Quazaa Security Library is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with the Quazaa Security Library; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef SECURITYSANITYCHECK_H
+#define SECURITYSANITYCHECK_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "securerule.h"
+
+// The rules a sanity check is about: only those added since the previous one. Components hold a
+// snapshot of their addresses and hits against it, so nothing they already passed is checked
+// again. The rules are indexed on construction and never change afterwards, so all const
+// methods may be called from any thread at the same time.
+class CSecuritySanityCheck
+{
+private:
+	struct Range
+	{
+		quint32	nStart;
+		quint32	nEnd;
+		quint32	nMaxEnd;	// highest end of this and all preceding ranges
+		int		nRule;		// index in m_lAddressRules
+
+		bool operator<(const Range& oOther) const
+		{
+			return nStart < oOther.nStart;
+		}
+	};
+
+	QList<CSecureRule*>	m_lAddressRules;	// owned, in the order they were added
+	QList<CSecureRule*>	m_lHitRules;		// owned, in the order they were added
+
+	QVector<Range>		m_vRanges;			// IPv4 ranges, sorted by start
+	QHash<quint32, int>	m_lhAddresses;		// IPv4 address -> first rule for it
+	QList<int>			m_lUnindexed;		// address rules for anything else (IPv6)
+
+public:
+	// Takes ownership of the rules.
+	CSecuritySanityCheck(const QList<CSecureRule*>& lAddressRules, const QList<CSecureRule*>& lHitRules);
+	~CSecuritySanityCheck();
+
+	inline bool		hasAddressRules() const;
+	inline bool		hasHitRules() const;
+
+	// The first matching rule decides, like within the Security Manager.
+	bool			isDenied(const CEndPoint& oAddress) const;
+	bool			isDenied(const CQueryHit* pHit, const QList<QString>& lQuery) const;
+
+	// Check whole snapshots, split into batches over the global thread pool. Return the indexes
+	// of the denied entries. Hits are denied by their source address or their content.
+	QList<int>		denied(const QList<CEndPoint>& lAddresses) const;
+	QList<int>		denied(const QList<QueryHitSharedPtr>& lHits, const QList<QString>& lQuery) const;
+
+private:
+	int				addressRule(const CEndPoint& oAddress) const;
+};
+
+bool CSecuritySanityCheck::hasAddressRules() const
+{
+	return !m_lAddressRules.isEmpty();
+}
+
+bool CSecuritySanityCheck::hasHitRules() const
+{
+	return !m_lHitRules.isEmpty();
+}
+
+#endif // SECURITYSANITYCHECK_H
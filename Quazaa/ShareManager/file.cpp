@@ -109,7 +109,7 @@ void CFile::refresh()
 
 bool CFile::removeHash(const CHash& oHash)
 {
-	for ( QList< CHash >::Iterator i = m_Hashes.begin(); i != m_Hashes.end(); i++ )
+	for ( QVector< CHash >::Iterator i = m_Hashes.begin(); i != m_Hashes.end(); i++ )
 	{
 		if ( oHash == *i )
 		{
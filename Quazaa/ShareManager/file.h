@@ -17,7 +17,7 @@ protected:
 
 	bool			m_bNull;
 
-	QList< CHash >	m_Hashes; // SHA1 (Base32), ED2K (MD4, Base16), BitTorrent Info Hash (Base32), TigerTree Root Hash (Base32), MD5 (Base16)
+	QVector< CHash >	m_Hashes; // SHA1 (Base32), ED2K (MD4, Base16), BitTorrent Info Hash (Base32), TigerTree Root Hash (Base32), MD5 (Base16)
 	QSet< QString > m_Tags;
 
 public:
@@ -44,13 +44,13 @@ public:
 	// Returns a list of all hashes attributed to this file. Note that this does not
 	// perform checking operations, so it is in theory possible to have 2 differnet
 	// hashes of the same type returned within this list.
-	inline QList< CHash > getHashes() const;
+	inline QVector< CHash > getHashes() const;
 
 	// Sets a single hash for the file.
 	inline void setHash(const CHash& oHash);
 
 	// Sets a list of hashes for the file.
-	inline void setHashes(const QList<CHash*>& lHashes);
+	inline void setHashes(const QVector<CHash>& lHashes);
 
 	// Removes a hash from the set of hashes of a file. Returns false if the requested
 	// hash could not be found; otherwise returns true.
@@ -153,7 +153,7 @@ bool CFile::isNull() const
 	return m_bNull;
 }
 
-QList< CHash > CFile::getHashes() const
+QVector< CHash > CFile::getHashes() const
 {
 	return m_Hashes;
 }
@@ -163,12 +163,9 @@ void CFile::setHash(const CHash& oHash)
 	m_Hashes.push_back( oHash );
 }
 
-void CFile::setHashes(const QList<CHash*>& lHashes)
+void CFile::setHashes(const QVector<CHash>& lHashes)
 {
-	foreach(CHash* pHash, lHashes)
-	{
-		m_Hashes.append(*pHash);
-	}
+	m_Hashes += lHashes;
 }
 
 void CFile::setTag(const QString& sTag)
@@ -24,6 +24,7 @@
 
 #include "filehasher.h"
 #include "Hashes/hash.h"
+#include "Hashes/tigertree.h"
 #include <QFile>
 #include <QByteArray>
 #include "sharemanager.h"
@@ -124,20 +125,23 @@ void CFileHasher::run()
 
 		bool bHashed = true;
 
-		QList<CHash*> lHashes;
+		QList<CHashContext*> lHashes;
+		CTigerTree oTigerTree;
 
 		if(pFile->exists() && pFile->open(QFile::ReadOnly))
 		{
 			baBuffer.resize(nBufferSize);
 
-			lHashes.append( new CHash( CHash::SHA1 ) );
-			lHashes.append( new CHash( CHash::MD5 ) );
+			lHashes.append( new CHashContext( CHash::SHA1 ) );
+			lHashes.append( new CHashContext( CHash::MD5 ) );
 
 			tTimer.start();
 //			double nLastPercent = 0;
 			quint64 nFileSize = pFile->size();
 			quint64 nTotalRead = 0, nLastTotalRead = 0;
 
+			oTigerTree.reset(nFileSize);
+
 			emit hashingProgress(m_nId, pFile->fileName(), 0, 0);
 
 			while(!pFile->atEnd())
@@ -167,8 +171,9 @@ void CFileHasher::run()
 
 				for(int i = 0; i < lHashes.size(); i++)
 				{
-					lHashes[i]->addData(baBuffer);
+					lHashes[i]->addData(baBuffer.constData(), nRead);
 				}
+				oTigerTree.addData(baBuffer.constData(), nRead);
 
 				if( tTimer.elapsed() >= 1000 )
 				{
@@ -193,14 +198,22 @@ void CFileHasher::run()
 
 		if(bHashed)
 		{
+			QVector<CHash> lResults;
+
 			for(int i = 0; i < lHashes.size(); i++)
 			{
-				lHashes[i]->finalize();
-				systemLog.postLog(LogSeverity::Debug, QString("%1").arg(lHashes[i]->toURN()));
-				//qDebug() << pFile->m_lHashes[i]->ToURN();
+				lResults.append(lHashes[i]->result());
+				systemLog.postLog(LogSeverity::Debug, QString("%1").arg(lResults.last().toURN()));
+			}
+
+			// fails if the file changed size while it was read
+			if(oTigerTree.finish())
+			{
+				lResults.append(oTigerTree.root());
+				pFile->m_oTigerTree = oTigerTree;
 			}
 
-			pFile->setHashes( lHashes );
+			pFile->setHashes( lResults );
 			emit fileHashed(pFile);
 		}
 
@@ -123,7 +123,7 @@ void CSharedFile::serialize(QSqlDatabase* pDatabase)
 		QMap<QString, QVariant> mapValues;
 		mapValues.insert( "file_id", QVariant( nFileID ) );
 
-		foreach ( CHash oHash, m_Hashes )
+		foreach ( const CHash& oHash, m_Hashes )
 		{
 			if ( pDatabase->record( "hashes" ).contains( oHash.getFamilyName() ) )
 			{
@@ -164,6 +164,20 @@ void CSharedFile::serialize(QSqlDatabase* pDatabase)
 			}
 		}
 
+		if ( m_oTigerTree.isValid() )
+		{
+			QSqlQuery qt( *pDatabase );
+			qt.prepare( "INSERT OR REPLACE INTO tigertrees (file_id, depth, tree) VALUES (?,?,?)" );
+			qt.bindValue( 0, nFileID );
+			qt.bindValue( 1, m_oTigerTree.depth() );
+			qt.bindValue( 2, m_oTigerTree.toBreadthFirst() );
+
+			if ( !qt.exec() )
+			{
+				systemLog.postLog( LogSeverity::Debug, QString( "Cannot insert Tiger tree: %1" ).arg( qt.lastError().text() ) );
+			}
+		}
+
 		QStringList lKeywords;
 		CQueryHashTable::makeKeywords( fileName(), lKeywords );
 
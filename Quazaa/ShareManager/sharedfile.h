@@ -28,6 +28,7 @@
 #include <QSharedPointer>
 
 #include "file.h"
+#include "Hashes/tigertree.h"
 
 class QSqlDatabase;
 
@@ -35,7 +36,8 @@ class CSharedFile : public CFile
 {
 
 public:
-	bool	m_bShared;
+	bool		m_bShared;
+	CTigerTree	m_oTigerTree;	// from hashing, stored with the file for THEX requests
 
 public:
 	explicit CSharedFile(QObject* parent = NULL);
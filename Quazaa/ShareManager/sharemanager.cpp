@@ -102,7 +102,8 @@ void CShareManager::setupThread()
 		// tables
 		query.exec("CREATE TABLE 'dirs' ('id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL  UNIQUE , 'path' TEXT NOT NULL, 'parent' INTEGER NOT NULL );");
 		query.exec("CREATE TABLE 'files' ('file_id' INTEGER PRIMARY KEY  AUTOINCREMENT  NOT NULL  UNIQUE , 'dir_id' INTEGER NOT NULL , 'name' VARCHAR(255) NOT NULL , 'size' INTEGER NOT NULL , 'last_modified' INTEGER NOT NULL , 'shared' BOOL NOT NULL  DEFAULT 1);");
-		query.exec("CREATE TABLE 'hashes' ('file_id' INTEGER PRIMARY KEY NOT NULL  UNIQUE , 'sha1' BLOB(20) NOT NULL, 'md5' BLOB(16) NOT NULL);");
+		query.exec("CREATE TABLE 'hashes' ('file_id' INTEGER PRIMARY KEY NOT NULL  UNIQUE , 'sha1' BLOB(20) NOT NULL, 'md5' BLOB(16) NOT NULL, 'tiger' BLOB(24));");
+		query.exec("CREATE TABLE 'tigertrees' ('file_id' INTEGER PRIMARY KEY NOT NULL  UNIQUE , 'depth' INTEGER NOT NULL, 'tree' BLOB NOT NULL);");
 		query.exec("CREATE TABLE 'hash_queue' ('dir_id' INTEGER NOT NULL, 'filename' VARCHAR(255) NOT NULL);");
 		query.exec("CREATE TABLE 'keywords' ('id' INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, 'keyword' TEXT NOT NULL);");
 
@@ -113,12 +114,26 @@ void CShareManager::setupThread()
 		query.exec("CREATE INDEX 'parent' ON 'dirs' ('parent' ASC)");
 		query.exec("CREATE UNIQUE INDEX 'keyword' ON 'keywords' ('keyword' ASC);");
 		query.exec("CREATE INDEX 'sha1' ON 'hashes' ('sha1' ASC);");
+		query.exec("CREATE INDEX 'tiger' ON 'hashes' ('tiger' ASC);");
 
 		systemLog.postLog(LogSeverity::Debug, QString("Database recreated."));
 	}
 	else
 	{
 		systemLog.postLog(LogSeverity::Debug, QString("Tables OK"));
+
+		if(!m_oDatabase.record("hashes").contains("tiger"))
+		{
+			systemLog.postLog(LogSeverity::Debug, QString("Adding Tiger trees to the database..."));
+
+			query.exec("ALTER TABLE 'hashes' ADD COLUMN 'tiger' BLOB(24);");
+			query.exec("CREATE TABLE IF NOT EXISTS 'tigertrees' ('file_id' INTEGER PRIMARY KEY NOT NULL  UNIQUE , 'depth' INTEGER NOT NULL, 'tree' BLOB NOT NULL);");
+			query.exec("CREATE INDEX 'tiger' ON 'hashes' ('tiger' ASC);");
+
+			// nothing hashed so far has a tree; forgetting the files queues them for hashing again
+			query.exec("DELETE FROM hashes;");
+			query.exec("DELETE FROM files;");
+		}
 	}
 
 	systemLog.postLog(LogSeverity::Debug, QString("Destroying hash queue."));
@@ -190,7 +205,8 @@ void CShareManager::removeDir(quint64 nId)
 		removeDir(delq.record().value(0).toUInt());
 	}
 
-	delq.exec(QString("DELETE FROM hashes WHERE file_id IN (SELECT dir_id FROM files WHERE dir_id = %1)").arg(nId));
+	delq.exec(QString("DELETE FROM hashes WHERE file_id IN (SELECT file_id FROM files WHERE dir_id = %1)").arg(nId));
+	delq.exec(QString("DELETE FROM tigertrees WHERE file_id IN (SELECT file_id FROM files WHERE dir_id = %1)").arg(nId));
 	delq.exec(QString("DELETE FROM files WHERE dir_id = %1").arg(nId));
 	delq.exec(QString("DELETE FROM dirs WHERE id = %1").arg(nId));
 }
@@ -205,6 +221,7 @@ void CShareManager::removeFile(quint64 nFileId)
 {
 	QSqlQuery delq(m_oDatabase);
 	delq.exec(QString("DELETE FROM hashes WHERE file_id = %1").arg(nFileId));
+	delq.exec(QString("DELETE FROM tigertrees WHERE file_id = %1").arg(nFileId));
 	delq.exec(QString("DELETE FROM files WHERE file_id = %1").arg(nFileId));
 }
 
@@ -576,6 +593,12 @@ QList<QSqlRecord> CShareManager::query(const QString sQuery)
 {
 	QMutexLocker l(&m_oSection);
 
+	// nobody would answer
+	if(!m_bActive)
+	{
+		return QList<QSqlRecord>();
+	}
+
 	m_lQueryResults.clear();
 	emit executeQuery(sQuery);
 	m_oQueryCond.wait(&m_oSection);
@@ -717,12 +740,10 @@ void CShareManager::buildHashTable()
 		{
 			while(q.next())
 			{
-				QByteArray m_oHash = q.record().value(0).toByteArray();
-				CHash* pHash = CHash::fromRaw(m_oHash, CHash::SHA1);
-				if(pHash)
+				CHash oHash = CHash::fromRaw(q.record().value(0).toByteArray(), CHash::SHA1);
+				if(!oHash.isNull())
 				{
-					m_pTable->addExactString(pHash->toURN());
-					delete pHash;
+					m_pTable->addExactString(oHash.toURN());
 				}
 			}
 		}
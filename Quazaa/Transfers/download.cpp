@@ -28,6 +28,8 @@
 #include "downloads.h"
 #include "transfers.h"
 #include "downloadtransfer.h"
+#include "downloadstorage.h"
+#include "downloadverifier.h"
 
 #include "commonfunctions.h"
 #include "quazaasettings.h"
@@ -49,6 +51,10 @@ QDataStream& operator<<(QDataStream& s, const CDownload& rhs)
 	s << "state" << rhs.m_nState;
 	s << "mf" << rhs.m_bMultifile;
 	s << "pr" << rhs.m_nPriority;
+	foreach(CHash h, rhs.m_lHashes)
+	{
+		s << "hash" << h.toURN();
+	}
 
 	// files
 	foreach(CDownload::FileListItem i, rhs.m_lFiles)
@@ -75,7 +81,10 @@ QDataStream& operator<<(QDataStream& s, const CDownload& rhs)
 	s << "completed-frags";
 	Fragments::SerializeOut(s, rhs.m_lCompleted);
 	s << "verified-frags";
-	Fragments::SerializeOut(s, rhs.m_lCompleted);
+	Fragments::SerializeOut(s, rhs.m_lVerified);
+
+	if( rhs.m_oTigerTree.isValid() )
+		s << "tiger-tree" << rhs.m_oTigerTree.toBreadthFirst();
 
 	s << "eof";
 	return s;
@@ -83,6 +92,7 @@ QDataStream& operator<<(QDataStream& s, const CDownload& rhs)
 QDataStream& operator>>(QDataStream& s, CDownload& rhs)
 {
 	quint32 nVer;
+	CTigerTree oTree;
 
 	s >> nVer;
 
@@ -108,10 +118,12 @@ QDataStream& operator>>(QDataStream& s, CDownload& rhs)
 				s >> nSize;
 				rhs.m_nSize = nSize;
 
-				Fragments::List oAct(nSize), oCp(nSize), oVer(nSize);
+				Fragments::List oAct(nSize), oCp(nSize), oRcv(nSize), oVer(nSize), oUna(nSize);
 				rhs.m_lActive.swap(oAct);
 				rhs.m_lCompleted.swap(oCp);
+				rhs.m_lReceived.swap(oRcv);
 				rhs.m_lVerified.swap(oVer);
+				rhs.m_lUnassigned.swap(oUna);
 			}
 			else if( sTag == "cs" )
 			{
@@ -131,6 +143,14 @@ QDataStream& operator>>(QDataStream& s, CDownload& rhs)
 			{
 				s >> rhs.m_nPriority;
 			}
+			else if( sTag == "hash" )
+			{
+				QString sHash;
+				s >> sHash;
+				CHash oHash = CHash::fromURN(sHash);
+				if( !oHash.isNull() && !rhs.m_lHashes.contains(oHash) )
+					rhs.m_lHashes.append(oHash);
+			}
 			else if( sTag == "file" )
 			{
 				quint32 nVerF;
@@ -170,9 +190,9 @@ QDataStream& operator>>(QDataStream& s, CDownload& rhs)
 						{
 							QString sHash;
 							s >> sHash;
-							CHash* pHash = CHash::fromURN(sHash);
-							item.lHashes.append(*pHash);
-							delete pHash;
+							CHash oHash = CHash::fromURN(sHash);
+							if( !oHash.isNull() )
+								item.lHashes.append(oHash);
 						}
 
 						s >> sTag2;
@@ -194,25 +214,46 @@ QDataStream& operator>>(QDataStream& s, CDownload& rhs)
 			{
 				Fragments::SerializeIn(s, rhs.m_lVerified);
 			}
+			else if( sTag == "tiger-tree" )
+			{
+				QByteArray baTree;
+				s >> baTree;
+				oTree = CTigerTree();
+				oTree.fromBreadthFirst(rhs.m_nSize, rhs.tigerRoot(), baTree);
+			}
 
 			s >> sTag;
 			sTag.chop(1);
 		}
 	}
 
-	Q_ASSERT(rhs.m_lActive.size() == rhs.m_lCompleted.size() && rhs.m_lCompleted.size() == rhs.m_lVerified.size());
+	Q_ASSERT(rhs.m_lActive.limit() == rhs.m_lCompleted.limit() && rhs.m_lCompleted.limit() == rhs.m_lVerified.limit());
+
+	rhs.resetScheduler();
+
+	// the tree is only taken once the whole state is in, it needs the size and the hashes
+	if( oTree.isValid() )
+		rhs.setTigerTree(oTree);
+
 	return s;
 }
 
 CDownload::CDownload(CQueryHit* pHit, QObject *parent) :
 	QObject(parent),
 	m_lCompleted(pHit->m_nObjectSize),
+	m_lReceived(pHit->m_nObjectSize),
 	m_lVerified(pHit->m_nObjectSize),
 	m_lActive(pHit->m_nObjectSize),
+	m_lUnassigned(pHit->m_nObjectSize),
 	m_bSignalSources(false),
 	m_nPriority(125),
 	m_bModified(true),
-	m_nTransfers(0)
+	m_nTransfers(0),
+	m_pStorage(0),
+	m_nCompleteSources(0),
+	m_nBlockSize(0),
+	m_pVerifier(0),
+	m_pTreeFetcher(0)
 {
 	Q_ASSERT(pHit != NULL);
 
@@ -221,6 +262,7 @@ CDownload::CDownload(CQueryHit* pHit, QObject *parent) :
 	m_nSize = pHit->m_nObjectSize;
 	m_nCompletedSize = 0;
 	m_sTempName = getTempFileName(m_sDisplayName);
+	resetScheduler();
 
 	FileListItem oFile;
 	oFile.sFileName = fixFileName(m_sDisplayName);
@@ -245,6 +287,13 @@ CDownload::~CDownload()
 	ASSUME_LOCK(Downloads.m_pSection);
 
 	qDeleteAll(m_lSources);
+
+	// flushes whatever is still cached on its own thread
+	if( m_pStorage )
+		m_pStorage->deleteLater();
+
+	if( m_pVerifier )
+		m_pVerifier->deleteLater();
 }
 
 void CDownload::start()
@@ -271,6 +320,11 @@ bool CDownload::addSource(CDownloadSource *pSource)
 
 	m_lSources.append(pSource);
 
+	if( pSource->m_lAvailableFrags.empty() )
+		m_nCompleteSources++;
+	else
+		addAvailability(pSource->m_lAvailableFrags, 1);
+
 	if( m_bSignalSources )
 		emit sourceAdded(pSource);
 
@@ -284,19 +338,9 @@ int CDownload::addSource(CQueryHit *pHit)
 	while(pThis != NULL)
 	{
 		// add hashes
-		for(QList<CHash>::const_iterator it = pThis->m_lHashes.begin(); it != pThis->m_lHashes.end(); ++it)
+		for(QVector<CHash>::const_iterator it = pThis->m_lHashes.begin(); it != pThis->m_lHashes.end(); ++it)
 		{
-			bool bFound = false;
-			for(QList<CHash>::const_iterator it2 = m_lHashes.begin(); it2 != m_lHashes.end(); ++it)
-			{
-				if(*it == *it2)
-				{
-					bFound = true;
-					break;
-				}
-			}
-
-			if( !bFound )
+			if( !m_lHashes.contains(*it) )
 			{
 				m_lHashes.append(*it);
 			}
@@ -321,26 +365,82 @@ void CDownload::removeSource(CDownloadSource *pSource)
 {
 	ASSUME_LOCK(Downloads.m_pSection);
 
-	for( int i = 0; i < m_lSources.size(); ++i )
-	{
-		if( m_lSources.at(i) == pSource )
-		{
-			m_lSources.removeAt(i);
-		}
-	}
+	if( !m_lSources.removeOne(pSource) )
+		return;
+
+	if( pSource->m_lAvailableFrags.empty() )
+		m_nCompleteSources--;
+	else
+		addAvailability(pSource->m_lAvailableFrags, -1);
 }
 
-int CDownload::startTransfers(int /*nMaxTransfers*/)
+int CDownload::startTransfers(int nMaxTransfers)
 {
 	ASSUME_LOCK(Downloads.m_pSection);
 
-	return 0; // must return the number of just started transfers
+	// reap transfers that have finished since the last call
+	foreach(CDownloadSource* pSource, m_lSources)
+	{
+		CDownloadTransfer* pTransfer = qobject_cast<CDownloadTransfer*>(pSource->m_pTransfer);
+
+		if( pTransfer && pTransfer->m_nState == CDownloadTransfer::dtsNull )
+			pSource->closeTransfer();
+	}
+
+	int nActive = 0;
+	foreach(CDownloadSource* pSource, m_lSources)
+	{
+		if( pSource->hasTransfer() )
+			nActive++;
+	}
+
+	if( nMaxTransfers < 0 )
+		nMaxTransfers = quazaaSettings.Downloads.MaxTransfersPerFile;
+
+	int nStarted = 0;
+
+	QMutexLocker l(&Transfers.m_pSection);
+
+	foreach(CDownloadSource* pSource, m_lSources)
+	{
+		if( nStarted >= nMaxTransfers || nActive >= quazaaSettings.Downloads.MaxTransfersPerFile )
+			break;
+
+		if( pSource->hasTransfer() || !pSource->canAccess() || pSource->m_bPush )
+			continue;
+
+		// sources are referenced by the download model, so dead ones are skipped rather than deleted
+		if( !quazaaSettings.Downloads.NeverDrop
+			&& pSource->m_nFailures > (quint32)quazaaSettings.Downloads.MaxAllowedFailures )
+			continue;
+
+		CTransfer* pTransfer = pSource->createTransfer();
+
+		if( !pTransfer )
+			continue;
+
+		pTransfer->connectTo(pSource->m_oAddress);
+		Transfers.add(pTransfer);
+
+		nStarted++;
+		nActive++;
+	}
+
+	m_nTransfers = nActive;
+
+	return nStarted; // must return the number of just started transfers
 }
 
 void CDownload::stopTransfers()
 {
 	ASSUME_LOCK(Downloads.m_pSection);
 
+	foreach(CDownloadSource* pSource, m_lSources)
+	{
+		pSource->closeTransfer();
+	}
+
+	m_nTransfers = 0;
 }
 
 bool CDownload::sourceExists(CDownloadSource *pSource)
@@ -355,48 +455,537 @@ QList<CTransfer *> CDownload::getTransfers()
 	return Transfers.getByOwner(this);
 }
 
-Fragments::List CDownload::getWantedFragments()
+bool CDownload::writeData(quint64 nOffset, const char* pData, quint64 nLength)
 {
-	// for now...
-	Fragments::List oList = inverse(m_lCompleted);
+	ASSUME_LOCK(Downloads.m_pSection);
 
-	return oList;
+	if( !m_pStorage )
+	{
+		m_pStorage = new CDownloadStorage(quazaaSettings.Downloads.IncompletePath + "/" + m_sTempName, m_nSize);
+		m_pStorage->moveToThread(&DownloadIOThread);
+		connect(m_pStorage, SIGNAL(flushed()), this, SLOT(onStorageFlushed()), Qt::QueuedConnection);
+		connectVerifier();
+	}
+	else if( m_pStorage->hasError() )
+	{
+		return false;
+	}
+
+	m_pStorage->write(nOffset, pData, nLength);
+
+	// m_lCompleted follows once the data is on disk, see commitStorage()
+	m_lReceived.insert(Fragments::Fragment(nOffset, nOffset + nLength));
+	m_lUnassigned.erase(Fragments::Fragment(nOffset, nOffset + nLength));
+
+	if( m_nState == dsPending )
+		setState(dsDownloading);
+
+	return true;
 }
 
-Fragments::List CDownload::getPossibleFragments(const Fragments::List &oAvailable, Fragments::Fragment &oLargest)
+// Writes out everything cached and waits for it; used before the state is saved.
+void CDownload::flushStorage()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( !m_pStorage )
+		return;
+
+	QMetaObject::invokeMethod(m_pStorage, "flush", Qt::BlockingQueuedConnection, Q_ARG(bool, true));
+	commitStorage();
+}
+
+void CDownload::onTimer()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( m_pStorage )
+		m_pStorage->flushIdle();
+}
+
+void CDownload::onStorageFlushed()
+{
+	QMutexLocker l(&Downloads.m_pSection);
+
+	commitStorage();
+}
+
+void CDownload::commitStorage()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	takeDurable();
+
+	if( m_pStorage && m_pStorage->hasError() )
+	{
+		systemLog.postLog( LogSeverity::Error, Components::Downloads,
+		                   qPrintable( tr( "Can't write incomplete file for %s: %s" ) ),
+		                   qPrintable( m_sDisplayName ), qPrintable( m_pStorage->errorString() ) );
+
+		// whatever did not make it to disk has to be downloaded again
+		resetScheduler();
+		setState(dsFileError);
+		return;
+	}
+
+	if( m_lCompleted.missing() == 0 && m_nState != dsCompleted )
+	{
+		// with a tree, the download is only done once the last block checked out
+		if( m_pVerifier && m_lVerified.missing() > 0 )
+			return;
+
+		if( m_pStorage )
+		{
+			m_pStorage->deleteLater();
+			m_pStorage = 0;
+		}
+
+		if( m_pVerifier )
+		{
+			m_pVerifier->deleteLater();
+			m_pVerifier = 0;
+		}
+
+		systemLog.postLog( LogSeverity::Notice, Components::Downloads,
+		                   qPrintable( tr( "Download completed: %s" ) ),
+		                   qPrintable( m_sDisplayName ) );
+		setState(dsCompleted);
+	}
+}
+
+void CDownload::takeDurable()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( !m_pStorage )
+		return;
+
+	QList<Fragments::Fragment> lDurable = m_pStorage->takeDurable();
+
+	for( int i = 0; i < lDurable.size(); ++i )
+		m_nCompletedSize += m_lCompleted.insert(lDurable[i]);
+
+	if( !lDurable.isEmpty() )
+		m_bModified = true;
+}
+
+CHash CDownload::tigerRoot() const
+{
+	foreach(const CHash& oHash, m_lHashes)
+	{
+		if( oHash.getAlgorithm() == CHash::TIGER )
+			return oHash;
+	}
+
+	return CHash();
+}
+
+bool CDownload::needsTigerTree() const
+{
+	return quazaaSettings.Downloads.VerifyTiger && !m_oTigerTree.isValid()
+			&& m_nSize > 0 && !tigerRoot().isNull() && m_nState != dsCompleted;
+}
+
+// Only one transfer at a time fetches the tree; the claim is dropped with its requests.
+bool CDownload::claimTigerTree(CDownloadTransfer* pTransfer)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( m_pTreeFetcher && m_pTreeFetcher != pTransfer )
+		return false;
+
+	m_pTreeFetcher = pTransfer;
+	return true;
+}
+
+void CDownload::releaseTigerTree(CDownloadTransfer* pTransfer)
 {
-	Fragments::List oPossible(oAvailable);
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( m_pTreeFetcher == pTransfer )
+		m_pTreeFetcher = 0;
+}
+
+// Takes a Tiger tree for the file, if it matches the size and the root we know of.
+// Without a known root the tree is taken as it is and its root becomes the file's.
+bool CDownload::setTigerTree(const CTigerTree& oTree)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
 
-	if( oAvailable.empty() )
+	if( !oTree.isValid() || oTree.size() != m_nSize || m_oTigerTree.isValid() )
+		return false;
+
+	const CHash oRoot = tigerRoot();
+
+	if( oRoot.isNull() )
+		m_lHashes.append(oTree.root());
+	else if( !(oRoot == oTree.root()) )
+		return false;
+
+	m_oTigerTree = oTree;
+	m_nBlockSize = m_oTigerTree.blockSize();
+	m_bModified = true;
+
+	systemLog.postLog( LogSeverity::Information, Components::Downloads,
+	                   qPrintable( tr( "Got Tiger tree for %s, %u blocks of %u bytes" ) ),
+	                   qPrintable( m_sDisplayName ), quint32(m_oTigerTree.blockCount()), quint32(m_oTigerTree.blockSize()) );
+
+	startVerifier();
+
+	return true;
+}
+
+// Sets up block verification once there is a tree. Whatever is on disk already and not
+// known to be good is read back and checked; new data comes in through the storage.
+void CDownload::startVerifier()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( m_pVerifier || !m_oTigerTree.isValid() || !quazaaSettings.Downloads.VerifyTiger
+		|| m_nState == dsCompleted )
+		return;
+
+	m_pVerifier = new CDownloadVerifier(quazaaSettings.Downloads.IncompletePath + "/" + m_sTempName, m_oTigerTree);
+	m_pVerifier->moveToThread(&DownloadVerifyThread);
+	connect(m_pVerifier, SIGNAL(blockVerified(quint32,bool)), this, SLOT(onBlockVerified(quint32,bool)), Qt::QueuedConnection);
+	connectVerifier();
+
+	// connected first, so nothing synced in between gets lost; overlaps are only checked twice
+	takeDurable();
+
+	Fragments::List oUnchecked(m_lCompleted);
+	oUnchecked.erase(m_lVerified.begin(), m_lVerified.end());
+
+	for( Fragments::List::const_iterator it = oUnchecked.begin(); it != oUnchecked.end(); ++it )
 	{
-		oPossible = getWantedFragments();
+		QMetaObject::invokeMethod(m_pVerifier, "addCompleted", Qt::QueuedConnection,
+		                          Q_ARG(quint64, it->begin()), Q_ARG(quint64, it->end()));
+	}
+}
+
+void CDownload::connectVerifier()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	if( m_pStorage && m_pVerifier )
+	{
+		connect(m_pStorage, SIGNAL(written(quint64,QByteArray)), m_pVerifier, SLOT(addData(quint64,QByteArray)),
+		        Qt::QueuedConnection);
+	}
+}
+
+void CDownload::onBlockVerified(quint32 nBlock, bool bValid)
+{
+	QMutexLocker l(&Downloads.m_pSection);
+
+	if( !m_pVerifier )
+		return;
+
+	// the block was synced before it was checked, make sure it counts as completed
+	takeDurable();
+
+	const quint64 nBegin = quint64(nBlock) * m_oTigerTree.blockSize();
+	const Fragments::Fragment oBlock(nBegin, qMin(nBegin + m_oTigerTree.blockSize(), m_nSize));
+
+	if( bValid )
+	{
+		m_lVerified.insert(oBlock);
 	}
 	else
 	{
-		Fragments::List oTmp = inverse(getWantedFragments());
-		oPossible.erase(oTmp.begin(), oTmp.end());
+		systemLog.postLog( LogSeverity::Warning, Components::Downloads,
+		                   qPrintable( tr( "Block %u of %s failed verification, downloading it again" ) ),
+		                   nBlock, qPrintable( m_sDisplayName ) );
+
+		// only this block goes, the rest of the file stays
+		m_lVerified.erase(oBlock);
+		m_nCompletedSize -= m_lCompleted.erase(oBlock);
+		m_lReceived.erase(oBlock);
+
+		Fragments::List oWanted(m_nSize);
+		oWanted.insert(oBlock);
+		oWanted.erase(m_lActive.begin(), m_lActive.end());
+		m_lUnassigned.insert(oWanted.begin(), oWanted.end());
+
+		penaliseSources(oBlock);
+	}
+
+	m_bModified = true;
+
+	commitStorage();
+}
+
+// A source that sent the whole of a bad block is dropped; sources that sent part of it
+// get a failure each, as there is no telling which part was wrong.
+void CDownload::penaliseSources(const Fragments::Fragment& oBlock)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	foreach(CDownloadSource* pSource, m_lSources)
+	{
+		quint64 nSent = 0;
+		Fragments::List::const_iterator_pair itSent = pSource->m_lDownloadedFrags.equal_range(oBlock);
+
+		for( ; itSent.first != itSent.second; ++itSent.first )
+			nSent += qMin(itSent.first->end(), oBlock.end()) - qMax(itSent.first->begin(), oBlock.begin());
+
+		if( !nSent )
+			continue;
+
+		pSource->m_lDownloadedFrags.erase(oBlock);
+
+		if( nSent == oBlock.size() )
+		{
+			systemLog.postLog( LogSeverity::Warning, Components::Downloads,
+			                   qPrintable( tr( "Dropping source %s of %s, it sent a corrupt block" ) ),
+			                   qPrintable( pSource->m_oAddress.toString() ), qPrintable( m_sDisplayName ) );
+
+			pSource->m_nFailures = quazaaSettings.Downloads.MaxAllowedFailures + 1;
+			pSource->m_tNextAccess = time(0) + quazaaSettings.Downloads.RetryDelay / 1000;
+			pSource->closeTransfer();
+		}
+		else
+		{
+			pSource->m_nFailures++;
+		}
 	}
+}
+
+Fragments::List CDownload::getPossibleFragments(const Fragments::List &oAvailable, Fragments::Fragment &oLargest)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	Fragments::List oPossible = oAvailable.empty() ? m_lUnassigned : intersection(m_lUnassigned, oAvailable);
 
 	if( oPossible.empty() )
 		return oPossible;
 
 	oLargest = *oPossible.largest_range();
 
-	QList<CTransfer*> lTransfers = getTransfers();
-	foreach(CTransfer* pTransfer, lTransfers)
+	return oPossible;
+}
+
+// Picks the next range for pTransfer to request: the rarest unassigned bytes its source has,
+// lowest offset first among equally rare ones, ending on a verification block boundary.
+// Once every missing byte is requested by someone, ranges already in flight elsewhere are
+// handed out again (end-game), so the last blocks don't wait on the slowest source.
+bool CDownload::selectFragment(CDownloadTransfer* pTransfer, quint64 nMaxSize, Fragments::Fragment& oFragment)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+	ASSUME_LOCK(Transfers.m_pSection);
+
+	const Fragments::List& oAvailable = pTransfer->m_pSource->m_lAvailableFrags;
+
+	quint32 nBestCount = ~0u;
+	quint64 nBestOffset = 0, nBestLimit = 0;
+
+	for( Fragments::List::const_iterator itFree = m_lUnassigned.begin(); itFree != m_lUnassigned.end() && nBestCount > 1; ++itFree )
 	{
-		CDownloadTransfer* pTr = qobject_cast<CDownloadTransfer*>(pTransfer);
+		if( oAvailable.empty() )
+		{
+			if( rarestFragment(itFree->begin(), itFree->end(), nBestCount, nBestOffset) )
+				nBestLimit = itFree->end();
+			continue;
+		}
+
+		Fragments::List::const_iterator_pair itHave = oAvailable.equal_range(*itFree);
 
-		if( pTr )
+		for( ; itHave.first != itHave.second && nBestCount > 1; ++itHave.first )
 		{
-			pTr->subtractRequested(oPossible);
+			const quint64 nBegin = qMax(itFree->begin(), itHave.first->begin());
+			const quint64 nEnd = qMin(itFree->end(), itHave.first->end());
 
-			if( oPossible.empty() )
-				break;
+			if( nBegin < nEnd && rarestFragment(nBegin, nEnd, nBestCount, nBestOffset) )
+				nBestLimit = nEnd;
 		}
 	}
 
-	return oPossible;
+	if( nBestCount == ~0u )
+	{
+		if( !m_lUnassigned.empty() )
+			return false; // what is left lives on other sources
+
+		// end-game: everything missing is requested, double up on what this source can serve
+		Fragments::List oDuplicate(m_lActive);
+		oDuplicate.erase(m_lReceived.begin(), m_lReceived.end());
+		oDuplicate.erase(pTransfer->m_lRequested.begin(), pTransfer->m_lRequested.end());
+
+		if( !oAvailable.empty() && !oDuplicate.empty() )
+			oDuplicate = intersection(oDuplicate, oAvailable);
+
+		if( oDuplicate.empty() )
+			return false;
+
+		// spread end-game sources over different ranges
+		Fragments::List::const_iterator itDup = oDuplicate.random_range();
+		nBestOffset = itDup->begin();
+		nBestLimit = itDup->end();
+	}
+
+	quint64 nEnd = nBestOffset + qMax(nMaxSize, quint64(1));
+
+	if( m_nBlockSize )
+	{
+		const quint64 nAligned = nEnd - nEnd % m_nBlockSize;
+		nEnd = (nAligned > nBestOffset) ? nAligned : nBestOffset - nBestOffset % m_nBlockSize + m_nBlockSize;
+	}
+
+	oFragment = Fragments::Fragment(nBestOffset, qMin(nEnd, nBestLimit));
+
+	return true;
+}
+
+void CDownload::reserveFragment(const Fragments::Fragment& oFragment)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	m_lActive.insert(oFragment);
+	m_lUnassigned.erase(oFragment);
+}
+
+void CDownload::releaseFragment(const Fragments::Fragment& oFragment)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	// In end-game another transfer may still be fetching part of this range;
+	// handing it out once more is cheaper than tracking every duplicate.
+	m_lActive.erase(oFragment);
+
+	quint64 nPos = oFragment.begin();
+	Fragments::List::const_iterator_pair itDone = m_lReceived.equal_range(oFragment);
+
+	for( ; itDone.first != itDone.second; ++itDone.first )
+	{
+		if( itDone.first->begin() > nPos )
+			m_lUnassigned.insert(Fragments::Fragment(nPos, itDone.first->begin()));
+
+		nPos = qMax(nPos, itDone.first->end());
+	}
+
+	if( nPos < oFragment.end() )
+		m_lUnassigned.insert(Fragments::Fragment(nPos, oFragment.end()));
+}
+
+void CDownload::setAvailableFragments(CDownloadSource* pSource, Fragments::List& oAvailable)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	const bool bCounted = sourceExists(pSource);
+
+	if( bCounted )
+	{
+		if( pSource->m_lAvailableFrags.empty() )
+			m_nCompleteSources--;
+		else
+			addAvailability(pSource->m_lAvailableFrags, -1);
+	}
+
+	pSource->m_lAvailableFrags.swap(oAvailable);
+
+	if( bCounted )
+	{
+		if( pSource->m_lAvailableFrags.empty() )
+			m_nCompleteSources++;
+		else
+			addAvailability(pSource->m_lAvailableFrags, 1);
+	}
+}
+
+void CDownload::resetScheduler()
+{
+	Fragments::List oActive(m_nSize);
+	m_lActive.swap(oActive);
+
+	m_lReceived = m_lCompleted;
+	m_lUnassigned = inverse(m_lReceived);
+	m_nBlockSize = m_oTigerTree.isValid() ? m_oTigerTree.blockSize() : defaultBlockSize(m_nSize);
+}
+
+// Tiger tree block size for a file, assuming the usual tree depth limit of 9 levels
+// (at most 256 blocks); the smallest block is one 1024 byte leaf.
+quint64 CDownload::defaultBlockSize(quint64 nSize)
+{
+	quint64 nBlock = 1024;
+
+	while( nBlock * 256 < nSize )
+		nBlock *= 2;
+
+	return nBlock;
+}
+
+void CDownload::addAvailability(const Fragments::List& oFragments, int nDelta)
+{
+	for( Fragments::List::const_iterator it = oFragments.begin(); it != oFragments.end(); ++it )
+		addAvailability(it->begin(), it->end(), nDelta);
+}
+
+void CDownload::addAvailability(quint64 nBegin, quint64 nEnd, int nDelta)
+{
+	if( nBegin >= nEnd )
+		return;
+
+	// split the step function at both ends, then shift every step in between
+	QMap<quint64, quint32>::iterator itSplit = m_lAvailability.lowerBound(nEnd);
+	if( itSplit == m_lAvailability.end() || itSplit.key() != nEnd )
+	{
+		const quint32 nCount = (itSplit == m_lAvailability.begin()) ? 0 : (itSplit - 1).value();
+		m_lAvailability.insert(nEnd, nCount);
+	}
+
+	QMap<quint64, quint32>::iterator it = m_lAvailability.lowerBound(nBegin);
+	if( it.key() != nBegin )
+	{
+		const quint32 nCount = (it == m_lAvailability.begin()) ? 0 : (it - 1).value();
+		it = m_lAvailability.insert(nBegin, nCount);
+	}
+
+	for( ; it.key() < nEnd; ++it )
+		it.value() += nDelta;
+
+	// The steps in between moved together, only those at both ends can now repeat the count
+	// before them; dropping those keeps the map at the real changes, not every boundary seen.
+	const quint64 lEdges[2] = { nBegin, nEnd };
+	for( int i = 0; i < 2; ++i )
+	{
+		it = m_lAvailability.find(lEdges[i]);
+		const quint32 nBefore = (it == m_lAvailability.begin()) ? 0 : (it - 1).value();
+
+		if( it.value() == nBefore )
+			m_lAvailability.erase(it);
+	}
+}
+
+// Scans [nBegin, nEnd) for a stretch held by fewer sources than nBestCount.
+// Only a strictly rarer stretch replaces the current best, so ties keep the lowest offset.
+bool CDownload::rarestFragment(quint64 nBegin, quint64 nEnd, quint32& nBestCount, quint64& nBestOffset)
+{
+	bool bImproved = false;
+
+	QMap<quint64, quint32>::const_iterator it = m_lAvailability.upperBound(nBegin);
+	quint32 nCount = (it == m_lAvailability.constBegin()) ? 0 : (it - 1).value();
+	quint64 nPos = nBegin;
+
+	while( nPos < nEnd )
+	{
+		if( m_nCompleteSources + nCount < nBestCount )
+		{
+			nBestCount = m_nCompleteSources + nCount;
+			nBestOffset = nPos;
+			bImproved = true;
+
+			if( nBestCount <= 1 )
+				break; // the asking source itself has it, nothing can be rarer
+		}
+
+		if( it == m_lAvailability.constEnd() )
+			break;
+
+		nPos = it.key();
+		nCount = it.value();
+		++it;
+	}
+
+	return bImproved;
 }
 
 void CDownload::saveState()
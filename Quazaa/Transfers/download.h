@@ -3,9 +3,15 @@
 
 #include "types.h"
 #include "FileFragments.hpp"
+#include "Hashes/tigertree.h"
 #include "Hashes/hash.h"
 
+#include <QMap>
+
 class CDownloadSource;
+class CDownloadStorage;
+class CDownloadVerifier;
+class CDownloadTransfer;
 class CQueryHit;
 class CTransfer;
 
@@ -21,7 +27,7 @@ public:
 		QString sTempName;
 		quint64 nStartOffset;
 		quint64 nEndOffset;
-		QList<CHash> lHashes;
+		QVector<CHash> lHashes;
 	};
 	enum DownloadState
 	{
@@ -44,22 +50,39 @@ public:
 	QList<CDownloadSource*> m_lSources;
 	bool					m_bMultifile;
 	QList<FileListItem>		m_lFiles;	// for multifile downloads
-	Fragments::List			m_lCompleted;
+	Fragments::List			m_lCompleted;	// durable on disk
+	Fragments::List			m_lReceived;	// received, maybe still cached; superset of m_lCompleted
 	Fragments::List			m_lVerified;
-	Fragments::List			m_lActive;
-	QList<CHash>			m_lHashes; // hashes for whole download
+	Fragments::List			m_lActive;		// requested by at least one transfer
+	Fragments::List			m_lUnassigned;	// wanted and not requested by any transfer
+	QVector<CHash>			m_lHashes; // hashes for whole download
 
 	bool					m_bSignalSources;
 	quint8					m_nPriority; // 255: highest priority; 1: lowest priority; 0: temporary disabled
 	bool					m_bModified;
 	int						m_nTransfers;
 	QDateTime				m_tStarted;
+protected:
+	CDownloadStorage*		m_pStorage;	// write cache for the incomplete file, created on first write
+	QMap<quint64, quint32>	m_lAvailability;	// partial sources having the bytes from key up to the next key
+	quint32					m_nCompleteSources;	// sources that have (or are assumed to have) everything
+	quint64					m_nBlockSize;	// verification block size, requests end on its boundaries
+	CTigerTree				m_oTigerTree;	// invalid until a source sent one that matches the root
+	CDownloadVerifier*		m_pVerifier;	// checks blocks against m_oTigerTree as they are written
+	CDownloadTransfer*		m_pTreeFetcher;	// transfer getting the tree, so only one does
 public:
 	CDownload()
 		: m_lCompleted(0),
+		  m_lReceived(0),
 		  m_lVerified(0),
 		  m_lActive(0),
-		  m_bSignalSources(false), m_bModified(false),m_nTransfers(0)
+		  m_lUnassigned(0),
+		  m_bSignalSources(false), m_bModified(false),m_nTransfers(0),
+		  m_pStorage(0),
+		  m_nCompleteSources(0),
+		  m_nBlockSize(0),
+		  m_pVerifier(0),
+		  m_pTreeFetcher(0)
 	{}
 	CDownload(CQueryHit* pHit, QObject *parent = 0);
 	~CDownload();
@@ -77,7 +100,25 @@ public:
 	QList<CTransfer*> getTransfers();
 
 	Fragments::List getPossibleFragments(const Fragments::List& oAvailable, Fragments::Fragment& oLargest);
-	Fragments::List getWantedFragments();
+
+	bool selectFragment(CDownloadTransfer* pTransfer, quint64 nMaxSize, Fragments::Fragment& oFragment);
+	void reserveFragment(const Fragments::Fragment& oFragment);
+	void releaseFragment(const Fragments::Fragment& oFragment);
+	void setAvailableFragments(CDownloadSource* pSource, Fragments::List& oAvailable);
+	void resetScheduler();
+
+	static quint64 defaultBlockSize(quint64 nSize);
+
+	CHash tigerRoot() const;
+	bool needsTigerTree() const;
+	bool claimTigerTree(CDownloadTransfer* pTransfer);
+	void releaseTigerTree(CDownloadTransfer* pTransfer);
+	bool setTigerTree(const CTigerTree& oTree);
+	inline const CTigerTree& tigerTree() const;
+
+	bool writeData(quint64 nOffset, const char* pData, quint64 nLength);
+	void flushStorage();
+	void onTimer();
 
 	void saveState();
 public:
@@ -89,11 +130,21 @@ public:
 	inline bool canDownload();
 protected:
 	void setState(CDownload::DownloadState state);
+	void commitStorage();
+	void takeDurable();
+	void startVerifier();
+	void connectVerifier();
+	void penaliseSources(const Fragments::Fragment& oBlock);
+	void addAvailability(const Fragments::List& oFragments, int nDelta);
+	void addAvailability(quint64 nBegin, quint64 nEnd, int nDelta);
+	bool rarestFragment(quint64 nBegin, quint64 nEnd, quint32& nBestCount, quint64& nBestOffset);
 signals:
 	void sourceAdded(CDownloadSource*);
 	void stateChanged(int);
 public slots:
 	void emitSources();
+	void onStorageFlushed();
+	void onBlockVerified(quint32 nBlock, bool bValid);
 };
 
 Q_DECLARE_METATYPE(CDownload*);
@@ -102,6 +153,10 @@ Q_DECLARE_METATYPE(CDownload::DownloadState);
 QDataStream& operator<<(QDataStream& s, const CDownload& rhs);
 QDataStream& operator>>(QDataStream& s, CDownload& rhs);
 
+const CTigerTree& CDownload::tigerTree() const
+{
+	return m_oTigerTree;
+}
 bool CDownload::isModified()
 {
 	return m_bModified;
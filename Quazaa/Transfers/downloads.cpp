@@ -25,13 +25,18 @@
 #include "downloads.h"
 #include "download.h"
 #include "downloadsource.h"
+#include "downloadstorage.h"
+#include "downloadverifier.h"
 #include "transfers.h"
 
 #include "quazaasettings.h"
+#include "securitymanager.h"
 
 #include <QDir>
 #include <QFile>
 
+#include <limits>
+
 #include "debug_new.h"
 
 CDownloads Downloads;
@@ -67,6 +72,12 @@ void CDownloads::start()
 {
 	QMutexLocker l(&m_pSection);
 
+	CDownloadStorage::startThread();
+	CDownloadVerifier::startThread();
+
+	// queued: the Security Manager emits while holding its own lock
+	connect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()), Qt::QueuedConnection);
+
 	QDir d(quazaaSettings.Downloads.IncompletePath);
 
 	if( !d.exists() )
@@ -102,8 +113,12 @@ void CDownloads::stop()
 {
 	QMutexLocker l(&m_pSection);
 
+	disconnect(&securityManager, SIGNAL(performSanityCheck()), this, SLOT(sanityCheck()));
+
 	foreach( CDownload* pDownload, m_lDownloads )
 	{
+		pDownload->flushStorage();
+
 		if( pDownload->isModified() )
 		{
 			pDownload->saveState();
@@ -113,6 +128,9 @@ void CDownloads::stop()
 	}
 
 	m_lDownloads.clear();
+
+	CDownloadVerifier::stopThread();
+	CDownloadStorage::stopThread();
 }
 
 void CDownloads::emitDownloads()
@@ -125,6 +143,54 @@ void CDownloads::emitDownloads()
 	}
 }
 
+// Checks download sources against the rules added since the last sanity check. Banned sources
+// lose their transfer and are never tried again; they are kept, as the GUI may still be about to
+// show them.
+void CDownloads::sanityCheck()
+{
+	QSharedPointer<const CSecuritySanityCheck> pRules = securityManager.newRules();
+
+	if( pRules && pRules->hasAddressRules() )
+	{
+		QList<CDownload*> lDownloads;
+		QList<CDownloadSource*> lSources;
+		QList<CEndPoint> lAddresses;
+
+		m_pSection.lock();
+		foreach( CDownload* pDownload, m_lDownloads )
+		{
+			foreach( CDownloadSource* pSource, pDownload->m_lSources )
+			{
+				lDownloads.append(pDownload);
+				lSources.append(pSource);
+				lAddresses.append(pSource->m_oAddress);
+			}
+		}
+		m_pSection.unlock();
+
+		QList<int> lDenied = pRules->denied(lAddresses);
+
+		if( !lDenied.isEmpty() )
+		{
+			QMutexLocker l(&m_pSection);
+
+			foreach( int nIndex, lDenied )
+			{
+				CDownload* pDownload = lDownloads.at(nIndex);
+				CDownloadSource* pSource = lSources.at(nIndex);
+
+				if( exists(pDownload) && pDownload->m_lSources.contains(pSource) )
+				{
+					pSource->closeTransfer();
+					pSource->m_tNextAccess = std::numeric_limits<time_t>::max();
+				}
+			}
+		}
+	}
+
+	securityManager.sanityCheckPerformed();
+}
+
 void CDownloads::onTimer()
 {
 	if(m_lDownloads.isEmpty())
@@ -162,6 +228,8 @@ void CDownloads::onTimer()
 
 	foreach(CDownload* pDownload, m_lDownloads)
 	{
+		pDownload->onTimer();
+
 		if( pDownload->m_nState == CDownload::dsPending )
 		{
 			if( false /* starved? */ )
@@ -183,11 +251,15 @@ void CDownloads::onTimer()
 			}
 		}
 
-		if( pDownload->canDownload() && nTransfersLeft > 0 )
+		if( pDownload->canDownload() )
 		{
-			int nAllow = qMin(3, (nTransfersLeft / (nActive + 1)));
+			int nAllow = qMax(0, qMin(3, (nTransfersLeft / (nActive + 1))));
 			nTransfersLeft -= pDownload->startTransfers(nAllow);
 		}
+		else if( pDownload->transfersCount() > 0 )
+		{
+			pDownload->stopTransfers();
+		}
 	}
 }
 
@@ -29,6 +29,7 @@ signals:
 public slots:
 	void emitDownloads();
 	void onTimer();
+	void sanityCheck();
 };
 
 extern CDownloads Downloads;
@@ -26,8 +26,9 @@
 #include "queryhit.h"
 #include "downloads.h"
 #include "download.h"
+#include "transfers.h"
 
-#include "transfer.h"
+#include "downloadtransferhttp.h"
 
 #include "debug_new.h"
 
@@ -77,6 +78,7 @@ CTransfer *CDownloadSource::createTransfer()
 	switch(m_nProtocol)
 	{
 		case tpHTTP:
+			pTransfer = new CDownloadTransferHTTP(m_pDownload, this);
 			break;
 		case tpBitTorrent:
 			break;
@@ -85,7 +87,10 @@ CTransfer *CDownloadSource::createTransfer()
 	}
 
 	if( pTransfer )
+	{
+		m_pTransfer = pTransfer;
 		emit transferCreated();
+	}
 
 	return pTransfer;
 }
@@ -96,12 +101,27 @@ void CDownloadSource::closeTransfer()
 
 	if( m_pTransfer )
 	{
+		QMutexLocker l(&Transfers.m_pSection);
+
+		// give back whatever it still had requested
+		CDownloadTransfer* pDownloadTransfer = qobject_cast<CDownloadTransfer*>(m_pTransfer);
+		if( pDownloadTransfer )
+			pDownloadTransfer->releaseRequests();
+
 		delete m_pTransfer;
 		m_pTransfer = 0;
 		emit transferClosed();
 	}
 }
 
+void CDownloadSource::addDownloadedFragment(quint64 nOffset, quint64 nLength)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	m_lDownloadedFrags.insert(Fragments::Fragment(nOffset, nOffset + nLength));
+	emit bytesReceived(nOffset, nLength);
+}
+
 QDataStream& operator<<(QDataStream& s, const CDownloadSource& rhs)
 {
 	if( !rhs.m_bPush ) // do not store push sources (they may be useless after restart)
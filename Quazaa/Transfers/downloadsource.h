@@ -19,7 +19,7 @@ public:
 	TransferProtocol	m_nProtocol;	// protocol
 	DiscoveryProtocol	m_nNetwork;		// network
 	QUuid				m_oGUID;		// source GUID (needed for pushing)
-	QList<CHash>		m_lHashes;		// list of hashes
+	QVector<CHash>		m_lHashes;		// list of hashes
 	time_t				m_tNextAccess;	// seconds since 1970
 	quint32				m_nFailures;	// number of failures
 	QString				m_sURL;			// URL
@@ -42,6 +42,8 @@ public:
 	inline bool canAccess();
 	inline bool hasTransfer();
 
+	void addDownloadedFragment(quint64 nOffset, quint64 nLength);
+
 signals:
 	void transferCreated();
 	void transferClosed();
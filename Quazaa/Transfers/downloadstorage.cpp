@@ -0,0 +1,348 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "downloadstorage.h"
+#include "thread.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QPair>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+#include "debug_new.h"
+
+CThread DownloadIOThread;
+static QMutex DownloadIOSection;
+
+static const quint64 StorageFlushChunk = 256 * 1024;		// a run is written once it holds this much aligned data
+static const quint64 StorageFlushAlign = 64 * 1024;			// partial writes end on multiples of this
+static const quint64 StorageCacheLimit = 2 * 1024 * 1024;	// per download; above it everything is written
+static const qint64  StorageIdleFlush  = 2000;				// ms without writes before the cache is written out
+
+CDownloadStorage::CDownloadStorage(const QString& sFileName, quint64 nSize) :
+	QObject(0),
+	m_sFileName(sFileName),
+	m_nSize(nSize),
+	m_nDirty(0),
+	m_bFlushQueued(false),
+	m_bError(false),
+	m_pFile(0)
+{
+}
+
+CDownloadStorage::~CDownloadStorage()
+{
+	flush(true);
+
+	if( m_pFile )
+	{
+		m_pFile->close();
+		delete m_pFile;
+	}
+}
+
+void CDownloadStorage::startThread()
+{
+	QMutexLocker l(&DownloadIOSection);
+
+	if( !DownloadIOThread.isRunning() )
+		DownloadIOThread.start("Download I/O", &DownloadIOSection);
+}
+
+void CDownloadStorage::stopThread()
+{
+	QMutexLocker l(&DownloadIOSection);
+
+	if( DownloadIOThread.isRunning() )
+		DownloadIOThread.exit(0);
+}
+
+void CDownloadStorage::write(quint64 nOffset, const char* pData, quint64 nLength)
+{
+	QMutexLocker l(&m_pSection);
+
+	const quint64 nRun = insertDirty(nOffset, pData, nLength);
+	m_tLastWrite.start();
+
+	if( nRun >= StorageFlushChunk || m_nDirty >= StorageCacheLimit )
+		queueFlush(false);
+}
+
+void CDownloadStorage::flushIdle()
+{
+	QMutexLocker l(&m_pSection);
+
+	if( m_nDirty > 0 && m_tLastWrite.isValid() && m_tLastWrite.hasExpired(StorageIdleFlush) )
+		queueFlush(true);
+}
+
+QList<Fragments::Fragment> CDownloadStorage::takeDurable()
+{
+	QMutexLocker l(&m_pSection);
+
+	QList<Fragments::Fragment> lDurable;
+	lDurable.swap(m_lDurable);
+	return lDurable;
+}
+
+bool CDownloadStorage::hasError() const
+{
+	QMutexLocker l(&m_pSection);
+	return m_bError;
+}
+
+QString CDownloadStorage::errorString() const
+{
+	QMutexLocker l(&m_pSection);
+	return m_sError;
+}
+
+quint64 CDownloadStorage::cachedBytes() const
+{
+	QMutexLocker l(&m_pSection);
+	return m_nDirty;
+}
+
+// Runs on DownloadIOThread. Unless forced (or over the cache limit), only the aligned head
+// of runs that reached StorageFlushChunk is written; the tail stays cached to be extended.
+void CDownloadStorage::flush(bool bForce)
+{
+	QList< QPair<quint64, QByteArray> > lRuns;
+
+	m_pSection.lock();
+
+	m_bFlushQueued = false;
+
+	const bool bAll = bForce || m_nDirty >= StorageCacheLimit;
+	QList< QPair<quint64, QByteArray> > lTails;
+
+	for( QMap<quint64, QByteArray>::iterator it = m_lDirty.begin(); it != m_lDirty.end(); )
+	{
+		quint64 nLength = it.value().size();
+
+		if( !bAll )
+		{
+			const quint64 nEnd = it.key() + nLength;
+			const quint64 nAligned = nEnd - nEnd % StorageFlushAlign;
+
+			nLength = (nAligned > it.key()) ? nAligned - it.key() : 0;
+
+			if( nLength < StorageFlushChunk )
+			{
+				++it;
+				continue;
+			}
+		}
+
+		if( nLength == quint64(it.value().size()) )
+		{
+			lRuns.append(qMakePair(it.key(), it.value()));
+		}
+		else
+		{
+			lRuns.append(qMakePair(it.key(), it.value().left(int(nLength))));
+			lTails.append(qMakePair(it.key() + nLength, it.value().mid(int(nLength))));
+		}
+
+		m_nDirty -= nLength;
+		it = m_lDirty.erase(it);
+	}
+
+	for( int i = 0; i < lTails.size(); ++i )
+		m_lDirty.insert(lTails[i].first, lTails[i].second);
+
+	const bool bError = m_bError;
+
+	m_pSection.unlock();
+
+	if( lRuns.isEmpty() || bError )
+		return;
+
+	QList<Fragments::Fragment> lWritten;
+	bool bOk = (m_pFile || open());
+
+	for( int i = 0; bOk && i < lRuns.size(); ++i )
+	{
+		const QByteArray& baData = lRuns[i].second;
+
+		if( !m_pFile->seek(lRuns[i].first) || m_pFile->write(baData) != baData.size() )
+		{
+			setError(m_pFile->errorString());
+			bOk = false;
+			break;
+		}
+
+		lWritten.append(Fragments::Fragment(lRuns[i].first, lRuns[i].first + baData.size()));
+	}
+
+	// nothing counts as durable unless the sync went through
+	if( bOk && !sync() )
+	{
+		setError(m_pFile->errorString());
+		bOk = false;
+	}
+
+	if( bOk )
+	{
+		m_pSection.lock();
+		m_lDurable.append(lWritten);
+		m_pSection.unlock();
+
+		for( int i = 0; i < lRuns.size(); ++i )
+			emit written(lRuns[i].first, lRuns[i].second);
+	}
+
+	emit flushed();
+}
+
+// Adds a range to the cache, skipping bytes that are already cached (they can only be the
+// same file data, e.g. from an end-game duplicate). Returns the size of the run it ended in.
+quint64 CDownloadStorage::insertDirty(quint64 nOffset, const char* pData, quint64 nLength)
+{
+	quint64 nLastRun = 0;
+
+	while( nLength > 0 )
+	{
+		QMap<quint64, QByteArray>::iterator itNext = m_lDirty.upperBound(nOffset);
+		QMap<quint64, QByteArray>::iterator itPrev = m_lDirty.end();
+		quint64 nPrevEnd = 0;
+
+		if( itNext != m_lDirty.begin() )
+		{
+			itPrev = itNext - 1;
+			nPrevEnd = itPrev.key() + itPrev.value().size();
+
+			if( nPrevEnd > nOffset )
+			{
+				const quint64 nSkip = qMin(nPrevEnd - nOffset, nLength);
+				nOffset += nSkip;
+				pData += nSkip;
+				nLength -= nSkip;
+				nLastRun = itPrev.value().size();
+				continue;
+			}
+		}
+
+		quint64 nPiece = nLength;
+		if( itNext != m_lDirty.end() )
+			nPiece = qMin(nPiece, itNext.key() - nOffset);
+
+		QMap<quint64, QByteArray>::iterator itRun;
+
+		if( itPrev != m_lDirty.end() && nPrevEnd == nOffset )
+		{
+			itPrev.value().append(pData, int(nPiece));
+			itRun = itPrev;
+		}
+		else
+		{
+			itRun = m_lDirty.insert(nOffset, QByteArray(pData, int(nPiece)));
+		}
+
+		m_nDirty += nPiece;
+		nOffset += nPiece;
+		pData += nPiece;
+		nLength -= nPiece;
+
+		// the gap to the next run is closed, fold it in
+		if( itNext != m_lDirty.end() && itNext.key() == nOffset )
+		{
+			itRun.value().append(itNext.value());
+			m_lDirty.erase(itNext);
+		}
+
+		nLastRun = itRun.value().size();
+	}
+
+	return nLastRun;
+}
+
+void CDownloadStorage::queueFlush(bool bForce)
+{
+	if( m_bFlushQueued )
+		return;
+
+	m_bFlushQueued = true;
+	QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection, Q_ARG(bool, bForce));
+}
+
+bool CDownloadStorage::open()
+{
+	m_pFile = new QFile(m_sFileName);
+
+	if( !m_pFile->open(QFile::ReadWrite | QFile::Unbuffered) )
+	{
+		setError(m_pFile->errorString());
+		delete m_pFile;
+		m_pFile = 0;
+		return false;
+	}
+
+	if( m_nSize != SIZE_UNKNOWN && quint64(m_pFile->size()) < m_nSize )
+	{
+		// reserve the whole file up front, so ranges arriving out of order don't fragment it
+		bool bReserved = false;
+#ifdef Q_OS_LINUX
+		bReserved = (posix_fallocate(m_pFile->handle(), 0, m_nSize) == 0);
+#endif
+		if( !bReserved && !m_pFile->resize(m_nSize) )
+		{
+			systemLog.postLog( LogSeverity::Warning, Components::Downloads,
+			                   "Could not preallocate %s: %s",
+			                   qPrintable( m_sFileName ), qPrintable( m_pFile->errorString() ) );
+		}
+	}
+
+	return true;
+}
+
+bool CDownloadStorage::sync()
+{
+	if( !m_pFile->flush() )
+		return false;
+
+#if defined(Q_OS_LINUX)
+	return (fdatasync(m_pFile->handle()) == 0);
+#elif defined(Q_OS_UNIX)
+	return (fsync(m_pFile->handle()) == 0);
+#elif defined(Q_OS_WIN)
+	return (_commit(m_pFile->handle()) == 0);
+#else
+	return true;
+#endif
+}
+
+void CDownloadStorage::setError(const QString& sError)
+{
+	QMutexLocker l(&m_pSection);
+
+	m_bError = true;
+	m_sError = sError;
+}
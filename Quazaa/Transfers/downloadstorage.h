@@ -0,0 +1,95 @@
+/*
+** downloadstorage.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef DOWNLOADSTORAGE_H
+#define DOWNLOADSTORAGE_H
+
+#include "types.h"
+#include "FileFragments.hpp"
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+
+class CThread;
+class QFile;
+
+// Write-back cache in front of a download's incomplete file.
+// Transfers hand received data to write() from the transfers thread; contiguous ranges are
+// coalesced in memory and written out in large, aligned chunks on DownloadIOThread. Ranges
+// only become durable (takeDurable()) after they have been written and synced to disk; the
+// data itself is passed on through written() at that point, for verification.
+class CDownloadStorage : public QObject
+{
+	Q_OBJECT
+
+protected:
+	mutable QMutex				m_pSection;		// guards everything but m_pFile
+	QString						m_sFileName;
+	quint64						m_nSize;
+
+	QMap<quint64, QByteArray>	m_lDirty;		// cached runs by offset, never adjacent or overlapping
+	quint64						m_nDirty;		// bytes in m_lDirty
+	QList<Fragments::Fragment>	m_lDurable;		// synced, not yet collected by the download
+	bool						m_bFlushQueued;
+	QElapsedTimer				m_tLastWrite;
+
+	bool						m_bError;
+	QString						m_sError;
+
+	QFile*						m_pFile;		// opened on DownloadIOThread by the first flush
+
+public:
+	CDownloadStorage(const QString& sFileName, quint64 nSize);
+	~CDownloadStorage();
+
+	void write(quint64 nOffset, const char* pData, quint64 nLength);
+	void flushIdle();
+	QList<Fragments::Fragment> takeDurable();
+
+	bool hasError() const;
+	QString errorString() const;
+	quint64 cachedBytes() const;
+
+	static void startThread();
+	static void stopThread();
+
+public slots:
+	void flush(bool bForce = false);
+
+signals:
+	void written(quint64 nOffset, const QByteArray& baData);
+	void flushed();
+
+protected:
+	quint64 insertDirty(quint64 nOffset, const char* pData, quint64 nLength);
+	void queueFlush(bool bForce);
+	bool open();
+	bool sync();
+	void setError(const QString& sError);
+};
+
+extern CThread DownloadIOThread;
+
+#endif // DOWNLOADSTORAGE_H
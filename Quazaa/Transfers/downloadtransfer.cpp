@@ -1,10 +1,14 @@
 #include "downloadtransfer.h"
 #include "downloadsource.h"
+#include "download.h"
+#include "downloads.h"
+#include "transfers.h"
 
 #include "quazaasettings.h"
 
 CDownloadTransfer::CDownloadTransfer(CDownload *pOwner, CDownloadSource *pSource, QObject *parent) :
 	CTransfer(pOwner, parent),
+	m_pOwner(pOwner),
 	m_pSource(pSource),
 	m_nState(dtsNull),
 	m_tLastResponse(0),
@@ -25,16 +29,23 @@ void CDownloadTransfer::onTimer(quint32 tNow)
 	switch(m_nState)
 	{
 		case CDownloadTransfer::dtsConnecting:
-		case CDownloadTransfer::dtsRequesting:
-		case CDownloadTransfer::dtsResponse:
 			if( tNow - m_tConnected > quazaaSettings.Connection.TimeoutConnect )
 			{
 				systemLog.postLog(LogSeverity::Error, QString(tr("Timed out connecting to download host %1.")).arg(m_pSource->m_oAddress.toStringWithPort()));
 				close();
 			}
 			break;
+		case CDownloadTransfer::dtsRequesting:
+		case CDownloadTransfer::dtsResponse:
+			// on a kept-alive connection the clock starts with the last request, not with the connect
+			if( tNow - m_tLastResponse > quazaaSettings.Connection.TimeoutConnect )
+			{
+				systemLog.postLog(LogSeverity::Error, QString(tr("Timed out waiting for response from download host %1.")).arg(m_pSource->m_oAddress.toStringWithPort()));
+				close();
+			}
+			break;
 		case CDownloadTransfer::dtsDownloading:
-			if( tNow - m_tConnected > quazaaSettings.Connection.TimeoutTraffic )
+			if( tNow - m_tLastResponse > quazaaSettings.Connection.TimeoutTraffic )
 			{
 				systemLog.postLog(LogSeverity::Error, QString(tr("Closing download connection to %1 due to lack of traffic.")).arg(m_pSource->m_oAddress.toStringWithPort()));
 				close();
@@ -47,7 +58,36 @@ void CDownloadTransfer::onTimer(quint32 tNow)
 
 void CDownloadTransfer::requestBlock(Fragments::Fragment oFragment)
 {
+	ASSUME_LOCK(Downloads.m_pSection);
+	ASSUME_LOCK(Transfers.m_pSection);
+
 	m_lRequested.push_back(oFragment);
+	m_pOwner->reserveFragment(oFragment);
+}
+
+void CDownloadTransfer::releaseFirstRequest()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+	ASSUME_LOCK(Transfers.m_pSection);
+
+	if( m_lRequested.empty() )
+		return;
+
+	m_pOwner->releaseFragment(*m_lRequested.begin());
+	m_lRequested.pop_front();
+}
+
+void CDownloadTransfer::releaseRequests()
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+	ASSUME_LOCK(Transfers.m_pSection);
+
+	for( Fragments::Queue::const_iterator it = m_lRequested.begin(); it != m_lRequested.end(); ++it )
+		m_pOwner->releaseFragment(*it);
+
+	m_lRequested.clear();
+
+	m_pOwner->releaseTigerTree(this);
 }
 
 void CDownloadTransfer::subtractRequested(Fragments::List &oFragments)
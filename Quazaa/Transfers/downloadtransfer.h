@@ -42,6 +42,8 @@ public:
 	virtual void onTimer(quint32 tNow = 0);
 	virtual void requestBlock(Fragments::Fragment oFragment);
 	virtual void subtractRequested(Fragments::List& oFragments);
+	void releaseFirstRequest();
+	void releaseRequests();
 public:
 	inline CDownloadSource* source() const;
 signals:
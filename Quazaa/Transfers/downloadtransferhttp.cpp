@@ -0,0 +1,739 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "downloadtransferhttp.h"
+#include "download.h"
+#include "downloads.h"
+#include "downloadsource.h"
+#include "transfers.h"
+
+#include "network.h"
+#include "headerparser.h"
+#include "quazaaglobals.h"
+#include "quazaasettings.h"
+
+#include <QRegExp>
+#include <QStringList>
+#include <QUrl>
+
+#include "debug_new.h"
+
+static const quint32 HTTPMaxHeaderSize    = 16384;	// drop sources that send a larger response header
+static const quint32 HTTPMaxPipelineDepth = 4;		// range requests in flight on one connection
+static const quint32 HTTPRequestWindow    = 10;		// seconds of traffic a single range request should cover
+static const quint32 HTTPPipelineWindow   = 4;		// seconds of traffic to keep requested ahead
+static const quint32 HTTPMaxTreeSize      = 1048576;	// larger Tiger trees are not fetched
+
+CDownloadTransferHTTP::CDownloadTransferHTTP(CDownload* pOwner, CDownloadSource* pSource, QObject* parent) :
+	CDownloadTransfer(pOwner, pSource, parent),
+	m_bKeepAlive(false),
+	m_bPipelining(false),
+	m_bDiscardContent(false),
+	m_nContentOffset(0),
+	m_nContentLength(0),
+	m_tRequestAgain(0),
+	m_nReceived(0),
+	m_oResponse(HTTPMaxHeaderSize),
+	m_bTreeRequest(false),
+	m_bTreeContent(false)
+{
+	ASSUME_LOCK(Downloads.m_pSection);
+
+	QUrl oUrl(pSource->m_sURL);
+
+	if( oUrl.isValid() && !oUrl.path().isEmpty() )
+	{
+		m_sRequestPath = oUrl.toEncoded(QUrl::RemoveScheme | QUrl::RemoveAuthority);
+	}
+	else
+	{
+		QVector<CHash> lHashes = pOwner->m_lHashes + pSource->m_lHashes;
+
+		// prefer SHA1, every Gnutella servent understands it
+		for( int i = 0; i < lHashes.size(); ++i )
+		{
+			if( m_sRequestPath.isEmpty() || lHashes[i].getAlgorithm() == CHash::SHA1 )
+			{
+				m_sRequestPath = "/uri-res/N2R?" + lHashes[i].toURN().toLatin1();
+
+				if( lHashes[i].getAlgorithm() == CHash::SHA1 )
+					break;
+			}
+		}
+	}
+}
+
+CDownloadTransferHTTP::~CDownloadTransferHTTP()
+{
+}
+
+void CDownloadTransferHTTP::connectTo(CEndPoint oAddress)
+{
+	systemLog.postLog( LogSeverity::Debug, Components::Downloads,
+	                   "Connecting to download source %s",
+	                   qPrintable( oAddress.toStringWithPort() ) );
+
+	m_nState = dtsConnecting;
+	m_tLastResponse = time(0);
+	m_oResponse.reset();
+
+	CDownloadTransfer::connectTo(oAddress);
+}
+
+void CDownloadTransferHTTP::onTimer(quint32 tNow)
+{
+	if( tNow == 0 )
+		tNow = time(0);
+
+	if( m_nState == dtsQueued && tNow >= m_tRequestAgain )
+	{
+		// Transfers.m_pSection is held here, and requesting needs Downloads.m_pSection first
+		m_tRequestAgain = tNow + quazaaSettings.Connection.TimeoutConnect;
+		QMetaObject::invokeMethod(this, "sendRequests", Qt::QueuedConnection);
+	}
+
+	CDownloadTransfer::onTimer(tNow);
+}
+
+void CDownloadTransferHTTP::requestBlock(Fragments::Fragment oFragment)
+{
+	ASSUME_LOCK(Transfers.m_pSection);
+
+	QByteArray sRequest;
+
+	sRequest += "GET " + m_sRequestPath + (quazaaSettings.Downloads.RequestHTTP11 ? " HTTP/1.1\r\n" : " HTTP/1.0\r\n");
+	sRequest += "Host: " + m_oAddress.toStringWithPort() + "\r\n";
+	sRequest += "User-Agent: " + CQuazaaGlobals::USER_AGENT_STRING() + "\r\n";
+	sRequest += "Connection: Keep-Alive\r\n";
+	sRequest += "Range: bytes=" + QByteArray::number(oFragment.begin()) + "-" + QByteArray::number(oFragment.end() - 1) + "\r\n";
+	sRequest += "X-Features: g2/1.0\r\n";
+	sRequest += "X-Queue: 0.1\r\n";
+	sRequest += "Listen-IP: " + Network.getLocalAddress().toStringWithPort() + "\r\n";
+	sRequest += "\r\n";
+
+	write(sRequest);
+
+	if( m_lRequested.empty() )
+		m_tLastResponse = time(0);
+
+	CDownloadTransfer::requestBlock(oFragment);
+}
+
+void CDownloadTransferHTTP::requestTigerTree()
+{
+	ASSUME_LOCK(Transfers.m_pSection);
+
+	QByteArray sRequest;
+
+	sRequest += "GET " + m_sTigerTreePath + (quazaaSettings.Downloads.RequestHTTP11 ? " HTTP/1.1\r\n" : " HTTP/1.0\r\n");
+	sRequest += "Host: " + m_oAddress.toStringWithPort() + "\r\n";
+	sRequest += "User-Agent: " + CQuazaaGlobals::USER_AGENT_STRING() + "\r\n";
+	sRequest += "Connection: Keep-Alive\r\n";
+	sRequest += "\r\n";
+
+	write(sRequest);
+
+	m_tLastResponse = time(0);
+}
+
+void CDownloadTransferHTTP::onConnectNode()
+{
+	m_bConnected = true;
+
+	if( m_sRequestPath.isEmpty() )
+	{
+		systemLog.postLog( LogSeverity::Error, Components::Downloads,
+		                   "No usable URN or URL for download source %s",
+		                   qPrintable( m_oAddress.toStringWithPort() ) );
+		finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+		return;
+	}
+
+	systemLog.postLog( LogSeverity::Information, Components::Downloads,
+	                   "Connected to download source %s, requesting data",
+	                   qPrintable( m_oAddress.toStringWithPort() ) );
+
+	m_nState = dtsRequesting;
+	sendRequests();
+}
+
+void CDownloadTransferHTTP::onDisconnectNode()
+{
+	m_bConnected = false;
+
+	if( m_nState == dtsNull )
+		return;
+
+	systemLog.postLog( LogSeverity::Information, Components::Downloads,
+	                   "Download source %s closed the connection",
+	                   qPrintable( m_oAddress.toStringWithPort() ) );
+
+	// whatever was still in the pipeline is released and requested again from any free source
+	finish(m_nReceived == 0, quazaaSettings.Downloads.RetryDelay / 1000);
+}
+
+void CDownloadTransferHTTP::onError(QAbstractSocket::SocketError e)
+{
+	if( m_nState == dtsNull )
+		return;
+
+	if( e != QAbstractSocket::RemoteHostClosedError )
+	{
+		systemLog.postLog( LogSeverity::Information, Components::Downloads,
+		                   "Download source %s: %s",
+		                   qPrintable( m_oAddress.toStringWithPort() ),
+		                   qPrintable( m_pSocket->errorString() ) );
+	}
+
+	finish(m_nReceived == 0, quazaaSettings.Downloads.RetryDelay / 1000);
+}
+
+void CDownloadTransferHTTP::onRead()
+{
+	while( m_nState != dtsNull )
+	{
+		if( m_nContentLength > 0 )
+		{
+			if( !readContent() )
+				break;
+		}
+		else if( m_nState == dtsRequesting )
+		{
+			if( !readResponse() )
+				break;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+void CDownloadTransferHTTP::sendRequests()
+{
+	if( m_nState != dtsRequesting && m_nState != dtsDownloading && m_nState != dtsQueued )
+		return;
+
+	if( m_bTreeRequest )
+		return; // ranges follow once the tree is in
+
+	QMutexLocker l(&Downloads.m_pSection);
+
+	if( !m_pOwner->canDownload() )
+		return; // transfer is reaped by the download
+
+	QMutexLocker t(&Transfers.m_pSection);
+
+	if( !m_sTigerTreePath.isEmpty() && m_pOwner->needsTigerTree() && m_pOwner->claimTigerTree(this) )
+	{
+		// the tree goes out on its own, once the ranges already requested are in
+		if( m_lRequested.empty() )
+		{
+			requestTigerTree();
+			m_bTreeRequest = true;
+
+			if( m_nState == dtsQueued )
+				m_nState = dtsRequesting;
+		}
+
+		return;
+	}
+
+	const quint32 nDepth = m_bPipelining ? HTTPMaxPipelineDepth : 1;
+	const quint64 nWindow = quint64(m_mInput.AvgUsage()) * HTTPPipelineWindow;
+
+	while( m_lRequested.size() < nDepth )
+	{
+		if( m_lRequested.size() > 1 && requestedBytes() >= nWindow )
+			break;
+
+		Fragments::Fragment oFragment(0, 0);
+
+		if( !m_pOwner->selectFragment(this, requestSize(), oFragment) )
+			break;
+
+		requestBlock(oFragment);
+	}
+
+	if( m_lRequested.empty() )
+	{
+		t.unlock();
+		l.unlock();
+
+		systemLog.postLog( LogSeverity::Debug, Components::Downloads,
+		                   "Nothing left to request from download source %s",
+		                   qPrintable( m_oAddress.toStringWithPort() ) );
+		finish(false, quazaaSettings.Downloads.RetryDelay / 1000);
+		return;
+	}
+
+	if( m_nState == dtsQueued )
+		m_nState = dtsRequesting;
+}
+
+bool CDownloadTransferHTTP::readResponse()
+{
+	CBuffer* pInput = getInputBuffer();
+
+	// the previous response has been handled
+	if( m_oResponse.state() != CHeaderParser::hsIncomplete )
+		m_oResponse.reset();
+
+	const CHeaderParser::State nState = m_oResponse.parse(pInput);
+
+	if( nState == CHeaderParser::hsIncomplete )
+		return false;
+
+	if( nState != CHeaderParser::hsComplete )
+	{
+		systemLog.postLog( LogSeverity::Error, Components::Downloads,
+		                   "Download source %s sent an oversized or malformed response header",
+		                   qPrintable( m_oAddress.toStringWithPort() ) );
+		finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+		return false;
+	}
+
+	pInput->remove(m_oResponse.length());
+	m_tLastResponse = time(0);
+
+	QList<QByteArray> lStatus = m_oResponse.startLine().split(' ');
+	lStatus.removeAll(QByteArray());
+
+	if( lStatus.size() < 2 || !lStatus[0].startsWith("HTTP/") )
+	{
+		systemLog.postLog( LogSeverity::Error, Components::Downloads,
+		                   "Download source %s sent a malformed response",
+		                   qPrintable( m_oAddress.toStringWithPort() ) );
+		finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+		return false;
+	}
+
+	const int nCode = lStatus[1].toInt();
+	const QString sConnection = m_oResponse.value("Connection");
+
+	if( lStatus[0] == "HTTP/1.0" )
+		m_bKeepAlive = (sConnection.compare("Keep-Alive", Qt::CaseInsensitive) == 0);
+	else
+		m_bKeepAlive = (sConnection.compare("close", Qt::CaseInsensitive) != 0);
+
+	bool bHasLength = false;
+	const quint64 nLength = m_oResponse.value("Content-Length").toULongLong(&bHasLength);
+
+	if( m_bTreeRequest )
+		return readTreeResponse(nCode, bHasLength, nLength);
+
+	const QString sAvailable = m_oResponse.value("X-Available-Ranges");
+	if( !sAvailable.isEmpty() )
+		parseAvailableRanges(sAvailable);
+
+	// X-Thex-URI: <path>;<root>
+	const QString sThex = m_oResponse.value("X-Thex-URI").split(';').first().trimmed();
+	if( sThex.startsWith('/') )
+		m_sTigerTreePath = sThex.toLatin1();
+
+	if( nCode == 200 || nCode == 206 )
+	{
+		quint64 nFrom = 0, nTo = bHasLength ? nLength : m_pOwner->m_nSize, nTotal = m_pOwner->m_nSize;
+
+		if( nCode == 206 )
+		{
+			QRegExp rxRange("bytes[ =]?\\s*(\\d+)-(\\d+)/(\\d+|\\*)");
+
+			if( rxRange.indexIn(m_oResponse.value("Content-Range")) < 0 )
+			{
+				systemLog.postLog( LogSeverity::Error, Components::Downloads,
+				                   "Download source %s sent 206 without a valid Content-Range",
+				                   qPrintable( m_oAddress.toStringWithPort() ) );
+				finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+				return false;
+			}
+
+			nFrom = rxRange.cap(1).toULongLong();
+			nTo = rxRange.cap(2).toULongLong() + 1;
+			if( rxRange.cap(3) != "*" )
+				nTotal = rxRange.cap(3).toULongLong();
+		}
+
+		if( nTotal != m_pOwner->m_nSize || nFrom >= nTo || nTo > nTotal || (bHasLength && nLength != nTo - nFrom) )
+		{
+			systemLog.postLog( LogSeverity::Error, Components::Downloads,
+			                   "Download source %s sent an invalid range",
+			                   qPrintable( m_oAddress.toStringWithPort() ) );
+			finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+			return false;
+		}
+
+		if( nCode == 206 )
+		{
+			// responses come in request order; anything else would be credited to the wrong request
+			QMutexLocker t(&Transfers.m_pSection);
+			const bool bExpected = !m_lRequested.empty() && m_lRequested.begin()->begin() == nFrom
+								   && nTo <= m_lRequested.begin()->end();
+			t.unlock();
+
+			if( !bExpected )
+			{
+				systemLog.postLog( LogSeverity::Error, Components::Downloads,
+				                   "Download source %s sent a range that was not requested",
+				                   qPrintable( m_oAddress.toStringWithPort() ) );
+				finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+				return false;
+			}
+		}
+
+		m_bPipelining = (m_bKeepAlive && nCode == 206);
+		m_bDiscardContent = false;
+		m_nContentOffset = nFrom;
+		m_nContentLength = nTo - nFrom;
+		m_nQueuePos = m_nQueueLength = 0;
+		m_nState = dtsDownloading;
+
+		// top up the pipeline while this body streams in
+		if( m_bPipelining )
+			sendRequests();
+
+		return true;
+	}
+
+	// anything else carries no file data
+	m_bDiscardContent = true;
+	m_nContentLength = bHasLength ? nLength : 0;
+
+	if( nCode == 503 )
+	{
+		const QString sQueue = m_oResponse.value("X-Queue");
+
+		if( !sQueue.isEmpty() && m_bKeepAlive && !m_bPipelining )
+		{
+			parseQueue(sQueue);
+
+			if( quazaaSettings.Downloads.QueueLimit > 0 && m_nQueueLength > (quint32)quazaaSettings.Downloads.QueueLimit )
+			{
+				systemLog.postLog( LogSeverity::Information, Components::Downloads,
+				                   "Queue on download source %s is too long (%u)",
+				                   qPrintable( m_oAddress.toStringWithPort() ), m_nQueueLength );
+				finish(false, quazaaSettings.Downloads.RetryDelay / 1000);
+				return false;
+			}
+
+			systemLog.postLog( LogSeverity::Information, Components::Downloads,
+			                   "Queued on download source %s, position %u of %u",
+			                   qPrintable( m_oAddress.toStringWithPort() ), m_nQueuePos, m_nQueueLength );
+
+			// don't hold ranges other sources could serve while we wait
+			QMutexLocker l(&Downloads.m_pSection);
+			QMutexLocker t(&Transfers.m_pSection);
+			releaseRequests();
+			t.unlock();
+			l.unlock();
+
+			m_nState = dtsQueued;
+			return true;
+		}
+
+		quint32 nRetryAfter = m_oResponse.value("Retry-After").toUInt();
+		if( nRetryAfter == 0 )
+			nRetryAfter = quazaaSettings.Downloads.RetryDelay / 1000;
+
+		systemLog.postLog( LogSeverity::Information, Components::Downloads,
+		                   "Download source %s is busy, retrying in %u seconds",
+		                   qPrintable( m_oAddress.toStringWithPort() ), nRetryAfter );
+		finish(false, nRetryAfter);
+		return false;
+	}
+
+	if( nCode == 416 )
+	{
+		// the source lacks the range we asked for; mark it unavailable unless X-Available-Ranges already told us
+		QMutexLocker l(&Downloads.m_pSection);
+		QMutexLocker t(&Transfers.m_pSection);
+
+		if( !m_lRequested.empty() && sAvailable.isEmpty() )
+		{
+			Fragments::List oAvailable(m_pSource->m_lAvailableFrags);
+
+			if( oAvailable.empty() )
+				oAvailable.insert(Fragments::Fragment(0, m_pOwner->m_nSize));
+
+			oAvailable.erase(*m_lRequested.begin());
+			m_pOwner->setAvailableFragments(m_pSource, oAvailable);
+		}
+
+		t.unlock();
+		l.unlock();
+
+		if( m_nContentLength == 0 )
+			endResponse();
+
+		return true;
+	}
+
+	systemLog.postLog( LogSeverity::Information, Components::Downloads,
+	                   "Download source %s responded with %s",
+	                   qPrintable( m_oAddress.toStringWithPort() ),
+	                   m_oResponse.startLine().constData() );
+
+	if( nCode == 404 || nCode == 410 )
+	{
+		// the file is gone from this source, no point in retrying
+		QMutexLocker l(&Downloads.m_pSection);
+		m_pSource->m_nFailures = quazaaSettings.Downloads.MaxAllowedFailures;
+	}
+
+	finish(true, quazaaSettings.Downloads.RetryDelay / 1000);
+	return false;
+}
+
+bool CDownloadTransferHTTP::readTreeResponse(int nCode, bool bHasLength, quint64 nLength)
+{
+	m_bDiscardContent = true;
+	m_nContentLength = bHasLength ? nLength : 0;
+	m_baTigerTree.clear();
+	m_bTreeContent = (nCode == 200 && bHasLength && nLength > 0 && nLength <= HTTPMaxTreeSize);
+
+	if( !m_bTreeContent )
+	{
+		systemLog.postLog( LogSeverity::Debug, Components::Downloads,
+		                   "Download source %s did not send its Tiger tree: %s",
+		                   qPrintable( m_oAddress.toStringWithPort() ),
+		                   m_oResponse.startLine().constData() );
+		m_sTigerTreePath.clear();
+	}
+
+	// a body without a length runs up to the end of the connection
+	if( !bHasLength )
+		m_bKeepAlive = false;
+
+	if( m_nContentLength == 0 )
+		endResponse();
+
+	return true;
+}
+
+bool CDownloadTransferHTTP::readContent()
+{
+	CBuffer* pInput = getInputBuffer();
+
+	if( pInput->isEmpty() )
+		return false;
+
+	const quint32 nLength = quint32(qMin<quint64>(pInput->size(), m_nContentLength));
+
+	if( !m_bDiscardContent )
+	{
+		QMutexLocker l(&Downloads.m_pSection);
+
+		if( !m_pOwner->writeData(m_nContentOffset, pInput->data(), nLength) )
+		{
+			l.unlock();
+			finish(false, quazaaSettings.Downloads.RetryDelay / 1000);
+			return false;
+		}
+
+		m_pSource->addDownloadedFragment(m_nContentOffset, nLength);
+		m_nReceived += nLength;
+	}
+	else if( m_bTreeContent )
+	{
+		m_baTigerTree.append(pInput->data(), nLength);
+	}
+
+	pInput->remove(nLength);
+	m_nContentOffset += nLength;
+	m_nContentLength -= nLength;
+	m_tLastResponse = time(0);
+
+	if( m_nContentLength == 0 )
+		endResponse();
+
+	return true;
+}
+
+void CDownloadTransferHTTP::endResponse()
+{
+	if( m_nState == dtsQueued )
+		return; // onTimer() polls again when the server asked us to
+
+	if( m_bTreeRequest )
+	{
+		endTreeResponse();
+	}
+	else
+	{
+		Downloads.m_pSection.lock();
+		Transfers.m_pSection.lock();
+		releaseFirstRequest();
+		Transfers.m_pSection.unlock();
+		Downloads.m_pSection.unlock();
+	}
+
+	if( !m_bKeepAlive )
+	{
+		// the source is free again right away, the next download tick reconnects
+		finish(false, 0);
+		return;
+	}
+
+	m_nState = dtsRequesting;
+	sendRequests();
+}
+
+// Hands the received tree to the download; a tree that doesn't match is not asked for again.
+void CDownloadTransferHTTP::endTreeResponse()
+{
+	m_bTreeRequest = false;
+
+	QMutexLocker l(&Downloads.m_pSection);
+
+	m_pOwner->releaseTigerTree(this);
+
+	if( m_bTreeContent && !m_pOwner->tigerTree().isValid() )
+	{
+		CTigerTree oTree;
+		const CHash oRoot = m_pOwner->tigerRoot();
+		bool bOk;
+
+		if( m_oResponse.value("Content-Type").contains("dime", Qt::CaseInsensitive) )
+			bOk = oTree.fromDIME(m_pOwner->m_nSize, oRoot, m_baTigerTree);
+		else
+			bOk = oTree.fromBreadthFirst(m_pOwner->m_nSize, oRoot, m_baTigerTree);
+
+		if( !bOk || !m_pOwner->setTigerTree(oTree) )
+		{
+			systemLog.postLog( LogSeverity::Warning, Components::Downloads,
+			                   "Download source %s sent a Tiger tree that does not match the file",
+			                   qPrintable( m_oAddress.toStringWithPort() ) );
+			m_sTigerTreePath.clear();
+			m_pSource->m_nFailures++;
+		}
+	}
+
+	m_bTreeContent = false;
+	m_baTigerTree.clear();
+}
+
+void CDownloadTransferHTTP::finish(bool bFailed, quint32 nRetryAfter)
+{
+	if( m_nState == dtsNull )
+		return;
+
+	// dtsNull tells the download to reap this transfer on its next tick
+	m_nState = dtsNull;
+	m_nContentLength = 0;
+
+	Downloads.m_pSection.lock();
+	if( bFailed )
+		m_pSource->m_nFailures++;
+	else if( m_nReceived > 0 )
+		m_pSource->m_nFailures = 0;
+	m_pSource->m_tNextAccess = time(0) + nRetryAfter;
+
+	Transfers.m_pSection.lock();
+	releaseRequests();
+	Transfers.m_pSection.unlock();
+	Downloads.m_pSection.unlock();
+
+	if( m_bConnected )
+		close();
+}
+
+void CDownloadTransferHTTP::parseAvailableRanges(const QString& sValue)
+{
+	// X-Available-Ranges: bytes 0-1023,4096-8191 (inclusive ends)
+	QString sRanges = sValue.trimmed();
+	if( sRanges.startsWith("bytes", Qt::CaseInsensitive) )
+		sRanges = sRanges.mid(5);
+	if( sRanges.startsWith('=') )
+		sRanges = sRanges.mid(1);
+
+	Fragments::List oAvailable(m_pOwner->m_nSize);
+
+	foreach( const QString& sRange, sRanges.split(',', QString::SkipEmptyParts) )
+	{
+		const int nDash = sRange.indexOf('-');
+		if( nDash <= 0 )
+			continue;
+
+		bool bFrom = false, bTo = false;
+		const quint64 nFrom = sRange.left(nDash).trimmed().toULongLong(&bFrom);
+		const quint64 nTo = sRange.mid(nDash + 1).trimmed().toULongLong(&bTo) + 1;
+
+		if( bFrom && bTo && nFrom < nTo && nFrom < m_pOwner->m_nSize )
+			oAvailable.insert(Fragments::Fragment(nFrom, qMin(nTo, m_pOwner->m_nSize)));
+	}
+
+	QMutexLocker l(&Downloads.m_pSection);
+	m_pOwner->setAvailableFragments(m_pSource, oAvailable);
+}
+
+void CDownloadTransferHTTP::parseQueue(const QString& sValue)
+{
+	// X-Queue: position=2,length=10,limit=4,pollMin=45,pollMax=120,id="name"
+	quint32 nPollMin = quazaaSettings.Connection.TimeoutConnect;
+
+	foreach( const QString& sPart, sValue.split(',', QString::SkipEmptyParts) )
+	{
+		const int nEquals = sPart.indexOf('=');
+		if( nEquals <= 0 )
+			continue;
+
+		const QString sKey = sPart.left(nEquals).trimmed().toLower();
+		const QString sPartValue = sPart.mid(nEquals + 1).trimmed();
+
+		if( sKey == "position" )
+			m_nQueuePos = sPartValue.toUInt();
+		else if( sKey == "length" )
+			m_nQueueLength = sPartValue.toUInt();
+		else if( sKey == "pollmin" )
+			nPollMin = qMax(nPollMin, sPartValue.toUInt());
+		else if( sKey == "id" )
+			m_sQueueName = QString(sPartValue).remove('"');
+	}
+
+	// polling before pollMin gets us dropped from the queue
+	m_tRequestAgain = time(0) + nPollMin + 1;
+}
+
+quint64 CDownloadTransferHTTP::requestSize()
+{
+	const quint64 nStrap = quazaaSettings.Downloads.ChunkStrap;
+
+	if( !m_bPipelining )
+		return nStrap;
+
+	// big enough to cover a few seconds at the rate this source actually delivers
+	const quint64 nSize = quint64(m_mInput.AvgUsage()) * HTTPRequestWindow;
+
+	return qBound(nStrap, nSize, qMax(nStrap, quint64(quazaaSettings.Downloads.ChunkSize) * 4));
+}
+
+quint64 CDownloadTransferHTTP::requestedBytes() const
+{
+	quint64 nBytes = 0;
+
+	for( Fragments::Queue::const_iterator it = m_lRequested.begin(); it != m_lRequested.end(); ++it )
+		nBytes += it->size();
+
+	return nBytes;
+}
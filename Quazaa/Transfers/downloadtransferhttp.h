@@ -0,0 +1,87 @@
+/*
+** downloadtransferhttp.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef DOWNLOADTRANSFERHTTP_H
+#define DOWNLOADTRANSFERHTTP_H
+
+#include "downloadtransfer.h"
+#include "headerparser.h"
+
+#include <QAbstractSocket>
+
+// HTTP/1.1 download transfer (Gnutella flavour).
+// Keeps the connection alive and, once the server has answered a range request
+// with 206, pipelines further range requests so the link never idles between chunks.
+// If the download still lacks its Tiger tree and the server named one in X-Thex-URI,
+// the tree is fetched on the same connection between two range requests.
+class CDownloadTransferHTTP : public CDownloadTransfer
+{
+	Q_OBJECT
+protected:
+	QByteArray	m_sRequestPath;		// /uri-res/N2R?urn:... or path taken from the source URL
+	bool		m_bKeepAlive;		// server keeps the connection open after a response
+	bool		m_bPipelining;		// server answered a range request on this connection
+	bool		m_bDiscardContent;	// current response body is not file data
+	quint64		m_nContentOffset;	// file offset of the next body byte
+	quint64		m_nContentLength;	// body bytes left in the current response
+	quint32		m_tRequestAgain;	// when to poll again while queued
+	quint64		m_nReceived;		// file bytes received on this connection
+	CHeaderParser	m_oResponse;		// response header being received
+	QByteArray	m_sTigerTreePath;	// from X-Thex-URI, cleared if the tree turned out unusable
+	bool		m_bTreeRequest;		// the request in flight is for the tree
+	bool		m_bTreeContent;		// current response body is the tree
+	QByteArray	m_baTigerTree;		// tree received so far
+
+public:
+	CDownloadTransferHTTP(CDownload* pOwner, CDownloadSource* pSource, QObject* parent = 0);
+	virtual ~CDownloadTransferHTTP();
+
+	virtual void connectTo(CEndPoint oAddress);
+	virtual void onTimer(quint32 tNow = 0);
+	virtual void requestBlock(Fragments::Fragment oFragment);
+
+public slots:
+	void onConnectNode();
+	void onDisconnectNode();
+	void onRead();
+	void onError(QAbstractSocket::SocketError e);
+
+	void sendRequests();
+
+protected:
+	bool readResponse();
+	bool readTreeResponse(int nCode, bool bHasLength, quint64 nLength);
+	bool readContent();
+	void endResponse();
+	void endTreeResponse();
+	void requestTigerTree();
+	void finish(bool bFailed, quint32 nRetryAfter);
+
+	void parseAvailableRanges(const QString& sValue);
+	void parseQueue(const QString& sValue);
+	quint64 requestSize();
+	quint64 requestedBytes() const;
+};
+
+#endif // DOWNLOADTRANSFERHTTP_H
@@ -0,0 +1,222 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "downloadverifier.h"
+#include "thread.h"
+
+#include <QFile>
+#include <QMutexLocker>
+
+#include <string.h>
+
+#include "debug_new.h"
+
+CThread DownloadVerifyThread;
+static QMutex DownloadVerifySection;
+
+CDownloadVerifier::CDownloadVerifier(const QString& sFileName, const CTigerTree& oTree) :
+	QObject(0),
+	m_sFileName(sFileName),
+	m_oTree(oTree),
+	m_lVerified(oTree.blockCount()),
+	m_pFile(0),
+	m_nHashed(0),
+	m_nReadBack(0)
+{
+}
+
+CDownloadVerifier::~CDownloadVerifier()
+{
+	qDeleteAll(m_lBlocks);
+	delete m_pFile;
+}
+
+void CDownloadVerifier::startThread()
+{
+	QMutexLocker l(&DownloadVerifySection);
+
+	if( !DownloadVerifyThread.isRunning() )
+		DownloadVerifyThread.start("Download verification", &DownloadVerifySection);
+}
+
+void CDownloadVerifier::stopThread()
+{
+	QMutexLocker l(&DownloadVerifySection);
+
+	if( DownloadVerifyThread.isRunning() )
+		DownloadVerifyThread.exit(0);
+}
+
+// Data the storage has just synced to the file.
+void CDownloadVerifier::addData(quint64 nOffset, QByteArray baData)
+{
+	const char* pData = baData.constData();
+	quint64 nLength = (nOffset < m_oTree.size()) ? qMin<quint64>(baData.size(), m_oTree.size() - nOffset) : 0;
+
+	while( nLength > 0 )
+	{
+		const quint32 nBlock = quint32(nOffset / m_oTree.blockSize());
+		const Fragments::Fragment oRange = blockRange(nBlock);
+		const quint64 nBegin = nOffset - oRange.begin();
+		const quint64 nPiece = qMin(nLength, oRange.end() - nOffset);
+
+		Block* pBlock = block(nBlock);
+		pBlock->lCovered.insert(Fragments::Fragment(nBegin, nBegin + nPiece));
+
+		// Only data that continues the hashed part exactly can be streamed; anything else,
+		// duplicates included, may not be what ends up in the file.
+		if( pBlock->bStreaming && nBegin == pBlock->nHashed )
+		{
+			pBlock->oHasher.addData(pData, quint32(nPiece));
+			pBlock->nHashed += nPiece;
+			m_nHashed += nPiece;
+		}
+		else
+		{
+			pBlock->bStreaming = false;
+		}
+
+		if( pBlock->lCovered.missing() == 0 )
+			checkBlock(nBlock, pBlock);
+
+		nOffset += nPiece;
+		pData += nPiece;
+		nLength -= nPiece;
+	}
+}
+
+// Data that was on disk before the verifier was created; read back once its blocks are covered.
+void CDownloadVerifier::addCompleted(quint64 nBegin, quint64 nEnd)
+{
+	nEnd = qMin(nEnd, m_oTree.size());
+
+	while( nBegin < nEnd )
+	{
+		const quint32 nBlock = quint32(nBegin / m_oTree.blockSize());
+		const Fragments::Fragment oRange = blockRange(nBlock);
+		const quint64 nPieceEnd = qMin(nEnd, oRange.end());
+
+		Block* pBlock = block(nBlock);
+		pBlock->lCovered.insert(Fragments::Fragment(nBegin - oRange.begin(), nPieceEnd - oRange.begin()));
+		pBlock->bStreaming = false;
+
+		if( pBlock->lCovered.missing() == 0 )
+			checkBlock(nBlock, pBlock);
+
+		nBegin = nPieceEnd;
+	}
+}
+
+CDownloadVerifier::Block* CDownloadVerifier::block(quint32 nBlock)
+{
+	Block* pBlock = m_lBlocks.value(nBlock);
+
+	if( !pBlock )
+	{
+		pBlock = new Block(blockRange(nBlock).size());
+		m_lBlocks.insert(nBlock, pBlock);
+
+		// data written over a block that checked out already has to be checked again
+		if( m_lVerified.testBit(nBlock) )
+		{
+			m_lVerified.clearBit(nBlock);
+			pBlock->lCovered.insert(Fragments::Fragment(0, blockRange(nBlock).size()));
+			pBlock->bStreaming = false;
+		}
+	}
+
+	return pBlock;
+}
+
+void CDownloadVerifier::checkBlock(quint32 nBlock, Block* pBlock)
+{
+	char pHash[CTiger::DigestSize];
+	bool bValid = false;
+
+	if( pBlock->bStreaming )
+	{
+		if( pBlock->oHasher.finish() )
+		{
+			memcpy(pHash, pBlock->oHasher.root().rawData(), CTiger::DigestSize);
+			bValid = true;
+		}
+	}
+	else
+	{
+		bValid = readBlock(nBlock, pHash);
+	}
+
+	bValid = bValid && memcmp(pHash, m_oTree.blockHash(nBlock), CTiger::DigestSize) == 0;
+
+	m_lBlocks.remove(nBlock);
+	delete pBlock;
+
+	m_lVerified.setBit(nBlock, bValid);
+	emit blockVerified(nBlock, bValid);
+}
+
+bool CDownloadVerifier::readBlock(quint32 nBlock, char* pHash)
+{
+	if( !m_pFile )
+	{
+		m_pFile = new QFile(m_sFileName);
+
+		if( !m_pFile->open(QFile::ReadOnly) )
+		{
+			systemLog.postLog( LogSeverity::Warning, Components::Downloads,
+			                   "Cannot read back %s for verification: %s",
+			                   qPrintable( m_sFileName ), qPrintable( m_pFile->errorString() ) );
+			delete m_pFile;
+			m_pFile = 0;
+			return false;
+		}
+	}
+
+	const Fragments::Fragment oRange = blockRange(nBlock);
+	QByteArray baBlock;
+
+	if( m_pFile->seek(oRange.begin()) )
+		baBlock = m_pFile->read(oRange.size());
+
+	if( quint64(baBlock.size()) != oRange.size() )
+	{
+		systemLog.postLog( LogSeverity::Warning, Components::Downloads,
+		                   "Cannot read back %s for verification: %s",
+		                   qPrintable( m_sFileName ), qPrintable( m_pFile->errorString() ) );
+		return false;
+	}
+
+	CTigerTree::hashBlock(baBlock.constData(), baBlock.size(), pHash);
+	m_nHashed += oRange.size();
+	m_nReadBack += oRange.size();
+
+	return true;
+}
+
+Fragments::Fragment CDownloadVerifier::blockRange(quint32 nBlock) const
+{
+	const quint64 nBegin = quint64(nBlock) * m_oTree.blockSize();
+
+	return Fragments::Fragment(nBegin, qMin(nBegin + m_oTree.blockSize(), m_oTree.size()));
+}
@@ -0,0 +1,102 @@
+/*
+** downloadverifier.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef DOWNLOADVERIFIER_H
+#define DOWNLOADVERIFIER_H
+
+#include "types.h"
+#include "FileFragments.hpp"
+#include "Hashes/tigertree.h"
+
+#include <QBitArray>
+#include <QHash>
+
+class CThread;
+class QFile;
+
+// Checks a download against its Tiger tree one block at a time, as the data reaches the disk.
+// Lives on DownloadVerifyThread. The storage passes on every run it has synced (addData());
+// a block whose data comes in order is hashed on the fly, one that arrives with gaps is read
+// back from the incomplete file once it is covered. Every check ends in blockVerified(); a
+// block is checked again if data is written over it, and after a failure it starts over.
+class CDownloadVerifier : public QObject
+{
+	Q_OBJECT
+
+protected:
+	struct Block
+	{
+		Block(quint64 nLength) : nHashed(0), bStreaming(true), oHasher(nLength), lCovered(nLength) {}
+
+		quint64			nHashed;	// bytes from the block start fed to oHasher
+		bool			bStreaming;	// false once data arrived past nHashed
+		CTigerTree		oHasher;
+		Fragments::List	lCovered;	// block relative
+	};
+
+	QString				m_sFileName;
+	CTigerTree			m_oTree;
+	QHash<quint32, Block*> m_lBlocks;	// blocks with some data, not checked yet
+	QBitArray			m_lVerified;
+	QFile*				m_pFile;		// opened for the first block that has to be read back
+
+	quint64				m_nHashed;		// bytes hashed, streamed or read back
+	quint64				m_nReadBack;	// of those, bytes read from the file
+
+public:
+	CDownloadVerifier(const QString& sFileName, const CTigerTree& oTree);
+	~CDownloadVerifier();
+
+	inline quint64 hashedBytes() const;
+	inline quint64 readBackBytes() const;
+
+	static void startThread();
+	static void stopThread();
+
+public slots:
+	void addData(quint64 nOffset, QByteArray baData);
+	void addCompleted(quint64 nBegin, quint64 nEnd);
+
+signals:
+	void blockVerified(quint32 nBlock, bool bValid);
+
+protected:
+	Block* block(quint32 nBlock);
+	void checkBlock(quint32 nBlock, Block* pBlock);
+	bool readBlock(quint32 nBlock, char* pHash);
+	Fragments::Fragment blockRange(quint32 nBlock) const;
+};
+
+quint64 CDownloadVerifier::hashedBytes() const
+{
+	return m_nHashed;
+}
+quint64 CDownloadVerifier::readBackBytes() const
+{
+	return m_nReadBack;
+}
+
+extern CThread DownloadVerifyThread;
+
+#endif // DOWNLOADVERIFIER_H
@@ -31,8 +31,7 @@ CTransfer::CTransfer(void* pOwner, QObject *parent) :
 	CNetworkConnection(parent),
 	m_pOwner(pOwner)
 {
-	ASSUME_LOCK(Transfers.m_pSection);
-	Transfers.add(this);
+	// registered with Transfers by the creator, once the socket exists
 }
 
 CTransfer::~CTransfer()
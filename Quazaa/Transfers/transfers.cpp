@@ -26,6 +26,8 @@
 #include "ratecontroller.h"
 #include "transfer.h"
 #include "downloads.h"
+#include "uploads.h"
+#include "quazaasettings.h"
 
 #include <QMutexLocker>
 
@@ -38,7 +40,7 @@ CTransfers::CTransfers(QObject* parent)
 	: QObject(parent),
 	  m_bActive(false)
 {
-	m_pController = new CRateController(&m_pSection);
+	m_pController = new CRateController(&m_pSection, rcTransfers);
 }
 
 CTransfers::~CTransfers()
@@ -54,10 +56,17 @@ void CTransfers::start()
 	systemLog.postLog(LogSeverity::Notice, qPrintable(tr("Starting transfers...")));
 
 	m_bActive = true;
+
+	// Transfers are guaranteed the part of the link neighbours do not reserve
+	BandwidthPool.setLimits(quazaaSettings.Connection.InSpeed, quazaaSettings.Connection.OutSpeed);
+	m_pController->setDownloadLimit(quazaaSettings.Connection.InSpeed * 3 / 4);
+	m_pController->setUploadLimit(quazaaSettings.Connection.OutSpeed * 3 / 4);
+
 	TransfersThread.start("Transfers", &m_pSection);
 	m_pController->moveToThread(&TransfersThread);
 	Downloads.start();
 	Downloads.moveToThread(&TransfersThread);
+	Uploads.start();
 
 	connect(&m_oTimer, SIGNAL(timeout()), this, SLOT(onTimer()));
 	connect(&m_oTimer, SIGNAL(timeout()), &Downloads, SLOT(onTimer()));
@@ -74,12 +83,13 @@ void CTransfers::stop()
 	m_bActive = false;
 
 	TransfersThread.exit(0);
+	Uploads.stop();
 	Downloads.stop();
 }
 
 void CTransfers::add(CTransfer *pTransfer)
 {
-	QMutexLocker l(&m_pSection);
+	ASSUME_LOCK(m_pSection);
 
 	Q_ASSERT_X(m_bActive, "CTransfers::add()", "Adding transfer while thread is inactive");
 
@@ -97,7 +107,7 @@ void CTransfers::add(CTransfer *pTransfer)
 
 void CTransfers::remove(CTransfer *pTransfer)
 {
-	QMutexLocker l(&m_pSection);
+	ASSUME_LOCK(m_pSection);
 
 	if(!m_lTransfers.contains(pTransfer->m_pOwner, pTransfer))
 	{
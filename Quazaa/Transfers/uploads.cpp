@@ -0,0 +1,161 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "uploads.h"
+#include "uploadtransferhttp.h"
+#include "transfers.h"
+
+#include "networkconnection.h"
+#include "quazaasettings.h"
+
+#include <QMutexLocker>
+
+#include "debug_new.h"
+
+CUploads Uploads;
+
+CUploads::CUploads(QObject* parent) :
+	QObject(parent),
+	m_bActive(false)
+{
+}
+
+void CUploads::start()
+{
+	QMutexLocker l(&m_pSection);
+
+	m_bActive = true;
+}
+
+void CUploads::stop()
+{
+	QMutexLocker l(&m_pSection);
+	QMutexLocker t(&Transfers.m_pSection);
+
+	m_bActive = false;
+
+	// each upload removes itself
+	while( !m_lUploads.isEmpty() )
+	{
+		delete m_lUploads.first();
+	}
+}
+
+void CUploads::onAccept(CNetworkConnection* pConn)
+{
+	QMutexLocker l(&m_pSection);
+	QMutexLocker t(&Transfers.m_pSection);
+
+	// Transfers stops its thread before it stops us
+	if( !m_bActive || !Transfers.m_bActive )
+	{
+		pConn->close();
+		return;
+	}
+
+	// the request is still in the input buffer and is parsed again by the upload
+	CUploadTransferHTTP* pUpload = new CUploadTransferHTTP();
+	pUpload->attachTo(pConn);
+	m_lUploads.append(pUpload);
+	Transfers.add(pUpload);
+	pUpload->moveToThread(&TransfersThread);
+
+	systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+	                   "Accepted upload connection from %s",
+	                   qPrintable( pUpload->address().toStringWithPort() ) );
+}
+
+void CUploads::remove(CUploadTransferHTTP* pUpload)
+{
+	ASSUME_LOCK(m_pSection);
+
+	releaseSlot(pUpload);
+	m_lUploads.removeAll(pUpload);
+}
+
+int CUploads::requestSlot(CUploadTransferHTTP* pUpload)
+{
+	ASSUME_LOCK(m_pSection);
+
+	if( m_lActive.contains(pUpload) )
+		return 0;
+
+	const int nFree = qMax(0, quazaaSettings.Uploads.MaxTransfers - m_lActive.size());
+	int nPosition = m_lQueue.indexOf(pUpload);
+
+	if( nPosition < 0 )
+	{
+		if( quazaaSettings.Uploads.MaxPerHost > 0 )
+		{
+			const QHostAddress oHost = pUpload->address();
+			int nFromHost = 0;
+
+			foreach( CUploadTransferHTTP* pOther, m_lActive + m_lQueue )
+			{
+				if( QHostAddress(pOther->address()) == oHost )
+					++nFromHost;
+			}
+
+			if( nFromHost >= quazaaSettings.Uploads.MaxPerHost )
+				return -1;
+		}
+
+		// those that are about to get the free slots don't count against the queue
+		if( m_lQueue.size() >= nFree + quazaaSettings.Uploads.MaxQueued )
+			return -1;
+
+		m_lQueue.append(pUpload);
+		nPosition = m_lQueue.size() - 1;
+	}
+
+	if( nPosition < nFree )
+	{
+		m_lQueue.removeAt(nPosition);
+		m_lActive.append(pUpload);
+		return 0;
+	}
+
+	return nPosition + 1;
+}
+
+void CUploads::releaseSlot(CUploadTransferHTTP* pUpload)
+{
+	ASSUME_LOCK(m_pSection);
+
+	m_lActive.removeAll(pUpload);
+	m_lQueue.removeAll(pUpload);
+}
+
+bool CUploads::isUploadRequest(const QByteArray& sRequestLine)
+{
+	QList<QByteArray> lRequest = sRequestLine.split(' ');
+	lRequest.removeAll(QByteArray());
+
+	if( lRequest.size() < 2 || (lRequest[0] != "GET" && lRequest[0] != "HEAD") )
+		return false;
+
+	const QByteArray& sPath = lRequest[1];
+
+	return sPath.startsWith("/uri-res/") || sPath.startsWith("/gnutella/thex/") || sPath.startsWith("/gnutella/tigertree/");
+}
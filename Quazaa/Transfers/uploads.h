@@ -0,0 +1,85 @@
+/*
+** uploads.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef UPLOADS_H
+#define UPLOADS_H
+
+#include <QObject>
+#include <QMutex>
+#include <QList>
+
+#include "types.h"
+
+class CNetworkConnection;
+class CUploadTransferHTTP;
+
+// Upload slots and the queue in front of them.
+// A connection keeps its slot from the request that got it until it closes, so a client
+// can fetch ranges back to back. Everyone else waits in order and is told their position
+// each time they poll; a freed slot goes to the head of the queue.
+class CUploads : public QObject
+{
+	Q_OBJECT
+public:
+	QMutex m_pSection;	// taken before Transfers.m_pSection
+
+protected:
+	bool m_bActive;
+	QList<CUploadTransferHTTP*> m_lUploads;	// every upload connection
+	QList<CUploadTransferHTTP*> m_lActive;	// connections holding a slot
+	QList<CUploadTransferHTTP*> m_lQueue;	// waiting for a slot, first in line first
+
+public:
+	CUploads(QObject* parent = 0);
+
+	void start();
+	void stop();
+
+	// Takes over an incoming connection whose first request is an upload request.
+	void onAccept(CNetworkConnection* pConn);
+	void remove(CUploadTransferHTTP* pUpload);
+
+	// 0 if the upload holds a slot, its queue position if it waits, or -1 if there is
+	// neither a slot nor room in the queue, or the host has enough uploads already.
+	int requestSlot(CUploadTransferHTTP* pUpload);
+	void releaseSlot(CUploadTransferHTTP* pUpload);
+
+	inline quint32 queueLength() const;
+	inline quint32 activeCount() const;
+
+	static bool isUploadRequest(const QByteArray& sRequestLine);
+};
+
+quint32 CUploads::queueLength() const
+{
+	return m_lQueue.size();
+}
+quint32 CUploads::activeCount() const
+{
+	return m_lActive.size();
+}
+
+extern CUploads Uploads;
+
+#endif // UPLOADS_H
@@ -0,0 +1,632 @@
+/*
+** $Id$
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "uploadtransferhttp.h"
+#include "uploads.h"
+#include "transfers.h"
+
+#include "sharemanager.h"
+#include "Hashes/tigertree.h"
+#include "quazaaglobals.h"
+#include "quazaasettings.h"
+
+#include <QRegExp>
+#include <QSocketNotifier>
+#include <QSqlRecord>
+#include <QTcpSocket>
+#include <QUrl>
+#include <QVariant>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <sys/sendfile.h>
+#endif
+
+#include "debug_new.h"
+
+static const quint32 HTTPMaxHeaderSize = 16384;		// drop clients that send a larger request header
+static const qint64  HTTPMaxPipelined  = 65536;		// request bytes a client may queue behind a response
+static const qint64  UploadChunkSize   = 65536;		// file data read at once without sendfile()
+static const qint64  UploadMaxBacklog  = 262144;	// file data left in the socket buffer without sendfile()
+
+static CHash tigerRoot(const QVector<CHash>& lHashes)
+{
+	foreach( const CHash& oHash, lHashes )
+	{
+		if( oHash.getAlgorithm() == CHash::TIGER )
+			return oHash;
+	}
+
+	return CHash();
+}
+
+CUploadTransferHTTP::CUploadTransferHTTP(QObject* parent) :
+	CTransfer(&Uploads, parent),
+	m_nState(usRequest),
+	m_oRequest(HTTPMaxHeaderSize),
+	m_bKeepAlive(false),
+	m_bHead(false),
+	m_tLastActivity(time(0)),
+	m_nQueuePos(0),
+	m_nFileID(0),
+	m_nFileSize(0),
+	m_nTreeDepth(0),
+	m_nBodyOffset(0),
+	m_nBodyLength(0),
+	m_nUploaded(0),
+	m_bZeroCopy(false),
+	m_pWriteNotifier(0)
+{
+}
+
+CUploadTransferHTTP::~CUploadTransferHTTP()
+{
+	ASSUME_LOCK(Uploads.m_pSection);
+
+	// the notifier watches the socket descriptor, it goes first
+	delete m_pWriteNotifier;
+	m_oFile.close();
+
+	Uploads.remove(this);
+}
+
+void CUploadTransferHTTP::onTimer(quint32 tNow)
+{
+	if( tNow == 0 )
+		tNow = time(0);
+
+	// called with Transfers.m_pSection held; close() only queues the work to our thread
+	const quint32 nTimeout = (m_nState == usQueued) ? quint32(quazaaSettings.Uploads.QueuePollMax) / 1000
+	                                                : quint32(quazaaSettings.Connection.TimeoutTraffic);
+
+	if( m_nState != usClosing && tNow - m_tLastActivity > nTimeout )
+	{
+		systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+		                   (m_nState == usQueued) ? "Queued upload client %s did not poll in time"
+		                                          : "Upload connection to %s timed out",
+		                   qPrintable( address().toStringWithPort() ) );
+		close();
+	}
+
+	CTransfer::onTimer(tNow);
+}
+
+bool CUploadTransferHTTP::hasData()
+{
+	if( !m_pSocket )
+		return false;
+
+	if( !getOutputBuffer()->isEmpty() || networkBytesAvailable() > 0 )
+		return true;
+
+	// requests queued up in the input buffer wait for the response in progress; while
+	// sendfile() waits for the socket the notifier brings us back
+	return m_nBodyLength > 0 && !(m_pWriteNotifier && m_pWriteNotifier->isEnabled());
+}
+
+void CUploadTransferHTTP::onConnectNode()
+{
+	// always incoming, handed over connected
+}
+
+void CUploadTransferHTTP::onDisconnectNode()
+{
+	systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+	                   "Upload connection to %s closed, %llu bytes sent",
+	                   qPrintable( address().toStringWithPort() ), m_nUploaded );
+
+	Uploads.m_pSection.lock();
+	Transfers.m_pSection.lock();
+	delete this;
+	Transfers.m_pSection.unlock();
+	Uploads.m_pSection.unlock();
+}
+
+void CUploadTransferHTTP::onRead()
+{
+	while( m_nState == usRequest || m_nState == usQueued )
+	{
+		if( !readRequest() )
+			break;
+	}
+
+	if( m_nState == usSending && getInputBuffer()->size() > HTTPMaxPipelined )
+	{
+		systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+		                   "Upload client %s pipelined too many requests",
+		                   qPrintable( address().toStringWithPort() ) );
+		finish();
+	}
+}
+
+void CUploadTransferHTTP::onError(QAbstractSocket::SocketError e)
+{
+	if( e != QAbstractSocket::RemoteHostClosedError )
+	{
+		systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+		                   "Upload connection to %s: %s",
+		                   qPrintable( address().toStringWithPort() ),
+		                   qPrintable( m_pSocket->errorString() ) );
+	}
+
+	onDisconnectNode();
+}
+
+void CUploadTransferHTTP::endResponse()
+{
+	if( m_nState != usSending )
+		return;
+
+	systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+	                   "Finished upload to %s", qPrintable( address().toStringWithPort() ) );
+
+	if( !m_bKeepAlive )
+	{
+		finish();
+		return;
+	}
+
+	m_nState = usRequest;
+	m_tLastActivity = time(0);
+
+	// the client may have pipelined its next request already
+	onRead();
+}
+
+void CUploadTransferHTTP::onSocketWritable()
+{
+	m_pWriteNotifier->setEnabled(false);
+	emit readyToTransfer();
+}
+
+qint64 CUploadTransferHTTP::writeToNetwork(qint64 nBytes)
+{
+	// the response header always goes out ahead of the body
+	qint64 nWritten = CTransfer::writeToNetwork(nBytes);
+
+	if( nWritten < 0 || m_nState != usSending || m_nBodyLength == 0 || nWritten >= nBytes )
+		return nWritten;
+
+	const qint64 nBody = writeBody(nBytes - nWritten);
+
+	if( nBody < 0 )
+	{
+		systemLog.postLog( LogSeverity::Error, Components::Uploads,
+		                   "Cannot read %s for upload to %s",
+		                   qPrintable( m_sFilePath ), qPrintable( address().toStringWithPort() ) );
+		m_bKeepAlive = false;
+		m_nBodyLength = 0;
+		QMetaObject::invokeMethod(this, "endResponse", Qt::QueuedConnection);
+		return nWritten;
+	}
+
+	if( m_nBodyLength == 0 )
+		QMetaObject::invokeMethod(this, "endResponse", Qt::QueuedConnection);
+
+	return nWritten + nBody;
+}
+
+qint64 CUploadTransferHTTP::writeBody(qint64 nBytes)
+{
+	nBytes = qMin<quint64>(nBytes, m_nBodyLength);
+	qint64 nSent = 0;
+
+#ifdef Q_OS_LINUX
+	if( m_bZeroCopy )
+	{
+		// sendfile() writes to the descriptor directly, past whatever Qt still buffers
+		if( m_pSocket->bytesToWrite() > 0 )
+		{
+			m_pSocket->flush();
+
+			if( m_pSocket->bytesToWrite() > 0 )
+				return 0;	// bytesWritten() brings us back
+		}
+
+		off_t nOffset = off_t(m_nBodyOffset);
+		nSent = ::sendfile(int(m_pSocket->socketDescriptor()), m_oFile.handle(), &nOffset, size_t(nBytes));
+
+		if( nSent < 0 && (errno == EAGAIN || errno == EINTR) )
+		{
+			if( !m_pWriteNotifier )
+			{
+				m_pWriteNotifier = new QSocketNotifier(m_pSocket->socketDescriptor(), QSocketNotifier::Write, this);
+				connect(m_pWriteNotifier, SIGNAL(activated(int)), this, SLOT(onSocketWritable()));
+			}
+
+			m_pWriteNotifier->setEnabled(true);
+			return 0;
+		}
+
+		if( nSent < 0 && (errno == EINVAL || errno == ENOSYS) )
+		{
+			// the file system does not support it, read the file instead
+			systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+			                   "sendfile() not available for %s", qPrintable( m_sFilePath ) );
+			m_bZeroCopy = false;
+			nSent = 0;
+		}
+		else if( nSent <= 0 )
+		{
+			return -1;	// read error, or the file got shorter
+		}
+	}
+#endif
+
+	if( !m_bZeroCopy )
+	{
+		const qint64 nRoom = UploadMaxBacklog - m_pSocket->bytesToWrite();
+
+		if( nRoom <= 0 )
+			return 0;
+
+		const qint64 nChunk = qMin(qMin(nBytes, UploadChunkSize), nRoom);
+
+		if( m_oFile.pos() != qint64(m_nBodyOffset) && !m_oFile.seek(m_nBodyOffset) )
+			return -1;
+
+		m_baChunk.resize(nChunk);
+		const qint64 nRead = m_oFile.read(m_baChunk.data(), nChunk);
+
+		if( nRead <= 0 )
+			return -1;
+
+		nSent = m_pSocket->write(m_baChunk.constData(), nRead);
+
+		if( nSent <= 0 )
+			return -1;
+	}
+
+	m_nBodyOffset += nSent;
+	m_nBodyLength -= nSent;
+	m_nUploaded += nSent;
+	m_mOutput.Add(nSent);
+	m_tLastActivity = time(0);
+
+	return nSent;
+}
+
+bool CUploadTransferHTTP::readRequest()
+{
+	CBuffer* pInput = getInputBuffer();
+
+	if( m_oRequest.state() != CHeaderParser::hsIncomplete )
+		m_oRequest.reset();
+
+	const CHeaderParser::State nState = m_oRequest.parse(pInput);
+
+	if( nState == CHeaderParser::hsIncomplete )
+		return false;
+
+	if( nState != CHeaderParser::hsComplete )
+	{
+		systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+		                   "Upload client %s sent a malformed or oversized request",
+		                   qPrintable( address().toStringWithPort() ) );
+		m_bKeepAlive = false;
+		sendError("400 Bad Request");
+		return false;
+	}
+
+	pInput->remove(m_oRequest.length());
+	m_tLastActivity = time(0);
+
+	QList<QByteArray> lRequest = m_oRequest.startLine().split(' ');
+	lRequest.removeAll(QByteArray());
+
+	if( lRequest.size() != 3 || !lRequest[2].startsWith("HTTP/") )
+	{
+		m_bKeepAlive = false;
+		sendError("400 Bad Request");
+		return false;
+	}
+
+	const QString sConnection = m_oRequest.value("Connection");
+
+	if( lRequest[2] == "HTTP/1.0" )
+		m_bKeepAlive = (sConnection.compare("Keep-Alive", Qt::CaseInsensitive) == 0);
+	else
+		m_bKeepAlive = (sConnection.compare("close", Qt::CaseInsensitive) != 0);
+
+	m_bHead = (lRequest[0] == "HEAD");
+
+	systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+	                   "Upload request from %s: %s",
+	                   qPrintable( address().toStringWithPort() ), lRequest[1].constData() );
+
+	if( !m_bHead && lRequest[0] != "GET" )
+	{
+		sendError("501 Not Implemented");
+		return true;
+	}
+
+	const QByteArray sPath = QUrl::fromPercentEncoding(lRequest[1]).toLatin1();
+
+	if( sPath.startsWith("/uri-res/N2R?") )
+		return requestFile(CHash::fromURN(QString::fromLatin1(sPath.mid(13))));
+
+	if( sPath.startsWith("/gnutella/thex/v1?") || sPath.startsWith("/gnutella/tigertree/v3?") )
+		return requestTigerTree(sPath);
+
+	sendError("404 Not Found");
+	return true;
+}
+
+bool CUploadTransferHTTP::requestFile(const CHash& oHash)
+{
+	if( oHash.isNull() || !findFile(oHash) )
+	{
+		sendError("404 Not Found");
+		return true;
+	}
+
+	if( !m_bHead )
+	{
+		Uploads.m_pSection.lock();
+
+		m_nQueuePos = Uploads.requestSlot(this);
+		const quint32 nQueueLength = Uploads.queueLength();
+
+		// only clients that announced queue support and stay connected wait in line
+		if( m_nQueuePos > 0 && (!m_bKeepAlive || !m_oRequest.contains("X-Queue")) )
+		{
+			Uploads.releaseSlot(this);
+			m_nQueuePos = -1;
+		}
+
+		Uploads.m_pSection.unlock();
+
+		if( m_nQueuePos < 0 )
+		{
+			systemLog.postLog( LogSeverity::Debug, Components::Uploads,
+			                   "No upload slot for %s", qPrintable( address().toStringWithPort() ) );
+			m_bKeepAlive = false;
+			sendError("503 Busy", "Retry-After: " + QByteArray::number(quazaaSettings.Uploads.QueuePollMax / 1000) + "\r\n");
+			return true;
+		}
+
+		if( m_nQueuePos > 0 )
+		{
+			QByteArray sQueue = "X-Queue: position=" + QByteArray::number(m_nQueuePos);
+			sQueue += ",length=" + QByteArray::number(nQueueLength);
+			sQueue += ",limit=" + QByteArray::number(quazaaSettings.Uploads.MaxTransfers);
+			sQueue += ",pollMin=" + QByteArray::number(quazaaSettings.Uploads.QueuePollMin / 1000);
+			sQueue += ",pollMax=" + QByteArray::number(quazaaSettings.Uploads.QueuePollMax / 1000) + "\r\n";
+
+			sendError("503 Busy Queued", sQueue);
+			m_nState = usQueued;
+			return true;
+		}
+	}
+
+	// first range only; multipart responses are not worth it for P2P clients
+	quint64 nFrom = 0, nTo = m_nFileSize;
+	bool bRange = false;
+	QRegExp rxRange("bytes\\s*=\\s*(\\d*)\\s*-\\s*(\\d*)");
+
+	if( rxRange.indexIn(m_oRequest.value("Range")) >= 0 && !(rxRange.cap(1).isEmpty() && rxRange.cap(2).isEmpty()) )
+	{
+		bRange = true;
+
+		if( rxRange.cap(1).isEmpty() )
+		{
+			// suffix range, the last n bytes
+			nFrom = m_nFileSize - qMin<quint64>(rxRange.cap(2).toULongLong(), m_nFileSize);
+		}
+		else
+		{
+			nFrom = rxRange.cap(1).toULongLong();
+
+			if( !rxRange.cap(2).isEmpty() )
+				nTo = qMin<quint64>(rxRange.cap(2).toULongLong() + 1, m_nFileSize);
+		}
+
+		if( nFrom >= nTo )
+		{
+			sendError("416 Requested Range Not Satisfiable", "Content-Range: bytes */" + QByteArray::number(m_nFileSize) + "\r\n");
+			return true;
+		}
+	}
+
+	if( !m_oFile.isOpen() || m_oFile.fileName() != m_sFilePath )
+	{
+		m_oFile.close();
+		m_oFile.setFileName(m_sFilePath);
+
+		if( !m_oFile.open(QIODevice::ReadOnly | QIODevice::Unbuffered) || quint64(m_oFile.size()) != m_nFileSize )
+		{
+			systemLog.postLog( LogSeverity::Warning, Components::Uploads,
+			                   "Cannot open shared file %s", qPrintable( m_sFilePath ) );
+			m_oFile.close();
+			m_nFileID = 0;	// look it up again next time
+			sendError("404 Not Found");
+			return true;
+		}
+	}
+
+	QByteArray sHeaders = "Content-Type: application/binary\r\nAccept-Ranges: bytes\r\n";
+
+	if( bRange )
+	{
+		sHeaders += "Content-Range: bytes " + QByteArray::number(nFrom) + "-" + QByteArray::number(nTo - 1)
+		          + "/" + QByteArray::number(m_nFileSize) + "\r\n";
+	}
+
+	foreach( const CHash& oFileHash, m_lFileHashes )
+	{
+		sHeaders += "X-Content-URN: " + oFileHash.toURN().toLatin1() + "\r\n";
+	}
+
+	const CHash oRoot = tigerRoot(m_lFileHashes);
+
+	if( quazaaSettings.Uploads.ShareTiger && !oRoot.isNull() && m_nTreeDepth > 0 )
+	{
+		const QByteArray sRoot = oRoot.toString().toLatin1();
+		sHeaders += "X-Thex-URI: /gnutella/thex/v1?urn:tree:tiger/:" + sRoot + "&depth="
+		          + QByteArray::number(m_nTreeDepth) + "&ed2k=0;" + sRoot + "\r\n";
+	}
+
+	sendResponse(bRange ? "206 Partial Content" : "200 OK", sHeaders, nTo - nFrom);
+
+	if( m_bHead || nTo == nFrom )
+	{
+		if( !m_bKeepAlive )
+			finish();
+
+		return true;
+	}
+
+	m_nBodyOffset = nFrom;
+	m_nBodyLength = nTo - nFrom;
+	m_nState = usSending;
+#ifdef Q_OS_LINUX
+	m_bZeroCopy = quazaaSettings.Uploads.ZeroCopy;
+#endif
+
+	systemLog.postLog( LogSeverity::Information, Components::Uploads,
+	                   "Uploading %s (%llu-%llu) to %s",
+	                   qPrintable( m_sFilePath ), nFrom, nTo - 1,
+	                   qPrintable( address().toStringWithPort() ) );
+
+	emit readyToTransfer();
+	return true;
+}
+
+bool CUploadTransferHTTP::requestTigerTree(const QByteArray& sPath)
+{
+	// /gnutella/thex/v1?urn:tree:tiger/:ROOT&depth=9&ed2k=0;ROOT
+	const QByteArray sURN = sPath.mid(sPath.indexOf('?') + 1).split('&').first().split(';').first();
+	const CHash oHash = CHash::fromURN(QString::fromLatin1(sURN));
+	CTigerTree oTree;
+
+	if( !quazaaSettings.Uploads.ShareTiger || oHash.isNull() || !findFile(oHash) || !loadTigerTree(oTree) )
+	{
+		sendError("404 Not Found");
+		return true;
+	}
+
+	// THEX wraps the tree in DIME, the v3 path serves it bare
+	const bool bDIME = sPath.startsWith("/gnutella/thex/");
+	const QByteArray baBody = bDIME ? oTree.toDIME() : oTree.toBreadthFirst();
+
+	sendResponse("200 OK", bDIME ? "Content-Type: application/dime\r\n" : "Content-Type: application/tigertree-breadthfirst\r\n",
+	             baBody.size(), baBody);
+
+	if( !m_bKeepAlive )
+		finish();
+
+	return true;
+}
+
+bool CUploadTransferHTTP::findFile(const CHash& oHash)
+{
+	// pipelined requests mostly name the same file
+	if( m_nFileID > 0 && m_lFileHashes.contains(oHash) )
+		return true;
+
+	m_nFileID = 0;
+	m_nTreeDepth = 0;
+	m_lFileHashes.clear();
+
+	if( oHash.getAlgorithm() == CHash::MD4 )
+		return false;
+
+	// answered by the library thread, so no locks may be held here
+	const QList<QSqlRecord> lResults = ShareManager.query(
+		QString("SELECT f.file_id, d.path, f.name, f.size, h.sha1, h.md5, h.tiger, t.depth FROM hashes h "
+		        "JOIN files f ON (f.file_id = h.file_id) JOIN dirs d ON (d.id = f.dir_id) "
+		        "LEFT JOIN tigertrees t ON (t.file_id = h.file_id) "
+		        "WHERE h.%1 = X'%2' AND f.shared = 1 LIMIT 1")
+		.arg(oHash.getFamilyName(), QString(oHash.rawValue().toHex())));
+
+	if( lResults.isEmpty() )
+		return false;
+
+	const QSqlRecord& oRecord = lResults.first();
+
+	m_nFileID    = oRecord.value(0).toLongLong();
+	m_sFilePath  = oRecord.value(1).toString() + "/" + oRecord.value(2).toString();
+	m_nFileSize  = oRecord.value(3).toULongLong();
+	m_nTreeDepth = oRecord.value(7).toUInt();
+
+	const CHash::Algorithm pAlgorithms[] = { CHash::SHA1, CHash::MD5, CHash::TIGER };
+
+	for( int i = 0; i < 3; ++i )
+	{
+		const CHash oFileHash = CHash::fromRaw(oRecord.value(4 + i).toByteArray(), pAlgorithms[i]);
+
+		if( !oFileHash.isNull() )
+			m_lFileHashes.append(oFileHash);
+	}
+
+	return true;
+}
+
+bool CUploadTransferHTTP::loadTigerTree(CTigerTree& oTree)
+{
+	const CHash oRoot = tigerRoot(m_lFileHashes);
+
+	if( oRoot.isNull() || m_nTreeDepth == 0 )
+		return false;
+
+	const QList<QSqlRecord> lResults = ShareManager.query(
+		QString("SELECT tree FROM tigertrees WHERE file_id = %1").arg(m_nFileID));
+
+	// checked against the root, so a damaged tree is never served
+	return !lResults.isEmpty() && oTree.fromBreadthFirst(m_nFileSize, oRoot, lResults.first().value(0).toByteArray());
+}
+
+void CUploadTransferHTTP::sendResponse(const QByteArray& sStatus, const QByteArray& sHeaders, quint64 nLength, const QByteArray& baBody)
+{
+	QByteArray sResponse = "HTTP/1.1 " + sStatus + "\r\n";
+	sResponse += "Server: " + CQuazaaGlobals::USER_AGENT_STRING() + "\r\n";
+	sResponse += m_bKeepAlive ? "Connection: Keep-Alive\r\n" : "Connection: close\r\n";
+	sResponse += "Content-Length: " + QByteArray::number(nLength) + "\r\n";
+	sResponse += sHeaders;
+	sResponse += "\r\n";
+
+	if( !m_bHead )
+		sResponse += baBody;
+
+	write(sResponse);
+}
+
+void CUploadTransferHTTP::sendError(const QByteArray& sStatus, const QByteArray& sHeaders)
+{
+	const QByteArray baBody = sStatus.mid(4) + "\r\n";
+
+	sendResponse(sStatus, sHeaders + "Content-Type: text/plain\r\n", baBody.size(), baBody);
+
+	if( !m_bKeepAlive )
+		finish();
+}
+
+void CUploadTransferHTTP::finish()
+{
+	m_nState = usClosing;
+	m_nBodyLength = 0;
+
+	// the response still in the output buffer is written before the socket closes
+	close(true);
+}
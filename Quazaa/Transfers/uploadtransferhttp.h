@@ -0,0 +1,123 @@
+/*
+** uploadtransferhttp.h
+**
+** Copyright © Quazaa Development Team, 2009-2013.
+** This file is part of QUAZAA (quazaa.sourceforge.net)
+**
+** Quazaa is free software; this file may be used under the terms of the GNU
+** General Public License version 3.0 or later as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.
+**
+** Quazaa is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+**
+** Please review the following information to ensure the GNU General Public
+** License version 3.0 requirements will be met:
+** http://www.gnu.org/copyleft/gpl.html.
+**
+** You should have received a copy of the GNU General Public License version
+** 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+** Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef UPLOADTRANSFERHTTP_H
+#define UPLOADTRANSFERHTTP_H
+
+#include "transfer.h"
+#include "headerparser.h"
+#include "Hashes/hash.h"
+
+#include <QAbstractSocket>
+#include <QFile>
+#include <QVector>
+
+class CTigerTree;
+class QSocketNotifier;
+
+// HTTP/1.1 upload of shared files and their Tiger trees (Gnutella flavour).
+// Requests are parsed as they arrive and answered in order, one at a time, so clients may
+// pipeline them on a keep-alive connection. File data does not pass through the output
+// buffer: on Linux sendfile() hands it from the page cache to the socket, otherwise it is
+// read in chunks as the rate controller asks for more.
+class CUploadTransferHTTP : public CTransfer
+{
+	Q_OBJECT
+public:
+	enum UploadState
+	{
+		usRequest,		// waiting for a request
+		usQueued,		// told to poll again for a slot
+		usSending,		// file data going out
+		usClosing
+	};
+
+protected:
+	UploadState	m_nState;
+	CHeaderParser	m_oRequest;		// request header being received
+	bool		m_bKeepAlive;		// client keeps the connection open after a response
+	bool		m_bHead;			// current request wants the header only
+	quint32		m_tLastActivity;	// last request, or last file data the client took
+	int			m_nQueuePos;
+
+	// file the last request named, looked up in the library
+	qint64		m_nFileID;
+	QString		m_sFilePath;
+	quint64		m_nFileSize;
+	quint32		m_nTreeDepth;		// 0 if the library has no Tiger tree for it
+	QVector<CHash> m_lFileHashes;
+
+	QFile		m_oFile;
+	quint64		m_nBodyOffset;		// file offset of the next body byte
+	quint64		m_nBodyLength;		// body bytes left to send from m_oFile
+	quint64		m_nUploaded;		// file bytes sent on this connection
+	bool		m_bZeroCopy;
+	QSocketNotifier* m_pWriteNotifier;	// set while sendfile() waits for room in the socket
+	QByteArray	m_baChunk;
+
+public:
+	CUploadTransferHTTP(QObject* parent = 0);
+	virtual ~CUploadTransferHTTP();
+
+	virtual void onTimer(quint32 tNow = 0);
+	virtual bool hasData();
+
+	inline UploadState state() const;
+	inline quint64 uploaded() const;
+
+public slots:
+	void onConnectNode();
+	void onDisconnectNode();
+	void onRead();
+	void onError(QAbstractSocket::SocketError e);
+
+protected slots:
+	void endResponse();
+	void onSocketWritable();
+
+protected:
+	virtual qint64 writeToNetwork(qint64 nBytes);
+	qint64 writeBody(qint64 nBytes);
+
+	bool readRequest();
+	bool requestFile(const CHash& oHash);
+	bool requestTigerTree(const QByteArray& sPath);
+	bool findFile(const CHash& oHash);
+	bool loadTigerTree(CTigerTree& oTree);
+
+	void sendResponse(const QByteArray& sStatus, const QByteArray& sHeaders, quint64 nLength, const QByteArray& baBody = QByteArray());
+	void sendError(const QByteArray& sStatus, const QByteArray& sHeaders = QByteArray());
+	void finish();
+};
+
+CUploadTransferHTTP::UploadState CUploadTransferHTTP::state() const
+{
+	return m_nState;
+}
+quint64 CUploadTransferHTTP::uploaded() const
+{
+	return m_nUploaded;
+}
+
+#endif // UPLOADTRANSFERHTTP_H
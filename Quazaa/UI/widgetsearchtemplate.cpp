@@ -29,6 +29,7 @@
 #include "NetworkCore/managedsearch.h"
 #include "NetworkCore/query.h"
 #include "NetworkCore/queryhit.h"
+#include "NetworkCore/searchresults.h"
 #include "NetworkCore/Hashes/hash.h"
 #include "downloads.h"
 #include "securitymanager.h"
@@ -59,6 +60,7 @@ CWidgetSearchTemplate::CWidgetSearchTemplate(QString searchString, QWidget* pare
 
 	m_sSearchString = searchString;
 	m_pSearch = 0;
+	m_pResults = 0;
 	m_nFiles = 0;
 	m_nHits = 0;
 	m_nHubs = 0;
@@ -108,12 +110,15 @@ void CWidgetSearchTemplate::StartSearch(CQuery* pQuery)
 	{
 		delete m_pSearch;
 		m_pSearch = 0;
+		m_pResults->deleteLater();
+		m_pResults = 0;
 	}
 
 	if ( !m_pSearch )
 	{
 		m_pSearch = new CManagedSearch( pQuery );
-		connect( m_pSearch, SIGNAL( OnHit( QueryHitSharedPtr) ), m_pSearchModel, SLOT( addQueryHit( QueryHitSharedPtr ) ) );
+		m_pResults = new CSearchResults( m_pSearch );
+		connect( m_pResults, SIGNAL( resultsReady( SearchResultBatch ) ), m_pSearchModel, SLOT( addResults( SearchResultBatch ) ) );
 		connect( m_pSearch, SIGNAL( StatsUpdated() ), this, SLOT( OnStatsUpdated() ) );
 		connect( m_pSearch, SIGNAL( StateChanged() ), this, SLOT( OnStateChanged() ) );
 	}
@@ -121,6 +126,7 @@ void CWidgetSearchTemplate::StartSearch(CQuery* pQuery)
 	m_searchState = SearchState::Searching;
 	m_pSearch->start();
 	m_sSearchString = m_pSearch->m_pQuery->descriptiveName();
+	m_pSearchModel->setQueryWords( m_sSearchString.split( QRegExp( "\\s+" ), QString::SkipEmptyParts ) );
 }
 
 void CWidgetSearchTemplate::StopSearch()
@@ -131,6 +137,8 @@ void CWidgetSearchTemplate::StopSearch()
 	m_pSearch->stop();
 	delete m_pSearch;
 	m_pSearch = 0;
+	m_pResults->deleteLater();
+	m_pResults = 0;
 }
 
 void CWidgetSearchTemplate::PauseSearch()
@@ -145,6 +153,10 @@ void CWidgetSearchTemplate::ClearSearch()
 {
 	//qDebug() << "Clear search captured in widget search template.";
 		m_searchState = SearchState::Default;
+	if ( m_pResults )
+	{
+		QMetaObject::invokeMethod( m_pResults, "clear", Qt::QueuedConnection );
+	}
 	m_pSearchModel->clear();
 	qApp->processEvents();
 }
@@ -36,6 +36,7 @@ namespace Ui
 }
 
 class CManagedSearch;
+class CSearchResults;
 class CQuery;
 //class CQueryHit;
 #include "NetworkCore/queryhit.h"
@@ -63,6 +64,7 @@ public:
 	SearchTreeModel*		m_pSearchModel;
 	QSortFilterProxyModel*	m_pSortModel;
 	CManagedSearch*			m_pSearch;
+	CSearchResults*			m_pResults;
 
 	int m_nHubs;
 	int m_nLeaves;
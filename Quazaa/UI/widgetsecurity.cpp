@@ -39,6 +39,7 @@
 
 #include <QMenu>
 #include <QKeyEvent>
+#include <QShowEvent>
 
 CWidgetSecurity::CWidgetSecurity(QWidget* parent) :
 	QMainWindow( parent ),
@@ -141,6 +142,15 @@ void CWidgetSecurity::keyPressEvent(QKeyEvent *e)
 	QMainWindow::keyPressEvent( e );
 }
 
+void CWidgetSecurity::showEvent(QShowEvent* e)
+{
+	// Rules the Security Manager still looks up in its rule file are only listed on request.
+	if ( m_lSecurity->rowCount() < (int)securityManager.getCount() )
+		m_lSecurity->completeRefresh();
+
+	QMainWindow::showEvent( e );
+}
+
 void CWidgetSecurity::update()
 {
 	m_lSecurity->updateAll();
@@ -61,6 +61,7 @@ public:
 protected:
 	virtual void changeEvent(QEvent* e);
 	virtual void keyPressEvent(QKeyEvent *event);
+	virtual void showEvent(QShowEvent* event);
 
 public slots:
 	void update();
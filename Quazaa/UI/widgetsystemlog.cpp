@@ -213,6 +213,11 @@ void CWidgetSystemLog::on_actionClearBuffer_triggered()
 	ui->textEditSystemLog->clear();
 }
 
+void CWidgetSystemLog::on_actionShowDebug_toggled(bool checked)
+{
+	systemLog.setLogged(LogSeverity::Debug, checked || quazaaSettings.Logging.SaveLog);
+}
+
 void CWidgetSystemLog::on_textEditSystemLog_customContextMenuRequested(QPoint pos)
 {
 	Q_UNUSED(pos);
@@ -54,6 +54,7 @@ private slots:
 	void on_actionCopy_triggered();
  void on_textEditSystemLog_customContextMenuRequested(QPoint pos);
 	void on_actionClearBuffer_triggered();
+	void on_actionShowDebug_toggled(bool checked);
 
 	void appendLog(QString message, LogSeverity::Severity severity = LogSeverity::Information);
 	void setSkin();
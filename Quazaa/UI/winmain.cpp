@@ -53,6 +53,9 @@
 #include "network.h"
 #include "neighbours.h"
 #include "datagrams.h"
+#include "g2metrics.h"
+#include "g2capture.h"
+#include "searchresults.h"
 #include "geoiplist.h"
 #include "sharemanager.h"
 #include "transfers.h"
@@ -437,6 +440,9 @@ void CWinMain::quazaaShutdown()
 	delete neighboursRefresher;
 	neighboursRefresher = 0;
 	Network.stop();
+	G2Metrics.stop();
+	G2Capture.stop();
+	CSearchResults::stopThread();
 	ShareManager.stop();
 
 	dlgSplash->updateProgress(65, tr("Saving Security Manager..."));
@@ -463,6 +469,7 @@ void CWinMain::quazaaShutdown()
 	Transfers.stop();
 
 	qApp->processEvents();
+	systemLog.stop();
 
 	dlgSplash->close();
 
@@ -137,11 +137,10 @@ QString common::fixFileName(QString sName)
 
 QString common::getTempFileName(QString sName)
 {
-	CHash oHashName(CHash::SHA1);
+	CHashContext oHashName(CHash::SHA1);
 	oHashName.addData(sName.toUtf8());
 	oHashName.addData(QString().number(qrand() % qrand()).append(getDateTimeUTC().toString(Qt::ISODate)).toLocal8Bit());
-	oHashName.finalize();
-	return oHashName.toString();
+	return oHashName.result().toString();
 }
 
 quint32 common::securedSaveFile(QString sPath, QString sFileName,
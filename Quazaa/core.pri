@@ -0,0 +1,279 @@
+#
+# core.pri
+#
+# Copyright © Quazaaa Development Team, 2009-2013.
+# This file is part of QUAZAA (quazaa.sourceforge.net)
+#
+# Quazaa is free software; this file may be used under the terms of the GNU
+# General Public License version 3.0 or later or later as published by the Free Software
+# Foundation and appearing in the file LICENSE.GPL included in the
+# packaging of this file.
+#
+# Quazaa is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# Please review the following information to ensure the GNU General Public
+# License version 3.0 requirements will be met:
+# http://www.gnu.org/copyleft/gpl.html.
+#
+# You should have received a copy of the GNU General Public License version
+# 3.0 along with Quazaa; if not, write to the Free Software Foundation,
+# Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+
+# Non-GUI core: networking, security, library, transfers and the settings and log they share.
+# QuazaaCore builds it as a static library (TEMPLATE = lib); the application, G2Replay and
+# the benchmarks include this file to get the include paths and to link against that library.
+# Everything that changes the layout of core classes (DEFINES) must be set here, so that all
+# of them see the same declarations.
+
+QT += network \
+		sql \
+		xml
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+		QT += widgets
+}
+
+CONFIG += c++11
+
+CONFIG(debug, debug|release) {
+		DEFINES += _DEBUG
+}
+
+INCLUDEPATH += $$PWD/3rdparty \
+		$$PWD/3rdparty/nvwa \
+		$$PWD/Discovery \
+		$$PWD/FileFragments \
+		$$PWD/HostCache \
+		$$PWD/Misc \
+		$$PWD/NetworkCore \
+		$$PWD/Security \
+		$$PWD/ShareManager \
+		$$PWD/Transfers \
+		$$PWD
+
+# Use Qt's Zlib
+INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+
+unix {
+		LIBS += -lz -L/usr/lib
+}
+
+QUAZAA_CORE = QuazaaCore
+CONFIG(debug, debug|release):QUAZAA_CORE = $$join(QUAZAA_CORE,,,_debug)
+QUAZAA_CORE_DIR = $$shadowed($$PWD/../QuazaaCore)
+
+equals(TEMPLATE, lib) {
+		# Version stuff
+		MAJOR = 0
+		MINOR = 1
+		VERSION_HEADER = version.h
+		VERSION_HEADER_PATH = $$clean_path($$relative_path($$PWD/$$VERSION_HEADER, $$OUT_PWD))
+
+		versiontarget.target = $$VERSION_HEADER_PATH
+		CONFIG(debug, debug|release): versiontarget.commands = cd \"$$PWD\" && \"$$OUT_PWD/../VersionTool/debug/VersionTool\" $$MAJOR $$MINOR $$VERSION_HEADER
+		CONFIG(release, debug|release): versiontarget.commands = cd \"$$PWD\" && \"$$OUT_PWD/../VersionTool/release/VersionTool\" $$MAJOR $$MINOR $$VERSION_HEADER
+		win32-*{
+			versiontarget.commands = $$replace(versiontarget.commands, '/', '\\') # for nmake
+		}
+		versiontarget.depends = FORCE
+		PRE_TARGETDEPS += $$VERSION_HEADER_PATH
+		QMAKE_EXTRA_TARGETS += versiontarget
+		QMAKE_CLEAN += $$VERSION_HEADER_PATH
+
+		HEADERS += \
+		$$[QT_INSTALL_HEADERS]/QtZlib/zlib.h \
+		$$PWD/3rdparty/CyoEncode/CyoDecode.h \
+		$$PWD/3rdparty/CyoEncode/CyoEncode.h \
+		$$PWD/3rdparty/nvwa/debug_new.h \
+		$$PWD/3rdparty/nvwa/fast_mutex.h \
+		$$PWD/3rdparty/nvwa/static_assert.h \
+		$$PWD/commonfunctions.h \
+		$$PWD/Discovery/banneddiscoveryservice.h \
+		$$PWD/Discovery/discovery.h \
+		$$PWD/Discovery/discoveryservice.h \
+		$$PWD/Discovery/gwc.h \
+		$$PWD/Discovery/networktype.h \
+		$$PWD/Discovery/ukhl.h \
+		$$PWD/FileFragments/Compatibility.hpp \
+		$$PWD/FileFragments/Exception.hpp \
+		$$PWD/FileFragments/FileFragments.hpp \
+		$$PWD/FileFragments/FlatList.hpp \
+		$$PWD/FileFragments/List.hpp \
+		$$PWD/FileFragments/Queue.hpp \
+		$$PWD/FileFragments/Range.hpp \
+		$$PWD/FileFragments/Ranges.hpp \
+		$$PWD/geoiplist.h \
+		$$PWD/HostCache/hostcache.h \
+		$$PWD/HostCache/hostcachehost.h \
+		$$PWD/Metalink/magnetlink.h \
+		$$PWD/Metalink/metalink4handler.h \
+		$$PWD/Metalink/metalinkhandler.h \
+		$$PWD/Misc/startupsequence.h \
+		$$PWD/Misc/timedsignalqueue.h \
+		$$PWD/Misc/timeoutwritelocker.h \
+		$$PWD/NetworkCore/bandwidthpool.h \
+		$$PWD/NetworkCore/buffer.h \
+		$$PWD/NetworkCore/compressedconnection.h \
+		$$PWD/NetworkCore/datagramfrags.h \
+		$$PWD/NetworkCore/datagrams.h \
+		$$PWD/NetworkCore/deflatebackend.h \
+		$$PWD/NetworkCore/endpoint.h \
+		$$PWD/NetworkCore/g2capture.h \
+		$$PWD/NetworkCore/g2metrics.h \
+		$$PWD/NetworkCore/g2node.h \
+		$$PWD/NetworkCore/g2packet.h \
+		$$PWD/NetworkCore/handshake.h \
+		$$PWD/NetworkCore/handshakes.h \
+		$$PWD/NetworkCore/Hashes/hash.h \
+		$$PWD/NetworkCore/Hashes/tiger.h \
+		$$PWD/NetworkCore/Hashes/tigertree.h \
+		$$PWD/NetworkCore/headerparser.h \
+		$$PWD/NetworkCore/hubhorizon.h \
+		$$PWD/NetworkCore/managedsearch.h \
+		$$PWD/NetworkCore/neighbour.h \
+		$$PWD/NetworkCore/neighbours.h \
+		$$PWD/NetworkCore/neighboursbase.h \
+		$$PWD/NetworkCore/neighboursconnections.h \
+		$$PWD/NetworkCore/neighboursg2.h \
+		$$PWD/NetworkCore/neighboursrouting.h \
+		$$PWD/NetworkCore/network.h \
+		$$PWD/NetworkCore/networkconnection.h \
+		$$PWD/NetworkCore/query.h \
+		$$PWD/NetworkCore/queryhashgroup.h \
+		$$PWD/NetworkCore/queryhashmaster.h \
+		$$PWD/NetworkCore/queryhashtable.h \
+		$$PWD/NetworkCore/queryhit.h \
+		$$PWD/NetworkCore/querykeys.h \
+		$$PWD/NetworkCore/ratecontroller.h \
+		$$PWD/NetworkCore/routetable.h \
+		$$PWD/NetworkCore/searchmanager.h \
+		$$PWD/NetworkCore/searchresults.h \
+		$$PWD/NetworkCore/thread.h \
+		$$PWD/NetworkCore/types.h \
+		$$PWD/NetworkCore/zlibutils.h \
+		$$PWD/quazaaglobals.h \
+		$$PWD/quazaasettings.h \
+		$$PWD/quazaasysinfo.h \
+		$$PWD/Security/contentrule.h \
+		$$PWD/Security/hashrule.h \
+		$$PWD/Security/iprangerule.h \
+		$$PWD/Security/iprule.h \
+		$$PWD/Security/regexprule.h \
+		$$PWD/Security/securerule.h \
+		$$PWD/Security/securitymanager.h \
+		$$PWD/Security/securityrulestore.h \
+		$$PWD/Security/securitysanitycheck.h \
+		$$PWD/Security/useragentrule.h \
+		$$PWD/ShareManager/file.h \
+		$$PWD/ShareManager/filehasher.h \
+		$$PWD/ShareManager/sharedfile.h \
+		$$PWD/ShareManager/sharemanager.h \
+		$$PWD/systemlog.h \
+		$$PWD/Transfers/download.h \
+		$$PWD/Transfers/downloads.h \
+		$$PWD/Transfers/downloadsource.h \
+		$$PWD/Transfers/downloadstorage.h \
+		$$PWD/Transfers/downloadtransfer.h \
+		$$PWD/Transfers/downloadtransferhttp.h \
+		$$PWD/Transfers/downloadverifier.h \
+		$$PWD/Transfers/transfer.h \
+		$$PWD/Transfers/transfers.h \
+		$$PWD/Transfers/uploads.h \
+		$$PWD/Transfers/uploadtransferhttp.h
+
+		SOURCES += \
+		$$PWD/3rdparty/CyoEncode/CyoDecode.c \
+		$$PWD/3rdparty/CyoEncode/CyoEncode.c \
+		$$PWD/3rdparty/nvwa/debug_new.cpp \
+		$$PWD/commonfunctions.cpp \
+		$$PWD/Discovery/banneddiscoveryservice.cpp \
+		$$PWD/Discovery/discovery.cpp \
+		$$PWD/Discovery/discoveryservice.cpp \
+		$$PWD/Discovery/gwc.cpp \
+		$$PWD/Discovery/networktype.cpp \
+		$$PWD/Discovery/ukhl.cpp \
+		$$PWD/geoiplist.cpp \
+		$$PWD/HostCache/hostcache.cpp \
+		$$PWD/HostCache/hostcachehost.cpp \
+		$$PWD/Metalink/magnetlink.cpp \
+		$$PWD/Metalink/metalink4handler.cpp \
+		$$PWD/Metalink/metalinkhandler.cpp \
+		$$PWD/Misc/startupsequence.cpp \
+		$$PWD/Misc/timedsignalqueue.cpp \
+		$$PWD/NetworkCore/bandwidthpool.cpp \
+		$$PWD/NetworkCore/buffer.cpp \
+		$$PWD/NetworkCore/compressedconnection.cpp \
+		$$PWD/NetworkCore/datagramfrags.cpp \
+		$$PWD/NetworkCore/datagrams.cpp \
+		$$PWD/NetworkCore/deflatebackend.cpp \
+		$$PWD/NetworkCore/endpoint.cpp \
+		$$PWD/NetworkCore/g2capture.cpp \
+		$$PWD/NetworkCore/g2metrics.cpp \
+		$$PWD/NetworkCore/g2node.cpp \
+		$$PWD/NetworkCore/g2packet.cpp \
+		$$PWD/NetworkCore/handshake.cpp \
+		$$PWD/NetworkCore/handshakes.cpp \
+		$$PWD/NetworkCore/Hashes/hash.cpp \
+		$$PWD/NetworkCore/Hashes/tiger.cpp \
+		$$PWD/NetworkCore/Hashes/tigertree.cpp \
+		$$PWD/NetworkCore/headerparser.cpp \
+		$$PWD/NetworkCore/hubhorizon.cpp \
+		$$PWD/NetworkCore/managedsearch.cpp \
+		$$PWD/NetworkCore/neighbour.cpp \
+		$$PWD/NetworkCore/neighbours.cpp \
+		$$PWD/NetworkCore/neighboursbase.cpp \
+		$$PWD/NetworkCore/neighboursconnections.cpp \
+		$$PWD/NetworkCore/neighboursg2.cpp \
+		$$PWD/NetworkCore/neighboursrouting.cpp \
+		$$PWD/NetworkCore/network.cpp \
+		$$PWD/NetworkCore/networkconnection.cpp \
+		$$PWD/NetworkCore/query.cpp \
+		$$PWD/NetworkCore/queryhashgroup.cpp \
+		$$PWD/NetworkCore/queryhashmaster.cpp \
+		$$PWD/NetworkCore/queryhashtable.cpp \
+		$$PWD/NetworkCore/queryhit.cpp \
+		$$PWD/NetworkCore/querykeys.cpp \
+		$$PWD/NetworkCore/ratecontroller.cpp \
+		$$PWD/NetworkCore/routetable.cpp \
+		$$PWD/NetworkCore/searchmanager.cpp \
+		$$PWD/NetworkCore/searchresults.cpp \
+		$$PWD/NetworkCore/thread.cpp \
+		$$PWD/NetworkCore/types.cpp \
+		$$PWD/NetworkCore/zlibutils.cpp \
+		$$PWD/quazaaglobals.cpp \
+		$$PWD/quazaasettings.cpp \
+		$$PWD/quazaasysinfo.cpp \
+		$$PWD/Security/contentrule.cpp \
+		$$PWD/Security/hashrule.cpp \
+		$$PWD/Security/iprangerule.cpp \
+		$$PWD/Security/iprule.cpp \
+		$$PWD/Security/regexprule.cpp \
+		$$PWD/Security/securerule.cpp \
+		$$PWD/Security/securitymanager.cpp \
+		$$PWD/Security/securityrulestore.cpp \
+		$$PWD/Security/securitysanitycheck.cpp \
+		$$PWD/Security/useragentrule.cpp \
+		$$PWD/ShareManager/file.cpp \
+		$$PWD/ShareManager/filehasher.cpp \
+		$$PWD/ShareManager/sharedfile.cpp \
+		$$PWD/ShareManager/sharemanager.cpp \
+		$$PWD/systemlog.cpp \
+		$$PWD/Transfers/download.cpp \
+		$$PWD/Transfers/downloads.cpp \
+		$$PWD/Transfers/downloadsource.cpp \
+		$$PWD/Transfers/downloadstorage.cpp \
+		$$PWD/Transfers/downloadtransfer.cpp \
+		$$PWD/Transfers/downloadtransferhttp.cpp \
+		$$PWD/Transfers/downloadverifier.cpp \
+		$$PWD/Transfers/transfer.cpp \
+		$$PWD/Transfers/transfers.cpp \
+		$$PWD/Transfers/uploads.cpp \
+		$$PWD/Transfers/uploadtransferhttp.cpp
+} else {
+		LIBS = -L$$QUAZAA_CORE_DIR -l$$QUAZAA_CORE $$LIBS
+		win32-msvc*:PRE_TARGETDEPS += $$QUAZAA_CORE_DIR/$${QUAZAA_CORE}.lib
+		else:PRE_TARGETDEPS += $$QUAZAA_CORE_DIR/lib$${QUAZAA_CORE}.a
+}
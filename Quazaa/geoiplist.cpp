@@ -25,118 +25,347 @@
 #include <QApplication>
 #include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
+#include <QVector>
+#include <QPair>
+#include <QtAlgorithms>
+#include <cstring>
 #include "geoiplist.h"
 #include "types.h"
 #include "systemlog.h"
 
 #include "debug_new.h"
 
+// Compiled database layout, all integers in host byte order:
+//   header, IPv4 range begins, IPv4 range ends, IPv4 codes,
+//   IPv6 range begins (16 bytes each), IPv6 range ends, IPv6 codes.
+// Ranges are sorted and do not overlap; a code is the two country letters, first one high.
+struct GeoIPHeader
+{
+	char	szMagic[8];
+	quint32	nByteOrder;
+	quint32	nVersion;
+	quint32	nV4;
+	quint32	nV6;
+	quint32	nReserved[2];
+};
+
+static const char    GeoIPMagic[8]     = { 'Q', 'G', 'E', 'O', 'I', 'P', 0, 0 };
+static const quint32 GeoIPByteOrder    = 0x01020304;
+static const quint32 GeoIPVersion      = 1;
+static const quint16 GeoIPUnknown      = ('Z' << 8) | 'Z';
+
+struct GeoIPRange4
+{
+	quint32 nBegin;
+	quint32 nEnd;
+	quint16 nCode;
+
+	bool operator<(const GeoIPRange4& other) const
+	{
+		return nBegin < other.nBegin;
+	}
+};
+
+struct GeoIPRange6
+{
+	Q_IPV6ADDR oBegin;
+	Q_IPV6ADDR oEnd;
+	quint16 nCode;
+
+	bool operator<(const GeoIPRange6& other) const
+	{
+		return memcmp(&oBegin, &other.oBegin, 16) < 0;
+	}
+};
+
 CGeoIPList geoIP;
 
 CGeoIPList::CGeoIPList()
 {
 	m_bListLoaded = false;
+	detach();
+}
+
+CGeoIPList::~CGeoIPList()
+{
+	detach();
+	m_oFile.close();
 }
 
 void CGeoIPList::loadGeoIP()
 {
 	const QString sOriginalFile(qApp->applicationDirPath() + "/GeoIP/geoip.dat");
-	const QString sSerializedFile(qApp->applicationDirPath() + "/geoIP.ser");
+	const QString sCompiledFile(qApp->applicationDirPath() + "/geoip.bin");
 
-	bool readFromOriginalGeoIP = false;
-	//First trying to deserialize from ser file
+	detach();
+	m_oFile.close();
+	m_baDatabase.clear();
 
-	QFile iFile( sSerializedFile );
+	// The serialised list of older versions is no longer used
+	QFile::remove(qApp->applicationDirPath() + "/geoIP.ser");
 
-	if( QFile::exists(sSerializedFile) && QFile::exists(sOriginalFile) )
+	bool bCompile = !QFile::exists(sCompiledFile);
+
+	if( !bCompile && QFile::exists(sOriginalFile) )
 	{
 		QFileInfo iOriginal(sOriginalFile);
-		QFileInfo iSerialized(sSerializedFile);
+		QFileInfo iCompiled(sCompiledFile);
 
-		if( iOriginal.lastModified() > iSerialized.lastModified() )
+		if( iOriginal.lastModified() > iCompiled.lastModified() )
 		{
 			systemLog.postLog(LogSeverity::Warning, QObject::tr("GeoIP data modified, refreshing..."));
-			iFile.remove();
+			bCompile = true;
 		}
 	}
 
-	if ( ! iFile.open( QIODevice::ReadOnly ))
+	if( !bCompile )
 	{
-		systemLog.postLog(LogSeverity::Warning, QObject::tr("Unable to load GeoIP serialization file for loading"));
-		readFromOriginalGeoIP = true;
-	}
-	else
-	{
-		try
+		m_oFile.setFileName(sCompiledFile);
+
+		uchar* pData = 0;
+		if( m_oFile.open(QIODevice::ReadOnly) && (pData = m_oFile.map(0, m_oFile.size())) && attach(pData, m_oFile.size()) )
 		{
-			QDataStream iStream( &iFile );
-			iStream >> m_lDatabase;
+			m_bListLoaded = (m_nV4 || m_nV6);
+			return;
 		}
-		catch(...)
+
+		systemLog.postLog(LogSeverity::Warning, QObject::tr("Unable to load compiled GeoIP database, rebuilding"));
+		detach();
+		m_oFile.close();
+	}
+
+	if( !compile(sOriginalFile, m_baDatabase) )
+	{
+		systemLog.postLog(LogSeverity::Warning, QObject::tr("Unable to load GeoIP data"));
+		m_baDatabase.clear();
+		return;
+	}
+
+	// Store it next to the source for the next start, then map it like any other time
+	QFile oFile(sCompiledFile + ".tmp");
+	if( oFile.open(QIODevice::WriteOnly) && oFile.write(m_baDatabase) == m_baDatabase.size() )
+	{
+		oFile.close();
+		QFile::remove(sCompiledFile);
+
+		if( oFile.rename(sCompiledFile) )
 		{
-			systemLog.postLog(LogSeverity::Warning, QObject::tr("Unable to deserialize GeoIP list"));
-			readFromOriginalGeoIP = true;
+			m_oFile.setFileName(sCompiledFile);
+
+			uchar* pData = 0;
+			if( m_oFile.open(QIODevice::ReadOnly) && (pData = m_oFile.map(0, m_oFile.size())) && attach(pData, m_oFile.size()) )
+			{
+				m_baDatabase.clear();
+				m_bListLoaded = (m_nV4 || m_nV6);
+				return;
+			}
+			m_oFile.close();
 		}
-		iFile.close();
+	}
+	else
+	{
+		systemLog.postLog(LogSeverity::Error, QObject::tr("Unable to open GeoIP database file for saving"));
+		oFile.remove();
+	}
+
+	// Could not store it; use the in-memory copy
+	if( attach((const uchar*)m_baDatabase.constData(), m_baDatabase.size()) )
+	{
+		m_bListLoaded = (m_nV4 || m_nV6);
+	}
+}
+
+bool CGeoIPList::compile(const QString& sSource, QByteArray& baOutput) const
+{
+	QFile file(sSource);
+	if( !file.open(QIODevice::ReadOnly | QIODevice::Text) )
+	{
+		return false;
 	}
 
+	QVector<GeoIPRange4> lV4;
+	QVector<GeoIPRange6> lV6;
+	lV4.reserve(150000);
 
-	if(readFromOriginalGeoIP)
+	while( !file.atEnd() )
 	{
-		QFile file(sOriginalFile);
-		if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		QByteArray baLine = file.readLine().trimmed();
+
+		if( baLine.isEmpty() )
 		{
-			return;
+			continue;
 		}
 
-		m_lDatabase.clear();
-
-		// TODO: optimize it
+		QList<QByteArray> line = baLine.split(' ');
 
-		QTextStream in(&file);
-		while(!in.atEnd())
+		if( line.size() != 3 || line[2].size() != 2 )
 		{
-			QStringList line = in.readLine().split(" ");
+			systemLog.postLog(LogSeverity::Warning, "[GeoIP] Bad line, skippig");
+			continue;
+		}
 
-			if( line.size() != 3 )
-			{
-				systemLog.postLog(LogSeverity::Warning, "[GeoIP] Bad line, skippig");
-				continue;
-			}
-			CEndPoint rBegin(line[0] + ":0");
-			CEndPoint rEnd(line[1] + ":0");
-			QString sCountry = line[2];
+		QHostAddress rBegin(QString::fromLatin1(line[0]));
+		QHostAddress rEnd(QString::fromLatin1(line[1]));
+		quint16 nCode = (quint16(uchar(line[2].at(0))) << 8) | uchar(line[2].at(1));
 
-			GeoIPEntry item = QPair<quint32, QPair<quint32, QString> >(rBegin.toIPv4Address(), QPair<quint32, QString>(rEnd.toIPv4Address(), sCountry));
-			m_lDatabase.append(item);
+		if( rBegin.protocol() == QAbstractSocket::IPv4Protocol && rEnd.protocol() == QAbstractSocket::IPv4Protocol )
+		{
+			GeoIPRange4 oRange = { rBegin.toIPv4Address(), rEnd.toIPv4Address(), nCode };
+			lV4.append(oRange);
+		}
+		else if( rBegin.protocol() == QAbstractSocket::IPv6Protocol && rEnd.protocol() == QAbstractSocket::IPv6Protocol )
+		{
+			GeoIPRange6 oRange;
+			oRange.oBegin = rBegin.toIPv6Address();
+			oRange.oEnd = rEnd.toIPv6Address();
+			oRange.nCode = nCode;
+			lV6.append(oRange);
 		}
+		else
+		{
+			systemLog.postLog(LogSeverity::Warning, "[GeoIP] Bad line, skippig");
+		}
+	}
+
+	// sort the ranges so binary search can work
+	qSort(lV4);
+	qSort(lV6);
 
-		QFile oFile( qApp->applicationDirPath() +  "/geoIP.ser" );
-		if ( ! oFile.open( QIODevice::WriteOnly ) )
+	GeoIPHeader oHeader;
+	memset(&oHeader, 0, sizeof(oHeader));
+	memcpy(oHeader.szMagic, GeoIPMagic, sizeof(oHeader.szMagic));
+	oHeader.nByteOrder = GeoIPByteOrder;
+	oHeader.nVersion = GeoIPVersion;
+	oHeader.nV4 = lV4.size();
+	oHeader.nV6 = lV6.size();
+
+	baOutput.clear();
+	baOutput.reserve(sizeof(GeoIPHeader) + lV4.size() * 10 + lV6.size() * 34);
+	baOutput.append((const char*)&oHeader, sizeof(oHeader));
+
+	for( int i = 0; i < lV4.size(); ++i )
+	{
+		baOutput.append((const char*)&lV4[i].nBegin, 4);
+	}
+	for( int i = 0; i < lV4.size(); ++i )
+	{
+		baOutput.append((const char*)&lV4[i].nEnd, 4);
+	}
+	for( int i = 0; i < lV4.size(); ++i )
+	{
+		baOutput.append((const char*)&lV4[i].nCode, 2);
+	}
+	for( int i = 0; i < lV6.size(); ++i )
+	{
+		baOutput.append((const char*)&lV6[i].oBegin, 16);
+	}
+	for( int i = 0; i < lV6.size(); ++i )
+	{
+		baOutput.append((const char*)&lV6[i].oEnd, 16);
+	}
+	for( int i = 0; i < lV6.size(); ++i )
+	{
+		baOutput.append((const char*)&lV6[i].nCode, 2);
+	}
+
+	return true;
+}
+
+bool CGeoIPList::attach(const uchar* pData, qint64 nSize)
+{
+	if( nSize < (qint64)sizeof(GeoIPHeader) )
+	{
+		return false;
+	}
+
+	GeoIPHeader oHeader;
+	memcpy(&oHeader, pData, sizeof(oHeader));
+
+	if( memcmp(oHeader.szMagic, GeoIPMagic, sizeof(GeoIPMagic)) != 0
+		|| oHeader.nByteOrder != GeoIPByteOrder || oHeader.nVersion != GeoIPVersion
+		|| nSize != (qint64)sizeof(GeoIPHeader) + qint64(oHeader.nV4) * 10 + qint64(oHeader.nV6) * 34 )
+	{
+		return false;
+	}
+
+	const uchar* p = pData + sizeof(GeoIPHeader);
+
+	m_nV4 = oHeader.nV4;
+	m_pV4Begin = (const quint32*)p;
+	p += m_nV4 * 4;
+	m_pV4End = (const quint32*)p;
+	p += m_nV4 * 4;
+	m_pV4Code = (const quint16*)p;
+	p += m_nV4 * 2;
+
+	m_nV6 = oHeader.nV6;
+	m_pV6Begin = p;
+	p += m_nV6 * 16;
+	m_pV6End = p;
+	p += m_nV6 * 16;
+	m_pV6Code = (const quint16*)p;
+
+	return true;
+}
+
+void CGeoIPList::detach()
+{
+	m_bListLoaded = false;
+
+	m_nV4 = m_nV6 = 0;
+	m_pV4Begin = m_pV4End = 0;
+	m_pV4Code = m_pV6Code = 0;
+	m_pV6Begin = m_pV6End = 0;
+}
+
+quint16 CGeoIPList::lookup(quint32 nIp) const
+{
+	// last range starting at or before nIp
+	const quint32* pFound = qUpperBound(m_pV4Begin, m_pV4Begin + m_nV4, nIp);
+
+	if( pFound == m_pV4Begin )
+	{
+		return GeoIPUnknown;
+	}
+
+	quint32 nIndex = pFound - m_pV4Begin - 1;
+
+	return nIp <= m_pV4End[nIndex] ? m_pV4Code[nIndex] : GeoIPUnknown;
+}
+
+quint16 CGeoIPList::lookup(const Q_IPV6ADDR& ip6) const
+{
+	quint32 nBegin = 0, nCount = m_nV6;
+
+	while( nCount > 0 )
+	{
+		quint32 nHalf = nCount >> 1;
+
+		if( memcmp(&ip6, m_pV6Begin + (nBegin + nHalf) * 16, 16) < 0 )
 		{
-			systemLog.postLog(LogSeverity::Error, QObject::tr("Unable to open GeoIP serialization file for saving"));
+			nCount = nHalf;
 		}
 		else
 		{
-			try
-			{
-				QDataStream oStream( &oFile );
-				oStream << m_lDatabase;
-			}
-			catch(...)
-			{
-				systemLog.postLog(LogSeverity::Error, QObject::tr("Unable to serialize GeoIP list"));
-			}
-			oFile.close();
+			nBegin += nHalf + 1;
+			nCount -= nHalf + 1;
 		}
+	}
 
+	if( nBegin == 0 )
+	{
+		return GeoIPUnknown;
 	}
 
-	// sort the database so binary search can work
-	qSort(m_lDatabase);
+	--nBegin;
+
+	return memcmp(&ip6, m_pV6End + nBegin * 16, 16) <= 0 ? m_pV6Code[nBegin] : GeoIPUnknown;
+}
 
-	m_bListLoaded = !m_lDatabase.isEmpty();
+QString CGeoIPList::codeToString(quint16 nCode)
+{
+	const char szCode[2] = { char(nCode >> 8), char(nCode & 0xFF) };
+	return QString::fromLatin1(szCode, 2);
 }
 
 QString CGeoIPList::findCountryCode(const quint32 nIp) const
@@ -146,36 +375,77 @@ QString CGeoIPList::findCountryCode(const quint32 nIp) const
 		return "ZZ";
 	}
 
-	int nMiddle;
-	int nBegin = 0;
-	int nEnd = m_lDatabase.size();
+	return codeToString(lookup(nIp));
+}
 
-	int n = nEnd - nBegin;
+QString CGeoIPList::findCountryCode(const Q_IPV6ADDR& ip6) const
+{
+	if ( !m_bListLoaded )
+	{
+		return "ZZ";
+	}
 
-	int nHalf;
+	return codeToString(lookup(ip6));
+}
 
-	while (n > 0)
-	{
-		nHalf = n >> 1;
+// Looks up many addresses at once. IPv4 addresses are resolved in ascending order,
+// each search starting where the previous one ended.
+QStringList CGeoIPList::findCountryCodes(const QList<QHostAddress>& lAddresses) const
+{
+	QStringList lCodes;
+	lCodes.reserve(lAddresses.size());
+
+	QVector<QPair<quint32, int> > lV4;
 
-		nMiddle = nBegin + nHalf;
+	for( int i = 0; i < lAddresses.size(); ++i )
+	{
+		const QHostAddress& oAddress = lAddresses.at(i);
 
-		if (nIp < m_lDatabase.at(nMiddle).first )
+		if( !m_bListLoaded )
+		{
+			lCodes.append("ZZ");
+		}
+		else if( oAddress.protocol() == QAbstractSocket::IPv6Protocol )
 		{
-			n = nHalf;
+			lCodes.append(codeToString(lookup(oAddress.toIPv6Address())));
 		}
 		else
 		{
-			if( nIp <= m_lDatabase.at(nMiddle).second.first )
+			lCodes.append(QString());
+			lV4.append(qMakePair(oAddress.toIPv4Address(), i));
+		}
+	}
+
+	qSort(lV4);
+
+	const quint32* pFrom = m_pV4Begin;
+	const quint32* pEnd = m_pV4Begin + m_nV4;
+
+	for( int i = 0; i < lV4.size(); ++i )
+	{
+		const quint32 nIp = lV4[i].first;
+		pFrom = qUpperBound(pFrom, pEnd, nIp);
+
+		quint16 nCode = GeoIPUnknown;
+		if( pFrom != m_pV4Begin )
+		{
+			quint32 nIndex = pFrom - m_pV4Begin - 1;
+			if( nIp <= m_pV4End[nIndex] )
 			{
-				return m_lDatabase.at(nMiddle).second.second;
+				nCode = m_pV4Code[nIndex];
 			}
-			nBegin = nMiddle + 1;
-			n -= nHalf + 1;
+		}
+
+		lCodes[lV4[i].second] = codeToString(nCode);
+
+		// the next address may fall in the same range
+		if( pFrom != m_pV4Begin )
+		{
+			--pFrom;
 		}
 	}
 
-	return "ZZ";
+	return lCodes;
 }
 
 QString CGeoIPList::countryNameFromCode(const QString& code) const
@@ -28,15 +28,31 @@
 #include "types.h"
 
 #include <QObject>
+#include <QFile>
+#include <QByteArray>
 #include <QList>
-#include <QPair>
-
-typedef QPair<quint32, QPair<quint32, QString> > GeoIPEntry;
+#include <QStringList>
 
+// Country lookup over a compiled database: sorted IPv4 and IPv6 range arrays with
+// 2-byte country codes, compiled once from GeoIP/geoip.dat and mapped at startup.
 class CGeoIPList
 {
 protected:
 	bool	m_bListLoaded;
+
+	QFile			m_oFile;		// compiled database, mapped
+	QByteArray		m_baDatabase;	// compiled database, if it could not be stored
+
+	quint32			m_nV4;
+	const quint32*	m_pV4Begin;
+	const quint32*	m_pV4End;
+	const quint16*	m_pV4Code;
+
+	quint32			m_nV6;
+	const uchar*	m_pV6Begin;		// 16 bytes per range, network byte order
+	const uchar*	m_pV6End;
+	const quint16*	m_pV6Code;
+
 public:
 	struct sGeoID
 	{
@@ -45,15 +61,25 @@ public:
 	};
 	sGeoID GeoID;
 
-	QList<GeoIPEntry> m_lDatabase;
-
 	CGeoIPList();
+	~CGeoIPList();
+
 	void loadGeoIP();
 	inline QString findCountryCode(const QString& IP) const;
 	inline QString findCountryCode(const QHostAddress& ip) const;
 
 	QString findCountryCode(const quint32 nIp) const;
+	QString findCountryCode(const Q_IPV6ADDR& ip6) const;
+	QStringList findCountryCodes(const QList<QHostAddress>& lAddresses) const;
 	QString countryNameFromCode(const QString& code) const;
+
+protected:
+	quint16 lookup(quint32 nIp) const;
+	quint16 lookup(const Q_IPV6ADDR& ip6) const;
+	bool compile(const QString& sSource, QByteArray& baOutput) const;
+	bool attach(const uchar* pData, qint64 nSize);
+	void detach();
+	static QString codeToString(quint16 nCode);
 };
 
 QString CGeoIPList::findCountryCode(const QString& IP) const
@@ -64,9 +90,9 @@ QString CGeoIPList::findCountryCode(const QString& IP) const
 
 QString CGeoIPList::findCountryCode(const QHostAddress& ip) const
 {
-	if ( ip.protocol() == 1 ) // IPv6
+	if ( ip.protocol() == QAbstractSocket::IPv6Protocol )
 	{
-		return "ZZ";
+		return findCountryCode( ip.toIPv6Address() );
 	}
 
 	const quint32 ip4 = ip.toIPv4Address();
@@ -31,6 +31,8 @@
 
 #include "geoiplist.h"
 #include "network.h"
+#include "g2metrics.h"
+#include "g2capture.h"
 #include "queryhashmaster.h"
 #include "dialogsplash.h"
 #include "dialoglanguage.h"
@@ -42,7 +44,9 @@
 
 #include "Discovery/discovery.h"
 #include "securitymanager.h"
+#include "startupsequence.h"
 
+#include <QMutexLocker>
 #include <QNetworkProxy>
 #include <QFont>
 #include <QtPlugin>
@@ -208,6 +212,19 @@ int main(int argc, char *argv[])
 	//Initialize Settings
 	quazaaSettings.loadSettings();
 
+	// Debug messages are dropped before formatting unless shown or saved
+	systemLog.setLogged( LogSeverity::Debug, quazaaSettings.Logging.ShowDebug || quazaaSettings.Logging.SaveLog );
+	if ( quazaaSettings.Logging.SaveLog )
+	{
+		systemLog.setLogFile( CQuazaaGlobals::DATA_PATH() + "quazaa.log" );
+	}
+
+	index = args.indexOf( "--capture-g2" );
+	if ( index != -1 )
+	{
+		G2Capture.start( args.value( index + 1 ) );
+	}
+
 	//Check if this is Quazaa's first run
 	dlgSplash->updateProgress( 8, QObject::tr( "Checking for first run..." ) );
 	qApp->processEvents();
@@ -226,73 +243,97 @@ int main(int argc, char *argv[])
 		wzrdQuickStart->exec();
 	}
 
-	// Load Security Manager
-	dlgSplash->updateProgress( 15, QObject::tr( "Loading Security Manager..." ) );
-	qApp->processEvents();
-	if ( !securityManager.start() )
-		systemLog.postLog( LogSeverity::Information,
-						   QObject::tr( "Security data file was not available." ) );
-
-	// Load Discovery Services Manager
-	dlgSplash->updateProgress( 22, QObject::tr( "Loading Discovery Services Manager..." ) );
-	qApp->processEvents();
-	discoveryManager.start();
+	// Set up the Security Manager; its rules are loaded with the other data below
+	securityManager.start();
 
-	//Load profile
-	dlgSplash->updateProgress( 25, QObject::tr( "Loading Profile..." ) );
-	qApp->processEvents();
-	quazaaSettings.loadProfile();
+	// The remaining subsystems start as a dependency graph: data files are read on worker
+	// threads in parallel, and the network comes up as soon as security rules, host cache and
+	// the other things it needs are there, without waiting for the user interface. Transfers
+	// are not needed by either and load last.
+	CStartupSequence* pStartup = new CStartupSequence( &theApp );
 
-	//Load Host Cache
-	dlgSplash->updateProgress( 30, QObject::tr( "Loading Host Cache..." ) );
-	qApp->processEvents();
-	hostCache.m_pSection.lock();
-	hostCache.load();
-	hostCache.m_pSection.unlock();
-
-	//initialize geoip list
-	geoIP.loadGeoIP();
+	const int nSecurity = pStartup->add( QObject::tr( "Security rules" ), CStartupSequence::Worker, []()
+	{
+		if ( !securityManager.load() )
+			systemLog.postLog( LogSeverity::Information,
+							   QObject::tr( "Security data file was not available." ) );
+	} );
 
-	//Load the library
-	dlgSplash->updateProgress( 38, QObject::tr( "Loading Library..." ) );
-	qApp->processEvents();
-	QueryHashMaster.create();
-	ShareManager.start();
+	const int nGeoIP = pStartup->add( QObject::tr( "GeoIP list" ), CStartupSequence::Worker, []()
+	{
+		geoIP.loadGeoIP();
+	} );
 
-	// Load Download Manager
-	dlgSplash->updateProgress( 60, QObject::tr( "Loading Transfer Manager..." ) );
-	qApp->processEvents();
-	Transfers.start();
+	const int nProfile = pStartup->add( QObject::tr( "Profile" ), CStartupSequence::MainThread, []()
+	{
+		quazaaSettings.loadProfile();
+	} );
 
-	dlgSplash->updateProgress( 80, QObject::tr( "Loading User Interface..." ) );
-	qApp->processEvents();
+	// Services are checked against the security rules
+	const int nDiscovery = pStartup->add( QObject::tr( "Discovery Services Manager" ), CStartupSequence::MainThread, []()
+	{
+		discoveryManager.start();
+	}, QList<int>() << nSecurity );
 
-	if ( quazaaSettings.WinMain.Visible )
+	// Hosts are checked against the security rules
+	const int nHostCache = pStartup->add( QObject::tr( "Host Cache" ), CStartupSequence::Worker, []()
 	{
-		if(bFirstRun)
-			MainWindow->showMaximized();
-		else
-			MainWindow->show();
-	}
+		QMutexLocker l( &hostCache.m_pSection );
+		hostCache.load();
+	}, QList<int>() << nSecurity );
 
-	dlgSplash->updateProgress( 90, QObject::tr( "Loading Tray Icon..." ) );
-	qApp->processEvents();
-	MainWindow->loadTrayIcon();
+	// Opens the library database in its own thread
+	const int nLibrary = pStartup->add( QObject::tr( "Library" ), CStartupSequence::MainThread, []()
+	{
+		QueryHashMaster.create();
+		ShareManager.start();
+	} );
 
-	dlgSplash->updateProgress( 100, QObject::tr( "Welcome to Quazaa!" ) );
-	qApp->processEvents();
+	pStartup->add( QObject::tr( "Network" ), CStartupSequence::MainThread, []()
+	{
+		// Serve G2 packet statistics on a local socket
+		G2Metrics.start();
 
-	dlgSplash->deleteLater();
-	dlgSplash = 0;
+		// Start networks if needed
+		if ( quazaaSettings.System.ConnectOnStartup )
+		{
+			if ( quazaaSettings.Gnutella2.Enable )
+			{
+				Network.start();
+			}
+		}
+	}, QList<int>() << nSecurity << nGeoIP << nProfile << nDiscovery << nHostCache << nLibrary );
 
-	// Start networks if needed
-	if ( quazaaSettings.System.ConnectOnStartup )
+	pStartup->add( QObject::tr( "User Interface" ), CStartupSequence::MainThread, [bFirstRun, dlgSplash]()
 	{
-		if ( quazaaSettings.Gnutella2.Enable )
+		if ( quazaaSettings.WinMain.Visible )
 		{
-			Network.start();
+			if ( bFirstRun )
+				MainWindow->showMaximized();
+			else
+				MainWindow->show();
 		}
-	}
+
+		MainWindow->loadTrayIcon();
+
+		dlgSplash->updateProgress( 100, QObject::tr( "Welcome to Quazaa!" ) );
+		dlgSplash->deleteLater();
+	}, QList<int>() << nProfile );
+
+	pStartup->add( QObject::tr( "Transfer Manager" ), CStartupSequence::Deferred, []()
+	{
+		Transfers.start();
+	}, QList<int>() << nLibrary );
+
+	// The splash screen follows the stages until the user interface replaces it
+	QObject::connect( pStartup, &CStartupSequence::stageStarted, dlgSplash, [pStartup, dlgSplash](const QString& sName)
+	{
+		dlgSplash->updateProgress( 15 + 85 * pStartup->finishedCount() / pStartup->count(),
+								   QObject::tr( "Loading %1..." ).arg( sName ) );
+	} );
+	QObject::connect( pStartup, &CStartupSequence::finished, pStartup, &QObject::deleteLater );
+
+	pStartup->run();
 
 	return theApp.exec();
 }
@@ -125,6 +125,8 @@ void CQuazaaSettings::saveSettings()
 
 	m_qSettings.beginGroup("Discovery");
 	m_qSettings.setValue("AccessThrottle",            quazaaSettings.Discovery.AccessThrottle);
+	m_qSettings.setValue("BootstrapFanOut",           quazaaSettings.Discovery.BootstrapFanOut);
+	m_qSettings.setValue("BootstrapHosts",            quazaaSettings.Discovery.BootstrapHosts);
 	m_qSettings.setValue("FailureLimit",              quazaaSettings.Discovery.FailureLimit);
 	m_qSettings.setValue("MaximalServiceRating",      quazaaSettings.Discovery.MaximumServiceRating);
 	m_qSettings.setValue("ServiceTimeout",            quazaaSettings.Discovery.ServiceTimeout);
@@ -437,6 +439,8 @@ void CQuazaaSettings::saveSettings()
 	m_qSettings.setValue("FreeBandwidthValue", quazaaSettings.Uploads.FreeBandwidthValue);
 	m_qSettings.setValue("HubShareLimiting", quazaaSettings.Uploads.HubShareLimiting);
 	m_qSettings.setValue("MaxPerHost", quazaaSettings.Uploads.MaxPerHost);
+	m_qSettings.setValue("MaxQueued", quazaaSettings.Uploads.MaxQueued);
+	m_qSettings.setValue("MaxTransfers", quazaaSettings.Uploads.MaxTransfers);
 	m_qSettings.setValue("PreviewQuality", quazaaSettings.Uploads.PreviewQuality);
 	m_qSettings.setValue("PreviewTransfers", quazaaSettings.Uploads.PreviewTransfers);
 	m_qSettings.setValue("QueuePollMax", quazaaSettings.Uploads.QueuePollMax);
@@ -449,6 +453,7 @@ void CQuazaaSettings::saveSettings()
 	m_qSettings.setValue("SharePreviews", quazaaSettings.Uploads.SharePreviews);
 	m_qSettings.setValue("ShareTiger", quazaaSettings.Uploads.ShareTiger);
 	m_qSettings.setValue("ThrottleMode", quazaaSettings.Uploads.ThrottleMode);
+	m_qSettings.setValue("ZeroCopy", quazaaSettings.Uploads.ZeroCopy);
 	m_qSettings.endGroup();
 
 	m_qSettings.beginGroup("Web");
@@ -541,6 +546,8 @@ void CQuazaaSettings::loadSettings()
 
 	m_qSettings.beginGroup("Discovery");
 	quazaaSettings.Discovery.AccessThrottle            = m_qSettings.value("AccessThrottle", 60).toUInt();
+	quazaaSettings.Discovery.BootstrapFanOut           = m_qSettings.value("BootstrapFanOut", 4).toUInt();
+	quazaaSettings.Discovery.BootstrapHosts            = m_qSettings.value("BootstrapHosts", 10).toUInt();
 	quazaaSettings.Discovery.FailureLimit              = m_qSettings.value("FailureLimit", 2).toUInt();
 	quazaaSettings.Discovery.MaximumServiceRating      = m_qSettings.value("MaximalServiceRating", 10).toUInt();
 	quazaaSettings.Discovery.ServiceTimeout            = m_qSettings.value("ServiceTimeout", 10).toUInt();
@@ -867,6 +874,8 @@ void CQuazaaSettings::loadSettings()
 	quazaaSettings.Uploads.FreeBandwidthValue = m_qSettings.value("FreeBandwidthValue", 20).toInt();
 	quazaaSettings.Uploads.HubShareLimiting = m_qSettings.value("HubShareLimiting", true).toBool();
 	quazaaSettings.Uploads.MaxPerHost = m_qSettings.value("MaxPerHost", 2).toInt();
+	quazaaSettings.Uploads.MaxQueued = m_qSettings.value("MaxQueued", 20).toInt();
+	quazaaSettings.Uploads.MaxTransfers = m_qSettings.value("MaxTransfers", 4).toInt();
 	quazaaSettings.Uploads.PreviewQuality = m_qSettings.value("PreviewQuality", 70).toInt();
 	quazaaSettings.Uploads.PreviewTransfers = m_qSettings.value("PreviewTransfers", 3).toInt();
 	quazaaSettings.Uploads.QueuePollMax = m_qSettings.value("QueuePollMax", 120000).toInt();
@@ -879,6 +888,7 @@ void CQuazaaSettings::loadSettings()
 	quazaaSettings.Uploads.SharePreviews = m_qSettings.value("SharePreviews", true).toBool();
 	quazaaSettings.Uploads.ShareTiger = m_qSettings.value("ShareTiger", true).toBool();
 	quazaaSettings.Uploads.ThrottleMode = m_qSettings.value("ThrottleMode", true).toBool();
+	quazaaSettings.Uploads.ZeroCopy = m_qSettings.value("ZeroCopy", true).toBool();
 	m_qSettings.endGroup();
 
 	m_qSettings.beginGroup("Web");
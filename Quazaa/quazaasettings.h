@@ -183,6 +183,8 @@ namespace Settings
 	struct sDiscovery
 	{
 		quint16		AccessThrottle;							// Number of seconds to wait between consecutive requests for the same service.
+		quint8		BootstrapFanOut;						// Number of services queried at the same time when looking for a first hub.
+		quint16		BootstrapHosts;							// Number of hosts after which no further services are queried when looking for a first hub.
 		quint8		FailureLimit;							// Number of failures after which a cache should be autodisabled no matter its rating. (0 to disable)
 															// Note that this setting will be ineffective if a value higher than MaximalServiceRating is chosen.
 		quint8		MaximumServiceRating;					// The highest rating a service can reach.
@@ -590,6 +592,8 @@ namespace Settings
 		int			FreeBandwidthValue;						// Amount of bandwidth remaining for uploads
 		bool		HubShareLimiting;						// Limit sharing in hub mode
 		int			MaxPerHost;								// Max simultaneous uploads to one remote client
+		int			MaxQueued;								// Max clients waiting for an upload slot
+		int			MaxTransfers;							// Max simultaneous uploads (upload slots)
 		int			PreviewQuality;							// Quality of dynamically created previews
 		int			PreviewTransfers;						// Max simultaneous uploads of previews
 		int			QueuePollMax;
@@ -602,6 +606,7 @@ namespace Settings
 		bool		SharePreviews;							// Share previews
 		bool		ShareTiger;								// Share tiger tree hashes
 		bool		ThrottleMode;							// Are we throttling upload bandwidth
+		bool		ZeroCopy;								// Send file data with sendfile() where the OS has it
 	};
 
 	struct sWeb
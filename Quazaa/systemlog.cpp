@@ -28,20 +28,80 @@
 
 #include "debug_new.h"
 
+const int LogRingSize          = 4096;              // must be a power of two
+const int LogRingMask          = LogRingSize - 1;
+const int LogMessagesPerSecond = 200;               // per component; Error and Critical are never limited
+const int LogWriterIdleWait    = 100;               // ms
+
 CSystemLog systemLog;
 
+class CSystemLogWriter : public QThread
+{
+public:
+	QAtomicInt m_bStop;
+
+	CSystemLogWriter() :
+		m_bStop( 0 )
+	{
+	}
+
+protected:
+	void run()
+	{
+		while ( !m_bStop.loadAcquire() )
+		{
+			if ( !systemLog.drain() )
+			{
+				QMutexLocker l( &systemLog.m_pWakeSection );
+				if ( !m_bStop.loadAcquire() )
+				{
+					systemLog.m_oWake.wait( &systemLog.m_pWakeSection, LogWriterIdleWait );
+				}
+			}
+		}
+		systemLog.drain();
+	}
+};
+
 CSystemLog::CSystemLog() :
-m_pSection(QMutex::Recursive)
+	m_pSection(QMutex::Recursive),
+	m_nEnqueuePos( 0 ),
+	m_nDequeuePos( 0 ),
+	m_nOverflow( 0 ),
+	m_bAsync( 0 ),
+	m_pWriter( 0 ),
+	m_eLastSeverity( LogSeverity::Information ),
+	m_eLastComponent( Components::None ),
+	m_nSuppressed( 0 )
 {
 	m_pComponents = new QString[Components::NoComponents];
 	m_bProcessingMessage = false;
 
+	for ( int i = 0; i < Components::NoComponents; ++i )
+	{
+		m_lFilter[i].store( 0xff );
+		m_lRateWindow[i].store( 0 );
+		m_lRateCount[i].store( 0 );
+		m_lRateDropped[i].store( 0 );
+	}
+
+	m_pRing = new LogEntry[LogRingSize];
+	for ( int i = 0; i < LogRingSize; ++i )
+	{
+		m_pRing[i].nSequence.store( i );
+	}
+
+	m_oClock.start();
+
 	qRegisterMetaType<LogSeverity::Severity>( "LogSeverity::Severity" );
 	qRegisterMetaType<Components::Component>( "Components::Component" );
 }
 
 CSystemLog::~CSystemLog()
 {
+	stop();
+
+	delete[] m_pRing;
 	delete[] m_pComponents;
 }
 
@@ -61,6 +121,39 @@ void CSystemLog::start()
 	m_pComponents[Components::Downloads]  = tr( "[Downloads] " );
 	m_pComponents[Components::Uploads]    = tr( "[Uploads] " );
 	m_pComponents[Components::GUI]        = tr( "[GUI] " );
+
+	if ( !m_pWriter )
+	{
+		m_pWriter = new CSystemLogWriter();
+		m_pWriter->start( QThread::LowPriority );
+		m_bAsync.storeRelease( 1 );
+	}
+}
+
+/*!
+	Stops the writer thread after it has written out everything queued so far.
+	Messages posted afterwards are written synchronously.
+*/
+void CSystemLog::stop()
+{
+	if ( !m_pWriter )
+		return;
+
+	m_bAsync.storeRelease( 0 );
+
+	m_pWriter->m_bStop.storeRelease( 1 );
+	m_oWake.wakeAll();
+	m_pWriter->wait();
+
+	delete m_pWriter;
+	m_pWriter = 0;
+
+	// catch whatever was queued by threads that saw m_bAsync just before it was cleared
+	drain();
+
+	QMutexLocker l( &m_pSection );
+	if ( m_oLogFile.isOpen() )
+		m_oLogFile.close();
 }
 
 QString CSystemLog::msgFromComponent(Components::Component eComponent)
@@ -68,6 +161,48 @@ QString CSystemLog::msgFromComponent(Components::Component eComponent)
 	return m_pComponents[eComponent];
 }
 
+void CSystemLog::setLogged(LogSeverity::Severity eSeverity, Components::Component eComponent, bool bLogged)
+{
+	const int nBit = 1 << eSeverity;
+
+	forever
+	{
+		const int nOld = m_lFilter[eComponent].loadAcquire();
+		const int nNew = bLogged ? ( nOld | nBit ) : ( nOld & ~nBit );
+		if ( nOld == nNew || m_lFilter[eComponent].testAndSetOrdered( nOld, nNew ) )
+			return;
+	}
+}
+
+void CSystemLog::setLogged(LogSeverity::Severity eSeverity, bool bLogged)
+{
+	for ( int i = 0; i < Components::NoComponents; ++i )
+	{
+		setLogged( eSeverity, ( Components::Component )i, bLogged );
+	}
+}
+
+/*!
+	Appends all messages to the file at sPath from now on. An empty path closes the file.
+*/
+void CSystemLog::setLogFile(const QString& sPath)
+{
+	QMutexLocker l( &m_pSection );
+
+	if ( m_oLogFile.isOpen() )
+		m_oLogFile.close();
+
+	if ( sPath.isEmpty() )
+		return;
+
+	m_oLogFile.setFileName( sPath );
+	if ( !m_oLogFile.open( QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text ) )
+	{
+		l.unlock();
+		postLog( LogSeverity::Warning, Components::None, tr( "Could not open log file %1." ).arg( sPath ) );
+	}
+}
+
 void CSystemLog::postLog(const LogSeverity::Severity &severity, const QString &message)
 {
 	postLog( severity, Components::None, message );
@@ -76,40 +211,188 @@ void CSystemLog::postLog(const LogSeverity::Severity &severity, const QString &m
 void CSystemLog::postLog(const LogSeverity::Severity &severity, const Components::Component &component,
 						 const QString &message)
 {
-	QMutexLocker locker(&m_pSection);
+	if ( !isLogged( severity, component ) || !admit( severity, component ) )
+		return;
 
-	static LogSeverity::Severity lastSeverity  = LogSeverity::Information;
-	static Components::Component lastComponent = Components::None;
-	static QString lastMessage;
-	static int suppressed = 0;
-	static bool bCheck = true;
+	if ( !m_bAsync.loadAcquire() || !enqueue( severity, component, message ) )
+	{
+		write( severity, component, message );
+	}
+}
 
-	if ( bCheck )
+void CSystemLog::postLog(const LogSeverity::Severity &severity, const Components::Component &component,
+						 const char* format, ...)
+{
+	// filter before paying for the formatting
+	if ( !isLogged( severity, component ) || !admit( severity, component ) )
+		return;
+
+	va_list argList;
+	va_start( argList, format );
+	QString message = QString().vsprintf( format, argList );
+	va_end( argList );
+
+	if ( !m_bAsync.loadAcquire() || !enqueue( severity, component, message ) )
 	{
-		if ( severity == lastSeverity && component == lastComponent && message == lastMessage )
-		{
-			++suppressed;
-			return;
-		}
-		else
+		write( severity, component, message );
+	}
+}
+
+/*!
+	Counts the message against its component's per second budget.
+	Returns false if the budget is used up; the dropped message is reported later by the writer.
+*/
+bool CSystemLog::admit(LogSeverity::Severity eSeverity, Components::Component eComponent)
+{
+	if ( eSeverity == LogSeverity::Error || eSeverity == LogSeverity::Critical )
+		return true;
+
+	const int nNow    = int( m_oClock.elapsed() / 1000 ) + 1;
+	const int nWindow = m_lRateWindow[eComponent].loadAcquire();
+
+	if ( nWindow != nNow && m_lRateWindow[eComponent].testAndSetOrdered( nWindow, nNow ) )
+	{
+		m_lRateCount[eComponent].fetchAndStoreRelease( 0 );
+	}
+
+	if ( m_lRateCount[eComponent].fetchAndAddRelaxed( 1 ) < LogMessagesPerSecond )
+		return true;
+
+	m_lRateDropped[eComponent].ref();
+	return false;
+}
+
+/*!
+	Multi producer, single consumer bounded queue: producers claim a slot by advancing
+	m_nEnqueuePos, the slot's sequence number tells who may touch it next.
+	Returns false if the ring is full, in which case the caller writes synchronously.
+*/
+bool CSystemLog::enqueue(LogSeverity::Severity eSeverity, Components::Component eComponent, const QString& sMessage)
+{
+	int nPos = m_nEnqueuePos.loadAcquire();
+
+	forever
+	{
+		LogEntry& oEntry = m_pRing[nPos & LogRingMask];
+		const int nDiff  = int( quint32( oEntry.nSequence.loadAcquire() ) - quint32( nPos ) );
+
+		if ( nDiff == 0 )
 		{
-			if ( suppressed > 0 )
+			if ( m_nEnqueuePos.testAndSetRelaxed( nPos, nPos + 1 ) )
 			{
-				bCheck = false;
-				postLog( lastSeverity, lastComponent,
-						 tr( "Suppressed %n identical message(s).", 0, suppressed ) );
-				bCheck = true;
+				oEntry.eSeverity  = eSeverity;
+				oEntry.eComponent = eComponent;
+				oEntry.sMessage   = sMessage;
+				oEntry.nSequence.storeRelease( nPos + 1 );
+				break;
 			}
-			lastMessage   = message;
-			lastSeverity  = severity;
-			lastComponent = component;
-			suppressed = 0;
 		}
+		else if ( nDiff < 0 )
+		{
+			m_nOverflow.ref();
+			m_oWake.wakeOne();
+			return false;
+		}
+
+		nPos = m_nEnqueuePos.loadAcquire();
 	}
 
-	const QString sComponentMessage = msgFromComponent( component ) + message;
+	const int nQueued = int( quint32( nPos + 1 ) - quint32( m_nDequeuePos.loadAcquire() ) );
+	if ( eSeverity >= LogSeverity::Warning || nQueued > LogRingSize / 2 )
+	{
+		m_oWake.wakeOne();
+	}
+
+	return true;
+}
+
+/*!
+	Writes out everything queued so far. Returns false if there was nothing to write.
+*/
+bool CSystemLog::drain()
+{
+	QMutexLocker l( &m_pSection );
+
+	bool bWritten = false;
 
-	switch ( severity )
+	forever
+	{
+		const int nPos   = m_nDequeuePos.loadAcquire();
+		LogEntry& oEntry = m_pRing[nPos & LogRingMask];
+		const int nDiff  = int( quint32( oEntry.nSequence.loadAcquire() ) - quint32( nPos + 1 ) );
+
+		if ( nDiff < 0 )
+			break;
+
+		const LogSeverity::Severity eSeverity  = oEntry.eSeverity;
+		const Components::Component eComponent = oEntry.eComponent;
+		QString sMessage;
+		qSwap( sMessage, oEntry.sMessage );
+
+		oEntry.nSequence.storeRelease( nPos + LogRingSize );
+		m_nDequeuePos.storeRelease( nPos + 1 );
+
+		write( eSeverity, eComponent, sMessage );
+		bWritten = true;
+	}
+
+	for ( int i = 0; i < Components::NoComponents; ++i )
+	{
+		const int nDropped = m_lRateDropped[i].fetchAndStoreRelaxed( 0 );
+		if ( nDropped > 0 )
+		{
+			write( LogSeverity::Warning, ( Components::Component )i,
+				   tr( "Rate limit exceeded, dropped %n message(s).", 0, nDropped ) );
+			bWritten = true;
+		}
+	}
+
+	const int nOverflow = m_nOverflow.fetchAndStoreRelaxed( 0 );
+	if ( nOverflow > 0 )
+	{
+		write( LogSeverity::Warning, Components::None,
+			   tr( "Log queue full, %n message(s) were written synchronously.", 0, nOverflow ) );
+		bWritten = true;
+	}
+
+	if ( bWritten && m_oLogFile.isOpen() )
+		m_oLogFile.flush();
+
+	return bWritten;
+}
+
+void CSystemLog::write(LogSeverity::Severity eSeverity, Components::Component eComponent, const QString& sMessage)
+{
+	QMutexLocker l( &m_pSection );
+
+	if ( eSeverity == m_eLastSeverity && eComponent == m_eLastComponent && sMessage == m_sLastMessage )
+	{
+		++m_nSuppressed;
+		return;
+	}
+
+	if ( m_nSuppressed > 0 )
+	{
+		writeToSinks( m_eLastSeverity, m_eLastComponent,
+					  tr( "Suppressed %n identical message(s).", 0, m_nSuppressed ) );
+	}
+
+	m_sLastMessage   = sMessage;
+	m_eLastSeverity  = eSeverity;
+	m_eLastComponent = eComponent;
+	m_nSuppressed    = 0;
+
+	writeToSinks( eSeverity, eComponent, sMessage );
+
+	if ( !m_bAsync.loadAcquire() && m_oLogFile.isOpen() )
+		m_oLogFile.flush();
+}
+
+void CSystemLog::writeToSinks(LogSeverity::Severity eSeverity, Components::Component eComponent, const QString& sMessage)
+{
+	const QString sComponentMessage = msgFromComponent( eComponent ) + sMessage;
+
+	switch ( eSeverity )
 	{
 		case LogSeverity::Debug:
 		case LogSeverity::Warning:
@@ -121,16 +404,13 @@ void CSystemLog::postLog(const LogSeverity::Severity &severity, const Components
 			break;
 	}
 
-	emit logPosted( sComponentMessage, severity );
-}
+	if ( m_oLogFile.isOpen() )
+	{
+		m_oLogFile.write( QDateTime::currentDateTime().toString( "yyyy-MM-dd hh:mm:ss.zzz " ).toUtf8() );
+		m_oLogFile.write( sComponentMessage.toUtf8() );
+		m_oLogFile.write( "\n" );
+	}
 
-void CSystemLog::postLog(const LogSeverity::Severity &severity, const Components::Component &component,
-						 const char* format, ...)
-{
-	va_list argList;
-	va_start( argList, format );
-	QString message = QString().vsprintf( format, argList );
-	postLog( severity, component, message );
-	va_end( argList );
+	// queued to the GUI thread when called from the writer
+	emit logPosted( sComponentMessage, eSeverity );
 }
-
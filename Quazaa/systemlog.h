@@ -29,6 +29,9 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <QThread>
+#include <QAtomicInt>
+#include <QFile>
+#include <QElapsedTimer>
 
 namespace LogSeverity
 {
@@ -60,22 +63,68 @@ enum Component { None         =  0,
 				 NoComponents = 14 };
 }
 
+class CSystemLogWriter;
+
+// Messages are filtered and rate limited per component before they are formatted, then
+// queued in a lock-free ring and written to the sinks (debug output, log file, GUI) by a
+// background thread. Before start() and after stop() they are written synchronously.
 class CSystemLog : public QObject
 {
 	Q_OBJECT
 private:
-	QMutex m_pSection;
+	struct LogEntry
+	{
+		QAtomicInt              nSequence;
+		LogSeverity::Severity   eSeverity;
+		Components::Component   eComponent;
+		QString                 sMessage;
+	};
+
+	QMutex m_pSection;                                  // guards the sinks
 	QString* m_pComponents;
 	bool m_bProcessingMessage;
 
+	QAtomicInt m_lFilter[Components::NoComponents];     // one bit per severity
+	QAtomicInt m_lRateWindow[Components::NoComponents]; // second the counts below belong to
+	QAtomicInt m_lRateCount[Components::NoComponents];
+	QAtomicInt m_lRateDropped[Components::NoComponents];
+	QElapsedTimer m_oClock;
+
+	LogEntry*  m_pRing;
+	QAtomicInt m_nEnqueuePos;
+	QAtomicInt m_nDequeuePos;
+	QAtomicInt m_nOverflow;                             // messages lost to a full ring
+
+	QAtomicInt m_bAsync;
+	CSystemLogWriter* m_pWriter;
+	QMutex m_pWakeSection;
+	QWaitCondition m_oWake;
+
+	QFile m_oLogFile;                                   // guarded by m_pSection
+
+	// duplicate suppression, sink side
+	LogSeverity::Severity m_eLastSeverity;
+	Components::Component m_eLastComponent;
+	QString m_sLastMessage;
+	int m_nSuppressed;
+
 public:
 	CSystemLog();
 	~CSystemLog();
 
 	void start();
+	void stop();
 
 	QString msgFromComponent(Components::Component eComponent);
 
+	inline bool isLogged(LogSeverity::Severity eSeverity, Components::Component eComponent) const
+	{
+		return m_lFilter[eComponent].loadAcquire() & (1 << eSeverity);
+	}
+	void setLogged(LogSeverity::Severity eSeverity, Components::Component eComponent, bool bLogged);
+	void setLogged(LogSeverity::Severity eSeverity, bool bLogged);
+	void setLogFile(const QString& sPath);
+
 signals:
 	void logPosted(QString message, LogSeverity::Severity severity);
 
@@ -85,6 +134,15 @@ public slots:
 public:
 	void postLog(const LogSeverity::Severity& severity, const Components::Component& component, const QString& message);
 	void postLog(const LogSeverity::Severity& severity, const Components::Component& component, const char* format, ...);
+
+private:
+	bool admit(LogSeverity::Severity eSeverity, Components::Component eComponent);
+	bool enqueue(LogSeverity::Severity eSeverity, Components::Component eComponent, const QString& sMessage);
+	bool drain();
+	void write(LogSeverity::Severity eSeverity, Components::Component eComponent, const QString& sMessage);
+	void writeToSinks(LogSeverity::Severity eSeverity, Components::Component eComponent, const QString& sMessage);
+
+	friend class CSystemLogWriter;
 };
 
 extern CSystemLog systemLog;